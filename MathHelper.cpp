@@ -33,50 +33,84 @@ float MathHelper::AngleFromXY(float x, float y)
 	return theta;
 }
 
-XMVECTOR MathHelper::RandUnitVec3()
+// Maps 4 pairs of uniform numbers onto the unit sphere (Archimedes' hat-box theorem):
+// z is uniform in [-1, 1] and the azimuth is uniform in [0, 2pi).
+static void RandUnitSphere4(XMVECTOR& x, XMVECTOR& y, XMVECTOR& z)
 {
-	XMVECTOR One  = XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
-	XMVECTOR Zero = XMVectorZero();
-
-	// Keep trying until we get a point on/in the hemisphere.
-	while(true)
-	{
-		// Generate random point in the cube [-1,1]^3.
-		XMVECTOR v = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), 0.0f);
-
-		// Ignore points outside the unit sphere in order to get an even distribution 
-		// over the unit sphere.  Otherwise points will clump more on the sphere near 
-		// the corners of the cube.
+	XMFLOAT4A uv[2];
+	RandomGenerator::ThreadLocal().FillFloat(&uv[0].x, 8);
+	XMVECTOR u = XMLoadFloat4A(&uv[0]);
+	XMVECTOR v = XMLoadFloat4A(&uv[1]);
+
+	z = XMVectorMultiplyAdd(u, XMVectorReplicate(2.0f), XMVectorReplicate(-1.0f));
+	XMVECTOR r = XMVectorSqrt(XMVectorMax(XMVectorZero(),
+		XMVectorNegativeMultiplySubtract(z, z, XMVectorSplatOne())));
+
+	XMVECTOR sin_phi, cos_phi;
+	XMVectorSinCos(&sin_phi, &cos_phi, XMVectorMultiply(v, XMVectorReplicate(XM_2PI)));
+	x = XMVectorMultiply(r, cos_phi);
+	y = XMVectorMultiply(r, sin_phi);
+}
 
-		if( XMVector3Greater( XMVector3LengthSq(v), One) )
-			continue;
+// Flip samples that lie in the bottom hemisphere of n.
+static void FlipToHemisphere4(FXMVECTOR n, XMVECTOR& x, XMVECTOR& y, XMVECTOR& z)
+{
+	XMVECTOR d = XMVectorMultiply(x, XMVectorSplatX(n));
+	d = XMVectorMultiplyAdd(y, XMVectorSplatY(n), d);
+	d = XMVectorMultiplyAdd(z, XMVectorSplatZ(n), d);
+	XMVECTOR below = XMVectorLess(d, XMVectorZero());
+	x = XMVectorSelect(x, XMVectorNegate(x), below);
+	y = XMVectorSelect(y, XMVectorNegate(y), below);
+	z = XMVectorSelect(z, XMVectorNegate(z), below);
+}
 
-		return XMVector3Normalize(v);
+// Transpose SoA lanes back into count (<= 4) XMFLOAT3.
+static void StoreSoA4(XMFLOAT3* out, size_t count, FXMVECTOR x, FXMVECTOR y, FXMVECTOR z)
+{
+	XMFLOAT4A xs, ys, zs;
+	XMStoreFloat4A(&xs, x);
+	XMStoreFloat4A(&ys, y);
+	XMStoreFloat4A(&zs, z);
+	const float* px = &xs.x;
+	const float* py = &ys.x;
+	const float* pz = &zs.x;
+	for(size_t i = 0; i < count; ++i)
+	{
+		out[i] = XMFLOAT3(px[i], py[i], pz[i]);
 	}
 }
 
+XMVECTOR MathHelper::RandUnitVec3()
+{
+	XMFLOAT3 v;
+	RandUnitVec3(&v, 1);
+	return XMLoadFloat3(&v);
+}
+
 XMVECTOR MathHelper::RandHemisphereUnitVec3(XMVECTOR n)
 {
-	XMVECTOR One  = XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
-	XMVECTOR Zero = XMVectorZero();
+	XMFLOAT3 v;
+	RandHemisphereUnitVec3(n, &v, 1);
+	return XMLoadFloat3(&v);
+}
 
-	// Keep trying until we get a point on/in the hemisphere.
-	while(true)
+void MathHelper::RandUnitVec3(XMFLOAT3* out, size_t count)
+{
+	for(size_t i = 0; i < count; i += 4)
 	{
-		// Generate random point in the cube [-1,1]^3.
-		XMVECTOR v = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), 0.0f);
-
-		// Ignore points outside the unit sphere in order to get an even distribution 
-		// over the unit sphere.  Otherwise points will clump more on the sphere near 
-		// the corners of the cube.
-		
-		if( XMVector3Greater( XMVector3LengthSq(v), One) )
-			continue;
-
-		// Ignore points in the bottom hemisphere.
-		if( XMVector3Less( XMVector3Dot(n, v), Zero ) )
-			continue;
+		XMVECTOR x, y, z;
+		RandUnitSphere4(x, y, z);
+		StoreSoA4(out + i, Min<size_t>(4, count - i), x, y, z);
+	}
+}
 
-		return XMVector3Normalize(v);
+void MathHelper::RandHemisphereUnitVec3(FXMVECTOR n, XMFLOAT3* out, size_t count)
+{
+	for(size_t i = 0; i < count; i += 4)
+	{
+		XMVECTOR x, y, z;
+		RandUnitSphere4(x, y, z);
+		FlipToHemisphere4(n, x, y, z);
+		StoreSoA4(out + i, Min<size_t>(4, count - i), x, y, z);
 	}
-}
\ No newline at end of file
+}
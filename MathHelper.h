@@ -9,14 +9,16 @@
 #include <Windows.h>
 #include <DirectXMath.h>
 #include <cstdint>
+#include "random_generator.h"
 
 class MathHelper
 {
 public:
 	// Returns random float in [0, 1).
+	// Uses the calling thread's generator, see RandomGenerator::ThreadLocal.
 	static float RandF()
 	{
-		return (float)(rand()) / (float)RAND_MAX;
+		return RandomGenerator::ThreadLocal().NextFloat();
 	}
 
 	// Returns random float in [a, b).
@@ -25,9 +27,10 @@ public:
 		return a + RandF()*(b-a);
 	}
 
+    // Returns random int in [a, b].
     static int Rand(int a, int b)
     {
-        return a + rand() % ((b - a) + 1);
+        return RandomGenerator::ThreadLocal().NextInt(a, b);
     }
 
 	template<typename T>
@@ -92,6 +95,11 @@ public:
     static DirectX::XMVECTOR RandUnitVec3();
     static DirectX::XMVECTOR RandHemisphereUnitVec3(DirectX::XMVECTOR n);
 
+    // Bulk versions.  Generate 4 samples per iteration with no rejection loop;
+    // use these for SSAO kernels, particle spawns and other large batches.
+    static void RandUnitVec3(DirectX::XMFLOAT3* out, size_t count);
+    static void RandHemisphereUnitVec3(DirectX::FXMVECTOR n, DirectX::XMFLOAT3* out, size_t count);
+
 	static const float Infinity;
 	static const float Pi;
 
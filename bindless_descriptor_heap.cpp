@@ -0,0 +1,98 @@
+//--------------------------------------------------------------------------------
+//  bindless_descriptor_heap.cpp
+//--------------------------------------------------------------------------------
+#include "bindless_descriptor_heap.h"
+#include "root_signature_layout.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+BindlessDescriptorHeap* BindlessDescriptorHeap::instance_ = nullptr;
+
+uint32_t AddBindlessParameters(RootSignatureLayout& layout, uint32_t constant_register)
+{
+    const uint32_t first = static_cast<uint32_t>(layout.Parameters().size());
+
+    // Unbounded, and slots are written while earlier frames are in flight.
+    RootDescriptorRange range;
+    range.type = DescriptorRangeType::kShaderResourceView;
+    range.count = UINT_MAX;
+    range.space = kBindlessRegisterSpace;
+    range.flags = D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE;
+
+    layout.AddConstants(1, constant_register);
+    layout.AddDescriptorTable(&range, 1);
+    return first;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+BindlessDescriptorHeap* BindlessDescriptorHeap::Create()
+{
+    if (instance_) return instance_;
+    instance_ = new BindlessDescriptorHeap;
+    return instance_;
+}
+
+void BindlessDescriptorHeap::Initialize(ID3D12Device* device, UINT capacity)
+{
+    device_ = device;
+    descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    supported_ = SUCCEEDED(device_->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)))
+        && options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2;
+
+    D3D12_DESCRIPTOR_HEAP_DESC heap_desc;
+    heap_desc.NumDescriptors = capacity;
+    heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    heap_desc.NodeMask = 0;
+    ThrowIfFailed(device_->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(heap_.GetAddressOf())));
+    cpu_start_ = heap_->GetCPUDescriptorHandleForHeapStart();
+
+    table_ = make_unique<BindlessHandleTable>(capacity);
+}
+
+void BindlessDescriptorHeap::Release()
+{
+    // The caller has flushed the queue, nothing references the heap anymore.
+    assert(instance_ != nullptr);
+    instance_ = nullptr;
+    delete this;
+}
+
+BindlessHandle BindlessDescriptorHeap::CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+{
+    const BindlessHandle handle = table_->Allocate();
+    if (handle.IsNull()) return handle;
+
+    // CreateShaderResourceView is free threaded, and nobody else writes this slot.
+    CD3DX12_CPU_DESCRIPTOR_HANDLE destination(cpu_start_, handle.Index(), descriptor_size_);
+    device_->CreateShaderResourceView(resource, desc, destination);
+    return handle;
+}
+
+BindlessHandle BindlessDescriptorHeap::CreateUnorderedAccessView(ID3D12Resource* resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc)
+{
+    const BindlessHandle handle = table_->Allocate();
+    if (handle.IsNull()) return handle;
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE destination(cpu_start_, handle.Index(), descriptor_size_);
+    device_->CreateUnorderedAccessView(resource, nullptr, desc, destination);
+    return handle;
+}
+
+bool BindlessDescriptorHeap::ReleaseView(BindlessHandle handle)
+{
+    return table_->Release(handle, frame_fence_.load(memory_order_acquire));
+}
+
+void BindlessDescriptorHeap::BeginFrame(UINT64 completed_fence, UINT64 frame_fence)
+{
+    frame_fence_.store(frame_fence, memory_order_release);
+    table_->Recycle(completed_fence);
+}
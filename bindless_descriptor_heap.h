@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------
+//  bindless_descriptor_heap.h
+//  One shader visible CBV/SRV/UAV heap holding an SRV for every streamed
+//  texture and buffer.  A view keeps its slot (BindlessHandle::Index) until
+//  released, shaders index the unbounded SRV table with a per draw root
+//  constant (see "Bindless resources" in triangle.hlsl):
+//
+//    const uint32_t first = AddBindlessParameters(layout, 1);
+//    command_list->SetGraphicsRoot32BitConstant(first, handle.Index(), 0);
+//    command_list->SetGraphicsRootDescriptorTable(first + 1, heap.TableStart());
+//
+//  Views are created and released from any thread (loaders); a released
+//  slot is reused once the GPU has passed the frame that was being recorded
+//  when it was released.  The unbounded table needs resource binding tier 2.
+//  Engine passes also keep their UAVs and per mip views here, bound as
+//  ordinary tables with GpuHandle, since only one shader visible heap can be
+//  set at a time.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+#include "bindless_handle_table.h"
+
+class RootSignatureLayout;
+
+constexpr uint32_t kBindlessRegisterSpace = 1;          // Texture2D gBindlessTextures[] : register(t0, space1)
+
+//--------------------------------------------------------------------------------
+//  Adds the draw's resource index (1 root constant at b<constant_register>)
+//  and the bindless table.  Returns the root parameter index of the constant;
+//  the table is the next one.
+//--------------------------------------------------------------------------------
+uint32_t AddBindlessParameters(RootSignatureLayout& layout, uint32_t constant_register);
+
+class BindlessDescriptorHeap
+{
+public:
+    static BindlessDescriptorHeap* Create();
+    static BindlessDescriptorHeap& Instance() { return *instance_; }
+    static bool IsCreated() { return instance_ != nullptr; }
+
+    void Initialize(ID3D12Device* device, UINT capacity = kDefaultCapacity);
+    void Release();
+
+    //--------------------------------------------------------------------------------
+    //  Any thread.  CreateShaderResourceView returns a null handle when the
+    //  heap is full.
+    //--------------------------------------------------------------------------------
+    BindlessHandle CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc);
+    BindlessHandle CreateUnorderedAccessView(ID3D12Resource* resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc);
+    bool ReleaseView(BindlessHandle handle);
+    bool IsValid(BindlessHandle handle) const { return table_->IsValid(handle); }
+
+    //--------------------------------------------------------------------------------
+    //  Render thread, before recording a frame.  completed_fence : last fence
+    //  value the GPU passed, frame_fence : value the frame will signal.
+    //--------------------------------------------------------------------------------
+    void BeginFrame(UINT64 completed_fence, UINT64 frame_fence);
+
+    ID3D12DescriptorHeap* Heap() const { return heap_.Get(); }
+    D3D12_GPU_DESCRIPTOR_HANDLE TableStart() const { return heap_->GetGPUDescriptorHandleForHeapStart(); }
+    D3D12_GPU_DESCRIPTOR_HANDLE GpuHandle(BindlessHandle handle) const
+    {
+        return CD3DX12_GPU_DESCRIPTOR_HANDLE(TableStart(), handle.Index(), descriptor_size_);
+    }
+    bool IsSupported() const { return supported_; }
+    UINT Capacity() const { return table_->Capacity(); }
+
+private:
+    BindlessDescriptorHeap() = default;
+    ~BindlessDescriptorHeap() = default;
+    BindlessDescriptorHeap(const BindlessDescriptorHeap& rhs) = delete;
+    BindlessDescriptorHeap& operator=(const BindlessDescriptorHeap& rhs) = delete;
+
+    static constexpr UINT kDefaultCapacity = 65536;
+
+    ID3D12Device* device_ = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap_;
+    D3D12_CPU_DESCRIPTOR_HANDLE cpu_start_ = {};
+    UINT descriptor_size_ = 0;
+    bool supported_ = false;
+
+    std::unique_ptr<BindlessHandleTable> table_;
+    std::atomic<UINT64> frame_fence_{ 1 };
+
+    static BindlessDescriptorHeap* instance_;
+};
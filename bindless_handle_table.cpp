@@ -0,0 +1,155 @@
+//--------------------------------------------------------------------------------
+//  bindless_handle_table.cpp
+//--------------------------------------------------------------------------------
+#include "bindless_handle_table.h"
+#include <cassert>
+
+using namespace std;
+
+namespace
+{
+    uint32_t NextPowerOfTwo(uint32_t value)
+    {
+        uint32_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    uint64_t PackHead(uint32_t tag, uint32_t index)
+    {
+        return static_cast<uint64_t>(tag) << 32 | index;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+BindlessHandleTable::BindlessHandleTable(uint32_t capacity)
+    : capacity_(capacity)
+    , generations_(new atomic<uint32_t>[capacity])
+    , next_free_(new atomic<uint32_t>[capacity])
+    , free_head_(PackHead(0, kEmpty))
+    , retired_(NextPowerOfTwo(capacity))
+{
+    assert(capacity > 0 && capacity < BindlessHandle::kIndexMask);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        generations_[i].store(0, memory_order_relaxed);
+        next_free_[i].store(kEmpty, memory_order_relaxed);
+    }
+    deferred_.reserve(capacity);
+}
+
+BindlessHandle BindlessHandleTable::Allocate()
+{
+    uint32_t index = PopFree();
+    if (index == kEmpty)
+    {
+        index = high_water_.load(memory_order_relaxed);
+        do
+        {
+            if (index >= capacity_) return BindlessHandle();
+        } while (!high_water_.compare_exchange_weak(index, index + 1, memory_order_relaxed));
+    }
+
+    BindlessHandle handle;
+    handle.value = generations_[index].load(memory_order_acquire) << BindlessHandle::kIndexBits | index;
+    return handle;
+}
+
+bool BindlessHandleTable::Release(BindlessHandle handle, uint64_t fence)
+{
+    const uint32_t index = handle.Index();
+    if (handle.IsNull() || index >= capacity_) return false;
+
+    // Only one Release of a live handle wins; the others see a new generation.
+    uint32_t generation = handle.Generation();
+    const uint32_t next_generation = (generation + 1) & BindlessHandle::kGenerationMask;
+    if (!generations_[index].compare_exchange_strong(generation, next_generation, memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    Retired retired;
+    retired.index = index;
+    retired.fence = fence;
+    const bool pushed = retired_.TryPush(retired);
+    assert(pushed);     // a slot is retired at most once per Recycle, the queue holds them all
+    (void)pushed;
+    return true;
+}
+
+bool BindlessHandleTable::IsValid(BindlessHandle handle) const
+{
+    const uint32_t index = handle.Index();
+    return !handle.IsNull()
+        && index < high_water_.load(memory_order_acquire)
+        && generations_[index].load(memory_order_acquire) == handle.Generation();
+}
+
+uint32_t BindlessHandleTable::Recycle(uint64_t completed_fence)
+{
+    Retired retired;
+    while (retired_.TryPop(retired))
+    {
+        deferred_.push_back(retired);
+    }
+
+    // Fences of releases from different threads are not ordered, so the
+    // whole list is scanned; it only holds the last few frames of releases.
+    uint32_t recycled = 0;
+    size_t kept = 0;
+    for (const Retired& entry : deferred_)
+    {
+        if (entry.fence <= completed_fence)
+        {
+            PushFree(entry.index);
+            ++recycled;
+        }
+        else
+        {
+            deferred_[kept++] = entry;
+        }
+    }
+    deferred_.resize(kept);
+    return recycled;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+uint32_t BindlessHandleTable::PopFree()
+{
+    uint64_t head = free_head_.load(memory_order_acquire);
+    for (;;)
+    {
+        const uint32_t index = static_cast<uint32_t>(head);
+        if (index == kEmpty) return kEmpty;
+
+        // next_free_ may be rewritten by a thread that popped and pushed the
+        // same slot meanwhile; the tag makes the CAS fail in that case.
+        const uint64_t next = PackHead(static_cast<uint32_t>(head >> 32) + 1, next_free_[index].load(memory_order_relaxed));
+        if (free_head_.compare_exchange_weak(head, next, memory_order_acquire, memory_order_acquire))
+        {
+            return index;
+        }
+    }
+}
+
+void BindlessHandleTable::PushFree(uint32_t index)
+{
+    uint64_t head = free_head_.load(memory_order_relaxed);
+    for (;;)
+    {
+        next_free_[index].store(static_cast<uint32_t>(head), memory_order_relaxed);
+        const uint64_t next = PackHead(static_cast<uint32_t>(head >> 32) + 1, index);
+        if (free_head_.compare_exchange_weak(head, next, memory_order_release, memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------
+//  bindless_handle_table.h
+//  Slot allocator behind the bindless descriptor range (portable C++17).
+//  - A handle is a slot index (what shaders see) and a generation; releasing
+//    a slot bumps its generation, so stale handles fail IsValid/Release.
+//  - Allocate and Release are lock free and may be called from any thread
+//    (texture and buffer loaders).  Free slots are a tagged Treiber stack,
+//    released slots go through an MpscQueue with the fence value after which
+//    the GPU no longer reads them.
+//  - Recycle is called by the render thread only; slots whose fence has
+//    completed go back to the free stack.
+//  - Generations have kGenerationBits, a handle kept across 4096 reuses of
+//    its slot would validate again.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "mpsc_queue.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct BindlessHandle
+{
+    static constexpr uint32_t kIndexBits = 20;
+    static constexpr uint32_t kGenerationBits = 32 - kIndexBits;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kGenerationMask = (1u << kGenerationBits) - 1;
+    static constexpr uint32_t kNull = 0xffffffff;       // index kIndexMask is never allocated
+
+    uint32_t value = kNull;
+
+    uint32_t Index() const { return value & kIndexMask; }
+    uint32_t Generation() const { return value >> kIndexBits; }
+    bool IsNull() const { return value == kNull; }
+
+    bool operator==(const BindlessHandle& rhs) const { return value == rhs.value; }
+    bool operator!=(const BindlessHandle& rhs) const { return value != rhs.value; }
+};
+
+class BindlessHandleTable
+{
+public:
+    //--------------------------------------------------------------------------------
+    //  capacity : number of slots, less than BindlessHandle::kIndexMask
+    //--------------------------------------------------------------------------------
+    explicit BindlessHandleTable(uint32_t capacity);
+
+    //--------------------------------------------------------------------------------
+    //  Any thread.  Allocate returns a null handle when every slot is in use or
+    //  waiting for its fence.  Release returns false for a stale handle.
+    //--------------------------------------------------------------------------------
+    BindlessHandle Allocate();
+    bool Release(BindlessHandle handle, uint64_t fence);
+    bool IsValid(BindlessHandle handle) const;
+
+    //--------------------------------------------------------------------------------
+    //  Render thread only.  Returns the number of slots made available.
+    //--------------------------------------------------------------------------------
+    uint32_t Recycle(uint64_t completed_fence);
+
+    uint32_t Capacity() const { return capacity_; }
+    uint32_t PendingCount() const { return static_cast<uint32_t>(deferred_.size()); }
+
+private:
+    BindlessHandleTable(const BindlessHandleTable& rhs) = delete;
+    BindlessHandleTable& operator=(const BindlessHandleTable& rhs) = delete;
+
+    struct Retired
+    {
+        uint32_t index = 0;
+        uint64_t fence = 0;
+    };
+
+    static constexpr uint32_t kEmpty = 0xffffffff;
+
+    uint32_t PopFree();
+    void PushFree(uint32_t index);
+
+    const uint32_t capacity_;
+    std::unique_ptr<std::atomic<uint32_t>[]> generations_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_free_;
+    alignas(64) std::atomic<uint64_t> free_head_;       // tag << 32 | index
+    alignas(64) std::atomic<uint32_t> high_water_{ 0 };  // slots never allocated start here
+    MpscQueue<Retired> retired_;
+    std::vector<Retired> deferred_;                     // render thread only
+};
@@ -0,0 +1,526 @@
+//--------------------------------------------------------------------------------
+//  bounding_volume_hierarchy.cpp
+//--------------------------------------------------------------------------------
+#include "bounding_volume_hierarchy.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    // Rebuild once refitting made the tree this much more expensive than
+    // right after the build, or once this many objects are tested linearly.
+    constexpr float  kRebuildCostRatio = 1.5f;
+    constexpr size_t kMaxPendingObjects = 64;
+
+    struct BuildPrimitive
+    {
+        XMFLOAT3 aabb_min;
+        XMFLOAT3 aabb_max;
+        XMFLOAT3 centroid;
+        uint32_t id;
+    };
+
+    struct Aabb
+    {
+        XMFLOAT3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+        XMFLOAT3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        void Grow(const XMFLOAT3& p_min, const XMFLOAT3& p_max)
+        {
+            min = { fminf(min.x, p_min.x), fminf(min.y, p_min.y), fminf(min.z, p_min.z) };
+            max = { fmaxf(max.x, p_max.x), fmaxf(max.y, p_max.y), fmaxf(max.z, p_max.z) };
+        }
+
+        float HalfArea() const
+        {
+            if (min.x > max.x) return 0.0f;
+            float x = max.x - min.x, y = max.y - min.y, z = max.z - min.z;
+            return x * y + y * z + z * x;
+        }
+    };
+
+    float Axis(const XMFLOAT3& v, int axis)
+    {
+        return (&v.x)[axis];
+    }
+
+    void ToMinMax(const BoundingBox& box, XMFLOAT3& aabb_min, XMFLOAT3& aabb_max)
+    {
+        aabb_min = { box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z };
+        aabb_max = { box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z };
+    }
+
+    bool FrustumIntersects(const XMFLOAT4 planes[6], const XMFLOAT3& aabb_min, const XMFLOAT3& aabb_max)
+    {
+        const XMFLOAT3 c = { (aabb_min.x + aabb_max.x) * 0.5f, (aabb_min.y + aabb_max.y) * 0.5f, (aabb_min.z + aabb_max.z) * 0.5f };
+        const XMFLOAT3 e = { (aabb_max.x - aabb_min.x) * 0.5f, (aabb_max.y - aabb_min.y) * 0.5f, (aabb_max.z - aabb_min.z) * 0.5f };
+        for (int i = 0; i < 6; ++i)
+        {
+            const XMFLOAT4& p = planes[i];
+            float distance = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+            float radius = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+            if (distance + radius < 0.0f) return false;
+        }
+        return true;
+    }
+
+    bool Overlaps(const XMFLOAT3& a_min, const XMFLOAT3& a_max, const XMFLOAT3& b_min, const XMFLOAT3& b_max)
+    {
+        return a_min.x <= b_max.x && a_max.x >= b_min.x
+            && a_min.y <= b_max.y && a_max.y >= b_min.y
+            && a_min.z <= b_max.z && a_max.z >= b_min.z;
+    }
+
+    // Slab test; returns the entry distance or FLT_MAX on a miss.
+    float RayAabb(const XMFLOAT3& origin, const XMFLOAT3& inv_dir, float max_distance, const XMFLOAT3& aabb_min, const XMFLOAT3& aabb_max)
+    {
+        float t0 = (aabb_min.x - origin.x) * inv_dir.x, t1 = (aabb_max.x - origin.x) * inv_dir.x;
+        float t_near = fminf(t0, t1), t_far = fmaxf(t0, t1);
+        t0 = (aabb_min.y - origin.y) * inv_dir.y; t1 = (aabb_max.y - origin.y) * inv_dir.y;
+        t_near = fmaxf(t_near, fminf(t0, t1)); t_far = fminf(t_far, fmaxf(t0, t1));
+        t0 = (aabb_min.z - origin.z) * inv_dir.z; t1 = (aabb_max.z - origin.z) * inv_dir.z;
+        t_near = fmaxf(t_near, fminf(t0, t1)); t_far = fminf(t_far, fmaxf(t0, t1));
+        t_near = fmaxf(t_near, 0.0f);
+        return (t_near <= t_far && t_near <= max_distance) ? t_near : FLT_MAX;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+    if (rebuild_.valid()) rebuild_.wait();
+}
+
+uint32_t BoundingVolumeHierarchy::AddObject(const BoundingBox& bounds)
+{
+    uint32_t id;
+    if (free_ids_.empty())
+    {
+        id = static_cast<uint32_t>(objects_.size());
+        objects_.emplace_back();
+    }
+    else
+    {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+    }
+    objects_[id].bounds = bounds;
+    objects_[id].alive = true;
+    pending_.push_back(id);
+    return id;
+}
+
+void BoundingVolumeHierarchy::RemoveObject(uint32_t id)
+{
+    assert(id < objects_.size() && objects_[id].alive);
+    objects_[id].alive = false;
+
+    // The tree may still reference the id, so it is only recycled after a rebuild.
+    auto it = find(pending_.begin(), pending_.end(), id);
+    if (it != pending_.end())
+    {
+        *it = pending_.back();
+        pending_.pop_back();
+    }
+    removed_ids_.push_back(id);
+}
+
+void BoundingVolumeHierarchy::UpdateObject(uint32_t id, const BoundingBox& bounds)
+{
+    assert(id < objects_.size() && objects_[id].alive);
+    objects_[id].bounds = bounds;
+}
+
+void BoundingVolumeHierarchy::Refit()
+{
+    // Children always follow their parent in depth first order,
+    // so a reverse sweep sees children before parents.
+    for (size_t i = nodes_.size(); i-- > 0;)
+    {
+        Node& node = nodes_[i];
+        Aabb box;
+        if (node.IsLeaf())
+        {
+            for (uint32_t j = 0; j < node.ObjectCount(); ++j)
+            {
+                const Object& object = objects_[object_ids_[node.FirstObject() + j]];
+                if (!object.alive) continue;
+                XMFLOAT3 o_min, o_max;
+                ToMinMax(object.bounds, o_min, o_max);
+                box.Grow(o_min, o_max);
+            }
+        }
+        else
+        {
+            const Node& left = nodes_[i + 1];
+            const Node& right = nodes_[left.escape];
+            box.Grow(left.aabb_min, left.aabb_max);
+            box.Grow(right.aabb_min, right.aabb_max);
+        }
+        node.aabb_min = box.min;
+        node.aabb_max = box.max;
+    }
+    current_cost_ = CostRatio();
+}
+
+void BoundingVolumeHierarchy::Rebuild()
+{
+    // A background result is superseded, but the ids it would recycle are still dead.
+    if (rebuild_.valid())
+    {
+        BuildResult stale = rebuild_.get();
+        removed_ids_.insert(removed_ids_.end(), stale.recycle_ids.begin(), stale.recycle_ids.end());
+    }
+
+    vector<BoundingBox> bounds;
+    vector<uint32_t> ids;
+    SnapshotForBuild(bounds, ids);
+    BuildResult result = Build(move(bounds), move(ids));
+    result.recycle_ids.swap(removed_ids_);
+    ApplyBuildResult(result);
+}
+
+void BoundingVolumeHierarchy::RebuildAsync()
+{
+    if (rebuild_.valid()) return;
+
+    vector<BoundingBox> bounds;
+    vector<uint32_t> ids;
+    SnapshotForBuild(bounds, ids);
+    vector<uint32_t> recycle_ids;
+    recycle_ids.swap(removed_ids_);
+
+    rebuild_ = async(launch::async, [](vector<BoundingBox> bounds, vector<uint32_t> ids, vector<uint32_t> recycle_ids)
+    {
+        BuildResult result = Build(move(bounds), move(ids));
+        result.recycle_ids = move(recycle_ids);
+        return result;
+    }, move(bounds), move(ids), move(recycle_ids));
+}
+
+bool BoundingVolumeHierarchy::ApplyRebuild()
+{
+    if (!rebuild_.valid()) return false;
+    if (rebuild_.wait_for(chrono::seconds(0)) != future_status::ready) return false;
+
+    BuildResult result = rebuild_.get();
+    ApplyBuildResult(result);
+    return true;
+}
+
+bool BoundingVolumeHierarchy::NeedsRebuild() const
+{
+    if (pending_.size() > kMaxPendingObjects) return true;
+    return built_cost_ > 0.0f && current_cost_ > built_cost_ * kRebuildCostRatio;
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const XMFLOAT4 planes[6], vector<uint32_t>& result) const
+{
+    const uint32_t node_count = static_cast<uint32_t>(nodes_.size());
+    uint32_t i = 0;
+    while (i < node_count)
+    {
+        const Node& node = nodes_[i];
+        if (!FrustumIntersects(planes, node.aabb_min, node.aabb_max))
+        {
+            i = node.escape;
+            continue;
+        }
+        if (node.IsLeaf())
+        {
+            for (uint32_t j = 0; j < node.ObjectCount(); ++j)
+            {
+                uint32_t id = object_ids_[node.FirstObject() + j];
+                const Object& object = objects_[id];
+                XMFLOAT3 o_min, o_max;
+                ToMinMax(object.bounds, o_min, o_max);
+                if (object.alive && FrustumIntersects(planes, o_min, o_max)) result.push_back(id);
+            }
+        }
+        ++i;
+    }
+
+    for (uint32_t id : pending_)
+    {
+        XMFLOAT3 o_min, o_max;
+        ToMinMax(objects_[id].bounds, o_min, o_max);
+        if (FrustumIntersects(planes, o_min, o_max)) result.push_back(id);
+    }
+}
+
+void BoundingVolumeHierarchy::QueryOverlap(const BoundingBox& bounds, vector<uint32_t>& result) const
+{
+    XMFLOAT3 q_min, q_max;
+    ToMinMax(bounds, q_min, q_max);
+
+    const uint32_t node_count = static_cast<uint32_t>(nodes_.size());
+    uint32_t i = 0;
+    while (i < node_count)
+    {
+        const Node& node = nodes_[i];
+        if (!Overlaps(q_min, q_max, node.aabb_min, node.aabb_max))
+        {
+            i = node.escape;
+            continue;
+        }
+        if (node.IsLeaf())
+        {
+            for (uint32_t j = 0; j < node.ObjectCount(); ++j)
+            {
+                uint32_t id = object_ids_[node.FirstObject() + j];
+                const Object& object = objects_[id];
+                XMFLOAT3 o_min, o_max;
+                ToMinMax(object.bounds, o_min, o_max);
+                if (object.alive && Overlaps(q_min, q_max, o_min, o_max)) result.push_back(id);
+            }
+        }
+        ++i;
+    }
+
+    for (uint32_t id : pending_)
+    {
+        XMFLOAT3 o_min, o_max;
+        ToMinMax(objects_[id].bounds, o_min, o_max);
+        if (Overlaps(q_min, q_max, o_min, o_max)) result.push_back(id);
+    }
+}
+
+uint32_t BoundingVolumeHierarchy::RayCast(FXMVECTOR origin, FXMVECTOR direction, float max_distance, float* hit_distance) const
+{
+    XMFLOAT3 o, inv_dir;
+    XMStoreFloat3(&o, origin);
+    XMStoreFloat3(&inv_dir, XMVectorReciprocal(direction));
+
+    uint32_t best_id = kInvalidObject;
+    float best_distance = max_distance;
+
+    auto test_object = [&](uint32_t id)
+    {
+        const Object& object = objects_[id];
+        if (!object.alive) return;
+        XMFLOAT3 o_min, o_max;
+        ToMinMax(object.bounds, o_min, o_max);
+        float t = RayAabb(o, inv_dir, best_distance, o_min, o_max);
+        if (t < best_distance)
+        {
+            best_distance = t;
+            best_id = id;
+        }
+    };
+
+    const uint32_t node_count = static_cast<uint32_t>(nodes_.size());
+    uint32_t i = 0;
+    while (i < node_count)
+    {
+        const Node& node = nodes_[i];
+        if (RayAabb(o, inv_dir, best_distance, node.aabb_min, node.aabb_max) == FLT_MAX)
+        {
+            i = node.escape;
+            continue;
+        }
+        if (node.IsLeaf())
+        {
+            for (uint32_t j = 0; j < node.ObjectCount(); ++j) test_object(object_ids_[node.FirstObject() + j]);
+        }
+        ++i;
+    }
+    for (uint32_t id : pending_) test_object(id);
+
+    if (hit_distance && best_id != kInvalidObject) *hit_distance = best_distance;
+    return best_id;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+BoundingVolumeHierarchy::BuildResult BoundingVolumeHierarchy::Build(vector<BoundingBox> bounds, vector<uint32_t> ids)
+{
+    BuildResult result;
+    if (ids.empty()) return result;
+
+    vector<BuildPrimitive> primitives(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        BuildPrimitive& p = primitives[i];
+        ToMinMax(bounds[i], p.aabb_min, p.aabb_max);
+        p.centroid = bounds[i].Center;
+        p.id = ids[i];
+    }
+
+    result.nodes.reserve(2 * ids.size() / kMaxLeafSize + 1);
+    result.object_ids.reserve(ids.size());
+
+    // Depth first, so the recursion emits nodes in traversal order.
+    struct Builder
+    {
+        vector<BuildPrimitive>& primitives;
+        BuildResult& result;
+
+        void Emit(size_t begin, size_t end)
+        {
+            const uint32_t node_index = static_cast<uint32_t>(result.nodes.size());
+            result.nodes.emplace_back();
+
+            Aabb box, centroid_box;
+            for (size_t i = begin; i < end; ++i)
+            {
+                box.Grow(primitives[i].aabb_min, primitives[i].aabb_max);
+                centroid_box.Grow(primitives[i].centroid, primitives[i].centroid);
+            }
+
+            const size_t count = end - begin;
+            if (count <= kMaxLeafSize)
+            {
+                Node& node = result.nodes[node_index];
+                node.aabb_min = box.min;
+                node.aabb_max = box.max;
+                node.leaf = (static_cast<uint32_t>(result.object_ids.size()) << 3) | static_cast<uint32_t>(count);
+                node.escape = node_index + 1;
+                for (size_t i = begin; i < end; ++i) result.object_ids.push_back(primitives[i].id);
+                return;
+            }
+
+            // Binned SAH over centroid bounds on every axis.
+            int best_axis = -1;
+            uint32_t best_split = 0;
+            float best_cost = FLT_MAX;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float axis_min = Axis(centroid_box.min, axis);
+                const float axis_extent = Axis(centroid_box.max, axis) - axis_min;
+                if (axis_extent <= 0.0f) continue;
+                const float scale = kSahBinCount / axis_extent;
+
+                Aabb bin_box[kSahBinCount];
+                uint32_t bin_count[kSahBinCount] = {};
+                for (size_t i = begin; i < end; ++i)
+                {
+                    uint32_t bin = min(kSahBinCount - 1, static_cast<uint32_t>((Axis(primitives[i].centroid, axis) - axis_min) * scale));
+                    bin_box[bin].Grow(primitives[i].aabb_min, primitives[i].aabb_max);
+                    ++bin_count[bin];
+                }
+
+                // Sweep from the right to get suffix areas, then from the left.
+                float right_area[kSahBinCount];
+                uint32_t right_count[kSahBinCount];
+                Aabb accumulated;
+                uint32_t accumulated_count = 0;
+                for (uint32_t b = kSahBinCount - 1; b > 0; --b)
+                {
+                    accumulated.Grow(bin_box[b].min, bin_box[b].max);
+                    accumulated_count += bin_count[b];
+                    right_area[b] = accumulated.HalfArea();
+                    right_count[b] = accumulated_count;
+                }
+                accumulated = Aabb();
+                accumulated_count = 0;
+                for (uint32_t b = 1; b < kSahBinCount; ++b)
+                {
+                    accumulated.Grow(bin_box[b - 1].min, bin_box[b - 1].max);
+                    accumulated_count += bin_count[b - 1];
+                    if (accumulated_count == 0 || right_count[b] == 0) continue;
+                    float cost = accumulated.HalfArea() * accumulated_count + right_area[b] * right_count[b];
+                    if (cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_split = b;
+                    }
+                }
+            }
+
+            size_t middle;
+            if (best_axis < 0)
+            {
+                // All centroids coincide; split by count.
+                middle = begin + count / 2;
+            }
+            else
+            {
+                const float axis_min = Axis(centroid_box.min, best_axis);
+                const float scale = kSahBinCount / (Axis(centroid_box.max, best_axis) - axis_min);
+                auto it = partition(primitives.begin() + begin, primitives.begin() + end, [&](const BuildPrimitive& p)
+                {
+                    return min(kSahBinCount - 1, static_cast<uint32_t>((Axis(p.centroid, best_axis) - axis_min) * scale)) < best_split;
+                });
+                middle = static_cast<size_t>(it - primitives.begin());
+            }
+
+            Emit(begin, middle);
+            Emit(middle, end);
+
+            Node& node = result.nodes[node_index];
+            node.aabb_min = box.min;
+            node.aabb_max = box.max;
+            node.leaf = 0;
+            node.escape = static_cast<uint32_t>(result.nodes.size());
+        }
+    };
+
+    Builder builder = { primitives, result };
+    builder.Emit(0, primitives.size());
+    return result;
+}
+
+void BoundingVolumeHierarchy::ApplyBuildResult(BuildResult& result)
+{
+    nodes_.swap(result.nodes);
+    object_ids_.swap(result.object_ids);
+    free_ids_.insert(free_ids_.end(), result.recycle_ids.begin(), result.recycle_ids.end());
+
+    // Objects added (or re-added) while a background build ran are still pending.
+    vector<uint8_t> in_tree(objects_.size(), 0);
+    for (uint32_t id : object_ids_) in_tree[id] = 1;
+    pending_.clear();
+    for (uint32_t id = 0; id < objects_.size(); ++id)
+    {
+        if (objects_[id].alive && !in_tree[id]) pending_.push_back(id);
+    }
+
+    // Objects may have moved since the snapshot.
+    Refit();
+    built_cost_ = current_cost_;
+}
+
+void BoundingVolumeHierarchy::SnapshotForBuild(vector<BoundingBox>& bounds, vector<uint32_t>& ids) const
+{
+    bounds.reserve(objects_.size());
+    ids.reserve(objects_.size());
+    for (uint32_t id = 0; id < objects_.size(); ++id)
+    {
+        if (!objects_[id].alive) continue;
+        bounds.push_back(objects_[id].bounds);
+        ids.push_back(id);
+    }
+}
+
+float BoundingVolumeHierarchy::CostRatio() const
+{
+    if (nodes_.empty()) return 0.0f;
+
+    Aabb root;
+    root.Grow(nodes_[0].aabb_min, nodes_[0].aabb_max);
+    const float root_area = root.HalfArea();
+    if (root_area <= 0.0f) return 0.0f;
+
+    // SAH cost relative to the root: sum of node areas weighted by leaf sizes.
+    float cost = 0.0f;
+    for (const Node& node : nodes_)
+    {
+        Aabb box;
+        box.Grow(node.aabb_min, node.aabb_max);
+        cost += box.HalfArea() * (node.IsLeaf() ? static_cast<float>(node.ObjectCount()) : 1.0f);
+    }
+    return cost / root_area;
+}
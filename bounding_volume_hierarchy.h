@@ -0,0 +1,120 @@
+//--------------------------------------------------------------------------------
+//  bounding_volume_hierarchy.h
+//  Dynamic BVH over world space object bounds (SubmeshGeometry::Bounds moved
+//  by their instance transform).
+//  - Moving objects are handled by Refit; the tree is rebuilt with binned SAH
+//    either synchronously or on a background thread (RebuildAsync/ApplyRebuild).
+//  - Nodes are stored in depth first order with an escape index, so queries
+//    walk the array front to back without a stack.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+class BoundingVolumeHierarchy
+{
+public:
+    static constexpr uint32_t kInvalidObject = 0xffffffff;
+    static constexpr uint32_t kMaxLeafSize = 4;
+    static constexpr uint32_t kSahBinCount = 16;
+
+    BoundingVolumeHierarchy() = default;
+    ~BoundingVolumeHierarchy();
+
+    //--------------------------------------------------------------------------------
+    //  Object management
+    //  New objects are tested linearly until the next rebuild.
+    //--------------------------------------------------------------------------------
+    uint32_t AddObject(const DirectX::BoundingBox& bounds);
+    void     RemoveObject(uint32_t id);
+    void     UpdateObject(uint32_t id, const DirectX::BoundingBox& bounds);
+    const DirectX::BoundingBox& ObjectBounds(uint32_t id) const { return objects_[id].bounds; }
+
+    //--------------------------------------------------------------------------------
+    //  Recompute node bounds bottom up after objects moved
+    //--------------------------------------------------------------------------------
+    void Refit();
+
+    //--------------------------------------------------------------------------------
+    //  Full SAH rebuild on the calling thread
+    //--------------------------------------------------------------------------------
+    void Rebuild();
+
+    //--------------------------------------------------------------------------------
+    //  Start a SAH rebuild from a snapshot of the current bounds on a background
+    //  thread.  Does nothing if one is already running.
+    //--------------------------------------------------------------------------------
+    void RebuildAsync();
+
+    //--------------------------------------------------------------------------------
+    //  Swap in the background result if it is finished (refits it with the
+    //  latest bounds).  Returns true when the tree was replaced.
+    //--------------------------------------------------------------------------------
+    bool ApplyRebuild();
+
+    //--------------------------------------------------------------------------------
+    //  True when refitting degraded the tree or too many objects are pending
+    //--------------------------------------------------------------------------------
+    bool NeedsRebuild() const;
+
+    //--------------------------------------------------------------------------------
+    //  Queries.  Results are object ids in no particular order.
+    //--------------------------------------------------------------------------------
+    void QueryFrustum(const DirectX::XMFLOAT4 planes[6], std::vector<uint32_t>& result) const;
+    void QueryOverlap(const DirectX::BoundingBox& bounds, std::vector<uint32_t>& result) const;
+
+    //--------------------------------------------------------------------------------
+    //  Closest object whose bounds the ray hits.  direction must be normalized.
+    //  Returns kInvalidObject on a miss.
+    //--------------------------------------------------------------------------------
+    uint32_t RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float max_distance, float* hit_distance = nullptr) const;
+
+    size_t NodeCount() const { return nodes_.size(); }
+    size_t PendingCount() const { return pending_.size(); }
+
+private:
+    // 32 bytes, two nodes per cache line.
+    struct Node
+    {
+        DirectX::XMFLOAT3 aabb_min;
+        uint32_t          escape;  // next node when this subtree is skipped
+        DirectX::XMFLOAT3 aabb_max;
+        uint32_t          leaf;    // (first object << 3) | count, 0 for internal nodes
+
+        bool     IsLeaf() const { return leaf != 0; }
+        uint32_t FirstObject() const { return leaf >> 3; }
+        uint32_t ObjectCount() const { return leaf & 7; }
+    };
+
+    struct Object
+    {
+        DirectX::BoundingBox bounds;
+        bool alive = false;
+    };
+
+    struct BuildResult
+    {
+        std::vector<Node>     nodes;
+        std::vector<uint32_t> object_ids;
+        std::vector<uint32_t> recycle_ids; // removed before the snapshot
+    };
+
+    static BuildResult Build(std::vector<DirectX::BoundingBox> bounds, std::vector<uint32_t> ids);
+    void  ApplyBuildResult(BuildResult& result);
+    void  SnapshotForBuild(std::vector<DirectX::BoundingBox>& bounds, std::vector<uint32_t>& ids) const;
+    float CostRatio() const;
+
+    std::vector<Node>     nodes_;
+    std::vector<uint32_t> object_ids_; // leaf ranges index this
+    std::vector<Object>   objects_;
+    std::vector<uint32_t> pending_;    // alive objects not in the tree yet
+    std::vector<uint32_t> removed_ids_;
+    std::vector<uint32_t> free_ids_;
+    float built_cost_ = 0.0f;
+    float current_cost_ = 0.0f;
+
+    std::future<BuildResult> rebuild_;
+};
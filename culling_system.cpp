@@ -0,0 +1,202 @@
+//--------------------------------------------------------------------------------
+//  culling_system.cpp
+//--------------------------------------------------------------------------------
+#include "culling_system.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void CullingSystem::Resize(size_t instance_count)
+{
+    instance_count_ = instance_count;
+    const size_t padded = (instance_count + 3) & ~static_cast<size_t>(3);
+
+    // Padding lanes are tested but masked out when the result is compacted.
+    center_x_.resize(padded, 0.0f);
+    center_y_.resize(padded, 0.0f);
+    center_z_.resize(padded, 0.0f);
+    extent_x_.resize(padded, 0.0f);
+    extent_y_.resize(padded, 0.0f);
+    extent_z_.resize(padded, 0.0f);
+}
+
+void CullingSystem::SetInstance(size_t index, const XMFLOAT4X4& world, const BoundingBox& local_bounds)
+{
+    assert(index < instance_count_);
+    XMMATRIX m = XMLoadFloat4x4(&world);
+    XMVECTOR center = XMVector3Transform(XMLoadFloat3(&local_bounds.Center), m);
+
+    // Extents of the transformed box are |M| applied to the local extents.
+    XMVECTOR extents = XMVectorMultiply(XMVectorAbs(m.r[0]), XMVectorReplicate(local_bounds.Extents.x));
+    extents = XMVectorMultiplyAdd(XMVectorAbs(m.r[1]), XMVectorReplicate(local_bounds.Extents.y), extents);
+    extents = XMVectorMultiplyAdd(XMVectorAbs(m.r[2]), XMVectorReplicate(local_bounds.Extents.z), extents);
+
+    XMFLOAT3 c, e;
+    XMStoreFloat3(&c, center);
+    XMStoreFloat3(&e, extents);
+    center_x_[index] = c.x;
+    center_y_[index] = c.y;
+    center_z_[index] = c.z;
+    extent_x_[index] = e.x;
+    extent_y_[index] = e.y;
+    extent_z_[index] = e.z;
+}
+
+void CullingSystem::SetInstances(const XMFLOAT4X4* worlds, const BoundingBox* local_bounds, size_t count)
+{
+    Resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        SetInstance(i, worlds[i], local_bounds[i]);
+    }
+}
+
+void CullingSystem::Cull(FXMMATRIX view_proj, vector<uint32_t>& visible, uint32_t worker_count) const
+{
+    XMFLOAT4 planes[6];
+    ExtractFrustumPlanes(view_proj, planes);
+    visible.clear();
+
+    const bool parallel = JobSystem::IsCreated();
+    if (worker_count == 0) worker_count = parallel ? JobSystem::Instance().WorkerCount() : 1;
+    const size_t max_chunks = max<size_t>(1, instance_count_ / kMinInstancesPerWorker);
+    const size_t chunk_count = parallel ? min<size_t>(worker_count, max_chunks) : 1;
+
+    if (chunk_count == 1)
+    {
+        CullRange(planes, 0, instance_count_, visible);
+        return;
+    }
+
+    // Split into 4-aligned chunks; each chunk compacts into its own list and
+    // the lists are concatenated in order so the output stays sorted.
+    const size_t chunk = ((instance_count_ / chunk_count) + 3) & ~static_cast<size_t>(3);
+    vector<vector<uint32_t>> chunk_visible(chunk_count);
+    JobSystem::Instance().ParallelFor(chunk_count, [this, &planes, &chunk_visible, chunk, chunk_count](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            const size_t begin = min(instance_count_, chunk * i);
+            const size_t end = (i + 1 == chunk_count) ? instance_count_ : min(instance_count_, chunk * (i + 1));
+            CullRange(planes, begin, end, chunk_visible[i]);
+        }
+    });
+
+    size_t total = 0;
+    for (auto& list : chunk_visible) total += list.size();
+    visible.reserve(total);
+    for (auto& list : chunk_visible) visible.insert(visible.end(), list.begin(), list.end());
+}
+
+void CullingSystem::ProjectedRadii(FXMVECTOR eye, float projection_scale,
+    const uint32_t* visible, size_t visible_count, float* radii) const
+{
+    XMFLOAT3 e;
+    XMStoreFloat3(&e, eye);
+    for (size_t i = 0; i < visible_count; ++i)
+    {
+        const uint32_t index = visible[i];
+        assert(index < instance_count_);
+        const float dx = center_x_[index] - e.x;
+        const float dy = center_y_[index] - e.y;
+        const float dz = center_z_[index] - e.z;
+        const float radius = sqrtf(extent_x_[index] * extent_x_[index]
+            + extent_y_[index] * extent_y_[index]
+            + extent_z_[index] * extent_z_[index]);
+        const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+        radii[i] = distance > radius ? radius * projection_scale / distance : projection_scale;
+    }
+}
+
+void CullingSystem::ExtractFrustumPlanes(FXMMATRIX view_proj, XMFLOAT4 planes[6])
+{
+    // Row vector convention (v * M): the clip coordinates are dot products with
+    // the columns of M, so work on the transpose.
+    XMMATRIX t = XMMatrixTranspose(view_proj);
+    XMStoreFloat4(&planes[0], XMVectorAdd(t.r[3], t.r[0]));      // left
+    XMStoreFloat4(&planes[1], XMVectorSubtract(t.r[3], t.r[0])); // right
+    XMStoreFloat4(&planes[2], XMVectorAdd(t.r[3], t.r[1]));      // bottom
+    XMStoreFloat4(&planes[3], XMVectorSubtract(t.r[3], t.r[1])); // top
+    XMStoreFloat4(&planes[4], t.r[2]);                           // near (z >= 0)
+    XMStoreFloat4(&planes[5], XMVectorSubtract(t.r[3], t.r[2])); // far
+}
+
+bool CullingSystem::IsBoxVisible(const XMFLOAT4 planes[6], const BoundingBox& world_bounds)
+{
+    const XMFLOAT3& c = world_bounds.Center;
+    const XMFLOAT3& e = world_bounds.Extents;
+    for (int i = 0; i < 6; ++i)
+    {
+        const XMFLOAT4& p = planes[i];
+        float distance = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+        float radius = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+        if (distance + radius < 0.0f) return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void CullingSystem::CullRange(const XMFLOAT4 planes[6], size_t begin, size_t end, vector<uint32_t>& visible) const
+{
+    if (begin >= end) return;
+    assert((begin & 3) == 0);
+    visible.reserve(visible.size() + (end - begin));
+
+    XMVECTOR plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+    XMVECTOR abs_x[6], abs_y[6], abs_z[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        plane_x[i] = XMVectorReplicate(planes[i].x);
+        plane_y[i] = XMVectorReplicate(planes[i].y);
+        plane_z[i] = XMVectorReplicate(planes[i].z);
+        plane_w[i] = XMVectorReplicate(planes[i].w);
+        abs_x[i] = XMVectorAbs(plane_x[i]);
+        abs_y[i] = XMVectorAbs(plane_y[i]);
+        abs_z[i] = XMVectorAbs(plane_z[i]);
+    }
+
+    // Test 4 boxes per iteration against all planes.
+    for (size_t i = begin; i < end; i += 4)
+    {
+        XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&center_x_[i]));
+        XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&center_y_[i]));
+        XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&center_z_[i]));
+        XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&extent_x_[i]));
+        XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&extent_y_[i]));
+        XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&extent_z_[i]));
+
+        XMVECTOR outside = XMVectorFalseInt();
+        for (int p = 0; p < 6; ++p)
+        {
+            XMVECTOR distance = XMVectorMultiplyAdd(cx, plane_x[p], plane_w[p]);
+            distance = XMVectorMultiplyAdd(cy, plane_y[p], distance);
+            distance = XMVectorMultiplyAdd(cz, plane_z[p], distance);
+            XMVECTOR radius = XMVectorMultiply(ex, abs_x[p]);
+            radius = XMVectorMultiplyAdd(ey, abs_y[p], radius);
+            radius = XMVectorMultiplyAdd(ez, abs_z[p], radius);
+            outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(distance, radius), XMVectorZero()));
+        }
+
+        XMUINT4 mask;
+        XMStoreUInt4(&mask, outside);
+        const uint32_t lanes = static_cast<uint32_t>(min<size_t>(4, end - i));
+        const uint32_t* outside_lane = &mask.x;
+        for (uint32_t lane = 0; lane < lanes; ++lane)
+        {
+            if (outside_lane[lane] == 0) visible.push_back(static_cast<uint32_t>(i + lane));
+        }
+    }
+}
@@ -0,0 +1,69 @@
+//--------------------------------------------------------------------------------
+//  culling_system.h
+//  View frustum culling over instance bounds stored in SoA form (CPU only).
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class CullingSystem
+{
+public:
+    //--------------------------------------------------------------------------------
+    //  Set the number of instances (contents of new instances are undefined)
+    //--------------------------------------------------------------------------------
+    void Resize(size_t instance_count);
+    size_t InstanceCount() const { return instance_count_; }
+
+    //--------------------------------------------------------------------------------
+    //  Transform a submesh's local bounds (SubmeshGeometry::Bounds) by the
+    //  instance world matrix and store the world space box
+    //--------------------------------------------------------------------------------
+    void SetInstance(size_t index, const DirectX::XMFLOAT4X4& world, const DirectX::BoundingBox& local_bounds);
+
+    //--------------------------------------------------------------------------------
+    //  Same as above for every instance at once
+    //--------------------------------------------------------------------------------
+    void SetInstances(const DirectX::XMFLOAT4X4* worlds, const DirectX::BoundingBox* local_bounds, size_t count);
+
+    //--------------------------------------------------------------------------------
+    //  Cull against the frustum of view_proj and write the indices of visible
+    //  instances into visible (ascending order).  Runs on the JobSystem when
+    //  it has been created.
+    //  worker_count 0 : split into JobSystem::WorkerCount() chunks
+    //--------------------------------------------------------------------------------
+    void Cull(DirectX::FXMMATRIX view_proj, std::vector<uint32_t>& visible, uint32_t worker_count = 0) const;
+
+    //--------------------------------------------------------------------------------
+    //  Projected bounding sphere radius in pixels of the instances in visible
+    //  (the output of Cull).  The sphere encloses the world space box, so the
+    //  result is conservative for rotated instances.
+    //  projection_scale : viewport height / (2 * tan(fov_y / 2))
+    //  An eye inside a sphere gives projection_scale (always the finest LOD).
+    //--------------------------------------------------------------------------------
+    void ProjectedRadii(DirectX::FXMVECTOR eye, float projection_scale,
+        const uint32_t* visible, size_t visible_count, float* radii) const;
+
+    //--------------------------------------------------------------------------------
+    //  Extract the 6 frustum planes (pointing inside) from a view projection
+    //  matrix with D3D clip space (0 <= z <= w)
+    //--------------------------------------------------------------------------------
+    static void ExtractFrustumPlanes(DirectX::FXMMATRIX view_proj, DirectX::XMFLOAT4 planes[6]);
+
+    //--------------------------------------------------------------------------------
+    //  Scalar reference test for one world space box
+    //--------------------------------------------------------------------------------
+    static bool IsBoxVisible(const DirectX::XMFLOAT4 planes[6], const DirectX::BoundingBox& world_bounds);
+
+    static constexpr size_t kMinInstancesPerWorker = 4096;
+
+private:
+    void CullRange(const DirectX::XMFLOAT4 planes[6], size_t begin, size_t end, std::vector<uint32_t>& visible) const;
+
+    // World space boxes, padded to a multiple of 4 so the SIMD loop has no tail.
+    std::vector<float> center_x_, center_y_, center_z_;
+    std::vector<float> extent_x_, extent_y_, extent_z_;
+    size_t instance_count_ = 0;
+};
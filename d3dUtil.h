@@ -146,12 +146,22 @@ public:
 // geometries are stored in one vertex and index buffer.  It provides the offsets
 // and data needed to draw a subset of geometry stores in the vertex and index 
 // buffers so that we can implement the technique described by Figure 6.3.
+struct SubmeshLod
+{
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	float Error = 0.0f;    // simplification error relative to the length of Bounds.Extents
+};
+
 struct SubmeshGeometry
 {
 	UINT IndexCount = 0;
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
 
+	// Coarser index ranges in the same index buffer, drawn with BaseVertexLocation.
+	std::vector<SubmeshLod> Lods;
+
     // Bounding box of the geometry defined by this submesh. 
     // This is used in later chapters of the book.
 	DirectX::BoundingBox Bounds;
@@ -0,0 +1,190 @@
+//--------------------------------------------------------------------------------
+//  depth_rasterizer.cpp
+//--------------------------------------------------------------------------------
+#include "depth_rasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    // 8 bits of sub pixel precision like D3D; edge functions are exact in 64 bits.
+    constexpr int kSubPixelBits = 8;
+    constexpr float kSubPixelScale = static_cast<float>(1 << kSubPixelBits);
+
+    // Clip space x and y are kept within this multiple of w, so snapped
+    // coordinates stay far from overflowing.
+    constexpr float kGuardBand = 64.0f;
+
+    struct ScreenVertex
+    {
+        int64_t x, y;       // fixed point pixels, y down
+        float z;
+    };
+
+    int64_t Edge(const ScreenVertex& a, const ScreenVertex& b, int64_t x, int64_t y)
+    {
+        return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    }
+
+    // With a positive area and y down, top edges run +x and left edges run -y.
+    bool IsTopLeft(const ScreenVertex& a, const ScreenVertex& b)
+    {
+        return (a.y == b.y && b.x > a.x) || b.y < a.y;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void DepthRasterizer::Resize(uint32_t width, uint32_t height)
+{
+    width_ = width;
+    height_ = height;
+    depth_.resize(static_cast<size_t>(width) * height);
+}
+
+void DepthRasterizer::Clear(float depth)
+{
+    fill(depth_.begin(), depth_.end(), depth);
+}
+
+void DepthRasterizer::DrawIndexed(const float* positions, size_t stride, const uint32_t* indices, size_t index_count,
+    const float world_view_proj[16])
+{
+    const float* m = world_view_proj;
+    const char* base = reinterpret_cast<const char*>(positions);
+    for (size_t i = 0; i + 2 < index_count; i += 3)
+    {
+        ClipVertex triangle[3];
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const float* p = reinterpret_cast<const float*>(base + indices[i + corner] * stride);
+            ClipVertex& v = triangle[corner];
+            v.x = p[0] * m[0] + p[1] * m[4] + p[2] * m[8] + m[12];
+            v.y = p[0] * m[1] + p[1] * m[5] + p[2] * m[9] + m[13];
+            v.z = p[0] * m[2] + p[1] * m[6] + p[2] * m[10] + m[14];
+            v.w = p[0] * m[3] + p[1] * m[7] + p[2] * m[11] + m[15];
+        }
+        DrawClipped(triangle, 3);
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void DepthRasterizer::DrawClipped(const ClipVertex* vertices, uint32_t count)
+{
+    // Near plane z >= 0 and the guard band; the screen bounds and the per
+    // pixel far test do the rest.
+    const float planes[5][4] =
+    {
+        { 0.0f, 0.0f, 1.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f, kGuardBand },
+        { -1.0f, 0.0f, 0.0f, kGuardBand },
+        { 0.0f, 1.0f, 0.0f, kGuardBand },
+        { 0.0f, -1.0f, 0.0f, kGuardBand },
+    };
+
+    ClipVertex buffers[2][3 + 5];
+    const ClipVertex* input = vertices;
+    uint32_t input_count = count;
+    for (int plane = 0; plane < 5 && input_count >= 3; ++plane)
+    {
+        const float* p = planes[plane];
+        auto distance = [p](const ClipVertex& v) { return p[0] * v.x + p[1] * v.y + p[2] * v.z + p[3] * v.w; };
+
+        ClipVertex* output = buffers[plane & 1];
+        uint32_t output_count = 0;
+        for (uint32_t i = 0; i < input_count; ++i)
+        {
+            const ClipVertex& a = input[i];
+            const ClipVertex& b = input[(i + 1) % input_count];
+            const float distance_a = distance(a);
+            const float distance_b = distance(b);
+            if (distance_a >= 0.0f) output[output_count++] = a;
+            if ((distance_a >= 0.0f) != (distance_b >= 0.0f))
+            {
+                const float t = distance_a / (distance_a - distance_b);
+                ClipVertex& v = output[output_count++];
+                v.x = a.x + (b.x - a.x) * t;
+                v.y = a.y + (b.y - a.y) * t;
+                v.z = a.z + (b.z - a.z) * t;
+                v.w = a.w + (b.w - a.w) * t;
+            }
+        }
+        input = output;
+        input_count = output_count;
+    }
+
+    for (uint32_t i = 2; i < input_count; ++i)
+    {
+        DrawTriangle(input[0], input[i - 1], input[i]);
+    }
+}
+
+void DepthRasterizer::DrawTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+    if (v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f) return;
+
+    // z / w is linear in screen space, so depth needs no perspective correction.
+    ScreenVertex s[3];
+    const ClipVertex* clip[3] = { &v0, &v1, &v2 };
+    for (int i = 0; i < 3; ++i)
+    {
+        const float inverse_w = 1.0f / clip[i]->w;
+        s[i].x = llroundf((clip[i]->x * inverse_w * 0.5f + 0.5f) * width_ * kSubPixelScale);
+        s[i].y = llroundf((0.5f - clip[i]->y * inverse_w * 0.5f) * height_ * kSubPixelScale);
+        s[i].z = clip[i]->z * inverse_w;
+    }
+
+    int64_t area = Edge(s[0], s[1], s[2].x, s[2].y);
+    if (area == 0) return;
+    if (area < 0)
+    {
+        swap(s[1], s[2]);
+        area = -area;
+    }
+
+    // Pixels whose centers may be inside.
+    const int64_t half = 1 << (kSubPixelBits - 1);
+    const int64_t min_x = min(min(s[0].x, s[1].x), s[2].x);
+    const int64_t max_x = max(max(s[0].x, s[1].x), s[2].x);
+    const int64_t min_y = min(min(s[0].y, s[1].y), s[2].y);
+    const int64_t max_y = max(max(s[0].y, s[1].y), s[2].y);
+    const int64_t x_begin = max<int64_t>((min_x - half + (1 << kSubPixelBits) - 1) >> kSubPixelBits, 0);
+    const int64_t x_end = min<int64_t>(((max_x - half) >> kSubPixelBits) + 1, width_);
+    const int64_t y_begin = max<int64_t>((min_y - half + (1 << kSubPixelBits) - 1) >> kSubPixelBits, 0);
+    const int64_t y_end = min<int64_t>(((max_y - half) >> kSubPixelBits) + 1, height_);
+    if (x_begin >= x_end || y_begin >= y_end) return;
+
+    // Edges that own the pixels on them keep 0, the others need > 0.
+    const int64_t bias[3] =
+    {
+        IsTopLeft(s[1], s[2]) ? 0 : -1,
+        IsTopLeft(s[2], s[0]) ? 0 : -1,
+        IsTopLeft(s[0], s[1]) ? 0 : -1,
+    };
+    const float inverse_area = 1.0f / static_cast<float>(area);
+    for (int64_t y = y_begin; y < y_end; ++y)
+    {
+        const int64_t center_y = (y << kSubPixelBits) + half;
+        float* row = depth_.data() + static_cast<size_t>(y) * width_;
+        for (int64_t x = x_begin; x < x_end; ++x)
+        {
+            const int64_t center_x = (x << kSubPixelBits) + half;
+            const int64_t w0 = Edge(s[1], s[2], center_x, center_y);
+            const int64_t w1 = Edge(s[2], s[0], center_x, center_y);
+            const int64_t w2 = Edge(s[0], s[1], center_x, center_y);
+            if (w0 + bias[0] < 0 || w1 + bias[1] < 0 || w2 + bias[2] < 0) continue;
+
+            const float depth = (w0 * s[0].z + w1 * s[1].z + w2 * s[2].z) * inverse_area;
+            if (depth < row[x] && depth <= 1.0f) row[x] = depth;
+        }
+    }
+}
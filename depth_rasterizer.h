@@ -0,0 +1,44 @@
+//--------------------------------------------------------------------------------
+//  depth_rasterizer.h
+//  Scalar CPU reference of the depth prepass: rasterizes indexed triangles
+//  into a float depth buffer with the D3D rules (clip space 0 <= z <= w,
+//  8 bit sub pixel snapping, pixel centers at +0.5, top-left fill rule,
+//  depth test LESS), so its output can feed HiZPyramid and be compared with
+//  the GPU.
+//  Both faces are drawn.  No D3D12 or DirectXMath dependency.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class DepthRasterizer
+{
+public:
+    void Resize(uint32_t width, uint32_t height);
+    void Clear(float depth = 1.0f);
+
+    //--------------------------------------------------------------------------------
+    //  positions       : x, y, z floats, vertex i at positions + i * stride bytes
+    //  world_view_proj : row vector convention, row major (XMFLOAT4X4 layout)
+    //--------------------------------------------------------------------------------
+    void DrawIndexed(const float* positions, size_t stride, const uint32_t* indices, size_t index_count,
+        const float world_view_proj[16]);
+
+    uint32_t Width() const { return width_; }
+    uint32_t Height() const { return height_; }
+    const float* Depth() const { return depth_.data(); }
+
+private:
+    struct ClipVertex
+    {
+        float x, y, z, w;
+    };
+
+    void DrawClipped(const ClipVertex* vertices, uint32_t count);
+    void DrawTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    std::vector<float> depth_;
+};
@@ -0,0 +1,148 @@
+//--------------------------------------------------------------------------------
+//  draw_batcher.cpp
+//--------------------------------------------------------------------------------
+#include "draw_batcher.h"
+#include <cassert>
+
+using namespace DirectX;
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+uint32_t DrawBatcher::RegisterSubmesh(const SubmeshRange& range)
+{
+    assert(submeshes_.size() < kMaxSubmeshes);
+    submeshes_.push_back(range);
+    return static_cast<uint32_t>(submeshes_.size() - 1);
+}
+
+uint64_t DrawBatcher::MakeKey(uint32_t pso, uint32_t material, uint32_t submesh, float depth01)
+{
+    assert(pso < kMaxPsos && material < kMaxMaterials && submesh < kMaxSubmeshes);
+    depth01 = depth01 < 0.0f ? 0.0f : (depth01 > 1.0f ? 1.0f : depth01);
+    const uint64_t depth = static_cast<uint64_t>(depth01 * 65535.0f);
+    return (static_cast<uint64_t>(pso) << 56)
+        | (static_cast<uint64_t>(material) << 40)
+        | (static_cast<uint64_t>(submesh) << 16)
+        | depth;
+}
+
+void DrawBatcher::Clear()
+{
+    keys_.clear();
+    packet_indices_.clear();
+    instances_.clear();
+    batches_.clear();
+    sorted_instances_.clear();
+}
+
+void DrawBatcher::Add(uint32_t pso, uint32_t material, uint32_t submesh, float depth01, const XMFLOAT4X4& world)
+{
+    assert(submesh < submeshes_.size());
+    keys_.push_back(MakeKey(pso, material, submesh, depth01));
+    packet_indices_.push_back(static_cast<uint32_t>(instances_.size()));
+
+    InstanceData instance;
+    instance.World = world;
+    instance.MaterialIndex = material;
+    instance.Pad[0] = instance.Pad[1] = instance.Pad[2] = 0;
+    instances_.push_back(instance);
+}
+
+void DrawBatcher::Build()
+{
+    batches_.clear();
+    sorted_instances_.clear();
+    if (keys_.empty()) return;
+
+    RadixSort(keys_, packet_indices_, temp_keys_, temp_indices_);
+
+    // Everything above the depth bits identifies the draw.
+    const size_t count = keys_.size();
+    sorted_instances_.resize(count);
+    size_t run_begin = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        sorted_instances_[i] = instances_[packet_indices_[i]];
+
+        const bool run_ends = (i + 1 == count) || ((keys_[i + 1] >> 16) != (keys_[i] >> 16));
+        if (!run_ends) continue;
+
+        const uint64_t key = keys_[i];
+        const SubmeshRange& range = submeshes_[KeySubmesh(key)];
+        DrawBatch batch;
+        batch.pso = KeyPso(key);
+        batch.material = KeyMaterial(key);
+        batch.mesh = range.mesh;
+        batch.submesh = KeySubmesh(key);
+        batch.args.IndexCountPerInstance = range.index_count;
+        batch.args.InstanceCount = static_cast<uint32_t>(i + 1 - run_begin);
+        batch.args.StartIndexLocation = range.start_index;
+        batch.args.BaseVertexLocation = range.base_vertex;
+        batch.args.StartInstanceLocation = static_cast<uint32_t>(run_begin);
+        batches_.push_back(batch);
+        run_begin = i + 1;
+    }
+}
+
+void DrawBatcher::RadixSort(vector<uint64_t>& keys, vector<uint32_t>& values,
+    vector<uint64_t>& temp_keys, vector<uint32_t>& temp_values)
+{
+    assert(keys.size() == values.size());
+    const size_t count = keys.size();
+    if (count == 0) return;
+    temp_keys.resize(count);
+    temp_values.resize(count);
+
+    // All 8 histograms in one read of the keys.
+    uint32_t histograms[8][256] = {};
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint64_t key = keys[i];
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            ++histograms[pass][(key >> (pass * 8)) & 0xff];
+        }
+    }
+
+    uint64_t* src_keys = keys.data();
+    uint32_t* src_values = values.data();
+    uint64_t* dst_keys = temp_keys.data();
+    uint32_t* dst_values = temp_values.data();
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        uint32_t* histogram = histograms[pass];
+        const int shift = pass * 8;
+
+        // Skip the pass when every key lands in the same bucket.
+        if (histogram[(src_keys[0] >> shift) & 0xff] == count) continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket)
+        {
+            const uint32_t bucket_count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_count;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t destination = histogram[(src_keys[i] >> shift) & 0xff]++;
+            dst_keys[destination] = src_keys[i];
+            dst_values[destination] = src_values[i];
+        }
+
+        swap(src_keys, dst_keys);
+        swap(src_values, dst_values);
+    }
+
+    // An odd number of passes leaves the result in the temp buffers.
+    if (src_keys != keys.data())
+    {
+        keys.swap(temp_keys);
+        values.swap(temp_values);
+    }
+}
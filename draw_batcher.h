@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------
+//  draw_batcher.h
+//  Sorts draw packets by a 64bit key and merges runs of the same submesh into
+//  instanced draws.  CPU only; see draw_submission.h for the D3D12 side.
+//
+//  Key layout (high to low bits)
+//    pso 8 | material 16 | submesh handle 24 | depth 16
+//  The depth is the lowest field, so packets with the same pso, material and
+//  submesh always end up adjacent regardless of their depth.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+//--------------------------------------------------------------------------------
+//  Same layout as D3D12_DRAW_INDEXED_ARGUMENTS
+//--------------------------------------------------------------------------------
+struct DrawIndexedArgs
+{
+    uint32_t IndexCountPerInstance;
+    uint32_t InstanceCount;
+    uint32_t StartIndexLocation;
+    int32_t  BaseVertexLocation;
+    uint32_t StartInstanceLocation;
+};
+
+//--------------------------------------------------------------------------------
+//  Index range of a submesh (SubmeshGeometry without the name lookup)
+//--------------------------------------------------------------------------------
+struct SubmeshRange
+{
+    uint32_t mesh = 0;
+    uint32_t index_count = 0;
+    uint32_t start_index = 0;
+    int32_t  base_vertex = 0;
+};
+
+//--------------------------------------------------------------------------------
+//  Per instance data read by the vertex shader through
+//  StructuredBuffer[instance base + SV_InstanceID]
+//--------------------------------------------------------------------------------
+struct InstanceData
+{
+    DirectX::XMFLOAT4X4 World;
+    uint32_t MaterialIndex;
+    uint32_t Pad[3];
+};
+
+//--------------------------------------------------------------------------------
+//  One merged draw
+//--------------------------------------------------------------------------------
+struct DrawBatch
+{
+    uint32_t pso;
+    uint32_t material;
+    uint32_t mesh;
+    uint32_t submesh;
+    DrawIndexedArgs args; // StartInstanceLocation is the first instance in instances()
+};
+
+class DrawBatcher
+{
+public:
+    static constexpr uint32_t kMaxPsos = 1u << 8;
+    static constexpr uint32_t kMaxMaterials = 1u << 16;
+    static constexpr uint32_t kMaxSubmeshes = 1u << 24;
+
+    //--------------------------------------------------------------------------------
+    //  Submesh handles are dense indices.  Register submeshes of the same mesh
+    //  together so that sorting by handle also groups vertex/index buffers.
+    //--------------------------------------------------------------------------------
+    uint32_t RegisterSubmesh(const SubmeshRange& range);
+    const SubmeshRange& Submesh(uint32_t handle) const { return submeshes_[handle]; }
+    uint32_t SubmeshCount() const { return static_cast<uint32_t>(submeshes_.size()); }
+
+    //--------------------------------------------------------------------------------
+    //  depth01 : view depth normalized to [0, 1] (front to back ordering)
+    //--------------------------------------------------------------------------------
+    static uint64_t MakeKey(uint32_t pso, uint32_t material, uint32_t submesh, float depth01);
+    static uint32_t KeyPso(uint64_t key) { return static_cast<uint32_t>(key >> 56); }
+    static uint32_t KeyMaterial(uint64_t key) { return static_cast<uint32_t>(key >> 40) & 0xffff; }
+    static uint32_t KeySubmesh(uint64_t key) { return static_cast<uint32_t>(key >> 16) & 0xffffff; }
+
+    //--------------------------------------------------------------------------------
+    //  Per frame
+    //--------------------------------------------------------------------------------
+    void Clear();
+    void Add(uint32_t pso, uint32_t material, uint32_t submesh, float depth01, const DirectX::XMFLOAT4X4& world);
+    void Build();
+
+    size_t PacketCount() const { return keys_.size(); }
+    const std::vector<DrawBatch>&    Batches() const { return batches_; }
+    const std::vector<InstanceData>& Instances() const { return sorted_instances_; }
+
+    //--------------------------------------------------------------------------------
+    //  LSD radix sort of keys with a 32bit payload, 8 bits per pass.
+    //  Passes where every key has the same byte are skipped.
+    //  temp_keys/temp_values are resized as needed and can be reused.
+    //--------------------------------------------------------------------------------
+    static void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+        std::vector<uint64_t>& temp_keys, std::vector<uint32_t>& temp_values);
+
+private:
+    std::vector<SubmeshRange> submeshes_;
+
+    std::vector<uint64_t>     keys_;
+    std::vector<uint32_t>     packet_indices_;
+    std::vector<InstanceData> instances_;
+
+    std::vector<uint64_t>     temp_keys_;
+    std::vector<uint32_t>     temp_indices_;
+
+    std::vector<DrawBatch>    batches_;
+    std::vector<InstanceData> sorted_instances_;
+};
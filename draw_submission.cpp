@@ -0,0 +1,133 @@
+//--------------------------------------------------------------------------------
+//  draw_submission.cpp
+//--------------------------------------------------------------------------------
+#include "draw_submission.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+DrawSubmission::~DrawSubmission()
+{
+    // The owner flushed the GPU before destroying us.
+    for (InstanceBuffer& buffer : instance_buffers_)
+    {
+        if (buffer.resource && buffer.mapped) buffer.resource->Unmap(0, nullptr);
+    }
+}
+
+uint32_t DrawSubmission::RegisterMesh(MeshGeometry* geometry, DrawBatcher& batcher,
+    unordered_map<string, uint32_t>* submesh_handles, LodSelector* lod_selector)
+{
+    const uint32_t mesh_index = static_cast<uint32_t>(meshes_.size());
+    meshes_.push_back(geometry);
+
+    for (auto& pair : geometry->DrawArgs)
+    {
+        SubmeshRange range;
+        range.mesh = mesh_index;
+        range.index_count = pair.second.IndexCount;
+        range.start_index = pair.second.StartIndexLocation;
+        range.base_vertex = pair.second.BaseVertexLocation;
+        LodRange lods[LodSelector::kMaxLods];
+        const uint32_t lod_count = static_cast<uint32_t>(MathHelper::Min<size_t>(pair.second.Lods.size(), LodSelector::kMaxLods));
+        for (uint32_t lod = 0; lod < lod_count; ++lod)
+        {
+            const SubmeshLod& source = pair.second.Lods[lod];
+            lods[lod] = { source.IndexCount, source.StartIndexLocation, source.Error };
+        }
+        const uint32_t handle = LodSelector::RegisterSubmesh(batcher, range, lods, lod_count, lod_selector);
+        if (submesh_handles) (*submesh_handles)[pair.first] = handle;
+    }
+    return mesh_index;
+}
+
+void DrawSubmission::BeginFrame(UINT frame_slot, UINT64 completed_fence, UINT64 frame_fence)
+{
+    assert(frame_slot < kFrameCount);
+    frame_slot_ = frame_slot;
+    frame_fence_ = frame_fence;
+
+    retired_buffers_.erase(remove_if(retired_buffers_.begin(), retired_buffers_.end(),
+        [completed_fence](const RetiredBuffer& retired) { return retired.fence <= completed_fence; }),
+        retired_buffers_.end());
+}
+
+void DrawSubmission::Record(ID3D12Device* device, ID3D12GraphicsCommandList* command_list,
+    const DrawBatcher& batcher, ID3D12PipelineState* const* psos,
+    UINT instance_base_param, UINT instance_buffer_param)
+{
+    const auto& batches = batcher.Batches();
+    const auto& instances = batcher.Instances();
+    if (batches.empty()) return;
+
+    // The buffer of this slot was last read kFrameCount frames ago, which
+    // the caller waited for before recording.
+    InstanceBuffer& buffer = instance_buffers_[frame_slot_];
+    ReserveInstanceBuffer(device, buffer, instances.size());
+    memcpy(buffer.mapped, instances.data(), instances.size() * sizeof(InstanceData));
+    buffer.fence = frame_fence_;
+    command_list->SetGraphicsRootShaderResourceView(instance_buffer_param, buffer.resource->GetGPUVirtualAddress());
+
+    uint32_t current_pso = UINT32_MAX;
+    uint32_t current_mesh = UINT32_MAX;
+    for (const DrawBatch& batch : batches)
+    {
+        if (batch.pso != current_pso)
+        {
+            command_list->SetPipelineState(psos[batch.pso]);
+            current_pso = batch.pso;
+        }
+        if (batch.mesh != current_mesh)
+        {
+            const MeshGeometry* geometry = meshes_[batch.mesh];
+            command_list->IASetVertexBuffers(0, 1, &geometry->VertexBufferView());
+            command_list->IASetIndexBuffer(&geometry->IndexBufferView());
+            command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            current_mesh = batch.mesh;
+        }
+
+        // SV_InstanceID does not include StartInstanceLocation, so pass it explicitly.
+        command_list->SetGraphicsRoot32BitConstant(instance_base_param, batch.args.StartInstanceLocation, 0);
+        command_list->DrawIndexedInstanced(
+            batch.args.IndexCountPerInstance,
+            batch.args.InstanceCount,
+            batch.args.StartIndexLocation,
+            batch.args.BaseVertexLocation,
+            batch.args.StartInstanceLocation);
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void DrawSubmission::ReserveInstanceBuffer(ID3D12Device* device, InstanceBuffer& buffer, size_t instance_count)
+{
+    if (instance_count <= buffer.capacity) return;
+
+    // A frame still in flight may read the old buffer; keep it until its fence.
+    if (buffer.resource)
+    {
+        if (buffer.mapped) buffer.resource->Unmap(0, nullptr);
+        retired_buffers_.push_back({ move(buffer.resource), buffer.fence });
+        buffer.mapped = nullptr;
+    }
+
+    // Grow geometrically so a slowly increasing scene does not reallocate every frame.
+    buffer.capacity = MathHelper::Max(instance_count, buffer.capacity * 2);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(buffer.capacity * sizeof(InstanceData)),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(buffer.resource.GetAddressOf())));
+    ThrowIfFailed(buffer.resource->Map(0, nullptr, reinterpret_cast<void**>(&buffer.mapped)));
+}
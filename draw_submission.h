@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------
+//  draw_submission.h
+//  Records the batches built by DrawBatcher into a command list.
+//  Submesh names are resolved to dense handles once, when a mesh is registered.
+//  Instance data goes to one upload buffer per frame in flight; a buffer
+//  replaced by a larger one is kept until the GPU passed its last frame.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+#include "draw_batcher.h"
+#include "lod_selector.h"
+
+class DrawSubmission
+{
+public:
+    static constexpr UINT kFrameCount = 2;     // frames in flight, as RenderSystem
+
+    DrawSubmission() = default;
+    ~DrawSubmission();
+
+    //--------------------------------------------------------------------------------
+    //  Register every DrawArgs entry of geometry with the batcher.  The LODs of
+    //  a submesh follow its base range (LOD n is base handle + n).
+    //  submesh_handles (optional) receives name -> base submesh handle.
+    //  lod_selector (optional) receives the LOD errors of every submesh.
+    //  Returns the mesh index.
+    //--------------------------------------------------------------------------------
+    uint32_t RegisterMesh(MeshGeometry* geometry, DrawBatcher& batcher,
+        std::unordered_map<std::string, uint32_t>* submesh_handles = nullptr,
+        LodSelector* lod_selector = nullptr);
+
+    //--------------------------------------------------------------------------------
+    //  Before Record, once per frame.  frame_slot : frame in flight being
+    //  recorded (< kFrameCount), completed_fence : last fence value the GPU
+    //  passed, frame_fence : value the frame will signal.
+    //--------------------------------------------------------------------------------
+    void BeginFrame(UINT frame_slot, UINT64 completed_fence, UINT64 frame_fence);
+
+    //--------------------------------------------------------------------------------
+    //  Upload the sorted instance data and record one DrawIndexedInstanced per batch.
+    //  psos                  : table indexed by the pso field of the draw key
+    //  instance_base_param   : root parameter of a 32bit constant (first instance)
+    //  instance_buffer_param : root parameter of the instance data SRV
+    //--------------------------------------------------------------------------------
+    void Record(ID3D12Device* device, ID3D12GraphicsCommandList* command_list,
+        const DrawBatcher& batcher, ID3D12PipelineState* const* psos,
+        UINT instance_base_param, UINT instance_buffer_param);
+
+    const MeshGeometry* Mesh(uint32_t mesh_index) const { return meshes_[mesh_index]; }
+
+private:
+    DrawSubmission(const DrawSubmission& rhs) = delete;
+    DrawSubmission& operator=(const DrawSubmission& rhs) = delete;
+
+    struct InstanceBuffer
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;    // persistently mapped
+        InstanceData* mapped = nullptr;
+        size_t capacity = 0;
+        UINT64 fence = 0;       // last frame that read it
+    };
+
+    struct RetiredBuffer
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        UINT64 fence = 0;       // released once the GPU passed this value
+    };
+
+    void ReserveInstanceBuffer(ID3D12Device* device, InstanceBuffer& buffer, size_t instance_count);
+
+    std::vector<MeshGeometry*> meshes_;
+
+    InstanceBuffer instance_buffers_[kFrameCount];
+    std::vector<RetiredBuffer> retired_buffers_;
+    UINT frame_slot_ = 0;
+    UINT64 frame_fence_ = 0;
+};
@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------
+//  dynamic_resolution.cpp
+//--------------------------------------------------------------------------------
+#include "dynamic_resolution.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+DynamicResolutionController::DynamicResolutionController(const DynamicResolutionSettings& settings)
+    : settings_(settings)
+{
+    assert(settings_.target_ms > 0.0f);
+    assert(settings_.scale_step > 0.0f);
+    assert(settings_.min_scale > 0.0f && settings_.min_scale <= settings_.max_scale);
+    assert(settings_.increase_threshold < settings_.decrease_threshold);
+    Reset();
+}
+
+float DynamicResolutionController::Update(float gpu_ms)
+{
+    if (settle_ > 0)
+    {
+        --settle_;
+        return scale_;
+    }
+
+    if (has_sample_)
+    {
+        const float sample = min(gpu_ms, filtered_ms_ * settings_.spike_ratio);
+        filtered_ms_ += settings_.smoothing * (sample - filtered_ms_);
+    }
+    else
+    {
+        filtered_ms_ = gpu_ms;
+    }
+    has_sample_ = true;
+    const float ratio = filtered_ms_ / settings_.target_ms;
+
+    if (ratio > settings_.decrease_threshold)
+    {
+        // Cost follows the pixel count: scale by sqrt(target / time), at least one step.
+        float scale = Quantize(scale_ * sqrtf(settings_.target_ms / filtered_ms_));
+        scale = min(scale, Quantize(scale_ - settings_.scale_step));
+        SetScale(max(scale, settings_.min_scale));
+        return scale_;
+    }
+
+    if (ratio >= settings_.increase_threshold || scale_ >= settings_.max_scale)
+    {
+        frames_under_ = 0;
+        return scale_;
+    }
+
+    if (++frames_under_ >= settings_.increase_frames)
+    {
+        const float scale = min(Quantize(scale_ + settings_.scale_step), settings_.max_scale);
+        const float growth = scale / scale_;
+        if (filtered_ms_ * growth * growth <= settings_.target_ms * settings_.decrease_threshold)
+        {
+            SetScale(scale);
+        }
+        else
+        {
+            frames_under_ = 0;
+        }
+    }
+    return scale_;
+}
+
+void DynamicResolutionController::Reset()
+{
+    scale_ = settings_.max_scale;
+    filtered_ms_ = 0.0f;
+    has_sample_ = false;
+    frames_under_ = 0;
+    settle_ = 0;
+}
+
+void DynamicResolutionController::RenderSize(uint32_t output_width, uint32_t output_height, float scale,
+    uint32_t* width, uint32_t* height)
+{
+    *width = max(1u, static_cast<uint32_t>(output_width * scale + 0.5f));
+    *height = max(1u, static_cast<uint32_t>(output_height * scale + 0.5f));
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void DynamicResolutionController::SetScale(float scale)
+{
+    if (scale == scale_) return;
+
+    // Carry the filtered time over at the new pixel count rather than
+    // restarting from the first sample, which would then not be clamped.
+    const float growth = scale / scale_;
+    filtered_ms_ *= growth * growth;
+    scale_ = scale;
+    frames_under_ = 0;
+    settle_ = settings_.settle_frames;
+}
+
+float DynamicResolutionController::Quantize(float scale) const
+{
+    // Round down to a multiple of the step; the bias absorbs float error so
+    // that a multiple maps to itself.
+    return floorf(scale / settings_.scale_step + 1e-3f) * settings_.scale_step;
+}
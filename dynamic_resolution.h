@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------
+//  dynamic_resolution.h
+//  Picks the fraction of the output size the scene is rendered at from the
+//  measured GPU frame time (CPU only, no clock: the same trace of times
+//  always gives the same scales).
+//  - Times are smoothed, and a sample counts as at most spike_ratio times the
+//    filtered time, so one off hitches (shader compiles, uploads) do not
+//    lower the resolution.
+//  - A filtered time over budget lowers the scale right away, by the amount
+//    that brings the frame back into budget assuming the cost follows the
+//    pixel count (scale squared).
+//  - The scale is raised one step at a time, and only after increase_frames
+//    consecutive frames well under budget (increase_threshold) whose
+//    predicted cost at the new scale still fits.  The gap between the two
+//    thresholds is the hysteresis that keeps it from oscillating.
+//  - After a change the next settle_frames samples are dropped: they were
+//    measured on frames already in flight at the old scale.  The filtered
+//    time is rescaled to the new pixel count, so the samples after that are
+//    smoothed and clamped like any other.
+//  - The scale is a multiple of scale_step, so render targets only take a
+//    handful of sizes.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+
+struct DynamicResolutionSettings
+{
+    float    target_ms = 16.0f;             // GPU budget per frame
+    float    min_scale = 0.5f;
+    float    max_scale = 1.0f;
+    float    scale_step = 0.05f;
+    float    decrease_threshold = 1.0f;     // filtered time / target above which the scale drops
+    float    increase_threshold = 0.85f;    // filtered time / target below which a frame counts toward a raise
+    uint32_t increase_frames = 30;
+    uint32_t settle_frames = 3;             // >= frames in flight
+    float    smoothing = 0.2f;              // weight of a new sample in the filtered time
+    float    spike_ratio = 1.5f;            // a sample counts as at most this times the filtered time
+};
+
+class DynamicResolutionController
+{
+public:
+    explicit DynamicResolutionController(const DynamicResolutionSettings& settings = DynamicResolutionSettings());
+
+    //--------------------------------------------------------------------------------
+    //  Feeds the GPU time of a completed frame, returns the scale to render
+    //  the next frame at.
+    //--------------------------------------------------------------------------------
+    float Update(float gpu_ms);
+
+    //--------------------------------------------------------------------------------
+    //  Back to max_scale with no history (output resized, settings changed)
+    //--------------------------------------------------------------------------------
+    void Reset();
+
+    float Scale() const { return scale_; }
+    float FilteredMs() const { return filtered_ms_; }
+    const DynamicResolutionSettings& Settings() const { return settings_; }
+
+    //--------------------------------------------------------------------------------
+    //  Render size of an output_width x output_height output at scale, at
+    //  least 1 x 1
+    //--------------------------------------------------------------------------------
+    static void RenderSize(uint32_t output_width, uint32_t output_height, float scale,
+        uint32_t* width, uint32_t* height);
+
+private:
+    void SetScale(float scale);
+    float Quantize(float scale) const;
+
+    DynamicResolutionSettings settings_;
+    float    scale_ = 1.0f;
+    float    filtered_ms_ = 0.0f;
+    bool     has_sample_ = false;
+    uint32_t frames_under_ = 0;
+    uint32_t settle_ = 0;
+};
@@ -0,0 +1,196 @@
+//--------------------------------------------------------------------------------
+//  frame_allocator.cpp
+//--------------------------------------------------------------------------------
+#include "frame_allocator.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+FrameAllocator* FrameAllocator::instance_ = nullptr;
+
+namespace
+{
+#if FRAME_ALLOCATOR_DEBUG
+    constexpr uint8_t kReleasedFill = 0xdd;
+    constexpr uint8_t kGuardFill = 0xfd;
+    constexpr size_t kGuardSize = 8;
+#else
+    constexpr size_t kGuardSize = 0;
+#endif
+
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  LinearArena
+//
+//--------------------------------------------------------------------------------
+LinearArena::~LinearArena()
+{
+    CheckGuards();
+}
+
+void LinearArena::Initialize(size_t capacity)
+{
+    memory_.reset(capacity ? new uint8_t[capacity] : nullptr);
+    capacity_ = capacity;
+    offset_ = 0;
+    overflow_bytes_ = 0;
+    high_water_ = 0;
+    overflow_blocks_.clear();
+#if FRAME_ALLOCATOR_DEBUG
+    guards_.clear();
+    if (capacity) memset(memory_.get(), kReleasedFill, capacity);
+#endif
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory_.get());
+    const size_t begin = AlignUp(base + offset_, alignment) - base;
+    const size_t end = begin + size + kGuardSize;
+    if (!memory_ || end > capacity_) return AllocateOverflow(size, alignment);
+
+    offset_ = end;
+    high_water_ = max(high_water_, offset_ + overflow_bytes_);
+    uint8_t* result = memory_.get() + begin;
+#if FRAME_ALLOCATOR_DEBUG
+    memset(result + size, kGuardFill, kGuardSize);
+    guards_.push_back({ result + size });
+#endif
+    return result;
+}
+
+void LinearArena::Reset()
+{
+    CheckGuards();
+#if FRAME_ALLOCATOR_DEBUG
+    if (memory_) memset(memory_.get(), kReleasedFill, offset_);
+    guards_.clear();
+#endif
+    offset_ = 0;
+    overflow_bytes_ = 0;
+    overflow_blocks_.clear();
+    ++generation_;
+}
+
+//--------------------------------------------------------------------------------
+//  Out of capacity: serve from the heap until the next Reset
+//--------------------------------------------------------------------------------
+void* LinearArena::AllocateOverflow(size_t size, size_t alignment)
+{
+    const size_t block_size = size + alignment + kGuardSize;
+    overflow_blocks_.emplace_back(new uint8_t[block_size]);
+    overflow_bytes_ += block_size;
+    high_water_ = max(high_water_, offset_ + overflow_bytes_);
+
+    const uintptr_t address = reinterpret_cast<uintptr_t>(overflow_blocks_.back().get());
+    uint8_t* result = reinterpret_cast<uint8_t*>(AlignUp(address, alignment));
+#if FRAME_ALLOCATOR_DEBUG
+    memset(result + size, kGuardFill, kGuardSize);
+    guards_.push_back({ result + size });
+#endif
+    return result;
+}
+
+void LinearArena::CheckGuards() const
+{
+#if FRAME_ALLOCATOR_DEBUG
+    for (const Guard& guard : guards_)
+    {
+        for (size_t i = 0; i < kGuardSize; ++i)
+        {
+            assert(guard.address[i] == kGuardFill && "LinearArena allocation overflowed");
+        }
+    }
+#endif
+}
+
+//--------------------------------------------------------------------------------
+//
+//  FrameAllocator
+//
+//--------------------------------------------------------------------------------
+FrameAllocator* FrameAllocator::Create()
+{
+    if (instance_) return instance_;
+    instance_ = new FrameAllocator;
+    return instance_;
+}
+
+void FrameAllocator::Initialize(size_t scratch_capacity, size_t two_frame_capacity)
+{
+    worker_count_ = JobSystem::IsCreated() ? JobSystem::Instance().WorkerCount() : 1;
+    workers_.reset(new WorkerArenas[worker_count_]);
+    for (uint32_t i = 0; i < worker_count_; ++i)
+    {
+        workers_[i].scratch.Initialize(scratch_capacity);
+        workers_[i].two_frame.Initialize(two_frame_capacity);
+    }
+}
+
+void FrameAllocator::Release()
+{
+    assert(instance_ != nullptr);
+    instance_ = nullptr;
+    delete this;
+}
+
+LinearArena& FrameAllocator::Scratch()
+{
+    return workers_[WorkerIndex()].scratch;
+}
+
+LinearArena& FrameAllocator::TwoFrame()
+{
+    return workers_[WorkerIndex()].two_frame.Current();
+}
+
+void FrameAllocator::EndFrame()
+{
+    for (uint32_t i = 0; i < worker_count_; ++i)
+    {
+        workers_[i].scratch.Reset();
+        workers_[i].two_frame.Flip();
+    }
+}
+
+bool FrameAllocator::HasArenas() const
+{
+    const uint32_t worker_index = JobSystem::IsCreated() ? JobSystem::CurrentWorker() : 0;
+    return worker_index < worker_count_;
+}
+
+size_t FrameAllocator::ScratchHighWater() const
+{
+    size_t high_water = 0;
+    for (uint32_t i = 0; i < worker_count_; ++i) high_water = max(high_water, workers_[i].scratch.HighWater());
+    return high_water;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+uint32_t FrameAllocator::WorkerIndex() const
+{
+    // Arenas are not thread safe; threads outside the JobSystem have none.
+    // Fail in release builds too rather than index past workers_.
+    const uint32_t worker_index = JobSystem::IsCreated() ? JobSystem::CurrentWorker() : 0;
+    if (worker_index >= worker_count_)
+    {
+        fputs("FrameAllocator used from a thread that is not a JobSystem worker\n", stderr);
+        abort();
+    }
+    return worker_index;
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+//--------------------------------------------------------------------------------
+//  frame_allocator.h
+//  Allocators for transient CPU data.
+//  - LinearArena         : bump allocator, everything freed at once by Reset
+//  - DoubleBufferedArena : two arenas flipped per frame, so data lives for the
+//                          frame it was allocated in and the next one
+//  - ArenaAllocator<T>   : STL allocator over a LinearArena
+//  - FrameAllocator      : one scratch and one double buffered arena per
+//                          JobSystem worker, reset in EndFrame
+//  When an arena runs out it falls back to heap blocks freed by Reset, so the
+//  capacity should be sized from HighWater().
+//  Debug builds (no NDEBUG) put guard bytes after every allocation, check
+//  them on Reset, fill released memory with 0xdd and assert when an
+//  ArenaAllocator is used after its arena was reset.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef NDEBUG
+#define FRAME_ALLOCATOR_DEBUG 1
+#else
+#define FRAME_ALLOCATOR_DEBUG 0
+#endif
+
+class LinearArena
+{
+public:
+    LinearArena() = default;
+    explicit LinearArena(size_t capacity) { Initialize(capacity); }
+    ~LinearArena();
+
+    void Initialize(size_t capacity);
+
+    //--------------------------------------------------------------------------------
+    //  alignment must be a power of 2.  Never returns nullptr.
+    //--------------------------------------------------------------------------------
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <class T>
+    T* AllocateArray(size_t count) { return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T))); }
+
+    //--------------------------------------------------------------------------------
+    //  Release every allocation.  Objects are not destroyed.
+    //--------------------------------------------------------------------------------
+    void Reset();
+
+    size_t   Used() const { return offset_; }
+    size_t   Capacity() const { return capacity_; }
+    size_t   HighWater() const { return high_water_; }      // including overflow
+    uint32_t Generation() const { return generation_; }     // incremented by Reset
+
+private:
+    LinearArena(const LinearArena& rhs) = delete;
+    LinearArena& operator=(const LinearArena& rhs) = delete;
+
+    void* AllocateOverflow(size_t size, size_t alignment);
+    void  CheckGuards() const;
+
+    std::unique_ptr<uint8_t[]> memory_;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    size_t overflow_bytes_ = 0;
+    size_t high_water_ = 0;
+    uint32_t generation_ = 0;
+    std::vector<std::unique_ptr<uint8_t[]>> overflow_blocks_;
+
+#if FRAME_ALLOCATOR_DEBUG
+    struct Guard
+    {
+        const uint8_t* address;
+    };
+    std::vector<Guard> guards_;
+#endif
+};
+
+//--------------------------------------------------------------------------------
+//  Data allocated in frame N stays valid until the Flip at the end of frame N+1
+//--------------------------------------------------------------------------------
+class DoubleBufferedArena
+{
+public:
+    void Initialize(size_t capacity)
+    {
+        arenas_[0].Initialize(capacity);
+        arenas_[1].Initialize(capacity);
+    }
+
+    LinearArena& Current() { return arenas_[current_]; }
+
+    //--------------------------------------------------------------------------------
+    //  Switch to the other arena and release what it held (two frames old)
+    //--------------------------------------------------------------------------------
+    void Flip()
+    {
+        current_ ^= 1;
+        arenas_[current_].Reset();
+    }
+
+private:
+    LinearArena arenas_[2];
+    uint32_t current_ = 0;
+};
+
+//--------------------------------------------------------------------------------
+//  STL allocator.  deallocate is a no-op; memory comes back on Reset.
+//--------------------------------------------------------------------------------
+template <class T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena)
+        : arena_(&arena)
+#if FRAME_ALLOCATOR_DEBUG
+        , generation_(arena.Generation())
+#endif
+    {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& rhs)
+        : arena_(rhs.arena_)
+#if FRAME_ALLOCATOR_DEBUG
+        , generation_(rhs.generation_)
+#endif
+    {}
+
+    T* allocate(size_t count)
+    {
+        assert(generation_ == arena_->Generation() && "ArenaAllocator used after its arena was reset");
+        return arena_->AllocateArray<T>(count);
+    }
+
+    void deallocate(T*, size_t)
+    {
+        assert(generation_ == arena_->Generation() && "ArenaAllocator used after its arena was reset");
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& rhs) const { return arena_ == rhs.arena_; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const { return arena_ != rhs.arena_; }
+
+private:
+    template <class U> friend class ArenaAllocator;
+
+    LinearArena* arena_;
+#if FRAME_ALLOCATOR_DEBUG
+    uint32_t generation_;
+#endif
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+using ArenaWString = std::basic_string<wchar_t, std::char_traits<wchar_t>, ArenaAllocator<wchar_t>>;
+
+//--------------------------------------------------------------------------------
+//  Per worker frame arenas
+//--------------------------------------------------------------------------------
+class FrameAllocator
+{
+public:
+    static FrameAllocator* Create();
+    static FrameAllocator& Instance() { return *instance_; }
+    static bool IsCreated() { return instance_ != nullptr; }
+
+    //--------------------------------------------------------------------------------
+    //  One set of arenas per JobSystem worker (one set when there is no JobSystem)
+    //--------------------------------------------------------------------------------
+    void Initialize(size_t scratch_capacity, size_t two_frame_capacity);
+    void Release();
+
+    //--------------------------------------------------------------------------------
+    //  Arenas of the calling worker.  Scratch is reset at the end of the
+    //  frame, TwoFrame at the end of the next one.
+    //--------------------------------------------------------------------------------
+    LinearArena& Scratch();
+    LinearArena& TwoFrame();
+
+    //--------------------------------------------------------------------------------
+    //  Whether the calling thread has arenas.  Scratch and TwoFrame abort on
+    //  threads that have none (threads outside the JobSystem).
+    //--------------------------------------------------------------------------------
+    bool HasArenas() const;
+
+    template <class T>
+    ArenaAllocator<T> ScratchAllocator() { return ArenaAllocator<T>(Scratch()); }
+
+    //--------------------------------------------------------------------------------
+    //  Main thread, once per frame, while no job is running
+    //--------------------------------------------------------------------------------
+    void EndFrame();
+
+    size_t ScratchHighWater() const;
+
+private:
+    FrameAllocator() = default;
+    ~FrameAllocator() = default;
+    FrameAllocator(const FrameAllocator& rhs) = delete;
+    FrameAllocator& operator=(const FrameAllocator& rhs) = delete;
+
+    uint32_t WorkerIndex() const;
+
+    struct WorkerArenas
+    {
+        LinearArena scratch;
+        DoubleBufferedArena two_frame;
+    };
+    std::unique_ptr<WorkerArenas[]> workers_;
+    uint32_t worker_count_ = 0;
+
+    static FrameAllocator* instance_;
+};
@@ -5,8 +5,11 @@
 #include <cassert>
 #include <windowsx.h>
 #include "game_system.h"
+#include "frame_allocator.h"
 #include "game_timer.h"
+#include "job_system.h"
 #include "render_system.h"
+#include "render_thread.h"
 
 LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
@@ -35,8 +38,18 @@ GameSystem::GameSystem(HINSTANCE app_instance_handle_)
 //--------------------------------------------------------------------------------
 GameSystem::~GameSystem()
 {
-    render_system_->Release();
+    if (render_thread_) render_thread_->Release();
+    if (render_system_) render_system_->Release();
     game_timer_->Release();
+    if (frame_allocator_) frame_allocator_->Release();
+    if (job_system_) job_system_->Release();
+
+    // Normally the message thread has already ended in Run.
+    if (message_thread_.joinable())
+    {
+        PostMessage(main_window_handle_, kDestroyWindowMessage, 0, 0);
+        message_thread_.join();
+    }
 }
 
 //--------------------------------------------------------------------------------
@@ -44,7 +57,22 @@ GameSystem::~GameSystem()
 //--------------------------------------------------------------------------------
 bool GameSystem::Initialize()
 {
-    if (InitWindow() == false) return false;
+    // The window is created by the thread that pumps its messages, so modal
+    // move / size loops never stall frame production.
+    std::promise<bool> window_created;
+    std::future<bool> window_result = window_created.get_future();
+    message_thread_ = std::thread([this, promise = std::move(window_created)]() mutable { MessageLoop(&promise); });
+    if (window_result.get() == false)
+    {
+        message_thread_.join();
+        return false;
+    }
+
+    job_system_ = JobSystem::Create();
+    job_system_->Initialize();
+
+    frame_allocator_ = FrameAllocator::Create();
+    frame_allocator_->Initialize(kFrameScratchCapacity, kFrameScratchCapacity);
 
     game_timer_ = GameTimer::Create();
     game_timer_->Initialize(main_window_handle_);
@@ -52,6 +80,10 @@ bool GameSystem::Initialize()
 
     render_system_ = RenderSystem::Create();
     if (render_system_->Initialize() == false) return false;
+
+    // From here on RenderSystem is driven by the render thread only.
+    render_thread_ = RenderThread::Create();
+    render_thread_->Initialize(render_system_);
     
     return true;
 }
@@ -61,41 +93,59 @@ bool GameSystem::Initialize()
 //--------------------------------------------------------------------------------
 int GameSystem::Run()
 {
-    MSG msg;
+    int exit_code = 0;
+    bool running = true;
 
-    // bZ[W[v
-    while (1)
+    while (running)
     {
-        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE) != 0)	// bZ[W擾Ȃꍇ"0"Ԃ
-        {// Windows̏
-            if (msg.message == WM_QUIT)
-            {// PostQuitMessage()Ă΂āAWM_QUITbZ[W烋[vI
-                break;
+        // Window events posted by the message thread since the last frame.
+        window_events_.Drain([this, &running, &exit_code](const WindowEvent& event)
+        {
+            if (event.type == WindowEventType::kQuit)
+            {
+                running = false;
+                exit_code = static_cast<int>(event.code);
             }
-            else
+            else if (event.type == WindowEventType::kClose)
             {
-                // bZ[W̖|Ƒo
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
+                Close();
             }
-        }
-        else
-        {
-            GameTimer& game_timer = GameTimer::Instance();
-            game_timer.Tick();
-
-            if (game_timer.CanUpdateFrame())
+            else if (running)
             {
-                Update();
-                Render();
+                HandleWindowEvent(event);
             }
+        });
+        if (!running) break;
+
+        // Closing: no more frames, wait for WM_QUIT from the message thread.
+        if (render_thread_ == nullptr)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // At most one resize per frame, none while the borders are dragged.
+        uint32_t width, height;
+        if (resize_coalescer_.Consume(width, height)) render_thread_->PostResize(width, height);
+
+        GameTimer& game_timer = GameTimer::Instance();
+        game_timer.Tick();
+
+        if (game_timer.CanUpdateFrame())
+        {
+            job_system_->RunMainThreadJobs();
+            Update();
+            Render();
+            frame_allocator_->EndFrame();
         }
     }
 
+    message_thread_.join();
+
     // EBhENX̓o^
     UnregisterClass(class_name_.c_str(), app_instance_handle_);
 
-    return (int)msg.wParam;
+    return exit_code;
 }
 
 //--------------------------------------------------------------------------------
@@ -153,99 +203,99 @@ bool GameSystem::InitWindow()
     return true;
 }
 
+//--------------------------------------------------------------------------------
+//  Message thread
+//--------------------------------------------------------------------------------
+void GameSystem::MessageLoop(std::promise<bool>* window_created)
+{
+    const bool succeeded = InitWindow();
+    window_created->set_value(succeeded);
+    if (!succeeded) return;
+
+    MSG msg = {};
+    while (1)
+    {
+        // Events that did not fit in the queue are retried every millisecond
+        // rather than waiting on the frame thread.
+        if (window_events_.HasBacklog()
+            && MsgWaitForMultipleObjects(0, nullptr, FALSE, 1, QS_ALLINPUT) == WAIT_TIMEOUT)
+        {
+            window_events_.FlushBacklog();
+            continue;
+        }
+
+        // WM_QUIT : 0, error : -1
+        if (GetMessage(&msg, nullptr, 0, 0) <= 0) break;
+
+        // bZ[W̖|Ƒo
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    WindowEvent quit;
+    quit.type = WindowEventType::kQuit;
+    quit.code = static_cast<uint32_t>(msg.wParam);
+    window_events_.Post(quit);
+    while (window_events_.HasBacklog())
+    {
+        std::this_thread::yield();
+        window_events_.FlushBacklog();
+    }
+}
+
 //--------------------------------------------------------------------------------
 //  Window Message
 //--------------------------------------------------------------------------------
 LRESULT GameSystem::MsgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
+    // Runs on the message thread.  Everything the frame thread has to know
+    // is posted to window_events_ and handled in HandleWindowEvent.
+    WindowEvent event;
     switch (msg)
     {
         // WM_ACTIVATE is sent when the window is activated or deactivated.  
         // We pause the game when the window is deactivated and unpause it 
         // when it becomes active.  
     case WM_ACTIVATE:
-        if (LOWORD(wparam) == WA_INACTIVE)
-        {
-            paused_ = true;
-            if (game_timer_) game_timer_->SetTimeScale(0.0f);
-        }
-        else
-        {
-            paused_ = false;
-            if (game_timer_) game_timer_->SetTimeScale(1.0f);
-        }
+        event.type = LOWORD(wparam) == WA_INACTIVE ? WindowEventType::kDeactivate : WindowEventType::kActivate;
+        window_events_.Post(event);
         return 0;
 
         // WM_SIZE is sent when the user resizes the window.  
     case WM_SIZE:
-        // Save the new client area dimensions.
-        width_ = LOWORD(lparam);
-        height_ = HIWORD(lparam);
-        if (render_system_)
-        {
-            if (wparam == SIZE_MINIMIZED)
-            {
-                paused_ = true;
-                minimized_ = true;
-                maximized_ = false;
-            }
-            else if (wparam == SIZE_MAXIMIZED)
-            {
-                paused_ = false;
-                minimized_ = false;
-                maximized_ = true;
-                render_system_->OnResize();
-            }
-            else if (wparam == SIZE_RESTORED)
-            {
-                // Restoring from minimized state?
-                if (minimized_)
-                {
-                    paused_ = false;
-                    minimized_ = false;
-                    render_system_->OnResize();
-                }
-
-                // Restoring from maximized state?
-                else if (maximized_)
-                {
-                    paused_ = false;
-                    maximized_ = false;
-                    render_system_->OnResize();
-                }
-                else if (resizing_)
-                {
-                    // If user is dragging the resize bars, we do not resize 
-                    // the buffers here because as the user continuously 
-                    // drags the resize bars, a stream of WM_SIZE messages are
-                    // sent to the window, and it would be pointless (and slow)
-                    // to resize for each WM_SIZE message received from dragging
-                    // the resize bars.  So instead, we reset after the user is 
-                    // done resizing the window and releases the resize bars, which 
-                    // sends a WM_EXITSIZEMOVE message.
-                }
-                else // API call such as SetWindowPos or mSwapChain->SetFullscreenState.
-                {
-                    render_system_->OnResize();
-                }
-            }
-        }
+        if (wparam == SIZE_MINIMIZED) event.code = static_cast<uint32_t>(WindowSizeState::kMinimized);
+        else if (wparam == SIZE_MAXIMIZED) event.code = static_cast<uint32_t>(WindowSizeState::kMaximized);
+        else if (wparam == SIZE_RESTORED) event.code = static_cast<uint32_t>(WindowSizeState::kRestored);
+        else return 0;
+        event.type = WindowEventType::kSize;
+        event.x = LOWORD(lparam);
+        event.y = HIWORD(lparam);
+        window_events_.Post(event);
         return 0;
 
-        // WM_EXITSIZEMOVE is sent when the user grabs the resize bars.
+        // WM_ENTERSIZEMOVE is sent when the user grabs the resize bars.
     case WM_ENTERSIZEMOVE:
-        paused_ = true;
-        resizing_ = true;
-        if (game_timer_) game_timer_->SetTimeScale(0.0f);
+        event.type = WindowEventType::kEnterSizeMove;
+        window_events_.Post(event);
         return 0;
 
         // WM_EXITSIZEMOVE is sent when the user releases the resize bars.
         // Here we reset everything based on the new window dimensions.
     case WM_EXITSIZEMOVE:
-        paused_ = false;
-        resizing_ = false;
-        if (game_timer_) game_timer_->SetTimeScale(1.0f);
-        if (render_system_) render_system_->OnResize();
+        event.type = WindowEventType::kExitSizeMove;
+        window_events_.Post(event);
+        return 0;
+
+        // WM_CLOSE is sent by the close button, Alt+F4 and Escape.  The
+        // window must outlive the render thread's last Present, so the frame
+        // thread releases that first and then asks for DestroyWindow.
+    case WM_CLOSE:
+        event.type = WindowEventType::kClose;
+        window_events_.Post(event);
+        return 0;
+
+    case kDestroyWindowMessage:
+        DestroyWindow(hwnd);
         return 0;
 
         // WM_DESTROY is sent when the window is being destroyed.
@@ -268,30 +318,108 @@ LRESULT GameSystem::MsgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
     case WM_LBUTTONDOWN:
     case WM_MBUTTONDOWN:
     case WM_RBUTTONDOWN:
-        if (render_system_) render_system_->OnMouseDown(wparam, GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam));
-        return 0;
+        event.type = WindowEventType::kMouseDown;
+        break;
     case WM_LBUTTONUP:
     case WM_MBUTTONUP:
     case WM_RBUTTONUP:
-        if (render_system_) render_system_->OnMouseUp(wparam, GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam));
-        return 0;
+        event.type = WindowEventType::kMouseUp;
+        break;
     case WM_MOUSEMOVE:
-        if (render_system_) render_system_->OnMouseMove(wparam, GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam));
-        return 0;
+        event.type = WindowEventType::kMouseMove;
+        break;
     case WM_KEYUP:
-        if (wparam == VK_ESCAPE)
+        event.type = WindowEventType::kKeyUp;
+        event.code = static_cast<uint32_t>(wparam);
+        window_events_.Post(event);
+        return 0;
+    default:
+        return DefWindowProc(hwnd, msg, wparam, lparam);
+    }
+
+    // Mouse messages
+    event.code = static_cast<uint32_t>(wparam);
+    event.x = GET_X_LPARAM(lparam);
+    event.y = GET_Y_LPARAM(lparam);
+    window_events_.Post(event);
+    return 0;
+}
+
+//--------------------------------------------------------------------------------
+//  Window Event (frame thread)
+//--------------------------------------------------------------------------------
+void GameSystem::HandleWindowEvent(const WindowEvent& event)
+{
+    switch (event.type)
+    {
+    case WindowEventType::kActivate:
+        paused_ = false;
+        if (game_timer_) game_timer_->SetTimeScale(1.0f);
+        break;
+    case WindowEventType::kDeactivate:
+        paused_ = true;
+        if (game_timer_) game_timer_->SetTimeScale(0.0f);
+        break;
+    case WindowEventType::kSize:
+        resize_coalescer_.OnSize(event.x, event.y, static_cast<WindowSizeState>(event.code));
+        width_ = resize_coalescer_.Width();
+        height_ = resize_coalescer_.Height();
+        paused_ = resize_coalescer_.Minimized() || resize_coalescer_.Dragging();
+        break;
+    case WindowEventType::kEnterSizeMove:
+        paused_ = true;
+        resize_coalescer_.OnEnterSizeMove();
+        if (game_timer_) game_timer_->SetTimeScale(0.0f);
+        break;
+    case WindowEventType::kExitSizeMove:
+        paused_ = false;
+        resize_coalescer_.OnExitSizeMove();
+        if (game_timer_) game_timer_->SetTimeScale(1.0f);
+        break;
+    case WindowEventType::kMouseDown:
+        if (render_thread_) render_thread_->PostMouseDown(event.code, event.x, event.y);
+        break;
+    case WindowEventType::kMouseUp:
+        if (render_thread_) render_thread_->PostMouseUp(event.code, event.x, event.y);
+        break;
+    case WindowEventType::kMouseMove:
+        if (render_thread_) render_thread_->PostMouseMove(event.code, event.x, event.y);
+        break;
+    case WindowEventType::kKeyUp:
+        if (event.code == VK_ESCAPE)
         {
-            PostQuitMessage(0);
+            // Same path as the close button (see Close).
+            PostMessage(main_window_handle_, WM_CLOSE, 0, 0);
         }
-        else if ((int)wparam == VK_F2)
+        else if (event.code == VK_F2)
         {
-            if (render_system_) render_system_->SetMsaaState(!render_system_->GetMsaaState());
+            if (render_thread_) render_thread_->PostToggleMsaa();
         }
-
-        return 0;
+        else if (event.code == VK_F3)
+        {
+            if (render_thread_) render_thread_->PostToggleDynamicResolution();
+        }
+        break;
+    default:
+        break;
     }
+}
 
-    return DefWindowProc(hwnd, msg, wparam, lparam);
+//--------------------------------------------------------------------------------
+//  Close (frame thread)
+//  Executes and joins what the render thread has queued and releases the
+//  swap chain, so nothing is presented any more, then has the message
+//  thread destroy the window.  It ends the message loop with WM_QUIT,
+//  which ends Run.
+//--------------------------------------------------------------------------------
+void GameSystem::Close()
+{
+    if (render_thread_ == nullptr) return;  // closed already
+    render_thread_->Release();
+    render_thread_ = nullptr;
+    render_system_->Release();
+    render_system_ = nullptr;
+    PostMessage(main_window_handle_, kDestroyWindowMessage, 0, 0);
 }
 
 //--------------------------------------------------------------------------------
@@ -299,7 +427,10 @@ LRESULT GameSystem::MsgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 //--------------------------------------------------------------------------------
 void GameSystem::Update()
 {
-    render_system_->PrepareRender();
+    // Waits only when the render thread is two frames behind.
+    RenderPacket& packet = render_thread_->BeginPacket();
+    packet.frame_index = frame_count_++;
+    packet.delta_time = game_timer_->ScaledDeltaTime();
 }
 
 //--------------------------------------------------------------------------------
@@ -307,5 +438,7 @@ void GameSystem::Update()
 //--------------------------------------------------------------------------------
 void GameSystem::Render()
 {
-    render_system_->Render();
+    // Hand the packet over; the render thread records and presents it
+    // while the next frame is simulated.
+    render_thread_->SubmitPacket();
 }
\ No newline at end of file
@@ -1,10 +1,16 @@
 #pragma once
 #include <Windows.h>
+#include <future>
 #include <string>
+#include <thread>
 #include <wrl.h>
+#include "window_events.h"
 
+class FrameAllocator;
 class GameTimer;
+class JobSystem;
 class RenderSystem;
+class RenderThread;
 
 class GameSystem
 {
@@ -26,25 +32,37 @@ private:
     GameSystem& operator=(const GameSystem& rhs) = delete;
 
     bool        InitWindow();
+    void        MessageLoop(std::promise<bool>* window_created);
+    void        HandleWindowEvent(const WindowEvent& event);
+    void        Close();
     void        Update();
     void        Render();
 
     static constexpr UINT kFpsLimit = 120;
+    static constexpr UINT kDestroyWindowMessage = WM_APP;      // posted by Close
+    static constexpr size_t kFrameScratchCapacity = 1 << 20;   // per worker and arena
 
     HINSTANCE     app_instance_handle_;
     HWND          main_window_handle_ = nullptr;
     bool          paused_ = false;
-    bool          minimized_ = false;
-    bool          maximized_ = false;
-    bool          resizing_ = false;
     bool          fullscreen_state_ = false;
     UINT          width_ = 800;
     UINT          height_ = 600;
     std::wstring  class_name_ = L"GameWindow";
     std::wstring  window_name_ = L"DirectX 12 test application";
+
+    // The window and its message loop live on message_thread_; the frame
+    // thread only sees what MsgProc posts to window_events_.
+    std::thread      message_thread_;
+    WindowEventQueue window_events_;
+    ResizeCoalescer  resize_coalescer_{ width_, height_ };
     
     GameTimer*    game_timer_ = nullptr;
+    JobSystem*    job_system_ = nullptr;
+    FrameAllocator* frame_allocator_ = nullptr;
     RenderSystem* render_system_ = nullptr;
+    RenderThread* render_thread_ = nullptr;
+    UINT64        frame_count_ = 0;
 
     static GameSystem* instance_;
 };
\ No newline at end of file
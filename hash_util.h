@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------------
+//  hash_util.h
+//  Stable 64 bit hashes for cache keys that are written to disk (FNV
+//  constants, no seed, so the value never depends on the platform or the run).
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+//--------------------------------------------------------------------------------
+//  FNV-1a
+//--------------------------------------------------------------------------------
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = kFnvOffsetBasis)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+//--------------------------------------------------------------------------------
+//  FNV-1a structure with whole 32 bit words in place of bytes: one xor and
+//  multiply per word.  This is not FNV-1a and differs from HashBytes over the
+//  same memory.  Bit n of the result only depends on bits 0..n of the words,
+//  so MixHash it before using its low bits alone.
+//--------------------------------------------------------------------------------
+inline uint64_t HashWords(const uint32_t* words, size_t count, uint64_t hash = kFnvOffsetBasis)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        hash ^= words[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+//--------------------------------------------------------------------------------
+//  Finalizer (MurmurHash3 fmix64), spreads a hash over all bits before hashes
+//  are combined by addition
+//--------------------------------------------------------------------------------
+inline uint64_t MixHash(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
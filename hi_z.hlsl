@@ -0,0 +1,75 @@
+//--------------------------------------------------------------------------------
+//  hi_z.hlsl
+//  Min / max depth pyramid of the depth prepass (hi_z_buffer.h).  GPU side of
+//  HiZPyramid::Build; texels without any pixel keep (1, 0).
+//  HI_Z_BASE           : level 0 from the depth buffer (HI_Z_SAMPLES samples)
+//  otherwise           : level n from level n - 1
+//--------------------------------------------------------------------------------
+
+#define THREAD_GROUP_SIZE 8
+
+cbuffer HiZConstants : register(b0)
+{
+    uint2 source_size;          // pixels of the depth buffer, or texels of level n - 1
+    uint2 destination_size;     // texels of the level written
+};
+
+#ifdef HI_Z_BASE
+#if HI_Z_SAMPLES > 1
+Texture2DMS<float> source : register(t0);
+#else
+Texture2D<float> source : register(t0);
+#endif
+#else
+Texture2D<float2> source : register(t0);
+#endif
+RWTexture2D<float2> destination : register(u0);
+
+float2 Merge(float2 texel, float2 value)
+{
+    return float2(min(texel.x, value.x), max(texel.y, value.y));
+}
+
+#ifdef HI_Z_BASE
+// Level 0 texel from its 2x2 pixels (all samples); pixels past the screen do not exist.
+[numthreads(THREAD_GROUP_SIZE, THREAD_GROUP_SIZE, 1)]
+void CSBuildBase(uint3 id : SV_DispatchThreadID)
+{
+    if (any(id.xy >= destination_size)) return;
+
+    float2 texel = float2(1.0f, 0.0f);
+    [unroll]
+    for (uint i = 0; i < 4; ++i)
+    {
+        uint2 pixel = id.xy * 2 + uint2(i & 1, i >> 1);
+        if (any(pixel >= source_size)) continue;
+#if HI_Z_SAMPLES > 1
+        [unroll]
+        for (uint sample = 0; sample < HI_Z_SAMPLES; ++sample)
+        {
+            float depth = source.Load(int2(pixel), sample);
+            texel = Merge(texel, float2(depth, depth));
+        }
+#else
+        float depth = source.Load(int3(pixel, 0));
+        texel = Merge(texel, float2(depth, depth));
+#endif
+    }
+    destination[id.xy] = texel;
+}
+#else
+// Level n texel from 2x2 texels of level n - 1; a size of 1 repeats.
+[numthreads(THREAD_GROUP_SIZE, THREAD_GROUP_SIZE, 1)]
+void CSDownsample(uint3 id : SV_DispatchThreadID)
+{
+    if (any(id.xy >= destination_size)) return;
+
+    uint2 t0 = min(id.xy * 2, source_size - 1);
+    uint2 t1 = min(id.xy * 2 + 1, source_size - 1);
+    float2 texel = source.Load(int3(t0.x, t0.y, 0));
+    texel = Merge(texel, source.Load(int3(t1.x, t0.y, 0)));
+    texel = Merge(texel, source.Load(int3(t0.x, t1.y, 0)));
+    texel = Merge(texel, source.Load(int3(t1.x, t1.y, 0)));
+    destination[id.xy] = texel;
+}
+#endif
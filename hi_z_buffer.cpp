@@ -0,0 +1,220 @@
+//--------------------------------------------------------------------------------
+//  hi_z_buffer.cpp
+//--------------------------------------------------------------------------------
+#include "hi_z_buffer.h"
+#include "bindless_descriptor_heap.h"
+#include "root_signature_cache.h"
+#include "root_signature_layout.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+namespace
+{
+    UINT LevelSize(UINT pixels, UINT level)
+    {
+        return MathHelper::Max(HiZPyramid::BaseSize(pixels) >> level, 1u);
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void HiZBuffer::Initialize(ID3D12Device* device)
+{
+    device_ = device;
+
+    RootDescriptorRange source;
+    source.type = DescriptorRangeType::kShaderResourceView;
+    RootDescriptorRange destination;
+    destination.type = DescriptorRangeType::kUnorderedAccessView;
+
+    RootSignatureLayout layout;
+    layout.AddConstants(4, 0);                      // kConstants
+    layout.AddDescriptorTable(&source, 1);          // kSource
+    layout.AddDescriptorTable(&destination, 1);     // kDestination
+    assert(layout.Parameters().size() == kRootParameterCount);
+    root_signature_ = RootSignatureCache::Instance().Get(layout);
+
+    CreatePipelineStates();
+}
+
+void HiZBuffer::Release()
+{
+    ReleaseViews();
+    pyramid_.Reset();
+    mip_count_ = 0;
+    level_count_ = 0;
+}
+
+void HiZBuffer::Resize(UINT width, UINT height)
+{
+    ReleaseViews();
+    pyramid_.Reset();
+    level_count_ = 0;
+
+    mip_count_ = HiZPyramid::LevelCount(width, height);
+    ThrowIfFailed(device_->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32G32_FLOAT,
+            HiZPyramid::BaseSize(width), HiZPyramid::BaseSize(height), 1, static_cast<UINT16>(mip_count_),
+            1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+        nullptr,
+        IID_PPV_ARGS(pyramid_.GetAddressOf())));
+
+    BindlessDescriptorHeap& heap = BindlessDescriptorHeap::Instance();
+    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+    srv_desc.Format = DXGI_FORMAT_R32G32_FLOAT;
+    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srv_desc.Texture2D.MostDetailedMip = 0;
+    srv_desc.Texture2D.MipLevels = mip_count_;
+    pyramid_view_ = heap.CreateShaderResourceView(pyramid_.Get(), &srv_desc);
+
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uav_desc = {};
+    uav_desc.Format = DXGI_FORMAT_R32G32_FLOAT;
+    uav_desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+    for (UINT level = 0; level < mip_count_; ++level)
+    {
+        srv_desc.Texture2D.MostDetailedMip = level;
+        srv_desc.Texture2D.MipLevels = 1;
+        level_views_[level] = heap.CreateShaderResourceView(pyramid_.Get(), &srv_desc);
+        uav_desc.Texture2D.MipSlice = level;
+        level_uavs_[level] = heap.CreateUnorderedAccessView(pyramid_.Get(), &uav_desc);
+    }
+}
+
+void HiZBuffer::Build(ID3D12GraphicsCommandList* command_list, ID3D12Resource* depth, DXGI_FORMAT view_format,
+    UINT sample_count, UINT width, UINT height)
+{
+    assert(pyramid_);
+    const UINT level_count = HiZPyramid::LevelCount(width, height);
+    assert(level_count <= mip_count_ && "HiZBuffer::Resize was not called for this size.");
+
+    // The depth buffer may be another pooled target next frame; its view
+    // lives for this frame only.
+    BindlessDescriptorHeap& heap = BindlessDescriptorHeap::Instance();
+    D3D12_SHADER_RESOURCE_VIEW_DESC depth_desc = {};
+    depth_desc.Format = view_format;
+    depth_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    if (sample_count > 1)
+    {
+        depth_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DMS;
+    }
+    else
+    {
+        depth_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        depth_desc.Texture2D.MipLevels = 1;
+    }
+    const BindlessHandle depth_view = heap.CreateShaderResourceView(depth, &depth_desc);
+    if (depth_view.IsNull())
+    {
+        level_count_ = 0;
+        return;
+    }
+
+    D3D12_RESOURCE_BARRIER barriers[HiZPyramid::kMaxLevels + 1];
+    barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(depth,
+        D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    for (UINT level = 0; level < level_count; ++level)
+    {
+        barriers[level + 1] = CD3DX12_RESOURCE_BARRIER::Transition(pyramid_.Get(),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, level);
+    }
+    command_list->ResourceBarrier(level_count + 1, barriers);
+
+    command_list->SetComputeRootSignature(root_signature_.Get());
+    for (UINT level = 0; level < level_count; ++level)
+    {
+        const UINT constants[4] =
+        {
+            level == 0 ? width : LevelSize(width, level - 1),
+            level == 0 ? height : LevelSize(height, level - 1),
+            LevelSize(width, level),
+            LevelSize(height, level),
+        };
+        command_list->SetComputeRoot32BitConstants(kConstants, _countof(constants), constants, 0);
+        command_list->SetComputeRootDescriptorTable(kSource, heap.GpuHandle(level == 0 ? depth_view : level_views_[level - 1]));
+        command_list->SetComputeRootDescriptorTable(kDestination, heap.GpuHandle(level_uavs_[level]));
+        command_list->SetPipelineState(level == 0 ? BasePipelineState(sample_count) : downsample_pso_.Get());
+        command_list->Dispatch((constants[2] + kThreadGroupSize - 1) / kThreadGroupSize,
+            (constants[3] + kThreadGroupSize - 1) / kThreadGroupSize, 1);
+
+        // Readable by the next level, and by the next frame's culling.
+        command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(pyramid_.Get(),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, level));
+    }
+
+    command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(depth,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+    heap.ReleaseView(depth_view);
+
+    width_ = width;
+    height_ = height;
+    level_count_ = level_count;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE HiZBuffer::Pyramid() const
+{
+    return BindlessDescriptorHeap::Instance().GpuHandle(pyramid_view_);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void HiZBuffer::CreatePipelineStates()
+{
+    const D3D_SHADER_MACRO base_defines[] = { { "HI_Z_BASE", "1" }, { "HI_Z_SAMPLES", "1" }, { nullptr, nullptr } };
+    const D3D_SHADER_MACRO base_ms_defines[] = { { "HI_Z_BASE", "1" }, { "HI_Z_SAMPLES", "4" }, { nullptr, nullptr } };
+    static_assert(kMaxSampleCount == 4, "HI_Z_SAMPLES of base_ms_defines must match kMaxSampleCount");
+
+    const struct
+    {
+        const D3D_SHADER_MACRO* defines;
+        const char* entry;
+        ComPtr<ID3D12PipelineState>* pso;
+    } kernels[] =
+    {
+        { base_defines, "CSBuildBase", &base_pso_ },
+        { base_ms_defines, "CSBuildBase", &base_ms_pso_ },
+        { nullptr, "CSDownsample", &downsample_pso_ },
+    };
+
+    for (auto& kernel : kernels)
+    {
+        ComPtr<ID3DBlob> shader = d3dUtil::CompileShader(L"hi_z.hlsl", kernel.defines, kernel.entry, "cs_5_1");
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = root_signature_.Get();
+        desc.CS = { shader->GetBufferPointer(), shader->GetBufferSize() };
+        desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+        ThrowIfFailed(device_->CreateComputePipelineState(&desc, IID_PPV_ARGS(kernel.pso->GetAddressOf())));
+    }
+}
+
+void HiZBuffer::ReleaseViews()
+{
+    if (!BindlessDescriptorHeap::IsCreated()) return;
+    BindlessDescriptorHeap& heap = BindlessDescriptorHeap::Instance();
+    heap.ReleaseView(pyramid_view_);
+    pyramid_view_ = BindlessHandle();
+    for (UINT level = 0; level < HiZPyramid::kMaxLevels; ++level)
+    {
+        heap.ReleaseView(level_views_[level]);
+        heap.ReleaseView(level_uavs_[level]);
+        level_views_[level] = BindlessHandle();
+        level_uavs_[level] = BindlessHandle();
+    }
+}
+
+ID3D12PipelineState* HiZBuffer::BasePipelineState(UINT sample_count) const
+{
+    assert((sample_count == 1 || sample_count == kMaxSampleCount) && "Unsupported depth sample count.");
+    return sample_count > 1 ? base_ms_pso_.Get() : base_pso_.Get();
+}
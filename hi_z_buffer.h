@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------------
+//  hi_z_buffer.h
+//  GPU min / max depth pyramid (hi_z.hlsl), built from the depth prepass of
+//  each frame and read by the next frame's occlusion test (hi_z_test.hlsli).
+//  Layout and rules are those of HiZPyramid, its CPU reference.
+//  - One R32G32_FLOAT texture with a mip per level, sized for the output;
+//    frames rendered smaller (dynamic resolution) use its top left part.
+//  - Views live in the BindlessDescriptorHeap.
+//  - Between builds every level is in NON_PIXEL_SHADER_RESOURCE.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+#include "bindless_handle_table.h"
+#include "hi_z_pyramid.h"
+
+class HiZBuffer
+{
+public:
+    HiZBuffer() = default;
+    ~HiZBuffer() = default;
+
+    void Initialize(ID3D12Device* device);
+    void Release();
+
+    //--------------------------------------------------------------------------------
+    //  Size for an output of width x height.  Only while the GPU is idle: the
+    //  old texture is released right away.
+    //--------------------------------------------------------------------------------
+    void Resize(UINT width, UINT height);
+
+    //--------------------------------------------------------------------------------
+    //  Record the pyramid of the width x height area of depth, which is in
+    //  DEPTH_WRITE state before and after.
+    //  view_format  : SRV format of depth (e.g. R24_UNORM_X8_TYPELESS)
+    //  sample_count : 1, or the MSAA sample count of depth
+    //--------------------------------------------------------------------------------
+    void Build(ID3D12GraphicsCommandList* command_list, ID3D12Resource* depth, DXGI_FORMAT view_format,
+        UINT sample_count, UINT width, UINT height);
+
+    //--------------------------------------------------------------------------------
+    //  Last build; LevelCount() is 0 before the first one and after Resize.
+    //  Pyramid() is an SRV of every level.
+    //--------------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE Pyramid() const;
+    UINT Width() const { return width_; }
+    UINT Height() const { return height_; }
+    UINT LevelCount() const { return level_count_; }
+
+private:
+    HiZBuffer(const HiZBuffer& rhs) = delete;
+    HiZBuffer& operator=(const HiZBuffer& rhs) = delete;
+
+    enum RootParameter
+    {
+        kConstants = 0,
+        kSource,
+        kDestination,
+        kRootParameterCount
+    };
+
+    static constexpr UINT kThreadGroupSize = 8;
+    static constexpr UINT kMaxSampleCount = 4;
+
+    void CreatePipelineStates();
+    void ReleaseViews();
+    ID3D12PipelineState* BasePipelineState(UINT sample_count) const;
+
+    ID3D12Device* device_ = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> root_signature_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> base_pso_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> base_ms_pso_;   // kMaxSampleCount samples
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> downsample_pso_;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> pyramid_;
+    UINT mip_count_ = 0;
+    BindlessHandle pyramid_view_;
+    BindlessHandle level_views_[HiZPyramid::kMaxLevels];
+    BindlessHandle level_uavs_[HiZPyramid::kMaxLevels];
+
+    UINT width_ = 0;
+    UINT height_ = 0;
+    UINT level_count_ = 0;
+};
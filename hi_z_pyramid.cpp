@@ -0,0 +1,174 @@
+//--------------------------------------------------------------------------------
+//  hi_z_pyramid.cpp
+//--------------------------------------------------------------------------------
+#include "hi_z_pyramid.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+using namespace std;
+
+namespace
+{
+    constexpr HiZTexel kEmptyTexel = { 1.0f, 0.0f };
+    constexpr float kMinClipW = 1e-5f;
+
+    uint32_t NextPowerOfTwo(uint32_t value)
+    {
+        uint32_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    void Merge(HiZTexel& destination, const HiZTexel& source)
+    {
+        destination.min_depth = min(destination.min_depth, source.min_depth);
+        destination.max_depth = max(destination.max_depth, source.max_depth);
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+uint32_t HiZPyramid::BaseSize(uint32_t pixels)
+{
+    return NextPowerOfTwo((pixels + 1) / 2);
+}
+
+uint32_t HiZPyramid::LevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t size = max(BaseSize(width), BaseSize(height));
+    uint32_t count = 1;
+    while (size > 1)
+    {
+        size >>= 1;
+        ++count;
+    }
+    return count;
+}
+
+void HiZPyramid::Build(const float* depth, uint32_t width, uint32_t height)
+{
+    assert(width > 0 && height > 0);
+    width_ = width;
+    height_ = height;
+    level_count_ = LevelCount(width, height);
+    assert(level_count_ <= kMaxLevels);
+
+    size_t texel_count = 0;
+    for (uint32_t level = 0; level < level_count_; ++level)
+    {
+        level_width_[level] = max(1u, BaseSize(width) >> level);
+        level_height_[level] = max(1u, BaseSize(height) >> level);
+        level_offset_[level] = texel_count;
+        texel_count += static_cast<size_t>(level_width_[level]) * level_height_[level];
+    }
+    texels_.assign(texel_count, kEmptyTexel);
+
+    // Level 0 from 2x2 pixels; pixels past the screen do not exist.
+    HiZTexel* base = texels_.data();
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        HiZTexel* row = base + static_cast<size_t>(y >> 1) * level_width_[0];
+        const float* source = depth + static_cast<size_t>(y) * width;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const HiZTexel pixel = { source[x], source[x] };
+            Merge(row[x >> 1], pixel);
+        }
+    }
+
+    // Each level from the 2x2 texels below it; a size of 1 repeats.
+    for (uint32_t level = 1; level < level_count_; ++level)
+    {
+        const HiZTexel* source = texels_.data() + level_offset_[level - 1];
+        const uint32_t source_width = level_width_[level - 1];
+        const uint32_t source_height = level_height_[level - 1];
+        HiZTexel* destination = texels_.data() + level_offset_[level];
+        for (uint32_t y = 0; y < level_height_[level]; ++y)
+        {
+            const uint32_t y0 = min(y * 2, source_height - 1);
+            const uint32_t y1 = min(y * 2 + 1, source_height - 1);
+            for (uint32_t x = 0; x < level_width_[level]; ++x)
+            {
+                const uint32_t x0 = min(x * 2, source_width - 1);
+                const uint32_t x1 = min(x * 2 + 1, source_width - 1);
+                HiZTexel texel = source[static_cast<size_t>(y0) * source_width + x0];
+                Merge(texel, source[static_cast<size_t>(y0) * source_width + x1]);
+                Merge(texel, source[static_cast<size_t>(y1) * source_width + x0]);
+                Merge(texel, source[static_cast<size_t>(y1) * source_width + x1]);
+                destination[static_cast<size_t>(y) * level_width_[level] + x] = texel;
+            }
+        }
+    }
+}
+
+bool HiZPyramid::ProjectBox(const float view_proj[16], const float center[3], const float extents[3],
+    uint32_t width, uint32_t height, HiZRect* rect)
+{
+    float min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+    float max_x = -FLT_MAX, max_y = -FLT_MAX;
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const float x = center[0] + ((corner & 1) ? extents[0] : -extents[0]);
+        const float y = center[1] + ((corner & 2) ? extents[1] : -extents[1]);
+        const float z = center[2] + ((corner & 4) ? extents[2] : -extents[2]);
+        const float clip_x = x * view_proj[0] + y * view_proj[4] + z * view_proj[8] + view_proj[12];
+        const float clip_y = x * view_proj[1] + y * view_proj[5] + z * view_proj[9] + view_proj[13];
+        const float clip_z = x * view_proj[2] + y * view_proj[6] + z * view_proj[10] + view_proj[14];
+        const float clip_w = x * view_proj[3] + y * view_proj[7] + z * view_proj[11] + view_proj[15];
+        if (clip_w < kMinClipW) return false;
+
+        const float inverse_w = 1.0f / clip_w;
+        min_x = min(min_x, clip_x * inverse_w);
+        max_x = max(max_x, clip_x * inverse_w);
+        min_y = min(min_y, clip_y * inverse_w);
+        max_y = max(max_y, clip_y * inverse_w);
+        min_z = min(min_z, clip_z * inverse_w);
+    }
+
+    // NDC to pixels, y down.
+    const float left = (min_x * 0.5f + 0.5f) * width;
+    const float right = (max_x * 0.5f + 0.5f) * width;
+    const float top = (0.5f - max_y * 0.5f) * height;
+    const float bottom = (0.5f - min_y * 0.5f) * height;
+    if (right < 0.0f || bottom < 0.0f || left >= width || top >= height) return false;
+
+    rect->min_x = static_cast<uint32_t>(max(left, 0.0f));
+    rect->min_y = static_cast<uint32_t>(max(top, 0.0f));
+    rect->max_x = static_cast<uint32_t>(min(right, width - 1.0f));
+    rect->max_y = static_cast<uint32_t>(min(bottom, height - 1.0f));
+    rect->min_depth = max(min_z, 0.0f);
+    return true;
+}
+
+bool HiZPyramid::IsOccluded(const HiZRect& rect) const
+{
+    // Finest level where the rectangle spans at most 2 texels per axis.
+    uint32_t level = 0;
+    while (level + 1 < level_count_
+        && ((rect.max_x >> (level + 1)) - (rect.min_x >> (level + 1)) > 1
+        || (rect.max_y >> (level + 1)) - (rect.min_y >> (level + 1)) > 1))
+    {
+        ++level;
+    }
+
+    const HiZTexel* texels = Level(level);
+    const uint32_t level_width = level_width_[level];
+    const uint32_t x0 = min(rect.min_x >> (level + 1), level_width - 1);
+    const uint32_t x1 = min(rect.max_x >> (level + 1), level_width - 1);
+    const uint32_t y0 = min(rect.min_y >> (level + 1), level_height_[level] - 1);
+    const uint32_t y1 = min(rect.max_y >> (level + 1), level_height_[level] - 1);
+    const float max_depth = max(
+        max(texels[y0 * level_width + x0].max_depth, texels[y0 * level_width + x1].max_depth),
+        max(texels[y1 * level_width + x0].max_depth, texels[y1 * level_width + x1].max_depth));
+    return rect.min_depth > max_depth;
+}
+
+bool HiZPyramid::IsOccluded(const float view_proj[16], const float center[3], const float extents[3]) const
+{
+    HiZRect rect;
+    return ProjectBox(view_proj, center, extents, width_, height_, &rect) && IsOccluded(rect);
+}
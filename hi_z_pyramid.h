@@ -0,0 +1,78 @@
+//--------------------------------------------------------------------------------
+//  hi_z_pyramid.h
+//  Hierarchical min / max depth of a depth buffer (depth test LESS, far 1.0)
+//  and the occlusion test of a box against it.  CPU reference of hi_z.hlsl
+//  and hi_z_test.hlsli, which use the same layout:
+//  - Level 0 texel (x, y) covers pixels [2x, 2x+1] x [2y, 2y+1]; level n+1
+//    covers 2x2 texels of level n.  Level 0 is the next power of two of half
+//    the screen, so a pixel maps to texel (x >> (n+1), y >> (n+1)) of level n.
+//  - Texels without any pixel keep { 1, 0 }, which leaves the min / max of
+//    the texels above them unchanged.
+//  - A box is occluded when its nearest depth is behind the farthest depth
+//    of the (at most 2x2) texels of the finest level that covers its screen
+//    rectangle with 2 texels per axis.
+//  No D3D12 or DirectXMath dependency.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct HiZTexel                 // DXGI_FORMAT_R32G32_FLOAT
+{
+    float min_depth;
+    float max_depth;
+};
+
+struct HiZRect
+{
+    uint32_t min_x, min_y;      // pixels, inclusive, inside the screen
+    uint32_t max_x, max_y;
+    float    min_depth;         // nearest depth of the box
+};
+
+class HiZPyramid
+{
+public:
+    static constexpr uint32_t kMaxLevels = 16;
+
+    //--------------------------------------------------------------------------------
+    //  Level 0 size for a screen size in pixels, and the number of levels
+    //  down to 1 x 1
+    //--------------------------------------------------------------------------------
+    static uint32_t BaseSize(uint32_t pixels);
+    static uint32_t LevelCount(uint32_t width, uint32_t height);
+
+    //--------------------------------------------------------------------------------
+    //  depth : width x height, row major
+    //--------------------------------------------------------------------------------
+    void Build(const float* depth, uint32_t width, uint32_t height);
+
+    //--------------------------------------------------------------------------------
+    //  Screen rectangle and nearest depth of a world space box.  False when
+    //  the box cannot be tested: it crosses the near plane or misses the
+    //  screen (the frustum test handles the latter).
+    //  view_proj : row vector convention, row major (XMFLOAT4X4 layout)
+    //--------------------------------------------------------------------------------
+    static bool ProjectBox(const float view_proj[16], const float center[3], const float extents[3],
+        uint32_t width, uint32_t height, HiZRect* rect);
+
+    bool IsOccluded(const HiZRect& rect) const;
+    bool IsOccluded(const float view_proj[16], const float center[3], const float extents[3]) const;
+
+    uint32_t Width() const { return width_; }
+    uint32_t Height() const { return height_; }
+    uint32_t LevelCount() const { return level_count_; }
+    uint32_t LevelWidth(uint32_t level) const { return level_width_[level]; }
+    uint32_t LevelHeight(uint32_t level) const { return level_height_[level]; }
+    const HiZTexel* Level(uint32_t level) const { return texels_.data() + level_offset_[level]; }
+
+private:
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t level_count_ = 0;
+    uint32_t level_width_[kMaxLevels] = {};
+    uint32_t level_height_[kMaxLevels] = {};
+    size_t   level_offset_[kMaxLevels] = {};
+    std::vector<HiZTexel> texels_;
+};
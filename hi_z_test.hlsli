@@ -0,0 +1,64 @@
+//--------------------------------------------------------------------------------
+//  hi_z_test.hlsli
+//  Occlusion test of a world space box against a Hi-Z pyramid built by
+//  hi_z.hlsl.  Mirrors HiZPyramid::ProjectBox / IsOccluded (hi_z_pyramid.h).
+//--------------------------------------------------------------------------------
+#ifndef HI_Z_TEST_HLSLI
+#define HI_Z_TEST_HLSLI
+
+uint HiZBaseSize(uint pixels)
+{
+    // Next power of two of half the screen.
+    uint half_size = (pixels + 1) / 2;
+    return half_size <= 1 ? 1 : 2u << firstbithigh(half_size - 1);
+}
+
+// view_proj    : matrix of the frame the pyramid was built from (row vectors)
+// screen_size  : size of that frame's depth buffer in pixels
+// level_count  : HiZPyramid::LevelCount(screen_size)
+bool HiZIsOccluded(Texture2D<float2> pyramid, float4x4 view_proj, uint2 screen_size, uint level_count,
+    float3 center, float3 extents)
+{
+    float2 ndc_min = float2(1e30f, 1e30f);
+    float2 ndc_max = float2(-1e30f, -1e30f);
+    float min_z = 1e30f;
+    [unroll]
+    for (uint corner = 0; corner < 8; ++corner)
+    {
+        float3 offset = float3((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+        float4 clip = mul(float4(center + offset * extents, 1.0f), view_proj);
+        if (clip.w < 1e-5f) return false;       // crosses the near plane
+        float3 ndc = clip.xyz / clip.w;
+        ndc_min = min(ndc_min, ndc.xy);
+        ndc_max = max(ndc_max, ndc.xy);
+        min_z = min(min_z, ndc.z);
+    }
+
+    float2 size = float2(screen_size);
+    float left = (ndc_min.x * 0.5f + 0.5f) * size.x;
+    float right = (ndc_max.x * 0.5f + 0.5f) * size.x;
+    float top = (0.5f - ndc_max.y * 0.5f) * size.y;
+    float bottom = (0.5f - ndc_min.y * 0.5f) * size.y;
+    if (right < 0.0f || bottom < 0.0f || left >= size.x || top >= size.y) return false;
+
+    uint2 rect_min = uint2(max(float2(left, top), 0.0f));
+    uint2 rect_max = uint2(min(float2(right, bottom), size - 1.0f));
+
+    // Finest level where the rectangle spans at most 2 texels per axis.
+    uint level = 0;
+    while (level + 1 < level_count
+        && any((rect_max >> (level + 1)) - (rect_min >> (level + 1)) > 1))
+    {
+        ++level;
+    }
+
+    uint2 level_size = max(uint2(HiZBaseSize(screen_size.x), HiZBaseSize(screen_size.y)) >> level, 1);
+    uint2 t0 = min(rect_min >> (level + 1), level_size - 1);
+    uint2 t1 = min(rect_max >> (level + 1), level_size - 1);
+    float max_depth = max(
+        max(pyramid.Load(int3(t0.x, t0.y, level)).y, pyramid.Load(int3(t1.x, t0.y, level)).y),
+        max(pyramid.Load(int3(t0.x, t1.y, level)).y, pyramid.Load(int3(t1.x, t1.y, level)).y));
+    return max(min_z, 0.0f) > max_depth;
+}
+
+#endif
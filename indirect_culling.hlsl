@@ -0,0 +1,120 @@
+//--------------------------------------------------------------------------------
+//  indirect_culling.hlsl
+//  GPU side of the indirect draw path.  Structures mirror indirect_draw.h and
+//  the passes mirror IndirectDrawLayout::CullAndCompact.
+//--------------------------------------------------------------------------------
+#include "hi_z_test.hlsli"
+
+#define THREAD_GROUP_SIZE 64
+
+struct IndirectInstance
+{
+    float3 center;
+    uint   group;
+    float3 extents;
+    uint   instance_data_index;
+};
+
+struct IndirectDrawGroup
+{
+    uint  bucket;
+    uint  first_visible;
+    uint  index_count;
+    uint  start_index;
+    int   base_vertex;
+    uint3 pad;
+};
+
+struct IndirectDrawCommand
+{
+    uint instance_base;
+    uint index_count_per_instance;
+    uint instance_count;
+    uint start_index_location;
+    int  base_vertex_location;
+    uint start_instance_location;
+};
+
+cbuffer CullConstants : register(b0)
+{
+    float4 planes[6];
+    uint   instance_count;
+    uint   group_count;
+    uint   bucket_count;
+};
+
+// Hi-Z pyramid of the previous frame; hi_z_level_count is 0 when there is none.
+cbuffer OcclusionConstants : register(b1)
+{
+    row_major float4x4 hi_z_view_proj;
+    uint2  hi_z_size;
+    uint   hi_z_level_count;
+};
+
+StructuredBuffer<IndirectInstance>      instances     : register(t0);
+StructuredBuffer<IndirectDrawGroup>     groups        : register(t1);
+StructuredBuffer<uint>                  bucket_first  : register(t2); // first command slot per bucket
+RWStructuredBuffer<uint>                group_counts  : register(u0);
+RWStructuredBuffer<uint>                visible       : register(u1);
+RWStructuredBuffer<IndirectDrawCommand> commands      : register(u2);
+RWStructuredBuffer<uint>                bucket_counts : register(u3);
+Texture2D<float2>                       hi_z          : register(t3);
+
+bool IsBoxVisible(float3 center, float3 extents)
+{
+    [unroll]
+    for (int i = 0; i < 6; ++i)
+    {
+        float distance = dot(planes[i].xyz, center) + planes[i].w;
+        float radius = dot(abs(planes[i].xyz), extents);
+        if (distance + radius < 0.0f) return false;
+    }
+    return true;
+}
+
+// Reset the counters of the previous frame.
+[numthreads(THREAD_GROUP_SIZE, 1, 1)]
+void CSClearCounts(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x < group_count) group_counts[id.x] = 0;
+    if (id.x < bucket_count) bucket_counts[id.x] = 0;
+}
+
+// Append each visible instance to its group's range of the visible list.
+[numthreads(THREAD_GROUP_SIZE, 1, 1)]
+void CSCullInstances(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x >= instance_count) return;
+
+    IndirectInstance instance = instances[id.x];
+    if (!IsBoxVisible(instance.center, instance.extents)) return;
+    if (hi_z_level_count > 0
+        && HiZIsOccluded(hi_z, hi_z_view_proj, hi_z_size, hi_z_level_count, instance.center, instance.extents)) return;
+
+    uint slot;
+    InterlockedAdd(group_counts[instance.group], 1, slot);
+    visible[groups[instance.group].first_visible + slot] = instance.instance_data_index;
+}
+
+// Write one command per non-empty group into its bucket's argument range.
+[numthreads(THREAD_GROUP_SIZE, 1, 1)]
+void CSCompactDraws(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x >= group_count) return;
+
+    uint count = group_counts[id.x];
+    if (count == 0) return;
+
+    IndirectDrawGroup group = groups[id.x];
+    uint slot;
+    InterlockedAdd(bucket_counts[group.bucket], 1, slot);
+
+    IndirectDrawCommand command;
+    command.instance_base = group.first_visible;
+    command.index_count_per_instance = group.index_count;
+    command.instance_count = count;
+    command.start_index_location = group.start_index;
+    command.base_vertex_location = group.base_vertex;
+    command.start_instance_location = 0;
+    commands[bucket_first[group.bucket] + slot] = command;
+}
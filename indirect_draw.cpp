@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------------
+//  indirect_draw.cpp
+//--------------------------------------------------------------------------------
+#include "indirect_draw.h"
+#include "culling_system.h"
+#include "hi_z_pyramid.h"
+#include <cassert>
+
+using namespace DirectX;
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void IndirectDrawLayout::Clear()
+{
+    pending_.clear();
+    instances_.clear();
+    groups_.clear();
+    buckets_.clear();
+}
+
+void IndirectDrawLayout::AddInstance(uint32_t pso, uint32_t submesh, const BoundingBox& world_bounds, uint32_t instance_data_index)
+{
+    PendingInstance instance;
+    instance.pso = pso;
+    instance.submesh = submesh;
+    instance.bounds = world_bounds;
+    instance.instance_data_index = instance_data_index;
+    pending_.push_back(instance);
+}
+
+void IndirectDrawLayout::Build(const DrawBatcher& batcher)
+{
+    instances_.clear();
+    groups_.clear();
+    buckets_.clear();
+
+    const size_t count = pending_.size();
+    vector<uint64_t> keys(count), temp_keys;
+    vector<uint32_t> order(count), temp_order;
+    for (size_t i = 0; i < count; ++i)
+    {
+        keys[i] = DrawBatcher::MakeKey(pending_[i].pso, 0, pending_[i].submesh, 0.0f);
+        order[i] = static_cast<uint32_t>(i);
+    }
+    DrawBatcher::RadixSort(keys, order, temp_keys, temp_order);
+
+    instances_.resize(count);
+    uint32_t first_visible = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const PendingInstance& pending = pending_[order[i]];
+        const SubmeshRange& range = batcher.Submesh(pending.submesh);
+
+        if (i == 0 || keys[i] != keys[i - 1])
+        {
+            if (buckets_.empty() || buckets_.back().pso != pending.pso || buckets_.back().mesh != range.mesh)
+            {
+                IndirectDrawBucket bucket;
+                bucket.pso = pending.pso;
+                bucket.mesh = range.mesh;
+                bucket.first_group = static_cast<uint32_t>(groups_.size());
+                bucket.group_count = 0;
+                buckets_.push_back(bucket);
+            }
+            ++buckets_.back().group_count;
+
+            IndirectDrawGroup group = {};
+            group.Bucket = static_cast<uint32_t>(buckets_.size() - 1);
+            group.FirstVisible = first_visible;
+            group.IndexCount = range.index_count;
+            group.StartIndex = range.start_index;
+            group.BaseVertex = range.base_vertex;
+            groups_.push_back(group);
+        }
+
+        IndirectInstance& instance = instances_[i];
+        instance.Center = pending.bounds.Center;
+        instance.Extents = pending.bounds.Extents;
+        instance.Group = static_cast<uint32_t>(groups_.size() - 1);
+        instance.InstanceDataIndex = pending.instance_data_index;
+        ++first_visible;
+    }
+}
+
+void IndirectDrawLayout::CullAndCompact(const XMFLOAT4 planes[6],
+    vector<uint32_t>& group_counts, vector<uint32_t>& visible,
+    vector<IndirectDrawCommand>& commands, vector<uint32_t>& bucket_counts,
+    const HiZPyramid* hi_z, const XMFLOAT4X4* hi_z_view_proj) const
+{
+    assert(!hi_z || hi_z_view_proj);
+
+    group_counts.assign(groups_.size(), 0);
+    visible.assign(instances_.size(), 0);
+    commands.assign(groups_.size(), IndirectDrawCommand());
+    bucket_counts.assign(buckets_.size(), 0);
+
+    // Pass 1 (CSCullInstances): append visible instances to their group.
+    for (const IndirectInstance& instance : instances_)
+    {
+        if (!CullingSystem::IsBoxVisible(planes, BoundingBox(instance.Center, instance.Extents))) continue;
+        if (hi_z && hi_z->LevelCount() > 0
+            && hi_z->IsOccluded(&hi_z_view_proj->m[0][0], &instance.Center.x, &instance.Extents.x)) continue;
+        const IndirectDrawGroup& group = groups_[instance.Group];
+        const uint32_t slot = group_counts[instance.Group]++;
+        visible[group.FirstVisible + slot] = instance.InstanceDataIndex;
+    }
+
+    // Pass 2 (CSCompactDraws): one command per non-empty group.
+    for (uint32_t i = 0; i < groups_.size(); ++i)
+    {
+        if (group_counts[i] == 0) continue;
+        const IndirectDrawGroup& group = groups_[i];
+        const uint32_t slot = bucket_counts[group.Bucket]++;
+
+        IndirectDrawCommand& command = commands[buckets_[group.Bucket].first_group + slot];
+        command.InstanceBase = group.FirstVisible;
+        command.Draw.IndexCountPerInstance = group.IndexCount;
+        command.Draw.InstanceCount = group_counts[i];
+        command.Draw.StartIndexLocation = group.StartIndex;
+        command.Draw.BaseVertexLocation = group.BaseVertex;
+        command.Draw.StartInstanceLocation = 0;
+    }
+}
@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------------
+//  indirect_draw.h
+//  Data layout shared by the GPU driven path (indirect_culling.hlsl and
+//  IndirectRenderer) and its CPU reference implementation.
+//
+//  Instances are grouped by (pso, submesh); groups are bucketed by (pso, mesh)
+//  so that each bucket is a single ExecuteIndirect with fixed buffers.
+//  Culling appends visible instances to their group's range of the visible
+//  list and compaction writes one command per non-empty group into its
+//  bucket's range of the argument buffer.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+#include "draw_batcher.h"
+
+class HiZPyramid;
+
+//--------------------------------------------------------------------------------
+//  One indirect command: root constant (first visible slot) + indexed draw.
+//  Must match the command signature created by IndirectRenderer.
+//--------------------------------------------------------------------------------
+struct IndirectDrawCommand
+{
+    uint32_t        InstanceBase;
+    DrawIndexedArgs Draw;
+};
+
+//--------------------------------------------------------------------------------
+//  GPU side structures (32 bytes each, mirrored in indirect_culling.hlsl)
+//--------------------------------------------------------------------------------
+struct IndirectInstance
+{
+    DirectX::XMFLOAT3 Center;   // world space bounds
+    uint32_t          Group;
+    DirectX::XMFLOAT3 Extents;
+    uint32_t          InstanceDataIndex;
+};
+
+struct IndirectDrawGroup
+{
+    uint32_t Bucket;
+    uint32_t FirstVisible;      // start of this group's range in the visible list
+    uint32_t IndexCount;
+    uint32_t StartIndex;
+    int32_t  BaseVertex;
+    uint32_t Pad[3];
+};
+
+struct IndirectDrawBucket
+{
+    uint32_t pso;
+    uint32_t mesh;
+    uint32_t first_group;       // also the first command slot of the bucket
+    uint32_t group_count;       // max command count
+};
+
+class IndirectDrawLayout
+{
+public:
+    void Clear();
+    void AddInstance(uint32_t pso, uint32_t submesh, const DirectX::BoundingBox& world_bounds, uint32_t instance_data_index);
+
+    //--------------------------------------------------------------------------------
+    //  Sort instances into groups and buckets with the DrawBatcher key
+    //--------------------------------------------------------------------------------
+    void Build(const DrawBatcher& batcher);
+
+    const std::vector<IndirectInstance>&   Instances() const { return instances_; }
+    const std::vector<IndirectDrawGroup>&  Groups() const { return groups_; }
+    const std::vector<IndirectDrawBucket>& Buckets() const { return buckets_; }
+
+    //--------------------------------------------------------------------------------
+    //  CPU reference of the cull + compaction passes.
+    //  Produces the same sets as the GPU (orders inside a group/bucket may differ
+    //  there because of atomics).
+    //  hi_z : optional occlusion test against the pyramid of a previous frame
+    //         and that frame's view_proj (XMFLOAT4X4 layout)
+    //--------------------------------------------------------------------------------
+    void CullAndCompact(const DirectX::XMFLOAT4 planes[6],
+        std::vector<uint32_t>& group_counts, std::vector<uint32_t>& visible,
+        std::vector<IndirectDrawCommand>& commands, std::vector<uint32_t>& bucket_counts,
+        const HiZPyramid* hi_z = nullptr, const DirectX::XMFLOAT4X4* hi_z_view_proj = nullptr) const;
+
+private:
+    struct PendingInstance
+    {
+        uint32_t pso;
+        uint32_t submesh;
+        DirectX::BoundingBox bounds;
+        uint32_t instance_data_index;
+    };
+
+    std::vector<PendingInstance>    pending_;
+    std::vector<IndirectInstance>   instances_;
+    std::vector<IndirectDrawGroup>  groups_;
+    std::vector<IndirectDrawBucket> buckets_;
+};
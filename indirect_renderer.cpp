@@ -0,0 +1,269 @@
+//--------------------------------------------------------------------------------
+//  indirect_renderer.cpp
+//--------------------------------------------------------------------------------
+#include "indirect_renderer.h"
+#include "bindless_descriptor_heap.h"
+#include "draw_submission.h"
+#include "root_signature_cache.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+IndirectRenderer::~IndirectRenderer()
+{
+    if (BindlessDescriptorHeap::IsCreated()) BindlessDescriptorHeap::Instance().ReleaseView(null_hi_z_view_);
+}
+
+void IndirectRenderer::Initialize(ID3D12Device* device, ID3D12RootSignature* graphics_root_signature, UINT instance_base_param)
+{
+    CreateRootSignature();
+    CreateNullHiZView();
+    CreatePipelineStates(device);
+    CreateCommandSignature(device, graphics_root_signature, instance_base_param);
+}
+
+void IndirectRenderer::Upload(ID3D12Device* device, ID3D12GraphicsCommandList* command_list, const IndirectDrawLayout& layout)
+{
+    const auto& instances = layout.Instances();
+    const auto& groups = layout.Groups();
+    buckets_ = layout.Buckets();
+    instance_count_ = static_cast<UINT>(instances.size());
+    group_count_ = static_cast<UINT>(groups.size());
+    if (instance_count_ == 0) return;
+
+    vector<UINT> bucket_first(buckets_.size());
+    for (size_t i = 0; i < buckets_.size(); ++i) bucket_first[i] = buckets_[i].first_group;
+
+    instance_buffer_ = d3dUtil::CreateDefaultBuffer(device, command_list,
+        instances.data(), instances.size() * sizeof(IndirectInstance), instance_uploader_);
+    group_buffer_ = d3dUtil::CreateDefaultBuffer(device, command_list,
+        groups.data(), groups.size() * sizeof(IndirectDrawGroup), group_uploader_);
+    bucket_first_buffer_ = d3dUtil::CreateDefaultBuffer(device, command_list,
+        bucket_first.data(), bucket_first.size() * sizeof(UINT), bucket_first_uploader_);
+
+    group_count_buffer_ = CreateUavBuffer(device, groups.size() * sizeof(UINT));
+    visible_buffer_ = CreateUavBuffer(device, instances.size() * sizeof(UINT));
+    command_buffer_ = CreateUavBuffer(device, groups.size() * sizeof(IndirectDrawCommand));
+    bucket_count_buffer_ = CreateUavBuffer(device, buckets_.size() * sizeof(UINT));
+    outputs_in_unordered_access_ = false;
+
+    // Start in the states Draw leaves them in.
+    D3D12_RESOURCE_BARRIER barriers[] =
+    {
+        CD3DX12_RESOURCE_BARRIER::Transition(group_count_buffer_.Get(),
+            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+        CD3DX12_RESOURCE_BARRIER::Transition(visible_buffer_.Get(),
+            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+        CD3DX12_RESOURCE_BARRIER::Transition(command_buffer_.Get(),
+            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+        CD3DX12_RESOURCE_BARRIER::Transition(bucket_count_buffer_.Get(),
+            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+    };
+    command_list->ResourceBarrier(_countof(barriers), barriers);
+}
+
+void IndirectRenderer::DisposeUploaders()
+{
+    instance_uploader_ = nullptr;
+    group_uploader_ = nullptr;
+    bucket_first_uploader_ = nullptr;
+}
+
+void IndirectRenderer::Cull(ID3D12GraphicsCommandList* command_list, const XMFLOAT4 planes[6],
+    const HiZOcclusion* occlusion)
+{
+    if (instance_count_ == 0) return;
+
+    TransitionOutputs(command_list, true);
+
+    UINT constants[kCullConstantCount];
+    memcpy(constants, planes, sizeof(XMFLOAT4) * 6);
+    constants[24] = instance_count_;
+    constants[25] = group_count_;
+    constants[26] = static_cast<UINT>(buckets_.size());
+
+    // The table must stay bound without a pyramid: the null view, which the
+    // shader skips.
+    UINT occlusion_constants[kOcclusionConstantCount] = {};
+    D3D12_GPU_DESCRIPTOR_HANDLE hi_z = BindlessDescriptorHeap::Instance().GpuHandle(null_hi_z_view_);
+    if (occlusion && occlusion->level_count > 0)
+    {
+        memcpy(occlusion_constants, &occlusion->view_proj, sizeof(XMFLOAT4X4));
+        occlusion_constants[16] = occlusion->width;
+        occlusion_constants[17] = occlusion->height;
+        occlusion_constants[18] = occlusion->level_count;
+        hi_z = occlusion->pyramid;
+    }
+
+    command_list->SetComputeRootSignature(root_signature_.Get());
+    command_list->SetComputeRoot32BitConstants(kCullConstants, kCullConstantCount, constants, 0);
+    command_list->SetComputeRootShaderResourceView(kInstances, instance_buffer_->GetGPUVirtualAddress());
+    command_list->SetComputeRootShaderResourceView(kGroups, group_buffer_->GetGPUVirtualAddress());
+    command_list->SetComputeRootShaderResourceView(kBucketFirst, bucket_first_buffer_->GetGPUVirtualAddress());
+    command_list->SetComputeRootUnorderedAccessView(kGroupCounts, group_count_buffer_->GetGPUVirtualAddress());
+    command_list->SetComputeRootUnorderedAccessView(kVisible, visible_buffer_->GetGPUVirtualAddress());
+    command_list->SetComputeRootUnorderedAccessView(kCommands, command_buffer_->GetGPUVirtualAddress());
+    command_list->SetComputeRootUnorderedAccessView(kBucketCounts, bucket_count_buffer_->GetGPUVirtualAddress());
+    command_list->SetComputeRoot32BitConstants(kOcclusionConstants, kOcclusionConstantCount, occlusion_constants, 0);
+    command_list->SetComputeRootDescriptorTable(kHiZ, hi_z);
+
+    const UINT clear_count = MathHelper::Max(group_count_, static_cast<UINT>(buckets_.size()));
+    const D3D12_RESOURCE_BARRIER uav_barrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+
+    command_list->SetPipelineState(clear_pso_.Get());
+    command_list->Dispatch((clear_count + kThreadGroupSize - 1) / kThreadGroupSize, 1, 1);
+    command_list->ResourceBarrier(1, &uav_barrier);
+
+    command_list->SetPipelineState(cull_pso_.Get());
+    command_list->Dispatch((instance_count_ + kThreadGroupSize - 1) / kThreadGroupSize, 1, 1);
+    command_list->ResourceBarrier(1, &uav_barrier);
+
+    command_list->SetPipelineState(compact_pso_.Get());
+    command_list->Dispatch((group_count_ + kThreadGroupSize - 1) / kThreadGroupSize, 1, 1);
+
+    TransitionOutputs(command_list, false);
+}
+
+void IndirectRenderer::Draw(ID3D12GraphicsCommandList* command_list, const DrawSubmission& submission, ID3D12PipelineState* const* psos)
+{
+    for (UINT i = 0; i < buckets_.size(); ++i)
+    {
+        const IndirectDrawBucket& bucket = buckets_[i];
+        const MeshGeometry* geometry = submission.Mesh(bucket.mesh);
+
+        command_list->SetPipelineState(psos[bucket.pso]);
+        command_list->IASetVertexBuffers(0, 1, &geometry->VertexBufferView());
+        command_list->IASetIndexBuffer(&geometry->IndexBufferView());
+        command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+        command_list->ExecuteIndirect(
+            command_signature_.Get(),
+            bucket.group_count,
+            command_buffer_.Get(),
+            bucket.first_group * sizeof(IndirectDrawCommand),
+            bucket_count_buffer_.Get(),
+            i * sizeof(UINT));
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void IndirectRenderer::CreateRootSignature()
+{
+    RootSignatureLayout layout;
+    layout.AddConstants(kCullConstantCount, 0);     // kCullConstants
+    layout.AddShaderResourceView(0);                // kInstances
+    layout.AddShaderResourceView(1);                // kGroups
+    layout.AddShaderResourceView(2);                // kBucketFirst
+    layout.AddUnorderedAccessView(0);               // kGroupCounts
+    layout.AddUnorderedAccessView(1);               // kVisible
+    layout.AddUnorderedAccessView(2);               // kCommands
+    layout.AddUnorderedAccessView(3);               // kBucketCounts
+    layout.AddConstants(kOcclusionConstantCount, 1); // kOcclusionConstants
+    RootDescriptorRange hi_z;
+    hi_z.base_register = 3;
+    layout.AddDescriptorTable(&hi_z, 1);            // kHiZ
+    assert(layout.Parameters().size() == kRootParameterCount);
+
+    root_signature_ = RootSignatureCache::Instance().Get(layout);
+}
+
+void IndirectRenderer::CreateNullHiZView()
+{
+    D3D12_SHADER_RESOURCE_VIEW_DESC desc = {};
+    desc.Format = DXGI_FORMAT_R32G32_FLOAT;
+    desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    desc.Texture2D.MipLevels = 1;
+    null_hi_z_view_ = BindlessDescriptorHeap::Instance().CreateShaderResourceView(nullptr, &desc);
+    assert(!null_hi_z_view_.IsNull());
+}
+
+void IndirectRenderer::CreatePipelineStates(ID3D12Device* device)
+{
+    const struct
+    {
+        const char* entry;
+        ComPtr<ID3D12PipelineState>* pso;
+    } kernels[] =
+    {
+        { "CSClearCounts", &clear_pso_ },
+        { "CSCullInstances", &cull_pso_ },
+        { "CSCompactDraws", &compact_pso_ },
+    };
+
+    for (auto& kernel : kernels)
+    {
+        ComPtr<ID3DBlob> shader = d3dUtil::CompileShader(L"indirect_culling.hlsl", nullptr, kernel.entry, "cs_5_1");
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = root_signature_.Get();
+        desc.CS = { shader->GetBufferPointer(), shader->GetBufferSize() };
+        desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+        ThrowIfFailed(device->CreateComputePipelineState(&desc, IID_PPV_ARGS(kernel.pso->GetAddressOf())));
+    }
+}
+
+void IndirectRenderer::CreateCommandSignature(ID3D12Device* device, ID3D12RootSignature* graphics_root_signature, UINT instance_base_param)
+{
+    // Layout of IndirectDrawCommand.
+    D3D12_INDIRECT_ARGUMENT_DESC arguments[2] = {};
+    arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+    arguments[0].Constant.RootParameterIndex = instance_base_param;
+    arguments[0].Constant.DestOffsetIn32BitValues = 0;
+    arguments[0].Constant.Num32BitValuesToSet = 1;
+    arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+    static_assert(sizeof(DrawIndexedArgs) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), "DrawIndexedArgs must match D3D12_DRAW_INDEXED_ARGUMENTS");
+    static_assert(sizeof(IndirectDrawCommand) == sizeof(UINT) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), "IndirectDrawCommand must be tightly packed");
+
+    D3D12_COMMAND_SIGNATURE_DESC desc = {};
+    desc.ByteStride = sizeof(IndirectDrawCommand);
+    desc.NumArgumentDescs = _countof(arguments);
+    desc.pArgumentDescs = arguments;
+    desc.NodeMask = 0;
+    ThrowIfFailed(device->CreateCommandSignature(&desc, graphics_root_signature,
+        IID_PPV_ARGS(command_signature_.GetAddressOf())));
+}
+
+ComPtr<ID3D12Resource> IndirectRenderer::CreateUavBuffer(ID3D12Device* device, UINT64 byte_size)
+{
+    ComPtr<ID3D12Resource> buffer;
+    ThrowIfFailed(device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(byte_size, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(buffer.GetAddressOf())));
+    return buffer;
+}
+
+void IndirectRenderer::TransitionOutputs(ID3D12GraphicsCommandList* command_list, bool to_unordered_access)
+{
+    if (outputs_in_unordered_access_ == to_unordered_access) return;
+
+    const D3D12_RESOURCE_STATES uav = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    const D3D12_RESOURCE_STATES srv = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    const D3D12_RESOURCE_STATES args = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+    D3D12_RESOURCE_BARRIER barriers[] =
+    {
+        CD3DX12_RESOURCE_BARRIER::Transition(visible_buffer_.Get(),
+            to_unordered_access ? srv : uav, to_unordered_access ? uav : srv),
+        CD3DX12_RESOURCE_BARRIER::Transition(command_buffer_.Get(),
+            to_unordered_access ? args : uav, to_unordered_access ? uav : args),
+        CD3DX12_RESOURCE_BARRIER::Transition(bucket_count_buffer_.Get(),
+            to_unordered_access ? args : uav, to_unordered_access ? uav : args),
+    };
+    command_list->ResourceBarrier(_countof(barriers), barriers);
+    outputs_in_unordered_access_ = to_unordered_access;
+}
@@ -0,0 +1,123 @@
+//--------------------------------------------------------------------------------
+//  indirect_renderer.h
+//  Optional GPU driven draw path: instances are uploaded once, culled and
+//  compacted by indirect_culling.hlsl, and drawn with one ExecuteIndirect per
+//  (pso, mesh) bucket.  See indirect_draw.h for the buffer layouts.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+#include "bindless_handle_table.h"
+#include "indirect_draw.h"
+
+class DrawSubmission;
+
+//--------------------------------------------------------------------------------
+//  Hi-Z pyramid (HiZBuffer) tested by the cull pass, with the view_proj of
+//  the frame it was built from (row vector convention)
+//--------------------------------------------------------------------------------
+struct HiZOcclusion
+{
+    DirectX::XMFLOAT4X4 view_proj;
+    D3D12_GPU_DESCRIPTOR_HANDLE pyramid;
+    UINT width;
+    UINT height;
+    UINT level_count;
+};
+
+class IndirectRenderer
+{
+public:
+    IndirectRenderer() = default;
+    ~IndirectRenderer();
+
+    //--------------------------------------------------------------------------------
+    //  graphics_root_signature : root signature used by the draw PSOs
+    //  instance_base_param     : its root parameter of the 32bit constant that
+    //                            receives IndirectDrawCommand::InstanceBase
+    //--------------------------------------------------------------------------------
+    void Initialize(ID3D12Device* device, ID3D12RootSignature* graphics_root_signature, UINT instance_base_param);
+
+    //--------------------------------------------------------------------------------
+    //  Upload the static instance/group data.  Call DisposeUploaders once the
+    //  command list has executed.
+    //--------------------------------------------------------------------------------
+    void Upload(ID3D12Device* device, ID3D12GraphicsCommandList* command_list, const IndirectDrawLayout& layout);
+    void DisposeUploaders();
+
+    //--------------------------------------------------------------------------------
+    //  Record the clear, cull and compaction dispatches.  The
+    //  BindlessDescriptorHeap must be set on command_list; occlusion is
+    //  optional.
+    //--------------------------------------------------------------------------------
+    void Cull(ID3D12GraphicsCommandList* command_list, const DirectX::XMFLOAT4 planes[6],
+        const HiZOcclusion* occlusion = nullptr);
+
+    //--------------------------------------------------------------------------------
+    //  Record one ExecuteIndirect per bucket.  The caller sets the graphics root
+    //  signature and binds VisibleInstanceBuffer() and the InstanceData buffer.
+    //--------------------------------------------------------------------------------
+    void Draw(ID3D12GraphicsCommandList* command_list, const DrawSubmission& submission, ID3D12PipelineState* const* psos);
+
+    //--------------------------------------------------------------------------------
+    //  uint per visible instance: index into the InstanceData buffer, read as
+    //  visible[InstanceBase + SV_InstanceID]
+    //--------------------------------------------------------------------------------
+    D3D12_GPU_VIRTUAL_ADDRESS VisibleInstanceBuffer() const { return visible_buffer_->GetGPUVirtualAddress(); }
+
+private:
+    IndirectRenderer(const IndirectRenderer& rhs) = delete;
+    IndirectRenderer& operator=(const IndirectRenderer& rhs) = delete;
+
+    enum RootParameter
+    {
+        kCullConstants = 0,
+        kInstances,
+        kGroups,
+        kBucketFirst,
+        kGroupCounts,
+        kVisible,
+        kCommands,
+        kBucketCounts,
+        kOcclusionConstants,
+        kHiZ,
+        kRootParameterCount
+    };
+
+    static constexpr UINT kThreadGroupSize = 64;
+    static constexpr UINT kCullConstantCount = 6 * 4 + 3;
+    static constexpr UINT kOcclusionConstantCount = 16 + 3;
+
+    void CreateRootSignature();
+    void CreateNullHiZView();
+    void CreatePipelineStates(ID3D12Device* device);
+    void CreateCommandSignature(ID3D12Device* device, ID3D12RootSignature* graphics_root_signature, UINT instance_base_param);
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateUavBuffer(ID3D12Device* device, UINT64 byte_size);
+    void TransitionOutputs(ID3D12GraphicsCommandList* command_list, bool to_unordered_access);
+
+    Microsoft::WRL::ComPtr<ID3D12RootSignature>  root_signature_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>  clear_pso_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>  cull_pso_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>  compact_pso_;
+    Microsoft::WRL::ComPtr<ID3D12CommandSignature> command_signature_;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> instance_buffer_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> group_buffer_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> bucket_first_buffer_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> instance_uploader_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> group_uploader_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> bucket_first_uploader_;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> group_count_buffer_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> visible_buffer_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> command_buffer_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> bucket_count_buffer_;
+    bool outputs_in_unordered_access_ = false;
+
+    // Bound to kHiZ when there is no pyramid: a null Texture2D<float2> SRV,
+    // so the table never points at a descriptor of another type.
+    BindlessHandle null_hi_z_view_;
+
+    std::vector<IndirectDrawBucket> buckets_;
+    UINT instance_count_ = 0;
+    UINT group_count_ = 0;
+};
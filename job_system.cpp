@@ -0,0 +1,370 @@
+//--------------------------------------------------------------------------------
+//  job_system.cpp
+//--------------------------------------------------------------------------------
+#include "job_system.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+JobSystem* JobSystem::instance_ = nullptr;
+
+namespace
+{
+    thread_local uint32_t t_worker_index = JobSystem::kNotWorker;
+
+    // Failed searches before a worker goes to sleep.
+    constexpr uint32_t kSpinCount = 64;
+
+    // Busy pool slots tried before a job is allocated on the heap.
+    constexpr uint32_t kJobProbeCount = 16;
+
+    uint32_t XorShift(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    //--------------------------------------------------------------------------------
+    //  One ParallelFor range.  Whoever runs it keeps halving it, pushing the
+    //  upper half as a new job, until it is below the grain.
+    //--------------------------------------------------------------------------------
+    struct RangeTask
+    {
+        void (*invoke)(void*, size_t, size_t);
+        void* context;
+        JobCounter* counter;
+        size_t begin;
+        size_t end;
+        size_t grain;
+    };
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+JobSystem* JobSystem::Create()
+{
+    if (instance_) return instance_;
+    instance_ = new JobSystem;
+    return instance_;
+}
+
+void JobSystem::Initialize(uint32_t worker_count)
+{
+    assert(!running_);
+    if (worker_count == 0) worker_count = max(1u, thread::hardware_concurrency());
+    worker_count_ = min(worker_count, kMaxWorkers);
+
+    workers_.reset(new Worker[worker_count_]);
+    for (uint32_t i = 0; i < worker_count_; ++i)
+    {
+        workers_[i].pool.reset(new Job[kJobPoolSize]);
+        workers_[i].steal_seed = 0x9e3779b9u * (i + 1);
+    }
+
+    running_ = true;
+    t_worker_index = 0;
+    for (uint32_t i = 1; i < worker_count_; ++i)
+    {
+        workers_[i].thread = thread([this, i]() { WorkerLoop(i); });
+    }
+}
+
+void JobSystem::Release()
+{
+    assert(instance_ != nullptr);
+
+    // Drain what is left, then stop the workers.
+    while (RunOneJob(0) || RunOneMainThreadJob()) {}
+    running_ = false;
+    WakeWorkers();
+    for (uint32_t i = 1; i < worker_count_; ++i)
+    {
+        if (workers_[i].thread.joinable()) workers_[i].thread.join();
+    }
+    t_worker_index = kNotWorker;
+
+    instance_ = nullptr;
+    delete this;
+}
+
+uint32_t JobSystem::CurrentWorker()
+{
+    return t_worker_index;
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    assert(t_worker_index == 0);
+    while (RunOneMainThreadJob()) {}
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    const uint32_t worker_index = t_worker_index;
+    uint32_t idle = 0;
+    while (!counter.IsDone())
+    {
+        bool ran = false;
+        if (worker_index == 0) ran = RunOneMainThreadJob();
+        if (!ran && worker_index != kNotWorker) ran = RunOneJob(worker_index);
+        if (!ran && worker_index == kNotWorker)
+        {
+            // Outside threads can only help with the shared queue.
+            Job* job = nullptr;
+            if (shared_job_count_.load(memory_order_acquire) > 0)
+            {
+                lock_guard<mutex> lock(shared_mutex_);
+                if (!shared_jobs_.empty())
+                {
+                    job = shared_jobs_.back();
+                    shared_jobs_.pop_back();
+                    shared_job_count_.fetch_sub(1, memory_order_release);
+                }
+            }
+            if (job)
+            {
+                Execute(job);
+                ran = true;
+            }
+        }
+
+        if (ran) idle = 0;
+        else if (++idle > kSpinCount) this_thread::yield();
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+bool JobSystem::WorkStealingDeque::Push(Job* job)
+{
+    const int64_t bottom = bottom_.load(memory_order_relaxed);
+    const int64_t top = top_.load(memory_order_acquire);
+    if (bottom - top >= static_cast<int64_t>(kDequeCapacity)) return false;
+
+    // A release store rather than a release fence: same ordering, and
+    // ThreadSanitizer (which does not model fences) sees the job publication.
+    buffer_[bottom & (kDequeCapacity - 1)].store(job, memory_order_relaxed);
+    bottom_.store(bottom + 1, memory_order_release);
+    return true;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::Pop()
+{
+    const int64_t bottom = bottom_.load(memory_order_relaxed) - 1;
+    bottom_.store(bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = top_.load(memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        bottom_.store(bottom + 1, memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer_[bottom & (kDequeCapacity - 1)].load(memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last job: race the thieves for it.
+        if (!top_.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed)) job = nullptr;
+        bottom_.store(bottom + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::Steal()
+{
+    int64_t top = top_.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(memory_order_acquire);
+    if (top >= bottom) return nullptr;
+
+    Job* job = buffer_[top & (kDequeCapacity - 1)].load(memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed)) return nullptr;
+    return job;
+}
+
+JobSystem::Job* JobSystem::AllocateJob()
+{
+    const uint32_t worker_index = t_worker_index;
+    if (worker_index == kNotWorker)
+    {
+        Job* job = new Job;
+        job->heap = true;
+        return job;
+    }
+
+    // Ring of jobs per worker.  Slots whose job has not finished are skipped;
+    // waiting for them could deadlock when the job is further up this
+    // thread's stack (nested Wait).
+    Worker& worker = workers_[worker_index];
+    for (uint32_t probe = 0; probe < kJobProbeCount; ++probe)
+    {
+        Job* job = &worker.pool[worker.pool_cursor++ & (kJobPoolSize - 1)];
+        if (!job->pending.load(memory_order_acquire))
+        {
+            job->pending.store(true, memory_order_relaxed);
+            return job;
+        }
+    }
+
+    Job* job = new Job;
+    job->heap = true;
+    return job;
+}
+
+void JobSystem::Submit(Job* job)
+{
+    const uint32_t worker_index = t_worker_index;
+    if (worker_index == kNotWorker)
+    {
+        lock_guard<mutex> lock(shared_mutex_);
+        shared_jobs_.push_back(job);
+        shared_job_count_.fetch_add(1, memory_order_release);
+    }
+    else if (!workers_[worker_index].deque.Push(job))
+    {
+        // Deque full: run it now rather than block.
+        Execute(job);
+        return;
+    }
+    WakeWorkers();
+}
+
+void JobSystem::Execute(Job* job)
+{
+    job->invoke(*job);
+    JobCounter* counter = job->counter;
+    if (job->heap) delete job;
+    else job->pending.store(false, memory_order_release);
+    if (counter) counter->count_.fetch_sub(1, memory_order_acq_rel);
+}
+
+JobSystem::Job* JobSystem::FindJob(uint32_t worker_index)
+{
+    Worker& worker = workers_[worker_index];
+    if (Job* job = worker.deque.Pop()) return job;
+
+    if (shared_job_count_.load(memory_order_acquire) > 0)
+    {
+        lock_guard<mutex> lock(shared_mutex_);
+        if (!shared_jobs_.empty())
+        {
+            Job* job = shared_jobs_.back();
+            shared_jobs_.pop_back();
+            shared_job_count_.fetch_sub(1, memory_order_release);
+            return job;
+        }
+    }
+
+    // Steal starting from a random victim.
+    if (worker_count_ > 1)
+    {
+        const uint32_t first = XorShift(worker.steal_seed) % worker_count_;
+        for (uint32_t i = 0; i < worker_count_; ++i)
+        {
+            const uint32_t victim = (first + i) % worker_count_;
+            if (victim == worker_index) continue;
+            if (Job* job = workers_[victim].deque.Steal()) return job;
+        }
+    }
+    return nullptr;
+}
+
+bool JobSystem::RunOneJob(uint32_t worker_index)
+{
+    Job* job = FindJob(worker_index);
+    if (!job) return false;
+    Execute(job);
+    return true;
+}
+
+bool JobSystem::RunOneMainThreadJob()
+{
+    Job* job = nullptr;
+    {
+        lock_guard<mutex> lock(main_thread_mutex_);
+        if (main_thread_jobs_.empty()) return false;
+        job = main_thread_jobs_.front();
+        main_thread_jobs_.erase(main_thread_jobs_.begin());
+    }
+    Execute(job);
+    return true;
+}
+
+void JobSystem::WorkerLoop(uint32_t worker_index)
+{
+    t_worker_index = worker_index;
+    uint32_t idle = 0;
+    while (running_.load(memory_order_acquire))
+    {
+        // Read the epoch before searching so a submit during the search is not missed.
+        const uint32_t epoch = epoch_.load(memory_order_acquire);
+        if (RunOneJob(worker_index))
+        {
+            idle = 0;
+            continue;
+        }
+        if (++idle < kSpinCount)
+        {
+            this_thread::yield();
+            continue;
+        }
+
+        unique_lock<mutex> lock(sleep_mutex_);
+        sleeping_.fetch_add(1, memory_order_seq_cst);
+        sleep_condition_.wait(lock, [this, epoch]()
+        {
+            return epoch_.load(memory_order_acquire) != epoch || !running_.load(memory_order_acquire);
+        });
+        sleeping_.fetch_sub(1, memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+void JobSystem::WakeWorkers()
+{
+    epoch_.fetch_add(1, memory_order_seq_cst);
+    if (sleeping_.load(memory_order_seq_cst) > 0 || !running_.load(memory_order_relaxed))
+    {
+        { lock_guard<mutex> lock(sleep_mutex_); }
+        sleep_condition_.notify_all();
+    }
+}
+
+void JobSystem::ParallelForImpl(size_t count, size_t min_chunk, void (*invoke)(void*, size_t, size_t), void* context)
+{
+    if (count == 0) return;
+    const size_t grain = max<size_t>(max<size_t>(min_chunk, 1), count / (4 * static_cast<size_t>(max(worker_count_, 1u))));
+    if (count <= grain || worker_count_ <= 1)
+    {
+        invoke(context, 0, count);
+        return;
+    }
+
+    JobCounter counter;
+    struct Splitter
+    {
+        static void Run(JobSystem& system, RangeTask task)
+        {
+            while (task.end - task.begin > task.grain)
+            {
+                RangeTask upper = task;
+                upper.begin = task.begin + (task.end - task.begin) / 2;
+                task.end = upper.begin;
+                system.Run([&system, upper]() { Run(system, upper); }, upper.counter);
+            }
+            task.invoke(task.context, task.begin, task.end);
+        }
+    };
+    Splitter::Run(*this, RangeTask{ invoke, context, &counter, 0, count, grain });
+    Wait(counter);
+}
@@ -0,0 +1,226 @@
+//--------------------------------------------------------------------------------
+//  job_system.h
+//  Shared job scheduler (portable C++17, no platform headers).
+//  - One Chase-Lev work stealing deque per worker; the thread that calls
+//    Initialize is worker 0 and runs jobs while it waits.
+//  - JobCounter tracks a group of jobs.  Wait() keeps executing other jobs
+//    until the counter reaches zero instead of blocking the thread.
+//  - ParallelFor splits ranges lazily in halves down to an adaptive grain.
+//  - Main thread affine jobs run only on worker 0, from RunMainThreadJobs or
+//    while worker 0 waits.
+//  Threads that are not workers may submit jobs; they go to a shared queue.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------------
+//  Number of unfinished jobs of a group
+//--------------------------------------------------------------------------------
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    bool IsDone() const { return count_.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    JobCounter(const JobCounter& rhs) = delete;
+    JobCounter& operator=(const JobCounter& rhs) = delete;
+
+    std::atomic<uint32_t> count_{ 0 };
+};
+
+class JobSystem
+{
+public:
+    static constexpr uint32_t kMaxWorkers = 64;
+    static constexpr uint32_t kDequeCapacity = 4096;    // per worker, power of 2
+    static constexpr uint32_t kJobPoolSize = 4096;      // per worker, power of 2
+    static constexpr size_t   kJobStorage = 96;         // inline callable size (Job is 128 bytes)
+
+    //--------------------------------------------------------------------------------
+    //  Create / Instance / Release, like the other systems
+    //--------------------------------------------------------------------------------
+    static JobSystem* Create();
+    static JobSystem& Instance() { return *instance_; }
+    static bool IsCreated() { return instance_ != nullptr; }
+
+    //--------------------------------------------------------------------------------
+    //  worker_count 0 : one worker per hardware thread (including the caller)
+    //--------------------------------------------------------------------------------
+    void Initialize(uint32_t worker_count = 0);
+    void Release();
+
+    uint32_t WorkerCount() const { return worker_count_; }
+
+    //--------------------------------------------------------------------------------
+    //  Worker index of the calling thread, kNotWorker for other threads
+    //--------------------------------------------------------------------------------
+    static constexpr uint32_t kNotWorker = 0xffffffff;
+    static uint32_t CurrentWorker();
+
+    //--------------------------------------------------------------------------------
+    //  Submit function() as a job.  counter (optional) is incremented now and
+    //  decremented when the job finishes.
+    //--------------------------------------------------------------------------------
+    template <class Function>
+    void Run(Function&& function, JobCounter* counter = nullptr)
+    {
+        Job* job = AllocateJob();
+        Bind(*job, std::forward<Function>(function), counter);
+        Submit(job);
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Same as Run, but the job only ever runs on worker 0 (the main thread)
+    //--------------------------------------------------------------------------------
+    template <class Function>
+    void RunOnMainThread(Function&& function, JobCounter* counter = nullptr)
+    {
+        Job* job = new Job;
+        job->heap = true;
+        Bind(*job, std::forward<Function>(function), counter);
+        std::lock_guard<std::mutex> lock(main_thread_mutex_);
+        main_thread_jobs_.push_back(job);
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Execute queued main thread jobs.  Call from the main thread once per frame.
+    //--------------------------------------------------------------------------------
+    void RunMainThreadJobs();
+
+    //--------------------------------------------------------------------------------
+    //  Execute other jobs until every job of counter has finished
+    //--------------------------------------------------------------------------------
+    void Wait(const JobCounter& counter);
+
+    //--------------------------------------------------------------------------------
+    //  function(begin, end) over [0, count) in parallel and wait for it.
+    //  Ranges are halved until they are below the grain:
+    //  max(min_chunk, count / (4 * WorkerCount())).
+    //--------------------------------------------------------------------------------
+    template <class Function>
+    void ParallelFor(size_t count, Function&& function, size_t min_chunk = 1)
+    {
+        using Decayed = typename std::decay<Function>::type;
+        ParallelForImpl(count, min_chunk, [](void* context, size_t begin, size_t end)
+        {
+            (*static_cast<Decayed*>(context))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(std::addressof(function))));
+    }
+
+private:
+    //--------------------------------------------------------------------------------
+    //  Job with inline storage for the callable (heap fallback when too big)
+    //--------------------------------------------------------------------------------
+    struct alignas(64) Job
+    {
+        void (*invoke)(Job& job) = nullptr;
+        JobCounter* counter = nullptr;
+        std::atomic<bool> pending{ false };
+        bool heap = false;
+        alignas(16) unsigned char storage[kJobStorage];
+    };
+    static_assert(sizeof(Job) == 128, "Job should stay two cache lines");
+
+    //--------------------------------------------------------------------------------
+    //  Chase-Lev deque (Le et al. 2013, fixed capacity).  Push/Pop by the
+    //  owner, Steal by any thread.
+    //--------------------------------------------------------------------------------
+    class WorkStealingDeque
+    {
+    public:
+        bool Push(Job* job);
+        Job* Pop();
+        Job* Steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> top_{ 0 };
+        alignas(64) std::atomic<int64_t> bottom_{ 0 };
+        std::atomic<Job*> buffer_[kDequeCapacity];
+    };
+
+    struct Worker
+    {
+        WorkStealingDeque deque;
+        std::unique_ptr<Job[]> pool;
+        uint32_t pool_cursor = 0;
+        uint32_t steal_seed = 0;
+        std::thread thread;
+    };
+
+    JobSystem() = default;
+    ~JobSystem() = default;
+    JobSystem(const JobSystem& rhs) = delete;
+    JobSystem& operator=(const JobSystem& rhs) = delete;
+
+    template <class Function>
+    static void Bind(Job& job, Function&& function, JobCounter* counter)
+    {
+        using Decayed = typename std::decay<Function>::type;
+        if constexpr (sizeof(Decayed) <= kJobStorage && alignof(Decayed) <= 16)
+        {
+            new (job.storage) Decayed(std::forward<Function>(function));
+            job.invoke = [](Job& self)
+            {
+                Decayed* callable = std::launder(reinterpret_cast<Decayed*>(self.storage));
+                (*callable)();
+                callable->~Decayed();
+            };
+        }
+        else
+        {
+            Decayed* callable = new Decayed(std::forward<Function>(function));
+            new (job.storage) Decayed*(callable);
+            job.invoke = [](Job& self)
+            {
+                Decayed* callable = *std::launder(reinterpret_cast<Decayed**>(self.storage));
+                (*callable)();
+                delete callable;
+            };
+        }
+
+        job.counter = counter;
+        if (counter) counter->count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Job* AllocateJob();
+    void Submit(Job* job);
+    void Execute(Job* job);
+    Job* FindJob(uint32_t worker_index);
+    bool RunOneJob(uint32_t worker_index);
+    bool RunOneMainThreadJob();
+    void WorkerLoop(uint32_t worker_index);
+    void WakeWorkers();
+    void ParallelForImpl(size_t count, size_t min_chunk, void (*invoke)(void*, size_t, size_t), void* context);
+
+    std::unique_ptr<Worker[]> workers_;
+    uint32_t worker_count_ = 0;
+    std::atomic<bool> running_{ false };
+
+    // Jobs from threads that are not workers.
+    std::mutex shared_mutex_;
+    std::vector<Job*> shared_jobs_;
+    std::atomic<uint32_t> shared_job_count_{ 0 };
+
+    std::mutex main_thread_mutex_;
+    std::vector<Job*> main_thread_jobs_;
+
+    // Idle workers sleep until the epoch changes.
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_condition_;
+    std::atomic<uint32_t> epoch_{ 0 };
+    std::atomic<uint32_t> sleeping_{ 0 };
+
+    static JobSystem* instance_;
+};
@@ -0,0 +1,357 @@
+//--------------------------------------------------------------------------------
+//  light_cluster_grid.cpp
+//--------------------------------------------------------------------------------
+#include "light_cluster_grid.h"
+#include "d3dUtil.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr size_t kMinLightsPerJob = 256;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void LightClusterGrid::SetProjection(const XMFLOAT4X4& proj, float near_z, float far_z, uint32_t width, uint32_t height)
+{
+    // View depth is clip w, as in XMMatrixPerspectiveFovLH / OffCenterLH.
+    assert(proj.m[0][3] == 0.0f && proj.m[1][3] == 0.0f && proj.m[2][3] == 1.0f && proj.m[3][3] == 0.0f);
+    assert(near_z > 0.0f && far_z > near_z && width > 0 && height > 0);
+    proj_ = proj;
+    near_z_ = near_z;
+    far_z_ = far_z;
+    width_ = width;
+    height_ = height;
+    grid_x_ = (width + kTileSize - 1) / kTileSize;
+    grid_y_ = (height + kTileSize - 1) / kTileSize;
+    row_pitch_ = (grid_x_ + 3) & ~3u;
+
+    const float log_ratio = log2f(far_z / near_z);
+    depth_scale_ = static_cast<float>(kSliceCount) / log_ratio;
+    depth_bias_ = -depth_scale_ * log2f(near_z);
+
+    const size_t size = static_cast<size_t>(row_pitch_) * grid_y_ * kSliceCount;
+    min_x_.assign(size, FLT_MAX);
+    min_y_.assign(size, FLT_MAX);
+    min_z_.assign(size, FLT_MAX);
+    max_x_.assign(size, -FLT_MAX);
+    max_y_.assign(size, -FLT_MAX);
+    max_z_.assign(size, -FLT_MAX);
+    sphere_x_.assign(size, 0.0f);
+    sphere_y_.assign(size, 0.0f);
+    sphere_z_.assign(size, 0.0f);
+    sphere_radius_.assign(size, 0.0f);
+
+    // Each froxel is bounded by the 8 corners of its tile at the depths of its slice.
+    for (uint32_t slice = 0; slice < kSliceCount; ++slice)
+    {
+        const float depths[2] =
+        {
+            near_z * powf(far_z / near_z, static_cast<float>(slice) / kSliceCount),
+            near_z * powf(far_z / near_z, static_cast<float>(slice + 1) / kSliceCount),
+        };
+        for (uint32_t y = 0; y < grid_y_; ++y)
+        {
+            const float ndc_y[2] =
+            {
+                1.0f - 2.0f * (y * kTileSize) / height,
+                1.0f - 2.0f * min((y + 1) * kTileSize, height) / height,
+            };
+            for (uint32_t x = 0; x < grid_x_; ++x)
+            {
+                const float ndc_x[2] =
+                {
+                    2.0f * (x * kTileSize) / width - 1.0f,
+                    2.0f * min((x + 1) * kTileSize, width) / width - 1.0f,
+                };
+
+                XMFLOAT3 lower(FLT_MAX, FLT_MAX, FLT_MAX);
+                XMFLOAT3 upper(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    const float z = depths[corner >> 2];
+                    const float view_x = (ndc_x[corner & 1] - proj.m[2][0]) * z / proj.m[0][0];
+                    const float view_y = (ndc_y[(corner >> 1) & 1] - proj.m[2][1]) * z / proj.m[1][1];
+                    lower = XMFLOAT3(min(lower.x, view_x), min(lower.y, view_y), min(lower.z, z));
+                    upper = XMFLOAT3(max(upper.x, view_x), max(upper.y, view_y), max(upper.z, z));
+                }
+
+                const size_t i = (static_cast<size_t>(slice) * grid_y_ + y) * row_pitch_ + x;
+                min_x_[i] = lower.x;
+                min_y_[i] = lower.y;
+                min_z_[i] = lower.z;
+                max_x_[i] = upper.x;
+                max_y_[i] = upper.y;
+                max_z_[i] = upper.z;
+                sphere_x_[i] = (lower.x + upper.x) * 0.5f;
+                sphere_y_[i] = (lower.y + upper.y) * 0.5f;
+                sphere_z_[i] = (lower.z + upper.z) * 0.5f;
+                sphere_radius_[i] = 0.5f * sqrtf((upper.x - lower.x) * (upper.x - lower.x)
+                    + (upper.y - lower.y) * (upper.y - lower.y)
+                    + (upper.z - lower.z) * (upper.z - lower.z));
+            }
+        }
+    }
+
+    clusters_.assign(static_cast<size_t>(grid_x_) * grid_y_ * kSliceCount, LightCluster());
+    light_indices_.clear();
+}
+
+void LightClusterGrid::Build(FXMMATRIX view, const Light* lights, uint32_t point_count, uint32_t spot_count)
+{
+    assert(grid_x_ > 0 && "SetProjection must be called first");
+    const uint32_t light_count = point_count + spot_count;
+    assert(light_count <= kMaxLights);
+    point_count_ = point_count;
+    view_lights_.resize(light_count);
+
+    // View space bounds and the clusters each light may reach.
+    auto setup = [this, &view, lights](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            SetupLight(view, lights[i], i >= point_count_, &view_lights_[i]);
+        }
+    };
+    const bool parallel = JobSystem::IsCreated() && JobSystem::Instance().WorkerCount() > 1;
+    if (parallel) JobSystem::Instance().ParallelFor(light_count, setup, kMinLightsPerJob);
+    else setup(0, light_count);
+
+    // Lights per slice, in light order so points come before spots.
+    for (auto& list : slice_lights_) list.clear();
+    for (uint32_t i = 0; i < light_count; ++i)
+    {
+        const ViewLight& light = view_lights_[i];
+        if (light.x_begin >= light.x_end || light.y_begin >= light.y_end) continue;
+        for (uint32_t slice = light.slice_begin; slice < light.slice_end; ++slice)
+        {
+            slice_lights_[slice].push_back(i);
+        }
+    }
+
+    // Slices own disjoint clusters, so they are assigned in parallel.
+    if (parallel)
+    {
+        JobSystem::Instance().ParallelFor(kSliceCount, [this](size_t begin, size_t end)
+        {
+            for (size_t slice = begin; slice < end; ++slice) BuildSlice(static_cast<uint32_t>(slice));
+        });
+    }
+    else
+    {
+        for (uint32_t slice = 0; slice < kSliceCount; ++slice) BuildSlice(slice);
+    }
+
+    // Concatenate the slices; their offsets were relative to the slice.
+    size_t total = 0;
+    for (const SliceScratch& scratch : slice_scratch_) total += scratch.indices.size();
+    light_indices_.resize(total);
+
+    const size_t clusters_per_slice = static_cast<size_t>(grid_x_) * grid_y_;
+    uint32_t base = 0;
+    for (uint32_t slice = 0; slice < kSliceCount; ++slice)
+    {
+        const vector<uint32_t>& indices = slice_scratch_[slice].indices;
+        LightCluster* cluster = clusters_.data() + slice * clusters_per_slice;
+        for (size_t i = 0; i < clusters_per_slice; ++i) cluster[i].offset += base;
+        copy(indices.begin(), indices.end(), light_indices_.begin() + base);
+        base += static_cast<uint32_t>(indices.size());
+    }
+}
+
+void LightClusterGrid::ClusterBounds(uint32_t cluster, XMFLOAT3* min_corner, XMFLOAT3* max_corner) const
+{
+    const uint32_t x = cluster % grid_x_;
+    const uint32_t row = cluster / grid_x_;
+    const size_t i = static_cast<size_t>(row) * row_pitch_ + x;
+    *min_corner = XMFLOAT3(min_x_[i], min_y_[i], min_z_[i]);
+    *max_corner = XMFLOAT3(max_x_[i], max_y_[i], max_z_[i]);
+}
+
+bool LightClusterGrid::IntersectsCluster(FXMMATRIX view, const Light& light, bool spot, uint32_t cluster) const
+{
+    ViewLight l;
+    SetupLight(view, light, spot, &l);
+    const uint32_t x = cluster % grid_x_;
+    const uint32_t y = cluster / grid_x_ % grid_y_;
+    const uint32_t slice = cluster / grid_x_ / grid_y_;
+    if (x < l.x_begin || x >= l.x_end || y < l.y_begin || y >= l.y_end || slice < l.slice_begin || slice >= l.slice_end) return false;
+    const size_t i = static_cast<size_t>(cluster / grid_x_) * row_pitch_ + x;
+
+    // Sphere against the box.
+    const float dx = max(max(min_x_[i] - l.center.x, l.center.x - max_x_[i]), 0.0f);
+    const float dy = max(max(min_y_[i] - l.center.y, l.center.y - max_y_[i]), 0.0f);
+    const float dz = max(max(min_z_[i] - l.center.z, l.center.z - max_z_[i]), 0.0f);
+    if (dx * dx + dy * dy + dz * dz > l.radius * l.radius) return false;
+    if (!spot) return true;
+
+    // Cone against the bounding sphere of the box.
+    const float vx = sphere_x_[i] - l.center.x;
+    const float vy = sphere_y_[i] - l.center.y;
+    const float vz = sphere_z_[i] - l.center.z;
+    const float length_sq = vx * vx + vy * vy + vz * vz;
+    const float along = vx * l.direction.x + vy * l.direction.y + vz * l.direction.z;
+    const float distance = l.cos_angle * sqrtf(max(length_sq - along * along, 0.0f)) - along * l.sin_angle;
+    const float radius = sphere_radius_[i];
+    return !(distance > radius || along > radius + l.radius || along < -radius);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void LightClusterGrid::SetupLight(FXMMATRIX view, const Light& light, bool spot, ViewLight* out) const
+{
+    XMStoreFloat3(&out->center, XMVector3Transform(XMLoadFloat3(&light.Position), view));
+    out->radius = light.FalloffEnd;
+    out->spot = spot;
+    if (spot)
+    {
+        // The cone where the spot factor pow(cos, SpotPower) is above the cutoff.
+        XMStoreFloat3(&out->direction, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&light.Direction), view)));
+        out->cos_angle = min(max(powf(kSpotCutoff, 1.0f / max(light.SpotPower, 1e-3f)), 0.0f), 1.0f);
+        out->sin_angle = sqrtf(1.0f - out->cos_angle * out->cos_angle);
+    }
+
+    out->x_begin = out->x_end = out->y_begin = out->y_end = 0;
+    out->slice_begin = out->slice_end = 0;
+    const XMFLOAT3& c = out->center;
+    const float r = out->radius;
+    if (c.z + r < near_z_ || c.z - r > far_z_) return;
+
+    // The sphere's box projects inside the extremes of its corners' x / z
+    // and y / z, all in front of the near plane.
+    const float z[2] = { max(c.z - r, near_z_), c.z + r };
+    float ndc_min_x = FLT_MAX, ndc_max_x = -FLT_MAX;
+    float ndc_min_y = FLT_MAX, ndc_max_y = -FLT_MAX;
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        const float inverse_z = 1.0f / z[corner >> 1];
+        const float sign = (corner & 1) ? 1.0f : -1.0f;
+        const float ndc_x = (c.x + sign * r) * proj_.m[0][0] * inverse_z + proj_.m[2][0];
+        const float ndc_y = (c.y + sign * r) * proj_.m[1][1] * inverse_z + proj_.m[2][1];
+        ndc_min_x = min(ndc_min_x, ndc_x);
+        ndc_max_x = max(ndc_max_x, ndc_x);
+        ndc_min_y = min(ndc_min_y, ndc_y);
+        ndc_max_y = max(ndc_max_y, ndc_y);
+    }
+    if (ndc_max_x < -1.0f || ndc_min_x > 1.0f || ndc_max_y < -1.0f || ndc_min_y > 1.0f) return;
+
+    auto tile = [](float pixels, uint32_t count)
+    {
+        return static_cast<uint32_t>(min(max(pixels / kTileSize, 0.0f), static_cast<float>(count - 1)));
+    };
+    out->x_begin = tile((ndc_min_x * 0.5f + 0.5f) * width_, grid_x_);
+    out->x_end = tile((ndc_max_x * 0.5f + 0.5f) * width_, grid_x_) + 1;
+    out->y_begin = tile((0.5f - ndc_max_y * 0.5f) * height_, grid_y_);
+    out->y_end = tile((0.5f - ndc_min_y * 0.5f) * height_, grid_y_) + 1;
+    out->slice_begin = Slice(c.z - r);
+    out->slice_end = Slice(c.z + r) + 1;
+}
+
+void LightClusterGrid::BuildSlice(uint32_t slice)
+{
+    SliceScratch& scratch = slice_scratch_[slice];
+    const size_t clusters_per_slice = static_cast<size_t>(grid_x_) * grid_y_;
+    scratch.cluster_lights.resize(clusters_per_slice);
+    for (auto& list : scratch.cluster_lights) list.clear();
+
+    for (uint32_t light_index : slice_lights_[slice])
+    {
+        const ViewLight& light = view_lights_[light_index];
+        const XMVECTOR center_x = XMVectorReplicate(light.center.x);
+        const XMVECTOR center_y = XMVectorReplicate(light.center.y);
+        const XMVECTOR center_z = XMVectorReplicate(light.center.z);
+        const XMVECTOR radius_sq = XMVectorReplicate(light.radius * light.radius);
+        const XMVECTOR direction_x = XMVectorReplicate(light.direction.x);
+        const XMVECTOR direction_y = XMVectorReplicate(light.direction.y);
+        const XMVECTOR direction_z = XMVectorReplicate(light.direction.z);
+        const XMVECTOR cos_angle = XMVectorReplicate(light.cos_angle);
+        const XMVECTOR sin_angle = XMVectorReplicate(light.sin_angle);
+        const XMVECTOR range = XMVectorReplicate(light.radius);
+
+        // 4 clusters of a row per iteration, same tests as IntersectsCluster.
+        for (uint32_t y = light.y_begin; y < light.y_end; ++y)
+        {
+            const size_t row = (static_cast<size_t>(slice) * grid_y_ + y) * row_pitch_;
+            for (uint32_t x = light.x_begin & ~3u; x < light.x_end; x += 4)
+            {
+                const size_t i = row + x;
+                auto load = [i](const vector<float>& v) { return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&v[i])); };
+
+                const XMVECTOR zero = XMVectorZero();
+                XMVECTOR dx = XMVectorMax(XMVectorMax(XMVectorSubtract(load(min_x_), center_x), XMVectorSubtract(center_x, load(max_x_))), zero);
+                XMVECTOR dy = XMVectorMax(XMVectorMax(XMVectorSubtract(load(min_y_), center_y), XMVectorSubtract(center_y, load(max_y_))), zero);
+                XMVECTOR dz = XMVectorMax(XMVectorMax(XMVectorSubtract(load(min_z_), center_z), XMVectorSubtract(center_z, load(max_z_))), zero);
+                XMVECTOR distance_sq = XMVectorMultiply(dx, dx);
+                distance_sq = XMVectorMultiplyAdd(dy, dy, distance_sq);
+                distance_sq = XMVectorMultiplyAdd(dz, dz, distance_sq);
+                XMVECTOR inside = XMVectorLessOrEqual(distance_sq, radius_sq);
+
+                if (light.spot)
+                {
+                    const XMVECTOR vx = XMVectorSubtract(load(sphere_x_), center_x);
+                    const XMVECTOR vy = XMVectorSubtract(load(sphere_y_), center_y);
+                    const XMVECTOR vz = XMVectorSubtract(load(sphere_z_), center_z);
+                    const XMVECTOR radius = load(sphere_radius_);
+                    XMVECTOR length_sq = XMVectorMultiply(vx, vx);
+                    length_sq = XMVectorMultiplyAdd(vy, vy, length_sq);
+                    length_sq = XMVectorMultiplyAdd(vz, vz, length_sq);
+                    XMVECTOR along = XMVectorMultiply(vx, direction_x);
+                    along = XMVectorMultiplyAdd(vy, direction_y, along);
+                    along = XMVectorMultiplyAdd(vz, direction_z, along);
+                    const XMVECTOR side = XMVectorSqrt(XMVectorMax(XMVectorNegativeMultiplySubtract(along, along, length_sq), zero));
+                    const XMVECTOR distance = XMVectorNegativeMultiplySubtract(along, sin_angle, XMVectorMultiply(cos_angle, side));
+
+                    XMVECTOR outside = XMVectorGreater(distance, radius);
+                    outside = XMVectorOrInt(outside, XMVectorGreater(along, XMVectorAdd(radius, range)));
+                    outside = XMVectorOrInt(outside, XMVectorLess(along, XMVectorNegate(radius)));
+                    inside = XMVectorAndCInt(inside, outside);
+                }
+
+                XMUINT4 mask;
+                XMStoreUInt4(&mask, inside);
+                const uint32_t* lane = &mask.x;
+                for (uint32_t j = 0; j < 4; ++j)
+                {
+                    const uint32_t cluster_x = x + j;
+                    if (lane[j] != 0 && cluster_x >= light.x_begin && cluster_x < light.x_end)
+                    {
+                        scratch.cluster_lights[y * grid_x_ + cluster_x].push_back(light_index);
+                    }
+                }
+            }
+        }
+    }
+
+    // Pack the slice; lists are in light order, so points come first.
+    scratch.indices.clear();
+    LightCluster* clusters = clusters_.data() + slice * clusters_per_slice;
+    for (size_t i = 0; i < clusters_per_slice; ++i)
+    {
+        const vector<uint32_t>& list = scratch.cluster_lights[i];
+        const size_t points = lower_bound(list.begin(), list.end(), point_count_) - list.begin();
+        clusters[i].offset = static_cast<uint32_t>(scratch.indices.size());
+        clusters[i].point_count = static_cast<uint16_t>(points);
+        clusters[i].spot_count = static_cast<uint16_t>(list.size() - points);
+        scratch.indices.insert(scratch.indices.end(), list.begin(), list.end());
+    }
+}
+
+uint32_t LightClusterGrid::Slice(float view_z) const
+{
+    if (view_z <= near_z_) return 0;
+    const float slice = floorf(log2f(view_z) * depth_scale_ + depth_bias_);
+    return static_cast<uint32_t>(min(max(slice, 0.0f), static_cast<float>(kSliceCount - 1)));
+}
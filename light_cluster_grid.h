@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------------
+//  light_cluster_grid.h
+//  Clustered forward light assignment (CPU only).  The view frustum is split
+//  into froxels: screen tiles of kTileSize pixels times kSliceCount slices
+//  exponential in view depth.
+//  Every frame each point / spot Light (d3dUtil.h) is tested against the
+//  froxels its bounds can reach, and the result is packed for the GPU:
+//  - Clusters()     : one LightCluster per froxel, x fastest, then y, then z
+//  - LightIndices() : per cluster, its point lights then its spot lights,
+//                     as indices into the Light array given to Build
+//  Shaders find their cluster with light_cluster_grid.hlsli, so the cost of
+//  a pixel follows the lights of its cluster, not the lights of the scene.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Light;
+
+struct LightCluster                 // uint2 in light_cluster_grid.hlsli
+{
+    uint32_t offset;                // first entry of LightIndices()
+    uint16_t point_count;
+    uint16_t spot_count;
+};
+
+class LightClusterGrid
+{
+public:
+    static constexpr uint32_t kTileSize = 64;               // pixels
+    static constexpr uint32_t kSliceCount = 24;
+    static constexpr uint32_t kMaxLights = 0xffff;          // counts are 16 bits
+
+    // Spot lights end where pow(cos, SpotPower) falls below this.
+    static constexpr float kSpotCutoff = 1.0f / 256.0f;
+
+    //--------------------------------------------------------------------------------
+    //  Froxel bounds for a perspective projection (row vector convention,
+    //  D3D clip space, e.g. XMMatrixPerspectiveFovLH) over the view depth
+    //  range [near_z, far_z] of a width x height viewport.  Call again when
+    //  any of them changes.
+    //--------------------------------------------------------------------------------
+    void SetProjection(const DirectX::XMFLOAT4X4& proj, float near_z, float far_z, uint32_t width, uint32_t height);
+
+    //--------------------------------------------------------------------------------
+    //  lights : point_count point lights followed by spot_count spot lights
+    //           (directional lights reach every cluster and are not passed).
+    //  Runs on the JobSystem when it has been created.
+    //--------------------------------------------------------------------------------
+    void Build(DirectX::FXMMATRIX view, const Light* lights, uint32_t point_count, uint32_t spot_count);
+
+    const std::vector<LightCluster>& Clusters() const { return clusters_; }
+    const std::vector<uint32_t>& LightIndices() const { return light_indices_; }
+
+    uint32_t GridWidth() const { return grid_x_; }
+    uint32_t GridHeight() const { return grid_y_; }
+    uint32_t ClusterIndex(uint32_t x, uint32_t y, uint32_t slice) const { return (slice * grid_y_ + y) * grid_x_ + x; }
+
+    //--------------------------------------------------------------------------------
+    //  Slice of a view depth: floor(log2(z) * DepthScale() + DepthBias())
+    //--------------------------------------------------------------------------------
+    float DepthScale() const { return depth_scale_; }
+    float DepthBias() const { return depth_bias_; }
+
+    //--------------------------------------------------------------------------------
+    //  View space bounds of a cluster, and the scalar test Build uses for
+    //  one light (for checks against a brute force assignment)
+    //--------------------------------------------------------------------------------
+    void ClusterBounds(uint32_t cluster, DirectX::XMFLOAT3* min_corner, DirectX::XMFLOAT3* max_corner) const;
+    bool IntersectsCluster(DirectX::FXMMATRIX view, const Light& light, bool spot, uint32_t cluster) const;
+
+private:
+    struct ViewLight
+    {
+        DirectX::XMFLOAT3 center;       // view space
+        float radius;
+        DirectX::XMFLOAT3 direction;    // spot only
+        float cos_angle;
+        float sin_angle;
+        bool spot;
+        uint32_t x_begin, x_end;        // clusters the bounds may reach
+        uint32_t y_begin, y_end;
+        uint32_t slice_begin, slice_end;
+    };
+
+    struct SliceScratch
+    {
+        std::vector<std::vector<uint32_t>> cluster_lights;
+        std::vector<uint32_t> indices;
+    };
+
+    void SetupLight(DirectX::FXMMATRIX view, const Light& light, bool spot, ViewLight* out) const;
+    void BuildSlice(uint32_t slice);
+    uint32_t Slice(float view_z) const;
+
+    // Projection
+    DirectX::XMFLOAT4X4 proj_;
+    float near_z_ = 0.0f;
+    float far_z_ = 0.0f;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t grid_x_ = 0;
+    uint32_t grid_y_ = 0;
+    uint32_t row_pitch_ = 0;        // grid_x_ padded to 4 for the SIMD tests
+    float depth_scale_ = 0.0f;
+    float depth_bias_ = 0.0f;
+
+    // Cluster bounds in SoA form, rows of row_pitch_; padding never intersects.
+    std::vector<float> min_x_, min_y_, min_z_;
+    std::vector<float> max_x_, max_y_, max_z_;
+    std::vector<float> sphere_x_, sphere_y_, sphere_z_, sphere_radius_;
+
+    // Per frame
+    std::vector<ViewLight> view_lights_;
+    std::vector<uint32_t> slice_lights_[kSliceCount];
+    SliceScratch slice_scratch_[kSliceCount];
+    uint32_t point_count_ = 0;
+    std::vector<LightCluster> clusters_;
+    std::vector<uint32_t> light_indices_;
+};
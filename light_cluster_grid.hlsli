@@ -0,0 +1,41 @@
+//--------------------------------------------------------------------------------
+//  light_cluster_grid.hlsli
+//  Lookup of the lights assigned by LightClusterGrid (light_cluster_grid.h).
+//  Upload LightClusterGrid::Clusters() as StructuredBuffer<LightCluster>
+//  and LightClusterGrid::LightIndices() as StructuredBuffer<uint>, then
+//
+//      LightCluster cluster = clusters[LightClusterIndex(...)];
+//      for (uint i = 0; i < LightClusterPointCount(cluster); ++i)
+//          light = lights[light_indices[cluster.offset + i]];
+//      for (i = 0; i < LightClusterSpotCount(cluster); ++i)
+//          light = lights[light_indices[cluster.offset + LightClusterPointCount(cluster) + i]];
+//--------------------------------------------------------------------------------
+#ifndef LIGHT_CLUSTER_GRID_HLSLI
+#define LIGHT_CLUSTER_GRID_HLSLI
+
+// LightClusterGrid::kTileSize / kSliceCount
+#define LIGHT_CLUSTER_TILE_SIZE 64
+#define LIGHT_CLUSTER_SLICE_COUNT 24
+
+struct LightCluster
+{
+    uint offset;
+    uint counts;            // point_count | spot_count << 16
+};
+
+uint LightClusterPointCount(LightCluster cluster) { return cluster.counts & 0xffff; }
+uint LightClusterSpotCount(LightCluster cluster) { return cluster.counts >> 16; }
+
+// pixel        : SV_Position.xy
+// view_z       : view space depth of the pixel
+// grid_size    : LightClusterGrid::GridWidth / GridHeight
+// depth_scale, depth_bias : LightClusterGrid::DepthScale / DepthBias
+uint LightClusterIndex(float2 pixel, float view_z, uint2 grid_size, float depth_scale, float depth_bias)
+{
+    uint2 tile = min(uint2(pixel) / LIGHT_CLUSTER_TILE_SIZE, grid_size - 1);
+    float slice = floor(log2(max(view_z, 1e-5f)) * depth_scale + depth_bias);
+    uint z = uint(clamp(slice, 0.0f, LIGHT_CLUSTER_SLICE_COUNT - 1.0f));
+    return (z * grid_size.y + tile.y) * grid_size.x + tile.x;
+}
+
+#endif
@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------------
+//  lod_selector.cpp
+//--------------------------------------------------------------------------------
+#include "lod_selector.h"
+#include "draw_batcher.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void LodSelector::SetSubmesh(uint32_t base_handle, const float* errors, uint32_t lod_count)
+{
+    if (entries_.size() <= base_handle) entries_.resize(base_handle + 1);
+    Entry& entry = entries_[base_handle];
+    entry.lod_count = min(lod_count, kMaxLods);
+
+    // Keep the errors monotonic so the selection can stop at the first miss.
+    float previous = 0.0f;
+    for (uint32_t i = 0; i < entry.lod_count; ++i)
+    {
+        previous = max(previous, errors[i]);
+        entry.errors[i] = previous;
+    }
+}
+
+uint32_t LodSelector::RegisterSubmesh(DrawBatcher& batcher, const SubmeshRange& range,
+    const LodRange* lods, uint32_t lod_count, LodSelector* selector)
+{
+    const uint32_t handle = batcher.RegisterSubmesh(range);
+    lod_count = min(lod_count, kMaxLods);
+    float errors[kMaxLods];
+    for (uint32_t lod = 0; lod < lod_count; ++lod)
+    {
+        SubmeshRange lod_range = range;
+        lod_range.index_count = lods[lod].index_count;
+        lod_range.start_index = lods[lod].start_index;
+        const uint32_t lod_handle = batcher.RegisterSubmesh(lod_range);
+        assert(lod_handle == handle + lod + 1 && "Select relies on consecutive handles");
+        (void)lod_handle;
+        errors[lod] = lods[lod].error;
+    }
+    if (selector) selector->SetSubmesh(handle, errors, lod_count);
+    return handle;
+}
+
+float LodSelector::ProjectionScale(float fov_y, float viewport_height)
+{
+    return viewport_height / (2.0f * tanf(fov_y * 0.5f));
+}
+
+void LodSelector::Select(const uint32_t* visible, size_t visible_count, const float* radii,
+    const uint32_t* instance_submesh, float pixel_error, uint32_t* submeshes) const
+{
+    const uint32_t entry_count = static_cast<uint32_t>(entries_.size());
+    for (size_t i = 0; i < visible_count; ++i)
+    {
+        const uint32_t base = instance_submesh[visible[i]];
+        uint32_t lod = 0;
+        if (base < entry_count)
+        {
+            // error * radius <= pixel_error  <=>  error <= pixel_error / radius
+            const Entry& entry = entries_[base];
+            const float limit = radii[i] > 0.0f ? pixel_error / radii[i] : HUGE_VALF;
+            while (lod < entry.lod_count && entry.errors[lod] <= limit) ++lod;
+        }
+        submeshes[i] = base + lod;
+    }
+}
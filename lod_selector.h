@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------------
+//  lod_selector.h
+//  Per frame LOD selection over the culling output (CPU only).
+//  LODs of a submesh are registered with DrawBatcher right after the base
+//  range (RegisterSubmesh), so LOD n (1 based) of base handle h is submesh
+//  handle h + n.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class DrawBatcher;
+struct SubmeshRange;
+
+struct LodRange                     // SubmeshLod without D3D types
+{
+    uint32_t index_count;
+    uint32_t start_index;
+    float    error;
+};
+
+class LodSelector
+{
+public:
+    static constexpr uint32_t kMaxLods = 8;
+
+    //--------------------------------------------------------------------------------
+    //  errors : SubmeshLod::Error of each LOD, finest first
+    //--------------------------------------------------------------------------------
+    void SetSubmesh(uint32_t base_handle, const float* errors, uint32_t lod_count);
+
+    //--------------------------------------------------------------------------------
+    //  Register range, then its LODs (index ranges drawn with the mesh and
+    //  base vertex of range, at most kMaxLods) with batcher, and their errors
+    //  with selector when given.  Returns the base handle.
+    //--------------------------------------------------------------------------------
+    static uint32_t RegisterSubmesh(DrawBatcher& batcher, const SubmeshRange& range,
+        const LodRange* lods, uint32_t lod_count, LodSelector* selector);
+
+    void Clear() { entries_.clear(); }
+
+    //--------------------------------------------------------------------------------
+    //  viewport height / (2 * tan(fov_y / 2)), see CullingSystem::ProjectedRadii
+    //--------------------------------------------------------------------------------
+    static float ProjectionScale(float fov_y, float viewport_height);
+
+    //--------------------------------------------------------------------------------
+    //  For every visible instance pick the coarsest LOD whose projected error
+    //  (Error * projected radius) stays within pixel_error pixels.
+    //  visible          : culling output (instance indices)
+    //  radii            : CullingSystem::ProjectedRadii of visible
+    //  instance_submesh : base submesh handle, indexed by instance
+    //  submeshes        : receives the submesh handle to draw, per visible entry
+    //--------------------------------------------------------------------------------
+    void Select(const uint32_t* visible, size_t visible_count, const float* radii,
+        const uint32_t* instance_submesh, float pixel_error, uint32_t* submeshes) const;
+
+private:
+    struct Entry
+    {
+        uint32_t lod_count = 0;
+        float    errors[kMaxLods] = {};
+    };
+    std::vector<Entry> entries_;    // indexed by base submesh handle
+};
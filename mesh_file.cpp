@@ -0,0 +1,279 @@
+//--------------------------------------------------------------------------------
+//  mesh_file.cpp
+//--------------------------------------------------------------------------------
+#include "mesh_file.h"
+#include <cstring>
+#include <fstream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value)
+    {
+        return (value + kMeshFileAlignment - 1) & ~(kMeshFileAlignment - 1);
+    }
+
+    bool RangeInFile(uint64_t offset, uint64_t size, uint64_t file_size)
+    {
+        return offset <= file_size && size <= file_size - offset;
+    }
+
+    // True when base_vertex + every index of the range is a vertex of the file.
+    template <class Index>
+    bool IndicesInVertexRange(const Index* indices, uint32_t count, int64_t base_vertex, uint32_t vertex_count)
+    {
+        if (count == 0) return true;
+        Index min_index = indices[0], max_index = indices[0];
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            min_index = indices[i] < min_index ? indices[i] : min_index;
+            max_index = indices[i] > max_index ? indices[i] : max_index;
+        }
+        return base_vertex + min_index >= 0 && base_vertex + max_index < vertex_count;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  MappedFile
+//
+//--------------------------------------------------------------------------------
+bool MappedFile::Open(const string& path)
+{
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle_ = file;
+    mapping_handle_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<uint64_t>(size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (view == MAP_FAILED) return false;
+
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<uint64_t>(status.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    CloseHandle(static_cast<HANDLE>(file_handle_));
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  MeshFileView
+//
+//--------------------------------------------------------------------------------
+bool MeshFileView::Open(const string& path)
+{
+    header_ = nullptr;
+    if (!file_.Open(path)) return false;
+    if (file_.Size() < sizeof(MeshFileHeader))
+    {
+        file_.Close();
+        return false;
+    }
+
+    header_ = reinterpret_cast<const MeshFileHeader*>(file_.Data());
+    if (!Validate())
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+string MeshFileView::SubmeshName(uint32_t index) const
+{
+    const MeshFileSubmesh& submesh = Submeshes()[index];
+    const char* names = reinterpret_cast<const char*>(file_.Data() + header_->name_offset);
+    return string(names + submesh.name_offset, submesh.name_length);
+}
+
+bool MeshFileView::Validate() const
+{
+    const MeshFileHeader& h = *header_;
+    const uint64_t size = file_.Size();
+    if (h.magic != kMeshFileMagic || h.version != kMeshFileVersion) return false;
+    if (h.file_size != size) return false;
+    if (h.index_size != 2 && h.index_size != 4) return false;
+    if (h.vertex_stride == 0) return false;
+
+    if (!RangeInFile(h.vertex_offset, VertexByteSize(), size)) return false;
+    if (!RangeInFile(h.index_offset, IndexByteSize(), size)) return false;
+    if (!RangeInFile(h.submesh_offset, static_cast<uint64_t>(h.submesh_count) * sizeof(MeshFileSubmesh), size)) return false;
+    if (!RangeInFile(h.lod_offset, static_cast<uint64_t>(h.lod_count) * sizeof(MeshFileLod), size)) return false;
+    if (!RangeInFile(h.name_offset, h.name_size, size)) return false;
+
+    const MeshFileSubmesh* submeshes = Submeshes();
+    for (uint32_t i = 0; i < h.submesh_count; ++i)
+    {
+        const MeshFileSubmesh& s = submeshes[i];
+        if (static_cast<uint64_t>(s.start_index) + s.index_count > h.index_count) return false;
+        if (static_cast<uint64_t>(s.name_offset) + s.name_length > h.name_size) return false;
+        if (static_cast<uint64_t>(s.first_lod) + s.lod_count > h.lod_count) return false;
+    }
+
+    const MeshFileLod* lods = Lods();
+    for (uint32_t i = 0; i < h.lod_count; ++i)
+    {
+        if (static_cast<uint64_t>(lods[i].start_index) + lods[i].index_count > h.index_count) return false;
+    }
+
+    // Every index must address a vertex; submeshes with a base vertex are
+    // checked again with it, LODs included.
+    if (!IndicesInRange(0, h.index_count, 0)) return false;
+    for (uint32_t i = 0; i < h.submesh_count; ++i)
+    {
+        const MeshFileSubmesh& s = submeshes[i];
+        if (s.base_vertex == 0) continue;
+        if (!IndicesInRange(s.start_index, s.index_count, s.base_vertex)) return false;
+        for (uint32_t lod = s.first_lod; lod < s.first_lod + s.lod_count; ++lod)
+        {
+            if (!IndicesInRange(lods[lod].start_index, lods[lod].index_count, s.base_vertex)) return false;
+        }
+    }
+    return true;
+}
+
+bool MeshFileView::IndicesInRange(uint32_t start_index, uint32_t index_count, int32_t base_vertex) const
+{
+    if (header_->index_size == 2)
+    {
+        return IndicesInVertexRange(static_cast<const uint16_t*>(Indices()) + start_index, index_count, base_vertex, header_->vertex_count);
+    }
+    return IndicesInVertexRange(static_cast<const uint32_t*>(Indices()) + start_index, index_count, base_vertex, header_->vertex_count);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  MeshFileWriter
+//
+//--------------------------------------------------------------------------------
+bool MeshFileWriter::Write(const string& path, const MeshFileData& data)
+{
+    if (data.vertex_stride == 0 || data.vertices.size() % data.vertex_stride != 0) return false;
+
+    uint32_t max_index = 0;
+    for (uint32_t index : data.indices) max_index = index > max_index ? index : max_index;
+    const uint32_t index_size = max_index <= 0xffff ? 2 : 4;
+
+    // Flatten names and lods.
+    string names;
+    vector<MeshFileSubmesh> submeshes;
+    vector<MeshFileLod> lods;
+    for (const auto& source : data.submeshes)
+    {
+        MeshFileSubmesh submesh = {};
+        submesh.index_count = source.index_count;
+        submesh.start_index = source.start_index;
+        submesh.base_vertex = source.base_vertex;
+        submesh.name_offset = static_cast<uint32_t>(names.size());
+        submesh.name_length = static_cast<uint32_t>(source.name.size());
+        submesh.first_lod = static_cast<uint32_t>(lods.size());
+        submesh.lod_count = static_cast<uint32_t>(source.lods.size());
+        memcpy(submesh.center, source.center, sizeof(submesh.center));
+        memcpy(submesh.extents, source.extents, sizeof(submesh.extents));
+        submeshes.push_back(submesh);
+        names += source.name;
+        lods.insert(lods.end(), source.lods.begin(), source.lods.end());
+    }
+
+    MeshFileHeader header = {};
+    header.magic = kMeshFileMagic;
+    header.version = kMeshFileVersion;
+    header.vertex_stride = data.vertex_stride;
+    header.vertex_count = static_cast<uint32_t>(data.vertices.size() / data.vertex_stride);
+    header.index_size = index_size;
+    header.index_count = static_cast<uint32_t>(data.indices.size());
+    header.submesh_count = static_cast<uint32_t>(submeshes.size());
+    header.lod_count = static_cast<uint32_t>(lods.size());
+    header.vertex_offset = AlignUp(sizeof(MeshFileHeader));
+    header.index_offset = AlignUp(header.vertex_offset + data.vertices.size());
+    header.submesh_offset = AlignUp(header.index_offset + static_cast<uint64_t>(index_size) * header.index_count);
+    header.lod_offset = AlignUp(header.submesh_offset + submeshes.size() * sizeof(MeshFileSubmesh));
+    header.name_offset = AlignUp(header.lod_offset + lods.size() * sizeof(MeshFileLod));
+    header.name_size = names.size();
+    header.file_size = header.name_offset + header.name_size;
+
+    vector<uint8_t> file(static_cast<size_t>(header.file_size), 0);
+    memcpy(&file[0], &header, sizeof(header));
+    if (!data.vertices.empty()) memcpy(&file[header.vertex_offset], data.vertices.data(), data.vertices.size());
+    if (index_size == 2)
+    {
+        uint16_t* indices = reinterpret_cast<uint16_t*>(&file[header.index_offset]);
+        for (size_t i = 0; i < data.indices.size(); ++i) indices[i] = static_cast<uint16_t>(data.indices[i]);
+    }
+    else if (!data.indices.empty())
+    {
+        memcpy(&file[header.index_offset], data.indices.data(), data.indices.size() * sizeof(uint32_t));
+    }
+    if (!submeshes.empty()) memcpy(&file[header.submesh_offset], submeshes.data(), submeshes.size() * sizeof(MeshFileSubmesh));
+    if (!lods.empty()) memcpy(&file[header.lod_offset], lods.data(), lods.size() * sizeof(MeshFileLod));
+    if (!names.empty()) memcpy(&file[header.name_offset], names.data(), names.size());
+
+    ofstream fout(path, ios::binary);
+    if (!fout) return false;
+    fout.write(reinterpret_cast<const char*>(file.data()), static_cast<streamsize>(file.size()));
+    fout.close();
+    return !fout.fail();
+}
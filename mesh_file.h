@@ -0,0 +1,149 @@
+//--------------------------------------------------------------------------------
+//  mesh_file.h
+//  Versioned binary mesh container (.kmesh).
+//
+//  [MeshFileHeader][vertex stream][index stream][submesh table][lod table][names]
+//  Every block starts on a kMeshFileAlignment boundary, so the streams can be
+//  handed to the upload path straight from a memory mapped file.
+//  Only plain C++ here so the converter tool builds without the D3D12 SDK.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static constexpr uint32_t kMeshFileMagic = 0x48534d4b; // "KMSH"
+static constexpr uint16_t kMeshFileVersion = 1;
+static constexpr uint64_t kMeshFileAlignment = 64;
+
+struct MeshFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t vertex_stride;
+    uint32_t vertex_count;
+    uint32_t index_size;        // 2 (R16_UINT) or 4 (R32_UINT)
+    uint32_t index_count;
+    uint32_t submesh_count;
+    uint32_t lod_count;
+    uint64_t vertex_offset;
+    uint64_t index_offset;
+    uint64_t submesh_offset;
+    uint64_t lod_offset;
+    uint64_t name_offset;
+    uint64_t name_size;
+    uint64_t file_size;
+};
+static_assert(sizeof(MeshFileHeader) == 88, "MeshFileHeader layout changed, bump kMeshFileVersion");
+
+//--------------------------------------------------------------------------------
+//  Maps 1:1 to SubmeshGeometry.  LODs (if any) are further index ranges in the
+//  same index buffer, listed in lod table [first_lod, first_lod + lod_count).
+//--------------------------------------------------------------------------------
+struct MeshFileSubmesh
+{
+    uint32_t index_count;
+    uint32_t start_index;
+    int32_t  base_vertex;
+    uint32_t name_offset;       // into the name block, not null terminated
+    uint32_t name_length;
+    uint32_t first_lod;
+    uint32_t lod_count;
+    uint32_t reserved;
+    float    center[3];
+    float    extents[3];
+};
+static_assert(sizeof(MeshFileSubmesh) == 56, "MeshFileSubmesh layout changed, bump kMeshFileVersion");
+
+struct MeshFileLod
+{
+    uint32_t index_count;
+    uint32_t start_index;
+    float    error;             // simplification error relative to the length of the submesh extents
+    uint32_t reserved;
+};
+static_assert(sizeof(MeshFileLod) == 16, "MeshFileLod layout changed, bump kMeshFileVersion");
+
+//--------------------------------------------------------------------------------
+//  Read only memory mapping of a whole file
+//--------------------------------------------------------------------------------
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const uint8_t* Data() const { return data_; }
+    uint64_t       Size() const { return size_; }
+
+private:
+    MappedFile(const MappedFile& rhs) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+
+    const uint8_t* data_ = nullptr;
+    uint64_t       size_ = 0;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+};
+
+//--------------------------------------------------------------------------------
+//  Validated view over a mapped .kmesh file.  Pointers stay valid while the
+//  view is open.
+//--------------------------------------------------------------------------------
+class MeshFileView
+{
+public:
+    bool Open(const std::string& path);
+    void Close() { file_.Close(); header_ = nullptr; }
+
+    const MeshFileHeader&  Header() const { return *header_; }
+    const void*            Vertices() const { return file_.Data() + header_->vertex_offset; }
+    const void*            Indices() const { return file_.Data() + header_->index_offset; }
+    const MeshFileSubmesh* Submeshes() const { return reinterpret_cast<const MeshFileSubmesh*>(file_.Data() + header_->submesh_offset); }
+    const MeshFileLod*     Lods() const { return reinterpret_cast<const MeshFileLod*>(file_.Data() + header_->lod_offset); }
+    std::string            SubmeshName(uint32_t index) const;
+
+    uint64_t VertexByteSize() const { return static_cast<uint64_t>(header_->vertex_stride) * header_->vertex_count; }
+    uint64_t IndexByteSize() const { return static_cast<uint64_t>(header_->index_size) * header_->index_count; }
+
+private:
+    bool Validate() const;
+    bool IndicesInRange(uint32_t start_index, uint32_t index_count, int32_t base_vertex) const;
+
+    MappedFile file_;
+    const MeshFileHeader* header_ = nullptr;
+};
+
+//--------------------------------------------------------------------------------
+//  Writer used by the converter tool and import pipeline
+//--------------------------------------------------------------------------------
+struct MeshFileData
+{
+    struct Submesh
+    {
+        std::string name;
+        uint32_t index_count = 0;
+        uint32_t start_index = 0;
+        int32_t  base_vertex = 0;
+        float    center[3] = { 0.0f, 0.0f, 0.0f };
+        float    extents[3] = { 0.0f, 0.0f, 0.0f };
+        std::vector<MeshFileLod> lods;
+    };
+
+    std::vector<uint8_t>  vertices;
+    uint32_t              vertex_stride = 0;
+    std::vector<uint32_t> indices;        // written as 16bit when every index fits
+    std::vector<Submesh>  submeshes;
+};
+
+class MeshFileWriter
+{
+public:
+    static bool Write(const std::string& path, const MeshFileData& data);
+};
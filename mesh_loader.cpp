@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------------
+//  mesh_loader.cpp
+//--------------------------------------------------------------------------------
+#include "mesh_loader.h"
+#include "mesh_file.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+unique_ptr<MeshGeometry> MeshLoader::Load(
+    ID3D12Device* device,
+    ID3D12GraphicsCommandList* command_list,
+    const string& path,
+    bool keep_cpu_copy)
+{
+    MeshFileView file;
+    if (!file.Open(path)) return nullptr;
+
+    const MeshFileHeader& header = file.Header();
+    auto geometry = make_unique<MeshGeometry>();
+    geometry->Name = path;
+    geometry->VertexByteStride = header.vertex_stride;
+    geometry->VertexBufferByteSize = static_cast<UINT>(file.VertexByteSize());
+    geometry->IndexFormat = header.index_size == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    geometry->IndexBufferByteSize = static_cast<UINT>(file.IndexByteSize());
+
+    if (keep_cpu_copy)
+    {
+        ThrowIfFailed(D3DCreateBlob(geometry->VertexBufferByteSize, &geometry->VertexBufferCPU));
+        memcpy(geometry->VertexBufferCPU->GetBufferPointer(), file.Vertices(), geometry->VertexBufferByteSize);
+        ThrowIfFailed(D3DCreateBlob(geometry->IndexBufferByteSize, &geometry->IndexBufferCPU));
+        memcpy(geometry->IndexBufferCPU->GetBufferPointer(), file.Indices(), geometry->IndexBufferByteSize);
+    }
+
+    // UpdateSubresources copies into the upload heaps during these calls,
+    // so the mapping is not needed once they return.
+    geometry->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(device, command_list,
+        file.Vertices(), geometry->VertexBufferByteSize, geometry->VertexBufferUploader);
+    geometry->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device, command_list,
+        file.Indices(), geometry->IndexBufferByteSize, geometry->IndexBufferUploader);
+
+    const MeshFileSubmesh* submeshes = file.Submeshes();
+    for (uint32_t i = 0; i < header.submesh_count; ++i)
+    {
+        const MeshFileSubmesh& source = submeshes[i];
+        SubmeshGeometry submesh;
+        submesh.IndexCount = source.index_count;
+        submesh.StartIndexLocation = source.start_index;
+        submesh.BaseVertexLocation = source.base_vertex;
+        submesh.Bounds.Center = XMFLOAT3(source.center[0], source.center[1], source.center[2]);
+        submesh.Bounds.Extents = XMFLOAT3(source.extents[0], source.extents[1], source.extents[2]);
+        for (uint32_t lod = 0; lod < source.lod_count; ++lod)
+        {
+            const MeshFileLod& source_lod = file.Lods()[source.first_lod + lod];
+            SubmeshLod submesh_lod;
+            submesh_lod.IndexCount = source_lod.index_count;
+            submesh_lod.StartIndexLocation = source_lod.start_index;
+            submesh_lod.Error = source_lod.error;
+            submesh.Lods.push_back(submesh_lod);
+        }
+        geometry->DrawArgs[file.SubmeshName(i)] = submesh;
+    }
+
+    return geometry;
+}
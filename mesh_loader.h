@@ -0,0 +1,22 @@
+//--------------------------------------------------------------------------------
+//  mesh_loader.h
+//  Creates a MeshGeometry from a .kmesh file (see mesh_file.h).
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+
+class MeshLoader
+{
+public:
+    //--------------------------------------------------------------------------------
+    //  The file is memory mapped and its streams are copied straight into the
+    //  upload buffers.  VertexBufferCPU/IndexBufferCPU are only filled when
+    //  keep_cpu_copy is true.  Returns nullptr if the file is missing or invalid.
+    //  Call DisposeUploaders on the result after the command list has executed.
+    //--------------------------------------------------------------------------------
+    static std::unique_ptr<MeshGeometry> Load(
+        ID3D12Device* device,
+        ID3D12GraphicsCommandList* command_list,
+        const std::string& path,
+        bool keep_cpu_copy = false);
+};
@@ -0,0 +1,415 @@
+//--------------------------------------------------------------------------------
+//  mesh_optimizer.cpp
+//--------------------------------------------------------------------------------
+#include "mesh_optimizer.h"
+#include "mesh_file.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kInvalid = 0xffffffff;
+
+    const float* Position(const void* vertices, uint32_t stride, uint32_t index)
+    {
+        return reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + static_cast<size_t>(index) * stride);
+    }
+
+    // Vertex with live triangles left to emit: first from the dead-end stack
+    // (recently used, likely in cache), then in input order.
+    uint32_t SkipDeadEnd(const vector<uint32_t>& live, vector<uint32_t>& dead_end,
+        const uint32_t* indices, size_t index_count, size_t& cursor)
+    {
+        while (!dead_end.empty())
+        {
+            uint32_t vertex = dead_end.back();
+            dead_end.pop_back();
+            if (live[vertex] > 0) return vertex;
+        }
+        while (cursor < index_count)
+        {
+            uint32_t vertex = indices[cursor++];
+            if (live[vertex] > 0) return vertex;
+        }
+        return kInvalid;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+float MeshOptimizer::SimulateAcmr(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size)
+{
+    if (index_count < 3) return 0.0f;
+
+    // A vertex is cached while fewer than cache_size misses happened since it was loaded.
+    vector<uint32_t> stamp(vertex_count, 0);
+    uint32_t time = cache_size + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        const uint32_t vertex = indices[i];
+        if (time - stamp[vertex] > cache_size)
+        {
+            stamp[vertex] = time++;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(index_count / 3);
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t index_count,
+    size_t vertex_count, uint32_t cache_size, vector<uint32_t>* clusters)
+{
+    assert(destination != indices);
+    assert(index_count % 3 == 0);
+    if (clusters) clusters->clear();
+    if (index_count == 0) return;
+
+    // Vertex -> triangle adjacency in CSR form.
+    vector<uint32_t> live(vertex_count, 0);
+    for (size_t i = 0; i < index_count; ++i) ++live[indices[i]];
+    vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] = offsets[v] + live[v];
+    vector<uint32_t> adjacency(index_count);
+    {
+        vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < index_count; ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    vector<uint32_t> cache_time(vertex_count, 0);
+    vector<uint8_t> emitted(index_count / 3, 0);
+    vector<uint32_t> dead_end;
+    dead_end.reserve(index_count);
+    vector<uint32_t> candidates;
+
+    uint32_t time = cache_size + 1;
+    size_t cursor = 0;
+    size_t written = 0;
+    uint32_t fanning = indices[0];
+    if (clusters) clusters->push_back(0);
+
+    while (fanning != kInvalid)
+    {
+        // Emit every remaining triangle around the fanning vertex.
+        candidates.clear();
+        for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+        {
+            const uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = 1;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t vertex = indices[triangle * 3 + k];
+                destination[written++] = vertex;
+                dead_end.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if (time - cache_time[vertex] > cache_size) cache_time[vertex] = time++;
+            }
+        }
+
+        // Next fanning vertex: the one that stays in cache the longest after
+        // its remaining triangles are emitted.
+        uint32_t best = kInvalid;
+        int best_priority = -1;
+        for (uint32_t vertex : candidates)
+        {
+            if (live[vertex] == 0) continue;
+            int priority = 0;
+            if (time - cache_time[vertex] + 2 * live[vertex] <= cache_size)
+            {
+                priority = static_cast<int>(time - cache_time[vertex]);
+            }
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                best = vertex;
+            }
+        }
+
+        if (best == kInvalid)
+        {
+            best = SkipDeadEnd(live, dead_end, indices, index_count, cursor);
+            if (best != kInvalid && clusters) clusters->push_back(static_cast<uint32_t>(written));
+        }
+        fanning = best;
+    }
+    assert(written == index_count);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t index_count,
+    const void* vertices, size_t vertex_count, uint32_t vertex_stride,
+    const vector<uint32_t>& clusters, float threshold, uint32_t cache_size)
+{
+    assert(destination != indices);
+    if (index_count == 0) return;
+
+    // Split the hard clusters where the cache did well so far.
+    const float overall_acmr = SimulateAcmr(indices, index_count, vertex_count, cache_size);
+    vector<uint32_t> split;
+    vector<uint32_t> stamp(vertex_count, 0);
+    uint32_t time = cache_size + 1;
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        const size_t begin = clusters[c];
+        const size_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : index_count;
+        split.push_back(static_cast<uint32_t>(begin));
+
+        // Hard boundaries start with a cold cache.
+        time += cache_size + 1;
+        size_t misses = 0;
+        size_t triangles = 0;
+        for (size_t i = begin; i < end; i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t vertex = indices[i + k];
+                if (time - stamp[vertex] > cache_size)
+                {
+                    stamp[vertex] = time++;
+                    ++misses;
+                }
+            }
+            ++triangles;
+
+            // Misses are counted with a cold cache at every split, so each soft
+            // cluster stays within the threshold wherever it ends up in the order.
+            if (i + 3 < end && static_cast<float>(misses) <= threshold * overall_acmr * static_cast<float>(triangles))
+            {
+                split.push_back(static_cast<uint32_t>(i + 3));
+                time += cache_size + 1;
+                misses = 0;
+                triangles = 0;
+            }
+        }
+    }
+
+    // Area weighted centroid and normal of each cluster and of the whole mesh.
+    struct Cluster
+    {
+        uint32_t begin;
+        uint32_t end;
+        float    sort_key;
+    };
+    vector<Cluster> sorted(split.size());
+    vector<float> centroids(split.size() * 4, 0.0f);
+    vector<float> normals(split.size() * 3, 0.0f);
+    float mesh_centroid[3] = { 0.0f, 0.0f, 0.0f };
+    float mesh_area = 0.0f;
+
+    for (size_t c = 0; c < split.size(); ++c)
+    {
+        sorted[c].begin = split[c];
+        sorted[c].end = (c + 1 < split.size()) ? split[c + 1] : static_cast<uint32_t>(index_count);
+
+        float* centroid = &centroids[c * 4];
+        float* normal = &normals[c * 3];
+        for (uint32_t i = sorted[c].begin; i < sorted[c].end; i += 3)
+        {
+            const float* p0 = Position(vertices, vertex_stride, indices[i + 0]);
+            const float* p1 = Position(vertices, vertex_stride, indices[i + 1]);
+            const float* p2 = Position(vertices, vertex_stride, indices[i + 2]);
+            const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float center = (p0[axis] + p1[axis] + p2[axis]) / 3.0f;
+                centroid[axis] += center * area;
+                mesh_centroid[axis] += center * area;
+                normal[axis] += n[axis];
+            }
+            centroid[3] += area;
+            mesh_area += area;
+        }
+    }
+
+    if (mesh_area > 0.0f)
+    {
+        for (int axis = 0; axis < 3; ++axis) mesh_centroid[axis] /= mesh_area;
+    }
+
+    // Outward facing clusters (seen from most directions) first.
+    for (size_t c = 0; c < sorted.size(); ++c)
+    {
+        const float* centroid = &centroids[c * 4];
+        const float* normal = &normals[c * 3];
+        const float area = centroid[3];
+        const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float key = 0.0f;
+        if (area > 0.0f && length > 0.0f)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                key += (centroid[axis] / area - mesh_centroid[axis]) * normal[axis];
+            }
+            key /= length;
+        }
+        sorted[c].sort_key = key;
+    }
+    stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b)
+    {
+        return a.sort_key > b.sort_key;
+    });
+
+    size_t written = 0;
+    for (const Cluster& cluster : sorted)
+    {
+        memcpy(destination + written, indices + cluster.begin, (cluster.end - cluster.begin) * sizeof(uint32_t));
+        written += cluster.end - cluster.begin;
+    }
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(void* destination, uint32_t* indices, size_t index_count,
+    const void* vertices, size_t vertex_count, uint32_t vertex_stride)
+{
+    assert(destination != vertices);
+    vector<uint32_t> remap(vertex_count, kInvalid);
+    uint8_t* dst = static_cast<uint8_t*>(destination);
+    const uint8_t* src = static_cast<const uint8_t*>(vertices);
+
+    uint32_t next = 0;
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        const uint32_t vertex = indices[i];
+        if (remap[vertex] == kInvalid)
+        {
+            remap[vertex] = next;
+            memcpy(dst + static_cast<size_t>(next) * vertex_stride, src + static_cast<size_t>(vertex) * vertex_stride, vertex_stride);
+            ++next;
+        }
+        indices[i] = remap[vertex];
+    }
+    return next;
+}
+
+uint32_t MeshOptimizer::SelectIndexSize(const uint32_t* indices, size_t index_count)
+{
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        if (indices[i] > 0xffff) return 4;
+    }
+    return 2;
+}
+
+MeshOptimizer::Report MeshOptimizer::Optimize(MeshFileData& data, float overdraw_threshold, uint32_t cache_size)
+{
+    Report report;
+    const uint32_t stride = data.vertex_stride;
+    const size_t vertex_count = stride ? data.vertices.size() / stride : 0;
+    report.vertex_count_before = static_cast<uint32_t>(vertex_count);
+
+    vector<uint8_t> new_vertices;
+    vector<uint32_t> new_indices;
+    new_vertices.reserve(data.vertices.size());
+    new_indices.reserve(data.indices.size());
+
+    // Absolute vertex -> submesh local id, reset after each submesh.
+    vector<uint32_t> local_id(vertex_count, kInvalid);
+    size_t misses_before = 0, misses_after = 0, triangles = 0;
+
+    for (auto& submesh : data.submeshes)
+    {
+        // Index ranges drawn with this submesh's base vertex: base LOD first.
+        struct Range { uint32_t start; uint32_t count; };
+        vector<Range> ranges;
+        ranges.push_back({ submesh.start_index, submesh.index_count });
+        for (const auto& lod : submesh.lods) ranges.push_back({ lod.start_index, lod.index_count });
+
+        // Compact the referenced vertices into a local buffer.
+        vector<uint32_t> used;
+        vector<uint32_t> local_indices;
+        for (const Range& range : ranges)
+        {
+            for (uint32_t i = 0; i < range.count; ++i)
+            {
+                const uint32_t vertex = data.indices[range.start + i] + submesh.base_vertex;
+                if (local_id[vertex] == kInvalid)
+                {
+                    local_id[vertex] = static_cast<uint32_t>(used.size());
+                    used.push_back(vertex);
+                }
+                local_indices.push_back(local_id[vertex]);
+            }
+        }
+        for (uint32_t vertex : used) local_id[vertex] = kInvalid;
+
+        vector<uint8_t> local_vertices(used.size() * stride);
+        for (size_t i = 0; i < used.size(); ++i)
+        {
+            memcpy(&local_vertices[i * stride], &data.vertices[static_cast<size_t>(used[i]) * stride], stride);
+        }
+
+        // Cache and overdraw order per range.
+        vector<uint32_t> reordered(local_indices.size());
+        vector<uint32_t> clusters;
+        vector<uint32_t> scratch;
+        size_t offset = 0;
+        for (size_t r = 0; r < ranges.size(); ++r)
+        {
+            const uint32_t* source = local_indices.data() + offset;
+            uint32_t* target = reordered.data() + offset;
+            const size_t count = ranges[r].count;
+            if (count == 0) continue;
+
+            if (r == 0)
+            {
+                misses_before += static_cast<size_t>(SimulateAcmr(source, count, used.size(), cache_size) * (count / 3) + 0.5f);
+                triangles += count / 3;
+            }
+
+            scratch.resize(count);
+            OptimizeVertexCache(scratch.data(), source, count, used.size(), cache_size, &clusters);
+            OptimizeOverdraw(target, scratch.data(), count, local_vertices.data(), used.size(), stride,
+                clusters, overdraw_threshold, cache_size);
+
+            if (r == 0)
+            {
+                misses_after += static_cast<size_t>(SimulateAcmr(target, count, used.size(), cache_size) * (count / 3) + 0.5f);
+            }
+            offset += count;
+        }
+
+        // Vertices in first use order, appended as this submesh's range.
+        const size_t base = new_vertices.size() / (stride ? stride : 1);
+        new_vertices.resize(new_vertices.size() + local_vertices.size());
+        if (!reordered.empty())
+        {
+            OptimizeVertexFetch(&new_vertices[base * stride], reordered.data(), reordered.size(),
+                local_vertices.data(), used.size(), stride);
+        }
+
+        submesh.base_vertex = static_cast<int32_t>(base);
+        offset = 0;
+        for (size_t r = 0; r < ranges.size(); ++r)
+        {
+            const uint32_t start = static_cast<uint32_t>(new_indices.size());
+            new_indices.insert(new_indices.end(), reordered.begin() + offset, reordered.begin() + offset + ranges[r].count);
+            if (r == 0) submesh.start_index = start;
+            else submesh.lods[r - 1].start_index = start;
+            offset += ranges[r].count;
+        }
+    }
+
+    data.vertices.swap(new_vertices);
+    data.indices.swap(new_indices);
+
+    if (triangles > 0)
+    {
+        report.acmr_before = static_cast<float>(misses_before) / static_cast<float>(triangles);
+        report.acmr_after = static_cast<float>(misses_after) / static_cast<float>(triangles);
+    }
+    report.vertex_count_after = stride ? static_cast<uint32_t>(data.vertices.size() / stride) : 0;
+    report.index_size = SelectIndexSize(data.indices.data(), data.indices.size());
+    return report;
+}
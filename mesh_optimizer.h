@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------------
+//  mesh_optimizer.h
+//  Import time index/vertex buffer optimization (CPU only).
+//  - Tipsify vertex cache ordering (Sander et al. 2007)
+//  - Overdraw aware cluster ordering on top of the Tipsify clusters
+//  - Vertex fetch remapping (vertices in order of first use)
+//  - 16/32bit index selection (per submesh base vertex keeps indices small)
+//  Indices are triangle lists.  Positions are float3 at the start of a vertex.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct MeshFileData;
+
+class MeshOptimizer
+{
+public:
+    static constexpr uint32_t kDefaultCacheSize = 16;
+
+    //--------------------------------------------------------------------------------
+    //  Average cache miss ratio (transformed vertices per triangle) of a FIFO
+    //  post transform cache.  1.0 is roughly ideal on regular grids, 3.0 is worst.
+    //--------------------------------------------------------------------------------
+    static float SimulateAcmr(const uint32_t* indices, size_t index_count, size_t vertex_count,
+        uint32_t cache_size = kDefaultCacheSize);
+
+    //--------------------------------------------------------------------------------
+    //  Reorder triangles for the vertex cache.  destination may not alias indices.
+    //  clusters (optional) receives the first index of every hard boundary.
+    //--------------------------------------------------------------------------------
+    static void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t index_count,
+        size_t vertex_count, uint32_t cache_size = kDefaultCacheSize, std::vector<uint32_t>* clusters = nullptr);
+
+    //--------------------------------------------------------------------------------
+    //  Reorder the clusters of a cache optimized index buffer so that outward
+    //  facing clusters are drawn first.  Clusters are further split where the
+    //  local ACMR stays below threshold * overall ACMR, trading a little cache
+    //  efficiency (threshold 1.05 = 5%) for finer ordering.
+    //--------------------------------------------------------------------------------
+    static void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t index_count,
+        const void* vertices, size_t vertex_count, uint32_t vertex_stride,
+        const std::vector<uint32_t>& clusters, float threshold = 1.05f,
+        uint32_t cache_size = kDefaultCacheSize);
+
+    //--------------------------------------------------------------------------------
+    //  Reorder vertices in order of first use and rewrite the indices.
+    //  Unreferenced vertices are dropped.  Returns the new vertex count.
+    //  destination may not alias vertices; indices are rewritten in place.
+    //--------------------------------------------------------------------------------
+    static size_t OptimizeVertexFetch(void* destination, uint32_t* indices, size_t index_count,
+        const void* vertices, size_t vertex_count, uint32_t vertex_stride);
+
+    //--------------------------------------------------------------------------------
+    //  2 when every index fits R16_UINT, 4 otherwise
+    //--------------------------------------------------------------------------------
+    static uint32_t SelectIndexSize(const uint32_t* indices, size_t index_count);
+
+    //--------------------------------------------------------------------------------
+    //  Runs every pass on each submesh of data.  Each submesh gets its own
+    //  vertex range and base vertex so its indices stay as small as possible.
+    //--------------------------------------------------------------------------------
+    struct Report
+    {
+        float    acmr_before = 0.0f;
+        float    acmr_after = 0.0f;
+        uint32_t vertex_count_before = 0;
+        uint32_t vertex_count_after = 0;
+        uint32_t index_size = 4;
+    };
+    static Report Optimize(MeshFileData& data, float overdraw_threshold = 1.05f,
+        uint32_t cache_size = kDefaultCacheSize);
+};
@@ -0,0 +1,385 @@
+//--------------------------------------------------------------------------------
+//  mesh_simplifier.cpp
+//--------------------------------------------------------------------------------
+#include "mesh_simplifier.h"
+#include "mesh_file.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kInvalid = 0xffffffff;
+
+    const float* Position(const void* vertices, uint32_t stride, uint32_t index)
+    {
+        return reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + static_cast<size_t>(index) * stride);
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Area weighted sum of squared plane distances.  Error() divides by the
+    //  weight, so it is a mean squared distance in world units.
+    //--------------------------------------------------------------------------------
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        void AddPlane(double a, double b, double c, double d, double w)
+        {
+            a00 += w * a * a; a01 += w * a * b; a02 += w * a * c; a03 += w * a * d;
+            a11 += w * b * b; a12 += w * b * c; a13 += w * b * d;
+            a22 += w * c * c; a23 += w * c * d;
+            a33 += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+            weight += q.weight;
+        }
+
+        double Error(const float* p) const
+        {
+            const double x = p[0], y = p[1], z = p[2];
+            const double e = x * (a00 * x + 2.0 * (a01 * y + a02 * z + a03))
+                + y * (a11 * y + 2.0 * (a12 * z + a13))
+                + z * (a22 * z + 2.0 * a23)
+                + a33;
+            return weight > 0.0 ? fabs(e) / weight : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        float    cost;
+        uint32_t from;
+        uint32_t to;
+    };
+
+    void Cross(const float* a, const float* b, const float* c, double* n)
+    {
+        const double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+    }
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    // Bit exact position for welding.
+    struct PositionKey
+    {
+        uint32_t bits[3];
+        bool operator==(const PositionKey& rhs) const { return memcmp(bits, rhs.bits, sizeof(bits)) == 0; }
+    };
+
+    struct PositionKeyHash
+    {
+        size_t operator()(const PositionKey& key) const
+        {
+            uint64_t hash = key.bits[0];
+            hash = hash * 0x9e3779b97f4a7c15ull ^ key.bits[1];
+            hash = hash * 0x9e3779b97f4a7c15ull ^ key.bits[2];
+            return static_cast<size_t>(hash ^ (hash >> 32));
+        }
+    };
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+size_t MeshSimplifier::Simplify(uint32_t* destination, const uint32_t* indices, size_t index_count,
+    const void* vertices, size_t vertex_count, uint32_t vertex_stride,
+    size_t target_index_count, float target_error, float* result_error)
+{
+    index_count -= index_count % 3;
+    vector<uint32_t> current(indices, indices + index_count);
+    if (result_error) *result_error = 0.0f;
+
+    // Weld vertices at identical positions.  canonical[v] is the first vertex
+    // at v's position; a position with several vertices is an attribute seam.
+    vector<uint32_t> canonical(vertex_count, kInvalid);
+    vector<uint8_t> locked(vertex_count, 0);
+    {
+        unordered_map<PositionKey, uint32_t, PositionKeyHash> lookup;
+        lookup.reserve(vertex_count);
+        for (uint32_t index : current)
+        {
+            if (canonical[index] != kInvalid) continue;
+            PositionKey key;
+            memcpy(key.bits, Position(vertices, vertex_stride, index), sizeof(key.bits));
+            auto result = lookup.emplace(key, index);
+            canonical[index] = result.first->second;
+            if (!result.second)
+            {
+                locked[index] = 1;
+                locked[result.first->second] = 1;
+            }
+        }
+    }
+
+    // Border (or non manifold) edges lock their vertices.
+    {
+        unordered_map<uint64_t, uint32_t> edges;
+        edges.reserve(index_count);
+        for (size_t i = 0; i < index_count; i += 3)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                ++edges[EdgeKey(canonical[current[i + e]], canonical[current[i + (e + 1) % 3]])];
+            }
+        }
+        for (const auto& edge : edges)
+        {
+            const uint32_t a = static_cast<uint32_t>(edge.first >> 32);
+            const uint32_t b = static_cast<uint32_t>(edge.first);
+            auto reverse = edges.find(EdgeKey(b, a));
+            if (edge.second != 1 || reverse == edges.end() || reverse->second != 1)
+            {
+                locked[a] = 1;
+                locked[b] = 1;
+            }
+        }
+    }
+    for (size_t v = 0; v < vertex_count; ++v)
+    {
+        if (canonical[v] != kInvalid && locked[canonical[v]]) locked[v] = 1;
+    }
+
+    // Bounding box radius for the relative error.
+    float bounds_min[3] = { 0.0f, 0.0f, 0.0f };
+    float bounds_max[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        const float* p = Position(vertices, vertex_stride, current[i]);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            bounds_min[axis] = i == 0 ? p[axis] : min(bounds_min[axis], p[axis]);
+            bounds_max[axis] = i == 0 ? p[axis] : max(bounds_max[axis], p[axis]);
+        }
+    }
+    const float dx = bounds_max[0] - bounds_min[0];
+    const float dy = bounds_max[1] - bounds_min[1];
+    const float dz = bounds_max[2] - bounds_min[2];
+    const float radius = 0.5f * sqrtf(dx * dx + dy * dy + dz * dz);
+    const float max_error = target_error * radius;
+    const float max_cost = max_error * max_error;
+
+    // Plane quadrics per welded position.
+    vector<Quadric> quadrics(vertex_count);
+    for (size_t i = 0; i < index_count; i += 3)
+    {
+        const float* p0 = Position(vertices, vertex_stride, current[i]);
+        const float* p1 = Position(vertices, vertex_stride, current[i + 1]);
+        const float* p2 = Position(vertices, vertex_stride, current[i + 2]);
+        double n[3];
+        Cross(p0, p1, p2, n);
+        const double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0) continue;
+        n[0] /= length; n[1] /= length; n[2] /= length;
+        const double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            quadrics[canonical[current[i + corner]]].AddPlane(n[0], n[1], n[2], d, length * 0.5);
+        }
+    }
+
+    // Collapse passes.  Each vertex takes part in at most one collapse per pass
+    // so the costs and flip tests of a pass stay valid.
+    vector<uint32_t> remap(vertex_count);
+    vector<uint8_t> touched(vertex_count);
+    vector<uint32_t> adjacency_offset(vertex_count + 1);
+    vector<uint32_t> adjacency;
+    vector<Collapse> collapses;
+    float error = 0.0f;
+    size_t triangle_count = index_count / 3;
+    const size_t target_triangles = target_index_count / 3;
+
+    while (triangle_count > target_triangles)
+    {
+        // Triangles around each vertex.
+        fill(adjacency_offset.begin(), adjacency_offset.end(), 0);
+        for (uint32_t index : current) ++adjacency_offset[index + 1];
+        for (size_t v = 0; v < vertex_count; ++v) adjacency_offset[v + 1] += adjacency_offset[v];
+        adjacency.resize(current.size());
+        {
+            vector<uint32_t> cursor(adjacency_offset.begin(), adjacency_offset.end() - 1);
+            for (size_t i = 0; i < current.size(); ++i) adjacency[cursor[current[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                const uint32_t a = current[i + e];
+                const uint32_t b = current[i + (e + 1) % 3];
+                Quadric q = quadrics[canonical[a]];
+                q.Add(quadrics[canonical[b]]);
+                if (!locked[a]) collapses.push_back({ static_cast<float>(q.Error(Position(vertices, vertex_stride, b))), a, b });
+                if (!locked[b]) collapses.push_back({ static_cast<float>(q.Error(Position(vertices, vertex_stride, a))), b, a });
+            }
+        }
+        if (collapses.empty()) break;
+        sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+        {
+            if (lhs.cost != rhs.cost) return lhs.cost < rhs.cost;
+            if (lhs.from != rhs.from) return lhs.from < rhs.from;
+            return lhs.to < rhs.to;
+        });
+
+        for (size_t v = 0; v < vertex_count; ++v) remap[v] = static_cast<uint32_t>(v);
+        fill(touched.begin(), touched.end(), 0);
+        size_t collapsed = 0;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (triangle_count <= target_triangles || collapse.cost > max_cost) break;
+            const uint32_t a = collapse.from;
+            const uint32_t b = collapse.to;
+            if (touched[canonical[a]] || touched[canonical[b]]) continue;
+
+            // Reject collapses that flip (or nearly flip) a surviving triangle around a.
+            const float* target = Position(vertices, vertex_stride, b);
+            bool flips = false;
+            size_t removed = 0;
+            for (uint32_t t = adjacency_offset[a]; t < adjacency_offset[a + 1] && !flips; ++t)
+            {
+                const uint32_t* triangle = &current[static_cast<size_t>(adjacency[t]) * 3];
+                if (canonical[triangle[0]] == canonical[b] || canonical[triangle[1]] == canonical[b] || canonical[triangle[2]] == canonical[b])
+                {
+                    ++removed;
+                    continue;
+                }
+
+                const float* p[3];
+                const float* q[3];
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    p[corner] = Position(vertices, vertex_stride, triangle[corner]);
+                    q[corner] = triangle[corner] == a ? target : p[corner];
+                }
+                double before[3], after[3];
+                Cross(p[0], p[1], p[2], before);
+                Cross(q[0], q[1], q[2], after);
+                // More than ~75 degrees of rotation counts as a flip.
+                const double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                const double length_before = sqrt(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]);
+                const double length_after = sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+                flips = dot <= 0.25 * length_before * length_after;
+            }
+            if (flips) continue;
+
+            // Neighbours of a are touched too: their triangles change shape.
+            for (uint32_t t = adjacency_offset[a]; t < adjacency_offset[a + 1]; ++t)
+            {
+                const uint32_t* triangle = &current[static_cast<size_t>(adjacency[t]) * 3];
+                for (int corner = 0; corner < 3; ++corner) touched[canonical[triangle[corner]]] = 1;
+            }
+
+            remap[a] = b;
+            quadrics[canonical[b]].Add(quadrics[canonical[a]]);
+            error = max(error, sqrtf(collapse.cost));
+            triangle_count -= removed;
+            ++collapsed;
+        }
+        if (collapsed == 0) break;
+
+        // Apply the pass and drop degenerate triangles.
+        size_t write = 0;
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            const uint32_t i0 = remap[current[i]];
+            const uint32_t i1 = remap[current[i + 1]];
+            const uint32_t i2 = remap[current[i + 2]];
+            if (canonical[i0] == canonical[i1] || canonical[i1] == canonical[i2] || canonical[i0] == canonical[i2]) continue;
+            current[write++] = i0;
+            current[write++] = i1;
+            current[write++] = i2;
+        }
+        current.resize(write);
+        triangle_count = write / 3;
+    }
+
+    if (!current.empty()) memcpy(destination, current.data(), current.size() * sizeof(uint32_t));
+    if (result_error) *result_error = radius > 0.0f ? error / radius : 0.0f;
+    return current.size();
+}
+
+uint32_t MeshSimplifier::GenerateLods(MeshFileData& data, uint32_t max_lod_count, float reduction, float max_error)
+{
+    const uint32_t stride = data.vertex_stride;
+    if (stride < sizeof(float) * 3) return 0;
+    const size_t vertex_count = data.vertices.size() / stride;
+    max_lod_count = min(max_lod_count, kMaxLods);
+
+    uint32_t generated = 0;
+    vector<uint32_t> local_id(vertex_count, kInvalid);
+    for (auto& submesh : data.submeshes)
+    {
+        if (!submesh.lods.empty() || submesh.index_count < 3) continue;
+
+        // Compact the submesh's positions so the simplifier works on its vertices only.
+        vector<uint32_t> used;
+        vector<uint32_t> source(submesh.index_count);
+        for (uint32_t i = 0; i < submesh.index_count; ++i)
+        {
+            const uint32_t vertex = data.indices[submesh.start_index + i] + submesh.base_vertex;
+            if (vertex >= vertex_count) return generated;
+            if (local_id[vertex] == kInvalid)
+            {
+                local_id[vertex] = static_cast<uint32_t>(used.size());
+                used.push_back(vertex);
+            }
+            source[i] = local_id[vertex];
+        }
+        for (uint32_t vertex : used) local_id[vertex] = kInvalid;
+
+        vector<float> positions(used.size() * 3);
+        for (size_t i = 0; i < used.size(); ++i)
+        {
+            memcpy(&positions[i * 3], &data.vertices[static_cast<size_t>(used[i]) * stride], sizeof(float) * 3);
+        }
+
+        float accumulated = 0.0f;
+        vector<uint32_t> lod(source.size());
+        for (uint32_t level = 0; level < max_lod_count; ++level)
+        {
+            const size_t target = static_cast<size_t>(source.size() / 3 * reduction) * 3;
+            float step_error = 0.0f;
+            const size_t count = Simplify(lod.data(), source.data(), source.size(),
+                positions.data(), used.size(), sizeof(float) * 3, target, max_error - accumulated, &step_error);
+            if (count == 0 || count * 10 > source.size() * 9) break;
+            accumulated += step_error;
+
+            MeshFileLod entry = {};
+            entry.index_count = static_cast<uint32_t>(count);
+            entry.start_index = static_cast<uint32_t>(data.indices.size());
+            entry.error = accumulated;
+            submesh.lods.push_back(entry);
+            for (size_t i = 0; i < count; ++i) data.indices.push_back(used[lod[i]] - submesh.base_vertex);
+            ++generated;
+
+            source.assign(lod.begin(), lod.begin() + count);
+        }
+    }
+    return generated;
+}
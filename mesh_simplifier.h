@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------
+//  mesh_simplifier.h
+//  Import time LOD generation (CPU only).
+//  Quadric error edge collapse (Garland and Heckbert 1997) onto existing
+//  vertices, so every LOD is an index range over the base LOD's vertices and
+//  can live in the same index buffer with the same base vertex.
+//  Border and attribute seam vertices (several vertices at one position) are
+//  never moved; other vertices may collapse onto them.
+//  Indices are triangle lists.  Positions are float3 at the start of a vertex.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+struct MeshFileData;
+
+class MeshSimplifier
+{
+public:
+    static constexpr uint32_t kMaxLods = 8;
+
+    //--------------------------------------------------------------------------------
+    //  Collapse edges, cheapest first, until at most target_index_count indices
+    //  are left or the next collapse would exceed target_error.
+    //  Errors are relative to the radius of the vertices' bounding box.
+    //  destination needs room for index_count indices and may alias indices.
+    //  Returns the new index count.
+    //--------------------------------------------------------------------------------
+    static size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t index_count,
+        const void* vertices, size_t vertex_count, uint32_t vertex_stride,
+        size_t target_index_count, float target_error, float* result_error = nullptr);
+
+    //--------------------------------------------------------------------------------
+    //  Append an LOD chain to every submesh that has none.  Each LOD keeps about
+    //  reduction of the previous one's triangles; the chain stops at max_lod_count,
+    //  when the error would exceed max_error or when a step removes under 10%.
+    //  MeshFileLod::error is the accumulated error.  Run before Optimize and
+    //  CompressMesh.  Returns the number of LODs added.
+    //--------------------------------------------------------------------------------
+    static uint32_t GenerateLods(MeshFileData& data, uint32_t max_lod_count = 4,
+        float reduction = 0.5f, float max_error = 0.05f);
+};
@@ -0,0 +1,235 @@
+//--------------------------------------------------------------------------------
+//  meshlet_builder.cpp
+//--------------------------------------------------------------------------------
+#include "meshlet_builder.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kInvalid = 0xffffffff;
+    constexpr uint8_t kNotInMeshlet = 0xff;
+
+    const float* Position(const void* vertices, uint32_t stride, uint32_t index)
+    {
+        return reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + static_cast<size_t>(index) * stride);
+    }
+
+    float Dot(const float* a, const float* b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void Normalize(float* v)
+    {
+        const float length = sqrtf(Dot(v, v));
+        if (length > 0.0f)
+        {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Sphere around the box of the meshlet vertices and the normal cone of
+    //  its triangles (Direct3D winding: cross(p1 - p0, p2 - p0) faces out)
+    //--------------------------------------------------------------------------------
+    MeshletBounds ComputeBounds(const Meshlet& meshlet, const uint32_t* meshlet_vertices,
+        const float* triangle_normals, const uint32_t* triangle_ids, const void* vertices, uint32_t stride)
+    {
+        MeshletBounds bounds = {};
+        const float* first = Position(vertices, stride, meshlet_vertices[0]);
+        float bounds_min[3] = { first[0], first[1], first[2] };
+        float bounds_max[3] = { first[0], first[1], first[2] };
+        for (uint32_t i = 1; i < meshlet.vertex_count; ++i)
+        {
+            const float* p = Position(vertices, stride, meshlet_vertices[i]);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                bounds_min[axis] = min(bounds_min[axis], p[axis]);
+                bounds_max[axis] = max(bounds_max[axis], p[axis]);
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis) bounds.center[axis] = (bounds_min[axis] + bounds_max[axis]) * 0.5f;
+
+        float radius_sq = 0.0f;
+        for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+        {
+            const float* p = Position(vertices, stride, meshlet_vertices[i]);
+            const float d[3] = { p[0] - bounds.center[0], p[1] - bounds.center[1], p[2] - bounds.center[2] };
+            radius_sq = max(radius_sq, Dot(d, d));
+        }
+        bounds.radius = sqrtf(radius_sq);
+
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t i = 0; i < meshlet.triangle_count; ++i)
+        {
+            const float* n = &triangle_normals[static_cast<size_t>(triangle_ids[i]) * 3];
+            axis[0] += n[0];
+            axis[1] += n[1];
+            axis[2] += n[2];
+        }
+        Normalize(axis);
+
+        float min_dot = 1.0f;
+        for (uint32_t i = 0; i < meshlet.triangle_count; ++i)
+        {
+            min_dot = min(min_dot, Dot(&triangle_normals[static_cast<size_t>(triangle_ids[i]) * 3], axis));
+        }
+        bounds.cone_axis[0] = axis[0];
+        bounds.cone_axis[1] = axis[1];
+        bounds.cone_axis[2] = axis[2];
+
+        // sin of the cone half angle; a cone of 90 degrees or more rejects nothing.
+        bounds.cone_cutoff = min_dot <= 0.0f || Dot(axis, axis) == 0.0f ? 1.0f : sqrtf(1.0f - min_dot * min_dot);
+        return bounds;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+size_t MeshletBuilder::Build(MeshletData& data, const uint32_t* indices, size_t index_count,
+    const void* vertices, size_t vertex_count, uint32_t vertex_stride)
+{
+    const size_t triangle_count = index_count / 3;
+    if (triangle_count == 0) return 0;
+
+    // Unit normals per triangle (zero for degenerate ones).
+    vector<float> normals(triangle_count * 3);
+    for (size_t t = 0; t < triangle_count; ++t)
+    {
+        const float* p0 = Position(vertices, vertex_stride, indices[t * 3]);
+        const float* p1 = Position(vertices, vertex_stride, indices[t * 3 + 1]);
+        const float* p2 = Position(vertices, vertex_stride, indices[t * 3 + 2]);
+        const float e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float* n = &normals[t * 3];
+        n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+        Normalize(n);
+    }
+
+    // Triangles around each vertex.
+    vector<uint32_t> adjacency_offset(vertex_count + 1, 0);
+    for (size_t i = 0; i < triangle_count * 3; ++i) ++adjacency_offset[indices[i] + 1];
+    for (size_t v = 0; v < vertex_count; ++v) adjacency_offset[v + 1] += adjacency_offset[v];
+    vector<uint32_t> adjacency(triangle_count * 3);
+    {
+        vector<uint32_t> cursor(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (size_t i = 0; i < triangle_count * 3; ++i) adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    vector<uint8_t> used(triangle_count, 0);
+    vector<uint8_t> local(vertex_count, kNotInMeshlet);
+    const size_t first_meshlet = data.meshlets.size();
+    size_t seed_cursor = 0;
+
+    uint32_t meshlet_vertices[kMaxVertices];
+    uint8_t meshlet_triangles[kMaxTriangles * 3];
+    uint32_t triangle_ids[kMaxTriangles];
+
+    for (;;)
+    {
+        while (seed_cursor < triangle_count && used[seed_cursor]) ++seed_cursor;
+        if (seed_cursor == triangle_count) break;
+
+        Meshlet meshlet = {};
+        float normal_sum[3] = { 0.0f, 0.0f, 0.0f };
+        uint32_t next = static_cast<uint32_t>(seed_cursor);
+
+        while (next != kInvalid)
+        {
+            // Add the triangle.
+            used[next] = 1;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t vertex = indices[static_cast<size_t>(next) * 3 + corner];
+                if (local[vertex] == kNotInMeshlet)
+                {
+                    local[vertex] = static_cast<uint8_t>(meshlet.vertex_count);
+                    meshlet_vertices[meshlet.vertex_count++] = vertex;
+                }
+                meshlet_triangles[meshlet.triangle_count * 3 + corner] = local[vertex];
+            }
+            triangle_ids[meshlet.triangle_count++] = next;
+            normal_sum[0] += normals[static_cast<size_t>(next) * 3];
+            normal_sum[1] += normals[static_cast<size_t>(next) * 3 + 1];
+            normal_sum[2] += normals[static_cast<size_t>(next) * 3 + 2];
+            if (meshlet.triangle_count == kMaxTriangles) break;
+
+            float axis[3] = { normal_sum[0], normal_sum[1], normal_sum[2] };
+            Normalize(axis);
+
+            // Best unused neighbour: fewest new vertices, then best facing, then lowest id.
+            // Neighbours of the newest triangle first, then of the whole meshlet.
+            const uint32_t last = next;
+            next = kInvalid;
+            float best_score = 0.0f;
+            for (int pass = 0; pass < 2 && next == kInvalid; ++pass)
+            {
+                const uint32_t source_count = pass == 0 ? 3 : meshlet.vertex_count;
+                for (uint32_t s = 0; s < source_count; ++s)
+                {
+                    const uint32_t vertex = pass == 0 ? indices[static_cast<size_t>(last) * 3 + s] : meshlet_vertices[s];
+                    for (uint32_t a = adjacency_offset[vertex]; a < adjacency_offset[vertex + 1]; ++a)
+                    {
+                        const uint32_t candidate = adjacency[a];
+                        if (used[candidate]) continue;
+
+                        uint32_t new_vertices = 0;
+                        for (int corner = 0; corner < 3; ++corner)
+                        {
+                            new_vertices += local[indices[static_cast<size_t>(candidate) * 3 + corner]] == kNotInMeshlet ? 1 : 0;
+                        }
+                        if (meshlet.vertex_count + new_vertices > kMaxVertices) continue;
+
+                        const float score = static_cast<float>(new_vertices)
+                            + (1.0f - Dot(&normals[static_cast<size_t>(candidate) * 3], axis)) * 0.25f;
+                        if (next == kInvalid || score < best_score || (score == best_score && candidate < next))
+                        {
+                            next = candidate;
+                            best_score = score;
+                        }
+                    }
+                }
+            }
+
+            // Disconnected: continue with the next unused triangle in input order.
+            if (next == kInvalid && meshlet.vertex_count + 3 <= kMaxVertices)
+            {
+                while (seed_cursor < triangle_count && used[seed_cursor]) ++seed_cursor;
+                if (seed_cursor < triangle_count) next = static_cast<uint32_t>(seed_cursor);
+            }
+        }
+
+        for (uint32_t i = 0; i < meshlet.vertex_count; ++i) local[meshlet_vertices[i]] = kNotInMeshlet;
+
+        meshlet.vertex_offset = static_cast<uint32_t>(data.vertices.size());
+        meshlet.triangle_offset = static_cast<uint32_t>(data.triangles.size());
+        data.vertices.insert(data.vertices.end(), meshlet_vertices, meshlet_vertices + meshlet.vertex_count);
+        data.triangles.insert(data.triangles.end(), meshlet_triangles, meshlet_triangles + meshlet.triangle_count * 3);
+        data.bounds.push_back(ComputeBounds(meshlet, meshlet_vertices, normals.data(), triangle_ids, vertices, vertex_stride));
+        data.meshlets.push_back(meshlet);
+    }
+    return data.meshlets.size() - first_meshlet;
+}
+
+bool MeshletBuilder::IsVisible(const MeshletBounds& bounds, const float eye[3], const float* planes)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const float* p = planes + i * 4;
+        if (Dot(p, bounds.center) + p[3] < -bounds.radius) return false;
+    }
+
+    // Every triangle faces away from every point of the sphere.
+    const float d[3] = { bounds.center[0] - eye[0], bounds.center[1] - eye[1], bounds.center[2] - eye[2] };
+    return Dot(d, bounds.cone_axis) < bounds.cone_cutoff * sqrtf(Dot(d, d)) + bounds.radius;
+}
@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------------
+//  meshlet_builder.h
+//  Splits a submesh into meshlets (at most 64 vertices / 124 triangles) with
+//  bounding spheres and normal cones for cluster level frustum and backface
+//  culling (CPU only, deterministic).
+//  Triangles are grown greedily from a seed, preferring neighbours that add
+//  the fewest vertices and face the same way.  Cache optimized input
+//  (MeshOptimizer) gives the seeds spatial coherence.
+//  Indices are triangle lists.  Positions are float3 at the start of a vertex.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct Meshlet
+{
+    uint32_t vertex_offset;     // into MeshletData::vertices
+    uint32_t triangle_offset;   // into MeshletData::triangles (3 bytes per triangle)
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+};
+
+//--------------------------------------------------------------------------------
+//  32 bytes, usable as a structured buffer element by a compute prepass
+//--------------------------------------------------------------------------------
+struct MeshletBounds
+{
+    float center[3];
+    float radius;
+    float cone_axis[3];
+    float cone_cutoff;          // 1 when the cone cannot reject the meshlet
+};
+static_assert(sizeof(MeshletBounds) == 32, "MeshletBounds is mirrored by shaders");
+
+struct MeshletData
+{
+    std::vector<Meshlet>       meshlets;
+    std::vector<MeshletBounds> bounds;      // one per meshlet
+    std::vector<uint32_t>      vertices;    // submesh local vertex indices
+    std::vector<uint8_t>       triangles;   // meshlet local vertex indices
+
+    void Clear()
+    {
+        meshlets.clear();
+        bounds.clear();
+        vertices.clear();
+        triangles.clear();
+    }
+};
+
+class MeshletBuilder
+{
+public:
+    static constexpr uint32_t kMaxVertices = 64;
+    static constexpr uint32_t kMaxTriangles = 124;
+
+    //--------------------------------------------------------------------------------
+    //  Append the meshlets of one index range to data.  indices are relative to
+    //  the submesh base vertex.  Returns the number of meshlets appended.
+    //--------------------------------------------------------------------------------
+    static size_t Build(MeshletData& data, const uint32_t* indices, size_t index_count,
+        const void* vertices, size_t vertex_count, uint32_t vertex_stride);
+
+    //--------------------------------------------------------------------------------
+    //  Conservative visibility of a meshlet in the same space as bounds.
+    //  planes : 6 planes (xyzw) pointing inside, e.g. the output of
+    //           CullingSystem::ExtractFrustumPlanes
+    //--------------------------------------------------------------------------------
+    static bool IsVisible(const MeshletBounds& bounds, const float eye[3], const float* planes);
+};
@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------------
+//  mpsc_queue.h
+//  Bounded lock-free multi producer / single consumer queue (portable C++17).
+//  Ring of cells tagged with a sequence number (Vyukov): producers claim a
+//  cell with one CAS on the tail, the consumer owns the head.  Nothing is
+//  allocated after construction and neither side ever blocks; TryPush fails
+//  when the queue is full and TryPop when it is empty.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+template <class T>
+class MpscQueue
+{
+public:
+    //--------------------------------------------------------------------------------
+    //  capacity must be a power of 2
+    //--------------------------------------------------------------------------------
+    explicit MpscQueue(uint32_t capacity)
+        : cells_(new Cell[capacity])
+        , mask_(capacity - 1)
+    {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        for (uint32_t i = 0; i < capacity; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Any thread
+    //--------------------------------------------------------------------------------
+    template <class U>
+    bool TryPush(U&& value)
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = cells_[tail & mask_];
+            const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const int32_t difference = static_cast<int32_t>(sequence - tail);
+            if (difference == 0)
+            {
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::forward<U>(value);
+                    cell.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;   // full: the consumer has not released this cell yet
+            }
+            else
+            {
+                tail = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Consumer thread only
+    //--------------------------------------------------------------------------------
+    bool TryPop(T& value)
+    {
+        Cell& cell = cells_[head_ & mask_];
+        const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<int32_t>(sequence - (head_ + 1)) < 0) return false;
+
+        value = std::move(cell.value);
+        cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    uint32_t Capacity() const { return mask_ + 1; }
+
+private:
+    MpscQueue(const MpscQueue& rhs) = delete;
+    MpscQueue& operator=(const MpscQueue& rhs) = delete;
+
+    struct Cell
+    {
+        std::atomic<uint32_t> sequence{ 0 };
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    const uint32_t mask_;
+    alignas(64) std::atomic<uint32_t> tail_{ 0 };
+    alignas(64) uint32_t head_ = 0;
+};
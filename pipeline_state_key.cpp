@@ -0,0 +1,440 @@
+//--------------------------------------------------------------------------------
+//  pipeline_state_key.cpp
+//--------------------------------------------------------------------------------
+#include "pipeline_state_key.h"
+#include "hash_util.h"
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    struct Encoder
+    {
+        vector<uint32_t>& words;
+        ShaderIdentity shader_identity;
+
+        void Push(uint32_t word) { words.push_back(word); }
+        void Push64(uint64_t value)
+        {
+            words.push_back(static_cast<uint32_t>(value));
+            words.push_back(static_cast<uint32_t>(value >> 32));
+        }
+        void PushFloat(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            words.push_back(bits);
+        }
+        void PushString(const char* value)
+        {
+            if (shader_identity == ShaderIdentity::kContents)
+            {
+                Push64(value ? HashBytes(value, strlen(value)) : 0);
+            }
+            else
+            {
+                Push64(reinterpret_cast<uintptr_t>(value));
+            }
+        }
+    };
+
+    //--------------------------------------------------------------------------------
+    //  Encoders, one per inner struct
+    //--------------------------------------------------------------------------------
+    template <typename Value>
+    void EncodeValue(const Value& value, Encoder& encoder)
+    {
+        encoder.Push(static_cast<uint32_t>(value));
+    }
+
+    void EncodeRootSignature(ID3D12RootSignature* const& root_signature, Encoder& encoder)
+    {
+        encoder.Push64(reinterpret_cast<uintptr_t>(root_signature));
+    }
+
+    void EncodeShader(const D3D12_SHADER_BYTECODE& shader, Encoder& encoder)
+    {
+        if (shader.BytecodeLength == 0)
+        {
+            return;
+        }
+        if (encoder.shader_identity == ShaderIdentity::kContents)
+        {
+            encoder.Push64(HashBytes(shader.pShaderBytecode, shader.BytecodeLength));
+        }
+        else
+        {
+            encoder.Push64(reinterpret_cast<uintptr_t>(shader.pShaderBytecode));
+        }
+        encoder.Push64(shader.BytecodeLength);
+    }
+
+    void EncodeInputLayout(const D3D12_INPUT_LAYOUT_DESC& layout, Encoder& encoder)
+    {
+        encoder.Push(layout.NumElements);
+        for (UINT i = 0; i < layout.NumElements; ++i)
+        {
+            const D3D12_INPUT_ELEMENT_DESC& element = layout.pInputElementDescs[i];
+            encoder.PushString(element.SemanticName);
+            encoder.Push(element.SemanticIndex);
+            encoder.Push(element.Format);
+            encoder.Push(element.InputSlot);
+            encoder.Push(element.AlignedByteOffset);
+            encoder.Push(element.InputSlotClass);
+            encoder.Push(element.InstanceDataStepRate);
+        }
+    }
+
+    void EncodeStreamOutput(const D3D12_STREAM_OUTPUT_DESC& stream_output, Encoder& encoder)
+    {
+        encoder.Push(stream_output.NumEntries);
+        for (UINT i = 0; i < stream_output.NumEntries; ++i)
+        {
+            const D3D12_SO_DECLARATION_ENTRY& entry = stream_output.pSODeclaration[i];
+            encoder.Push(entry.Stream);
+            encoder.PushString(entry.SemanticName);
+            encoder.Push(entry.SemanticIndex);
+            encoder.Push(entry.StartComponent | entry.ComponentCount << 8 | entry.OutputSlot << 16);
+        }
+        encoder.Push(stream_output.NumStrides);
+        for (UINT i = 0; i < stream_output.NumStrides; ++i)
+        {
+            encoder.Push(stream_output.pBufferStrides[i]);
+        }
+        encoder.Push(stream_output.RasterizedStream);
+    }
+
+    void EncodeBlend(const D3D12_BLEND_DESC& blend, Encoder& encoder)
+    {
+        encoder.Push((blend.AlphaToCoverageEnable ? 1 : 0) | (blend.IndependentBlendEnable ? 2 : 0));
+
+        // Only RenderTarget[0] is used unless blending is independent.
+        const UINT count = blend.IndependentBlendEnable ? D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT : 1;
+        for (UINT i = 0; i < count; ++i)
+        {
+            const D3D12_RENDER_TARGET_BLEND_DESC& target = blend.RenderTarget[i];
+            if (target.BlendEnable)
+            {
+                encoder.Push(1 | target.SrcBlend << 8 | target.DestBlend << 16 | target.BlendOp << 24);
+                encoder.Push(target.SrcBlendAlpha | target.DestBlendAlpha << 8 | target.BlendOpAlpha << 16);
+            }
+            else
+            {
+                encoder.Push(0);
+                encoder.Push(0);
+            }
+            const uint32_t logic_op = target.LogicOpEnable ? (1 | target.LogicOp << 8) : 0;
+            encoder.Push(logic_op | target.RenderTargetWriteMask << 16);
+        }
+    }
+
+    void EncodeRasterizer(const D3D12_RASTERIZER_DESC& rasterizer, Encoder& encoder)
+    {
+        encoder.Push(rasterizer.FillMode
+            | rasterizer.CullMode << 4
+            | (rasterizer.FrontCounterClockwise ? 1 : 0) << 8
+            | (rasterizer.DepthClipEnable ? 1 : 0) << 9
+            | (rasterizer.MultisampleEnable ? 1 : 0) << 10
+            | (rasterizer.AntialiasedLineEnable ? 1 : 0) << 11
+            | rasterizer.ConservativeRaster << 12);
+        encoder.Push(static_cast<uint32_t>(rasterizer.DepthBias));
+        encoder.PushFloat(rasterizer.DepthBiasClamp);
+        encoder.PushFloat(rasterizer.SlopeScaledDepthBias);
+        encoder.Push(rasterizer.ForcedSampleCount);
+    }
+
+    uint32_t StencilOps(const D3D12_DEPTH_STENCILOP_DESC& face)
+    {
+        return face.StencilFailOp | face.StencilDepthFailOp << 8 | face.StencilPassOp << 16 | face.StencilFunc << 24;
+    }
+
+    void EncodeDepthStencil1(const D3D12_DEPTH_STENCIL_DESC1& depth_stencil, Encoder& encoder)
+    {
+        uint32_t word = (depth_stencil.StencilEnable ? 1 : 0) << 8 | (depth_stencil.DepthBoundsTestEnable ? 1 : 0) << 9;
+        if (depth_stencil.DepthEnable)
+        {
+            word |= 1 | depth_stencil.DepthWriteMask << 1 | depth_stencil.DepthFunc << 4;
+        }
+        encoder.Push(word);
+        if (depth_stencil.StencilEnable)
+        {
+            encoder.Push(depth_stencil.StencilReadMask | depth_stencil.StencilWriteMask << 8);
+            encoder.Push(StencilOps(depth_stencil.FrontFace));
+            encoder.Push(StencilOps(depth_stencil.BackFace));
+        }
+    }
+
+    void EncodeDepthStencil(const D3D12_DEPTH_STENCIL_DESC& depth_stencil, Encoder& encoder)
+    {
+        EncodeDepthStencil1(CD3DX12_DEPTH_STENCIL_DESC1(depth_stencil), encoder);
+    }
+
+    void EncodeRenderTargetFormats(const D3D12_RT_FORMAT_ARRAY& formats, Encoder& encoder)
+    {
+        const UINT count = MathHelper::Min(formats.NumRenderTargets, static_cast<UINT>(D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT));
+        encoder.Push(count);
+        for (UINT i = 0; i < count; ++i)
+        {
+            encoder.Push(formats.RTFormats[i]);
+        }
+    }
+
+    void EncodeSampleDesc(const DXGI_SAMPLE_DESC& sample_desc, Encoder& encoder)
+    {
+        encoder.Push(sample_desc.Count);
+        encoder.Push(sample_desc.Quality);
+    }
+
+    void EncodeViewInstancing(const D3D12_VIEW_INSTANCING_DESC& view_instancing, Encoder& encoder)
+    {
+        encoder.Push(view_instancing.ViewInstanceCount);
+        encoder.Push(view_instancing.Flags);
+        for (UINT i = 0; i < view_instancing.ViewInstanceCount; ++i)
+        {
+            const D3D12_VIEW_INSTANCE_LOCATION& location = view_instancing.pViewInstanceLocations[i];
+            encoder.Push(location.ViewportArrayIndex | location.RenderTargetArrayIndex << 16);
+        }
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Subobject table
+    //--------------------------------------------------------------------------------
+    typedef void (*EncodeFunction)(const void* subobject, Encoder& encoder);
+
+    // Same access as D3DX12ParsePipelineStream: the stream wrapper converts
+    // to a reference to its inner struct.
+    template <typename Subobject, typename Desc, void (*Encode)(const Desc&, Encoder&)>
+    void EncodeSubobject(const void* subobject, Encoder& encoder)
+    {
+        Subobject& wrapper = *const_cast<Subobject*>(static_cast<const Subobject*>(subobject));
+        const Desc& desc = wrapper;
+        Encode(desc, encoder);
+    }
+
+    struct SubobjectEntry
+    {
+        SIZE_T size = 0;                                // 0: unknown type
+        EncodeFunction encode = nullptr;                // nullptr: does not identify the pipeline
+        UINT segment_type = 0;
+        bool has_default = false;
+        vector<uint32_t> default_words;
+    };
+
+    class SubobjectTable
+    {
+    public:
+        SubobjectTable()
+        {
+            // Defaults are the CD3DX12 ones.  The topology type and the depth
+            // stencil state are always kept, their defaults when absent are
+            // not the same for every consumer of the stream.
+            Add<CD3DX12_PIPELINE_STATE_STREAM_FLAGS, D3D12_PIPELINE_STATE_FLAGS, EncodeValue>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK, UINT, EncodeValue>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE, ID3D12RootSignature*, EncodeRootSignature>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT, D3D12_INPUT_LAYOUT_DESC, EncodeInputLayout>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE, D3D12_INDEX_BUFFER_STRIP_CUT_VALUE, EncodeValue>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY, D3D12_PRIMITIVE_TOPOLOGY_TYPE, EncodeValue>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY, false);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_VS, D3D12_SHADER_BYTECODE, EncodeShader>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_GS, D3D12_SHADER_BYTECODE, EncodeShader>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT, D3D12_STREAM_OUTPUT_DESC, EncodeStreamOutput>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_HS, D3D12_SHADER_BYTECODE, EncodeShader>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_DS, D3D12_SHADER_BYTECODE, EncodeShader>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_PS, D3D12_SHADER_BYTECODE, EncodeShader>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_CS, D3D12_SHADER_BYTECODE, EncodeShader>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC, D3D12_BLEND_DESC, EncodeBlend>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL, D3D12_DEPTH_STENCIL_DESC, EncodeDepthStencil>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL, false);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1, D3D12_DEPTH_STENCIL_DESC1, EncodeDepthStencil1>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1, false);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT, DXGI_FORMAT, EncodeValue>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER, D3D12_RASTERIZER_DESC, EncodeRasterizer>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS, D3D12_RT_FORMAT_ARRAY, EncodeRenderTargetFormats>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC, DXGI_SAMPLE_DESC, EncodeSampleDesc>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK, UINT, EncodeValue>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK, true);
+            Add<CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING, D3D12_VIEW_INSTANCING_DESC, EncodeViewInstancing>(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING, true);
+
+            // A cached blob only speeds up creation.
+            entries_[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO].size = sizeof(CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO);
+
+            // Both depth stencil versions share one segment.
+            entries_[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL].segment_type = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1;
+        }
+
+        const SubobjectEntry& operator[](UINT type) const { return entries_[type]; }
+
+    private:
+        template <typename Subobject, typename Desc, void (*Encode)(const Desc&, Encoder&)>
+        void Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, bool has_default)
+        {
+            SubobjectEntry& entry = entries_[type];
+            entry.size = sizeof(Subobject);
+            entry.encode = EncodeSubobject<Subobject, Desc, Encode>;
+            entry.segment_type = type;
+            entry.has_default = has_default;
+            if (has_default)
+            {
+                Subobject subobject;
+                Encoder encoder = { entry.default_words, ShaderIdentity::kAddress };
+                entry.encode(&subobject, encoder);
+            }
+        }
+
+        SubobjectEntry entries_[kPipelineSubobjectTypeCount];
+    };
+
+    const SubobjectTable& Table()
+    {
+        static const SubobjectTable table;
+        return table;
+    }
+
+    bool IsDefault(const SubobjectEntry& entry, const uint32_t* words, size_t size)
+    {
+        return entry.has_default
+            && entry.default_words.size() == size
+            && (size == 0 || memcmp(entry.default_words.data(), words, size * sizeof(uint32_t)) == 0);
+    }
+
+    bool SegmentsEqual(const PipelineStateKey& lhs, const PipelineStateKey& rhs, UINT type)
+    {
+        UINT lhs_size, rhs_size;
+        const uint32_t* lhs_words = lhs.Segment(static_cast<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE>(type), &lhs_size);
+        const uint32_t* rhs_words = rhs.Segment(static_cast<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE>(type), &rhs_size);
+        return lhs_size == rhs_size && memcmp(lhs_words, rhs_words, lhs_size * sizeof(uint32_t)) == 0;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+const uint32_t* PipelineStateKey::Segment(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, UINT* size) const
+{
+    if (type >= kPipelineSubobjectTypeCount || (present & 1ull << type) == 0)
+    {
+        *size = 0;
+        return nullptr;
+    }
+    const uint32_t* header = words.data() + offsets[type];
+    *size = *header >> 8;
+    return header + 1;
+}
+
+bool PipelineStateKey::operator==(const PipelineStateKey& rhs) const
+{
+    if (hash != rhs.hash || present != rhs.present)
+    {
+        return false;
+    }
+    for (UINT type = 0; type < kPipelineSubobjectTypeCount; ++type)
+    {
+        if ((present & 1ull << type) != 0 && !SegmentsEqual(*this, rhs, type))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BuildPipelineStateKey(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, PipelineStateKey& key, ShaderIdentity shader_identity)
+{
+    key.hash = 0;
+    key.present = 0;
+    key.words.clear();
+    if (desc.SizeInBytes == 0 || desc.pPipelineStateSubobjectStream == nullptr)
+    {
+        return false;
+    }
+
+    const SubobjectTable& table = Table();
+    const BYTE* stream = static_cast<const BYTE*>(desc.pPipelineStateSubobjectStream);
+    Encoder encoder = { key.words, shader_identity };
+    uint64_t seen = 0;
+
+    for (SIZE_T offset = 0; offset < desc.SizeInBytes;)
+    {
+        if (desc.SizeInBytes - offset < sizeof(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE))
+        {
+            return false;
+        }
+        const UINT type = *reinterpret_cast<const D3D12_PIPELINE_STATE_SUBOBJECT_TYPE*>(stream + offset);
+        if (type >= kPipelineSubobjectTypeCount || table[type].size == 0)
+        {
+            return false;
+        }
+        const SubobjectEntry& entry = table[type];
+        const uint64_t bit = 1ull << entry.segment_type;
+        if (entry.size > desc.SizeInBytes - offset || (seen & bit) != 0)
+        {
+            return false;
+        }
+        seen |= bit;
+
+        if (entry.encode)
+        {
+            const size_t start = key.words.size();
+            key.words.push_back(0);
+            entry.encode(stream + offset, encoder);
+            uint32_t* segment = key.words.data() + start;
+            const size_t size = key.words.size() - start - 1;
+            if (IsDefault(entry, segment + 1, size))
+            {
+                key.words.resize(start);
+            }
+            else
+            {
+                segment[0] = entry.segment_type | static_cast<uint32_t>(size) << 8;
+                key.offsets[entry.segment_type] = static_cast<uint32_t>(start);
+                key.present |= bit;
+                key.hash += MixHash(HashWords(segment, size + 1));
+            }
+        }
+        offset += entry.size;
+    }
+    return true;
+}
+
+uint64_t Differences(const PipelineStateKey& lhs, const PipelineStateKey& rhs)
+{
+    uint64_t differences = lhs.present ^ rhs.present;
+    const uint64_t both = lhs.present & rhs.present;
+    for (UINT type = 0; type < kPipelineSubobjectTypeCount; ++type)
+    {
+        if ((both & 1ull << type) != 0 && !SegmentsEqual(lhs, rhs, type))
+        {
+            differences |= 1ull << type;
+        }
+    }
+    return differences;
+}
+
+const char* PipelineSubobjectName(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type)
+{
+    switch (type)
+    {
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE: return "RootSignature";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS: return "VS";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS: return "PS";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS: return "DS";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS: return "HS";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS: return "GS";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS: return "CS";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT: return "StreamOutput";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND: return "Blend";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK: return "SampleMask";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER: return "Rasterizer";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL: return "DepthStencil";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT: return "InputLayout";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE: return "IBStripCutValue";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY: return "PrimitiveTopology";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS: return "RenderTargetFormats";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT: return "DepthStencilFormat";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC: return "SampleDesc";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK: return "NodeMask";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO: return "CachedPSO";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS: return "Flags";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1: return "DepthStencil1";
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING: return "ViewInstancing";
+    default: return "Unknown";
+    }
+}
@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------
+//  pipeline_state_key.h
+//  Canonical key of a D3D12_PIPELINE_STATE_STREAM_DESC, the lookup key of a
+//  PSO cache.
+//  - The stream is walked once through a table indexed by subobject type
+//    (size + encoder function), no virtual callbacks as in
+//    D3DX12ParsePipelineStream.
+//  - Every subobject is packed into a few words (a segment).  Fields the
+//    driver ignores are zeroed (blend factors of disabled targets, stencil
+//    ops with stencil off), DEPTH_STENCIL is stored as DEPTH_STENCIL1 and
+//    subobjects equal to their default are dropped, so equivalent streams
+//    have equal keys whatever the subobject order.
+//  - hash is the sum of the segment hashes, so it does not depend on the
+//    order either.  Segments are kept for equality and Differences().
+//  - A few hundred ns per stream: build the key once per material and keep
+//    it, a bind then only looks up key.hash.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+
+//--------------------------------------------------------------------------------
+//  How shader bytecode and semantic names are identified
+//  kAddress  : by pointer, enough while the blobs and input layouts are alive
+//              (in process caches); equal data at two addresses only costs a
+//              duplicate PSO
+//  kContents : by hash of the data, for keys that outlive the blobs
+//--------------------------------------------------------------------------------
+enum class ShaderIdentity
+{
+    kAddress,
+    kContents,
+};
+
+constexpr UINT kPipelineSubobjectTypeCount = D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID;
+static_assert(kPipelineSubobjectTypeCount <= 64, "subobject mask is 64 bits");
+
+struct PipelineStateKey
+{
+    uint64_t hash = 0;
+    uint64_t present = 0;                               // bit per subobject type with a segment
+    uint32_t offsets[kPipelineSubobjectTypeCount] = {}; // segment of each present type in words
+    std::vector<uint32_t> words;                        // segments: header (type | size << 8), payload
+
+    //--------------------------------------------------------------------------------
+    //  Payload of the segment of type, nullptr when absent or default
+    //--------------------------------------------------------------------------------
+    const uint32_t* Segment(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, UINT* size) const;
+
+    bool operator==(const PipelineStateKey& rhs) const;
+    bool operator!=(const PipelineStateKey& rhs) const { return !(*this == rhs); }
+};
+
+//--------------------------------------------------------------------------------
+//  Builds key from desc in one pass.  key.words keeps its capacity, so reusing
+//  the same key does not allocate once warmed up.  Returns false for the
+//  streams D3DX12ParsePipelineStream rejects (unknown or duplicated subobject,
+//  truncated stream).
+//--------------------------------------------------------------------------------
+bool BuildPipelineStateKey(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, PipelineStateKey& key,
+    ShaderIdentity shader_identity = ShaderIdentity::kAddress);
+
+//--------------------------------------------------------------------------------
+//  Bit per subobject type whose segments differ
+//--------------------------------------------------------------------------------
+uint64_t Differences(const PipelineStateKey& lhs, const PipelineStateKey& rhs);
+
+const char* PipelineSubobjectName(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type);
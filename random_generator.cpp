@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------
+//  random_generator.cpp
+//--------------------------------------------------------------------------------
+#include "random_generator.h"
+#include <atomic>
+
+namespace
+{
+    std::atomic<uint64_t> global_seed(RandomGenerator::kDefaultSeed);
+    std::atomic<uint64_t> thread_stream_count(0);
+
+    uint64_t SplitMix64(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+}
+
+//--------------------------------------------------------------------------------
+//  Reset the state from a 64bit seed
+//--------------------------------------------------------------------------------
+void RandomGenerator::Seed(uint64_t seed)
+{
+    const uint64_t a = SplitMix64(seed);
+    const uint64_t b = SplitMix64(seed);
+    state_[0] = static_cast<uint32_t>(a);
+    state_[1] = static_cast<uint32_t>(a >> 32);
+    state_[2] = static_cast<uint32_t>(b);
+    state_[3] = static_cast<uint32_t>(b >> 32);
+
+    // xoshiro must never be all zero.
+    if ((state_[0] | state_[1] | state_[2] | state_[3]) == 0) state_[0] = 1;
+}
+
+//--------------------------------------------------------------------------------
+//  Returns random int in [a, b] (Lemire's multiply-shift with rejection)
+//--------------------------------------------------------------------------------
+int RandomGenerator::NextInt(int a, int b)
+{
+    const uint32_t range = static_cast<uint32_t>(b) - static_cast<uint32_t>(a) + 1u;
+    if (range == 0) return static_cast<int>(NextUint()); // full 32bit range
+
+    uint64_t m = static_cast<uint64_t>(NextUint()) * range;
+    uint32_t low = static_cast<uint32_t>(m);
+    if (low < range)
+    {
+        const uint32_t threshold = (0u - range) % range;
+        while (low < threshold)
+        {
+            m = static_cast<uint64_t>(NextUint()) * range;
+            low = static_cast<uint32_t>(m);
+        }
+    }
+    return static_cast<int>(static_cast<uint32_t>(a) + static_cast<uint32_t>(m >> 32));
+}
+
+//--------------------------------------------------------------------------------
+//  Fill count floats in [0, 1)
+//--------------------------------------------------------------------------------
+void RandomGenerator::FillFloat(float* out, size_t count)
+{
+    // Work on a local copy so the compiler can keep the state in registers.
+    RandomGenerator local = *this;
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[i] = local.NextFloat();
+    }
+    *this = local;
+}
+
+//--------------------------------------------------------------------------------
+//  Generator owned by the calling thread
+//--------------------------------------------------------------------------------
+RandomGenerator& RandomGenerator::ThreadLocal()
+{
+    thread_local RandomGenerator generator(
+        global_seed.load(std::memory_order_relaxed)
+        + thread_stream_count.fetch_add(1, std::memory_order_relaxed) * 0xd1b54a32d192ed03ULL);
+    return generator;
+}
+
+//--------------------------------------------------------------------------------
+//  Global seed used by threads that did not create their generator yet
+//--------------------------------------------------------------------------------
+void RandomGenerator::SetGlobalSeed(uint64_t seed)
+{
+    global_seed.store(seed, std::memory_order_relaxed);
+    thread_stream_count.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------------------
+//  random_generator.h
+//  xoshiro128+ based pseudo random generator.
+//  Each thread owns its own generator (see ThreadLocal), so there is no shared
+//  hidden state like rand() and sequences are reproducible per thread.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+class RandomGenerator
+{
+public:
+    static constexpr uint64_t kDefaultSeed = 0x853c49e6748fea9bULL;
+
+    explicit RandomGenerator(uint64_t seed = kDefaultSeed) { Seed(seed); }
+
+    //--------------------------------------------------------------------------------
+    //  Reset the state from a 64bit seed (expanded with splitmix64)
+    //--------------------------------------------------------------------------------
+    void Seed(uint64_t seed);
+
+    //--------------------------------------------------------------------------------
+    //  Returns next 32bit value
+    //--------------------------------------------------------------------------------
+    uint32_t NextUint()
+    {
+        const uint32_t result = state_[0] + state_[3];
+        const uint32_t t = state_[1] << 9;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = (state_[3] << 11) | (state_[3] >> 21);
+        return result;
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Returns random float in [0, 1).
+    //  Only the upper 24 bits are used since the low bits of xoshiro128+ are weak.
+    //--------------------------------------------------------------------------------
+    float NextFloat()
+    {
+        return static_cast<float>(NextUint() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Returns random float in [a, b).
+    //--------------------------------------------------------------------------------
+    float NextFloat(float a, float b)
+    {
+        return a + NextFloat() * (b - a);
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Returns random int in [a, b] without modulo bias.
+    //--------------------------------------------------------------------------------
+    int NextInt(int a, int b);
+
+    //--------------------------------------------------------------------------------
+    //  Fill count floats in [0, 1)
+    //--------------------------------------------------------------------------------
+    void FillFloat(float* out, size_t count);
+
+    //--------------------------------------------------------------------------------
+    //  Generator owned by the calling thread.
+    //  Threads are seeded from the global seed and the order they first ask for it.
+    //--------------------------------------------------------------------------------
+    static RandomGenerator& ThreadLocal();
+
+    //--------------------------------------------------------------------------------
+    //  Global seed used by threads that did not create their generator yet
+    //--------------------------------------------------------------------------------
+    static void SetGlobalSeed(uint64_t seed);
+
+private:
+    uint32_t state_[4];
+};
@@ -1,6 +1,10 @@
 #include "render_system.h"
 #include "game_system.h"
+#include "render_thread.h"
+#include "root_signature_cache.h"
+#include "bindless_descriptor_heap.h"
 #include <DirectXColors.h>
+#include <chrono>
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -52,7 +56,6 @@ bool RenderSystem::Initialize()
         IID_PPV_ARGS(&fence_)));
 
     rtv_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    dsv_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
     cbv_srv_uav_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
     // Check 4X MSAA quality support for our back buffer format.
@@ -76,52 +79,204 @@ bool RenderSystem::Initialize()
     LogAdapters();
 #endif
 
+    // Root signatures are shared and their blobs cached next to the shaders.
+    root_signature_cache_ = RootSignatureCache::Create();
+    root_signature_cache_->Initialize(device_.Get(), kShaderCacheDirectory);
+
+    // Streamed textures and buffers are bound by index into one heap.
+    bindless_heap_ = BindlessDescriptorHeap::Create();
+    bindless_heap_->Initialize(device_.Get());
+
     CreateCommandObjects();
+    CreateTimestampQueries();
     CreateSwapChain();
-    CreateRtvAndDsvDescriptorHeaps();
+    CreateRtvDescriptorHeap();
+    render_target_pool_.Initialize(device_.Get());
+    hi_z_buffer_.Initialize(device_.Get());
+
+    // The upscale reads the scene target through the bindless table.
+    if (bindless_heap_->IsSupported())
+    {
+        upscale_pass_.Initialize(device_.Get(), back_buffer_format_);
+        dynamic_resolution_state_ = true;
+    }
 
-    OnResize();
+    OnResize(GameSystem::Instance().Width(), GameSystem::Instance().Height());
     return true;
 }
 
 void RenderSystem::Release()
 {
+    // Frames may still be in flight.
+    if (fence_) FlushCommandQueue();
+    render_target_pool_.Release();
+    hi_z_buffer_.Release();
+    if (bindless_heap_) bindless_heap_->Release();
+    if (root_signature_cache_) root_signature_cache_->Release();
     delete this;
 }
 
-void RenderSystem::PrepareRender()
+void RenderSystem::PrepareRender(const RenderPacket& packet)
 {
-
+    // Copy what Render needs; the packet is handed back to the game thread after Render.
+    memcpy(clear_color_, packet.clear_color, sizeof(clear_color_));
 }
 
 void RenderSystem::Render()
 {
     // Reuse the memory associated with command recording.
-    // We can only reset when the associated command lists have finished execution on the GPU.
-    ThrowIfFailed(command_list_allocator_->Reset());
+    // We can only reset when the associated command lists have finished execution on the GPU,
+    // so wait for the frame that last used this allocator (kSwapChainBufferCount frames ago).
+    WaitForFence(frame_fences_[frame_index_]);
+
+    // That frame is also the latest whose GPU time is known.
+    double gpu_ms = 0.0;
+    if (ReadGpuFrameTime(frame_index_, &gpu_ms) && dynamic_resolution_state_)
+    {
+        resolution_controller_.Update(static_cast<float>(gpu_ms));
+    }
+
+    ID3D12CommandAllocator* command_list_allocator = command_list_allocators_[frame_index_].Get();
+    ThrowIfFailed(command_list_allocator->Reset());
 
     // A command list can be reset after it has been added to the command queue via ExecuteCommandList.
     // Reusing the command list reuses memory.
-    ThrowIfFailed(command_list_->Reset(command_list_allocator_.Get(), nullptr));
+    ThrowIfFailed(command_list_->Reset(command_list_allocator, nullptr));
+
+    // Views released by the loaders before this point can be reused once the
+    // frames that might read them are done; this frame signals current_fence_ + 1.
+    bindless_heap_->BeginFrame(fence_->GetCompletedValue(), current_fence_ + 1);
+    ID3D12DescriptorHeap* descriptor_heaps[] = { bindless_heap_->Heap() };
+    command_list_->SetDescriptorHeaps(_countof(descriptor_heaps), descriptor_heaps);
+
+    command_list_->EndQuery(timestamp_heap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frame_index_ * 2);
+
+    // Below the output size the scene goes to a pooled target that is
+    // stretched over the back buffer at the end of the frame.
+    UINT render_width = 0;
+    UINT render_height = 0;
+    RenderSize(&render_width, &render_height);
+    const bool upscale = render_width != client_width_ || render_height != client_height_;
+
+    // Depth, with MSAA a multisampled color target, and when upscaling the scene
+    // target come from the pool; otherwise the back buffer is rendered to directly.
+    const UINT64 completed_fence = fence_->GetCompletedValue();
+    const PooledRenderTarget* depth_target = render_target_pool_.Acquire(
+        FrameTargetDesc(true, msaa_state_, render_width, render_height), completed_fence);
+    const PooledRenderTarget* msaa_target = msaa_state_ ? render_target_pool_.Acquire(
+        FrameTargetDesc(false, true, render_width, render_height), completed_fence) : nullptr;
+    const PooledRenderTarget* scene_target = upscale ? render_target_pool_.Acquire(
+        FrameTargetDesc(false, false, render_width, render_height), completed_fence) : nullptr;
+    const PooledRenderTarget* color_target = msaa_target ? msaa_target : scene_target;
+    const D3D12_CPU_DESCRIPTOR_HANDLE render_target_view = color_target ? color_target->view : CurrentBackBufferView();
 
     // Indicate a state transition on the resource usage.
-    command_list_->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-        D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+    if (!color_target)
+    {
+        command_list_->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
+            D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+    }
 
     // Set the viewport and scissor rect.  This needs to be reset whenever the command list is reset.
-    command_list_->RSSetViewports(1, &screen_viewport_);
-    command_list_->RSSetScissorRects(1, &scissor_rect_);
+    D3D12_VIEWPORT render_viewport = screen_viewport_;
+    render_viewport.Width = static_cast<float>(render_width);
+    render_viewport.Height = static_cast<float>(render_height);
+    const D3D12_RECT render_rect = { 0, 0, static_cast<LONG>(render_width), static_cast<LONG>(render_height) };
+    command_list_->RSSetViewports(1, &render_viewport);
+    command_list_->RSSetScissorRects(1, &render_rect);
 
     // Clear the back buffer and depth buffer.
-    command_list_->ClearRenderTargetView(CurrentBackBufferView(), Colors::LightSteelBlue, 0, nullptr);
-    command_list_->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+    command_list_->ClearRenderTargetView(render_target_view, clear_color_, 0, nullptr);
+    command_list_->ClearDepthStencilView(depth_target->view, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+
+    // The depth prepass draws no occluders yet, so the depth buffer is still
+    // clear here and a pyramid of it would hide nothing.  It is only built
+    // when enabled (SetHiZState), keeping it out of the frame time that
+    // dynamic resolution reacts to.
+    if (hi_z_state_)
+    {
+        command_list_->OMSetRenderTargets(0, nullptr, false, &depth_target->view);
+        hi_z_buffer_.Build(command_list_.Get(), depth_target->resource.Get(), DXGI_FORMAT_R24_UNORM_X8_TYPELESS,
+            depth_target->desc.sample_count, render_width, render_height);
+    }
 
     // Specify the buffers we are going to render to.
-    command_list_->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
+    command_list_->OMSetRenderTargets(1, &render_target_view, true, &depth_target->view);
 
-    // Indicate a state transition on the resource usage.
-    command_list_->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-        D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+    if (msaa_target)
+    {
+        // Resolve the rendered area (the pooled target may be larger) into the
+        // scene target, or straight into the back buffer.
+        ID3D12Resource* destination = scene_target ? scene_target->resource.Get() : CurrentBackBuffer();
+        const D3D12_RESOURCE_STATES destination_state = scene_target ? D3D12_RESOURCE_STATE_RENDER_TARGET : D3D12_RESOURCE_STATE_PRESENT;
+        const CD3DX12_RESOURCE_BARRIER to_resolve[] =
+        {
+            CD3DX12_RESOURCE_BARRIER::Transition(msaa_target->resource.Get(),
+                D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RESOLVE_SOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(destination,
+                destination_state, D3D12_RESOURCE_STATE_RESOLVE_DEST),
+        };
+        command_list_->ResourceBarrier(_countof(to_resolve), to_resolve);
+
+        D3D12_RECT region = render_rect;
+        command_list1_->ResolveSubresourceRegion(destination, 0, 0, 0,
+            msaa_target->resource.Get(), 0, &region, back_buffer_format_, D3D12_RESOLVE_MODE_AVERAGE);
+
+        const CD3DX12_RESOURCE_BARRIER from_resolve[] =
+        {
+            CD3DX12_RESOURCE_BARRIER::Transition(msaa_target->resource.Get(),
+                D3D12_RESOURCE_STATE_RESOLVE_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET),
+            CD3DX12_RESOURCE_BARRIER::Transition(destination,
+                D3D12_RESOURCE_STATE_RESOLVE_DEST, destination_state),
+        };
+        command_list_->ResourceBarrier(_countof(from_resolve), from_resolve);
+    }
+
+    if (scene_target)
+    {
+        // Stretch the scene over the whole back buffer.
+        const CD3DX12_RESOURCE_BARRIER to_upscale[] =
+        {
+            CD3DX12_RESOURCE_BARRIER::Transition(scene_target->resource.Get(),
+                D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
+                D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET),
+        };
+        command_list_->ResourceBarrier(_countof(to_upscale), to_upscale);
+
+        command_list_->RSSetViewports(1, &screen_viewport_);
+        command_list_->RSSetScissorRects(1, &scissor_rect_);
+        command_list_->OMSetRenderTargets(1, &CurrentBackBufferView(), true, nullptr);
+
+        // The target may be regrown between frames, so the view lives for one
+        // frame; its slot is reused once this frame is done.
+        const BindlessHandle source = bindless_heap_->CreateShaderResourceView(scene_target->resource.Get(), nullptr);
+        if (!source.IsNull())
+        {
+            upscale_pass_.Draw(command_list_.Get(), source, scene_target->desc, render_width, render_height);
+            bindless_heap_->ReleaseView(source);
+        }
+
+        const CD3DX12_RESOURCE_BARRIER from_upscale[] =
+        {
+            CD3DX12_RESOURCE_BARRIER::Transition(scene_target->resource.Get(),
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET),
+            CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
+                D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT),
+        };
+        command_list_->ResourceBarrier(_countof(from_upscale), from_upscale);
+    }
+    else if (!msaa_target)
+    {
+        // Indicate a state transition on the resource usage.
+        command_list_->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+    }
+
+    command_list_->EndQuery(timestamp_heap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frame_index_ * 2 + 1);
+    command_list_->ResolveQueryData(timestamp_heap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frame_index_ * 2, 2,
+        timestamp_readback_.Get(), frame_index_ * 2 * sizeof(UINT64));
+    timestamps_pending_[frame_index_] = true;
 
     // Done recording commands.
     ThrowIfFailed(command_list_->Close());
@@ -134,111 +289,114 @@ void RenderSystem::Render()
     ThrowIfFailed(swap_chain_->Present(0, 0));
     current_back_buffer_ = (current_back_buffer_ + 1) % kSwapChainBufferCount;
 
-    // Wait until frame commands are complete.  This waiting is inefficient and is
-    // done for simplicity.  Later we will show how to organize our rendering code
-    // so we do not have to wait per frame.
-    FlushCommandQueue();
+    // Mark the end of this frame instead of waiting for it.
+    ThrowIfFailed(command_queue_->Signal(fence_.Get(), ++current_fence_));
+    frame_fences_[frame_index_] = current_fence_;
+    frame_index_ = (frame_index_ + 1) % kSwapChainBufferCount;
+    render_target_pool_.Release(depth_target, current_fence_);
+    render_target_pool_.Release(msaa_target, current_fence_);
+    render_target_pool_.Release(scene_target, current_fence_);
 }
 
-void RenderSystem::OnResize()
+void RenderSystem::OnResize(UINT width, UINT height)
 {
     assert(device_);
     assert(swap_chain_);
-    assert(command_list_allocator_);
-
-    // Flush before changing any resources.
-    FlushCommandQueue();
 
-    ThrowIfFailed(command_list_->Reset(command_list_allocator_.Get(), nullptr));
-
-    // Release the previous resources we will be recreating.
-    for (int i = 0; i < kSwapChainBufferCount; ++i)
+    ResizeTimings timings;
+    auto phase_begin = chrono::steady_clock::now();
+    auto end_phase = [&phase_begin]()
     {
-        swap_chain_buffer_[i].Reset();
-    }
+        const auto now = chrono::steady_clock::now();
+        const double milliseconds = chrono::duration<double, milli>(now - phase_begin).count();
+        phase_begin = now;
+        return milliseconds;
+    };
 
-    depth_stencil_buffer_.Reset();
+    timings.swap_chain_resized = width != client_width_ || height != client_height_ || !swap_chain_buffer_[0];
 
-    // Resize the swap chain.
-    ThrowIfFailed(swap_chain_->ResizeBuffers(
-        kSwapChainBufferCount,
-        GameSystem::Instance().Width(),
-        GameSystem::Instance().Height(),
-        back_buffer_format_,
-        DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH));
+    // The old back buffers are referenced only by the frames still in flight.
+    // Wait for the last of them, and only when they are going away; nothing
+    // new has to be executed.  Pooled targets never need a wait.
+    if (timings.swap_chain_resized) WaitForFence(current_fence_);
+    timings.wait_gpu_ms = end_phase();
 
-    current_back_buffer_ = 0;
-
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtv_heap_handle(rtv_heap_->GetCPUDescriptorHandleForHeapStart());
-    for (UINT i = 0; i < kSwapChainBufferCount; i++)
+    if (timings.swap_chain_resized)
     {
-        ThrowIfFailed(swap_chain_->GetBuffer(i, IID_PPV_ARGS(&swap_chain_buffer_[i])));
-        device_->CreateRenderTargetView(swap_chain_buffer_[i].Get(), nullptr, rtv_heap_handle);
-        rtv_heap_handle.Offset(1, rtv_descriptor_size_);
+        // Release the previous resources we will be recreating.
+        for (int i = 0; i < kSwapChainBufferCount; ++i)
+        {
+            swap_chain_buffer_[i].Reset();
+        }
+
+        // Resize the swap chain.
+        ThrowIfFailed(swap_chain_->ResizeBuffers(
+            kSwapChainBufferCount,
+            width,
+            height,
+            back_buffer_format_,
+            DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH));
+
+        current_back_buffer_ = 0;
+
+        CD3DX12_CPU_DESCRIPTOR_HANDLE rtv_heap_handle(rtv_heap_->GetCPUDescriptorHandleForHeapStart());
+        for (UINT i = 0; i < kSwapChainBufferCount; i++)
+        {
+            ThrowIfFailed(swap_chain_->GetBuffer(i, IID_PPV_ARGS(&swap_chain_buffer_[i])));
+            device_->CreateRenderTargetView(swap_chain_buffer_[i].Get(), nullptr, rtv_heap_handle);
+            rtv_heap_handle.Offset(1, rtv_descriptor_size_);
+        }
+
+        // Nothing in flight reads the old pyramid either.
+        hi_z_buffer_.Resize(width, height);
     }
+    client_width_ = width;
+    client_height_ = height;
+    timings.swap_chain_ms = end_phase();
+
+    // Grow the transient targets of the current mode now instead of in the
+    // next frame.  They keep their high water size, so this only allocates
+    // when the window grows past it.
+    UINT render_width = 0;
+    UINT render_height = 0;
+    RenderSize(&render_width, &render_height);
+    const bool upscale = render_width != client_width_ || render_height != client_height_;
+    const UINT64 completed_fence = fence_->GetCompletedValue();
+    bool depth_created = false;
+    bool msaa_created = false;
+    bool scene_created = false;
+    const PooledRenderTarget* depth_target = render_target_pool_.Acquire(
+        FrameTargetDesc(true, msaa_state_, render_width, render_height), completed_fence, &depth_created);
+    const PooledRenderTarget* msaa_target = msaa_state_ ? render_target_pool_.Acquire(
+        FrameTargetDesc(false, true, render_width, render_height), completed_fence, &msaa_created) : nullptr;
+    const PooledRenderTarget* scene_target = upscale ? render_target_pool_.Acquire(
+        FrameTargetDesc(false, false, render_width, render_height), completed_fence, &scene_created) : nullptr;
+    render_target_pool_.Release(depth_target, 0);
+    render_target_pool_.Release(msaa_target, 0);
+    render_target_pool_.Release(scene_target, 0);
+    timings.targets_reused = !depth_created && !msaa_created && !scene_created;
+    timings.targets_ms = end_phase();
+    resize_timings_ = timings;
 
-    // Create the depth/stencil buffer and view.
-    D3D12_RESOURCE_DESC depth_stencil_desc;
-    depth_stencil_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    depth_stencil_desc.Alignment = 0;
-    depth_stencil_desc.Width = GameSystem::Instance().Width();
-    depth_stencil_desc.Height = GameSystem::Instance().Height();
-    depth_stencil_desc.DepthOrArraySize = 1;
-    depth_stencil_desc.MipLevels = 1;
-
-    // Correction 11/12/2016: SSAO chapter requires an SRV to the depth buffer to read from 
-    // the depth buffer.  Therefore, because we need to create two views to the same resource:
-    //   1. SRV format: DXGI_FORMAT_R24_UNORM_X8_TYPELESS
-    //   2. DSV Format: DXGI_FORMAT_D24_UNORM_S8_UINT
-    // we need to create the depth buffer resource with a typeless format.  
-    depth_stencil_desc.Format = DXGI_FORMAT_R24G8_TYPELESS;
-
-    depth_stencil_desc.SampleDesc.Count = msaa_state_ ? 4 : 1;
-    depth_stencil_desc.SampleDesc.Quality = msaa_state_ ? (msaa_quality_ - 1) : 0;
-    depth_stencil_desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-    depth_stencil_desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-    D3D12_CLEAR_VALUE opt_clear;
-    opt_clear.Format = depth_stencil_format_;
-    opt_clear.DepthStencil.Depth = 1.0f;
-    opt_clear.DepthStencil.Stencil = 0;
-    ThrowIfFailed(device_->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-        D3D12_HEAP_FLAG_NONE,
-        &depth_stencil_desc,
-        D3D12_RESOURCE_STATE_COMMON,
-        &opt_clear,
-        IID_PPV_ARGS(depth_stencil_buffer_.GetAddressOf())));
-
-    // Create descriptor to mip level 0 of entire resource using the format of the resource.
-    D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc;
-    dsv_desc.Flags = D3D12_DSV_FLAG_NONE;
-    dsv_desc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-    dsv_desc.Format = depth_stencil_format_;
-    dsv_desc.Texture2D.MipSlice = 0;
-    device_->CreateDepthStencilView(depth_stencil_buffer_.Get(), &dsv_desc, DepthStencilView());
-
-    // Transition the resource from its initial state to be used as a depth buffer.
-    command_list_->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(depth_stencil_buffer_.Get(),
-        D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE));
-
-    // Execute the resize commands.
-    ThrowIfFailed(command_list_->Close());
-    ID3D12CommandList* command_lists[] = { command_list_.Get() };
-    command_queue_->ExecuteCommandLists(_countof(command_lists), command_lists);
-
-    // Wait until resize is complete.
-    FlushCommandQueue();
+#ifdef _DEBUG
+    wostringstream text;
+    text << L"OnResize " << width << L"x" << height
+        << L" wait " << timings.wait_gpu_ms << L"ms"
+        << L", swap chain " << timings.swap_chain_ms << L"ms" << (timings.swap_chain_resized ? L"" : L" (kept)")
+        << L", targets " << timings.targets_ms << L"ms" << (timings.targets_reused ? L" (reused)" : L"")
+        << L"\n";
+    OutputDebugString(text.str().c_str());
+#endif
 
     // Update the viewport transform to cover the client area.
     screen_viewport_.TopLeftX = 0;
     screen_viewport_.TopLeftY = 0;
-    screen_viewport_.Width = static_cast<float>(GameSystem::Instance().Width());
-    screen_viewport_.Height = static_cast<float>(GameSystem::Instance().Height());
+    screen_viewport_.Width = static_cast<float>(client_width_);
+    screen_viewport_.Height = static_cast<float>(client_height_);
     screen_viewport_.MinDepth = 0.0f;
     screen_viewport_.MaxDepth = 1.0f;
 
-    scissor_rect_ = { 0, 0, (LONG)GameSystem::Instance().Width(), (LONG)GameSystem::Instance().Height() };
+    scissor_rect_ = { 0, 0, (LONG)client_width_, (LONG)client_height_ };
 }
 
 bool RenderSystem::GetMsaaState() const
@@ -248,21 +406,44 @@ bool RenderSystem::GetMsaaState() const
 
 void RenderSystem::SetMsaaState(bool value)
 {
+    // Resolving part of a larger pooled target needs ID3D12GraphicsCommandList1.
+    if (value && !command_list1_) return;
+
+    // Targets of both sample counts stay in the pool, nothing is rebuilt.
     msaa_state_ = value;
 }
 
+bool RenderSystem::GetDynamicResolutionState() const
+{
+    return dynamic_resolution_state_;
+}
+
+void RenderSystem::SetDynamicResolutionState(bool value)
+{
+    if (value && !bindless_heap_->IsSupported()) return;
+
+    // Start again from full resolution without the old history.
+    if (value && !dynamic_resolution_state_) resolution_controller_.Reset();
+    dynamic_resolution_state_ = value;
+}
+
+float RenderSystem::ResolutionScale() const
+{
+    return dynamic_resolution_state_ ? resolution_controller_.Scale() : 1.0f;
+}
+
 // Convenience overrides for handling mouse input.
-void RenderSystem::OnMouseDown(WPARAM state, int x, int y)
+void RenderSystem::OnMouseDown(UINT state, int x, int y)
 {
 
 }
 
-void RenderSystem::OnMouseUp(WPARAM state, int x, int y)
+void RenderSystem::OnMouseUp(UINT state, int x, int y)
 {
 
 }
 
-void RenderSystem::OnMouseMove(WPARAM state, int x, int y)
+void RenderSystem::OnMouseMove(UINT state, int x, int y)
 {
 
 }
@@ -282,7 +463,7 @@ RenderSystem::~RenderSystem()
 
 }
 
-void RenderSystem::CreateRtvAndDsvDescriptorHeaps()
+void RenderSystem::CreateRtvDescriptorHeap()
 {
     D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc;
     rtv_heap_desc.NumDescriptors = kSwapChainBufferCount;
@@ -291,15 +472,6 @@ void RenderSystem::CreateRtvAndDsvDescriptorHeaps()
     rtv_heap_desc.NodeMask = 0;
     ThrowIfFailed(device_->CreateDescriptorHeap(
         &rtv_heap_desc, IID_PPV_ARGS(rtv_heap_.GetAddressOf())));
-
-
-    D3D12_DESCRIPTOR_HEAP_DESC dsv_heap_desc;
-    dsv_heap_desc.NumDescriptors = 1;
-    dsv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-    dsv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    dsv_heap_desc.NodeMask = 0;
-    ThrowIfFailed(device_->CreateDescriptorHeap(
-        &dsv_heap_desc, IID_PPV_ARGS(dsv_heap_.GetAddressOf())));
 }
 
 void RenderSystem::CreateCommandObjects()
@@ -309,14 +481,17 @@ void RenderSystem::CreateCommandObjects()
     queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
     ThrowIfFailed(device_->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&command_queue_)));
 
-    ThrowIfFailed(device_->CreateCommandAllocator(
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-        IID_PPV_ARGS(command_list_allocator_.GetAddressOf())));
+    for (int i = 0; i < kSwapChainBufferCount; ++i)
+    {
+        ThrowIfFailed(device_->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(command_list_allocators_[i].GetAddressOf())));
+    }
 
     ThrowIfFailed(device_->CreateCommandList(
         0,
         D3D12_COMMAND_LIST_TYPE_DIRECT,
-        command_list_allocator_.Get(), // Associated command allocator
+        command_list_allocators_[0].Get(), // Associated command allocator
         nullptr,                   // Initial PipelineStateObject
         IID_PPV_ARGS(command_list_.GetAddressOf())));
 
@@ -324,6 +499,47 @@ void RenderSystem::CreateCommandObjects()
     // to the command list we will Reset it, and it needs to be closed before
     // calling Reset.
     command_list_->Close();
+
+    // Missing before Windows 10 1709; MSAA stays off there.
+    command_list_.As(&command_list1_);
+}
+
+void RenderSystem::CreateTimestampQueries()
+{
+    D3D12_QUERY_HEAP_DESC query_heap_desc = {};
+    query_heap_desc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    query_heap_desc.Count = kSwapChainBufferCount * 2;
+    query_heap_desc.NodeMask = 0;
+    ThrowIfFailed(device_->CreateQueryHeap(&query_heap_desc, IID_PPV_ARGS(timestamp_heap_.GetAddressOf())));
+
+    ThrowIfFailed(device_->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(kSwapChainBufferCount * 2 * sizeof(UINT64)),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(timestamp_readback_.GetAddressOf())));
+
+    ThrowIfFailed(command_queue_->GetTimestampFrequency(&timestamp_frequency_));
+}
+
+bool RenderSystem::ReadGpuFrameTime(int frame, double* milliseconds)
+{
+    // The caller waited for the frame's fence, its timestamps are resolved.
+    if (!timestamps_pending_[frame]) return false;
+    timestamps_pending_[frame] = false;
+
+    const D3D12_RANGE read_range = { frame * 2 * sizeof(UINT64), (frame * 2 + 2) * sizeof(UINT64) };
+    const D3D12_RANGE written_range = { 0, 0 };
+    UINT64* timestamps = nullptr;
+    ThrowIfFailed(timestamp_readback_->Map(0, &read_range, reinterpret_cast<void**>(&timestamps)));
+    const UINT64 begin = timestamps[frame * 2];
+    const UINT64 end = timestamps[frame * 2 + 1];
+    timestamp_readback_->Unmap(0, &written_range);
+
+    if (end <= begin || timestamp_frequency_ == 0) return false;
+    *milliseconds = static_cast<double>(end - begin) * 1000.0 / timestamp_frequency_;
+    return true;
 }
 
 void RenderSystem::CreateSwapChain()
@@ -339,8 +555,10 @@ void RenderSystem::CreateSwapChain()
     swap_chain_desc.BufferDesc.Format = back_buffer_format_;
     swap_chain_desc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
     swap_chain_desc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-    swap_chain_desc.SampleDesc.Count = msaa_state_ ? 4 : 1;
-    swap_chain_desc.SampleDesc.Quality = msaa_state_ ? (msaa_quality_ - 1) : 0;
+    // Flip model swap chains cannot be multisampled; MSAA renders into a
+    // pooled target that is resolved into the back buffer.
+    swap_chain_desc.SampleDesc.Count = 1;
+    swap_chain_desc.SampleDesc.Quality = 0;
     swap_chain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     swap_chain_desc.BufferCount = kSwapChainBufferCount;
     swap_chain_desc.OutputWindow = GameSystem::Instance().MainWindowHandle();
@@ -366,12 +584,17 @@ void RenderSystem::FlushCommandQueue()
     ThrowIfFailed(command_queue_->Signal(fence_.Get(), current_fence_));
 
     // Wait until the GPU has completed commands up to this fence point.
-    if (fence_->GetCompletedValue() < current_fence_)
+    WaitForFence(current_fence_);
+}
+
+void RenderSystem::WaitForFence(UINT64 value)
+{
+    if (fence_->GetCompletedValue() < value)
     {
         HANDLE event_handle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
 
-        // Fire event when GPU hits current fence.  
-        ThrowIfFailed(fence_->SetEventOnCompletion(current_fence_, event_handle));
+        // Fire event when GPU hits the fence.  
+        ThrowIfFailed(fence_->SetEventOnCompletion(value, event_handle));
 
         // Wait until the GPU hits current fence event is fired.
         WaitForSingleObject(event_handle, INFINITE);
@@ -392,9 +615,36 @@ D3D12_CPU_DESCRIPTOR_HANDLE RenderSystem::CurrentBackBufferView() const
         rtv_descriptor_size_);
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE RenderSystem::DepthStencilView() const
+RenderTargetDesc RenderSystem::FrameTargetDesc(bool depth_stencil, bool multisampled, UINT width, UINT height) const
+{
+    RenderTargetDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.sample_count = multisampled ? 4 : 1;
+    desc.sample_quality = multisampled ? (msaa_quality_ - 1) : 0;
+    desc.depth_stencil = depth_stencil;
+    if (depth_stencil)
+    {
+        // Correction 11/12/2016: SSAO chapter requires an SRV to the depth buffer to read from 
+        // the depth buffer.  Therefore, because we need to create two views to the same resource:
+        //   1. SRV format: DXGI_FORMAT_R24_UNORM_X8_TYPELESS
+        //   2. DSV Format: DXGI_FORMAT_D24_UNORM_S8_UINT
+        // we need to create the depth buffer resource with a typeless format.  
+        desc.format = DXGI_FORMAT_R24G8_TYPELESS;
+        desc.view_format = depth_stencil_format_;
+    }
+    else
+    {
+        desc.format = back_buffer_format_;
+        desc.view_format = back_buffer_format_;
+        memcpy(desc.clear_color, Colors::LightSteelBlue.f, sizeof(desc.clear_color));
+    }
+    return desc;
+}
+
+void RenderSystem::RenderSize(UINT* width, UINT* height) const
 {
-    return dsv_heap_->GetCPUDescriptorHandleForHeapStart();
+    DynamicResolutionController::RenderSize(client_width_, client_height_, ResolutionScale(), width, height);
 }
 
 void RenderSystem::LogAdapters()
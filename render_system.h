@@ -1,13 +1,22 @@
 #pragma once
 
 #include "d3dUtil.h"
+#include "render_target_pool.h"
+#include "dynamic_resolution.h"
+#include "upscale_pass.h"
+#include "hi_z_buffer.h"
+
+#include "render_thread.h"
+
+class RootSignatureCache;
+class BindlessDescriptorHeap;
 
 // Link necessary d3d12 libraries.
 #pragma comment(lib,"d3dcompiler.lib")
 #pragma comment(lib, "D3D12.lib")
 #pragma comment(lib, "dxgi.lib")
 
-class RenderSystem
+class RenderSystem : public RenderBackend
 {
 public:
     static RenderSystem* Create();
@@ -15,18 +24,41 @@ public:
     bool Initialize();
     void Release();
 
-    void PrepareRender();
-    void Render();
-
-    void OnResize();
-
-    bool GetMsaaState()const;
-    void SetMsaaState(bool value);
-
-    // Convenience overrides for handling mouse input.
-    void OnMouseDown(WPARAM state, int x, int y);
-    void OnMouseUp(WPARAM state, int x, int y);
-    void OnMouseMove(WPARAM state, int x, int y);
+    void PrepareRender(const RenderPacket& packet) override;
+    void Render() override;
+
+    void OnResize(UINT width, UINT height) override;
+
+    // Duration of each phase of the last OnResize in milliseconds.
+    struct ResizeTimings
+    {
+        double wait_gpu_ms = 0.0;       // frames in flight that use the old buffers
+        double swap_chain_ms = 0.0;     // ResizeBuffers and render target views
+        double targets_ms = 0.0;        // transient color / depth targets of the current mode
+        bool   swap_chain_resized = false;
+        bool   targets_reused = false;
+    };
+    const ResizeTimings& LastResizeTimings() const { return resize_timings_; }
+
+    bool GetMsaaState()const override;
+    void SetMsaaState(bool value) override;
+
+    // Render the scene below the output size when the GPU misses its budget.
+    bool GetDynamicResolutionState()const override;
+    void SetDynamicResolutionState(bool value) override;
+    float ResolutionScale()const;
+
+    // Min / max depth of the last depth prepass, for the next frame's occlusion
+    // test.  Off by default: turn it on once occluders are drawn in the prepass
+    // and the culling reads the pyramid, until then the build is wasted GPU time.
+    bool GetHiZState()const { return hi_z_state_; }
+    void SetHiZState(bool value) { hi_z_state_ = value; }
+    const HiZBuffer& GetHiZBuffer()const { return hi_z_buffer_; }
+
+    // Convenience overrides for handling mouse input, on the render thread.
+    void OnMouseDown(UINT state, int x, int y) override;
+    void OnMouseUp(UINT state, int x, int y) override;
+    void OnMouseMove(UINT state, int x, int y) override;
 
 private:
     RenderSystem();
@@ -34,21 +66,26 @@ private:
     RenderSystem& operator=(const RenderSystem& rhs) = delete;
     ~RenderSystem();
 
-    void CreateRtvAndDsvDescriptorHeaps();
+    void CreateRtvDescriptorHeap();
     void CreateCommandObjects();
     void CreateSwapChain();
+    void CreateTimestampQueries();
+    bool ReadGpuFrameTime(int frame, double* milliseconds);
 
     void FlushCommandQueue();
+    void WaitForFence(UINT64 value);
 
     ID3D12Resource* CurrentBackBuffer()const;
     D3D12_CPU_DESCRIPTOR_HANDLE CurrentBackBufferView()const;
-    D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView()const;
+    RenderTargetDesc FrameTargetDesc(bool depth_stencil, bool multisampled, UINT width, UINT height)const;
+    void RenderSize(UINT* width, UINT* height)const;
 
     void LogAdapters();
     void LogAdapterOutputs(IDXGIAdapter* adapter);
     void LogOutputDisplayModes(IDXGIOutput* output, DXGI_FORMAT format);
 
     static constexpr int kSwapChainBufferCount = 2;
+    static constexpr const wchar_t* kShaderCacheDirectory = L"shader_cache";
 
     // Set true to use 4X MSAA (4.1.8).  The default is false.
     bool msaa_state_ = false;    // 4X MSAA enabled
@@ -62,21 +99,42 @@ private:
     UINT64 current_fence_ = 0;
 
     Microsoft::WRL::ComPtr<ID3D12CommandQueue> command_queue_;
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_list_allocator_;
+    // One allocator per frame in flight; frame_fences_ is the fence value
+    // that tells when the GPU is done with it.
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_list_allocators_[kSwapChainBufferCount];
+    UINT64 frame_fences_[kSwapChainBufferCount] = {};
+    int frame_index_ = 0;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> command_list_;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList1> command_list1_;   // same list, for ResolveSubresourceRegion
+
+    // Begin / end timestamp of each frame in flight, read back once its fence passed.
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> timestamp_heap_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> timestamp_readback_;
+    UINT64 timestamp_frequency_ = 0;
+    bool timestamps_pending_[kSwapChainBufferCount] = {};
 
     int current_back_buffer_ = 0;
     Microsoft::WRL::ComPtr<ID3D12Resource> swap_chain_buffer_[kSwapChainBufferCount];
-    Microsoft::WRL::ComPtr<ID3D12Resource> depth_stencil_buffer_;
+    // MSAA color, the scaled scene and depth; the swap chain is always single sample.
+    RenderTargetPool render_target_pool_;
+    UpscalePass upscale_pass_;
+    HiZBuffer hi_z_buffer_;
+    bool hi_z_state_ = false;
+    DynamicResolutionController resolution_controller_;
+    bool dynamic_resolution_state_ = false;
+    RootSignatureCache* root_signature_cache_ = nullptr;
+    BindlessDescriptorHeap* bindless_heap_ = nullptr;
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtv_heap_;
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsv_heap_;
 
     D3D12_VIEWPORT screen_viewport_;
     D3D12_RECT scissor_rect_;
+    UINT client_width_ = 0;
+    UINT client_height_ = 0;
+    float clear_color_[4] = {};
+    ResizeTimings resize_timings_;
 
     UINT rtv_descriptor_size_ = 0;
-    UINT dsv_descriptor_size_ = 0;
     UINT cbv_srv_uav_descriptor_size_ = 0;
 
     D3D_DRIVER_TYPE driver_type_ = D3D_DRIVER_TYPE_HARDWARE;
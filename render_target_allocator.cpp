@@ -0,0 +1,69 @@
+//--------------------------------------------------------------------------------
+//  render_target_allocator.cpp
+//--------------------------------------------------------------------------------
+#include "render_target_allocator.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+uint32_t RenderTargetAllocator::Acquire(const RenderTargetKind& kind, uint32_t width, uint32_t height,
+    uint64_t completed_fence, bool* create)
+{
+    // Smallest free slot that fits; otherwise a free one of the same kind to grow.
+    uint32_t best = kInvalid;
+    uint32_t grow = kInvalid;
+    for (uint32_t i = 0; i < count_; ++i)
+    {
+        const RenderTargetSlot& slot = slots_[i];
+        if (slot.in_use || slot.fence > completed_fence || !(slot.kind == kind)) continue;
+
+        if (slot.width >= width && slot.height >= height)
+        {
+            const uint64_t area = static_cast<uint64_t>(slot.width) * slot.height;
+            if (best == kInvalid || area < static_cast<uint64_t>(slots_[best].width) * slots_[best].height) best = i;
+        }
+        else if (grow == kInvalid)
+        {
+            grow = i;
+        }
+    }
+
+    *create = best == kInvalid;
+    if (best == kInvalid)
+    {
+        if (grow != kInvalid)
+        {
+            // The GPU is done with it, so it can go right away.
+            width = max(width, slots_[grow].width);
+            height = max(height, slots_[grow].height);
+            best = grow;
+        }
+        else
+        {
+            if (count_ == kMaxTargets) return kInvalid;
+            best = count_++;
+        }
+
+        RenderTargetSlot& slot = slots_[best];
+        slot.kind = kind;
+        slot.width = RoundUp(width);
+        slot.height = RoundUp(height);
+        slot.fence = 0;
+    }
+
+    slots_[best].in_use = true;
+    return best;
+}
+
+void RenderTargetAllocator::Release(uint32_t index, uint64_t fence)
+{
+    assert(index < count_ && slots_[index].in_use);
+    slots_[index].in_use = false;
+    slots_[index].fence = fence;
+}
@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------
+//  render_target_allocator.h
+//  Which slot of RenderTargetPool a request gets (CPU only).  The pool
+//  creates the resources; this decides when:
+//  - Any free slot of the same kind at least as large is reused, the
+//    smallest one first.  Otherwise a free slot of that kind too small for
+//    the request is grown to cover both sizes, or a new slot is taken.
+//  - Sizes are rounded up to kSizeGranularity and never shrink.
+//  - A released slot becomes free once the completed fence passed to
+//    Acquire reaches the fence it was released with.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+
+struct RenderTargetKind
+{
+    uint32_t format = 0;                    // DXGI_FORMAT of the resource
+    uint32_t view_format = 0;
+    uint32_t sample_count = 1;
+    uint32_t sample_quality = 0;
+    bool     depth_stencil = false;
+
+    bool operator==(const RenderTargetKind& rhs) const
+    {
+        return format == rhs.format && view_format == rhs.view_format
+            && sample_count == rhs.sample_count && sample_quality == rhs.sample_quality
+            && depth_stencil == rhs.depth_stencil;
+    }
+};
+
+struct RenderTargetSlot
+{
+    RenderTargetKind kind;
+    uint32_t width = 0;                     // allocated size
+    uint32_t height = 0;
+    uint64_t fence = 0;                     // free once the GPU passed this value
+    bool     in_use = false;
+};
+
+class RenderTargetAllocator
+{
+public:
+    static constexpr uint32_t kMaxTargets = 16;
+    static constexpr uint32_t kSizeGranularity = 128;
+    static constexpr uint32_t kInvalid = ~0u;
+
+    //--------------------------------------------------------------------------------
+    //  Slot for a width x height target of kind, marked in use.
+    //  completed_fence : fence value the GPU has passed
+    //  create          : true when the slot is new or grown, so its resource
+    //                    has to be (re)created at Slot(index)'s size
+    //  Returns kInvalid when all kMaxTargets slots are taken.
+    //--------------------------------------------------------------------------------
+    uint32_t Acquire(const RenderTargetKind& kind, uint32_t width, uint32_t height,
+        uint64_t completed_fence, bool* create);
+    void Release(uint32_t index, uint64_t fence);
+    void Clear() { count_ = 0; }
+
+    const RenderTargetSlot& Slot(uint32_t index) const { return slots_[index]; }
+    uint32_t Count() const { return count_; }
+
+    static uint32_t RoundUp(uint32_t value) { return (value + kSizeGranularity - 1) / kSizeGranularity * kSizeGranularity; }
+
+private:
+    RenderTargetSlot slots_[kMaxTargets];
+    uint32_t count_ = 0;
+};
@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------
+//  render_target_pool.cpp
+//--------------------------------------------------------------------------------
+#include "render_target_pool.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+namespace
+{
+    RenderTargetKind Kind(const RenderTargetDesc& desc)
+    {
+        RenderTargetKind kind;
+        kind.format = static_cast<uint32_t>(desc.format);
+        kind.view_format = static_cast<uint32_t>(desc.view_format);
+        kind.sample_count = desc.sample_count;
+        kind.sample_quality = desc.sample_quality;
+        kind.depth_stencil = desc.depth_stencil;
+        return kind;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void RenderTargetPool::Initialize(ID3D12Device* device)
+{
+    device_ = device;
+    rtv_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    dsv_descriptor_size_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+    // One RTV and one DSV slot per target, whichever the target ends up being.
+    D3D12_DESCRIPTOR_HEAP_DESC heap_desc;
+    heap_desc.NumDescriptors = kMaxTargets;
+    heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    heap_desc.NodeMask = 0;
+    heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    ThrowIfFailed(device_->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(rtv_heap_.GetAddressOf())));
+    heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+    ThrowIfFailed(device_->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(dsv_heap_.GetAddressOf())));
+}
+
+void RenderTargetPool::Release()
+{
+    for (UINT i = 0; i < allocator_.Count(); ++i)
+    {
+        targets_[i] = PooledRenderTarget();
+    }
+    allocator_.Clear();
+    memory_size_ = 0;
+    rtv_heap_.Reset();
+    dsv_heap_.Reset();
+}
+
+const PooledRenderTarget* RenderTargetPool::Acquire(const RenderTargetDesc& desc, UINT64 completed_fence, bool* created)
+{
+    assert(device_ != nullptr);
+    bool create = false;
+    const uint32_t index = allocator_.Acquire(Kind(desc), desc.width, desc.height, completed_fence, &create);
+    assert(index != RenderTargetAllocator::kInvalid && "Too many transient render targets in flight.");
+    if (index == RenderTargetAllocator::kInvalid) ThrowIfFailed(E_OUTOFMEMORY);
+
+    PooledRenderTarget& target = targets_[index];
+    if (create)
+    {
+        RenderTargetDesc allocation = desc;
+        allocation.width = allocator_.Slot(index).width;
+        allocation.height = allocator_.Slot(index).height;
+        CreateTarget(target, allocation);
+    }
+    if (created) *created = create;
+    return &target;
+}
+
+void RenderTargetPool::Release(const PooledRenderTarget* target, UINT64 fence)
+{
+    if (!target) return;
+    allocator_.Release(static_cast<uint32_t>(target - targets_), fence);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void RenderTargetPool::CreateTarget(PooledRenderTarget& target, const RenderTargetDesc& desc)
+{
+    const UINT index = static_cast<UINT>(&target - targets_);
+    target.resource.Reset();
+
+    const CD3DX12_RESOURCE_DESC resource_desc = CD3DX12_RESOURCE_DESC::Tex2D(
+        desc.format, desc.width, desc.height, 1, 1, desc.sample_count, desc.sample_quality,
+        desc.depth_stencil ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+    const D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(0, 1, &resource_desc);
+
+    // The heap only grows; a target keeps its kind, so its alignment
+    // (64 KB, or 4 MB with MSAA) never changes either.
+    if (!target.heap || target.heap_size < info.SizeInBytes)
+    {
+        memory_size_ -= target.heap_size;
+        target.heap.Reset();
+        const CD3DX12_HEAP_DESC heap_desc(info, D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+        ThrowIfFailed(device_->CreateHeap(&heap_desc, IID_PPV_ARGS(target.heap.GetAddressOf())));
+        target.heap_size = info.SizeInBytes;
+        memory_size_ += target.heap_size;
+    }
+
+    D3D12_CLEAR_VALUE clear_value;
+    clear_value.Format = desc.view_format;
+    if (desc.depth_stencil)
+    {
+        clear_value.DepthStencil.Depth = 1.0f;
+        clear_value.DepthStencil.Stencil = 0;
+    }
+    else
+    {
+        memcpy(clear_value.Color, desc.clear_color, sizeof(clear_value.Color));
+    }
+
+    // Created directly in the state it is used in, so no barrier (and no
+    // command list) is needed.
+    ThrowIfFailed(device_->CreatePlacedResource(
+        target.heap.Get(), 0, &resource_desc,
+        desc.depth_stencil ? D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_RENDER_TARGET,
+        &clear_value,
+        IID_PPV_ARGS(target.resource.GetAddressOf())));
+
+    const bool multisampled = desc.sample_count > 1;
+    if (desc.depth_stencil)
+    {
+        D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc = {};
+        dsv_desc.Format = desc.view_format;
+        dsv_desc.ViewDimension = multisampled ? D3D12_DSV_DIMENSION_TEXTURE2DMS : D3D12_DSV_DIMENSION_TEXTURE2D;
+        dsv_desc.Flags = D3D12_DSV_FLAG_NONE;
+        target.view = CD3DX12_CPU_DESCRIPTOR_HANDLE(dsv_heap_->GetCPUDescriptorHandleForHeapStart(), index, dsv_descriptor_size_);
+        device_->CreateDepthStencilView(target.resource.Get(), &dsv_desc, target.view);
+    }
+    else
+    {
+        D3D12_RENDER_TARGET_VIEW_DESC rtv_desc = {};
+        rtv_desc.Format = desc.view_format;
+        rtv_desc.ViewDimension = multisampled ? D3D12_RTV_DIMENSION_TEXTURE2DMS : D3D12_RTV_DIMENSION_TEXTURE2D;
+        target.view = CD3DX12_CPU_DESCRIPTOR_HANDLE(rtv_heap_->GetCPUDescriptorHandleForHeapStart(), index, rtv_descriptor_size_);
+        device_->CreateRenderTargetView(target.resource.Get(), &rtv_desc, target.view);
+    }
+
+    target.desc = desc;
+}
@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------
+//  render_target_pool.h
+//  Transient color and depth targets shared across frames.
+//  - A target is found by (format, samples, quality, kind) and size: any free
+//    target at least as large is reused, a too small free one is grown
+//    (RenderTargetAllocator).  Sizes are rounded up and never shrink, so
+//    resizes and MSAA toggles stop allocating once each combination has
+//    been seen.
+//  - Each target is placed in its own ID3D12Heap, which only grows: a grown
+//    target reuses the heap when it still fits.
+//  - A released target becomes free when the GPU passes the fence given to
+//    Release, so nothing ever waits for the GPU.
+//  - Targets are larger than requested: draws set the viewport / scissor to
+//    the requested size and resolves copy that region only.
+//  - Render thread only.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+#include "render_target_allocator.h"
+
+struct RenderTargetDesc
+{
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;           // resource format (may be typeless)
+    DXGI_FORMAT view_format = DXGI_FORMAT_UNKNOWN;      // RTV / DSV format and optimized clear format
+    UINT width = 0;
+    UINT height = 0;
+    UINT sample_count = 1;
+    UINT sample_quality = 0;
+    bool depth_stencil = false;
+    float clear_color[4] = {};                          // color targets only
+};
+
+struct PooledRenderTarget
+{
+    Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+    Microsoft::WRL::ComPtr<ID3D12Heap> heap;            // resource is placed at offset 0
+    UINT64 heap_size = 0;
+    D3D12_CPU_DESCRIPTOR_HANDLE view = {};              // RTV, or DSV for depth stencil targets
+    RenderTargetDesc desc;                              // allocated size
+};
+
+class RenderTargetPool
+{
+public:
+    RenderTargetPool() = default;
+    ~RenderTargetPool() = default;
+
+    void Initialize(ID3D12Device* device);
+    void Release();
+
+    //--------------------------------------------------------------------------------
+    //  Target of at least desc.width x desc.height, in RENDER_TARGET (color) or
+    //  DEPTH_WRITE (depth stencil) state, and returned to the pool in it.
+    //  completed_fence : fence value the GPU has passed
+    //  created         : true when a resource had to be created
+    //--------------------------------------------------------------------------------
+    const PooledRenderTarget* Acquire(const RenderTargetDesc& desc, UINT64 completed_fence, bool* created = nullptr);
+    void Release(const PooledRenderTarget* target, UINT64 fence);
+
+    UINT TargetCount() const { return allocator_.Count(); }
+    UINT64 MemorySize() const { return memory_size_; }
+
+private:
+    RenderTargetPool(const RenderTargetPool& rhs) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool& rhs) = delete;
+
+    static constexpr UINT kMaxTargets = RenderTargetAllocator::kMaxTargets;
+
+    void CreateTarget(PooledRenderTarget& target, const RenderTargetDesc& desc);
+
+    ID3D12Device* device_ = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtv_heap_;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsv_heap_;
+    UINT rtv_descriptor_size_ = 0;
+    UINT dsv_descriptor_size_ = 0;
+
+    RenderTargetAllocator allocator_;
+    PooledRenderTarget targets_[kMaxTargets];
+    UINT64 memory_size_ = 0;
+};
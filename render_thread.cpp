@@ -0,0 +1,224 @@
+//--------------------------------------------------------------------------------
+//  render_thread.cpp
+//--------------------------------------------------------------------------------
+#include "render_thread.h"
+#include <cassert>
+
+using namespace std;
+
+RenderThread* RenderThread::instance_ = nullptr;
+
+namespace
+{
+    // Empty polls before the render thread goes to sleep.
+    constexpr uint32_t kSpinCount = 64;
+
+    uint32_t LowestBit(uint32_t mask)
+    {
+        uint32_t index = 0;
+        while ((mask & 1) == 0)
+        {
+            mask >>= 1;
+            ++index;
+        }
+        return index;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+RenderThread* RenderThread::Create()
+{
+    if (instance_) return instance_;
+    instance_ = new RenderThread;
+    return instance_;
+}
+
+void RenderThread::Initialize(RenderBackend* backend)
+{
+    assert(backend != nullptr);
+    assert(!thread_.joinable());
+    backend_ = backend;
+    thread_ = thread([this]() { ThreadLoop(); });
+}
+
+void RenderThread::Release()
+{
+    assert(instance_ != nullptr);
+    if (thread_.joinable())
+    {
+        Post(Command{ CommandType::kQuit });
+        thread_.join();
+    }
+    instance_ = nullptr;
+    delete this;
+}
+
+RenderPacket& RenderThread::BeginPacket()
+{
+    assert(writing_packet_ == kPacketCount && "BeginPacket called twice");
+    uint32_t free_packets = free_packets_.load(memory_order_acquire);
+    if (free_packets == 0)
+    {
+        unique_lock<mutex> lock(packet_mutex_);
+        packet_released_.wait(lock, [this, &free_packets]()
+        {
+            free_packets = free_packets_.load(memory_order_acquire);
+            return free_packets != 0;
+        });
+    }
+
+    // Only this thread clears bits, so the packet is still free.
+    writing_packet_ = LowestBit(free_packets);
+    free_packets_.fetch_and(~(1u << writing_packet_), memory_order_relaxed);
+    return packets_[writing_packet_];
+}
+
+void RenderThread::SubmitPacket()
+{
+    assert(writing_packet_ < kPacketCount && "SubmitPacket without BeginPacket");
+    Command command{ CommandType::kFrame };
+    command.packet = writing_packet_;
+    writing_packet_ = kPacketCount;
+    Post(command);
+}
+
+void RenderThread::PostResize(uint32_t width, uint32_t height)
+{
+    Command command{ CommandType::kResize };
+    command.width = width;
+    command.height = height;
+    Post(command);
+}
+
+void RenderThread::PostToggleMsaa()
+{
+    Post(Command{ CommandType::kToggleMsaa });
+}
+
+void RenderThread::PostToggleDynamicResolution()
+{
+    Post(Command{ CommandType::kToggleDynamicResolution });
+}
+
+void RenderThread::PostMouseDown(uint32_t state, int x, int y)
+{
+    PostMouse(CommandType::kMouseDown, state, x, y);
+}
+
+void RenderThread::PostMouseUp(uint32_t state, int x, int y)
+{
+    PostMouse(CommandType::kMouseUp, state, x, y);
+}
+
+void RenderThread::PostMouseMove(uint32_t state, int x, int y)
+{
+    PostMouse(CommandType::kMouseMove, state, x, y);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+RenderThread::RenderThread()
+    : commands_(kCommandCapacity)
+{
+
+}
+
+void RenderThread::Post(const Command& command)
+{
+    // Full means the render thread is far behind; it never waits on us.
+    while (!commands_.TryPush(command)) this_thread::yield();
+
+    // seq_cst pairs with the sleeping_ store / pending_ load in ThreadLoop:
+    // either we see it asleep or it sees our command.
+    pending_.fetch_add(1, memory_order_seq_cst);
+    if (sleeping_.load(memory_order_seq_cst))
+    {
+        { lock_guard<mutex> lock(wake_mutex_); }
+        wake_condition_.notify_one();
+    }
+}
+
+void RenderThread::PostMouse(CommandType type, uint32_t state, int x, int y)
+{
+    Command command{ type };
+    command.width = state;
+    command.x = x;
+    command.y = y;
+    Post(command);
+}
+
+void RenderThread::ThreadLoop()
+{
+    uint32_t idle = 0;
+    for (;;)
+    {
+        Command command;
+        if (commands_.TryPop(command))
+        {
+            pending_.fetch_sub(1, memory_order_relaxed);
+            idle = 0;
+            if (command.type == CommandType::kQuit) return;
+            Execute(command);
+            continue;
+        }
+
+        if (++idle < kSpinCount)
+        {
+            this_thread::yield();
+            continue;
+        }
+
+        unique_lock<mutex> lock(wake_mutex_);
+        sleeping_.store(true, memory_order_seq_cst);
+        wake_condition_.wait(lock, [this]() { return pending_.load(memory_order_seq_cst) > 0; });
+        sleeping_.store(false, memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+void RenderThread::Execute(const Command& command)
+{
+    switch (command.type)
+    {
+    case CommandType::kFrame:
+        backend_->PrepareRender(packets_[command.packet]);
+        backend_->Render();
+        frames_rendered_.fetch_add(1, memory_order_relaxed);
+        ReleasePacket(command.packet);
+        break;
+    case CommandType::kResize:
+        backend_->OnResize(command.width, command.height);
+        break;
+    case CommandType::kToggleMsaa:
+        backend_->SetMsaaState(!backend_->GetMsaaState());
+        break;
+    case CommandType::kToggleDynamicResolution:
+        backend_->SetDynamicResolutionState(!backend_->GetDynamicResolutionState());
+        break;
+    case CommandType::kMouseDown:
+        backend_->OnMouseDown(command.width, command.x, command.y);
+        break;
+    case CommandType::kMouseUp:
+        backend_->OnMouseUp(command.width, command.x, command.y);
+        break;
+    case CommandType::kMouseMove:
+        backend_->OnMouseMove(command.width, command.x, command.y);
+        break;
+    default:
+        break;
+    }
+}
+
+void RenderThread::ReleasePacket(uint32_t index)
+{
+    free_packets_.fetch_or(1u << index, memory_order_release);
+    { lock_guard<mutex> lock(packet_mutex_); }
+    packet_released_.notify_one();
+}
@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------
+//  render_thread.h
+//  Dedicated thread that owns every RenderSystem call after Initialize.
+//  - The game thread fills a RenderPacket per frame (BeginPacket /
+//    SubmitPacket).  Packets are triple buffered: one being rendered, one
+//    queued and one being written, so simulation of frame N+1 overlaps
+//    submission of frame N and the game runs at most two frames ahead.
+//  - Frames, resizes, MSAA toggles and mouse input go through one MpscQueue
+//    and execute in the order they were posted.
+//  The render thread sleeps on a condition variable only when the queue
+//  is empty; posting wakes it.  It drives a RenderBackend (RenderSystem in
+//  the application), so the protocol runs without D3D12 in the tests.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "mpsc_queue.h"
+
+//--------------------------------------------------------------------------------
+//  Everything the render thread reads for one frame.  Written by the game
+//  thread only between BeginPacket and SubmitPacket.
+//--------------------------------------------------------------------------------
+struct RenderPacket
+{
+    uint64_t frame_index = 0;
+    float    delta_time = 0.0f;
+    float    clear_color[4] = { 0.690196097f, 0.768627524f, 0.870588303f, 1.0f };    // LightSteelBlue
+};
+
+//--------------------------------------------------------------------------------
+//  What the render thread calls, on the render thread only
+//--------------------------------------------------------------------------------
+class RenderBackend
+{
+public:
+    virtual void PrepareRender(const RenderPacket& packet) = 0;
+    virtual void Render() = 0;
+    virtual void OnResize(uint32_t width, uint32_t height) = 0;
+    virtual bool GetMsaaState() const = 0;
+    virtual void SetMsaaState(bool value) = 0;
+    virtual bool GetDynamicResolutionState() const = 0;
+    virtual void SetDynamicResolutionState(bool value) = 0;
+    virtual void OnMouseDown(uint32_t state, int x, int y) = 0;
+    virtual void OnMouseUp(uint32_t state, int x, int y) = 0;
+    virtual void OnMouseMove(uint32_t state, int x, int y) = 0;
+
+protected:
+    ~RenderBackend() = default;
+};
+
+class RenderThread
+{
+public:
+    static constexpr uint32_t kPacketCount = 3;
+    static constexpr uint32_t kCommandCapacity = 64;   // power of 2
+
+    static RenderThread* Create();
+    static RenderThread& Instance() { return *instance_; }
+
+    //--------------------------------------------------------------------------------
+    //  backend must be initialized.  From here on it is only used by the
+    //  render thread.  Release executes what is queued, then joins.
+    //--------------------------------------------------------------------------------
+    void Initialize(RenderBackend* backend);
+    void Release();
+
+    //--------------------------------------------------------------------------------
+    //  Game thread.  BeginPacket waits while every packet is queued or being
+    //  rendered.
+    //--------------------------------------------------------------------------------
+    RenderPacket& BeginPacket();
+    void SubmitPacket();
+
+    //--------------------------------------------------------------------------------
+    //  Any thread
+    //--------------------------------------------------------------------------------
+    void PostResize(uint32_t width, uint32_t height);
+    void PostToggleMsaa();
+    void PostToggleDynamicResolution();
+
+    //--------------------------------------------------------------------------------
+    //  Any thread.  state is the button state of the mouse message.
+    //--------------------------------------------------------------------------------
+    void PostMouseDown(uint32_t state, int x, int y);
+    void PostMouseUp(uint32_t state, int x, int y);
+    void PostMouseMove(uint32_t state, int x, int y);
+
+    uint64_t FramesRendered() const { return frames_rendered_.load(std::memory_order_relaxed); }
+
+private:
+    enum class CommandType : uint32_t
+    {
+        kNone = 0,
+        kFrame,
+        kResize,
+        kToggleMsaa,
+        kToggleDynamicResolution,
+        kMouseDown,
+        kMouseUp,
+        kMouseMove,
+        kQuit,
+    };
+
+    struct Command
+    {
+        CommandType type = CommandType::kNone;
+        uint32_t packet = 0;
+        uint32_t width = 0;     // kResize, mouse: button state
+        uint32_t height = 0;
+        int32_t  x = 0;         // mouse position
+        int32_t  y = 0;
+    };
+
+    RenderThread();
+    ~RenderThread() = default;
+    RenderThread(const RenderThread& rhs) = delete;
+    RenderThread& operator=(const RenderThread& rhs) = delete;
+
+    void Post(const Command& command);
+    void PostMouse(CommandType type, uint32_t state, int x, int y);
+    void ThreadLoop();
+    void Execute(const Command& command);
+    void ReleasePacket(uint32_t index);
+
+    RenderBackend* backend_ = nullptr;
+    std::thread thread_;
+
+    MpscQueue<Command> commands_;
+    std::atomic<uint32_t> pending_{ 0 };        // pushed but not popped
+    std::atomic<bool> sleeping_{ false };
+    std::mutex wake_mutex_;
+    std::condition_variable wake_condition_;
+
+    RenderPacket packets_[kPacketCount];
+    std::atomic<uint32_t> free_packets_{ (1u << kPacketCount) - 1 };    // bit mask
+    uint32_t writing_packet_ = kPacketCount;    // game thread only
+    std::mutex packet_mutex_;
+    std::condition_variable packet_released_;
+
+    std::atomic<uint64_t> frames_rendered_{ 0 };
+
+    static RenderThread* instance_;
+};
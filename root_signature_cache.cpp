@@ -0,0 +1,253 @@
+//--------------------------------------------------------------------------------
+//  root_signature_cache.cpp
+//--------------------------------------------------------------------------------
+#include "root_signature_cache.h"
+#include "hash_util.h"
+#include <iterator>
+
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+RootSignatureCache* RootSignatureCache::instance_ = nullptr;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+RootSignatureCache* RootSignatureCache::Create()
+{
+    if (instance_) return instance_;
+    instance_ = new RootSignatureCache;
+    return instance_;
+}
+
+void RootSignatureCache::Initialize(ID3D12Device* device, const wstring& cache_directory)
+{
+    device_ = device;
+    cache_directory_ = cache_directory;
+    if (!cache_directory_.empty()) CreateDirectory(cache_directory_.c_str(), nullptr);
+
+    D3D12_FEATURE_DATA_ROOT_SIGNATURE feature = {};
+    feature.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+    version_ = SUCCEEDED(device_->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &feature, sizeof(feature)))
+        ? feature.HighestVersion : D3D_ROOT_SIGNATURE_VERSION_1_0;
+}
+
+void RootSignatureCache::Release()
+{
+    assert(instance_ != nullptr);
+    instance_ = nullptr;
+    delete this;
+}
+
+ID3D12RootSignature* RootSignatureCache::Get(const RootSignatureLayout& layout)
+{
+    vector<uint32_t> words = layout.Words();
+    const uint64_t hash = HashWords(words.data(), words.size());
+
+    lock_guard<mutex> lock(mutex_);
+    ++statistics_.requests;
+    if (ComPtr<ID3D12RootSignature>* cached = root_signatures_.Find(hash, words))
+    {
+        ++statistics_.memory_hits;
+        return cached->Get();
+    }
+
+    ComPtr<ID3D12RootSignature> root_signature;
+    ComPtr<ID3DBlob> blob = LoadBlob(hash, words);
+    if (blob && SUCCEEDED(device_->CreateRootSignature(0, blob->GetBufferPointer(), blob->GetBufferSize(),
+        IID_PPV_ARGS(root_signature.GetAddressOf()))))
+    {
+        ++statistics_.disk_hits;
+    }
+    else
+    {
+        // Missing, stale or rejected by the driver: serialize again.
+        blob = Serialize(layout);
+        ThrowIfFailed(device_->CreateRootSignature(0, blob->GetBufferPointer(), blob->GetBufferSize(),
+            IID_PPV_ARGS(root_signature.ReleaseAndGetAddressOf())));
+        StoreBlob(hash, words, blob.Get());
+        ++statistics_.serialized;
+    }
+
+    return root_signatures_.Insert(hash, move(words), move(root_signature)).Get();
+}
+
+RootSignatureCache::Statistics RootSignatureCache::Stats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return statistics_;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+ComPtr<ID3DBlob> RootSignatureCache::Serialize(const RootSignatureLayout& layout) const
+{
+    const vector<RootParameter>& parameters = layout.Parameters();
+    const vector<RootDescriptorRange>& ranges = layout.Ranges();
+    const vector<RootStaticSampler>& samplers = layout.StaticSamplers();
+
+    vector<D3D12_STATIC_SAMPLER_DESC> static_samplers(samplers.size());
+    for (size_t i = 0; i < samplers.size(); ++i)
+    {
+        const RootStaticSampler& source = samplers[i];
+        D3D12_STATIC_SAMPLER_DESC& sampler = static_samplers[i];
+        sampler.Filter = static_cast<D3D12_FILTER>(source.filter);
+        sampler.AddressU = static_cast<D3D12_TEXTURE_ADDRESS_MODE>(source.address_u);
+        sampler.AddressV = static_cast<D3D12_TEXTURE_ADDRESS_MODE>(source.address_v);
+        sampler.AddressW = static_cast<D3D12_TEXTURE_ADDRESS_MODE>(source.address_w);
+        sampler.MipLODBias = source.mip_lod_bias;
+        sampler.MaxAnisotropy = source.max_anisotropy;
+        sampler.ComparisonFunc = static_cast<D3D12_COMPARISON_FUNC>(source.comparison_func);
+        sampler.BorderColor = static_cast<D3D12_STATIC_BORDER_COLOR>(source.border_color);
+        sampler.MinLOD = source.min_lod;
+        sampler.MaxLOD = source.max_lod;
+        sampler.ShaderRegister = source.shader_register;
+        sampler.RegisterSpace = source.space;
+        sampler.ShaderVisibility = static_cast<D3D12_SHADER_VISIBILITY>(source.visibility);
+    }
+
+    ComPtr<ID3DBlob> serialized;
+    ComPtr<ID3DBlob> errors;
+    HRESULT hr = S_OK;
+    if (version_ == D3D_ROOT_SIGNATURE_VERSION_1_1)
+    {
+        vector<D3D12_DESCRIPTOR_RANGE1> ranges_1(ranges.size());
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            ranges_1[i].RangeType = static_cast<D3D12_DESCRIPTOR_RANGE_TYPE>(ranges[i].type);
+            ranges_1[i].NumDescriptors = ranges[i].count;
+            ranges_1[i].BaseShaderRegister = ranges[i].base_register;
+            ranges_1[i].RegisterSpace = ranges[i].space;
+            ranges_1[i].Flags = static_cast<D3D12_DESCRIPTOR_RANGE_FLAGS>(ranges[i].flags);
+            ranges_1[i].OffsetInDescriptorsFromTableStart = ranges[i].offset;
+        }
+
+        vector<D3D12_ROOT_PARAMETER1> parameters_1(parameters.size());
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            const RootParameter& source = parameters[i];
+            D3D12_ROOT_PARAMETER1& parameter = parameters_1[i];
+            parameter.ParameterType = static_cast<D3D12_ROOT_PARAMETER_TYPE>(source.type);
+            parameter.ShaderVisibility = static_cast<D3D12_SHADER_VISIBILITY>(source.visibility);
+            switch (source.type)
+            {
+            case RootParameterType::kDescriptorTable:
+                parameter.DescriptorTable.NumDescriptorRanges = source.range_count;
+                parameter.DescriptorTable.pDescriptorRanges = ranges_1.data() + source.first_range;
+                break;
+            case RootParameterType::kConstants:
+                parameter.Constants.ShaderRegister = source.shader_register;
+                parameter.Constants.RegisterSpace = source.space;
+                parameter.Constants.Num32BitValues = source.constant_count;
+                break;
+            default:
+                parameter.Descriptor.ShaderRegister = source.shader_register;
+                parameter.Descriptor.RegisterSpace = source.space;
+                parameter.Descriptor.Flags = static_cast<D3D12_ROOT_DESCRIPTOR_FLAGS>(source.flags);
+                break;
+            }
+        }
+
+        D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc;
+        desc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+        desc.Desc_1_1.NumParameters = static_cast<UINT>(parameters_1.size());
+        desc.Desc_1_1.pParameters = parameters_1.data();
+        desc.Desc_1_1.NumStaticSamplers = static_cast<UINT>(static_samplers.size());
+        desc.Desc_1_1.pStaticSamplers = static_samplers.data();
+        desc.Desc_1_1.Flags = static_cast<D3D12_ROOT_SIGNATURE_FLAGS>(layout.Flags());
+        hr = D3D12SerializeVersionedRootSignature(&desc, serialized.GetAddressOf(), errors.GetAddressOf());
+    }
+    else
+    {
+        vector<D3D12_DESCRIPTOR_RANGE> ranges_0(ranges.size());
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            ranges_0[i].RangeType = static_cast<D3D12_DESCRIPTOR_RANGE_TYPE>(ranges[i].type);
+            ranges_0[i].NumDescriptors = ranges[i].count;
+            ranges_0[i].BaseShaderRegister = ranges[i].base_register;
+            ranges_0[i].RegisterSpace = ranges[i].space;
+            ranges_0[i].OffsetInDescriptorsFromTableStart = ranges[i].offset;
+        }
+
+        vector<D3D12_ROOT_PARAMETER> parameters_0(parameters.size());
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            const RootParameter& source = parameters[i];
+            D3D12_ROOT_PARAMETER& parameter = parameters_0[i];
+            parameter.ParameterType = static_cast<D3D12_ROOT_PARAMETER_TYPE>(source.type);
+            parameter.ShaderVisibility = static_cast<D3D12_SHADER_VISIBILITY>(source.visibility);
+            switch (source.type)
+            {
+            case RootParameterType::kDescriptorTable:
+                parameter.DescriptorTable.NumDescriptorRanges = source.range_count;
+                parameter.DescriptorTable.pDescriptorRanges = ranges_0.data() + source.first_range;
+                break;
+            case RootParameterType::kConstants:
+                parameter.Constants.ShaderRegister = source.shader_register;
+                parameter.Constants.RegisterSpace = source.space;
+                parameter.Constants.Num32BitValues = source.constant_count;
+                break;
+            default:
+                parameter.Descriptor.ShaderRegister = source.shader_register;
+                parameter.Descriptor.RegisterSpace = source.space;
+                break;
+            }
+        }
+
+        D3D12_ROOT_SIGNATURE_DESC desc;
+        desc.NumParameters = static_cast<UINT>(parameters_0.size());
+        desc.pParameters = parameters_0.data();
+        desc.NumStaticSamplers = static_cast<UINT>(static_samplers.size());
+        desc.pStaticSamplers = static_samplers.data();
+        desc.Flags = static_cast<D3D12_ROOT_SIGNATURE_FLAGS>(layout.Flags());
+        hr = D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, serialized.GetAddressOf(), errors.GetAddressOf());
+    }
+
+    if (errors != nullptr)
+    {
+        ::OutputDebugStringA((char*)errors->GetBufferPointer());
+    }
+    ThrowIfFailed(hr);
+    return serialized;
+}
+
+ComPtr<ID3DBlob> RootSignatureCache::LoadBlob(uint64_t hash, const vector<uint32_t>& words) const
+{
+    if (cache_directory_.empty()) return nullptr;
+    ifstream file(BlobPath(hash), ios::binary);
+    if (!file) return nullptr;
+    const vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    size_t blob_size = 0;
+    const uint8_t* stored = RootSignatureBlobFile::Read(data.data(), data.size(), static_cast<uint32_t>(version_), words, &blob_size);
+    if (!stored) return nullptr;
+
+    ComPtr<ID3DBlob> blob;
+    if (FAILED(D3DCreateBlob(blob_size, blob.GetAddressOf()))) return nullptr;
+    memcpy(blob->GetBufferPointer(), stored, blob_size);
+    return blob;
+}
+
+void RootSignatureCache::StoreBlob(uint64_t hash, const vector<uint32_t>& words, ID3DBlob* blob) const
+{
+    if (cache_directory_.empty()) return;
+
+    const vector<uint8_t> data = RootSignatureBlobFile::Write(static_cast<uint32_t>(version_), words,
+        blob->GetBufferPointer(), blob->GetBufferSize());
+
+    // A failed write only costs a serialize on the next run.
+    ofstream file(BlobPath(hash), ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+wstring RootSignatureCache::BlobPath(uint64_t hash) const
+{
+    wchar_t name[64];
+    swprintf_s(name, L"root_signature_%016llx.bin", static_cast<unsigned long long>(hash));
+    return cache_directory_ + L"\\" + name;
+}
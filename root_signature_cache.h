@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------
+//  root_signature_cache.h
+//  Shared root signatures, one per distinct RootSignatureLayout.
+//  - Layouts are deduplicated by Hash(), collisions are told apart by the
+//    canonical words, so PSO creation never serializes the same layout twice.
+//  - Serialized blobs are stored on disk next to the shader bytecode and
+//    reused on the next run without calling the serializer.
+//  - Version 1.1 is used when the device supports it; otherwise the 1.0 desc
+//    is built directly from the layout (1.1 only flags are dropped) instead of
+//    converting through D3DX12SerializeVersionedRootSignature, which HeapAllocs.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+#include "root_signature_layout.h"
+#include <mutex>
+
+class RootSignatureCache
+{
+public:
+    static RootSignatureCache* Create();
+    static RootSignatureCache& Instance() { return *instance_; }
+    static bool IsCreated() { return instance_ != nullptr; }
+
+    //--------------------------------------------------------------------------------
+    //  cache_directory : where blobs are stored, created if missing.  Empty
+    //                    keeps the cache in memory only.
+    //--------------------------------------------------------------------------------
+    void Initialize(ID3D12Device* device, const std::wstring& cache_directory);
+    void Release();
+
+    //--------------------------------------------------------------------------------
+    //  Root signature for layout, owned by the cache until Release.  Thread safe.
+    //--------------------------------------------------------------------------------
+    ID3D12RootSignature* Get(const RootSignatureLayout& layout);
+
+    D3D_ROOT_SIGNATURE_VERSION Version() const { return version_; }
+
+    struct Statistics
+    {
+        UINT requests = 0;
+        UINT memory_hits = 0;
+        UINT disk_hits = 0;
+        UINT serialized = 0;
+    };
+    Statistics Stats() const;
+
+private:
+    RootSignatureCache() = default;
+    ~RootSignatureCache() = default;
+    RootSignatureCache(const RootSignatureCache& rhs) = delete;
+    RootSignatureCache& operator=(const RootSignatureCache& rhs) = delete;
+
+    Microsoft::WRL::ComPtr<ID3DBlob> Serialize(const RootSignatureLayout& layout) const;
+    Microsoft::WRL::ComPtr<ID3DBlob> LoadBlob(uint64_t hash, const std::vector<uint32_t>& words) const;
+    void StoreBlob(uint64_t hash, const std::vector<uint32_t>& words, ID3DBlob* blob) const;
+    std::wstring BlobPath(uint64_t hash) const;
+
+    ID3D12Device* device_ = nullptr;
+    D3D_ROOT_SIGNATURE_VERSION version_ = D3D_ROOT_SIGNATURE_VERSION_1_0;
+    std::wstring cache_directory_;
+
+    mutable std::mutex mutex_;
+    RootSignatureLayoutTable<Microsoft::WRL::ComPtr<ID3D12RootSignature>> root_signatures_;
+    Statistics statistics_;
+
+    static RootSignatureCache* instance_;
+};
@@ -0,0 +1,219 @@
+//--------------------------------------------------------------------------------
+//  root_signature_layout.cpp
+//--------------------------------------------------------------------------------
+#include "root_signature_layout.h"
+#include "hash_util.h"
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    // Bumped whenever the encoding changes, so cached blobs are not reused.
+    constexpr uint32_t kEncodingVersion = 1;
+
+    constexpr uint32_t kBlobMagic = 0x43535352;    // "RSSC"
+
+    struct BlobHeader
+    {
+        uint32_t magic;
+        uint32_t version;       // D3D_ROOT_SIGNATURE_VERSION
+        uint32_t word_count;
+        uint32_t blob_size;
+    };
+
+    uint32_t FloatBits(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+RootSignatureLayout& RootSignatureLayout::AddConstants(uint32_t count, uint32_t shader_register, uint32_t space, uint32_t visibility)
+{
+    RootParameter parameter;
+    parameter.type = RootParameterType::kConstants;
+    parameter.visibility = visibility;
+    parameter.shader_register = shader_register;
+    parameter.space = space;
+    parameter.constant_count = count;
+    parameters_.push_back(parameter);
+    return *this;
+}
+
+RootSignatureLayout& RootSignatureLayout::AddConstantBufferView(uint32_t shader_register, uint32_t space, uint32_t visibility, uint32_t flags)
+{
+    return AddRootDescriptor(RootParameterType::kConstantBufferView, shader_register, space, visibility, flags);
+}
+
+RootSignatureLayout& RootSignatureLayout::AddShaderResourceView(uint32_t shader_register, uint32_t space, uint32_t visibility, uint32_t flags)
+{
+    return AddRootDescriptor(RootParameterType::kShaderResourceView, shader_register, space, visibility, flags);
+}
+
+RootSignatureLayout& RootSignatureLayout::AddUnorderedAccessView(uint32_t shader_register, uint32_t space, uint32_t visibility, uint32_t flags)
+{
+    return AddRootDescriptor(RootParameterType::kUnorderedAccessView, shader_register, space, visibility, flags);
+}
+
+RootSignatureLayout& RootSignatureLayout::AddDescriptorTable(const RootDescriptorRange* ranges, uint32_t count, uint32_t visibility)
+{
+    RootParameter parameter;
+    parameter.type = RootParameterType::kDescriptorTable;
+    parameter.visibility = visibility;
+    parameter.first_range = static_cast<uint32_t>(ranges_.size());
+    parameter.range_count = count;
+    ranges_.insert(ranges_.end(), ranges, ranges + count);
+    parameters_.push_back(parameter);
+    return *this;
+}
+
+RootSignatureLayout& RootSignatureLayout::AddStaticSampler(const RootStaticSampler& sampler)
+{
+    static_samplers_.push_back(sampler);
+    return *this;
+}
+
+RootSignatureLayout& RootSignatureLayout::SetFlags(uint32_t flags)
+{
+    flags_ = flags;
+    return *this;
+}
+
+vector<uint32_t> RootSignatureLayout::Words() const
+{
+    vector<uint32_t> words;
+    words.reserve(4 + parameters_.size() * 6 + ranges_.size() * 6 + static_samplers_.size() * 13);
+    words.push_back(kEncodingVersion);
+    words.push_back(flags_);
+    words.push_back(static_cast<uint32_t>(parameters_.size()));
+    words.push_back(static_cast<uint32_t>(static_samplers_.size()));
+
+    for (const RootParameter& parameter : parameters_)
+    {
+        words.push_back(static_cast<uint32_t>(parameter.type));
+        words.push_back(parameter.visibility);
+        switch (parameter.type)
+        {
+        case RootParameterType::kDescriptorTable:
+        {
+            words.push_back(parameter.range_count);
+            uint32_t next_offset = 0;
+            for (uint32_t i = 0; i < parameter.range_count; ++i)
+            {
+                const RootDescriptorRange& range = ranges_[parameter.first_range + i];
+                const uint32_t offset = range.offset == kDescriptorRangeOffsetAppend ? next_offset : range.offset;
+                next_offset = offset + range.count;
+                words.push_back(static_cast<uint32_t>(range.type));
+                words.push_back(range.count);
+                words.push_back(range.base_register);
+                words.push_back(range.space);
+                words.push_back(range.flags);
+                words.push_back(offset);
+            }
+            break;
+        }
+        case RootParameterType::kConstants:
+            words.push_back(parameter.shader_register);
+            words.push_back(parameter.space);
+            words.push_back(parameter.constant_count);
+            break;
+        default:
+            words.push_back(parameter.shader_register);
+            words.push_back(parameter.space);
+            words.push_back(parameter.flags);
+            break;
+        }
+    }
+
+    for (const RootStaticSampler& sampler : static_samplers_)
+    {
+        words.push_back(sampler.filter);
+        words.push_back(sampler.address_u);
+        words.push_back(sampler.address_v);
+        words.push_back(sampler.address_w);
+        words.push_back(FloatBits(sampler.mip_lod_bias));
+        words.push_back(sampler.max_anisotropy);
+        words.push_back(sampler.comparison_func);
+        words.push_back(sampler.border_color);
+        words.push_back(FloatBits(sampler.min_lod));
+        words.push_back(FloatBits(sampler.max_lod));
+        words.push_back(sampler.shader_register);
+        words.push_back(sampler.space);
+        words.push_back(sampler.visibility);
+    }
+    return words;
+}
+
+uint64_t RootSignatureLayout::Hash() const
+{
+    const vector<uint32_t> words = Words();
+    return HashWords(words.data(), words.size());
+}
+
+//--------------------------------------------------------------------------------
+//
+//  RootSignatureBlobFile
+//
+//--------------------------------------------------------------------------------
+vector<uint8_t> RootSignatureBlobFile::Write(uint32_t version, const vector<uint32_t>& words, const void* blob, size_t blob_size)
+{
+    BlobHeader header;
+    header.magic = kBlobMagic;
+    header.version = version;
+    header.word_count = static_cast<uint32_t>(words.size());
+    header.blob_size = static_cast<uint32_t>(blob_size);
+
+    const size_t words_size = words.size() * sizeof(uint32_t);
+    vector<uint8_t> file(sizeof(header) + words_size + blob_size);
+    memcpy(file.data(), &header, sizeof(header));
+    if (words_size) memcpy(file.data() + sizeof(header), words.data(), words_size);
+    if (blob_size) memcpy(file.data() + sizeof(header) + words_size, blob, blob_size);
+    return file;
+}
+
+const uint8_t* RootSignatureBlobFile::Read(const uint8_t* data, size_t size, uint32_t version,
+    const vector<uint32_t>& words, size_t* blob_size)
+{
+    BlobHeader header;
+    if (size < sizeof(header)) return nullptr;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != kBlobMagic
+        || header.version != version
+        || header.word_count != words.size()
+        || header.blob_size == 0)
+    {
+        return nullptr;
+    }
+
+    // Truncated or trailing data means a write was interrupted or mixed up.
+    const size_t words_size = words.size() * sizeof(uint32_t);
+    if (size != sizeof(header) + words_size + header.blob_size) return nullptr;
+    if (words_size && memcmp(data + sizeof(header), words.data(), words_size) != 0) return nullptr;
+
+    *blob_size = header.blob_size;
+    return data + sizeof(header) + words_size;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+RootSignatureLayout& RootSignatureLayout::AddRootDescriptor(RootParameterType type, uint32_t shader_register, uint32_t space, uint32_t visibility, uint32_t flags)
+{
+    RootParameter parameter;
+    parameter.type = type;
+    parameter.visibility = visibility;
+    parameter.shader_register = shader_register;
+    parameter.space = space;
+    parameter.flags = flags;
+    parameters_.push_back(parameter);
+    return *this;
+}
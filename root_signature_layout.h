@@ -0,0 +1,172 @@
+//--------------------------------------------------------------------------------
+//  root_signature_layout.h
+//  Platform neutral description of a root signature (no D3D12 headers), used
+//  as the key of RootSignatureCache.
+//  - Built with the Add* functions; enumerations and flags hold the numeric
+//    values of the matching D3D12 enumerations.
+//  - Words() is a canonical encoding: appended range offsets are resolved,
+//    floats are stored as bits.  Two layouts that describe the same root
+//    signature have the same words, and Hash() is HashWords over them.
+//  - RootSignatureLayoutTable deduplicates by hash and words,
+//    RootSignatureBlobFile is the on disk format of RootSignatureCache.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class RootParameterType : uint32_t     // D3D12_ROOT_PARAMETER_TYPE
+{
+    kDescriptorTable = 0,
+    kConstants = 1,
+    kConstantBufferView = 2,
+    kShaderResourceView = 3,
+    kUnorderedAccessView = 4,
+};
+
+enum class DescriptorRangeType : uint32_t   // D3D12_DESCRIPTOR_RANGE_TYPE
+{
+    kShaderResourceView = 0,
+    kUnorderedAccessView = 1,
+    kConstantBufferView = 2,
+    kSampler = 3,
+};
+
+constexpr uint32_t kShaderVisibilityAll = 0;            // D3D12_SHADER_VISIBILITY_ALL
+constexpr uint32_t kDescriptorRangeOffsetAppend = 0xffffffff;
+
+struct RootDescriptorRange
+{
+    DescriptorRangeType type = DescriptorRangeType::kShaderResourceView;
+    uint32_t count = 1;
+    uint32_t base_register = 0;
+    uint32_t space = 0;
+    uint32_t flags = 0;                                 // D3D12_DESCRIPTOR_RANGE_FLAGS (1.1 only)
+    uint32_t offset = kDescriptorRangeOffsetAppend;
+};
+
+struct RootParameter
+{
+    RootParameterType type = RootParameterType::kConstants;
+    uint32_t visibility = kShaderVisibilityAll;         // D3D12_SHADER_VISIBILITY
+    uint32_t shader_register = 0;
+    uint32_t space = 0;
+    uint32_t constant_count = 0;                        // kConstants
+    uint32_t flags = 0;                                 // D3D12_ROOT_DESCRIPTOR_FLAGS (1.1 only)
+    uint32_t first_range = 0;                           // kDescriptorTable: into Ranges()
+    uint32_t range_count = 0;
+};
+
+struct RootStaticSampler                                // D3D12_STATIC_SAMPLER_DESC
+{
+    uint32_t filter = 0x55;                             // D3D12_FILTER_ANISOTROPIC
+    uint32_t address_u = 1;                             // D3D12_TEXTURE_ADDRESS_MODE_WRAP
+    uint32_t address_v = 1;
+    uint32_t address_w = 1;
+    float    mip_lod_bias = 0.0f;
+    uint32_t max_anisotropy = 16;
+    uint32_t comparison_func = 4;                       // D3D12_COMPARISON_FUNC_LESS_EQUAL
+    uint32_t border_color = 2;                          // D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE
+    float    min_lod = 0.0f;
+    float    max_lod = 3.402823466e+38f;
+    uint32_t shader_register = 0;
+    uint32_t space = 0;
+    uint32_t visibility = kShaderVisibilityAll;
+};
+
+class RootSignatureLayout
+{
+public:
+    RootSignatureLayout& AddConstants(uint32_t count, uint32_t shader_register, uint32_t space = 0, uint32_t visibility = kShaderVisibilityAll);
+    RootSignatureLayout& AddConstantBufferView(uint32_t shader_register, uint32_t space = 0, uint32_t visibility = kShaderVisibilityAll, uint32_t flags = 0);
+    RootSignatureLayout& AddShaderResourceView(uint32_t shader_register, uint32_t space = 0, uint32_t visibility = kShaderVisibilityAll, uint32_t flags = 0);
+    RootSignatureLayout& AddUnorderedAccessView(uint32_t shader_register, uint32_t space = 0, uint32_t visibility = kShaderVisibilityAll, uint32_t flags = 0);
+    RootSignatureLayout& AddDescriptorTable(const RootDescriptorRange* ranges, uint32_t count, uint32_t visibility = kShaderVisibilityAll);
+    RootSignatureLayout& AddStaticSampler(const RootStaticSampler& sampler);
+    RootSignatureLayout& SetFlags(uint32_t flags);      // D3D12_ROOT_SIGNATURE_FLAGS
+
+    const std::vector<RootParameter>&       Parameters() const { return parameters_; }
+    const std::vector<RootDescriptorRange>& Ranges() const { return ranges_; }
+    const std::vector<RootStaticSampler>&   StaticSamplers() const { return static_samplers_; }
+    uint32_t Flags() const { return flags_; }
+
+    //--------------------------------------------------------------------------------
+    //  Canonical encoding and its hash
+    //--------------------------------------------------------------------------------
+    std::vector<uint32_t> Words() const;
+    uint64_t Hash() const;
+
+    bool operator==(const RootSignatureLayout& rhs) const { return Words() == rhs.Words(); }
+    bool operator!=(const RootSignatureLayout& rhs) const { return !(*this == rhs); }
+
+private:
+    RootSignatureLayout& AddRootDescriptor(RootParameterType type, uint32_t shader_register, uint32_t space, uint32_t visibility, uint32_t flags);
+
+    std::vector<RootParameter> parameters_;
+    std::vector<RootDescriptorRange> ranges_;
+    std::vector<RootStaticSampler> static_samplers_;
+    uint32_t flags_ = 0;
+};
+
+//--------------------------------------------------------------------------------
+//  One value per distinct layout: found by hash, told apart by the words
+//  when hashes collide.  Not thread safe.
+//--------------------------------------------------------------------------------
+template <class T>
+class RootSignatureLayoutTable
+{
+public:
+    //--------------------------------------------------------------------------------
+    //  nullptr when no layout with these words was inserted
+    //--------------------------------------------------------------------------------
+    T* Find(uint64_t hash, const std::vector<uint32_t>& words)
+    {
+        auto range = entries_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second.words == words) return &it->second.value;
+        }
+        return nullptr;
+    }
+
+    //--------------------------------------------------------------------------------
+    //  words must not be in the table yet
+    //--------------------------------------------------------------------------------
+    T& Insert(uint64_t hash, std::vector<uint32_t> words, T value)
+    {
+        auto it = entries_.emplace(hash, Entry{ std::move(words), std::move(value) });
+        return it->second.value;
+    }
+
+    size_t Size() const { return entries_.size(); }
+
+private:
+    struct Entry
+    {
+        std::vector<uint32_t> words;
+        T value;
+    };
+    std::unordered_multimap<uint64_t, Entry> entries_;
+};
+
+//--------------------------------------------------------------------------------
+//  Cache file of one serialized root signature: a header, the layout words
+//  (a guard against hash collisions and older encodings), then the blob
+//--------------------------------------------------------------------------------
+class RootSignatureBlobFile
+{
+public:
+    //--------------------------------------------------------------------------------
+    //  version : D3D_ROOT_SIGNATURE_VERSION the blob was serialized with
+    //--------------------------------------------------------------------------------
+    static std::vector<uint8_t> Write(uint32_t version, const std::vector<uint32_t>& words, const void* blob, size_t blob_size);
+
+    //--------------------------------------------------------------------------------
+    //  The blob inside data, or nullptr unless data is one complete file
+    //  written for this version and these words
+    //--------------------------------------------------------------------------------
+    static const uint8_t* Read(const uint8_t* data, size_t size, uint32_t version,
+        const std::vector<uint32_t>& words, size_t* blob_size);
+};
@@ -0,0 +1,173 @@
+//--------------------------------------------------------------------------------
+//  shadow_atlas.cpp
+//--------------------------------------------------------------------------------
+#include "shadow_atlas.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+namespace
+{
+    // Even bits of a Morton index.
+    uint32_t CompactBits(uint32_t value)
+    {
+        value &= 0x55555555;
+        value = (value | (value >> 1)) & 0x33333333;
+        value = (value | (value >> 2)) & 0x0f0f0f0f;
+        value = (value | (value >> 4)) & 0x00ff00ff;
+        value = (value | (value >> 8)) & 0x0000ffff;
+        return value;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void ShadowAtlas::Initialize(uint32_t size, uint32_t min_tile_size)
+{
+    assert(min_tile_size > 0 && (size & (size - 1)) == 0 && (min_tile_size & (min_tile_size - 1)) == 0 && min_tile_size <= size);
+    size_ = size;
+    level_count_ = 1;
+    while ((size >> level_count_) >= min_tile_size && level_count_ < kMaxLevels) ++level_count_;
+    assert((size >> (level_count_ - 1)) == min_tile_size && "Too many tile sizes, raise kMaxLevels.");
+
+    states_.resize(FirstNode(level_count_));
+    free_slots_.resize(states_.size());
+    Clear();
+}
+
+void ShadowAtlas::Clear()
+{
+    fill(states_.begin(), states_.end(), NodeState::kCovered);
+    for (auto& list : free_lists_) list.clear();
+    tile_count_ = 0;
+    free_texels_ = 0;
+    if (states_.empty()) return;
+
+    states_[0] = NodeState::kFree;
+    PushFree(0, 0);
+    free_texels_ = static_cast<uint64_t>(size_) * size_;
+}
+
+uint32_t ShadowAtlas::Allocate(uint32_t size)
+{
+    // Deepest level whose tiles still hold size texels.
+    uint32_t level = 0;
+    while (level + 1 < level_count_ && (size_ >> (level + 1)) >= size) ++level;
+    if ((size_ >> level) < size) return kInvalidNode;
+
+    // Smallest free block that fits.
+    uint32_t source = level + 1;
+    while (source > 0 && free_lists_[source - 1].empty()) --source;
+    if (source == 0) return kInvalidNode;
+    --source;
+
+    uint32_t node = free_lists_[source].back();
+    RemoveFree(source, node);
+
+    // Split down to the requested level, keeping the first quarter.
+    for (; source < level; ++source)
+    {
+        states_[node] = NodeState::kSplit;
+        const uint32_t child = FirstNode(source + 1) + (node - FirstNode(source)) * 4;
+        for (uint32_t i = 3; i > 0; --i)
+        {
+            states_[child + i] = NodeState::kFree;
+            PushFree(source + 1, child + i);
+        }
+        node = child;
+    }
+
+    states_[node] = NodeState::kUsed;
+    ++tile_count_;
+    free_texels_ -= static_cast<uint64_t>(size_ >> level) * (size_ >> level);
+    return node;
+}
+
+void ShadowAtlas::Free(uint32_t node)
+{
+    if (node == kInvalidNode) return;
+    assert(node < states_.size() && states_[node] == NodeState::kUsed);
+    uint32_t level = Level(node);
+    --tile_count_;
+    free_texels_ += static_cast<uint64_t>(size_ >> level) * (size_ >> level);
+
+    // Merge while the 3 siblings are free too.
+    while (level > 0)
+    {
+        const uint32_t first_sibling = node - (node - FirstNode(level)) % 4;
+        bool siblings_free = true;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const uint32_t sibling = first_sibling + i;
+            if (sibling != node && states_[sibling] != NodeState::kFree) siblings_free = false;
+        }
+        if (!siblings_free) break;
+
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const uint32_t sibling = first_sibling + i;
+            if (sibling != node) RemoveFree(level, sibling);
+            states_[sibling] = NodeState::kCovered;
+        }
+        node = FirstNode(level - 1) + (first_sibling - FirstNode(level)) / 4;
+        --level;
+    }
+
+    states_[node] = NodeState::kFree;
+    PushFree(level, node);
+}
+
+ShadowTile ShadowAtlas::Tile(uint32_t node) const
+{
+    ShadowTile tile;
+    if (node == kInvalidNode) return tile;
+    assert(node < states_.size());
+    const uint32_t level = Level(node);
+    const uint32_t morton = node - FirstNode(level);
+    tile.size = size_ >> level;
+    tile.x = CompactBits(morton) * tile.size;
+    tile.y = CompactBits(morton >> 1) * tile.size;
+    return tile;
+}
+
+uint32_t ShadowAtlas::LargestFreeTile() const
+{
+    for (uint32_t level = 0; level < level_count_; ++level)
+    {
+        if (!free_lists_[level].empty()) return size_ >> level;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+uint32_t ShadowAtlas::Level(uint32_t node) const
+{
+    uint32_t level = 0;
+    while (level + 1 < level_count_ && node >= FirstNode(level + 1)) ++level;
+    return level;
+}
+
+void ShadowAtlas::PushFree(uint32_t level, uint32_t node)
+{
+    free_slots_[node] = static_cast<uint32_t>(free_lists_[level].size());
+    free_lists_[level].push_back(node);
+}
+
+void ShadowAtlas::RemoveFree(uint32_t level, uint32_t node)
+{
+    // Swap with the last entry.
+    vector<uint32_t>& list = free_lists_[level];
+    const uint32_t slot = free_slots_[node];
+    assert(slot < list.size() && list[slot] == node);
+    list[slot] = list.back();
+    free_slots_[list[slot]] = slot;
+    list.pop_back();
+}
@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------
+//  shadow_atlas.h
+//  Square tiles of one shadow map texture shared by many shadow views
+//  (CPU only).  The atlas is a quadtree: a free block is split into 4
+//  quarters until it has the requested size, and 4 free quarters merge back
+//  into their parent when freed, so tiles are powers of 2 aligned on their
+//  size and never overlap.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct ShadowTile
+{
+    uint32_t x = 0;         // texels
+    uint32_t y = 0;
+    uint32_t size = 0;      // 0 : no tile
+};
+
+class ShadowAtlas
+{
+public:
+    static constexpr uint32_t kInvalidNode = 0xffffffff;
+    static constexpr uint32_t kMaxLevels = 10;      // e.g. 16384 down to 32 texels
+
+    //--------------------------------------------------------------------------------
+    //  size, min_tile_size : powers of 2, at most kMaxLevels tile sizes.
+    //  Frees every tile.
+    //--------------------------------------------------------------------------------
+    void Initialize(uint32_t size, uint32_t min_tile_size);
+    void Clear();
+
+    //--------------------------------------------------------------------------------
+    //  A tile of at least size texels (rounded up to a power of 2, at least
+    //  MinTileSize), kInvalidNode when no free block is large enough.
+    //  The smallest fitting block is split, which keeps large blocks whole.
+    //--------------------------------------------------------------------------------
+    uint32_t Allocate(uint32_t size);
+    void Free(uint32_t node);
+
+    ShadowTile Tile(uint32_t node) const;
+
+    uint32_t Size() const { return size_; }
+    uint32_t MinTileSize() const { return size_ >> (level_count_ - 1); }
+    uint32_t TileCount() const { return tile_count_; }
+    uint64_t FreeTexels() const { return free_texels_; }
+    uint32_t LargestFreeTile() const;
+
+private:
+    enum class NodeState : uint8_t { kCovered, kFree, kSplit, kUsed };
+
+    static uint32_t FirstNode(uint32_t level) { return ((1u << (2 * level)) - 1) / 3; }
+    uint32_t Level(uint32_t node) const;
+    void PushFree(uint32_t level, uint32_t node);
+    void RemoveFree(uint32_t level, uint32_t node);
+
+    uint32_t size_ = 0;
+    uint32_t level_count_ = 0;
+    uint32_t tile_count_ = 0;
+    uint64_t free_texels_ = 0;
+
+    // Complete quadtree, level by level; the 4 children of node i of a level
+    // are nodes 4i .. 4i+3 of the next one (Morton order).
+    std::vector<NodeState> states_;
+    std::vector<uint32_t> free_slots_;              // position in free_lists_, per node
+    std::vector<uint32_t> free_lists_[kMaxLevels];  // free nodes per level
+};
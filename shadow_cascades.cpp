@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------
+//  shadow_cascades.cpp
+//--------------------------------------------------------------------------------
+#include "shadow_cascades.h"
+#include "d3dUtil.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+ShadowCascades::ShadowCascades(const ShadowCascadeSettings& settings)
+    : settings_(settings)
+{
+    assert(settings_.cascade_count >= 1 && settings_.cascade_count <= kMaxCascades);
+    assert(settings_.resolution > 2);
+    for (auto& view_proj : view_proj_) XMStoreFloat4x4(&view_proj, XMMatrixIdentity());
+}
+
+void ShadowCascades::ComputeSplits(float near_z, float far_z, uint32_t count, float lambda, float* splits)
+{
+    assert(near_z > 0.0f && far_z > near_z && count > 0);
+    splits[0] = near_z;
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        const float t = static_cast<float>(i) / count;
+        const float logarithmic = near_z * powf(far_z / near_z, t);
+        const float uniform = near_z + (far_z - near_z) * t;
+        splits[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+    }
+    splits[count] = far_z;
+}
+
+void ShadowCascades::Update(FXMMATRIX camera_view, float fov_y, float aspect, float near_z, float far_z, const Light& light)
+{
+    const uint32_t count = settings_.cascade_count;
+    ComputeSplits(near_z, far_z, count, settings_.split_lambda, splits_);
+
+    // Squared distance from the view axis to a frustum corner, per unit depth.
+    const float tan_y = tanf(fov_y * 0.5f);
+    const float corner_sq = tan_y * tan_y * (1.0f + aspect * aspect);
+
+    const XMMATRIX inverse_view = XMMatrixInverse(nullptr, camera_view);
+    const XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&light.Direction));
+    const XMVECTOR up = fabsf(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    const XMMATRIX light_view = XMMatrixLookToLH(XMVectorZero(), direction, up);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // Smallest sphere on the view axis around the slice: equally far from
+        // the near and far corners, unless the far corners alone decide.
+        const float n = splits_[i];
+        const float f = splits_[i + 1];
+        const float center_z = min((n + f) * 0.5f * (1.0f + corner_sq), f);
+        const float radius = sqrtf(max(corner_sq * f * f + (f - center_z) * (f - center_z),
+            corner_sq * n * n + (n - center_z) * (n - center_z)));
+
+        const XMVECTOR center = XMVector3Transform(XMVectorSet(0.0f, 0.0f, center_z, 1.0f), inverse_view);
+        XMStoreFloat3(&bounds_[i].Center, center);
+        bounds_[i].Radius = radius;
+
+        // One texel of margin absorbs the snapping.
+        const float half_size = radius * settings_.resolution / (settings_.resolution - 2);
+        const float texel = 2.0f * half_size / settings_.resolution;
+        XMFLOAT3 origin;
+        XMStoreFloat3(&origin, XMVectorScale(XMVectorFloor(XMVectorScale(XMVector3Transform(center, light_view), 1.0f / texel)), texel));
+
+        const XMMATRIX proj = XMMatrixOrthographicOffCenterLH(
+            origin.x - half_size, origin.x + half_size,
+            origin.y - half_size, origin.y + half_size,
+            origin.z - half_size - settings_.caster_depth, origin.z + half_size);
+        XMStoreFloat4x4(&view_proj_[i], XMMatrixMultiply(light_view, proj));
+    }
+}
@@ -0,0 +1,62 @@
+//--------------------------------------------------------------------------------
+//  shadow_cascades.h
+//  Cascaded shadow maps of the directional Light (d3dUtil.h), CPU only.
+//  - The view depth range is split by blending logarithmic and uniform
+//    splits (split_lambda 1 : logarithmic, 0 : uniform).
+//  - Each cascade is an orthographic projection around the bounding sphere
+//    of its frustum slice, so its size does not change when the camera
+//    turns, and its origin is snapped to whole texels, so shadows do not
+//    shimmer when the camera moves.  A camera moving less than a texel
+//    keeps the same matrix, which ShadowScheduler takes as a still view
+//    whose static casters are cached.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+
+struct Light;
+
+struct ShadowCascadeSettings
+{
+    uint32_t cascade_count = 4;
+    uint32_t resolution = 2048;         // tile size in texels of every cascade
+    float    split_lambda = 0.75f;
+    float    caster_depth = 200.0f;     // how far toward the light casters outside a slice may be
+};
+
+class ShadowCascades
+{
+public:
+    static constexpr uint32_t kMaxCascades = 4;
+
+    explicit ShadowCascades(const ShadowCascadeSettings& settings = ShadowCascadeSettings());
+
+    //--------------------------------------------------------------------------------
+    //  splits : count + 1 view depths from near_z to far_z
+    //--------------------------------------------------------------------------------
+    static void ComputeSplits(float near_z, float far_z, uint32_t count, float lambda, float* splits);
+
+    //--------------------------------------------------------------------------------
+    //  camera_view : world to view matrix of the camera (row vectors)
+    //  fov_y, aspect, near_z, far_z : its perspective projection
+    //  light : the directional light (Direction, pointing away from the light)
+    //--------------------------------------------------------------------------------
+    void Update(DirectX::FXMMATRIX camera_view, float fov_y, float aspect, float near_z, float far_z, const Light& light);
+
+    uint32_t CascadeCount() const { return settings_.cascade_count; }
+    const ShadowCascadeSettings& Settings() const { return settings_; }
+
+    //--------------------------------------------------------------------------------
+    //  Cascade i covers the view depths [Split(i), Split(i + 1)]
+    //--------------------------------------------------------------------------------
+    float Split(uint32_t i) const { return splits_[i]; }
+    const DirectX::XMFLOAT4X4& ViewProj(uint32_t i) const { return view_proj_[i]; }
+    const DirectX::BoundingSphere& Bounds(uint32_t i) const { return bounds_[i]; }     // world space
+
+private:
+    ShadowCascadeSettings settings_;
+    float splits_[kMaxCascades + 1] = {};
+    DirectX::XMFLOAT4X4 view_proj_[kMaxCascades];
+    DirectX::BoundingSphere bounds_[kMaxCascades];
+};
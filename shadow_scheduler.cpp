@@ -0,0 +1,272 @@
+//--------------------------------------------------------------------------------
+//  shadow_scheduler.cpp
+//--------------------------------------------------------------------------------
+#include "shadow_scheduler.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    uint32_t NextPowerOf2(uint32_t value)
+    {
+        uint32_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    bool IsSphereInFrustum(const XMFLOAT4 planes[6], const BoundingSphere& sphere)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            const XMFLOAT4& p = planes[i];
+            const float distance = p.x * sphere.Center.x + p.y * sphere.Center.y + p.z * sphere.Center.z + p.w;
+            if (distance < -sphere.Radius * sqrtf(p.x * p.x + p.y * p.y + p.z * p.z)) return false;
+        }
+        return true;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+ShadowScheduler::ShadowScheduler(const ShadowSchedulerSettings& settings)
+    : settings_(settings)
+{
+    assert(settings_.min_tile_size <= settings_.max_tile_size && settings_.max_tile_size <= settings_.atlas_size);
+    atlas_.Initialize(settings_.atlas_size, settings_.min_tile_size);
+}
+
+uint32_t ShadowScheduler::AddView(const ShadowView& view)
+{
+    uint32_t id;
+    if (free_ids_.empty())
+    {
+        id = static_cast<uint32_t>(views_.size());
+        views_.emplace_back();
+    }
+    else
+    {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+        views_[id] = Entry();
+    }
+
+    Entry& entry = views_[id];
+    entry.view = view;
+    entry.rendered_view_proj = view.view_proj;
+    entry.active = true;
+    return id;
+}
+
+void ShadowScheduler::RemoveView(uint32_t id)
+{
+    assert(id < views_.size() && views_[id].active);
+    ReleaseTile(views_[id]);
+    views_[id].active = false;
+    free_ids_.push_back(id);
+}
+
+void ShadowScheduler::SetView(uint32_t id, const ShadowView& view)
+{
+    assert(id < views_.size() && views_[id].active);
+    Entry& entry = views_[id];
+    if (memcmp(&entry.view.view_proj, &view.view_proj, sizeof(XMFLOAT4X4)) != 0) entry.static_valid = false;
+    entry.view = view;
+}
+
+void ShadowScheduler::InvalidateStatic(const BoundingBox& world_bounds)
+{
+    const XMFLOAT3& c = world_bounds.Center;
+    const XMFLOAT3& e = world_bounds.Extents;
+    for (Entry& entry : views_)
+    {
+        if (!entry.active) continue;
+        const XMFLOAT3& s = entry.view.influence.Center;
+        const float dx = max(fabsf(s.x - c.x) - e.x, 0.0f);
+        const float dy = max(fabsf(s.y - c.y) - e.y, 0.0f);
+        const float dz = max(fabsf(s.z - c.z) - e.z, 0.0f);
+        const float radius = entry.view.influence.Radius;
+        if (dx * dx + dy * dy + dz * dz <= radius * radius) entry.static_valid = false;
+    }
+}
+
+void ShadowScheduler::Schedule(const XMFLOAT4 planes[6], FXMVECTOR eye, float projection_scale,
+    vector<ShadowUpdate>& updates)
+{
+    updates.clear();
+
+    // Screen influence, as CullingSystem::ProjectedRadii.
+    XMFLOAT3 e;
+    XMStoreFloat3(&e, eye);
+    for (Entry& entry : views_)
+    {
+        if (!entry.active) continue;
+        const BoundingSphere& sphere = entry.view.influence;
+        entry.influence = 0.0f;
+        if (IsSphereInFrustum(planes, sphere))
+        {
+            const float dx = sphere.Center.x - e.x;
+            const float dy = sphere.Center.y - e.y;
+            const float dz = sphere.Center.z - e.z;
+            const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+            entry.influence = distance > sphere.Radius ? sphere.Radius * projection_scale / distance : projection_scale;
+        }
+        entry.desired_size = DesiredSize(entry);
+    }
+
+    AllocateTiles();
+
+    // Views whose tile is out of date, first draws first, then by
+    // influence weighted by the time waited.
+    order_.clear();
+    for (uint32_t id = 0; id < views_.size(); ++id)
+    {
+        Entry& entry = views_[id];
+        if (!entry.active || entry.node == ShadowAtlas::kInvalidNode || entry.influence <= 0.0f) continue;
+        if (entry.rendered && entry.static_valid && !entry.view.dynamic_casters)
+        {
+            entry.age = 0;
+            continue;
+        }
+        order_.push_back(id);
+    }
+
+    const size_t update_count = min<size_t>(order_.size(), settings_.update_budget);
+    partial_sort(order_.begin(), order_.begin() + update_count, order_.end(), [this](uint32_t a, uint32_t b)
+    {
+        const Entry& x = views_[a];
+        const Entry& y = views_[b];
+        if (x.rendered != y.rendered) return !x.rendered;
+        const float x_priority = x.influence * (x.age + 1);
+        const float y_priority = y.influence * (y.age + 1);
+        if (x_priority != y_priority) return x_priority > y_priority;
+        return a < b;
+    });
+
+    for (size_t i = 0; i < order_.size(); ++i)
+    {
+        Entry& entry = views_[order_[i]];
+        if (i >= update_count)
+        {
+            ++entry.age;
+            continue;
+        }
+
+        ShadowUpdate update;
+        update.view = order_[i];
+        update.tile = atlas_.Tile(entry.node);
+        update.static_casters = !entry.rendered || !entry.static_valid;
+        updates.push_back(update);
+
+        entry.rendered_view_proj = entry.view.view_proj;
+        entry.rendered = true;
+        entry.static_valid = true;
+        entry.age = 0;
+    }
+}
+
+ShadowTile ShadowScheduler::Tile(uint32_t id) const
+{
+    assert(id < views_.size());
+    const Entry& entry = views_[id];
+    return entry.rendered ? atlas_.Tile(entry.node) : ShadowTile();
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+uint32_t ShadowScheduler::DesiredSize(const Entry& entry) const
+{
+    if (entry.influence <= 0.0f) return 0;
+    if (entry.view.fixed_size > 0) return min(NextPowerOf2(entry.view.fixed_size), settings_.atlas_size);
+    const float texels = min(2.0f * entry.influence * settings_.texels_per_pixel, static_cast<float>(settings_.max_tile_size));
+    return min(max(NextPowerOf2(static_cast<uint32_t>(ceilf(texels))), settings_.min_tile_size), settings_.max_tile_size);
+}
+
+void ShadowScheduler::AllocateTiles()
+{
+    // Resize the tiles of visible views.  A larger tile is taken only when
+    // free space allows it; a tile shrinks once 4 times too large, so sizes
+    // do not flip every frame.
+    for (Entry& entry : views_)
+    {
+        if (!entry.active || entry.node == ShadowAtlas::kInvalidNode || entry.desired_size == 0) continue;
+        const uint32_t size = atlas_.Tile(entry.node).size;
+        if (entry.desired_size > size)
+        {
+            const uint32_t node = atlas_.Allocate(entry.desired_size);
+            if (node == ShadowAtlas::kInvalidNode) continue;
+            ReleaseTile(entry);
+            entry.node = node;
+        }
+        else if (entry.desired_size * 4 <= size)
+        {
+            ReleaseTile(entry);
+            entry.node = atlas_.Allocate(entry.desired_size);
+        }
+    }
+
+    // Visible views without a tile, most influential first.  Views with less
+    // influence (the ones off screen first) give their tiles up before a
+    // view settles for a smaller one.
+    order_.clear();
+    holders_.clear();
+    for (uint32_t id = 0; id < views_.size(); ++id)
+    {
+        const Entry& entry = views_[id];
+        if (!entry.active) continue;
+        if (entry.node != ShadowAtlas::kInvalidNode) holders_.push_back(id);
+        else if (entry.desired_size > 0) order_.push_back(id);
+    }
+    if (order_.empty()) return;
+
+    auto more_influence = [this](uint32_t a, uint32_t b)
+    {
+        if (views_[a].influence != views_[b].influence) return views_[a].influence > views_[b].influence;
+        return a < b;
+    };
+    sort(order_.begin(), order_.end(), more_influence);
+    sort(holders_.begin(), holders_.end(), [&more_influence](uint32_t a, uint32_t b) { return more_influence(b, a); });
+
+    size_t next_holder = 0;
+    for (uint32_t id : order_)
+    {
+        Entry& entry = views_[id];
+        uint32_t size = entry.desired_size;
+        uint32_t node = atlas_.Allocate(size);
+        while (node == ShadowAtlas::kInvalidNode)
+        {
+            if (next_holder < holders_.size() && views_[holders_[next_holder]].influence < entry.influence)
+            {
+                ReleaseTile(views_[holders_[next_holder++]]);
+            }
+            else if (size > settings_.min_tile_size)
+            {
+                size /= 2;
+            }
+            else
+            {
+                break;
+            }
+            node = atlas_.Allocate(size);
+        }
+        entry.node = node;
+    }
+}
+
+void ShadowScheduler::ReleaseTile(Entry& entry)
+{
+    atlas_.Free(entry.node);
+    entry.node = ShadowAtlas::kInvalidNode;
+    entry.rendered = false;
+    entry.static_valid = false;
+}
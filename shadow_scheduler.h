@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------------
+//  shadow_scheduler.h
+//  Decides, every frame, where in the ShadowAtlas each shadow view lives and
+//  which views are redrawn (CPU only).
+//  - A view is sized by its screen influence: the projected radius of its
+//    influence sphere, as in CullingSystem::ProjectedRadii.  Views outside
+//    the camera frustum keep their tile until a more influential view needs
+//    the space.
+//  - At most update_budget views are redrawn per frame, highest
+//    influence * (frames waited + 1) first, so small lights still update.
+//    Views waiting for a first draw go before all others.
+//  - Static casters are cached: the renderer keeps a second atlas with the
+//    static casters of every tile and redraws them only when the view moved
+//    or InvalidateStatic touched it.  Otherwise an update copies the cached
+//    tile and draws the dynamic casters alone, and a view with no dynamic
+//    casters is not redrawn at all.
+//  Shaders sample a tile with RenderedViewProj, the matrix it was drawn
+//  with, which lags ShadowView::view_proj while the view waits for an update.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "shadow_atlas.h"
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+struct ShadowSchedulerSettings
+{
+    uint32_t atlas_size = 8192;
+    uint32_t min_tile_size = 128;
+    uint32_t max_tile_size = 2048;
+    uint32_t update_budget = 4;         // views redrawn per frame
+    float    texels_per_pixel = 1.0f;   // tile size / projected diameter of the influence
+};
+
+struct ShadowView
+{
+    DirectX::XMFLOAT4X4 view_proj;      // of the shadow camera; any change redraws the static casters
+    DirectX::BoundingSphere influence;  // world space volume the view shadows (light range, cascade slice)
+    uint32_t fixed_size = 0;            // tile size, 0 : from the screen influence (cascades use a fixed size)
+    bool     dynamic_casters = false;   // dynamic casters overlap the view this frame
+};
+
+struct ShadowUpdate
+{
+    uint32_t   view;
+    ShadowTile tile;
+    bool       static_casters;          // redraw the static cache of the tile first
+};
+
+class ShadowScheduler
+{
+public:
+    explicit ShadowScheduler(const ShadowSchedulerSettings& settings = ShadowSchedulerSettings());
+
+    //--------------------------------------------------------------------------------
+    //  Ids are reused after RemoveView
+    //--------------------------------------------------------------------------------
+    uint32_t AddView(const ShadowView& view);
+    void RemoveView(uint32_t id);
+    void SetView(uint32_t id, const ShadowView& view);
+
+    //--------------------------------------------------------------------------------
+    //  A static caster inside world_bounds was added, moved or removed
+    //--------------------------------------------------------------------------------
+    void InvalidateStatic(const DirectX::BoundingBox& world_bounds);
+
+    //--------------------------------------------------------------------------------
+    //  planes           : camera frustum (CullingSystem::ExtractFrustumPlanes)
+    //  eye              : camera position
+    //  projection_scale : viewport height / (2 * tan(fov_y / 2))
+    //  updates          : receives the views to draw this frame
+    //--------------------------------------------------------------------------------
+    void Schedule(const DirectX::XMFLOAT4 planes[6], DirectX::FXMVECTOR eye, float projection_scale,
+        std::vector<ShadowUpdate>& updates);
+
+    //--------------------------------------------------------------------------------
+    //  Tile of a view, size 0 while it has no tile or was never drawn there
+    //--------------------------------------------------------------------------------
+    ShadowTile Tile(uint32_t id) const;
+    const DirectX::XMFLOAT4X4& RenderedViewProj(uint32_t id) const { return views_[id].rendered_view_proj; }
+    float Influence(uint32_t id) const { return views_[id].influence; }
+
+    const ShadowAtlas& Atlas() const { return atlas_; }
+    const ShadowSchedulerSettings& Settings() const { return settings_; }
+
+private:
+    struct Entry
+    {
+        ShadowView view;
+        DirectX::XMFLOAT4X4 rendered_view_proj;
+        uint32_t node = ShadowAtlas::kInvalidNode;
+        float    influence = 0.0f;  // pixels, 0 : outside the camera frustum
+        uint32_t desired_size = 0;
+        uint32_t age = 0;           // frames waited for an update
+        bool     active = false;
+        bool     rendered = false;  // the tile holds a drawing of the view
+        bool     static_valid = false;
+    };
+
+    uint32_t DesiredSize(const Entry& entry) const;
+    void AllocateTiles();
+    void ReleaseTile(Entry& entry);
+
+    ShadowSchedulerSettings settings_;
+    ShadowAtlas atlas_;
+    std::vector<Entry> views_;
+    std::vector<uint32_t> free_ids_;
+    std::vector<uint32_t> order_;   // scratch
+    std::vector<uint32_t> holders_; // scratch
+};
@@ -0,0 +1,503 @@
+//--------------------------------------------------------------------------------
+//  software_occlusion.cpp
+//--------------------------------------------------------------------------------
+#include "software_occlusion.h"
+#include "hi_z_pyramid.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SOFTWARE_OCCLUSION_SSE2 1
+#else
+#define SOFTWARE_OCCLUSION_SSE2 0
+#endif
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    // 4 bits of sub pixel precision.  With the guard band below and at most
+    // kMaxSize pixels, every edge function inside the screen fits in 31 bits.
+    constexpr int kSubPixelBits = 4;
+    constexpr float kSubPixelScale = static_cast<float>(1 << kSubPixelBits);
+
+    // Clip space x and y are kept within this multiple of w.
+    constexpr float kGuardBand = 1.5f;
+
+    struct ScreenVertex
+    {
+        int64_t x, y;       // fixed point pixels, y down
+        float z;
+    };
+
+    int64_t Edge(const ScreenVertex& a, const ScreenVertex& b, int64_t x, int64_t y)
+    {
+        return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    }
+
+    // With a positive area and y down, top edges run +x and left edges run -y.
+    bool IsTopLeft(const ScreenVertex& a, const ScreenVertex& b)
+    {
+        return (a.y == b.y && b.x > a.x) || b.y < a.y;
+    }
+
+    // Bit per plane the vertex is outside of: the frustum sides and far plane
+    // (trivial reject), then the near plane and the guard band (clipping).
+    enum OutCode : uint32_t
+    {
+        kOutLeft = 1 << 0,
+        kOutRight = 1 << 1,
+        kOutBottom = 1 << 2,
+        kOutTop = 1 << 3,
+        kOutFar = 1 << 4,
+        kOutNear = 1 << 5,
+        kOutGuardBand = 1 << 6,
+        kOutFrustum = kOutLeft | kOutRight | kOutBottom | kOutTop | kOutFar | kOutNear,
+        kOutClip = kOutNear | kOutGuardBand,
+    };
+
+    uint32_t ComputeOutCode(const XMFLOAT4& v)
+    {
+        uint32_t code = 0;
+        if (v.x < -v.w) code |= kOutLeft;
+        if (v.x > v.w) code |= kOutRight;
+        if (v.y < -v.w) code |= kOutBottom;
+        if (v.y > v.w) code |= kOutTop;
+        if (v.z > v.w) code |= kOutFar;
+        if (v.z < 0.0f) code |= kOutNear;
+        if (fabsf(v.x) > kGuardBand * v.w || fabsf(v.y) > kGuardBand * v.w) code |= kOutGuardBand;
+        return code;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void SoftwareOcclusion::Resize(uint32_t width, uint32_t height)
+{
+    assert(width > 0 && width <= kMaxSize);
+    assert(height > 0 && height <= kMaxSize);
+    width_ = width;
+    height_ = height;
+
+    // Rows are padded to 4 pixels so the SIMD loop never crosses into the next row.
+    pitch_ = (width + 3) & ~3u;
+    tiles_x_ = (pitch_ + kTileWidth - 1) / kTileWidth;
+    tiles_y_ = (height + kTileHeight - 1) / kTileHeight;
+    depth_.assign(static_cast<size_t>(pitch_) * height, 1.0f);
+}
+
+void SoftwareOcclusion::BeginFrame(FXMMATRIX view_proj)
+{
+    XMStoreFloat4x4(&view_proj_, view_proj);
+    occluders_.clear();
+    triangle_count_ = 0;
+}
+
+void SoftwareOcclusion::AddOccluder(const OccluderMesh& mesh, const XMFLOAT4X4& world)
+{
+    Occluder occluder;
+    occluder.mesh = mesh;
+    XMStoreFloat4x4(&occluder.world_view_proj, XMMatrixMultiply(XMLoadFloat4x4(&world), XMLoadFloat4x4(&view_proj_)));
+    occluder.first_triangle = triangle_count_;
+    occluders_.push_back(occluder);
+    triangle_count_ += mesh.index_count / 3;
+}
+
+void SoftwareOcclusion::Rasterize()
+{
+    assert(width_ > 0);
+    fill(depth_.begin(), depth_.end(), 1.0f);
+
+    chunk_count_ = (triangle_count_ + kTrianglesPerChunk - 1) / kTrianglesPerChunk;
+    if (chunks_.size() < chunk_count_) chunks_.resize(chunk_count_);
+
+    // Setup and binning write per chunk lists, so tiles can then be drawn
+    // without any synchronization.  Depth LESS keeps the nearest value, so
+    // the result does not depend on the order either.
+    const uint32_t tile_count = tiles_x_ * tiles_y_;
+    const bool parallel = JobSystem::IsCreated() && JobSystem::Instance().WorkerCount() > 1;
+    if (parallel)
+    {
+        JobSystem::Instance().ParallelFor(chunk_count_, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i) SetupChunk(static_cast<uint32_t>(i));
+        });
+        JobSystem::Instance().ParallelFor(tile_count, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i) RasterizeTile(static_cast<uint32_t>(i));
+        });
+    }
+    else
+    {
+        for (uint32_t i = 0; i < chunk_count_; ++i) SetupChunk(i);
+        for (uint32_t i = 0; i < tile_count; ++i) RasterizeTile(i);
+    }
+
+    rasterized_count_ = 0;
+    for (uint32_t i = 0; i < chunk_count_; ++i)
+    {
+        rasterized_count_ += static_cast<uint32_t>(chunks_[i].triangles.size());
+    }
+}
+
+bool SoftwareOcclusion::IsVisible(const BoundingBox& local_bounds, const XMFLOAT4X4& world) const
+{
+    // Project the local box with world * view_proj: tighter than its world space AABB.
+    XMFLOAT4X4 world_view_proj;
+    XMStoreFloat4x4(&world_view_proj, XMMatrixMultiply(XMLoadFloat4x4(&world), XMLoadFloat4x4(&view_proj_)));
+    HiZRect rect;
+    if (!HiZPyramid::ProjectBox(&world_view_proj.m[0][0], &local_bounds.Center.x, &local_bounds.Extents.x,
+        width_, height_, &rect))
+    {
+        return true;
+    }
+
+    // Visible as soon as one pixel of the rectangle is not nearer than the box.
+    for (uint32_t y = rect.min_y; y <= rect.max_y; ++y)
+    {
+        const float* row = depth_.data() + static_cast<size_t>(y) * pitch_;
+#if SOFTWARE_OCCLUSION_SSE2
+        const __m128i first = _mm_set1_epi32(static_cast<int>(rect.min_x) - 1);
+        const __m128i last = _mm_set1_epi32(static_cast<int>(rect.max_x) + 1);
+        const __m128 box_depth = _mm_set1_ps(rect.min_depth);
+        __m128i lane_x = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(rect.min_x & ~3u)), _mm_set_epi32(3, 2, 1, 0));
+        for (uint32_t x = rect.min_x & ~3u; x <= rect.max_x; x += 4)
+        {
+            const __m128 inside = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(lane_x, first), _mm_cmplt_epi32(lane_x, last)));
+            const __m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), box_depth);
+            if (_mm_movemask_ps(_mm_and_ps(inside, behind)) != 0) return true;
+            lane_x = _mm_add_epi32(lane_x, _mm_set1_epi32(4));
+        }
+#else
+        for (uint32_t x = rect.min_x; x <= rect.max_x; ++x)
+        {
+            if (row[x] >= rect.min_depth) return true;
+        }
+#endif
+    }
+    return false;
+}
+
+void SoftwareOcclusion::FilterVisible(const XMFLOAT4X4* worlds, const BoundingBox* local_bounds,
+    const uint32_t* candidates, size_t candidate_count, vector<uint32_t>& visible) const
+{
+    visible.clear();
+
+    const bool parallel = JobSystem::IsCreated();
+    const size_t worker_count = parallel ? JobSystem::Instance().WorkerCount() : 1;
+    const size_t max_chunks = max<size_t>(1, candidate_count / kMinBoxesPerWorker);
+    const size_t chunk_count = parallel ? min(worker_count, max_chunks) : 1;
+
+    if (chunk_count == 1)
+    {
+        FilterRange(worlds, local_bounds, candidates, 0, candidate_count, visible);
+        return;
+    }
+
+    // Each chunk keeps its own list; concatenating them in order keeps the
+    // candidates' order.
+    const size_t chunk = (candidate_count + chunk_count - 1) / chunk_count;
+    vector<vector<uint32_t>> chunk_visible(chunk_count);
+    JobSystem::Instance().ParallelFor(chunk_count,
+        [this, worlds, local_bounds, candidates, candidate_count, chunk, &chunk_visible](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            const size_t begin = min(candidate_count, chunk * i);
+            const size_t end = min(candidate_count, chunk * (i + 1));
+            FilterRange(worlds, local_bounds, candidates, begin, end, chunk_visible[i]);
+        }
+    });
+
+    size_t total = 0;
+    for (auto& list : chunk_visible) total += list.size();
+    visible.reserve(total);
+    for (auto& list : chunk_visible) visible.insert(visible.end(), list.begin(), list.end());
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Private
+//
+//--------------------------------------------------------------------------------
+void SoftwareOcclusion::SetupChunk(uint32_t chunk_index)
+{
+    Chunk& chunk = chunks_[chunk_index];
+    chunk.triangles.clear();
+    chunk.bins.resize(static_cast<size_t>(tiles_x_) * tiles_y_);
+    for (auto& bin : chunk.bins) bin.clear();
+
+    const uint32_t first = chunk_index * kTrianglesPerChunk;
+    const uint32_t last = min(first + kTrianglesPerChunk, triangle_count_);
+
+    // Last occluder that starts at or before the first triangle.
+    auto occluder = upper_bound(occluders_.begin(), occluders_.end(), first,
+        [](uint32_t triangle, const Occluder& o) { return triangle < o.first_triangle; }) - 1;
+    XMMATRIX world_view_proj = XMLoadFloat4x4(&occluder->world_view_proj);
+
+    for (uint32_t triangle = first; triangle < last; ++triangle)
+    {
+        if (occluder + 1 != occluders_.end() && (occluder + 1)->first_triangle <= triangle)
+        {
+            while (occluder + 1 != occluders_.end() && (occluder + 1)->first_triangle <= triangle) ++occluder;
+            world_view_proj = XMLoadFloat4x4(&occluder->world_view_proj);
+        }
+
+        const OccluderMesh& mesh = occluder->mesh;
+        const char* vertices = static_cast<const char*>(mesh.vertices);
+        const size_t first_index = mesh.start_index + static_cast<size_t>(triangle - occluder->first_triangle) * 3;
+
+        XMFLOAT4 clip[3];
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const size_t index = mesh.indices_32bit
+                ? static_cast<const uint32_t*>(mesh.indices)[first_index + corner]
+                : static_cast<const uint16_t*>(mesh.indices)[first_index + corner];
+            const XMFLOAT3* position = reinterpret_cast<const XMFLOAT3*>(
+                vertices + (static_cast<int64_t>(index) + mesh.base_vertex) * mesh.vertex_stride);
+            XMStoreFloat4(&clip[corner], XMVector3Transform(XMLoadFloat3(position), world_view_proj));
+        }
+        SetupClipped(clip, 3, chunk);
+    }
+}
+
+void SoftwareOcclusion::SetupClipped(const XMFLOAT4* vertices, uint32_t count, Chunk& chunk) const
+{
+    uint32_t all_out = ~0u;
+    uint32_t any_out = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t code = ComputeOutCode(vertices[i]);
+        all_out &= code;
+        any_out |= code;
+    }
+    if (all_out & kOutFrustum) return;
+    if ((any_out & kOutClip) == 0)
+    {
+        SetupTriangle(vertices[0], vertices[1], vertices[2], chunk);
+        return;
+    }
+
+    // Near plane z >= 0 and the guard band, as in DepthRasterizer.
+    const float planes[5][4] =
+    {
+        { 0.0f, 0.0f, 1.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f, kGuardBand },
+        { -1.0f, 0.0f, 0.0f, kGuardBand },
+        { 0.0f, 1.0f, 0.0f, kGuardBand },
+        { 0.0f, -1.0f, 0.0f, kGuardBand },
+    };
+
+    XMFLOAT4 buffers[2][3 + 5];
+    const XMFLOAT4* input = vertices;
+    uint32_t input_count = count;
+    for (int plane = 0; plane < 5 && input_count >= 3; ++plane)
+    {
+        const float* p = planes[plane];
+        auto distance = [p](const XMFLOAT4& v) { return p[0] * v.x + p[1] * v.y + p[2] * v.z + p[3] * v.w; };
+
+        XMFLOAT4* output = buffers[plane & 1];
+        uint32_t output_count = 0;
+        for (uint32_t i = 0; i < input_count; ++i)
+        {
+            const XMFLOAT4& a = input[i];
+            const XMFLOAT4& b = input[(i + 1) % input_count];
+            const float distance_a = distance(a);
+            const float distance_b = distance(b);
+            if (distance_a >= 0.0f) output[output_count++] = a;
+            if ((distance_a >= 0.0f) != (distance_b >= 0.0f))
+            {
+                const float t = distance_a / (distance_a - distance_b);
+                XMStoreFloat4(&output[output_count++], XMVectorLerp(XMLoadFloat4(&a), XMLoadFloat4(&b), t));
+            }
+        }
+        input = output;
+        input_count = output_count;
+    }
+
+    for (uint32_t i = 2; i < input_count; ++i)
+    {
+        SetupTriangle(input[0], input[i - 1], input[i], chunk);
+    }
+}
+
+void SoftwareOcclusion::SetupTriangle(const XMFLOAT4& v0, const XMFLOAT4& v1, const XMFLOAT4& v2, Chunk& chunk) const
+{
+    if (v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f) return;
+
+    // z / w is linear in screen space, so depth needs no perspective correction.
+    ScreenVertex s[3];
+    const XMFLOAT4* clip[3] = { &v0, &v1, &v2 };
+    for (int i = 0; i < 3; ++i)
+    {
+        const float inverse_w = 1.0f / clip[i]->w;
+        s[i].x = llroundf((clip[i]->x * inverse_w * 0.5f + 0.5f) * width_ * kSubPixelScale);
+        s[i].y = llroundf((0.5f - clip[i]->y * inverse_w * 0.5f) * height_ * kSubPixelScale);
+        s[i].z = clip[i]->z * inverse_w;
+    }
+
+    int64_t area = Edge(s[0], s[1], s[2].x, s[2].y);
+    if (area == 0) return;
+    if (area < 0)
+    {
+        swap(s[1], s[2]);
+        area = -area;
+    }
+
+    // Pixels whose centers may be inside.
+    const int64_t half = 1 << (kSubPixelBits - 1);
+    const int64_t min_x = min(min(s[0].x, s[1].x), s[2].x);
+    const int64_t max_x = max(max(s[0].x, s[1].x), s[2].x);
+    const int64_t min_y = min(min(s[0].y, s[1].y), s[2].y);
+    const int64_t max_y = max(max(s[0].y, s[1].y), s[2].y);
+    ScreenTriangle triangle;
+    triangle.x_begin = static_cast<int32_t>(max<int64_t>((min_x - half + (1 << kSubPixelBits) - 1) >> kSubPixelBits, 0));
+    triangle.x_end = static_cast<int32_t>(min<int64_t>(((max_x - half) >> kSubPixelBits) + 1, width_));
+    triangle.y_begin = static_cast<int32_t>(max<int64_t>((min_y - half + (1 << kSubPixelBits) - 1) >> kSubPixelBits, 0));
+    triangle.y_end = static_cast<int32_t>(min<int64_t>(((max_y - half) >> kSubPixelBits) + 1, height_));
+    if (triangle.x_begin >= triangle.x_end || triangle.y_begin >= triangle.y_end) return;
+
+    // Edge k is opposite vertex k.  Edges that own the pixels on them keep 0,
+    // the others need > 0, so -1 is folded into their start value.  The
+    // depth sum takes it out again; on thin triangles it would shift the
+    // depth by a sizable part of their z range.
+    triangle.z_bias = 0.0f;
+    for (int k = 0; k < 3; ++k)
+    {
+        const ScreenVertex& a = s[(k + 1) % 3];
+        const ScreenVertex& b = s[(k + 2) % 3];
+        const bool top_left = IsTopLeft(a, b);
+        const int64_t edge = Edge(a, b, half, half) + (top_left ? 0 : -1);
+        assert(edge >= INT32_MIN && edge <= INT32_MAX);
+        triangle.edge[k] = static_cast<int32_t>(edge);
+        triangle.step_x[k] = static_cast<int32_t>((a.y - b.y) * (1 << kSubPixelBits));
+        triangle.step_y[k] = static_cast<int32_t>((b.x - a.x) * (1 << kSubPixelBits));
+        triangle.z[k] = s[k].z;
+        if (!top_left) triangle.z_bias += s[k].z;
+    }
+    triangle.min_z = min(min(s[0].z, s[1].z), s[2].z);
+    triangle.max_z = max(max(s[0].z, s[1].z), s[2].z);
+    triangle.inverse_area = 1.0f / static_cast<float>(area);
+
+    const uint32_t index = static_cast<uint32_t>(chunk.triangles.size());
+    chunk.triangles.push_back(triangle);
+    for (int32_t tile_y = triangle.y_begin / kTileHeight; tile_y <= (triangle.y_end - 1) / static_cast<int32_t>(kTileHeight); ++tile_y)
+    {
+        for (int32_t tile_x = triangle.x_begin / kTileWidth; tile_x <= (triangle.x_end - 1) / static_cast<int32_t>(kTileWidth); ++tile_x)
+        {
+            chunk.bins[tile_y * tiles_x_ + tile_x].push_back(index);
+        }
+    }
+}
+
+void SoftwareOcclusion::RasterizeTile(uint32_t tile)
+{
+    const int32_t x0 = static_cast<int32_t>((tile % tiles_x_) * kTileWidth);
+    const int32_t y0 = static_cast<int32_t>((tile / tiles_x_) * kTileHeight);
+    const int32_t x1 = min<int32_t>(x0 + kTileWidth, pitch_);
+    const int32_t y1 = min<int32_t>(y0 + kTileHeight, height_);
+    for (uint32_t i = 0; i < chunk_count_; ++i)
+    {
+        const Chunk& chunk = chunks_[i];
+        for (uint32_t index : chunk.bins[tile])
+        {
+            RasterizeTriangle(chunk.triangles[index], x0, y0, x1, y1);
+        }
+    }
+}
+
+void SoftwareOcclusion::RasterizeTriangle(const ScreenTriangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+    // Whole groups of 4 pixels; tiles start and end on a group, so the
+    // extra lanes stay in this tile and fail the edge test.
+    const int32_t x_begin = max(triangle.x_begin, x0) & ~3;
+    const int32_t x_end = min(triangle.x_end, x1);
+    const int32_t y_begin = max(triangle.y_begin, y0);
+    const int32_t y_end = min(triangle.y_end, y1);
+
+#if SOFTWARE_OCCLUSION_SSE2
+    __m128i step[3];
+    __m128i lane_offset[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        step[k] = _mm_set1_epi32(triangle.step_x[k] * 4);
+        lane_offset[k] = _mm_set_epi32(triangle.step_x[k] * 3, triangle.step_x[k] * 2, triangle.step_x[k], 0);
+    }
+    const __m128 z0 = _mm_set1_ps(triangle.z[0]);
+    const __m128 z1 = _mm_set1_ps(triangle.z[1]);
+    const __m128 z2 = _mm_set1_ps(triangle.z[2]);
+    const __m128 z_bias = _mm_set1_ps(triangle.z_bias);
+    const __m128 min_z = _mm_set1_ps(triangle.min_z);
+    const __m128 max_z = _mm_set1_ps(triangle.max_z);
+    const __m128 inverse_area = _mm_set1_ps(triangle.inverse_area);
+    const __m128 far_depth = _mm_set1_ps(1.0f);
+    const __m128i minus_one = _mm_set1_epi32(-1);
+#endif
+
+    for (int32_t y = y_begin; y < y_end; ++y)
+    {
+        // Each partial sum is the edge function of a pixel on screen, so none overflows.
+        int32_t edge[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            edge[k] = triangle.edge[k] + x_begin * triangle.step_x[k] + y * triangle.step_y[k];
+        }
+        float* row = depth_.data() + static_cast<size_t>(y) * pitch_;
+
+#if SOFTWARE_OCCLUSION_SSE2
+        __m128i w0 = _mm_add_epi32(_mm_set1_epi32(edge[0]), lane_offset[0]);
+        __m128i w1 = _mm_add_epi32(_mm_set1_epi32(edge[1]), lane_offset[1]);
+        __m128i w2 = _mm_add_epi32(_mm_set1_epi32(edge[2]), lane_offset[2]);
+        for (int32_t x = x_begin; x < x_end; x += 4)
+        {
+            // Inside when no edge function is negative.
+            const __m128i inside = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(w0, w1), w2), minus_one);
+            if (_mm_movemask_ps(_mm_castsi128_ps(inside)) != 0)
+            {
+                __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(w0), z0), z_bias);
+                depth = _mm_add_ps(depth, _mm_mul_ps(_mm_cvtepi32_ps(w1), z1));
+                depth = _mm_add_ps(depth, _mm_mul_ps(_mm_cvtepi32_ps(w2), z2));
+                depth = _mm_min_ps(_mm_max_ps(_mm_mul_ps(depth, inverse_area), min_z), max_z);
+
+                const __m128 previous = _mm_loadu_ps(row + x);
+                const __m128 write = _mm_and_ps(_mm_castsi128_ps(inside), _mm_cmple_ps(depth, far_depth));
+                const __m128 nearest = _mm_min_ps(previous, depth);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(write, nearest), _mm_andnot_ps(write, previous)));
+            }
+            w0 = _mm_add_epi32(w0, step[0]);
+            w1 = _mm_add_epi32(w1, step[1]);
+            w2 = _mm_add_epi32(w2, step[2]);
+        }
+#else
+        for (int32_t x = x_begin; x < x_end; ++x)
+        {
+            if ((edge[0] | edge[1] | edge[2]) >= 0)
+            {
+                float depth = (edge[0] * triangle.z[0] + edge[1] * triangle.z[1] + edge[2] * triangle.z[2] + triangle.z_bias)
+                    * triangle.inverse_area;
+                depth = min(max(depth, triangle.min_z), triangle.max_z);
+                if (depth < row[x] && depth <= 1.0f) row[x] = depth;
+            }
+            for (int k = 0; k < 3; ++k) edge[k] += triangle.step_x[k];
+        }
+#endif
+    }
+}
+
+void SoftwareOcclusion::FilterRange(const XMFLOAT4X4* worlds, const BoundingBox* local_bounds,
+    const uint32_t* candidates, size_t begin, size_t end, vector<uint32_t>& visible) const
+{
+    visible.reserve(visible.size() + (end - begin));
+    for (size_t i = begin; i < end; ++i)
+    {
+        const uint32_t index = candidates[i];
+        if (IsVisible(local_bounds[index], worlds[index])) visible.push_back(index);
+    }
+}
@@ -0,0 +1,139 @@
+//--------------------------------------------------------------------------------
+//  software_occlusion.h
+//  Occlusion culling on the CPU, for GPUs without spare compute and for
+//  builds without D3D12: a few occluder meshes are rasterized into a low
+//  resolution depth buffer and SubmeshGeometry::Bounds are tested against it
+//  before anything is submitted.
+//  - Triangles are transformed, clipped and binned into screen tiles in
+//    chunks, then every tile is rasterized by one job (JobSystem).
+//  - Rows are rasterized 4 pixels at a time (SSE2, scalar elsewhere) with
+//    integer edge functions: 4 bit sub pixel snapping, pixel centers at
+//    +0.5, top-left fill rule, depth test LESS, both faces.
+//  DepthRasterizer is the scalar reference of the same rules.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//--------------------------------------------------------------------------------
+//  Triangles of an occluder, read from the CPU copies of a MeshGeometry
+//--------------------------------------------------------------------------------
+struct OccluderMesh
+{
+    const void* vertices = nullptr;     // MeshGeometry::VertexBufferCPU, float3 position first
+    uint32_t    vertex_stride = 0;      // MeshGeometry::VertexByteStride
+    const void* indices = nullptr;      // MeshGeometry::IndexBufferCPU
+    bool        indices_32bit = false;  // MeshGeometry::IndexFormat is DXGI_FORMAT_R32_UINT
+    uint32_t    index_count = 0;        // SubmeshGeometry::IndexCount
+    uint32_t    start_index = 0;        // SubmeshGeometry::StartIndexLocation
+    int32_t     base_vertex = 0;        // SubmeshGeometry::BaseVertexLocation
+};
+
+class SoftwareOcclusion
+{
+public:
+    static constexpr uint32_t kMaxSize = 1024;          // keeps the edge functions in 32 bits
+    static constexpr uint32_t kTileWidth = 32;          // multiple of 4
+    static constexpr uint32_t kTileHeight = 16;
+    static constexpr uint32_t kTrianglesPerChunk = 256;
+    static constexpr size_t   kMinBoxesPerWorker = 1024;
+
+    //--------------------------------------------------------------------------------
+    //  Depth buffer size in pixels, at most kMaxSize per axis
+    //--------------------------------------------------------------------------------
+    void Resize(uint32_t width, uint32_t height);
+
+    //--------------------------------------------------------------------------------
+    //  Forget the occluders of the previous frame
+    //--------------------------------------------------------------------------------
+    void BeginFrame(DirectX::FXMMATRIX view_proj);
+
+    //--------------------------------------------------------------------------------
+    //  The mesh memory must stay valid until Rasterize returns
+    //--------------------------------------------------------------------------------
+    void AddOccluder(const OccluderMesh& mesh, const DirectX::XMFLOAT4X4& world);
+
+    //--------------------------------------------------------------------------------
+    //  Clear and draw every occluder.  Runs on the JobSystem when it has been
+    //  created.
+    //--------------------------------------------------------------------------------
+    void Rasterize();
+
+    //--------------------------------------------------------------------------------
+    //  False when the box (SubmeshGeometry::Bounds placed by world) is behind
+    //  the occluders everywhere on screen.  Boxes that cross the near plane
+    //  or leave the screen are visible; the frustum test handles them.
+    //--------------------------------------------------------------------------------
+    bool IsVisible(const DirectX::BoundingBox& local_bounds, const DirectX::XMFLOAT4X4& world) const;
+
+    //--------------------------------------------------------------------------------
+    //  Keep the candidates (e.g. the output of CullingSystem::Cull) that are
+    //  visible, in order.  worlds and local_bounds are indexed by the values
+    //  of candidates.
+    //--------------------------------------------------------------------------------
+    void FilterVisible(const DirectX::XMFLOAT4X4* worlds, const DirectX::BoundingBox* local_bounds,
+        const uint32_t* candidates, size_t candidate_count, std::vector<uint32_t>& visible) const;
+
+    uint32_t Width() const { return width_; }
+    uint32_t Height() const { return height_; }
+    uint32_t Pitch() const { return pitch_; }                   // floats per row
+    const float* Depth() const { return depth_.data(); }
+
+    //--------------------------------------------------------------------------------
+    //  Triangles of the last Rasterize: submitted, and left after clipping
+    //--------------------------------------------------------------------------------
+    uint32_t TriangleCount() const { return triangle_count_; }
+    uint32_t RasterizedTriangleCount() const { return rasterized_count_; }
+
+private:
+    struct Occluder
+    {
+        OccluderMesh mesh;
+        DirectX::XMFLOAT4X4 world_view_proj;
+        uint32_t first_triangle;
+    };
+
+    struct ScreenTriangle
+    {
+        int32_t edge[3];            // edge function of each vertex at the center of pixel (0, 0), fill rule applied
+        int32_t step_x[3];          // per pixel
+        int32_t step_y[3];
+        float   z[3];
+        float   z_bias;             // adds back the fill rule's -1 in the depth sum
+        float   min_z, max_z;
+        float   inverse_area;
+        int32_t x_begin, x_end;     // pixels whose centers may be inside
+        int32_t y_begin, y_end;
+    };
+
+    struct Chunk
+    {
+        std::vector<ScreenTriangle> triangles;
+        std::vector<std::vector<uint32_t>> bins;    // triangles per tile
+    };
+
+    void SetupChunk(uint32_t chunk_index);
+    void SetupClipped(const DirectX::XMFLOAT4* vertices, uint32_t count, Chunk& chunk) const;
+    void SetupTriangle(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2, Chunk& chunk) const;
+    void RasterizeTile(uint32_t tile);
+    void RasterizeTriangle(const ScreenTriangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+    void FilterRange(const DirectX::XMFLOAT4X4* worlds, const DirectX::BoundingBox* local_bounds,
+        const uint32_t* candidates, size_t begin, size_t end, std::vector<uint32_t>& visible) const;
+
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t pitch_ = 0;
+    uint32_t tiles_x_ = 0;
+    uint32_t tiles_y_ = 0;
+    std::vector<float> depth_;
+
+    DirectX::XMFLOAT4X4 view_proj_;
+    std::vector<Occluder> occluders_;
+    std::vector<Chunk> chunks_;
+    uint32_t chunk_count_ = 0;
+    uint32_t triangle_count_ = 0;
+    uint32_t rasterized_count_ = 0;
+};
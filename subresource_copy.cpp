@@ -0,0 +1,132 @@
+//--------------------------------------------------------------------------------
+//  subresource_copy.cpp
+//--------------------------------------------------------------------------------
+#include "subresource_copy.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SUBRESOURCE_COPY_SSE2 1
+#else
+#define SUBRESOURCE_COPY_SSE2 0
+#endif
+
+using namespace std;
+
+namespace
+{
+    // Below this a plain memcpy is cheaper than aligning for streaming stores.
+    constexpr size_t kStreamMinBytes = 256;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void SubresourceCopier::Copy(const SubresourceCopy* copies, uint32_t count)
+{
+    const bool parallel = JobSystem::IsCreated() && JobSystem::Instance().WorkerCount() > 1;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const SubresourceCopy& copy = copies[i];
+        const size_t rows = static_cast<size_t>(copy.row_count) * copy.slice_count;
+        if (!parallel || rows * copy.row_bytes < kParallelMinBytes)
+        {
+            CopyRows(copy, 0, rows);
+            continue;
+        }
+
+        // Mip 0 usually dominates, so the split is per subresource, by rows.
+        const size_t rows_per_job = max<size_t>(1, kMinBytesPerJob / max<size_t>(copy.row_bytes, 1));
+        JobSystem::Instance().ParallelFor(rows, [&copy](size_t begin, size_t end)
+        {
+            CopyRows(copy, begin, end);
+            StreamFence();
+        }, rows_per_job);
+    }
+    StreamFence();
+}
+
+void SubresourceCopier::CopyRows(const SubresourceCopy& copy, size_t begin, size_t end)
+{
+    // Tightly packed on both sides: one contiguous run per slice.
+    const bool packed_rows = copy.destination_row_pitch == copy.row_bytes && copy.source_row_pitch == copy.row_bytes;
+
+    size_t row = begin;
+    while (row < end)
+    {
+        const size_t slice = row / copy.row_count;
+        const size_t row_in_slice = row % copy.row_count;
+        const size_t slice_end = min(end, (slice + 1) * static_cast<size_t>(copy.row_count));
+
+        uint8_t* destination = static_cast<uint8_t*>(copy.destination)
+            + slice * copy.destination_slice_pitch + row_in_slice * copy.destination_row_pitch;
+        const uint8_t* source = static_cast<const uint8_t*>(copy.source)
+            + slice * copy.source_slice_pitch + row_in_slice * copy.source_row_pitch;
+
+        if (packed_rows)
+        {
+            StreamCopy(destination, source, (slice_end - row) * copy.row_bytes);
+        }
+        else
+        {
+            for (size_t i = row; i < slice_end; ++i)
+            {
+                StreamCopy(destination, source, copy.row_bytes);
+                destination += copy.destination_row_pitch;
+                source += copy.source_row_pitch;
+            }
+        }
+        row = slice_end;
+    }
+}
+
+void SubresourceCopier::StreamCopy(void* destination, const void* source, size_t size)
+{
+#if SUBRESOURCE_COPY_SSE2
+    if (size < kStreamMinBytes)
+    {
+        memcpy(destination, source, size);
+        return;
+    }
+
+    uint8_t* dst = static_cast<uint8_t*>(destination);
+    const uint8_t* src = static_cast<const uint8_t*>(source);
+
+    // Align the destination to 16 bytes; the source may stay unaligned.
+    const size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+
+    for (; size >= 64; size -= 64, dst += 64, src += 64)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+    }
+    for (; size >= 16; size -= 16, dst += 16, src += 16)
+    {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+    }
+    memcpy(dst, src, size);
+#else
+    memcpy(destination, source, size);
+#endif
+}
+
+void SubresourceCopier::StreamFence()
+{
+#if SUBRESOURCE_COPY_SSE2
+    _mm_sfence();
+#endif
+}
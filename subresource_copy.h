@@ -0,0 +1,58 @@
+//--------------------------------------------------------------------------------
+//  subresource_copy.h
+//  Row copies from CPU memory into mapped upload memory (portable C++17, no
+//  platform headers).  Replaces the single threaded, memcpy per row loop
+//  of d3dx12's MemcpySubresource:
+//  - rows are written with non-temporal stores (SSE2) so write-combined
+//    upload memory is filled in whole lines and the cache is not polluted
+//  - large subresources are split across the JobSystem by rows
+//  Nothing is allocated.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//--------------------------------------------------------------------------------
+//  One subresource: slice_count slices of row_count rows of row_bytes
+//--------------------------------------------------------------------------------
+struct SubresourceCopy
+{
+    void*       destination = nullptr;
+    size_t      destination_row_pitch = 0;
+    size_t      destination_slice_pitch = 0;
+    const void* source = nullptr;
+    size_t      source_row_pitch = 0;
+    size_t      source_slice_pitch = 0;
+    size_t      row_bytes = 0;
+    uint32_t    row_count = 0;
+    uint32_t    slice_count = 1;
+};
+
+class SubresourceCopier
+{
+public:
+    // Subresources smaller than this are copied on the calling thread.
+    static constexpr size_t kParallelMinBytes = 256 * 1024;
+
+    // Smallest share of a subresource given to one job.
+    static constexpr size_t kMinBytesPerJob = 64 * 1024;
+
+    //--------------------------------------------------------------------------------
+    //  Copy every subresource.  Uses the JobSystem when it exists and waits
+    //  for it; the stores are fenced before returning.
+    //--------------------------------------------------------------------------------
+    static void Copy(const SubresourceCopy* copies, uint32_t count);
+
+    //--------------------------------------------------------------------------------
+    //  Rows [begin, end) of copy, numbered across slices
+    //  (slice * row_count + row).  Does not fence.
+    //--------------------------------------------------------------------------------
+    static void CopyRows(const SubresourceCopy& copy, size_t begin, size_t end);
+
+    //--------------------------------------------------------------------------------
+    //  memcpy with non-temporal stores for the aligned middle part.  Call
+    //  StreamFence before another thread (or the GPU) reads the data.
+    //--------------------------------------------------------------------------------
+    static void StreamCopy(void* destination, const void* source, size_t size);
+    static void StreamFence();
+};
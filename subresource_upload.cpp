@@ -0,0 +1,135 @@
+//--------------------------------------------------------------------------------
+//  subresource_upload.cpp
+//--------------------------------------------------------------------------------
+#include "subresource_upload.h"
+#include "frame_allocator.h"
+#include "subresource_copy.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+namespace
+{
+    struct Footprints
+    {
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts;
+        UINT* row_counts;
+        UINT64* row_sizes;
+        SubresourceCopy* copies;
+    };
+
+    UINT64 Upload(
+        ID3D12GraphicsCommandList* command_list,
+        ID3D12Resource* destination,
+        ID3D12Resource* intermediate,
+        UINT64 intermediate_offset,
+        UINT first_subresource,
+        UINT subresource_count,
+        const D3D12_SUBRESOURCE_DATA* source,
+        const Footprints& footprints)
+    {
+        const D3D12_RESOURCE_DESC destination_desc = destination->GetDesc();
+        const D3D12_RESOURCE_DESC intermediate_desc = intermediate->GetDesc();
+
+        ComPtr<ID3D12Device> device;
+        destination->GetDevice(IID_PPV_ARGS(device.GetAddressOf()));
+        UINT64 required_size = 0;
+        device->GetCopyableFootprints(&destination_desc, first_subresource, subresource_count, intermediate_offset,
+            footprints.layouts, footprints.row_counts, footprints.row_sizes, &required_size);
+
+        // Same validation as UpdateSubresources.
+        if (intermediate_desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER
+            || intermediate_desc.Width < required_size + footprints.layouts[0].Offset
+            || required_size > static_cast<UINT64>(SIZE_MAX)
+            || (destination_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER
+                && (first_subresource != 0 || subresource_count != 1)))
+        {
+            return 0;
+        }
+
+        BYTE* mapped = nullptr;
+        if (FAILED(intermediate->Map(0, nullptr, reinterpret_cast<void**>(&mapped)))) return 0;
+
+        for (UINT i = 0; i < subresource_count; ++i)
+        {
+            const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = footprints.layouts[i];
+            SubresourceCopy& copy = footprints.copies[i];
+            copy.destination = mapped + layout.Offset;
+            copy.destination_row_pitch = layout.Footprint.RowPitch;
+            copy.destination_slice_pitch = static_cast<size_t>(layout.Footprint.RowPitch) * footprints.row_counts[i];
+            copy.source = source[i].pData;
+            copy.source_row_pitch = static_cast<size_t>(source[i].RowPitch);
+            copy.source_slice_pitch = static_cast<size_t>(source[i].SlicePitch);
+            copy.row_bytes = static_cast<size_t>(footprints.row_sizes[i]);
+            copy.row_count = footprints.row_counts[i];
+            copy.slice_count = layout.Footprint.Depth;
+        }
+        SubresourceCopier::Copy(footprints.copies, subresource_count);
+        intermediate->Unmap(0, nullptr);
+
+        if (destination_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            command_list->CopyBufferRegion(
+                destination, 0, intermediate, footprints.layouts[0].Offset, footprints.layouts[0].Footprint.Width);
+        }
+        else
+        {
+            for (UINT i = 0; i < subresource_count; ++i)
+            {
+                CD3DX12_TEXTURE_COPY_LOCATION destination_location(destination, i + first_subresource);
+                CD3DX12_TEXTURE_COPY_LOCATION source_location(intermediate, footprints.layouts[i]);
+                command_list->CopyTextureRegion(&destination_location, 0, 0, 0, &source_location, nullptr);
+            }
+        }
+        return required_size;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+UINT64 UploadSubresources(
+    ID3D12GraphicsCommandList* command_list,
+    ID3D12Resource* destination,
+    ID3D12Resource* intermediate,
+    UINT64 intermediate_offset,
+    UINT first_subresource,
+    UINT subresource_count,
+    const D3D12_SUBRESOURCE_DATA* source,
+    LinearArena* scratch)
+{
+    if (subresource_count == 0) return 0;
+
+    if (!scratch && FrameAllocator::IsCreated() && FrameAllocator::Instance().HasArenas())
+    {
+        scratch = &FrameAllocator::Instance().Scratch();
+    }
+
+    Footprints footprints;
+    if (scratch)
+    {
+        footprints.layouts = scratch->AllocateArray<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>(subresource_count);
+        footprints.row_counts = scratch->AllocateArray<UINT>(subresource_count);
+        footprints.row_sizes = scratch->AllocateArray<UINT64>(subresource_count);
+        footprints.copies = scratch->AllocateArray<SubresourceCopy>(subresource_count);
+        return Upload(command_list, destination, intermediate, intermediate_offset,
+            first_subresource, subresource_count, source, footprints);
+    }
+
+    if (subresource_count > kUploadStackSubresources)
+    {
+        // No arena on this thread: the heap allocating d3dx12 version.
+        return UpdateSubresources(command_list, destination, intermediate, intermediate_offset,
+            first_subresource, subresource_count, const_cast<D3D12_SUBRESOURCE_DATA*>(source));
+    }
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[kUploadStackSubresources];
+    UINT row_counts[kUploadStackSubresources];
+    UINT64 row_sizes[kUploadStackSubresources];
+    SubresourceCopy copies[kUploadStackSubresources];
+    footprints = { layouts, row_counts, row_sizes, copies };
+    return Upload(command_list, destination, intermediate, intermediate_offset,
+        first_subresource, subresource_count, source, footprints);
+}
@@ -0,0 +1,32 @@
+//--------------------------------------------------------------------------------
+//  subresource_upload.h
+//  Allocation free replacement for d3dx12's UpdateSubresources: footprints
+//  live in a LinearArena (the caller's, or the calling worker's frame
+//  scratch), and the rows are copied by SubresourceCopier (streaming
+//  stores, split across the JobSystem).
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+
+class LinearArena;
+
+//--------------------------------------------------------------------------------
+//  Same contract as UpdateSubresources: copies source into intermediate at
+//  intermediate_offset and records the copies into destination.  Returns
+//  the number of bytes used in intermediate, 0 on failure.
+//  scratch : where the footprints go.  nullptr uses FrameAllocator scratch
+//            on JobSystem workers, and a stack array otherwise (up to
+//            kUploadStackSubresources subresources, beyond that the heap
+//            allocating UpdateSubresources).
+//--------------------------------------------------------------------------------
+constexpr UINT kUploadStackSubresources = 16;
+
+UINT64 UploadSubresources(
+    ID3D12GraphicsCommandList* command_list,
+    ID3D12Resource* destination,
+    ID3D12Resource* intermediate,
+    UINT64 intermediate_offset,
+    UINT first_subresource,
+    UINT subresource_count,
+    const D3D12_SUBRESOURCE_DATA* source,
+    LinearArena* scratch = nullptr);
@@ -0,0 +1,208 @@
+//--------------------------------------------------------------------------------
+//  bindless_handle_table_test.cpp
+//  BindlessHandleTable: stale generations are rejected, released slots wait
+//  in the retire queue for their fence, and under contention (ABA on the free
+//  stack, racing releases) no slot is ever owned twice or reused before its
+//  fence.  Run it in the SANITIZER=thread build as well.
+//--------------------------------------------------------------------------------
+#include "bindless_handle_table.h"
+#include "test_util.h"
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    void TestAllocate()
+    {
+        BindlessHandleTable table(4);
+        vector<BindlessHandle> handles;
+        for (uint32_t i = 0; i < 4; ++i) handles.push_back(table.Allocate());
+        CHECK(table.Allocate().IsNull());
+        for (uint32_t i = 0; i < 4; ++i) CHECK(handles[i].Index() == i && handles[i].Generation() == 0 && table.IsValid(handles[i]));
+
+        CHECK(!table.IsValid(BindlessHandle()));
+        CHECK(!table.Release(BindlessHandle(), 0));
+        BindlessHandle out_of_range;
+        out_of_range.value = 7;
+        CHECK(!table.IsValid(out_of_range) && !table.Release(out_of_range, 0));
+    }
+
+    void TestStaleGeneration()
+    {
+        BindlessHandleTable table(2);
+        const BindlessHandle first = table.Allocate();
+        CHECK(table.Release(first, 0));
+        CHECK(!table.IsValid(first));
+        CHECK(!table.Release(first, 0));        // double release
+        CHECK(table.PendingCount() == 0 && table.Recycle(0) == 1 && table.PendingCount() == 0);
+
+        // The slot comes back with the next generation; the old handle can
+        // neither see nor release it.
+        const BindlessHandle second = table.Allocate();
+        CHECK(second.Index() == first.Index() && second.Generation() == first.Generation() + 1);
+        CHECK(!table.IsValid(first) && table.IsValid(second));
+        CHECK(!table.Release(first, 0));
+        CHECK(table.IsValid(second));
+
+        // Documented limit: the generation wraps after kGenerationMask + 1 reuses.
+        BindlessHandle handle = second;
+        for (uint32_t i = 1; i <= BindlessHandle::kGenerationMask; ++i)
+        {
+            CHECK(table.Release(handle, 0) && table.Recycle(0) == 1);
+            handle = table.Allocate();
+        }
+        CHECK(handle.Generation() == first.Generation() && handle == first);
+    }
+
+    void TestRetireQueue()
+    {
+        // Every slot released at once, with fences 0 .. capacity - 1, from
+        // several threads: the queue holds them all.
+        constexpr uint32_t kCapacity = 1000;
+        constexpr uint32_t kThreadCount = 4;
+        BindlessHandleTable table(kCapacity);
+        vector<BindlessHandle> handles;
+        for (uint32_t i = 0; i < kCapacity; ++i) handles.push_back(table.Allocate());
+
+        vector<thread> threads;
+        for (uint32_t t = 0; t < kThreadCount; ++t)
+        {
+            threads.emplace_back([&table, &handles, t]
+            {
+                for (uint32_t i = t; i < kCapacity; i += kThreadCount) CHECK(table.Release(handles[i], i));
+            });
+        }
+        for (thread& released : threads) released.join();
+        CHECK(table.Allocate().IsNull());
+
+        // Only slots whose fence has completed come back.
+        CHECK(table.Recycle(kCapacity / 2 - 1) == kCapacity / 2);
+        CHECK(table.PendingCount() == kCapacity / 2);
+        uint32_t allocated = 0;
+        bool early_fence = false;
+        for (BindlessHandle handle = table.Allocate(); !handle.IsNull(); handle = table.Allocate())
+        {
+            early_fence = early_fence || handle.Index() >= kCapacity / 2;
+            ++allocated;
+        }
+        CHECK(allocated == kCapacity / 2 && !early_fence);
+
+        CHECK(table.Recycle(kCapacity / 2 - 1) == 0);
+        CHECK(table.Recycle(kCapacity) == kCapacity / 2 && table.PendingCount() == 0);
+        CHECK(!table.Allocate().IsNull());
+    }
+
+    void TestRacingRelease()
+    {
+        // Several threads release the same handle: exactly one wins.
+        constexpr uint32_t kRounds = 2000;
+        constexpr uint32_t kThreadCount = 4;
+        BindlessHandleTable table(1);
+        atomic<uint32_t> wins(0);
+        for (uint32_t round = 0; round < kRounds; ++round)
+        {
+            const BindlessHandle handle = table.Allocate();
+            vector<thread> threads;
+            for (uint32_t t = 0; t < kThreadCount; ++t)
+            {
+                threads.emplace_back([&table, &wins, handle, round]
+                {
+                    if (table.Release(handle, round)) wins.fetch_add(1, memory_order_relaxed);
+                });
+            }
+            for (thread& released : threads) released.join();
+            table.Recycle(round);
+        }
+        CHECK(wins.load() == kRounds);
+    }
+
+    void TestContention()
+    {
+        // Few slots and many loaders: slots are popped, released and pushed
+        // back constantly, the pattern that breaks an untagged free stack.
+        // The render thread advances the frame and recycles with the fence
+        // two frames back, as the GPU would complete it.
+        constexpr uint32_t kCapacity = 8;
+        constexpr uint32_t kLoaderCount = 4;
+        constexpr uint32_t kAllocationsPerLoader = 100000;
+        BindlessHandleTable table(kCapacity);
+        atomic<uint32_t> owners[kCapacity];
+        atomic<uint64_t> release_fences[kCapacity];
+        for (uint32_t i = 0; i < kCapacity; ++i)
+        {
+            owners[i].store(0, memory_order_relaxed);
+            release_fences[i].store(0, memory_order_relaxed);
+        }
+        atomic<uint64_t> frame(2);
+        atomic<uint64_t> completed_fence(0);
+        atomic<uint32_t> loaders_done(0);
+        atomic<bool> owned_twice(false);
+        atomic<bool> reused_early(false);
+        atomic<bool> stale_accepted(false);
+
+        vector<thread> loaders;
+        for (uint32_t loader = 0; loader < kLoaderCount; ++loader)
+        {
+            loaders.emplace_back([&, loader]
+            {
+                // Released one allocation ago: far fewer than 4096 reuses of
+                // its slot since, so its generation cannot have wrapped.
+                BindlessHandle previous;
+                uint32_t allocations = 0;
+                while (allocations < kAllocationsPerLoader)
+                {
+                    const BindlessHandle handle = table.Allocate();
+                    if (handle.IsNull())
+                    {
+                        this_thread::yield();
+                        continue;
+                    }
+                    ++allocations;
+                    const uint32_t index = handle.Index();
+                    if (owners[index].exchange(loader + 1, memory_order_acq_rel) != 0) owned_twice = true;
+                    if (release_fences[index].load(memory_order_relaxed) > completed_fence.load(memory_order_acquire)) reused_early = true;
+                    if (!previous.IsNull() && table.Release(previous, 0)) stale_accepted = true;
+                    previous = handle;
+
+                    const uint64_t fence = frame.load(memory_order_relaxed);
+                    release_fences[index].store(fence, memory_order_relaxed);
+                    owners[index].store(0, memory_order_release);
+                    if (!table.Release(handle, fence)) stale_accepted = true;
+                }
+                loaders_done.fetch_add(1, memory_order_release);
+            });
+        }
+
+        while (loaders_done.load(memory_order_acquire) < kLoaderCount)
+        {
+            const uint64_t current = frame.fetch_add(1, memory_order_relaxed) + 1;
+            completed_fence.store(current - 2, memory_order_release);
+            table.Recycle(current - 2);
+            this_thread::yield();
+        }
+        for (thread& loader : loaders) loader.join();
+
+        CHECK(!owned_twice);
+        CHECK(!reused_early);
+        CHECK(!stale_accepted);
+
+        // Every slot is accounted for once the last fences complete.
+        table.Recycle(~0ull);
+        CHECK(table.PendingCount() == 0);
+        uint32_t allocated = 0;
+        while (!table.Allocate().IsNull()) ++allocated;
+        CHECK(allocated == kCapacity);
+    }
+}
+
+int main()
+{
+    TestAllocate();
+    TestStaleGeneration();
+    TestRetireQueue();
+    TestRacingRelease();
+    TestContention();
+    return test::Result();
+}
@@ -0,0 +1,87 @@
+//--------------------------------------------------------------------------------
+//  bounding_volume_hierarchy_benchmark.cpp
+//  Build, refit and query times of BoundingVolumeHierarchy over 100k objects,
+//  with the linear scan of the pending objects as the baseline.
+//--------------------------------------------------------------------------------
+#include "bounding_volume_hierarchy.h"
+#include "culling_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr int kObjectCount = 100000;
+    constexpr int kQueryCount = 1000;
+    constexpr int kRepeat = 10;
+
+    void Report(const char* name, double ms, size_t checksum)
+    {
+        printf("%-28s %9.3f ms   (checksum %zu)\n", name, ms, checksum);
+    }
+
+    // One frustum query, kQueryCount overlap queries and kQueryCount rays.
+    void RunQueries(const BoundingVolumeHierarchy& bvh, const XMFLOAT4 planes[6], size_t& checksum)
+    {
+        RandomGenerator random(2);
+        vector<uint32_t> result;
+        bvh.QueryFrustum(planes, result);
+        for (int i = 0; i < kQueryCount; ++i)
+        {
+            bvh.QueryOverlap(BoundingBox(XMFLOAT3(random.NextFloat(-500.0f, 500.0f), 0.0f, random.NextFloat(-500.0f, 500.0f)), XMFLOAT3(10.0f, 10.0f, 10.0f)), result);
+            const XMVECTOR direction = XMVector3Normalize(XMVectorSet(random.NextFloat(-1.0f, 1.0f), 0.01f, random.NextFloat(-1.0f, 1.0f), 0.0f));
+            checksum += bvh.RayCast(XMVectorSet(random.NextFloat(-500.0f, 500.0f), 0.0f, random.NextFloat(-500.0f, 500.0f), 1.0f), direction, 200.0f) & 0xff;
+        }
+        checksum += result.size();
+    }
+}
+
+int main()
+{
+    RandomGenerator random(1);
+    BoundingVolumeHierarchy bvh;
+    vector<BoundingBox> bounds(kObjectCount);
+    for (BoundingBox& box : bounds)
+    {
+        box = BoundingBox(XMFLOAT3(random.NextFloat(-500.0f, 500.0f), random.NextFloat(-20.0f, 20.0f), random.NextFloat(-500.0f, 500.0f)),
+            XMFLOAT3(random.NextFloat(0.2f, 2.0f), random.NextFloat(0.2f, 2.0f), random.NextFloat(0.2f, 2.0f)));
+        bvh.AddObject(box);
+    }
+    XMFLOAT4 planes[6];
+    CullingSystem::ExtractFrustumPlanes(XMMatrixMultiply(
+        XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -50.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+        XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 300.0f)), planes);
+
+    size_t checksum = 0;
+    double ms = test::MeasureMs(1, [&bvh, &planes, &checksum] { RunQueries(bvh, planes, checksum); });
+    Report("queries, all pending", ms, checksum);
+
+    ms = test::MeasureMs(kRepeat, [&bvh] { bvh.Rebuild(); });
+    Report("Rebuild (SAH)", ms, bvh.NodeCount());
+
+    checksum = 0;
+    ms = test::MeasureMs(kRepeat, [&bvh, &planes, &checksum] { RunQueries(bvh, planes, checksum); });
+    Report("queries, tree", ms, checksum);
+
+    ms = test::MeasureMs(kRepeat, [&bvh, &bounds]
+    {
+        for (uint32_t id = 0; id < kObjectCount; id += 4)
+        {
+            bounds[id].Center.x += 0.1f;
+            bvh.UpdateObject(id, bounds[id]);
+        }
+        bvh.Refit();
+    });
+    Report("update 25% + Refit", ms, bvh.NodeCount());
+
+    ms = test::MeasureMs(kRepeat, [&bvh]
+    {
+        bvh.RebuildAsync();
+        while (!bvh.ApplyRebuild()) {}
+    });
+    Report("RebuildAsync + ApplyRebuild", ms, bvh.NodeCount());
+    return 0;
+}
@@ -0,0 +1,204 @@
+//--------------------------------------------------------------------------------
+//  bounding_volume_hierarchy_test.cpp
+//  Frustum, overlap and ray queries of BoundingVolumeHierarchy against brute
+//  force over the live objects, through add / rebuild / refit / remove and a
+//  background rebuild.
+//--------------------------------------------------------------------------------
+#include "bounding_volume_hierarchy.h"
+#include "culling_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    // Objects as the test sees them; the reference for every query.
+    struct Model
+    {
+        vector<BoundingBox> bounds;
+        vector<bool> alive;
+    };
+
+    BoundingBox RandomBox(RandomGenerator& random)
+    {
+        return BoundingBox(
+            XMFLOAT3(random.NextFloat(-100.0f, 100.0f), random.NextFloat(-10.0f, 10.0f), random.NextFloat(-100.0f, 100.0f)),
+            XMFLOAT3(random.NextFloat(0.1f, 3.0f), random.NextFloat(0.1f, 3.0f), random.NextFloat(0.1f, 3.0f)));
+    }
+
+    void Track(Model& model, uint32_t id, const BoundingBox& bounds)
+    {
+        if (id >= model.bounds.size())
+        {
+            model.bounds.resize(id + 1);
+            model.alive.resize(id + 1, false);
+        }
+        CHECK(!model.alive[id]);
+        model.bounds[id] = bounds;
+        model.alive[id] = true;
+    }
+
+    float RayBox(const XMFLOAT3& origin, const XMFLOAT3& direction, const BoundingBox& box)
+    {
+        float t_near = 0.0f, t_far = FLT_MAX;
+        const float o[3] = { origin.x, origin.y, origin.z };
+        const float d[3] = { direction.x, direction.y, direction.z };
+        const float c[3] = { box.Center.x, box.Center.y, box.Center.z };
+        const float e[3] = { box.Extents.x, box.Extents.y, box.Extents.z };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float t0 = (c[axis] - e[axis] - o[axis]) / d[axis];
+            const float t1 = (c[axis] + e[axis] - o[axis]) / d[axis];
+            t_near = max(t_near, min(t0, t1));
+            t_far = min(t_far, max(t0, t1));
+        }
+        return t_near <= t_far ? t_near : FLT_MAX;
+    }
+
+    void CheckQueries(const BoundingVolumeHierarchy& bvh, const Model& model, RandomGenerator& random)
+    {
+        vector<uint32_t> result, expected;
+        for (int query = 0; query < 16; ++query)
+        {
+            // Frustum
+            const XMMATRIX view_proj = XMMatrixMultiply(
+                XMMatrixLookAtLH(XMVectorSet(random.NextFloat(-80.0f, 80.0f), 5.0f, random.NextFloat(-80.0f, 80.0f), 1.0f),
+                    XMVectorSet(random.NextFloat(-80.0f, 80.0f), 0.0f, random.NextFloat(-80.0f, 80.0f), 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+                XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.5f, 0.5f, random.NextFloat(20.0f, 150.0f)));
+            XMFLOAT4 planes[6];
+            CullingSystem::ExtractFrustumPlanes(view_proj, planes);
+            result.clear();
+            expected.clear();
+            bvh.QueryFrustum(planes, result);
+            for (uint32_t id = 0; id < model.bounds.size(); ++id)
+            {
+                if (model.alive[id] && CullingSystem::IsBoxVisible(planes, model.bounds[id])) expected.push_back(id);
+            }
+            sort(result.begin(), result.end());
+            CHECK(result == expected);
+
+            // Overlap, touching faces included
+            const BoundingBox box(XMFLOAT3(random.NextFloat(-100.0f, 100.0f), 0.0f, random.NextFloat(-100.0f, 100.0f)), XMFLOAT3(15.0f, 15.0f, 15.0f));
+            result.clear();
+            expected.clear();
+            bvh.QueryOverlap(box, result);
+            for (uint32_t id = 0; id < model.bounds.size(); ++id)
+            {
+                const BoundingBox& b = model.bounds[id];
+                if (model.alive[id]
+                    && fabsf(b.Center.x - box.Center.x) <= b.Extents.x + box.Extents.x
+                    && fabsf(b.Center.y - box.Center.y) <= b.Extents.y + box.Extents.y
+                    && fabsf(b.Center.z - box.Center.z) <= b.Extents.z + box.Extents.z) expected.push_back(id);
+            }
+            sort(result.begin(), result.end());
+            CHECK(result == expected);
+
+            // Ray: the same closest distance (ids may differ on exact ties)
+            const XMFLOAT3 origin(random.NextFloat(-120.0f, 120.0f), random.NextFloat(-5.0f, 5.0f), random.NextFloat(-120.0f, 120.0f));
+            XMFLOAT3 direction;
+            XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSet(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-0.1f, 0.1f), random.NextFloat(-1.0f, 1.0f), 0.0f)));
+            const float max_distance = 150.0f;
+            float best = FLT_MAX;
+            for (uint32_t id = 0; id < model.bounds.size(); ++id)
+            {
+                if (model.alive[id]) best = min(best, RayBox(origin, direction, model.bounds[id]));
+            }
+            float hit = -1.0f;
+            const uint32_t id = bvh.RayCast(XMLoadFloat3(&origin), XMLoadFloat3(&direction), max_distance, &hit);
+            if (best > max_distance)
+            {
+                CHECK(id == BoundingVolumeHierarchy::kInvalidObject);
+            }
+            else
+            {
+                CHECK(id != BoundingVolumeHierarchy::kInvalidObject && model.alive[id]);
+                CHECK(fabsf(hit - best) < 1e-3f);
+            }
+        }
+    }
+
+    void TestQueries()
+    {
+        RandomGenerator random(8);
+        BoundingVolumeHierarchy bvh;
+        Model model;
+
+        // Pending objects only: the linear path.
+        for (int i = 0; i < 3000; ++i)
+        {
+            const BoundingBox box = RandomBox(random);
+            Track(model, bvh.AddObject(box), box);
+        }
+        CHECK(bvh.NodeCount() == 0 && bvh.PendingCount() == 3000);
+        CheckQueries(bvh, model, random);
+
+        bvh.Rebuild();
+        CHECK(bvh.PendingCount() == 0 && bvh.NodeCount() > 0);
+        CHECK(!bvh.NeedsRebuild());
+        CheckQueries(bvh, model, random);
+
+        // Move a third of the objects and refit.
+        for (uint32_t id = 0; id < model.bounds.size(); id += 3)
+        {
+            BoundingBox& box = model.bounds[id];
+            box.Center.x += random.NextFloat(-10.0f, 10.0f);
+            box.Center.z += random.NextFloat(-10.0f, 10.0f);
+            bvh.UpdateObject(id, box);
+        }
+        bvh.Refit();
+        CheckQueries(bvh, model, random);
+
+        // Removed objects disappear at once; their ids are recycled only
+        // after a rebuild, so new objects get fresh ids meanwhile.
+        for (uint32_t id = 1; id < model.bounds.size(); id += 5)
+        {
+            bvh.RemoveObject(id);
+            model.alive[id] = false;
+        }
+        const uint32_t fresh = bvh.AddObject(RandomBox(random));
+        CHECK(fresh == 3000);
+        Track(model, fresh, bvh.ObjectBounds(fresh));
+        CheckQueries(bvh, model, random);
+
+        // Background rebuild; objects keep moving while it runs.
+        bvh.RebuildAsync();
+        for (uint32_t id = 0; id < model.bounds.size(); id += 7)
+        {
+            if (!model.alive[id]) continue;
+            model.bounds[id].Center.y += 1.0f;
+            bvh.UpdateObject(id, model.bounds[id]);
+        }
+        bvh.Refit();
+        while (!bvh.ApplyRebuild()) {}
+        CheckQueries(bvh, model, random);
+
+        const uint32_t recycled = bvh.AddObject(RandomBox(random));
+        CHECK(recycled < 3000 && !model.alive[recycled]);
+        Track(model, recycled, bvh.ObjectBounds(recycled));
+        CheckQueries(bvh, model, random);
+    }
+
+    void TestEmpty()
+    {
+        BoundingVolumeHierarchy bvh;
+        bvh.Rebuild();
+        bvh.Refit();
+        vector<uint32_t> result;
+        bvh.QueryOverlap(BoundingBox(), result);
+        CHECK(result.empty());
+        CHECK(bvh.RayCast(XMVectorZero(), XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), 100.0f) == BoundingVolumeHierarchy::kInvalidObject);
+    }
+}
+
+int main()
+{
+    TestEmpty();
+    TestQueries();
+    return test::Result();
+}
@@ -0,0 +1,72 @@
+//--------------------------------------------------------------------------------
+//  culling_system_benchmark.cpp
+//  Milliseconds to cull 100k instances: scalar IsBoxVisible loop against the
+//  SIMD CullingSystem, serial and on the JobSystem.
+//--------------------------------------------------------------------------------
+#include "culling_system.h"
+#include "job_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr size_t kInstanceCount = 100000;
+    constexpr int kRepeat = 50;
+
+    void Report(const char* name, double ms, size_t visible)
+    {
+        printf("%-24s %8.3f ms   (%zu visible)\n", name, ms, visible);
+    }
+}
+
+int main()
+{
+    RandomGenerator random(1);
+    vector<XMFLOAT4X4> worlds(kInstanceCount);
+    vector<BoundingBox> bounds(kInstanceCount);
+    vector<BoundingBox> world_bounds(kInstanceCount);
+    for (size_t i = 0; i < kInstanceCount; ++i)
+    {
+        const XMFLOAT3 position(random.NextFloat(-500.0f, 500.0f), random.NextFloat(-20.0f, 20.0f), random.NextFloat(-500.0f, 500.0f));
+        XMStoreFloat4x4(&worlds[i], XMMatrixTranslation(position.x, position.y, position.z));
+        world_bounds[i] = BoundingBox(position, bounds[i].Extents);
+    }
+    const XMMATRIX view_proj = XMMatrixMultiply(
+        XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -50.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+        XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+    vector<uint32_t> visible;
+    double ms = test::MeasureMs(kRepeat, [&world_bounds, &visible, &view_proj]
+    {
+        XMFLOAT4 planes[6];
+        CullingSystem::ExtractFrustumPlanes(view_proj, planes);
+        visible.clear();
+        for (size_t i = 0; i < world_bounds.size(); ++i)
+        {
+            if (CullingSystem::IsBoxVisible(planes, world_bounds[i])) visible.push_back(static_cast<uint32_t>(i));
+        }
+    });
+    Report("scalar reference", ms, visible.size());
+
+    CullingSystem culling;
+    ms = test::MeasureMs(kRepeat, [&culling, &worlds, &bounds]
+    {
+        culling.SetInstances(worlds.data(), bounds.data(), kInstanceCount);
+    });
+    printf("%-24s %8.3f ms\n", "SetInstances", ms);
+
+    ms = test::MeasureMs(kRepeat, [&culling, &visible, &view_proj] { culling.Cull(view_proj, visible); });
+    Report("Cull serial", ms, visible.size());
+
+    JobSystem::Create()->Initialize();
+    ms = test::MeasureMs(kRepeat, [&culling, &visible, &view_proj] { culling.Cull(view_proj, visible); });
+    char name[64];
+    snprintf(name, sizeof(name), "Cull %u workers", JobSystem::Instance().WorkerCount());
+    Report(name, ms, visible.size());
+    JobSystem::Instance().Release();
+    return 0;
+}
@@ -0,0 +1,229 @@
+//--------------------------------------------------------------------------------
+//  culling_system_test.cpp
+//  SIMD culling of CullingSystem against the scalar IsBoxVisible reference,
+//  serial and on the JobSystem, for random instances and cameras.
+//--------------------------------------------------------------------------------
+#include "culling_system.h"
+#include "job_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    struct Scene
+    {
+        vector<XMFLOAT4X4> worlds;
+        vector<BoundingBox> local_bounds;
+        vector<BoundingBox> world_bounds;   // expected result of SetInstance
+    };
+
+    // Rotated, scaled and translated boxes spread around the origin.
+    Scene MakeScene(size_t count, uint32_t seed)
+    {
+        RandomGenerator random(seed);
+        Scene scene;
+        scene.worlds.resize(count);
+        scene.local_bounds.resize(count);
+        scene.world_bounds.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float scale = random.NextFloat(0.2f, 3.0f);
+            const XMMATRIX world = XMMatrixMultiply(
+                XMMatrixMultiply(XMMatrixScaling(scale, scale, scale), XMMatrixRotationY(random.NextFloat(0.0f, XM_2PI))),
+                XMMatrixTranslation(random.NextFloat(-200.0f, 200.0f), random.NextFloat(-20.0f, 20.0f), random.NextFloat(-200.0f, 200.0f)));
+            XMStoreFloat4x4(&scene.worlds[i], world);
+
+            BoundingBox& local = scene.local_bounds[i];
+            local.Center = XMFLOAT3(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f));
+            local.Extents = XMFLOAT3(random.NextFloat(0.1f, 2.0f), random.NextFloat(0.1f, 2.0f), random.NextFloat(0.1f, 2.0f));
+
+            // Box of the 8 transformed corners.
+            XMFLOAT3 lo(1e30f, 1e30f, 1e30f), hi(-1e30f, -1e30f, -1e30f);
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                const XMVECTOR p = XMVector3Transform(XMVectorSet(
+                    local.Center.x + ((corner & 1) ? local.Extents.x : -local.Extents.x),
+                    local.Center.y + ((corner & 2) ? local.Extents.y : -local.Extents.y),
+                    local.Center.z + ((corner & 4) ? local.Extents.z : -local.Extents.z), 1.0f), world);
+                XMFLOAT3 c;
+                XMStoreFloat3(&c, p);
+                lo = XMFLOAT3(fminf(lo.x, c.x), fminf(lo.y, c.y), fminf(lo.z, c.z));
+                hi = XMFLOAT3(fmaxf(hi.x, c.x), fmaxf(hi.y, c.y), fmaxf(hi.z, c.z));
+            }
+            scene.world_bounds[i].Center = XMFLOAT3((lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f);
+            scene.world_bounds[i].Extents = XMFLOAT3((hi.x - lo.x) * 0.5f, (hi.y - lo.y) * 0.5f, (hi.z - lo.z) * 0.5f);
+        }
+        return scene;
+    }
+
+    XMMATRIX MakeViewProj(RandomGenerator& random)
+    {
+        const XMVECTOR eye = XMVectorSet(random.NextFloat(-100.0f, 100.0f), random.NextFloat(0.0f, 30.0f), random.NextFloat(-100.0f, 100.0f), 1.0f);
+        const XMVECTOR at = XMVectorSet(random.NextFloat(-100.0f, 100.0f), 0.0f, random.NextFloat(-100.0f, 100.0f), 1.0f);
+        const XMMATRIX view = XMMatrixLookAtLH(eye, at, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(random.NextFloat(0.5f, 1.5f), 16.0f / 9.0f, 0.1f, random.NextFloat(50.0f, 300.0f)));
+    }
+
+    vector<uint32_t> Reference(const Scene& scene, FXMMATRIX view_proj)
+    {
+        XMFLOAT4 planes[6];
+        CullingSystem::ExtractFrustumPlanes(view_proj, planes);
+        vector<uint32_t> visible;
+        for (size_t i = 0; i < scene.world_bounds.size(); ++i)
+        {
+            if (CullingSystem::IsBoxVisible(planes, scene.world_bounds[i])) visible.push_back(static_cast<uint32_t>(i));
+        }
+        return visible;
+    }
+
+    // Signed distance by which the box clears the plane it is closest to
+    // failing, in world units (< 0: outside that plane).
+    float Margin(const XMFLOAT4 planes[6], const BoundingBox& box)
+    {
+        float margin = FLT_MAX;
+        for (int i = 0; i < 6; ++i)
+        {
+            const XMFLOAT4& p = planes[i];
+            const float distance = p.x * box.Center.x + p.y * box.Center.y + p.z * box.Center.z + p.w;
+            const float radius = fabsf(p.x) * box.Extents.x + fabsf(p.y) * box.Extents.y + fabsf(p.z) * box.Extents.z;
+            margin = fminf(margin, (distance + radius) / sqrtf(p.x * p.x + p.y * p.y + p.z * p.z));
+        }
+        return margin;
+    }
+
+    // The SIMD path builds its bounds from |M| * extents, the reference from
+    // the 8 transformed corners, so boxes touching a plane (within rounding
+    // of either, on any DirectXMath build) may land on either side.  All
+    // others must agree, and the list must stay ascending.
+    bool MatchesReference(const Scene& scene, FXMMATRIX view_proj, const vector<uint32_t>& visible, const vector<uint32_t>& expected)
+    {
+        constexpr float kTolerance = 1e-3f;
+        XMFLOAT4 planes[6];
+        CullingSystem::ExtractFrustumPlanes(view_proj, planes);
+        for (size_t i = 1; i < visible.size(); ++i)
+        {
+            if (visible[i - 1] >= visible[i]) return false;
+        }
+
+        size_t a = 0, b = 0;
+        while (a < visible.size() || b < expected.size())
+        {
+            if (a < visible.size() && b < expected.size() && visible[a] == expected[b])
+            {
+                ++a;
+                ++b;
+                continue;
+            }
+            const bool extra = b == expected.size() || (a < visible.size() && visible[a] < expected[b]);
+            const uint32_t instance = extra ? visible[a++] : expected[b++];
+            if (instance >= scene.world_bounds.size() || fabsf(Margin(planes, scene.world_bounds[instance])) > kTolerance) return false;
+        }
+        return true;
+    }
+
+    void TestWorldBounds()
+    {
+        // The |M| extents give the exact box of the transformed corners.
+        const Scene scene = MakeScene(1001, 3);
+        CullingSystem culling;
+        culling.SetInstances(scene.worlds.data(), scene.local_bounds.data(), scene.worlds.size());
+        CHECK(culling.InstanceCount() == 1001);
+
+        // An orthographic box cutting through many instances: a looser box
+        // than the transformed corners would keep instances the reference culls.
+        const XMMATRIX view_proj = XMMatrixOrthographicOffCenterLH(-50.0f, 50.0f, -5.0f, 5.0f, -50.0f, 50.0f);
+        vector<uint32_t> visible;
+        culling.Cull(view_proj, visible);
+        CHECK(MatchesReference(scene, view_proj, visible, Reference(scene, view_proj)));
+        CHECK(!visible.empty() && visible.size() < scene.worlds.size());
+    }
+
+    void TestAgainstReference()
+    {
+        // Counts that are not a multiple of 4 exercise the padding lanes.
+        const size_t counts[] = { 0, 1, 3, 4, 7, 4097, 50001 };
+        RandomGenerator random(17);
+        for (size_t count : counts)
+        {
+            const Scene scene = MakeScene(count, static_cast<uint32_t>(count) + 1);
+            CullingSystem culling;
+            culling.SetInstances(scene.worlds.data(), scene.local_bounds.data(), count);
+            for (int camera = 0; camera < 8; ++camera)
+            {
+                const XMMATRIX view_proj = MakeViewProj(random);
+                const vector<uint32_t> expected = Reference(scene, view_proj);
+                vector<uint32_t> visible;
+                culling.Cull(view_proj, visible);
+                CHECK(MatchesReference(scene, view_proj, visible, expected));
+
+                if (JobSystem::IsCreated())
+                {
+                    // Any chunk count gives the same ascending list.
+                    vector<uint32_t> serial;
+                    culling.Cull(view_proj, serial, 1);
+                    for (uint32_t workers = 1; workers <= 7; workers += 3)
+                    {
+                        culling.Cull(view_proj, visible, workers);
+                        CHECK(visible == serial);
+                    }
+                }
+            }
+        }
+    }
+
+    void TestEdgeCases()
+    {
+        const XMMATRIX view_proj = XMMatrixMultiply(
+            XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+            XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 100.0f));
+        XMFLOAT4 planes[6];
+        CullingSystem::ExtractFrustumPlanes(view_proj, planes);
+
+        // In front, behind, past the far plane, straddling the near plane and
+        // just outside the right plane (x = z with a 90 degree fov).
+        CHECK(CullingSystem::IsBoxVisible(planes, BoundingBox(XMFLOAT3(0.0f, 0.0f, 10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+        CHECK(!CullingSystem::IsBoxVisible(planes, BoundingBox(XMFLOAT3(0.0f, 0.0f, -10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+        CHECK(!CullingSystem::IsBoxVisible(planes, BoundingBox(XMFLOAT3(0.0f, 0.0f, 110.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+        CHECK(CullingSystem::IsBoxVisible(planes, BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+        CHECK(!CullingSystem::IsBoxVisible(planes, BoundingBox(XMFLOAT3(12.0f, 0.0f, 10.0f), XMFLOAT3(0.5f, 0.5f, 0.5f))));
+        CHECK(CullingSystem::IsBoxVisible(planes, BoundingBox(XMFLOAT3(10.5f, 0.0f, 10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+    }
+
+    void TestProjectedRadii()
+    {
+        XMFLOAT4X4 identity;
+        XMStoreFloat4x4(&identity, XMMatrixIdentity());
+        const XMFLOAT4X4 worlds[2] = { identity, identity };
+        const BoundingBox bounds[2] =
+        {
+            BoundingBox(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 2.0f, 2.0f)),  // radius 3
+            BoundingBox(XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(2.0f, 2.0f, 2.0f)),   // contains the eye
+        };
+        CullingSystem culling;
+        culling.SetInstances(worlds, bounds, 2);
+        const uint32_t visible[2] = { 0, 1 };
+        float radii[2] = {};
+        culling.ProjectedRadii(XMVectorZero(), 500.0f, visible, 2, radii);
+        CHECK(fabsf(radii[0] - 3.0f * 500.0f / 20.0f) < 1e-3f);
+        CHECK(radii[1] == 500.0f);
+    }
+}
+
+int main()
+{
+    TestWorldBounds();
+    TestEdgeCases();
+    TestProjectedRadii();
+    TestAgainstReference();
+
+    JobSystem::Create()->Initialize(4);
+    TestAgainstReference();
+    JobSystem::Instance().Release();
+    return test::Result();
+}
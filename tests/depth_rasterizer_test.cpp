@@ -0,0 +1,282 @@
+//--------------------------------------------------------------------------------
+//  depth_rasterizer_test.cpp
+//  DepthRasterizer against a per pixel reference: coverage with the top-left
+//  fill rule (pixel centers on edges and vertices, shared edges drawn exactly
+//  once, both windings), interpolated depth, the depth test and near / far
+//  clipping.  Vertices are given in pixels on a 1/256 grid, so the sub pixel
+//  snapping is exact and the reference needs no tolerance.
+//--------------------------------------------------------------------------------
+#include "depth_rasterizer.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kSize = 64;
+
+    struct Vertex
+    {
+        float x, y, z;      // pixels, y down; depth
+    };
+
+    // Pixels to clip space (row vectors): x * 2 / size - 1, 1 - y * 2 / size.
+    const float kPixelToClip[16] =
+    {
+        2.0f / kSize, 0.0f, 0.0f, 0.0f,
+        0.0f, -2.0f / kSize, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f, 1.0f,
+    };
+
+    float Snap(float value)
+    {
+        return roundf(value * 256.0f) / 256.0f;
+    }
+
+    void Draw(DepthRasterizer& rasterizer, const Vertex& a, const Vertex& b, const Vertex& c)
+    {
+        const Vertex vertices[3] = { a, b, c };
+        const uint32_t indices[3] = { 0, 1, 2 };
+        rasterizer.DrawIndexed(&vertices[0].x, sizeof(Vertex), indices, 3, kPixelToClip);
+    }
+
+    // Reference coverage: a center is inside when it is strictly inside every
+    // edge, or on an edge that is a top edge (horizontal, the third vertex
+    // below it) or a left edge (the triangle to its right).
+    bool Covers(const Vertex& a, const Vertex& b, const Vertex& c, double x, double y)
+    {
+        const Vertex* v[3] = { &a, &b, &c };
+        const double area = (double(b.x) - a.x) * (double(c.y) - a.y) - (double(b.y) - a.y) * (double(c.x) - a.x);
+        if (area == 0.0) return false;
+        for (int i = 0; i < 3; ++i)
+        {
+            const Vertex& p = *v[i];
+            const Vertex& q = *v[(i + 1) % 3];
+            const Vertex& r = *v[(i + 2) % 3];
+            // Positive on the side of the third vertex.
+            const double side = ((double(q.x) - p.x) * (y - p.y) - (double(q.y) - p.y) * (x - p.x)) * (area > 0.0 ? 1.0 : -1.0);
+            if (side > 0.0) continue;
+            if (side < 0.0) return false;
+            const bool top = p.y == q.y && r.y > p.y;
+            const bool left = p.y != q.y && r.x > p.x + (r.y - p.y) * (double(q.x) - p.x) / (double(q.y) - p.y);
+            if (!top && !left) return false;
+        }
+        return true;
+    }
+
+    vector<uint32_t> Coverage(DepthRasterizer& rasterizer)
+    {
+        vector<uint32_t> covered;
+        for (uint32_t i = 0; i < kSize * kSize; ++i)
+        {
+            if (rasterizer.Depth()[i] != 1.0f) covered.push_back(i);
+        }
+        return covered;
+    }
+
+    vector<uint32_t> ReferenceCoverage(const Vertex& a, const Vertex& b, const Vertex& c)
+    {
+        vector<uint32_t> covered;
+        for (uint32_t y = 0; y < kSize; ++y)
+        {
+            for (uint32_t x = 0; x < kSize; ++x)
+            {
+                if (Covers(a, b, c, x + 0.5, y + 0.5)) covered.push_back(y * kSize + x);
+            }
+        }
+        return covered;
+    }
+
+    void TestEdgeCases()
+    {
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(kSize, kSize);
+
+        // A square with corners on pixel centers, split along either
+        // diagonal, in either winding: its top and left sides are drawn,
+        // the bottom and right ones are not.
+        const Vertex tl = { 10.5f, 10.5f, 0.5f }, tr = { 20.5f, 10.5f, 0.5f };
+        const Vertex bl = { 10.5f, 20.5f, 0.5f }, br = { 20.5f, 20.5f, 0.5f };
+        const Vertex squares[4][2][3] =
+        {
+            { { tl, tr, br }, { tl, br, bl } },
+            { { tl, br, tr }, { tl, bl, br } },
+            { { tl, tr, bl }, { tr, br, bl } },
+            { { tr, tl, bl }, { br, tr, bl } },
+        };
+        for (const auto& square : squares)
+        {
+            vector<uint32_t> counts(kSize * kSize, 0);
+            for (const auto& triangle : square)
+            {
+                rasterizer.Clear();
+                Draw(rasterizer, triangle[0], triangle[1], triangle[2]);
+                const vector<uint32_t> covered = Coverage(rasterizer);
+                CHECK(covered == ReferenceCoverage(triangle[0], triangle[1], triangle[2]));
+                for (uint32_t pixel : covered) ++counts[pixel];
+            }
+            bool exact = true;
+            for (uint32_t y = 0; y < kSize; ++y)
+            {
+                for (uint32_t x = 0; x < kSize; ++x)
+                {
+                    const uint32_t expected = x >= 10 && x < 20 && y >= 10 && y < 20 ? 1 : 0;
+                    exact = exact && counts[y * kSize + x] == expected;
+                }
+            }
+            CHECK(exact);
+        }
+
+        // A degenerate triangle, then the two halves of one pixel, whose
+        // center is on their diagonal.
+        rasterizer.Clear();
+        Draw(rasterizer, { 5.5f, 5.5f, 0.5f }, { 30.5f, 5.5f, 0.5f }, { 17.5f, 5.5f, 0.5f });
+        CHECK(Coverage(rasterizer).empty());
+        rasterizer.Clear();
+        Draw(rasterizer, { 5.0f, 5.0f, 0.5f }, { 6.0f, 5.0f, 0.5f }, { 5.0f, 6.0f, 0.5f });
+        CHECK(Coverage(rasterizer).empty());    // a right edge
+        rasterizer.Clear();
+        Draw(rasterizer, { 5.0f, 5.0f, 0.5f }, { 6.0f, 5.0f, 0.5f }, { 6.0f, 6.0f, 0.5f });
+        CHECK(Coverage(rasterizer) == vector<uint32_t>{ 5 * kSize + 5 });     // a left edge
+    }
+
+    void TestSharedEdges()
+    {
+        // A jittered grid of triangles over [8.5, 56.5)^2: every pixel center
+        // inside is drawn exactly once and matches the reference.
+        RandomGenerator random(47);
+        constexpr int kCells = 6;
+        const float cell = 8.0f;
+        Vertex grid[kCells + 1][kCells + 1];
+        for (int j = 0; j <= kCells; ++j)
+        {
+            for (int i = 0; i <= kCells; ++i)
+            {
+                const bool border_x = i == 0 || i == kCells;
+                const bool border_y = j == 0 || j == kCells;
+                grid[j][i].x = 8.5f + i * cell + (border_x ? 0.0f : Snap(random.NextFloat(-3.0f, 3.0f)));
+                grid[j][i].y = 8.5f + j * cell + (border_y ? 0.0f : Snap(random.NextFloat(-3.0f, 3.0f)));
+                grid[j][i].z = 0.5f;
+            }
+        }
+        // Some vertices exactly on pixel centers and on pixel corners.
+        grid[2][2].x = 24.5f;
+        grid[2][2].y = 24.5f;
+        grid[3][4].x = 41.0f;
+        grid[3][4].y = 32.0f;
+
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(kSize, kSize);
+        vector<uint32_t> counts(kSize * kSize, 0);
+        bool matches = true;
+        for (int j = 0; j < kCells; ++j)
+        {
+            for (int i = 0; i < kCells; ++i)
+            {
+                const Vertex& a = grid[j][i];
+                const Vertex& b = grid[j][i + 1];
+                const Vertex& c = grid[j + 1][i];
+                const Vertex& d = grid[j + 1][i + 1];
+                const Vertex triangles[2][3] = { { a, b, d }, { a, d, c } };
+                for (const auto& triangle : triangles)
+                {
+                    rasterizer.Clear();
+                    // Alternate windings.
+                    if ((i + j) & 1) Draw(rasterizer, triangle[0], triangle[2], triangle[1]);
+                    else Draw(rasterizer, triangle[0], triangle[1], triangle[2]);
+                    const vector<uint32_t> covered = Coverage(rasterizer);
+                    matches = matches && covered == ReferenceCoverage(triangle[0], triangle[1], triangle[2]);
+                    for (uint32_t pixel : covered) ++counts[pixel];
+                }
+            }
+        }
+        CHECK(matches);
+        bool once = true;
+        for (uint32_t y = 0; y < kSize; ++y)
+        {
+            for (uint32_t x = 0; x < kSize; ++x)
+            {
+                const uint32_t expected = x >= 8 && x < 56 && y >= 8 && y < 56 ? 1 : 0;
+                once = once && counts[y * kSize + x] == expected;
+            }
+        }
+        CHECK(once);
+    }
+
+    void TestDepth()
+    {
+        // Depth is the plane through the vertices, sampled at pixel centers.
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(kSize, kSize);
+        rasterizer.Clear();
+        const Vertex a = { 0.0f, 0.0f, 0.2f }, b = { 64.0f, 0.0f, 0.6f }, c = { 0.0f, 64.0f, 0.4f };
+        Draw(rasterizer, a, b, c);
+        bool plane = true;
+        for (uint32_t y = 0; y < kSize; ++y)
+        {
+            for (uint32_t x = 0; x < kSize; ++x)
+            {
+                const float depth = rasterizer.Depth()[y * kSize + x];
+                if (depth == 1.0f) continue;
+                const float expected = 0.2f + 0.4f * (x + 0.5f) / 64.0f + 0.2f * (y + 0.5f) / 64.0f;
+                plane = plane && fabsf(depth - expected) < 1e-5f;
+            }
+        }
+        CHECK(plane);
+
+        // LESS: the nearer triangle wins in either order.
+        const Vertex near_quad[2][3] = { { { 0, 0, 0.3f }, { 64, 0, 0.3f }, { 64, 64, 0.3f } }, { { 0, 0, 0.3f }, { 64, 64, 0.3f }, { 0, 64, 0.3f } } };
+        const Vertex far_quad[2][3] = { { { 0, 0, 0.7f }, { 64, 0, 0.7f }, { 64, 64, 0.7f } }, { { 0, 0, 0.7f }, { 64, 64, 0.7f }, { 0, 64, 0.7f } } };
+        for (int order = 0; order < 2; ++order)
+        {
+            rasterizer.Clear();
+            const auto& first = order == 0 ? near_quad : far_quad;
+            const auto& second = order == 0 ? far_quad : near_quad;
+            for (const auto& triangle : first) Draw(rasterizer, triangle[0], triangle[1], triangle[2]);
+            for (const auto& triangle : second) Draw(rasterizer, triangle[0], triangle[1], triangle[2]);
+            bool nearest = true;
+            for (uint32_t i = 0; i < kSize * kSize; ++i) nearest = nearest && fabsf(rasterizer.Depth()[i] - 0.3f) < 1e-6f;
+            CHECK(nearest);
+        }
+
+        // Depth from -0.5 to 1.5 across the screen: only 0 <= z <= 1 is drawn.
+        rasterizer.Clear();
+        const Vertex ramp[2][3] = { { { 0, 0, -0.5f }, { 64, 0, 1.5f }, { 64, 64, 1.5f } }, { { 0, 0, -0.5f }, { 64, 64, 1.5f }, { 0, 64, -0.5f } } };
+        for (const auto& triangle : ramp) Draw(rasterizer, triangle[0], triangle[1], triangle[2]);
+        bool clipped = true;
+        for (uint32_t y = 0; y < kSize; ++y)
+        {
+            for (uint32_t x = 0; x < kSize; ++x)
+            {
+                const float z = -0.5f + 2.0f * (x + 0.5f) / 64.0f;
+                const float depth = rasterizer.Depth()[y * kSize + x];
+                if (z < -1e-4f || z > 1.0f + 1e-4f) clipped = clipped && depth == 1.0f;
+                else if (z > 1e-4f && z < 1.0f - 1e-4f) clipped = clipped && fabsf(depth - z) < 1e-5f;
+            }
+        }
+        CHECK(clipped);
+    }
+
+    void TestGuardBand()
+    {
+        // A triangle far larger than the screen covers all of it.
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(kSize, kSize);
+        rasterizer.Clear();
+        Draw(rasterizer, { -100000.0f, -100000.0f, 0.5f }, { 200000.0f, -100000.0f, 0.5f }, { -100000.0f, 200000.0f, 0.5f });
+        CHECK(Coverage(rasterizer).size() == kSize * kSize);
+    }
+}
+
+int main()
+{
+    TestEdgeCases();
+    TestSharedEdges();
+    TestDepth();
+    TestGuardBand();
+    return test::Result();
+}
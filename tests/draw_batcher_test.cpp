@@ -0,0 +1,139 @@
+//--------------------------------------------------------------------------------
+//  draw_batcher_test.cpp
+//  RadixSort against std::stable_sort, and the batches of DrawBatcher against
+//  the runs of the sorted packets.
+//--------------------------------------------------------------------------------
+#include "draw_batcher.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    void TestRadixSort()
+    {
+        RandomGenerator random(4);
+        vector<uint64_t> temp_keys;
+        vector<uint32_t> temp_values;
+        const size_t counts[] = { 1, 2, 255, 10000 };
+        for (size_t count : counts)
+        {
+            // Few distinct high bytes, so some passes are skipped and many keys tie.
+            vector<uint64_t> keys(count);
+            for (uint64_t& key : keys)
+            {
+                key = DrawBatcher::MakeKey(random.NextInt(0, 3), random.NextInt(0, 40), random.NextInt(0, 1000), random.NextFloat());
+            }
+            vector<uint32_t> values(count);
+            iota(values.begin(), values.end(), 0u);
+
+            vector<uint32_t> expected = values;
+            stable_sort(expected.begin(), expected.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+            vector<uint64_t> expected_keys(count);
+            for (size_t i = 0; i < count; ++i) expected_keys[i] = keys[expected[i]];
+
+            DrawBatcher::RadixSort(keys, values, temp_keys, temp_values);
+            CHECK(keys == expected_keys);
+            CHECK(values == expected);  // stable
+        }
+
+        // Identical keys skip every pass.
+        vector<uint64_t> keys(5, 42);
+        vector<uint32_t> values = { 4, 3, 2, 1, 0 };
+        DrawBatcher::RadixSort(keys, values, temp_keys, temp_values);
+        CHECK(values == vector<uint32_t>({ 4, 3, 2, 1, 0 }));
+    }
+
+    void TestKey()
+    {
+        const uint64_t key = DrawBatcher::MakeKey(200, 60000, 0xabcdef, 0.5f);
+        CHECK(DrawBatcher::KeyPso(key) == 200);
+        CHECK(DrawBatcher::KeyMaterial(key) == 60000);
+        CHECK(DrawBatcher::KeySubmesh(key) == 0xabcdef);
+        CHECK(DrawBatcher::MakeKey(0, 0, 0, -1.0f) == 0);
+        CHECK(DrawBatcher::MakeKey(0, 0, 0, 2.0f) == 0xffff);
+        // Front to back inside a draw.
+        CHECK(DrawBatcher::MakeKey(1, 1, 1, 0.2f) < DrawBatcher::MakeKey(1, 1, 1, 0.3f));
+    }
+
+    void TestBuild()
+    {
+        RandomGenerator random(9);
+        DrawBatcher batcher;
+        for (uint32_t i = 0; i < 50; ++i)
+        {
+            SubmeshRange range;
+            range.mesh = i / 10;
+            range.index_count = 3 * (i + 1);
+            range.start_index = 100 * i;
+            range.base_vertex = static_cast<int32_t>(i);
+            CHECK(batcher.RegisterSubmesh(range) == i);
+        }
+
+        const int packet_count = 5000;
+        vector<uint32_t> materials(packet_count);
+        for (int frame = 0; frame < 2; ++frame)
+        {
+            batcher.Clear();
+            for (int i = 0; i < packet_count; ++i)
+            {
+                // The packet index goes in the world matrix to trace it.
+                XMFLOAT4X4 world = {};
+                world.m[0][0] = static_cast<float>(i);
+                materials[i] = random.NextInt(0, 7);
+                batcher.Add(random.NextInt(0, 2), materials[i], random.NextInt(0, 49), random.NextFloat(), world);
+            }
+            batcher.Build();
+            CHECK(batcher.PacketCount() == packet_count);
+
+            const vector<DrawBatch>& batches = batcher.Batches();
+            const vector<InstanceData>& instances = batcher.Instances();
+            CHECK(instances.size() == packet_count);
+
+            // Batches tile the instances in order, every instance matches its
+            // batch, and consecutive batches never share pso/material/submesh.
+            uint32_t next_instance = 0;
+            for (size_t b = 0; b < batches.size(); ++b)
+            {
+                const DrawBatch& batch = batches[b];
+                const SubmeshRange& range = batcher.Submesh(batch.submesh);
+                CHECK(batch.args.StartInstanceLocation == next_instance);
+                CHECK(batch.args.InstanceCount > 0);
+                CHECK(batch.mesh == range.mesh && batch.args.IndexCountPerInstance == range.index_count);
+                CHECK(batch.args.StartIndexLocation == range.start_index && batch.args.BaseVertexLocation == range.base_vertex);
+                for (uint32_t i = 0; i < batch.args.InstanceCount; ++i)
+                {
+                    const InstanceData& instance = instances[next_instance + i];
+                    CHECK(instance.MaterialIndex == batch.material);
+                    CHECK(materials[static_cast<int>(instance.World.m[0][0])] == batch.material);
+                }
+                next_instance += batch.args.InstanceCount;
+                if (b > 0)
+                {
+                    const DrawBatch& previous = batches[b - 1];
+                    CHECK(previous.pso != batch.pso || previous.material != batch.material || previous.submesh != batch.submesh);
+                }
+            }
+            CHECK(next_instance == packet_count);
+            // 3 psos * 8 materials * 50 submeshes at most.
+            CHECK(batches.size() <= 3 * 8 * 50);
+        }
+
+        batcher.Clear();
+        batcher.Build();
+        CHECK(batcher.Batches().empty());
+    }
+}
+
+int main()
+{
+    TestKey();
+    TestRadixSort();
+    TestBuild();
+    return test::Result();
+}
@@ -0,0 +1,221 @@
+//--------------------------------------------------------------------------------
+//  dynamic_resolution_test.cpp
+//  DynamicResolutionController on frame time traces: a GPU whose cost
+//  follows the pixel count (base_ms * scale^2) with spikes, overloads and
+//  cheap stretches mixed in.  Checks single spikes, the hysteresis band,
+//  the settle frames and that the same trace always gives the same scales.
+//--------------------------------------------------------------------------------
+#include "dynamic_resolution.h"
+#include "test_util.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Feeds base_ms * scale^2 for count frames, with spike_ms in place of
+    // the frames listed in spikes.  Returns the scale after each frame.
+    vector<float> Run(DynamicResolutionController& controller, float base_ms, uint32_t count,
+        const vector<uint32_t>& spikes = {}, float spike_ms = 100.0f)
+    {
+        vector<float> scales;
+        for (uint32_t frame = 0; frame < count; ++frame)
+        {
+            bool spike = false;
+            for (uint32_t spike_frame : spikes) spike = spike || spike_frame == frame;
+            const float scale = controller.Scale();
+            scales.push_back(controller.Update(spike ? spike_ms : base_ms * scale * scale));
+        }
+        return scales;
+    }
+
+    uint32_t ChangeCount(const vector<float>& scales, float first)
+    {
+        uint32_t changes = 0;
+        for (float scale : scales)
+        {
+            if (scale != first) ++changes;
+            first = scale;
+        }
+        return changes;
+    }
+
+    bool IsStep(float scale, float step)
+    {
+        const float steps = scale / step;
+        return fabsf(steps - roundf(steps)) < 1e-3f;
+    }
+
+    void TestUnderBudget()
+    {
+        DynamicResolutionController controller;
+        const vector<float> scales = Run(controller, 12.0f, 1000);
+        CHECK(ChangeCount(scales, 1.0f) == 0 && controller.Scale() == 1.0f);
+    }
+
+    void TestSingleSpike()
+    {
+        // One hitch per second at full resolution: the scale never drops.
+        DynamicResolutionController controller;
+        const vector<float> scales = Run(controller, 12.0f, 600, { 10, 70, 130, 131, 400 });
+        CHECK(ChangeCount(scales, 1.0f) == 0);
+        CHECK(controller.FilteredMs() < controller.Settings().target_ms);
+    }
+
+    void TestOverload()
+    {
+        // 20 ms at full resolution: drops below budget at once and stays.
+        DynamicResolutionController controller;
+        const vector<float> scales = Run(controller, 20.0f, 2000);
+        CHECK(scales[0] < 1.0f);
+        const float settled = controller.Scale();
+        CHECK(settled < 1.0f && IsStep(settled, controller.Settings().scale_step));
+        CHECK(20.0f * settled * settled <= controller.Settings().target_ms);
+        CHECK(ChangeCount(vector<float>(scales.begin() + 100, scales.end()), scales[99]) == 0);
+
+        // Far over budget: stops at min_scale.
+        DynamicResolutionController slow;
+        Run(slow, 200.0f, 100);
+        CHECK(slow.Scale() == slow.Settings().min_scale);
+    }
+
+    void TestSettleFrames()
+    {
+        // The settle_frames samples after a change are ignored, whatever
+        // they are.
+        DynamicResolutionController controller;
+        const uint32_t settle_frames = controller.Settings().settle_frames;
+        const float scale = controller.Update(20.0f);
+        CHECK(scale < 1.0f);
+        const float filtered = controller.FilteredMs();
+        for (uint32_t i = 0; i < settle_frames; ++i) CHECK(controller.Update(1000.0f) == scale);
+        CHECK(controller.FilteredMs() == filtered);
+
+        // The filtered time went on at the new pixel count, so a spike right
+        // after the settle frames is clamped like any other.
+        CHECK(filtered < controller.Settings().target_ms);
+        CHECK(controller.Update(100.0f) == scale);
+        CHECK(controller.FilteredMs() < controller.Settings().target_ms);
+        const vector<float> scales = Run(controller, 20.0f, 500, { 40, 200 });
+        CHECK(ChangeCount(scales, scale) == 0);
+    }
+
+    void TestHysteresis()
+    {
+        // Within the band (0.85 to 1.0 of the budget) the scale holds, for
+        // times drifting inside it as well.
+        DynamicResolutionController controller;
+        Run(controller, 20.0f, 100);
+        const float scale = controller.Scale();
+        vector<float> scales;
+        for (uint32_t frame = 0; frame < 2000; ++frame)
+        {
+            const float ms = controller.Settings().target_ms * (0.87f + 0.12f * (frame % 50) / 50.0f);
+            scales.push_back(controller.Update(ms));
+        }
+        CHECK(ChangeCount(scales, scale) == 0);
+
+        // Under the band, one step after increase_frames frames, no sooner.
+        const uint32_t increase_frames = controller.Settings().increase_frames;
+        DynamicResolutionController rising;
+        Run(rising, 20.0f, 100);
+        const float before = rising.Scale();
+        const float cheap_ms = 10.0f * before * before;
+        uint32_t frames = 0;
+        while (rising.Scale() == before && frames < 1000)
+        {
+            rising.Update(cheap_ms);
+            ++frames;
+        }
+        CHECK(frames >= increase_frames);
+        CHECK(fabsf(rising.Scale() - before - rising.Settings().scale_step) < 1e-4f);
+
+        // A raise whose predicted cost is over budget does not happen, though
+        // the time is under the band.
+        DynamicResolutionSettings settings;
+        settings.scale_step = 0.25f;
+        settings.min_scale = 0.5f;
+        DynamicResolutionController coarse(settings);
+        Run(coarse, 40.0f, 100);
+        CHECK(coarse.Scale() == 0.5f);
+        const vector<float> held = Run(coarse, 52.0f, 500);    // 13 ms now, 20.3 ms at 0.75
+        CHECK(ChangeCount(held, 0.5f) == 0);
+    }
+
+    void TestRecovery()
+    {
+        // The scene gets cheap: back to full resolution step by step, each
+        // raise at least settle + increase frames after the one before.
+        DynamicResolutionController controller;
+        Run(controller, 30.0f, 200);
+        const float low = controller.Scale();
+        const vector<float> scales = Run(controller, 8.0f, 2000);
+        CHECK(controller.Scale() == 1.0f);
+
+        const DynamicResolutionSettings& settings = controller.Settings();
+        uint32_t last_change = 0;
+        float previous = low;
+        bool one_step = true;
+        bool spaced = true;
+        for (uint32_t frame = 0; frame < scales.size(); ++frame)
+        {
+            if (scales[frame] == previous) continue;
+            one_step = one_step && fabsf(scales[frame] - previous - settings.scale_step) < 1e-4f;
+            spaced = spaced && (last_change == 0 || frame - last_change >= settings.settle_frames + settings.increase_frames);
+            last_change = frame;
+            previous = scales[frame];
+        }
+        CHECK(one_step && spaced);
+    }
+
+    void TestDeterministic()
+    {
+        vector<float> trace;
+        for (uint32_t frame = 0; frame < 3000; ++frame)
+        {
+            trace.push_back(10.0f + 12.0f * ((frame * 2654435761u) >> 24) / 255.0f + (frame % 500 < 100 ? 10.0f : 0.0f));
+        }
+        DynamicResolutionController first;
+        DynamicResolutionController second;
+        bool same = true;
+        bool quantized = true;
+        for (float ms : trace)
+        {
+            const float scale = first.Update(ms);
+            same = same && scale == second.Update(ms);
+            quantized = quantized && IsStep(scale, first.Settings().scale_step)
+                && scale >= first.Settings().min_scale && scale <= first.Settings().max_scale;
+        }
+        CHECK(same && quantized);
+
+        // Reset forgets the history.
+        first.Reset();
+        CHECK(first.Scale() == 1.0f && first.FilteredMs() == 0.0f);
+        CHECK(first.Update(12.0f) == 1.0f && first.FilteredMs() == 12.0f);
+    }
+
+    void TestRenderSize()
+    {
+        uint32_t width = 0, height = 0;
+        DynamicResolutionController::RenderSize(1920, 1080, 0.5f, &width, &height);
+        CHECK(width == 960 && height == 540);
+        DynamicResolutionController::RenderSize(1280, 720, 0.85f, &width, &height);
+        CHECK(width == 1088 && height == 612);
+        DynamicResolutionController::RenderSize(1, 1, 0.5f, &width, &height);
+        CHECK(width == 1 && height == 1);
+    }
+}
+
+int main()
+{
+    TestUnderBudget();
+    TestSingleSpike();
+    TestOverload();
+    TestSettleFrames();
+    TestHysteresis();
+    TestRecovery();
+    TestDeterministic();
+    TestRenderSize();
+    return test::Result();
+}
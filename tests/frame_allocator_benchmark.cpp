@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------------
+//  frame_allocator_benchmark.cpp
+//  Small allocations per microsecond: malloc / free against LinearArena,
+//  std::vector against ArenaVector, and FrameAllocator scratch from jobs.
+//--------------------------------------------------------------------------------
+#include "frame_allocator.h"
+#include "job_system.h"
+#include "test_util.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kCount = 1 << 18;
+    constexpr int kRepeat = 20;
+
+    // 16 to 256 bytes, the size of typical per frame temporaries.
+    size_t SizeOf(uint32_t i)
+    {
+        return 16 + (i * 2654435761u >> 24);
+    }
+
+    void Report(const char* name, double ms, uint32_t count, uint64_t checksum)
+    {
+        printf("%-28s %8.1f allocations/us   (checksum %llu)\n", name, count / (ms * 1000.0),
+            static_cast<unsigned long long>(checksum));
+    }
+}
+
+int main()
+{
+    uint64_t checksum = 0;
+    vector<void*> pointers(kCount);
+    double ms = test::MeasureMs(kRepeat, [&]
+    {
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            pointers[i] = malloc(SizeOf(i));
+            static_cast<uint8_t*>(pointers[i])[0] = static_cast<uint8_t>(i);
+        }
+        checksum = static_cast<uint8_t*>(pointers[kCount / 3])[0];
+        for (void* p : pointers) free(p);
+    });
+    Report("malloc / free", ms, kCount, checksum);
+
+    LinearArena arena(64 << 20);
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            pointers[i] = arena.Allocate(SizeOf(i));
+            static_cast<uint8_t*>(pointers[i])[0] = static_cast<uint8_t>(i);
+        }
+        checksum = static_cast<uint8_t*>(pointers[kCount / 3])[0];
+        arena.Reset();
+    });
+    Report("LinearArena / Reset", ms, kCount, checksum);
+
+    // A short lived vector grown element by element, as in a frame's passes.
+    constexpr uint32_t kVectorCount = kCount / 64;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < kVectorCount; ++i)
+        {
+            vector<uint32_t> values;
+            for (uint32_t j = 0; j < 64; ++j) values.push_back(i + j);
+            sum += values.back();
+        }
+        checksum = sum;
+    });
+    Report("std::vector", ms, kVectorCount, checksum);
+
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < kVectorCount; ++i)
+        {
+            ArenaVector<uint32_t> values{ ArenaAllocator<uint32_t>(arena) };
+            for (uint32_t j = 0; j < 64; ++j) values.push_back(i + j);
+            sum += values.back();
+        }
+        checksum = sum;
+        arena.Reset();
+    });
+    Report("ArenaVector", ms, kVectorCount, checksum);
+
+    JobSystem::Create()->Initialize();
+    FrameAllocator::Create()->Initialize(64 << 20, 1 << 20);
+    JobSystem& job_system = JobSystem::Instance();
+    FrameAllocator& frame_allocator = FrameAllocator::Instance();
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        job_system.ParallelFor(kCount, [&pointers](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                pointers[i] = malloc(SizeOf(i));
+                static_cast<uint8_t*>(pointers[i])[0] = static_cast<uint8_t>(i);
+            }
+        }, 1024);
+        checksum = static_cast<uint8_t*>(pointers[kCount / 3])[0];
+        for (void* p : pointers) free(p);
+    });
+    Report("malloc in jobs", ms, kCount, checksum);
+
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        job_system.ParallelFor(kCount, [&pointers, &frame_allocator](uint32_t begin, uint32_t end)
+        {
+            LinearArena& scratch = frame_allocator.Scratch();
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                pointers[i] = scratch.Allocate(SizeOf(i));
+                static_cast<uint8_t*>(pointers[i])[0] = static_cast<uint8_t>(i);
+            }
+        }, 1024);
+        checksum = static_cast<uint8_t*>(pointers[kCount / 3])[0];
+        frame_allocator.EndFrame();
+    });
+    Report("FrameAllocator in jobs", ms, kCount, checksum);
+    printf("%-28s %8zu KiB\n", "scratch high water", frame_allocator.ScratchHighWater() >> 10);
+
+    frame_allocator.Release();
+    job_system.Release();
+    return 0;
+}
@@ -0,0 +1,166 @@
+//--------------------------------------------------------------------------------
+//  frame_allocator_test.cpp
+//  LinearArena alignment, overflow and reset, the double buffered lifetime,
+//  ArenaAllocator containers and the per worker arenas of FrameAllocator.
+//--------------------------------------------------------------------------------
+#include "frame_allocator.h"
+#include "job_system.h"
+#include "test_util.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    bool IsAligned(const void* pointer, size_t alignment)
+    {
+        return (reinterpret_cast<uintptr_t>(pointer) & (alignment - 1)) == 0;
+    }
+
+    void TestLinearArena()
+    {
+        LinearArena arena(1024);
+        CHECK(arena.Capacity() == 1024 && arena.Used() == 0);
+
+        bool aligned = true;
+        for (size_t alignment = 1; alignment <= 256; alignment *= 2)
+        {
+            uint8_t* p = static_cast<uint8_t*>(arena.Allocate(3, alignment));
+            aligned = aligned && IsAligned(p, alignment);
+            memset(p, 0x11, 3);
+        }
+        CHECK(aligned);
+        const size_t used = arena.Used();
+        CHECK(used > 0 && used <= 1024);
+
+        // Past the capacity the arena serves heap blocks, still aligned, and
+        // the high water mark counts them.
+        uint32_t* big = arena.AllocateArray<uint32_t>(1024);
+        CHECK(big != nullptr && IsAligned(big, alignof(uint32_t)));
+        for (uint32_t i = 0; i < 1024; ++i) big[i] = i;
+        CHECK(arena.Used() == used);
+        CHECK(arena.HighWater() >= used + 4096);
+
+        const uint32_t generation = arena.Generation();
+        arena.Reset();
+        CHECK(arena.Used() == 0 && arena.Generation() == generation + 1);
+        CHECK(arena.HighWater() >= used + 4096);
+
+        // No capacity: everything overflows.
+        LinearArena empty;
+        double* d = empty.AllocateArray<double>(16);
+        CHECK(d != nullptr && IsAligned(d, alignof(double)));
+        empty.Reset();
+    }
+
+    void TestDoubleBuffered()
+    {
+        DoubleBufferedArena arena;
+        arena.Initialize(256);
+        int* frame0 = arena.Current().AllocateArray<int>(4);
+        frame0[0] = 42;
+        LinearArena* first = &arena.Current();
+
+        // Still valid through the next frame, released at the end of it.
+        arena.Flip();
+        CHECK(&arena.Current() != first);
+        CHECK(frame0[0] == 42);
+        arena.Current().AllocateArray<int>(4);
+        arena.Flip();
+        CHECK(&arena.Current() == first);
+        CHECK(first->Used() == 0);
+    }
+
+    void TestArenaAllocator()
+    {
+        LinearArena arena(1 << 16);
+        {
+            ArenaVector<int> values{ ArenaAllocator<int>(arena) };
+            for (int i = 0; i < 1000; ++i) values.push_back(i);
+            CHECK(values.size() == 1000 && values[999] == 999);
+
+            ArenaString text{ ArenaAllocator<char>(arena) };
+            text = "a string longer than the small string buffer";
+            CHECK(text.size() == 44);
+            CHECK(ArenaAllocator<int>(arena) == ArenaAllocator<char>(arena));
+        }
+        CHECK(arena.Used() > 4000);
+        arena.Reset();
+    }
+
+    void TestWorkerArenas()
+    {
+        JobSystem::Create()->Initialize(4);
+        FrameAllocator::Create()->Initialize(1 << 12, 1 << 12);
+        FrameAllocator& frame_allocator = FrameAllocator::Instance();
+        const uint32_t worker_count = JobSystem::Instance().WorkerCount();
+
+        // Every worker writes its index in its own scratch arena; no two
+        // workers may share one.
+        vector<atomic<const LinearArena*>> arenas(worker_count);
+        for (auto& arena : arenas) arena = nullptr;
+        atomic<bool> overlap(false);
+        JobSystem::Instance().ParallelFor(1 << 14, [&](uint32_t begin, uint32_t end)
+        {
+            const uint32_t worker = JobSystem::CurrentWorker();
+            LinearArena& scratch = frame_allocator.Scratch();
+            const LinearArena* expected = nullptr;
+            if (!arenas[worker].compare_exchange_strong(expected, &scratch) && expected != &scratch) overlap = true;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                uint32_t* p = scratch.AllocateArray<uint32_t>(1);
+                *p = worker;
+                if (*p != worker) overlap = true;
+            }
+            frame_allocator.TwoFrame().AllocateArray<uint32_t>(end - begin);
+        }, 64);
+        CHECK(!overlap);
+        for (uint32_t i = 0; i < worker_count; ++i)
+        {
+            for (uint32_t j = i + 1; j < worker_count; ++j)
+            {
+                CHECK(arenas[i] == nullptr || arenas[i] != arenas[j]);
+            }
+        }
+        CHECK(frame_allocator.ScratchHighWater() > 0);
+
+        // A thread outside the JobSystem has no arenas.
+        CHECK(frame_allocator.HasArenas());
+        bool outside_has_arenas = true;
+        thread outside([&] { outside_has_arenas = frame_allocator.HasArenas(); });
+        outside.join();
+        CHECK(!outside_has_arenas);
+
+        frame_allocator.EndFrame();
+        CHECK(frame_allocator.Scratch().Used() == 0);
+
+        frame_allocator.Release();
+        JobSystem::Instance().Release();
+    }
+
+    void TestWithoutJobSystem()
+    {
+        // A single set of arenas for the main thread.
+        FrameAllocator::Create()->Initialize(256, 256);
+        FrameAllocator& frame_allocator = FrameAllocator::Instance();
+        CHECK(frame_allocator.HasArenas());
+        frame_allocator.Scratch().AllocateArray<int>(8);
+        CHECK(frame_allocator.Scratch().Used() > 0);
+        frame_allocator.EndFrame();
+        CHECK(frame_allocator.Scratch().Used() == 0);
+        frame_allocator.Release();
+        CHECK(!FrameAllocator::IsCreated());
+    }
+}
+
+int main()
+{
+    TestLinearArena();
+    TestDoubleBuffered();
+    TestArenaAllocator();
+    TestWithoutJobSystem();
+    TestWorkerArenas();
+    return test::Result();
+}
@@ -0,0 +1,167 @@
+//--------------------------------------------------------------------------------
+//  hi_z_pyramid_test.cpp
+//  HiZPyramid against brute force over the depth buffer: every texel of
+//  every level holds the min / max of the pixels it covers (odd and non
+//  square sizes included), occlusion is never reported for a box that some
+//  pixel of its rectangle could show, and box projection.
+//--------------------------------------------------------------------------------
+#include "hi_z_pyramid.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    vector<float> RandomDepth(RandomGenerator& random, uint32_t width, uint32_t height)
+    {
+        vector<float> depth(static_cast<size_t>(width) * height);
+        for (float& value : depth) value = random.NextFloat();
+        return depth;
+    }
+
+    // Min / max of the pixels of [min_x, max_x] x [min_y, max_y], { 1, 0 } when empty.
+    HiZTexel Reference(const vector<float>& depth, uint32_t width, uint32_t height,
+        uint64_t min_x, uint64_t min_y, uint64_t max_x, uint64_t max_y)
+    {
+        HiZTexel texel = { 1.0f, 0.0f };
+        for (uint64_t y = min_y; y <= max_y && y < height; ++y)
+        {
+            for (uint64_t x = min_x; x <= max_x && x < width; ++x)
+            {
+                texel.min_depth = min(texel.min_depth, depth[y * width + x]);
+                texel.max_depth = max(texel.max_depth, depth[y * width + x]);
+            }
+        }
+        return texel;
+    }
+
+    void TestLevels(uint32_t width, uint32_t height)
+    {
+        RandomGenerator random(width * 31 + height);
+        const vector<float> depth = RandomDepth(random, width, height);
+        HiZPyramid pyramid;
+        pyramid.Build(depth.data(), width, height);
+
+        CHECK(pyramid.LevelCount() == HiZPyramid::LevelCount(width, height));
+        const uint32_t last = pyramid.LevelCount() - 1;
+        CHECK(pyramid.LevelWidth(last) == 1 && pyramid.LevelHeight(last) == 1);
+        CHECK(pyramid.LevelWidth(0) >= (width + 1) / 2 && pyramid.LevelHeight(0) >= (height + 1) / 2);
+
+        // Texel (x, y) of level n covers pixels [x << (n+1), (x+1) << (n+1)).
+        bool equal = true;
+        for (uint32_t level = 0; level < pyramid.LevelCount(); ++level)
+        {
+            const HiZTexel* texels = pyramid.Level(level);
+            for (uint32_t y = 0; y < pyramid.LevelHeight(level); ++y)
+            {
+                for (uint32_t x = 0; x < pyramid.LevelWidth(level); ++x)
+                {
+                    const uint64_t shift = level + 1;
+                    const HiZTexel expected = Reference(depth, width, height,
+                        uint64_t(x) << shift, uint64_t(y) << shift, ((uint64_t(x) + 1) << shift) - 1, ((uint64_t(y) + 1) << shift) - 1);
+                    const HiZTexel& texel = texels[static_cast<size_t>(y) * pyramid.LevelWidth(level) + x];
+                    equal = equal && texel.min_depth == expected.min_depth && texel.max_depth == expected.max_depth;
+                }
+            }
+        }
+        CHECK(equal);
+    }
+
+    void TestOcclusion(uint32_t width, uint32_t height)
+    {
+        RandomGenerator random(width + height * 17);
+        vector<float> depth = RandomDepth(random, width, height);
+
+        // A near wall over the left half, so that some boxes are occluded.
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width / 2; ++x) depth[static_cast<size_t>(y) * width + x] *= 0.1f;
+        }
+        HiZPyramid pyramid;
+        pyramid.Build(depth.data(), width, height);
+
+        uint32_t occluded = 0;
+        bool conservative = true;
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            HiZRect rect;
+            rect.min_x = random.NextInt(0, width - 1);
+            rect.min_y = random.NextInt(0, height - 1);
+            rect.max_x = min<uint32_t>(rect.min_x + random.NextInt(0, i % 4 == 0 ? width : 16), width - 1);
+            rect.max_y = min<uint32_t>(rect.min_y + random.NextInt(0, i % 4 == 0 ? height : 16), height - 1);
+            rect.min_depth = random.NextFloat(0.0f, 0.2f);
+            if (!pyramid.IsOccluded(rect)) continue;
+
+            const HiZTexel visible = Reference(depth, width, height, rect.min_x, rect.min_y, rect.max_x, rect.max_y);
+            conservative = conservative && rect.min_depth > visible.max_depth;
+            ++occluded;
+        }
+        CHECK(conservative);
+        CHECK(occluded > 1000);
+
+        // Behind a constant depth everything is occluded, in front nothing.
+        fill(depth.begin(), depth.end(), 0.5f);
+        pyramid.Build(depth.data(), width, height);
+        bool exact = true;
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            HiZRect rect;
+            rect.min_x = random.NextInt(0, width - 1);
+            rect.min_y = random.NextInt(0, height - 1);
+            rect.max_x = random.NextInt(rect.min_x, width - 1);
+            rect.max_y = random.NextInt(rect.min_y, height - 1);
+            rect.min_depth = 0.5001f;
+            exact = exact && pyramid.IsOccluded(rect);
+            rect.min_depth = 0.5f;
+            exact = exact && !pyramid.IsOccluded(rect);
+        }
+        CHECK(exact);
+    }
+
+    void TestProjectBox()
+    {
+        // Orthographic: x, y in [-1, 1] map to the screen, z is the depth.
+        const float view_proj[16] =
+        {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f,
+        };
+        const float center[3] = { 0.0f, 0.5f, 0.5f };
+        const float extents[3] = { 0.5f, 0.25f, 0.25f };
+        HiZRect rect;
+        CHECK(HiZPyramid::ProjectBox(view_proj, center, extents, 200, 100, &rect));
+        CHECK(rect.min_x == 50 && rect.max_x == 150 && rect.min_y == 12 && rect.max_y == 37);
+        CHECK(rect.min_depth == 0.25f);
+
+        // Clamped to the screen; off screen boxes are not tested.
+        const float wide[3] = { 5.0f, 5.0f, 0.25f };
+        CHECK(HiZPyramid::ProjectBox(view_proj, center, wide, 200, 100, &rect));
+        CHECK(rect.min_x == 0 && rect.max_x == 199 && rect.min_y == 0 && rect.max_y == 99);
+        const float off_screen[3] = { 3.0f, 0.0f, 0.5f };
+        CHECK(!HiZPyramid::ProjectBox(view_proj, off_screen, extents, 200, 100, &rect));
+
+        // Perspective (w = z): a box crossing w = 0 is not tested.
+        float perspective[16] = {};
+        perspective[0] = perspective[5] = perspective[10] = perspective[11] = 1.0f;
+        const float near_center[3] = { 0.0f, 0.0f, 0.1f };
+        CHECK(!HiZPyramid::ProjectBox(perspective, near_center, extents, 200, 100, &rect));
+        const float far_center[3] = { 0.0f, 0.0f, 4.0f };
+        CHECK(HiZPyramid::ProjectBox(perspective, far_center, extents, 200, 100, &rect));
+        CHECK(rect.min_x < 100 && rect.max_x > 100 && rect.min_depth == 1.0f);
+    }
+}
+
+int main()
+{
+    const uint32_t sizes[][2] = { { 1, 1 }, { 2, 2 }, { 3, 5 }, { 64, 64 }, { 37, 300 }, { 641, 359 }, { 1280, 720 } };
+    for (const auto& size : sizes) TestLevels(size[0], size[1]);
+    TestOcclusion(640, 360);
+    TestOcclusion(333, 97);
+    TestProjectBox();
+    return test::Result();
+}
@@ -0,0 +1,191 @@
+//--------------------------------------------------------------------------------
+//  indirect_draw_test.cpp
+//  Layout and CPU reference cull + compaction of IndirectDrawLayout: the
+//  commands must draw exactly the instances CullingSystem keeps, grouped like
+//  the DrawBatcher batches, with and without a Hi-Z pyramid.
+//--------------------------------------------------------------------------------
+#include "indirect_draw.h"
+#include "culling_system.h"
+#include "hi_z_pyramid.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kSubmeshCount = 24;
+    constexpr uint32_t kSubmeshesPerMesh = 4;
+    constexpr uint32_t kPsoCount = 3;
+    constexpr uint32_t kInstanceCount = 20000;
+
+    struct Scene
+    {
+        DrawBatcher batcher;
+        IndirectDrawLayout layout;
+        vector<uint32_t> psos, submeshes;
+        vector<BoundingBox> bounds;
+    };
+
+    void MakeScene(Scene& scene)
+    {
+        for (uint32_t i = 0; i < kSubmeshCount; ++i)
+        {
+            SubmeshRange range;
+            range.mesh = i / kSubmeshesPerMesh;
+            range.index_count = 6 * (i + 1);
+            range.start_index = 1000 * i;
+            range.base_vertex = 10 * static_cast<int32_t>(i);
+            scene.batcher.RegisterSubmesh(range);
+        }
+
+        RandomGenerator random(12);
+        for (uint32_t i = 0; i < kInstanceCount; ++i)
+        {
+            scene.psos.push_back(random.NextInt(0, kPsoCount - 1));
+            scene.submeshes.push_back(random.NextInt(0, kSubmeshCount - 1));
+            scene.bounds.push_back(BoundingBox(
+                XMFLOAT3(random.NextFloat(-200.0f, 200.0f), random.NextFloat(-5.0f, 5.0f), random.NextFloat(-200.0f, 200.0f)),
+                XMFLOAT3(random.NextFloat(0.2f, 2.0f), random.NextFloat(0.2f, 2.0f), random.NextFloat(0.2f, 2.0f))));
+            // instance_data_index i identifies the instance.
+            scene.layout.AddInstance(scene.psos[i], scene.submeshes[i], scene.bounds[i], i);
+        }
+        scene.layout.Build(scene.batcher);
+    }
+
+    void TestLayout(const Scene& scene)
+    {
+        const vector<IndirectInstance>& instances = scene.layout.Instances();
+        const vector<IndirectDrawGroup>& groups = scene.layout.Groups();
+        const vector<IndirectDrawBucket>& buckets = scene.layout.Buckets();
+        CHECK(instances.size() == kInstanceCount);
+
+        // Buckets are distinct (pso, mesh) pairs tiling the groups.
+        set<pair<uint32_t, uint32_t>> bucket_keys;
+        uint32_t next_group = 0;
+        for (const IndirectDrawBucket& bucket : buckets)
+        {
+            CHECK(bucket_keys.insert(make_pair(bucket.pso, bucket.mesh)).second);
+            CHECK(bucket.first_group == next_group && bucket.group_count > 0);
+            next_group += bucket.group_count;
+        }
+        CHECK(next_group == groups.size());
+
+        // Every instance sits in its group's range with the right submesh.
+        vector<uint32_t> group_sizes(groups.size(), 0);
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            const IndirectInstance& instance = instances[i];
+            const uint32_t source = instance.InstanceDataIndex;
+            const IndirectDrawGroup& group = groups[instance.Group];
+            const SubmeshRange& range = scene.batcher.Submesh(scene.submeshes[source]);
+            CHECK(group.IndexCount == range.index_count && group.StartIndex == range.start_index && group.BaseVertex == range.base_vertex);
+            CHECK(buckets[group.Bucket].pso == scene.psos[source] && buckets[group.Bucket].mesh == range.mesh);
+            CHECK(group.FirstVisible + group_sizes[instance.Group] == i);
+            ++group_sizes[instance.Group];
+        }
+    }
+
+    // (pso, submesh) -> sorted instances, from the commands of CullAndCompact.
+    map<pair<uint32_t, uint32_t>, vector<uint32_t>> Draws(const Scene& scene, const XMFLOAT4 planes[6],
+        const HiZPyramid* hi_z, const XMFLOAT4X4* hi_z_view_proj)
+    {
+        vector<uint32_t> group_counts, visible, bucket_counts;
+        vector<IndirectDrawCommand> commands;
+        scene.layout.CullAndCompact(planes, group_counts, visible, commands, bucket_counts, hi_z, hi_z_view_proj);
+
+        const vector<IndirectDrawBucket>& buckets = scene.layout.Buckets();
+        CHECK(bucket_counts.size() == buckets.size());
+        map<pair<uint32_t, uint32_t>, vector<uint32_t>> draws;
+        for (size_t b = 0; b < buckets.size(); ++b)
+        {
+            // ExecuteIndirect reads bucket_counts[b] commands from first_group.
+            CHECK(bucket_counts[b] <= buckets[b].group_count);
+            for (uint32_t c = 0; c < bucket_counts[b]; ++c)
+            {
+                const IndirectDrawCommand& command = commands[buckets[b].first_group + c];
+                CHECK(command.Draw.InstanceCount > 0 && command.Draw.StartInstanceLocation == 0);
+                vector<uint32_t> drawn(visible.begin() + command.InstanceBase, visible.begin() + command.InstanceBase + command.Draw.InstanceCount);
+                const uint32_t source = drawn[0];
+                const uint32_t key_pso = scene.psos[source], key_submesh = scene.submeshes[source];
+                CHECK(key_pso == buckets[b].pso);
+                CHECK(command.Draw.IndexCountPerInstance == scene.batcher.Submesh(key_submesh).index_count);
+                for (uint32_t index : drawn) CHECK(scene.psos[index] == key_pso && scene.submeshes[index] == key_submesh);
+                sort(drawn.begin(), drawn.end());
+                vector<uint32_t>& list = draws[make_pair(key_pso, key_submesh)];
+                CHECK(list.empty());    // one command per group
+                list = drawn;
+            }
+        }
+        return draws;
+    }
+
+    map<pair<uint32_t, uint32_t>, vector<uint32_t>> Expected(const Scene& scene, const XMFLOAT4 planes[6])
+    {
+        map<pair<uint32_t, uint32_t>, vector<uint32_t>> draws;
+        for (uint32_t i = 0; i < kInstanceCount; ++i)
+        {
+            if (CullingSystem::IsBoxVisible(planes, scene.bounds[i])) draws[make_pair(scene.psos[i], scene.submeshes[i])].push_back(i);
+        }
+        return draws;
+    }
+
+    void TestCullAndCompact(const Scene& scene)
+    {
+        const XMMATRIX view_proj = XMMatrixMultiply(
+            XMMatrixLookAtLH(XMVectorSet(0.0f, 3.0f, -150.0f, 1.0f), XMVectorSet(20.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+            XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.5f, 400.0f));
+        XMFLOAT4 planes[6];
+        CullingSystem::ExtractFrustumPlanes(view_proj, planes);
+        XMFLOAT4X4 hi_z_view_proj;
+        XMStoreFloat4x4(&hi_z_view_proj, view_proj);
+
+        const auto expected = Expected(scene, planes);
+        CHECK(!expected.empty());
+        CHECK(Draws(scene, planes, nullptr, nullptr) == expected);
+
+        // A far depth buffer occludes nothing; an empty pyramid is ignored.
+        const uint32_t width = 160, height = 90;
+        vector<float> depth(width * height, 1.0f);
+        HiZPyramid hi_z;
+        CHECK(Draws(scene, planes, &hi_z, &hi_z_view_proj) == expected);
+        hi_z.Build(depth.data(), width, height);
+        CHECK(Draws(scene, planes, &hi_z, &hi_z_view_proj) == expected);
+
+        // A wall right in front of the camera occludes every instance the
+        // pyramid can test; the others stay visible.
+        fill(depth.begin(), depth.end(), 0.0f);
+        hi_z.Build(depth.data(), width, height);
+        auto occluded = Draws(scene, planes, &hi_z, &hi_z_view_proj);
+        size_t drawn = 0;
+        for (auto& draw : occluded)
+        {
+            const vector<uint32_t>& all = expected.at(draw.first);
+            for (uint32_t index : draw.second)
+            {
+                HiZRect rect;
+                CHECK(binary_search(all.begin(), all.end(), index));
+                CHECK(!HiZPyramid::ProjectBox(&hi_z_view_proj.m[0][0], &scene.bounds[index].Center.x, &scene.bounds[index].Extents.x, width, height, &rect));
+                ++drawn;
+            }
+        }
+        size_t expected_count = 0;
+        for (auto& draw : expected) expected_count += draw.second.size();
+        CHECK(drawn < expected_count);
+    }
+}
+
+int main()
+{
+    Scene scene;
+    MakeScene(scene);
+    TestLayout(scene);
+    TestCullAndCompact(scene);
+    return test::Result();
+}
@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------
+//  job_system_benchmark.cpp
+//  Scheduling overhead of JobSystem: empty jobs per microsecond (Run + Wait)
+//  against a thread per task, and ParallelFor against a serial loop.
+//--------------------------------------------------------------------------------
+#include "job_system.h"
+#include "test_util.h"
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr int kJobCount = 100000;
+    constexpr int kRepeat = 10;
+}
+
+int main()
+{
+    JobSystem::Create()->Initialize();
+    JobSystem& jobs = JobSystem::Instance();
+    printf("%u workers\n", jobs.WorkerCount());
+
+    atomic<int> sum{ 0 };
+    double ms = test::MeasureMs(kRepeat, [&jobs, &sum]
+    {
+        JobCounter counter;
+        for (int i = 0; i < kJobCount; ++i) jobs.Run([&sum] { sum.fetch_add(1, memory_order_relaxed); }, &counter);
+        jobs.Wait(counter);
+    });
+    printf("%-28s %9.2f jobs/us   (%.1f ns per job)\n", "Run + Wait", kJobCount / (ms * 1000.0), ms * 1e6 / kJobCount);
+
+    // Submitted from a thread that is not a worker (shared queue).
+    ms = test::MeasureMs(kRepeat, [&jobs, &sum]
+    {
+        async(launch::async, [&jobs, &sum]
+        {
+            JobCounter counter;
+            for (int i = 0; i < kJobCount; ++i) jobs.Run([&sum] { sum.fetch_add(1, memory_order_relaxed); }, &counter);
+            jobs.Wait(counter);
+        }).wait();
+    });
+    printf("%-28s %9.2f jobs/us   (%.1f ns per job)\n", "Run + Wait, outside thread", kJobCount / (ms * 1000.0), ms * 1e6 / kJobCount);
+
+    const int async_count = 1000;
+    ms = test::MeasureMs(kRepeat, [&sum]
+    {
+        vector<future<void>> futures;
+        for (int i = 0; i < async_count; ++i) futures.push_back(async(launch::async, [&sum] { sum.fetch_add(1, memory_order_relaxed); }));
+        for (auto& f : futures) f.wait();
+    });
+    printf("%-28s %9.2f jobs/us   (%.1f ns per job)\n", "std::async per task", async_count / (ms * 1000.0), ms * 1e6 / async_count);
+
+    // A light loop body where the split overhead shows.
+    const size_t count = 1 << 22;
+    vector<float> values(count, 1.0f);
+    ms = test::MeasureMs(kRepeat, [&values]
+    {
+        for (float& v : values) v = sqrtf(v * 1.0001f + 0.5f);
+    });
+    printf("%-28s %9.3f ms\n", "serial loop", ms);
+
+    const size_t min_chunks[] = { 1, 1024, 16384 };
+    for (size_t min_chunk : min_chunks)
+    {
+        ms = test::MeasureMs(kRepeat, [&jobs, &values, min_chunk]
+        {
+            jobs.ParallelFor(values.size(), [&values](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i) values[i] = sqrtf(values[i] * 1.0001f + 0.5f);
+            }, min_chunk);
+        });
+        printf("ParallelFor min_chunk %-6zu %9.3f ms\n", min_chunk, ms);
+    }
+    printf("(checksum %d %.3f)\n", sum.load(), values[count / 2]);
+
+    jobs.Release();
+    return 0;
+}
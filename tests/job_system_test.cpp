@@ -0,0 +1,209 @@
+//--------------------------------------------------------------------------------
+//  job_system_test.cpp
+//  Work stealing stress test of JobSystem: more jobs than the deques and pools
+//  hold, nested jobs and ParallelFor, submission from outside threads,
+//  oversized callables and main thread jobs.  Also run under ThreadSanitizer
+//  (SANITIZER=thread).
+//--------------------------------------------------------------------------------
+#include "job_system.h"
+#include "test_util.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kWorkerCount = 4;
+
+    void TestManyJobs()
+    {
+        // Several times kDequeCapacity / kJobPoolSize from one worker.
+        JobSystem& jobs = JobSystem::Instance();
+        const int job_count = 100000;
+        atomic<int> sum{ 0 };
+        JobCounter counter;
+        for (int i = 0; i < job_count; ++i)
+        {
+            jobs.Run([&sum, i] { sum.fetch_add(i & 7, memory_order_relaxed); }, &counter);
+        }
+        jobs.Wait(counter);
+        CHECK(counter.IsDone());
+        int expected = 0;
+        for (int i = 0; i < job_count; ++i) expected += i & 7;
+        CHECK(sum.load() == expected);
+    }
+
+    // Each job spawns its children and waits for them, so waiting workers
+    // keep stealing.
+    void Tree(int depth, atomic<int>& leaves)
+    {
+        if (depth == 0)
+        {
+            leaves.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        JobCounter counter;
+        for (int i = 0; i < 4; ++i) JobSystem::Instance().Run([depth, &leaves] { Tree(depth - 1, leaves); }, &counter);
+        JobSystem::Instance().Wait(counter);
+    }
+
+    void TestNested()
+    {
+        atomic<int> leaves{ 0 };
+        Tree(7, leaves);
+        CHECK(leaves.load() == 4 * 4 * 4 * 4 * 4 * 4 * 4);
+    }
+
+    void TestParallelFor()
+    {
+        JobSystem& jobs = JobSystem::Instance();
+        const size_t counts[] = { 0, 1, 7, 1000, 100003 };
+        const size_t min_chunks[] = { 1, 64, 1 << 20 };
+        for (size_t count : counts)
+        {
+            for (size_t min_chunk : min_chunks)
+            {
+                // Every index exactly once.
+                vector<atomic<int>> hits(count);
+                for (auto& hit : hits) hit.store(0);
+                jobs.ParallelFor(count, [&hits](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i) hits[i].fetch_add(1, memory_order_relaxed);
+                }, min_chunk);
+                bool once = true;
+                for (auto& hit : hits) once = once && hit.load() == 1;
+                CHECK(once);
+            }
+        }
+
+        // ParallelFor inside ParallelFor.
+        atomic<long long> sum{ 0 };
+        jobs.ParallelFor(64, [&jobs, &sum](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                jobs.ParallelFor(1000, [&sum, i](size_t b, size_t e)
+                {
+                    long long local = 0;
+                    for (size_t j = b; j < e; ++j) local += static_cast<long long>(i * j);
+                    sum.fetch_add(local, memory_order_relaxed);
+                });
+            }
+        });
+        CHECK(sum.load() == 2016LL * 499500LL);     // sum(0..63) * sum(0..999)
+    }
+
+    void TestStealing()
+    {
+        // Jobs that block: idle workers must steal them from worker 0.
+        JobSystem& jobs = JobSystem::Instance();
+        array<atomic<int>, JobSystem::kMaxWorkers> ran_on = {};
+        JobCounter counter;
+        for (int i = 0; i < 64; ++i)
+        {
+            jobs.Run([&ran_on]
+            {
+                ran_on[JobSystem::CurrentWorker()].fetch_add(1);
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }, &counter);
+        }
+        jobs.Wait(counter);
+        int busy_workers = 0, total = 0;
+        for (uint32_t i = 0; i < kWorkerCount; ++i)
+        {
+            busy_workers += ran_on[i].load() > 0;
+            total += ran_on[i].load();
+        }
+        CHECK(total == 64);
+        CHECK(busy_workers > 1);
+    }
+
+    void TestOutsideThreads()
+    {
+        // Non worker threads submit through the shared queue and wait on it.
+        JobSystem& jobs = JobSystem::Instance();
+        atomic<int> sum{ 0 };
+        vector<thread> threads;
+        for (int t = 0; t < 3; ++t)
+        {
+            threads.emplace_back([&jobs, &sum]
+            {
+                CHECK(JobSystem::CurrentWorker() == JobSystem::kNotWorker);
+                JobCounter counter;
+                for (int i = 0; i < 2000; ++i) jobs.Run([&sum] { sum.fetch_add(1, memory_order_relaxed); }, &counter);
+                jobs.Wait(counter);
+            });
+        }
+        // Worker 0 helps meanwhile.
+        JobCounter local;
+        for (int i = 0; i < 2000; ++i) jobs.Run([&sum] { sum.fetch_add(1, memory_order_relaxed); }, &local);
+        jobs.Wait(local);
+        for (thread& t : threads) t.join();
+        CHECK(sum.load() == 4 * 2000);
+    }
+
+    void TestLargeCallable()
+    {
+        // Bigger than kJobStorage: stored on the heap.
+        JobSystem& jobs = JobSystem::Instance();
+        array<int, 64> payload;
+        for (int i = 0; i < 64; ++i) payload[i] = i;
+        atomic<int> sum{ 0 };
+        JobCounter counter;
+        for (int i = 0; i < 100; ++i)
+        {
+            jobs.Run([payload, &sum] { int s = 0; for (int v : payload) s += v; sum.fetch_add(s); }, &counter);
+        }
+        jobs.Wait(counter);
+        CHECK(sum.load() == 100 * 2016);
+    }
+
+    void TestMainThreadJobs()
+    {
+        JobSystem& jobs = JobSystem::Instance();
+        atomic<int> wrong_thread{ 0 }, ran{ 0 };
+        JobCounter counter;
+        // Queued from other workers; they only run on worker 0.
+        jobs.ParallelFor(100, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                jobs.RunOnMainThread([&]
+                {
+                    wrong_thread += JobSystem::CurrentWorker() != 0;
+                    ++ran;
+                }, &counter);
+            }
+        });
+        jobs.RunMainThreadJobs();
+        jobs.Wait(counter);
+        CHECK(ran.load() == 100);
+        CHECK(wrong_thread.load() == 0);
+    }
+}
+
+int main()
+{
+    // Restarting leaves nothing behind.
+    for (int round = 0; round < 3; ++round)
+    {
+        JobSystem::Create()->Initialize(kWorkerCount);
+        CHECK(JobSystem::Instance().WorkerCount() == kWorkerCount);
+        CHECK(JobSystem::CurrentWorker() == 0);
+        TestManyJobs();
+        TestNested();
+        TestParallelFor();
+        TestStealing();
+        TestOutsideThreads();
+        TestLargeCallable();
+        TestMainThreadJobs();
+        JobSystem::Instance().Release();
+        CHECK(!JobSystem::IsCreated());
+        CHECK(JobSystem::CurrentWorker() == JobSystem::kNotWorker);
+    }
+    return test::Result();
+}
@@ -0,0 +1,106 @@
+//--------------------------------------------------------------------------------
+//  light_cluster_grid_benchmark.cpp
+//  Milliseconds per LightClusterGrid::Build at 1920 x 1080 for 1k and 10k
+//  lights (2/3 point, 1/3 spot), serial and on the JobSystem, against a
+//  brute force pass testing every point light sphere against every cluster
+//  box.
+//--------------------------------------------------------------------------------
+#include "light_cluster_grid.h"
+#include "d3dUtil.h"
+#include "job_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kWidth = 1920;
+    constexpr uint32_t kHeight = 1080;
+    constexpr float kNearZ = 0.1f;
+    constexpr float kFarZ = 500.0f;
+    constexpr int kRepeat = 20;
+
+    vector<Light> MakeLights(uint32_t count)
+    {
+        RandomGenerator random(10);
+        vector<Light> lights(count);
+        for (Light& light : lights)
+        {
+            light.Position = XMFLOAT3(random.NextFloat(-250.0f, 250.0f), random.NextFloat(-20.0f, 40.0f), random.NextFloat(-50.0f, 450.0f));
+            light.FalloffEnd = random.NextFloat(1.0f, 12.0f);
+            XMStoreFloat3(&light.Direction, XMVector3Normalize(XMVectorSet(
+                random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), 0.0f)));
+            light.SpotPower = random.NextFloat(2.0f, 64.0f);
+        }
+        return lights;
+    }
+
+    // The entry count doubles as the checksum.
+    void Report(const char* name, size_t light_count, double ms, size_t entry_count, size_t cluster_count)
+    {
+        printf("%-24s %6zu lights %9.3f ms   %5.2f lights/cluster   (checksum %zu)\n", name, light_count, ms,
+            static_cast<double>(entry_count) / cluster_count, entry_count);
+    }
+
+    void Measure(const LightClusterGrid& prototype, FXMMATRIX view, const vector<Light>& lights)
+    {
+        LightClusterGrid grid = prototype;
+        const uint32_t point_count = static_cast<uint32_t>(lights.size() * 2 / 3);
+        const uint32_t spot_count = static_cast<uint32_t>(lights.size()) - point_count;
+        const double ms = test::MeasureMs(kRepeat, [&] { grid.Build(view, lights.data(), point_count, spot_count); });
+        Report(JobSystem::IsCreated() ? "Build (jobs)" : "Build", lights.size(), ms, grid.LightIndices().size(), grid.Clusters().size());
+    }
+
+    void MeasureBruteForce(const LightClusterGrid& grid, FXMMATRIX view, const vector<Light>& lights)
+    {
+        const uint32_t cluster_count = static_cast<uint32_t>(grid.Clusters().size());
+        vector<XMFLOAT3> lower(cluster_count), upper(cluster_count);
+        for (uint32_t i = 0; i < cluster_count; ++i) grid.ClusterBounds(i, &lower[i], &upper[i]);
+
+        size_t hits = 0;
+        const double ms = test::MeasureMs(1, [&]
+        {
+            hits = 0;
+            for (const Light& light : lights)
+            {
+                XMFLOAT3 c;
+                XMStoreFloat3(&c, XMVector3Transform(XMLoadFloat3(&light.Position), view));
+                const float radius_sq = light.FalloffEnd * light.FalloffEnd;
+                for (uint32_t i = 0; i < cluster_count; ++i)
+                {
+                    const float dx = max(max(lower[i].x - c.x, c.x - upper[i].x), 0.0f);
+                    const float dy = max(max(lower[i].y - c.y, c.y - upper[i].y), 0.0f);
+                    const float dz = max(max(lower[i].z - c.z, c.z - upper[i].z), 0.0f);
+                    hits += dx * dx + dy * dy + dz * dz <= radius_sq;
+                }
+            }
+        });
+        Report("brute force (spheres)", lights.size(), ms, hits, cluster_count);
+    }
+}
+
+int main()
+{
+    XMFLOAT4X4 proj;
+    XMStoreFloat4x4(&proj, XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(kWidth) / kHeight, kNearZ, kFarZ));
+    const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -20.0f, 1.0f),
+        XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    LightClusterGrid grid;
+    grid.SetProjection(proj, kNearZ, kFarZ, kWidth, kHeight);
+    const vector<Light> lights_1k = MakeLights(1000);
+    const vector<Light> lights_10k = MakeLights(10000);
+
+    Measure(grid, view, lights_1k);
+    Measure(grid, view, lights_10k);
+    MeasureBruteForce(grid, view, lights_10k);
+
+    JobSystem::Create()->Initialize();
+    Measure(grid, view, lights_1k);
+    Measure(grid, view, lights_10k);
+    JobSystem::Instance().Release();
+    return 0;
+}
@@ -0,0 +1,343 @@
+//--------------------------------------------------------------------------------
+//  light_cluster_grid_test.cpp
+//  LightClusterGrid against brute force: every light against every cluster
+//  box in double precision (spheres exactly, cones within their sphere),
+//  points sampled inside each sphere and cone must find their light in the
+//  cluster the shader would look up, serial and on the JobSystem (Windows
+//  only: Light comes from d3dUtil.h).
+//--------------------------------------------------------------------------------
+#include "light_cluster_grid.h"
+#include "d3dUtil.h"
+#include "job_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kWidth = 1280;
+    constexpr uint32_t kHeight = 720;
+    constexpr float kNearZ = 0.1f;
+    constexpr float kFarZ = 300.0f;
+
+    struct Scene
+    {
+        XMFLOAT4X4 proj;
+        XMFLOAT4X4 view;
+        vector<Light> lights;
+        uint32_t point_count = 0;
+        uint32_t spot_count = 0;
+    };
+
+    Scene MakeScene(uint32_t point_count, uint32_t spot_count, uint64_t seed)
+    {
+        Scene scene;
+        XMStoreFloat4x4(&scene.proj, XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(kWidth) / kHeight, kNearZ, kFarZ));
+        XMStoreFloat4x4(&scene.view, XMMatrixLookAtLH(XMVectorSet(3.0f, 10.0f, -20.0f, 1.0f),
+            XMVectorSet(0.0f, 0.0f, 50.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+        RandomGenerator random(seed);
+        scene.point_count = point_count;
+        scene.spot_count = spot_count;
+        scene.lights.resize(point_count + spot_count);
+        for (Light& light : scene.lights)
+        {
+            light.Position = XMFLOAT3(random.NextFloat(-150.0f, 150.0f), random.NextFloat(-20.0f, 30.0f), random.NextFloat(-40.0f, 280.0f));
+            light.FalloffEnd = 0.5f + 25.0f * random.NextFloat() * random.NextFloat();
+            XMStoreFloat3(&light.Direction, XMVector3Normalize(XMVectorSet(
+                random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), 0.0f)));
+            light.SpotPower = random.NextFloat(1.0f, 200.0f);
+        }
+        return scene;
+    }
+
+    vector<uint32_t> ClusterLights(const LightClusterGrid& grid, uint32_t cluster)
+    {
+        const LightCluster& entry = grid.Clusters()[cluster];
+        const auto begin = grid.LightIndices().begin() + entry.offset;
+        return vector<uint32_t>(begin, begin + entry.point_count + entry.spot_count);
+    }
+
+    XMFLOAT3 ToView(const Scene& scene, const XMFLOAT3& position)
+    {
+        XMFLOAT3 view;
+        XMStoreFloat3(&view, XMVector3Transform(XMLoadFloat3(&position), XMLoadFloat4x4(&scene.view)));
+        return view;
+    }
+
+    // Squared distance from the sphere center to the cluster box, relative
+    // to the squared radius: < 1 intersects, > 1 misses.
+    double SphereBoxRatio(const LightClusterGrid& grid, uint32_t cluster, const XMFLOAT3& center, float radius)
+    {
+        XMFLOAT3 lower, upper;
+        grid.ClusterBounds(cluster, &lower, &upper);
+        auto axis = [](double c, double a, double b) { return c < a ? a - c : (c > b ? c - b : 0.0); };
+        const double dx = axis(center.x, lower.x, upper.x);
+        const double dy = axis(center.y, lower.y, upper.y);
+        const double dz = axis(center.z, lower.z, upper.z);
+        return (dx * dx + dy * dy + dz * dz) / (double(radius) * radius);
+    }
+
+    // Distance from a view space point to the froxel itself (the tile's
+    // frustum between the slice depths, not its box), by Dykstra's
+    // alternating projections onto its 6 half spaces n.p <= d.
+    double FroxelDistance(const LightClusterGrid& grid, const Scene& scene, uint32_t cluster, const XMFLOAT3& point)
+    {
+        const uint32_t x = cluster % grid.GridWidth();
+        const uint32_t y = cluster / grid.GridWidth() % grid.GridHeight();
+        const uint32_t slice = cluster / grid.GridWidth() / grid.GridHeight();
+        const double m00 = scene.proj.m[0][0], m11 = scene.proj.m[1][1];
+        const double m20 = scene.proj.m[2][0], m21 = scene.proj.m[2][1];
+        const double ndc_x0 = 2.0 * (x * LightClusterGrid::kTileSize) / kWidth - 1.0;
+        const double ndc_x1 = 2.0 * min((x + 1) * LightClusterGrid::kTileSize, kWidth) / kWidth - 1.0;
+        const double ndc_y0 = 1.0 - 2.0 * min((y + 1) * LightClusterGrid::kTileSize, kHeight) / kHeight;
+        const double ndc_y1 = 1.0 - 2.0 * (y * LightClusterGrid::kTileSize) / kHeight;
+        const double z0 = kNearZ * pow(double(kFarZ) / kNearZ, double(slice) / LightClusterGrid::kSliceCount);
+        const double z1 = kNearZ * pow(double(kFarZ) / kNearZ, double(slice + 1) / LightClusterGrid::kSliceCount);
+
+        // ndc = v.x * m00 / z + m20, so ndc >= a is -m00 x + (a - m20) z <= 0.
+        const double planes[6][4] =
+        {
+            { -m00, 0.0, ndc_x0 - m20, 0.0 },
+            { m00, 0.0, m20 - ndc_x1, 0.0 },
+            { 0.0, -m11, ndc_y0 - m21, 0.0 },
+            { 0.0, m11, m21 - ndc_y1, 0.0 },
+            { 0.0, 0.0, -1.0, -z0 },
+            { 0.0, 0.0, 1.0, z1 },
+        };
+        double p[3] = { point.x, point.y, point.z };
+        double increment[6][3] = {};
+        for (int sweep = 0; sweep < 2000; ++sweep)
+        {
+            for (int k = 0; k < 6; ++k)
+            {
+                const double* n = planes[k];
+                const double q[3] = { p[0] + increment[k][0], p[1] + increment[k][1], p[2] + increment[k][2] };
+                const double excess = max(n[0] * q[0] + n[1] * q[1] + n[2] * q[2] - n[3], 0.0) / (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (int j = 0; j < 3; ++j)
+                {
+                    p[j] = q[j] - excess * n[j];
+                    increment[k][j] = q[j] - p[j];
+                }
+            }
+        }
+        const double dx = p[0] - point.x, dy = p[1] - point.y, dz = p[2] - point.z;
+        return sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    void TestBruteForce(const Scene& scene)
+    {
+        LightClusterGrid grid;
+        grid.SetProjection(scene.proj, kNearZ, kFarZ, kWidth, kHeight);
+        const XMMATRIX view = XMLoadFloat4x4(&scene.view);
+        grid.Build(view, scene.lights.data(), scene.point_count, scene.spot_count);
+
+        const uint32_t cluster_count = static_cast<uint32_t>(grid.Clusters().size());
+        CHECK(cluster_count == grid.GridWidth() * grid.GridHeight() * LightClusterGrid::kSliceCount);
+        uint32_t missed = 0;
+        uint32_t outside_box = 0;
+        uint32_t order_errors = 0;
+        uint32_t scalar_mismatches = 0;
+        size_t point_entries = 0, spot_entries = 0, spot_box_entries = 0;
+        for (uint32_t cluster = 0; cluster < cluster_count; ++cluster)
+        {
+            const vector<uint32_t> lights = ClusterLights(grid, cluster);
+            const LightCluster& entry = grid.Clusters()[cluster];
+            for (uint32_t k = 0; k < lights.size(); ++k)
+            {
+                const bool listed_as_point = k < entry.point_count;
+                if (listed_as_point != (lights[k] < scene.point_count)) ++order_errors;
+                if (k > 0 && lights[k] <= lights[k - 1]) ++order_errors;
+            }
+
+            for (uint32_t i = 0; i < scene.lights.size(); ++i)
+            {
+                const Light& light = scene.lights[i];
+                const bool spot = i >= scene.point_count;
+                const XMFLOAT3 center = ToView(scene, light.Position);
+                const double ratio = SphereBoxRatio(grid, cluster, center, light.FalloffEnd);
+                const bool listed = binary_search(lights.begin(), lights.end(), i);
+                if (listed != grid.IntersectsCluster(view, light, spot, cluster)) ++scalar_mismatches;
+
+                // Never looser than the box, for spheres and cones alike.
+                if (listed && ratio > 1.0 + 1e-4) ++outside_box;
+                if (spot)
+                {
+                    spot_entries += listed;
+                    spot_box_entries += ratio < 1.0;
+                    continue;
+                }
+
+                // Every froxel a sphere reaches (the box contains the froxel,
+                // so only those within the box need the exact distance).
+                point_entries += listed;
+                if (!listed && ratio < 1.0 && FroxelDistance(grid, scene, cluster, center) < light.FalloffEnd * 0.999) ++missed;
+            }
+        }
+        CHECK(order_errors == 0);
+        CHECK(scalar_mismatches == 0);
+        CHECK(outside_box == 0);
+        CHECK(missed == 0);
+        CHECK(point_entries > 0);
+
+        // The cone test has to pay off: narrow cones reach far fewer boxes.
+        CHECK(spot_entries > 0 && spot_entries < spot_box_entries * 3 / 4);
+
+        // Indices are packed without gaps.
+        size_t total = 0;
+        for (const LightCluster& entry : grid.Clusters()) total += entry.point_count + entry.spot_count;
+        CHECK(total == grid.LightIndices().size());
+    }
+
+    // Cluster the shader looks the view space point up in, false when it is
+    // off screen or too close to a tile or slice border to tell.
+    bool LookUp(const LightClusterGrid& grid, const Scene& scene, const XMFLOAT3& point, uint32_t* cluster)
+    {
+        if (point.z < kNearZ * 1.01f || point.z > kFarZ * 0.99f) return false;
+        const float ndc_x = point.x * scene.proj.m[0][0] / point.z + scene.proj.m[2][0];
+        const float ndc_y = point.y * scene.proj.m[1][1] / point.z + scene.proj.m[2][1];
+        if (fabsf(ndc_x) > 0.999f || fabsf(ndc_y) > 0.999f) return false;
+        const float pixel_x = (ndc_x * 0.5f + 0.5f) * kWidth;
+        const float pixel_y = (0.5f - ndc_y * 0.5f) * kHeight;
+        const float slice = log2f(point.z) * grid.DepthScale() + grid.DepthBias();
+        auto near_border = [](float value) { return fabsf(value - roundf(value)) < 0.01f; };
+        if (near_border(pixel_x / LightClusterGrid::kTileSize) || near_border(pixel_y / LightClusterGrid::kTileSize) || near_border(slice))
+        {
+            return false;
+        }
+        *cluster = grid.ClusterIndex(static_cast<uint32_t>(pixel_x) / LightClusterGrid::kTileSize,
+            static_cast<uint32_t>(pixel_y) / LightClusterGrid::kTileSize,
+            min(static_cast<uint32_t>(max(slice, 0.0f)), LightClusterGrid::kSliceCount - 1));
+        return true;
+    }
+
+    void TestSamples(const Scene& scene)
+    {
+        LightClusterGrid grid;
+        grid.SetProjection(scene.proj, kNearZ, kFarZ, kWidth, kHeight);
+        grid.Build(XMLoadFloat4x4(&scene.view), scene.lights.data(), scene.point_count, scene.spot_count);
+
+        RandomGenerator random(49);
+        uint32_t samples = 0, missed = 0;
+        for (uint32_t i = 0; i < scene.lights.size(); ++i)
+        {
+            const Light& light = scene.lights[i];
+            const bool spot = i >= scene.point_count;
+            const float cos_angle = spot ? powf(LightClusterGrid::kSpotCutoff, 1.0f / light.SpotPower) : -1.0f;
+
+            // A basis around the spot direction.
+            const XMVECTOR axis = XMLoadFloat3(&light.Direction);
+            const XMVECTOR helper = fabsf(light.Direction.y) < 0.9f ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+            const XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(helper, axis));
+            const XMVECTOR bitangent = XMVector3Cross(axis, tangent);
+            for (uint32_t k = 0; k < 400; ++k)
+            {
+                // Mostly near the rim and the far end, where a tight test
+                // would miss.
+                const float u = random.NextFloat();
+                const float cosine = cos_angle + (1.0f - cos_angle) * (0.001f + 0.998f * u * u * u);
+                const float sine = sqrtf(max(1.0f - cosine * cosine, 0.0f));
+                const float azimuth = random.NextFloat(0.0f, XM_2PI);
+                const float distance = light.FalloffEnd * 0.999f * cbrtf(random.NextFloat());
+                const XMVECTOR offset = XMVectorScale(XMVectorAdd(XMVectorScale(axis, cosine),
+                    XMVectorScale(XMVectorAdd(XMVectorScale(tangent, cosf(azimuth)), XMVectorScale(bitangent, sinf(azimuth))), sine)), distance);
+                XMFLOAT3 world;
+                XMStoreFloat3(&world, XMVectorAdd(XMLoadFloat3(&light.Position), offset));
+
+                uint32_t cluster;
+                if (!LookUp(grid, scene, ToView(scene, world), &cluster)) continue;
+                ++samples;
+                const vector<uint32_t> lights = ClusterLights(grid, cluster);
+                if (!binary_search(lights.begin(), lights.end(), i)) ++missed;
+            }
+        }
+        CHECK(samples > scene.lights.size() * 10);
+        CHECK(missed == 0);
+    }
+
+    void TestSpecialCases()
+    {
+        Scene scene = MakeScene(0, 0, 1);
+        XMStoreFloat4x4(&scene.view, XMMatrixIdentity());
+        LightClusterGrid grid;
+        grid.SetProjection(scene.proj, kNearZ, kFarZ, kWidth, kHeight);
+        const XMMATRIX view = XMMatrixIdentity();
+
+        Light lights[5];
+        lights[0].Position = XMFLOAT3(0.0f, 0.0f, -30.0f);     // behind the camera
+        lights[0].FalloffEnd = 10.0f;
+        lights[1].Position = XMFLOAT3(0.0f, 0.0f, 400.0f);     // past the far plane
+        lights[1].FalloffEnd = 50.0f;
+        lights[2].Position = XMFLOAT3(0.0f, 0.0f, 0.0f);       // around the camera
+        lights[2].FalloffEnd = 1.0f;
+        lights[3].Position = XMFLOAT3(0.0f, 0.0f, 20.0f);      // spot facing away, 10 degrees
+        lights[3].Direction = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        lights[3].FalloffEnd = 15.0f;
+        lights[3].SpotPower = logf(LightClusterGrid::kSpotCutoff) / logf(cosf(XM_PI / 18.0f));
+        lights[4] = lights[3];                                  // the same as a point light
+        grid.Build(view, lights, 3, 1);
+
+        vector<uint32_t> counts(4, 0);
+        bool near_slices = true;
+        for (uint32_t cluster = 0; cluster < grid.Clusters().size(); ++cluster)
+        {
+            for (uint32_t light : ClusterLights(grid, cluster))
+            {
+                ++counts[light];
+                const uint32_t slice = cluster / (grid.GridWidth() * grid.GridHeight());
+                if (light == 2) near_slices = near_slices && slice <= grid.DepthScale() * log2f(1.0f) + grid.DepthBias();
+            }
+        }
+        CHECK(counts[0] == 0 && counts[1] == 0);
+        CHECK(counts[2] > 0 && near_slices);
+
+        // The cone only reaches the boxes in front of its apex.
+        bool in_front = true;
+        uint32_t point_clusters = 0;
+        for (uint32_t cluster = 0; cluster < grid.Clusters().size(); ++cluster)
+        {
+            XMFLOAT3 lower, upper;
+            grid.ClusterBounds(cluster, &lower, &upper);
+            if (grid.IntersectsCluster(view, lights[4], false, cluster)) ++point_clusters;
+            const vector<uint32_t> list = ClusterLights(grid, cluster);
+            if (find(list.begin(), list.end(), 3u) != list.end()) in_front = in_front && upper.z > 20.0f;
+        }
+        CHECK(in_front && counts[3] > 0 && counts[3] * 4 < point_clusters);
+    }
+
+    void TestJobs(const Scene& scene)
+    {
+        LightClusterGrid serial;
+        serial.SetProjection(scene.proj, kNearZ, kFarZ, kWidth, kHeight);
+        serial.Build(XMLoadFloat4x4(&scene.view), scene.lights.data(), scene.point_count, scene.spot_count);
+
+        JobSystem::Create()->Initialize(4);
+        LightClusterGrid parallel;
+        parallel.SetProjection(scene.proj, kNearZ, kFarZ, kWidth, kHeight);
+        parallel.Build(XMLoadFloat4x4(&scene.view), scene.lights.data(), scene.point_count, scene.spot_count);
+        JobSystem::Instance().Release();
+
+        bool same = serial.LightIndices() == parallel.LightIndices();
+        for (size_t i = 0; same && i < serial.Clusters().size(); ++i)
+        {
+            const LightCluster& a = serial.Clusters()[i];
+            const LightCluster& b = parallel.Clusters()[i];
+            same = a.offset == b.offset && a.point_count == b.point_count && a.spot_count == b.spot_count;
+        }
+        CHECK(same);
+    }
+}
+
+int main()
+{
+    const Scene scene = MakeScene(200, 100, 49);
+    TestBruteForce(scene);
+    TestSamples(scene);
+    TestSpecialCases();
+    TestJobs(MakeScene(4000, 2000, 7));
+    return test::Result();
+}
@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------------
+//  lod_selector_benchmark.cpp
+//  Milliseconds to pick LODs for the visible part of 100k instances: Cull,
+//  ProjectedRadii and Select side by side, so Select's share of the frame's
+//  CPU culling cost can be read off directly.
+//--------------------------------------------------------------------------------
+#include "lod_selector.h"
+#include "culling_system.h"
+#include "job_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr size_t kInstanceCount = 100000;
+    constexpr uint32_t kSubmeshCount = 256;
+    constexpr uint32_t kLodCount = 4;           // handles kLodCount + 1 apart
+    constexpr int kRepeat = 50;
+
+    void Report(const char* name, double ms, size_t count)
+    {
+        printf("%-24s %8.3f ms   (%zu visible)\n", name, ms, count);
+    }
+}
+
+int main()
+{
+    RandomGenerator random(34);
+    vector<XMFLOAT4X4> worlds(kInstanceCount);
+    vector<BoundingBox> bounds(kInstanceCount);
+    vector<uint32_t> instance_submesh(kInstanceCount);
+    for (size_t i = 0; i < kInstanceCount; ++i)
+    {
+        XMStoreFloat4x4(&worlds[i], XMMatrixTranslation(random.NextFloat(-500.0f, 500.0f), random.NextFloat(-20.0f, 20.0f), random.NextFloat(-500.0f, 500.0f)));
+        bounds[i].Extents = XMFLOAT3(random.NextFloat(0.5f, 4.0f), random.NextFloat(0.5f, 4.0f), random.NextFloat(0.5f, 4.0f));
+        instance_submesh[i] = random.NextUint() % kSubmeshCount * (kLodCount + 1);
+    }
+
+    LodSelector selector;
+    for (uint32_t s = 0; s < kSubmeshCount; ++s)
+    {
+        const float errors[kLodCount] = { 0.01f, 0.03f, 0.1f, 0.3f };
+        selector.SetSubmesh(s * (kLodCount + 1), errors, kLodCount);
+    }
+
+    CullingSystem culling;
+    culling.SetInstances(worlds.data(), bounds.data(), kInstanceCount);
+    const XMVECTOR eye = XMVectorSet(0.0f, 10.0f, -50.0f, 1.0f);
+    const XMMATRIX view_proj = XMMatrixMultiply(
+        XMMatrixLookAtLH(eye, XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+        XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f));
+    const float projection_scale = 1080.0f / (2.0f * tanf(XM_PIDIV4 * 0.5f));
+
+    vector<uint32_t> visible;
+    double ms = test::MeasureMs(kRepeat, [&culling, &visible, &view_proj] { culling.Cull(view_proj, visible, 1); });
+    Report("Cull serial", ms, visible.size());
+
+    vector<float> radii(visible.size());
+    ms = test::MeasureMs(kRepeat, [&culling, &visible, &radii, eye, projection_scale]
+    {
+        culling.ProjectedRadii(eye, projection_scale, visible.data(), visible.size(), radii.data());
+    });
+    Report("ProjectedRadii", ms, visible.size());
+
+    vector<uint32_t> submeshes(visible.size());
+    ms = test::MeasureMs(kRepeat, [&selector, &visible, &radii, &instance_submesh, &submeshes]
+    {
+        selector.Select(visible.data(), visible.size(), radii.data(), instance_submesh.data(), 1.0f, submeshes.data());
+    });
+    Report("Select", ms, visible.size());
+
+    // Checksum: how often each LOD was picked.
+    size_t lod_counts[kLodCount + 1] = {};
+    for (size_t i = 0; i < visible.size(); ++i) ++lod_counts[submeshes[i] - instance_submesh[visible[i]]];
+    printf("LOD 0..4:");
+    for (size_t count : lod_counts) printf(" %zu", count);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------------
+//  math_helper_benchmark.cpp
+//  Unit sphere samples per microsecond: the former rejection loop against
+//  the single and bulk MathHelper::RandUnitVec3 (Windows only).
+//--------------------------------------------------------------------------------
+#include "MathHelper.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr int kCount = 1 << 20;
+    constexpr int kRepeat = 10;
+
+    // MathHelper::RandUnitVec3 before the bulk version.
+    XMVECTOR RandUnitVec3Rejection()
+    {
+        const XMVECTOR one = XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
+        while (true)
+        {
+            const XMVECTOR v = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), 0.0f);
+            if (XMVector3Greater(XMVector3LengthSq(v), one)) continue;
+            return XMVector3Normalize(v);
+        }
+    }
+
+    void Report(const char* name, double ms, float checksum)
+    {
+        printf("%-24s %8.1f samples/us   (checksum %.3f)\n", name, kCount / (ms * 1000.0), checksum);
+    }
+}
+
+int main()
+{
+    vector<XMFLOAT3> samples(kCount);
+    auto checksum = [&samples] { return samples[0].x + samples[kCount / 2].y + samples[kCount - 1].z; };
+
+    double ms = test::MeasureMs(kRepeat, [&samples]
+    {
+        for (XMFLOAT3& v : samples) XMStoreFloat3(&v, RandUnitVec3Rejection());
+    });
+    Report("rejection loop", ms, checksum());
+
+    ms = test::MeasureMs(kRepeat, [&samples]
+    {
+        for (XMFLOAT3& v : samples) XMStoreFloat3(&v, MathHelper::RandUnitVec3());
+    });
+    Report("RandUnitVec3()", ms, checksum());
+
+    ms = test::MeasureMs(kRepeat, [&samples]
+    {
+        MathHelper::RandUnitVec3(samples.data(), samples.size());
+    });
+    Report("RandUnitVec3 bulk", ms, checksum());
+
+    const XMVECTOR n = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    ms = test::MeasureMs(kRepeat, [&samples, n]
+    {
+        MathHelper::RandHemisphereUnitVec3(n, samples.data(), samples.size());
+    });
+    Report("RandHemisphereUnitVec3", ms, checksum());
+    return 0;
+}
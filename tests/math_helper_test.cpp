@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------
+//  math_helper_test.cpp
+//  Distribution of the unit sphere / hemisphere samples of MathHelper
+//  (Windows only: MathHelper.h includes Windows.h).
+//--------------------------------------------------------------------------------
+#include "MathHelper.h"
+#include "test_util.h"
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr size_t kSampleCount = 1 << 18;
+
+    double ChiSquare(const vector<int>& counts, size_t total)
+    {
+        const double expected = static_cast<double>(total) / counts.size();
+        double chi_square = 0.0;
+        for (int count : counts) chi_square += (count - expected) * (count - expected) / expected;
+        return chi_square;
+    }
+
+    // Unit length, and uniform on the sphere: every coordinate is uniform in
+    // [-1, 1] (Archimedes) and the mean is the origin.
+    void CheckSphere(const vector<XMFLOAT3>& samples)
+    {
+        bool unit = true;
+        double mean[3] = {};
+        vector<int> bins[3] = { vector<int>(32, 0), vector<int>(32, 0), vector<int>(32, 0) };
+        for (const XMFLOAT3& v : samples)
+        {
+            const float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+            unit = unit && fabsf(length - 1.0f) < 1e-4f;
+            const float c[3] = { v.x, v.y, v.z };
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                mean[axis] += c[axis];
+                ++bins[axis][MathHelper::Clamp(static_cast<int>((c[axis] + 1.0f) * 16.0f), 0, 31)];
+            }
+        }
+        CHECK(unit);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            // Each coordinate has variance 1/3.
+            CHECK(fabs(mean[axis] / samples.size()) < 3.3 * sqrt(1.0 / 3.0 / samples.size()));
+            CHECK(ChiSquare(bins[axis], samples.size()) < 61.1);    // 31 degrees of freedom
+        }
+    }
+}
+
+int main()
+{
+    RandomGenerator::SetGlobalSeed(31);
+
+    vector<XMFLOAT3> samples(kSampleCount);
+    MathHelper::RandUnitVec3(samples.data(), samples.size());
+    CheckSphere(samples);
+
+    // Odd counts only write count entries.
+    vector<XMFLOAT3> tail(7, XMFLOAT3(9.0f, 9.0f, 9.0f));
+    MathHelper::RandUnitVec3(tail.data(), 6);
+    CHECK(tail[5].x != 9.0f && tail[6].x == 9.0f);
+
+    // Hemisphere samples are on the side of n, and mirrored they cover the sphere.
+    const XMVECTOR n = XMVector3Normalize(XMVectorSet(0.3f, -0.5f, 0.8f, 0.0f));
+    XMFLOAT3 normal;
+    XMStoreFloat3(&normal, n);
+    MathHelper::RandHemisphereUnitVec3(n, samples.data(), samples.size());
+    bool above = true;
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        XMFLOAT3& v = samples[i];
+        above = above && v.x * normal.x + v.y * normal.y + v.z * normal.z >= 0.0f;
+        if (i & 1) v = XMFLOAT3(-v.x, -v.y, -v.z);
+    }
+    CHECK(above);
+    CheckSphere(samples);
+
+    XMFLOAT3 single;
+    XMStoreFloat3(&single, MathHelper::RandUnitVec3());
+    CHECK(fabsf(single.x * single.x + single.y * single.y + single.z * single.z - 1.0f) < 1e-4f);
+    return test::Result();
+}
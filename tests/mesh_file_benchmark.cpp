@@ -0,0 +1,75 @@
+//--------------------------------------------------------------------------------
+//  mesh_file_benchmark.cpp
+//  Load throughput of a large .kmesh: MeshFileView (map + validate, indices
+//  included) against reading the whole file with ifstream.
+//--------------------------------------------------------------------------------
+#include "mesh_file.h"
+#include "test_util.h"
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const char* const kPath = "mesh_file_benchmark.kmesh";
+    constexpr uint32_t kGrid = 1024;        // 1M vertices, 6M indices
+    constexpr uint32_t kStride = 32;
+    constexpr int kRepeat = 20;
+
+    void Report(const char* name, double ms, uint64_t bytes, uint64_t checksum)
+    {
+        printf("%-28s %8.3f ms %8.1f MB/s   (checksum %llu)\n", name, ms, bytes / (ms * 1000.0),
+            static_cast<unsigned long long>(checksum));
+    }
+}
+
+int main()
+{
+    MeshFileData data;
+    data.vertex_stride = kStride;
+    data.vertices.assign(static_cast<size_t>(kGrid) * kGrid * kStride, 1);
+    for (uint32_t y = 0; y + 1 < kGrid; ++y)
+    {
+        for (uint32_t x = 0; x + 1 < kGrid; ++x)
+        {
+            const uint32_t i = y * kGrid + x;
+            const uint32_t quad[6] = { i, i + kGrid, i + 1, i + 1, i + kGrid, i + kGrid + 1 };
+            data.indices.insert(data.indices.end(), quad, quad + 6);
+        }
+    }
+    MeshFileData::Submesh submesh;
+    submesh.name = "grid";
+    submesh.index_count = static_cast<uint32_t>(data.indices.size());
+    data.submeshes.push_back(submesh);
+    if (!MeshFileWriter::Write(kPath, data))
+    {
+        printf("cannot write %s\n", kPath);
+        return 1;
+    }
+
+    uint64_t file_size = 0;
+    uint64_t checksum = 0;
+    double ms = test::MeasureMs(kRepeat, [&file_size, &checksum]
+    {
+        ifstream fin(kPath, ios::binary | ios::ate);
+        vector<char> bytes(static_cast<size_t>(fin.tellg()));
+        fin.seekg(0);
+        fin.read(bytes.data(), static_cast<streamsize>(bytes.size()));
+        file_size = bytes.size();
+        checksum += static_cast<unsigned char>(bytes[bytes.size() / 2]);
+    });
+    Report("ifstream read", ms, file_size, checksum);
+
+    checksum = 0;
+    ms = test::MeasureMs(kRepeat, [&checksum]
+    {
+        MeshFileView view;
+        if (view.Open(kPath)) checksum += view.Header().index_count;
+    });
+    Report("MeshFileView::Open", ms, file_size, checksum);
+
+    remove(kPath);
+    return 0;
+}
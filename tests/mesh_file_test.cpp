@@ -0,0 +1,212 @@
+//--------------------------------------------------------------------------------
+//  mesh_file_test.cpp
+//  .kmesh round trip through MeshFileWriter / MeshFileView, and rejection of
+//  corrupted files: bad header, ranges outside the file and indices outside
+//  the vertex stream.
+//--------------------------------------------------------------------------------
+#include "mesh_file.h"
+#include "test_util.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const char* const kPath = "mesh_file_test.kmesh";
+
+    // Grid of (x, y, z, u) float vertices with two submeshes, the second with
+    // a base vertex and one LOD.
+    MeshFileData MakeData(uint32_t grid)
+    {
+        MeshFileData data;
+        data.vertex_stride = 4 * sizeof(float);
+        const uint32_t vertex_count = grid * grid;
+        data.vertices.resize(vertex_count * data.vertex_stride);
+        float* v = reinterpret_cast<float*>(data.vertices.data());
+        for (uint32_t i = 0; i < vertex_count; ++i)
+        {
+            v[i * 4 + 0] = static_cast<float>(i % grid);
+            v[i * 4 + 1] = 0.0f;
+            v[i * 4 + 2] = static_cast<float>(i / grid);
+            v[i * 4 + 3] = 0.5f;
+        }
+
+        // Quads of the lower and upper half of the grid, both indexed from 0.
+        const uint32_t half = grid / 2;
+        for (uint32_t pass = 0; pass < 2; ++pass)
+        {
+            for (uint32_t y = 0; y + 1 < half; ++y)
+            {
+                for (uint32_t x = 0; x + 1 < grid; ++x)
+                {
+                    const uint32_t i = y * grid + x;
+                    const uint32_t quad[6] = { i, i + grid, i + 1, i + 1, i + grid, i + grid + 1 };
+                    data.indices.insert(data.indices.end(), quad, quad + 6);
+                }
+            }
+        }
+        const uint32_t half_count = static_cast<uint32_t>(data.indices.size() / 2);
+
+        MeshFileData::Submesh lower;
+        lower.name = "lower";
+        lower.index_count = half_count;
+        lower.extents[0] = lower.extents[2] = grid * 0.5f;
+        MeshFileData::Submesh upper;
+        upper.name = "upper";
+        upper.index_count = half_count;
+        upper.start_index = half_count;
+        upper.base_vertex = static_cast<int32_t>(half * grid);
+        MeshFileLod lod = {};
+        lod.index_count = 6;
+        lod.start_index = half_count;
+        lod.error = 0.25f;
+        upper.lods.push_back(lod);
+        data.submeshes.push_back(lower);
+        data.submeshes.push_back(upper);
+        return data;
+    }
+
+    vector<char> ReadFile()
+    {
+        ifstream fin(kPath, ios::binary);
+        return vector<char>(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const vector<char>& bytes)
+    {
+        ofstream fout(kPath, ios::binary);
+        fout.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+    }
+
+    // Open a copy of the valid file patched by function(bytes, header).
+    template <class Function>
+    bool OpenPatched(const vector<char>& valid, Function function)
+    {
+        vector<char> bytes = valid;
+        MeshFileHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        function(bytes, header);
+        memcpy(bytes.data(), &header, sizeof(header));
+        WriteFile(bytes);
+        MeshFileView view;
+        return view.Open(kPath);
+    }
+
+    void TestRoundTrip(uint32_t grid, uint32_t index_size)
+    {
+        const MeshFileData data = MakeData(grid);
+        CHECK(MeshFileWriter::Write(kPath, data));
+
+        MeshFileView view;
+        if (!view.Open(kPath))
+        {
+            CHECK(!"open failed");
+            return;
+        }
+        const MeshFileHeader& header = view.Header();
+        CHECK(header.index_size == index_size);
+        CHECK(header.vertex_count == grid * grid);
+        CHECK(header.index_count == data.indices.size());
+        CHECK(view.VertexByteSize() == data.vertices.size());
+        CHECK(memcmp(view.Vertices(), data.vertices.data(), data.vertices.size()) == 0);
+        CHECK(header.vertex_offset % kMeshFileAlignment == 0 && header.index_offset % kMeshFileAlignment == 0);
+
+        bool same = true;
+        for (size_t i = 0; i < data.indices.size(); ++i)
+        {
+            const uint32_t index = index_size == 2 ? static_cast<const uint16_t*>(view.Indices())[i] : static_cast<const uint32_t*>(view.Indices())[i];
+            same = same && index == data.indices[i];
+        }
+        CHECK(same);
+
+        CHECK(header.submesh_count == 2 && header.lod_count == 1);
+        CHECK(view.SubmeshName(0) == "lower" && view.SubmeshName(1) == "upper");
+        const MeshFileSubmesh& upper = view.Submeshes()[1];
+        CHECK(upper.base_vertex == data.submeshes[1].base_vertex && upper.start_index == data.submeshes[1].start_index);
+        CHECK(upper.first_lod == 0 && upper.lod_count == 1);
+        CHECK(view.Lods()[0].error == 0.25f);
+        CHECK(view.Submeshes()[0].extents[0] == grid * 0.5f);
+    }
+
+    void TestCorruption()
+    {
+        // 600 x 600 vertices: 32bit indices.
+        CHECK(MeshFileWriter::Write(kPath, MakeData(600)));
+        const vector<char> valid = ReadFile();
+        CHECK(OpenPatched(valid, [](vector<char>&, MeshFileHeader&) {}));
+
+        MeshFileView view;
+        CHECK(!view.Open("mesh_file_test_missing.kmesh"));
+
+        // Header
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { h.magic = 0; }));
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { ++h.version; }));
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { h.index_size = 3; }));
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { h.vertex_stride = 0; }));
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader&) { b.resize(b.size() - 1); }));
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader&) { b.resize(sizeof(MeshFileHeader) - 1); }));
+
+        // Blocks and tables outside the file
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { h.vertex_count *= 100; }));
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { h.index_offset = h.file_size - 4; }));
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { h.submesh_count = 0x7fffffff; }));
+        CHECK(!OpenPatched(valid, [](vector<char>&, MeshFileHeader& h) { h.name_offset = ~0ull; }));
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<MeshFileSubmesh*>(&b[h.submesh_offset])[1].start_index = h.index_count - 1;
+        }));
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<MeshFileSubmesh*>(&b[h.submesh_offset])[0].lod_count = 2;
+        }));
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<MeshFileLod*>(&b[h.lod_offset])[0].index_count = h.index_count;
+        }));
+
+        // Indices outside the vertex stream, alone or with the base vertex
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<uint32_t*>(&b[h.index_offset])[7] = h.vertex_count;
+        }));
+        CHECK(OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<uint32_t*>(&b[h.index_offset])[7] = h.vertex_count - 1;
+        }));
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<MeshFileSubmesh*>(&b[h.submesh_offset])[1].base_vertex += 1;
+        }));
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<MeshFileSubmesh*>(&b[h.submesh_offset])[0].base_vertex = -1;
+        }));
+        // Only the LOD of the upper half reads the patched index: valid for
+        // the lower half, past the last vertex with the upper base vertex.
+        CHECK(!OpenPatched(valid, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<MeshFileLod*>(&b[h.lod_offset])[0].start_index = 0;
+            reinterpret_cast<uint32_t*>(&b[h.index_offset])[0] = 300 * 600;
+        }));
+
+        // 16bit indices
+        CHECK(MeshFileWriter::Write(kPath, MakeData(100)));
+        const vector<char> small = ReadFile();
+        CHECK(!OpenPatched(small, [](vector<char>& b, MeshFileHeader& h)
+        {
+            reinterpret_cast<uint16_t*>(&b[h.index_offset])[h.index_count - 1] = static_cast<uint16_t>(h.vertex_count);
+        }));
+        remove(kPath);
+    }
+}
+
+int main()
+{
+    TestRoundTrip(100, 2);
+    TestRoundTrip(600, 4);
+    TestCorruption();
+    return test::Result();
+}
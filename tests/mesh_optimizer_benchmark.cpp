@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------
+//  mesh_optimizer_benchmark.cpp
+//  Time of each MeshOptimizer pass on a large shuffled mesh (1M triangles)
+//  and the ACMR they reach.
+//--------------------------------------------------------------------------------
+#include "mesh_optimizer.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kRings = 512;
+    constexpr uint32_t kSegments = 1024;
+    constexpr uint32_t kStride = 3 * sizeof(float);
+    constexpr int kRepeat = 3;
+
+    void Report(const char* name, double ms, size_t triangle_count, float acmr)
+    {
+        printf("%-22s %9.2f ms %9.1f triangles/ms   ACMR %.3f\n", name, ms, triangle_count / ms, acmr);
+    }
+}
+
+int main()
+{
+    vector<float> vertices;
+    for (uint32_t r = 0; r <= kRings; ++r)
+    {
+        const float phi = 3.14159265f * r / kRings;
+        for (uint32_t s = 0; s <= kSegments; ++s)
+        {
+            const float theta = 6.28318531f * s / kSegments;
+            vertices.push_back(sinf(phi) * cosf(theta));
+            vertices.push_back(cosf(phi));
+            vertices.push_back(sinf(phi) * sinf(theta));
+        }
+    }
+    vector<uint32_t> indices;
+    for (uint32_t r = 0; r < kRings; ++r)
+    {
+        for (uint32_t s = 0; s < kSegments; ++s)
+        {
+            const uint32_t i = r * (kSegments + 1) + s;
+            const uint32_t quad[6] = { i, i + 1, i + kSegments + 1, i + 1, i + kSegments + 2, i + kSegments + 1 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    const size_t vertex_count = vertices.size() / 3;
+    const size_t index_count = indices.size();
+    const size_t triangle_count = index_count / 3;
+
+    RandomGenerator random(1);
+    for (int i = static_cast<int>(triangle_count) - 1; i > 0; --i)
+    {
+        const int j = random.NextInt(0, i);
+        for (int k = 0; k < 3; ++k) swap(indices[i * 3 + k], indices[j * 3 + k]);
+    }
+
+    float acmr = 0.0f;
+    double ms = test::MeasureMs(kRepeat, [&] { acmr = MeshOptimizer::SimulateAcmr(indices.data(), index_count, vertex_count); });
+    Report("SimulateAcmr (input)", ms, triangle_count, acmr);
+
+    vector<uint32_t> cache_order(index_count), clusters;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        MeshOptimizer::OptimizeVertexCache(cache_order.data(), indices.data(), index_count, vertex_count,
+            MeshOptimizer::kDefaultCacheSize, &clusters);
+    });
+    Report("OptimizeVertexCache", ms, triangle_count, MeshOptimizer::SimulateAcmr(cache_order.data(), index_count, vertex_count));
+
+    vector<uint32_t> overdraw_order(index_count);
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        MeshOptimizer::OptimizeOverdraw(overdraw_order.data(), cache_order.data(), index_count,
+            vertices.data(), vertex_count, kStride, clusters);
+    });
+    Report("OptimizeOverdraw", ms, triangle_count, MeshOptimizer::SimulateAcmr(overdraw_order.data(), index_count, vertex_count));
+
+    vector<float> fetched(vertices.size());
+    vector<uint32_t> remapped;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        remapped = overdraw_order;
+        MeshOptimizer::OptimizeVertexFetch(fetched.data(), remapped.data(), index_count, vertices.data(), vertex_count, kStride);
+    });
+    Report("OptimizeVertexFetch", ms, triangle_count, MeshOptimizer::SimulateAcmr(remapped.data(), index_count, vertex_count));
+    return 0;
+}
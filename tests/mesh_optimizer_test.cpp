@@ -0,0 +1,222 @@
+//--------------------------------------------------------------------------------
+//  mesh_optimizer_test.cpp
+//  Every MeshOptimizer pass keeps the same triangles (winding included) and
+//  the cache passes lower the ACMR of shuffled meshes.
+//--------------------------------------------------------------------------------
+#include "mesh_optimizer.h"
+#include "mesh_file.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kStride = 4 * sizeof(float);     // position + one float
+
+    struct Mesh
+    {
+        vector<float>    vertices;                      // 4 floats per vertex
+        vector<uint32_t> indices;
+        size_t VertexCount() const { return vertices.size() / 4; }
+    };
+
+    // Closed UV sphere, so the overdraw pass has front and back faces.
+    Mesh MakeSphere(uint32_t rings, uint32_t segments)
+    {
+        Mesh mesh;
+        for (uint32_t r = 0; r <= rings; ++r)
+        {
+            const float phi = 3.14159265f * r / rings;
+            for (uint32_t s = 0; s <= segments; ++s)
+            {
+                const float theta = 6.28318531f * s / segments;
+                const float v[4] = { sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta), static_cast<float>(r * 1000 + s) };
+                mesh.vertices.insert(mesh.vertices.end(), v, v + 4);
+            }
+        }
+        for (uint32_t r = 0; r < rings; ++r)
+        {
+            for (uint32_t s = 0; s < segments; ++s)
+            {
+                const uint32_t i = r * (segments + 1) + s;
+                const uint32_t quad[6] = { i, i + 1, i + segments + 1, i + 1, i + segments + 2, i + segments + 1 };
+                mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+            }
+        }
+        return mesh;
+    }
+
+    void ShuffleTriangles(vector<uint32_t>& indices, uint32_t seed)
+    {
+        RandomGenerator random(seed);
+        const int triangle_count = static_cast<int>(indices.size() / 3);
+        for (int i = triangle_count - 1; i > 0; --i)
+        {
+            const int j = random.NextInt(0, i);
+            for (int k = 0; k < 3; ++k) swap(indices[i * 3 + k], indices[j * 3 + k]);
+        }
+    }
+
+    // Triangles as sorted vertex payloads, each rotated to start with its
+    // smallest vertex so the winding is part of the comparison.
+    vector<array<float, 3>> Triangles(const float* vertices, const uint32_t* indices, size_t index_count)
+    {
+        vector<array<float, 3>> triangles;
+        for (size_t i = 0; i < index_count; i += 3)
+        {
+            array<float, 3> t = { vertices[indices[i] * 4 + 3], vertices[indices[i + 1] * 4 + 3], vertices[indices[i + 2] * 4 + 3] };
+            rotate(t.begin(), min_element(t.begin(), t.end()), t.end());
+            triangles.push_back(t);
+        }
+        sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void TestAcmr()
+    {
+        // Disjoint triangles miss every vertex; a repeated triangle only once.
+        const uint32_t disjoint[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+        CHECK(MeshOptimizer::SimulateAcmr(disjoint, 9, 9) == 3.0f);
+        const uint32_t repeated[] = { 0, 1, 2, 0, 1, 2, 2, 1, 0 };
+        CHECK(fabsf(MeshOptimizer::SimulateAcmr(repeated, 9, 3) - 1.0f) < 1e-6f);
+        // FIFO with 3 entries: vertex 3 evicts 0, which then evicts 1 and so
+        // on, so the last triangle misses everything (3 + 1 + 3 misses).
+        const uint32_t evict[] = { 0, 1, 2, 1, 2, 3, 0, 1, 2 };
+        CHECK(fabsf(MeshOptimizer::SimulateAcmr(evict, 9, 4, 3) - 7.0f / 3.0f) < 1e-6f);
+    }
+
+    void TestVertexCacheAndOverdraw()
+    {
+        Mesh mesh = MakeSphere(64, 128);
+        ShuffleTriangles(mesh.indices, 3);
+        const size_t count = mesh.indices.size();
+        const auto triangles = Triangles(mesh.vertices.data(), mesh.indices.data(), count);
+        const float acmr_shuffled = MeshOptimizer::SimulateAcmr(mesh.indices.data(), count, mesh.VertexCount());
+
+        vector<uint32_t> cache_order(count), clusters;
+        MeshOptimizer::OptimizeVertexCache(cache_order.data(), mesh.indices.data(), count, mesh.VertexCount(),
+            MeshOptimizer::kDefaultCacheSize, &clusters);
+        CHECK(Triangles(mesh.vertices.data(), cache_order.data(), count) == triangles);
+        const float acmr_cache = MeshOptimizer::SimulateAcmr(cache_order.data(), count, mesh.VertexCount());
+        CHECK(acmr_shuffled > 2.0f);
+        CHECK(acmr_cache < 0.8f);
+
+        // Clusters are ascending triangle boundaries starting at 0.
+        CHECK(!clusters.empty() && clusters[0] == 0);
+        CHECK(is_sorted(clusters.begin(), clusters.end()));
+        CHECK(clusters.back() < count && clusters.back() % 3 == 0);
+
+        vector<uint32_t> overdraw_order(count);
+        const float threshold = 1.05f;
+        MeshOptimizer::OptimizeOverdraw(overdraw_order.data(), cache_order.data(), count,
+            mesh.vertices.data(), mesh.VertexCount(), kStride, clusters, threshold);
+        CHECK(Triangles(mesh.vertices.data(), overdraw_order.data(), count) == triangles);
+        // Splitting clusters costs little of the cache gain.
+        CHECK(MeshOptimizer::SimulateAcmr(overdraw_order.data(), count, mesh.VertexCount()) < acmr_cache * threshold + 0.05f);
+    }
+
+    void TestVertexFetch()
+    {
+        Mesh mesh = MakeSphere(16, 32);
+        ShuffleTriangles(mesh.indices, 5);
+        // Drop the first rows: their vertices are no longer referenced.
+        mesh.indices.erase(mesh.indices.begin(), mesh.indices.begin() + 6 * 32 * 2);
+        const auto triangles = Triangles(mesh.vertices.data(), mesh.indices.data(), mesh.indices.size());
+
+        vector<uint32_t> indices = mesh.indices;
+        vector<float> fetched(mesh.vertices.size());
+        const size_t used = MeshOptimizer::OptimizeVertexFetch(fetched.data(), indices.data(), indices.size(),
+            mesh.vertices.data(), mesh.VertexCount(), kStride);
+        CHECK(used < mesh.VertexCount());
+        CHECK(Triangles(fetched.data(), indices.data(), indices.size()) == triangles);
+
+        // Vertices are in order of first use.
+        uint32_t next = 0;
+        bool first_use_order = true;
+        for (uint32_t index : indices)
+        {
+            if (index == next) ++next;
+            else first_use_order = first_use_order && index < next;
+        }
+        CHECK(first_use_order && next == used);
+    }
+
+    void TestIndexSize()
+    {
+        const uint32_t small[] = { 0, 65535, 7 };
+        const uint32_t large[] = { 0, 65536, 7 };
+        CHECK(MeshOptimizer::SelectIndexSize(small, 3) == 2);
+        CHECK(MeshOptimizer::SelectIndexSize(large, 3) == 4);
+        CHECK(MeshOptimizer::SelectIndexSize(nullptr, 0) == 2);
+    }
+
+    void TestOptimize()
+    {
+        // Two spheres in one vertex buffer, the second with a base vertex and
+        // a LOD drawn with the same base vertex.
+        Mesh a = MakeSphere(80, 160), b = MakeSphere(20, 40);
+        ShuffleTriangles(a.indices, 7);
+        ShuffleTriangles(b.indices, 9);
+        for (size_t i = 3; i < b.vertices.size(); i += 4) b.vertices[i] += 1e6f;
+
+        MeshFileData data;
+        data.vertex_stride = kStride;
+        vector<float> vertices = a.vertices;
+        vertices.insert(vertices.end(), b.vertices.begin(), b.vertices.end());
+        data.vertices.resize(vertices.size() * sizeof(float));
+        memcpy(data.vertices.data(), vertices.data(), data.vertices.size());
+        data.indices = a.indices;
+        data.indices.insert(data.indices.end(), b.indices.begin(), b.indices.end());
+        data.indices.insert(data.indices.end(), b.indices.begin(), b.indices.begin() + 300);
+
+        MeshFileData::Submesh first, second;
+        first.index_count = static_cast<uint32_t>(a.indices.size());
+        second.start_index = first.index_count;
+        second.index_count = static_cast<uint32_t>(b.indices.size());
+        second.base_vertex = static_cast<int32_t>(a.VertexCount());
+        MeshFileLod lod = {};
+        lod.start_index = second.start_index + second.index_count;
+        lod.index_count = 300;
+        second.lods.push_back(lod);
+        data.submeshes = { first, second };
+
+        auto submesh_triangles = [](const MeshFileData& d, uint32_t start, uint32_t count, int32_t base)
+        {
+            vector<uint32_t> indices(d.indices.begin() + start, d.indices.begin() + start + count);
+            for (uint32_t& index : indices) index += base;
+            return Triangles(reinterpret_cast<const float*>(d.vertices.data()), indices.data(), count);
+        };
+        const auto first_triangles = submesh_triangles(data, 0, first.index_count, 0);
+        const auto second_triangles = submesh_triangles(data, second.start_index, second.index_count, second.base_vertex);
+        const auto lod_triangles = submesh_triangles(data, lod.start_index, lod.index_count, second.base_vertex);
+
+        const MeshOptimizer::Report report = MeshOptimizer::Optimize(data);
+        CHECK(report.acmr_before > 2.0f && report.acmr_after < 0.8f);
+        CHECK(report.vertex_count_before == vertices.size() / 4);
+        CHECK(report.vertex_count_after == report.vertex_count_before);
+        // Each submesh indexes from its own base vertex: 16bit indices.
+        CHECK(report.index_size == 2);
+
+        const MeshFileData::Submesh& s0 = data.submeshes[0];
+        const MeshFileData::Submesh& s1 = data.submeshes[1];
+        CHECK(submesh_triangles(data, s0.start_index, s0.index_count, s0.base_vertex) == first_triangles);
+        CHECK(submesh_triangles(data, s1.start_index, s1.index_count, s1.base_vertex) == second_triangles);
+        CHECK(submesh_triangles(data, s1.lods[0].start_index, s1.lods[0].index_count, s1.base_vertex) == lod_triangles);
+    }
+}
+
+int main()
+{
+    TestAcmr();
+    TestIndexSize();
+    TestVertexCacheAndOverdraw();
+    TestVertexFetch();
+    TestOptimize();
+    return test::Result();
+}
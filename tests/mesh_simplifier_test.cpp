@@ -0,0 +1,305 @@
+//--------------------------------------------------------------------------------
+//  mesh_simplifier_test.cpp
+//  MeshSimplifier on height field grids with a UV seam: LODs shrink with a
+//  growing error, border and seam vertices stay, no hole opens; LodSelector
+//  registration order and Select against brute force.
+//--------------------------------------------------------------------------------
+#include "mesh_simplifier.h"
+#include "lod_selector.h"
+#include "draw_batcher.h"
+#include "mesh_file.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kFloatsPerVertex = 5;    // position, uv
+    constexpr uint32_t kStride = kFloatsPerVertex * sizeof(float);
+
+    struct Grid
+    {
+        vector<float>    vertices;
+        vector<uint32_t> indices;
+        vector<uint32_t> border;                // vertices on the outline
+        vector<uint32_t> seam;                  // vertices sharing a position
+        float area = 0.0f;                      // in x / z
+        size_t VertexCount() const { return vertices.size() / kFloatsPerVertex; }
+    };
+
+    // n x n quads over [0, n] in x / z, heights from a few bumps (flat when
+    // height is 0).  The column x = n / 2 is split: the quads on its right
+    // use their own vertices there, as a UV seam would.
+    Grid MakeGrid(uint32_t n, float height)
+    {
+        Grid grid;
+        auto add = [&grid, n, height](uint32_t x, uint32_t z, float u)
+        {
+            const float fx = static_cast<float>(x), fz = static_cast<float>(z);
+            const float y = height * (sinf(fx * 0.4f) * cosf(fz * 0.3f) + 0.5f * sinf((fx + fz) * 0.9f));
+            const float v[kFloatsPerVertex] = { fx, y, fz, u, fz / n };
+            grid.vertices.insert(grid.vertices.end(), v, v + kFloatsPerVertex);
+            return static_cast<uint32_t>(grid.VertexCount() - 1);
+        };
+
+        const uint32_t seam_x = n / 2;
+        vector<uint32_t> ids((n + 1) * (n + 1)), seam_ids(n + 1);
+        for (uint32_t z = 0; z <= n; ++z)
+        {
+            for (uint32_t x = 0; x <= n; ++x)
+            {
+                ids[z * (n + 1) + x] = add(x, z, static_cast<float>(x) / n);
+                if (x == 0 || z == 0 || x == n || z == n) grid.border.push_back(ids[z * (n + 1) + x]);
+            }
+            seam_ids[z] = add(seam_x, z, 1.0f);
+            grid.seam.push_back(ids[z * (n + 1) + seam_x]);
+            grid.seam.push_back(seam_ids[z]);
+        }
+        auto id = [&](uint32_t x, uint32_t z, bool right) { return (x == seam_x && right) ? seam_ids[z] : ids[z * (n + 1) + x]; };
+        for (uint32_t z = 0; z < n; ++z)
+        {
+            for (uint32_t x = 0; x < n; ++x)
+            {
+                const bool right = x >= seam_x;
+                const uint32_t quad[6] =
+                {
+                    id(x, z, right), id(x, z + 1, right), id(x + 1, z + 1, right),
+                    id(x, z, right), id(x + 1, z + 1, right), id(x + 1, z, right),
+                };
+                grid.indices.insert(grid.indices.end(), quad, quad + 6);
+            }
+        }
+        grid.area = static_cast<float>(n) * n;
+        return grid;
+    }
+
+    const float* Position(const Grid& grid, uint32_t vertex) { return &grid.vertices[vertex * kFloatsPerVertex]; }
+
+    // Signed area in x / z: a hole or a folded triangle changes it.
+    float ProjectedArea(const Grid& grid, const uint32_t* indices, size_t count)
+    {
+        double area = 0.0;
+        for (size_t i = 0; i < count; i += 3)
+        {
+            const float* a = Position(grid, indices[i]);
+            const float* b = Position(grid, indices[i + 1]);
+            const float* c = Position(grid, indices[i + 2]);
+            area += 0.5 * ((double(b[2]) - a[2]) * (double(c[0]) - a[0]) - (double(b[0]) - a[0]) * (double(c[2]) - a[2]));
+        }
+        return static_cast<float>(area);
+    }
+
+    // Valid indices, no triangle with two corners at one position, every
+    // border and seam vertex still used and the outline closed.
+    bool IsSound(const Grid& grid, const uint32_t* indices, size_t count)
+    {
+        vector<bool> used(grid.VertexCount(), false);
+        for (size_t i = 0; i < count; i += 3)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                if (indices[i + corner] >= grid.VertexCount()) return false;
+                used[indices[i + corner]] = true;
+            }
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const float* p = Position(grid, indices[i + corner]);
+                const float* q = Position(grid, indices[i + (corner + 1) % 3]);
+                if (p[0] == q[0] && p[1] == q[1] && p[2] == q[2]) return false;
+            }
+        }
+        for (uint32_t vertex : grid.border) if (!used[vertex]) return false;
+        for (uint32_t vertex : grid.seam) if (!used[vertex]) return false;
+        return fabsf(ProjectedArea(grid, indices, count) - grid.area) <= grid.area * 1e-5f;
+    }
+
+    void TestSimplify()
+    {
+        const Grid grid = MakeGrid(32, 1.0f);
+        CHECK(IsSound(grid, grid.indices.data(), grid.indices.size()));
+
+        // The error bound stops the collapses before the index target.
+        vector<uint32_t> lod(grid.indices.size());
+        float error = -1.0f;
+        const size_t count = MeshSimplifier::Simplify(lod.data(), grid.indices.data(), grid.indices.size(),
+            grid.vertices.data(), grid.VertexCount(), kStride, 0, 0.02f, &error);
+        CHECK(count > 0 && count < grid.indices.size() / 2);
+        CHECK(error > 0.0f && error <= 0.02f);
+        CHECK(IsSound(grid, lod.data(), count));
+
+        // A larger bound goes further; the index target is honoured.
+        float coarse_error = 0.0f;
+        const size_t coarse = MeshSimplifier::Simplify(lod.data(), grid.indices.data(), grid.indices.size(),
+            grid.vertices.data(), grid.VertexCount(), kStride, 0, 0.2f, &coarse_error);
+        CHECK(coarse < count && coarse_error >= error && coarse_error <= 0.2f);
+        CHECK(IsSound(grid, lod.data(), coarse));
+        const size_t target = grid.indices.size() / 4 / 3 * 3;
+        const size_t targeted = MeshSimplifier::Simplify(lod.data(), grid.indices.data(), grid.indices.size(),
+            grid.vertices.data(), grid.VertexCount(), kStride, target, 1.0f);
+        CHECK(targeted <= target && targeted * 2 > target);
+
+        // In place, and a flat grid collapses with no error at all.
+        const Grid flat = MakeGrid(16, 0.0f);
+        vector<uint32_t> in_place = flat.indices;
+        float flat_error = -1.0f;
+        const size_t flat_count = MeshSimplifier::Simplify(in_place.data(), in_place.data(), in_place.size(),
+            flat.vertices.data(), flat.VertexCount(), kStride, 0, 0.0f, &flat_error);
+        CHECK(flat_error == 0.0f && flat_count * 3 < flat.indices.size());
+        CHECK(IsSound(flat, in_place.data(), flat_count));
+
+        // A zero bound keeps every triangle of a curved surface.
+        const size_t kept = MeshSimplifier::Simplify(lod.data(), grid.indices.data(), grid.indices.size(),
+            grid.vertices.data(), grid.VertexCount(), kStride, 0, 0.0f);
+        CHECK(kept == grid.indices.size());
+    }
+
+    void TestGenerateLods()
+    {
+        // Two submeshes, the second one with a base vertex.
+        const Grid first = MakeGrid(24, 1.0f);
+        const Grid second = MakeGrid(40, 2.0f);
+        MeshFileData data;
+        data.vertex_stride = kStride;
+        const Grid* grids[2] = { &first, &second };
+        for (const Grid* grid : grids)
+        {
+            MeshFileData::Submesh submesh;
+            submesh.index_count = static_cast<uint32_t>(grid->indices.size());
+            submesh.start_index = static_cast<uint32_t>(data.indices.size());
+            submesh.base_vertex = static_cast<int32_t>(data.vertices.size() / kStride);
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(grid->vertices.data());
+            data.vertices.insert(data.vertices.end(), bytes, bytes + grid->vertices.size() * sizeof(float));
+            data.indices.insert(data.indices.end(), grid->indices.begin(), grid->indices.end());
+            data.submeshes.push_back(submesh);
+        }
+
+        const uint32_t generated = MeshSimplifier::GenerateLods(data, 4, 0.5f, 0.05f);
+        CHECK(generated >= 4);
+        for (uint32_t s = 0; s < 2; ++s)
+        {
+            const MeshFileData::Submesh& submesh = data.submeshes[s];
+            CHECK(!submesh.lods.empty() && submesh.lods.size() <= 4);
+            uint32_t previous_count = submesh.index_count;
+            float previous_error = 0.0f;
+            bool shrinks = true, error_grows = true, sound = true;
+            for (const MeshFileLod& lod : submesh.lods)
+            {
+                shrinks = shrinks && lod.index_count < previous_count && lod.index_count % 3 == 0;
+                error_grows = error_grows && lod.error >= previous_error && lod.error <= 0.05f;
+                previous_count = lod.index_count;
+                previous_error = lod.error;
+
+                // Back to vertices of the grid (the indices are relative to base_vertex).
+                const uint32_t* indices = &data.indices[lod.start_index];
+                sound = sound && lod.start_index + lod.index_count <= data.indices.size() && IsSound(*grids[s], indices, lod.index_count);
+            }
+            CHECK(shrinks);
+            CHECK(error_grows);
+            CHECK(sound);
+        }
+
+        // Submeshes with LODs are left alone.
+        CHECK(MeshSimplifier::GenerateLods(data) == 0);
+    }
+
+    void TestRegister()
+    {
+        DrawBatcher batcher;
+        SubmeshRange range;
+        range.mesh = 3;
+        range.index_count = 600;
+        range.start_index = 100;
+        range.base_vertex = 40;
+        const LodRange lods[3] = { { 300, 700, 0.01f }, { 150, 1000, 0.03f }, { 60, 1150, 0.02f } };
+
+        LodSelector selector;
+        const uint32_t first = LodSelector::RegisterSubmesh(batcher, range, lods, 3, &selector);
+        const uint32_t plain = LodSelector::RegisterSubmesh(batcher, range, nullptr, 0, &selector);
+        CHECK(first == 0 && plain == 4 && batcher.SubmeshCount() == 5);
+
+        // LOD n is handle base + n, drawn with the base range's mesh and base vertex.
+        bool ranges = batcher.Submesh(first).index_count == 600 && batcher.Submesh(first).start_index == 100;
+        for (uint32_t lod = 0; lod < 3; ++lod)
+        {
+            const SubmeshRange& r = batcher.Submesh(first + 1 + lod);
+            ranges = ranges && r.index_count == lods[lod].index_count && r.start_index == lods[lod].start_index
+                && r.mesh == 3 && r.base_vertex == 40;
+        }
+        CHECK(ranges);
+
+        // At most kMaxLods, and no selector needed.
+        vector<LodRange> many(LodSelector::kMaxLods + 3, LodRange{ 3, 0, 0.0f });
+        const uint32_t clipped = LodSelector::RegisterSubmesh(batcher, range, many.data(), static_cast<uint32_t>(many.size()), nullptr);
+        CHECK(clipped == 5 && batcher.SubmeshCount() == 6 + LodSelector::kMaxLods);
+
+        // Errors 0.01, 0.03, 0.03 (kept monotonic) with 1 pixel of error.
+        const uint32_t visible[7] = { 0, 1, 2, 3, 4, 5, 6 };
+        const float radii[7] = { 200.0f, 100.0f, 50.0f, 10.0f, 0.0f, 10.0f, 10.0f };
+        const uint32_t instance_submesh[7] = { first, first, first, first, first, plain, 1000 };
+        uint32_t submeshes[7];
+        selector.Select(visible, 7, radii, instance_submesh, 1.0f, submeshes);
+        CHECK(submeshes[0] == first);           // 0.01 * 200 > 1
+        CHECK(submeshes[1] == first + 1);       // 0.01 * 100 <= 1, 0.03 * 100 > 1
+        CHECK(submeshes[2] == first + 1);       // the third LOD's 0.02 counts as 0.03
+        CHECK(submeshes[3] == first + 3);
+        CHECK(submeshes[4] == first + 3);       // no size on screen: coarsest
+        CHECK(submeshes[5] == plain);           // no LODs
+        CHECK(submeshes[6] == 1000);            // never registered
+    }
+
+    void TestSelect()
+    {
+        // Random errors against the brute force: the last LOD whose error,
+        // and every finer one's, projects within pixel_error.
+        RandomGenerator random(34);
+        LodSelector selector;
+        constexpr uint32_t kSubmeshCount = 64;
+        vector<vector<float>> errors(kSubmeshCount);
+        for (uint32_t s = 0; s < kSubmeshCount; ++s)
+        {
+            errors[s].resize(random.NextUint() % (LodSelector::kMaxLods + 1));
+            for (float& error : errors[s]) error = random.NextFloat(0.0f, 0.1f);
+            selector.SetSubmesh(s * 10, errors[s].data(), static_cast<uint32_t>(errors[s].size()));
+        }
+
+        constexpr uint32_t kCount = 10000;
+        vector<uint32_t> visible(kCount), instance_submesh(kCount * 2), submeshes(kCount);
+        vector<float> radii(kCount);
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            visible[i] = i * 2;
+            instance_submesh[i * 2] = random.NextUint() % kSubmeshCount * 10;
+            radii[i] = random.NextFloat() < 0.05f ? 0.0f : random.NextFloat(1.0f, 500.0f);
+        }
+        selector.Select(visible.data(), kCount, radii.data(), instance_submesh.data(), 2.0f, submeshes.data());
+
+        uint32_t wrong = 0;
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            const uint32_t base = instance_submesh[visible[i]];
+            const vector<float>& e = errors[base / 10];
+            uint32_t lod = 0;
+            float worst = 0.0f;
+            while (lod < e.size() && (radii[i] == 0.0f || max(worst, e[lod]) <= 2.0f / radii[i]))
+            {
+                worst = max(worst, e[lod]);
+                ++lod;
+            }
+            wrong += submeshes[i] != base + lod;
+        }
+        CHECK(wrong == 0);
+    }
+}
+
+int main()
+{
+    TestSimplify();
+    TestGenerateLods();
+    TestRegister();
+    TestSelect();
+    return test::Result();
+}
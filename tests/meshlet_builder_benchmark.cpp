@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------------------
+//  meshlet_builder_benchmark.cpp
+//  Meshlets built per second on a 1M triangle mesh, and IsVisible tests per
+//  microsecond.
+//--------------------------------------------------------------------------------
+#include "meshlet_builder.h"
+#include "test_util.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kRings = 512;
+    constexpr uint32_t kSegments = 1024;
+    constexpr int kRepeat = 3;
+}
+
+int main()
+{
+    vector<float> positions;
+    for (uint32_t r = 0; r <= kRings; ++r)
+    {
+        const float phi = 3.14159265f * r / kRings;
+        for (uint32_t s = 0; s <= kSegments; ++s)
+        {
+            const float theta = 6.28318531f * s / kSegments;
+            positions.push_back(sinf(phi) * cosf(theta));
+            positions.push_back(cosf(phi));
+            positions.push_back(sinf(phi) * sinf(theta));
+        }
+    }
+    vector<uint32_t> indices;
+    for (uint32_t r = 0; r < kRings; ++r)
+    {
+        for (uint32_t s = 0; s < kSegments; ++s)
+        {
+            const uint32_t i = r * (kSegments + 1) + s;
+            const uint32_t quad[6] = { i, i + 1, i + kSegments + 1, i + 1, i + kSegments + 2, i + kSegments + 1 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    MeshletData data;
+    double ms = test::MeasureMs(kRepeat, [&]
+    {
+        data.Clear();
+        MeshletBuilder::Build(data, indices.data(), indices.size(), positions.data(), positions.size() / 3, 3 * sizeof(float));
+    });
+    const size_t meshlet_count = data.meshlets.size();
+    printf("Build                %9.2f ms %10.0f meshlets/s %9.1f triangles/ms   (%zu meshlets, %.1f triangles, %.1f vertices each)\n",
+        ms, meshlet_count / (ms * 0.001), indices.size() / 3 / ms, meshlet_count,
+        static_cast<double>(indices.size() / 3) / meshlet_count, static_cast<double>(data.vertices.size()) / meshlet_count);
+
+    // 90 degree frustum of a camera at z = -3 looking down +z: the front
+    // half of the sphere passes the cone test.
+    const float planes[24] = { 1, 0, 1, 3, -1, 0, 1, 3, 0, 1, 1, 3, 0, -1, 1, 3, 0, 0, 1, 2.9f, 0, 0, -1, 97 };
+    const float eye[3] = { 0.0f, 0.0f, -3.0f };
+    size_t visible = 0;
+    const int passes = 100;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        visible = 0;
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            for (const MeshletBounds& bounds : data.bounds) visible += MeshletBuilder::IsVisible(bounds, eye, planes);
+        }
+    });
+    printf("IsVisible            %9.2f ms %10.1f tests/us   (%zu visible of %zu)\n",
+        ms, meshlet_count * passes / (ms * 1000.0), visible / passes, meshlet_count);
+    return 0;
+}
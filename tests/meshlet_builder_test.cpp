@@ -0,0 +1,229 @@
+//--------------------------------------------------------------------------------
+//  meshlet_builder_test.cpp
+//  MeshletBuilder limits, coverage of the input triangles, determinism, and
+//  conservative bounds (sphere and normal cone) on a sphere and a noisy grid.
+//--------------------------------------------------------------------------------
+#include "meshlet_builder.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct Mesh
+    {
+        vector<float>    positions;     // float3
+        vector<uint32_t> indices;
+        size_t VertexCount() const { return positions.size() / 3; }
+        const float* Position(uint32_t i) const { return &positions[i * 3]; }
+    };
+
+    // Closed UV sphere wound so that cross(p1 - p0, p2 - p0) points out.
+    Mesh MakeSphere(uint32_t rings, uint32_t segments)
+    {
+        Mesh mesh;
+        for (uint32_t r = 0; r <= rings; ++r)
+        {
+            const float phi = 3.14159265f * r / rings;
+            for (uint32_t s = 0; s <= segments; ++s)
+            {
+                const float theta = 6.28318531f * s / segments;
+                mesh.positions.push_back(sinf(phi) * cosf(theta));
+                mesh.positions.push_back(cosf(phi));
+                mesh.positions.push_back(sinf(phi) * sinf(theta));
+            }
+        }
+        for (uint32_t r = 0; r < rings; ++r)
+        {
+            for (uint32_t s = 0; s < segments; ++s)
+            {
+                const uint32_t i = r * (segments + 1) + s;
+                const uint32_t quad[6] = { i, i + 1, i + segments + 1, i + 1, i + segments + 2, i + segments + 1 };
+                mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+            }
+        }
+        return mesh;
+    }
+
+    Mesh MakeNoisyGrid(uint32_t size, uint32_t seed)
+    {
+        RandomGenerator random(seed);
+        Mesh mesh;
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+            {
+                mesh.positions.push_back(static_cast<float>(x));
+                mesh.positions.push_back(random.NextFloat(-0.3f, 0.3f));
+                mesh.positions.push_back(static_cast<float>(y));
+            }
+        }
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const uint32_t i = y * (size + 1) + x;
+                const uint32_t quad[6] = { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 };
+                mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+            }
+        }
+        return mesh;
+    }
+
+    size_t Build(MeshletData& data, const Mesh& mesh)
+    {
+        return MeshletBuilder::Build(data, mesh.indices.data(), mesh.indices.size(),
+            mesh.positions.data(), mesh.VertexCount(), 3 * sizeof(float));
+    }
+
+    // Triangles rotated to start with their smallest vertex (winding kept).
+    array<uint32_t, 3> Canonical(uint32_t a, uint32_t b, uint32_t c)
+    {
+        array<uint32_t, 3> t = { a, b, c };
+        rotate(t.begin(), min_element(t.begin(), t.end()), t.end());
+        return t;
+    }
+
+    void Sub(const float* a, const float* b, float* out) { for (int i = 0; i < 3; ++i) out[i] = a[i] - b[i]; }
+    float Dot(const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+    void CheckMeshlets(const Mesh& mesh)
+    {
+        MeshletData data;
+        const size_t count = Build(data, mesh);
+        CHECK(count == data.meshlets.size() && count == data.bounds.size());
+
+        // Limits, and every input triangle exactly once.
+        vector<array<uint32_t, 3>> expected, built;
+        for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        {
+            expected.push_back(Canonical(mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2]));
+        }
+        bool limits = true, local_in_range = true, spheres = true, cones = true;
+        RandomGenerator random(77);
+        for (size_t m = 0; m < count; ++m)
+        {
+            const Meshlet& meshlet = data.meshlets[m];
+            const MeshletBounds& bounds = data.bounds[m];
+            limits = limits && meshlet.vertex_count > 0 && meshlet.vertex_count <= MeshletBuilder::kMaxVertices
+                && meshlet.triangle_count > 0 && meshlet.triangle_count <= MeshletBuilder::kMaxTriangles;
+            const uint32_t* vertices = &data.vertices[meshlet.vertex_offset];
+            const uint8_t* triangles = &data.triangles[meshlet.triangle_offset];
+            for (uint32_t t = 0; t < meshlet.triangle_count * 3; ++t) local_in_range = local_in_range && triangles[t] < meshlet.vertex_count;
+            if (!local_in_range) break;
+            for (uint32_t t = 0; t < meshlet.triangle_count; ++t)
+            {
+                built.push_back(Canonical(vertices[triangles[t * 3]], vertices[triangles[t * 3 + 1]], vertices[triangles[t * 3 + 2]]));
+            }
+
+            for (uint32_t v = 0; v < meshlet.vertex_count; ++v)
+            {
+                float d[3];
+                Sub(mesh.Position(vertices[v]), bounds.center, d);
+                spheres = spheres && sqrtf(Dot(d, d)) <= bounds.radius * 1.0001f + 1e-5f;
+            }
+
+            // Cone: an eye that sees the front of any triangle must keep the
+            // meshlet (frustum planes that accept everything).
+            const float planes[24] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+            for (int sample = 0; sample < 32; ++sample)
+            {
+                const float eye[3] = { bounds.center[0] + random.NextFloat(-4.0f, 4.0f),
+                    bounds.center[1] + random.NextFloat(-4.0f, 4.0f), bounds.center[2] + random.NextFloat(-4.0f, 4.0f) };
+                if (MeshletBuilder::IsVisible(bounds, eye, planes)) continue;
+                for (uint32_t t = 0; t < meshlet.triangle_count; ++t)
+                {
+                    const float* p0 = mesh.Position(vertices[triangles[t * 3]]);
+                    const float* p1 = mesh.Position(vertices[triangles[t * 3 + 1]]);
+                    const float* p2 = mesh.Position(vertices[triangles[t * 3 + 2]]);
+                    float e1[3], e2[3], to_eye[3];
+                    Sub(p1, p0, e1);
+                    Sub(p2, p0, e2);
+                    Sub(eye, p0, to_eye);
+                    const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                    cones = cones && Dot(n, to_eye) <= 1e-6f;
+                }
+            }
+        }
+        CHECK(limits);
+        CHECK(local_in_range);
+        CHECK(spheres);
+        CHECK(cones);
+        sort(expected.begin(), expected.end());
+        sort(built.begin(), built.end());
+        CHECK(built == expected);
+
+        // Meshlets are reasonably full.
+        CHECK(mesh.indices.size() / 3 <= count * MeshletBuilder::kMaxTriangles * 10 / 7);
+    }
+
+    void TestDeterminism()
+    {
+        const Mesh mesh = MakeSphere(40, 80);
+        MeshletData a, b;
+        Build(a, mesh);
+        Build(b, mesh);
+        CHECK(a.meshlets.size() == b.meshlets.size());
+        CHECK(a.vertices == b.vertices && a.triangles == b.triangles);
+        bool same = a.meshlets.size() == b.meshlets.size();
+        for (size_t i = 0; same && i < a.meshlets.size(); ++i)
+        {
+            same = a.meshlets[i].vertex_offset == b.meshlets[i].vertex_offset && a.meshlets[i].triangle_count == b.meshlets[i].triangle_count
+                && a.bounds[i].radius == b.bounds[i].radius && a.bounds[i].cone_cutoff == b.bounds[i].cone_cutoff;
+        }
+        CHECK(same);
+
+        // Appending offsets the new meshlets past the existing data.
+        const size_t first_count = b.meshlets.size();
+        const size_t appended = Build(b, mesh);
+        CHECK(appended == first_count && b.meshlets.size() == 2 * first_count);
+        const Meshlet& copy = b.meshlets[first_count];
+        CHECK(copy.vertex_offset == a.vertices.size() && copy.triangle_offset == a.triangles.size());
+        CHECK(equal(a.vertices.begin(), a.vertices.end(), b.vertices.begin() + a.vertices.size()));
+
+        MeshletData empty;
+        CHECK(MeshletBuilder::Build(empty, nullptr, 0, nullptr, 0, 12) == 0 && empty.meshlets.empty());
+    }
+
+    void TestFrustum()
+    {
+        MeshletBounds bounds = {};
+        bounds.center[2] = 10.0f;
+        bounds.radius = 1.0f;
+        bounds.cone_cutoff = 1.0f;
+        const float eye[3] = { 0.0f, 0.0f, 0.0f };
+        // Only the near plane z >= 0 matters (the others accept everything).
+        float planes[24] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 1 };
+        CHECK(MeshletBuilder::IsVisible(bounds, eye, planes));
+        bounds.center[2] = -0.9f;
+        CHECK(MeshletBuilder::IsVisible(bounds, eye, planes));  // straddles
+        bounds.center[2] = -1.1f;
+        CHECK(!MeshletBuilder::IsVisible(bounds, eye, planes));
+
+        // A cone of cutoff 0 (every normal along +z) seen from +z is visible,
+        // from -z (behind every triangle) it is rejected.
+        bounds.center[2] = 10.0f;
+        bounds.cone_axis[2] = 1.0f;
+        bounds.cone_cutoff = 0.0f;
+        planes[18] = 0.0f;
+        planes[19] = 1.0f;
+        const float behind[3] = { 0.0f, 0.0f, -10.0f };
+        const float front[3] = { 0.0f, 0.0f, 30.0f };
+        CHECK(!MeshletBuilder::IsVisible(bounds, behind, planes));
+        CHECK(MeshletBuilder::IsVisible(bounds, front, planes));
+    }
+}
+
+int main()
+{
+    CheckMeshlets(MakeSphere(64, 128));
+    CheckMeshlets(MakeNoisyGrid(100, 5));
+    TestDeterminism();
+    TestFrustum();
+    return test::Result();
+}
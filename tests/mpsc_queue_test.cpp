@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------------
+//  mpsc_queue_test.cpp
+//  Full / empty / wrap around of MpscQueue and a multi producer stress test:
+//  nothing lost or duplicated, each producer's values in order.  Run it in
+//  the SANITIZER=thread build as well.
+//--------------------------------------------------------------------------------
+#include "mpsc_queue.h"
+#include "test_util.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    void TestSingleThread()
+    {
+        MpscQueue<int> queue(4);
+        CHECK(queue.Capacity() == 4);
+
+        int value = -1;
+        CHECK(!queue.TryPop(value));
+        for (int i = 0; i < 4; ++i) CHECK(queue.TryPush(i));
+        CHECK(!queue.TryPush(4));
+
+        // The sequence numbers wrap many times around the ring.
+        bool in_order = true;
+        for (int i = 0; i < 1000; ++i)
+        {
+            in_order = in_order && queue.TryPop(value) && value == i;
+            in_order = in_order && queue.TryPush(i + 4);
+        }
+        CHECK(in_order);
+        for (int i = 1000; i < 1004; ++i) CHECK(queue.TryPop(value) && value == i);
+        CHECK(!queue.TryPop(value));
+    }
+
+    void TestMoveOnly()
+    {
+        MpscQueue<unique_ptr<int>> queue(2);
+        CHECK(queue.TryPush(make_unique<int>(7)));
+        unique_ptr<int> value;
+        CHECK(queue.TryPop(value) && value && *value == 7);
+    }
+
+    void TestProducers(uint32_t producer_count, uint32_t capacity)
+    {
+        constexpr uint32_t kPerProducer = 100000;
+        MpscQueue<uint32_t> queue(capacity);
+        atomic<bool> start(false);
+
+        // value = producer << 24 | sequence
+        vector<thread> producers;
+        for (uint32_t producer = 0; producer < producer_count; ++producer)
+        {
+            producers.emplace_back([&queue, &start, producer]
+            {
+                while (!start.load(memory_order_acquire)) this_thread::yield();
+                for (uint32_t i = 0; i < kPerProducer; ++i)
+                {
+                    while (!queue.TryPush(producer << 24 | i)) this_thread::yield();
+                }
+            });
+        }
+
+        vector<uint32_t> next(producer_count, 0);
+        bool in_order = true;
+        uint32_t received = 0;
+        start.store(true, memory_order_release);
+        while (received < producer_count * kPerProducer)
+        {
+            uint32_t value;
+            if (!queue.TryPop(value))
+            {
+                this_thread::yield();
+                continue;
+            }
+            const uint32_t producer = value >> 24;
+            in_order = in_order && producer < producer_count && (value & 0xffffff) == next[producer];
+            if (producer < producer_count) ++next[producer];
+            ++received;
+        }
+        for (thread& producer : producers) producer.join();
+
+        CHECK(in_order);
+        for (uint32_t count : next) CHECK(count == kPerProducer);
+        uint32_t extra;
+        CHECK(!queue.TryPop(extra));
+    }
+}
+
+int main()
+{
+    TestSingleThread();
+    TestMoveOnly();
+    TestProducers(1, 2);
+    TestProducers(4, 2);        // almost always full
+    TestProducers(4, 1024);
+    return test::Result();
+}
@@ -0,0 +1,126 @@
+//--------------------------------------------------------------------------------
+//  pipeline_state_key_benchmark.cpp
+//  Nanoseconds per key for a full graphics pipeline stream: building the key
+//  with shader addresses and with shader contents, and building it plus the
+//  lookup in a cache of 256 pipelines.
+//--------------------------------------------------------------------------------
+#include "pipeline_state_key.h"
+#include "test_util.h"
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kCount = 100000;
+    constexpr int kRepeat = 10;
+    constexpr int kPipelineCount = 256;
+
+    struct Stream
+    {
+        CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE root_signature;
+        CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT input_layout;
+        CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY topology;
+        CD3DX12_PIPELINE_STATE_STREAM_VS vs;
+        CD3DX12_PIPELINE_STATE_STREAM_PS ps;
+        CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC blend;
+        CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1 depth_stencil;
+        CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT depth_stencil_format;
+        CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER rasterizer;
+        CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS render_target_formats;
+        CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC sample_desc;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const PipelineStateKey& key) const { return static_cast<size_t>(key.hash); }
+    };
+
+    D3D12_INPUT_ELEMENT_DESC g_elements[3] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    char g_vs[4096];
+    char g_ps[8192];
+
+    // Pipeline i differs from the others in its depth bias.
+    Stream MakeStream(int i)
+    {
+        Stream stream;
+        stream.root_signature = reinterpret_cast<ID3D12RootSignature*>(0x1000);
+        stream.input_layout = D3D12_INPUT_LAYOUT_DESC{ g_elements, 3 };
+        stream.topology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        stream.vs = D3D12_SHADER_BYTECODE{ g_vs, sizeof(g_vs) };
+        stream.ps = D3D12_SHADER_BYTECODE{ g_ps, sizeof(g_ps) };
+        stream.depth_stencil_format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+        D3D12_RASTERIZER_DESC& rasterizer = stream.rasterizer;
+        rasterizer.DepthBias = i;
+        D3D12_RT_FORMAT_ARRAY formats = {};
+        formats.NumRenderTargets = 1;
+        formats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        stream.render_target_formats = formats;
+        return stream;
+    }
+
+    void Report(const char* name, double ms, uint64_t checksum)
+    {
+        printf("%-28s %8.1f ns/key   (checksum %llu)\n", name, ms * 1.0e6 / kCount,
+            static_cast<unsigned long long>(checksum));
+    }
+}
+
+int main()
+{
+    Stream streams[kPipelineCount];
+    for (int i = 0; i < kPipelineCount; ++i) streams[i] = MakeStream(i);
+    for (size_t i = 0; i < sizeof(g_vs); ++i) g_vs[i] = static_cast<char>(i * 7);
+    for (size_t i = 0; i < sizeof(g_ps); ++i) g_ps[i] = static_cast<char>(i * 13);
+
+    PipelineStateKey key;
+    uint64_t checksum = 0;
+    double ms = test::MeasureMs(kRepeat, [&]
+    {
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(Stream), &streams[i % kPipelineCount] };
+            BuildPipelineStateKey(desc, key);
+            checksum += key.hash;
+        }
+    });
+    Report("build (shader address)", ms, checksum);
+
+    checksum = 0;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(Stream), &streams[i % kPipelineCount] };
+            BuildPipelineStateKey(desc, key, ShaderIdentity::kContents);
+            checksum += key.hash;
+        }
+    });
+    Report("build (shader contents)", ms, checksum);
+
+    unordered_map<PipelineStateKey, int, KeyHash> pipelines;
+    for (int i = 0; i < kPipelineCount; ++i)
+    {
+        D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(Stream), &streams[i] };
+        BuildPipelineStateKey(desc, key);
+        pipelines.emplace(key, i);
+    }
+    checksum = 0;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(Stream), &streams[i % kPipelineCount] };
+            BuildPipelineStateKey(desc, key);
+            const auto found = pipelines.find(key);
+            checksum += found != pipelines.end() ? found->second : 0;
+        }
+    });
+    Report("build + lookup", ms, checksum);
+    return 0;
+}
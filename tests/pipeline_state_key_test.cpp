@@ -0,0 +1,233 @@
+//--------------------------------------------------------------------------------
+//  pipeline_state_key_test.cpp
+//  Distinct pipeline descriptions give distinct keys and hashes, equivalent
+//  ones (order, explicit defaults, ignored fields) equal keys; malformed
+//  streams are rejected (Windows only: the key reads d3d12.h structs).
+//--------------------------------------------------------------------------------
+#include "pipeline_state_key.h"
+#include "test_util.h"
+#include <cstring>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct Stream
+    {
+        CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE root_signature;
+        CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT input_layout;
+        CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY topology;
+        CD3DX12_PIPELINE_STATE_STREAM_VS vs;
+        CD3DX12_PIPELINE_STATE_STREAM_PS ps;
+        CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC blend;
+        CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1 depth_stencil;
+        CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT depth_stencil_format;
+        CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER rasterizer;
+        CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS render_target_formats;
+        CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC sample_desc;
+        CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK sample_mask;
+    };
+
+    D3D12_INPUT_ELEMENT_DESC g_elements[3] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    char g_vs[4096];
+    char g_ps[8192];
+    char g_other_shader[8192];
+
+    Stream MakeStream()
+    {
+        Stream stream;
+        stream.root_signature = reinterpret_cast<ID3D12RootSignature*>(0x1000);
+        stream.input_layout = D3D12_INPUT_LAYOUT_DESC{ g_elements, 3 };
+        stream.topology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        stream.vs = D3D12_SHADER_BYTECODE{ g_vs, sizeof(g_vs) };
+        stream.ps = D3D12_SHADER_BYTECODE{ g_ps, sizeof(g_ps) };
+        stream.depth_stencil_format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+        D3D12_RT_FORMAT_ARRAY formats = {};
+        formats.NumRenderTargets = 1;
+        formats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        stream.render_target_formats = formats;
+        return stream;
+    }
+
+    PipelineStateKey BuildKey(Stream& stream, ShaderIdentity identity = ShaderIdentity::kAddress)
+    {
+        D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(stream), &stream };
+        PipelineStateKey key;
+        CHECK(BuildPipelineStateKey(desc, key, identity));
+        return key;
+    }
+
+    D3D12_BLEND_DESC& Blend(Stream& stream) { return stream.blend; }
+    D3D12_DEPTH_STENCIL_DESC1& DepthStencil(Stream& stream) { return stream.depth_stencil; }
+    D3D12_RASTERIZER_DESC& Rasterizer(Stream& stream) { return stream.rasterizer; }
+    D3D12_RT_FORMAT_ARRAY& Formats(Stream& stream) { return stream.render_target_formats; }
+
+    void TestDistinct()
+    {
+        // One change per description, each to a field the driver reads.
+        static D3D12_INPUT_ELEMENT_DESC elements[3];
+        const vector<function<void(Stream&)>> changes =
+        {
+            [](Stream&) {},
+            [](Stream& s) { s.root_signature = reinterpret_cast<ID3D12RootSignature*>(0x2000); },
+            [](Stream& s) { s.input_layout = D3D12_INPUT_LAYOUT_DESC{ g_elements, 2 }; },
+            [](Stream& s)
+            {
+                memcpy(elements, g_elements, sizeof(elements));
+                elements[2].AlignedByteOffset = 28;
+                s.input_layout = D3D12_INPUT_LAYOUT_DESC{ elements, 3 };
+            },
+            [](Stream& s) { s.topology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; },
+            [](Stream& s) { s.vs = D3D12_SHADER_BYTECODE{ g_other_shader, sizeof(g_vs) }; },
+            [](Stream& s) { s.vs = D3D12_SHADER_BYTECODE{ g_vs, sizeof(g_vs) - 4 }; },
+            [](Stream& s) { s.ps = D3D12_SHADER_BYTECODE{ g_other_shader, sizeof(g_ps) }; },
+            [](Stream& s) { s.ps = D3D12_SHADER_BYTECODE{ nullptr, 0 }; },
+            [](Stream& s) { Blend(s).AlphaToCoverageEnable = 1; },
+            [](Stream& s) { Blend(s).RenderTarget[0].BlendEnable = 1; },
+            [](Stream& s)
+            {
+                Blend(s).RenderTarget[0].BlendEnable = 1;
+                Blend(s).RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA;
+                Blend(s).RenderTarget[0].DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+            },
+            [](Stream& s) { Blend(s).RenderTarget[0].RenderTargetWriteMask = 7; },
+            [](Stream& s) { DepthStencil(s).DepthEnable = 0; },
+            [](Stream& s) { DepthStencil(s).DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; },
+            [](Stream& s) { DepthStencil(s).DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS; },
+            [](Stream& s) { DepthStencil(s).StencilEnable = 1; },
+            [](Stream& s) { DepthStencil(s).DepthBoundsTestEnable = 1; },
+            [](Stream& s) { s.depth_stencil_format = DXGI_FORMAT_UNKNOWN; },
+            [](Stream& s) { Rasterizer(s).FillMode = D3D12_FILL_MODE_WIREFRAME; },
+            [](Stream& s) { Rasterizer(s).CullMode = D3D12_CULL_MODE_NONE; },
+            [](Stream& s) { Rasterizer(s).FrontCounterClockwise = 1; },
+            [](Stream& s) { Rasterizer(s).DepthBias = 1; },
+            [](Stream& s) { Rasterizer(s).SlopeScaledDepthBias = 1.0f; },
+            [](Stream& s) { Rasterizer(s).DepthClipEnable = 0; },
+            [](Stream& s) { Formats(s).RTFormats[0] = DXGI_FORMAT_R32G32_FLOAT; },
+            [](Stream& s) { Formats(s).NumRenderTargets = 2; Formats(s).RTFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM; },
+            [](Stream& s) { s.sample_desc = DXGI_SAMPLE_DESC{ 4, 0 }; },
+            [](Stream& s) { s.sample_desc = DXGI_SAMPLE_DESC{ 1, 1 }; },
+            [](Stream& s) { s.sample_mask = 1u; },
+        };
+
+        vector<PipelineStateKey> keys;
+        for (const auto& change : changes)
+        {
+            Stream stream = MakeStream();
+            change(stream);
+            keys.push_back(BuildKey(stream));
+        }
+        bool distinct = true;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            for (size_t j = i + 1; j < keys.size(); ++j)
+            {
+                const bool differ = keys[i] != keys[j] && keys[i].hash != keys[j].hash && Differences(keys[i], keys[j]) != 0;
+                if (!differ) printf("descriptions %zu and %zu give the same key\n", i, j);
+                distinct = distinct && differ;
+            }
+        }
+        CHECK(distinct);
+
+        // Many values of one field: no hash collision.
+        unordered_set<uint64_t> hashes;
+        for (int bias = 0; bias < 10000; ++bias)
+        {
+            Stream stream = MakeStream();
+            Rasterizer(stream).DepthBias = bias;
+            hashes.insert(BuildKey(stream).hash);
+        }
+        CHECK(hashes.size() == 10000);
+    }
+
+    void TestEquivalent()
+    {
+        const Stream base = MakeStream();
+        Stream stream = base;
+        const PipelineStateKey key = BuildKey(stream);
+
+        // Blend factors of a disabled target and stencil ops with stencil off
+        // are ignored by the driver.
+        Blend(stream).RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        Blend(stream).RenderTarget[3].DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        DepthStencil(stream).FrontFace.StencilFunc = D3D12_COMPARISON_FUNC_LESS;
+        CHECK(BuildKey(stream) == key);
+        CHECK(Differences(BuildKey(stream), key) == 0);
+
+        // The blend change shows in Differences once it matters.
+        Blend(stream).RenderTarget[0].BlendEnable = 1;
+        CHECK(Differences(BuildKey(stream), key) == 1ull << D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND);
+
+        // Another order, explicit defaults and DEPTH_STENCIL for DEPTH_STENCIL1.
+        struct Short
+        {
+            CD3DX12_PIPELINE_STATE_STREAM_VS vs;
+            CD3DX12_PIPELINE_STATE_STREAM_PS ps;
+            CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1 depth_stencil;
+        } a;
+        struct Reordered
+        {
+            CD3DX12_PIPELINE_STATE_STREAM_FLAGS flags;
+            CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK sample_mask;
+            CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL depth_stencil;
+            CD3DX12_PIPELINE_STATE_STREAM_PS ps;
+            CD3DX12_PIPELINE_STATE_STREAM_VS vs;
+        } b;
+        a.vs = b.vs = D3D12_SHADER_BYTECODE{ g_vs, sizeof(g_vs) };
+        a.ps = b.ps = D3D12_SHADER_BYTECODE{ g_ps, sizeof(g_ps) };
+        D3D12_PIPELINE_STATE_STREAM_DESC desc_a = { sizeof(a), &a };
+        D3D12_PIPELINE_STATE_STREAM_DESC desc_b = { sizeof(b), &b };
+        PipelineStateKey key_a, key_b;
+        CHECK(BuildPipelineStateKey(desc_a, key_a) && BuildPipelineStateKey(desc_b, key_b));
+        CHECK(key_a == key_b && key_a.hash == key_b.hash);
+
+        // Same bytecode at another address: equal by contents only.
+        memcpy(g_other_shader, g_vs, sizeof(g_vs));
+        Stream copy = base;
+        copy.vs = D3D12_SHADER_BYTECODE{ g_other_shader, sizeof(g_vs) };
+        Stream original = base;
+        CHECK(BuildKey(copy) != BuildKey(original));
+        CHECK(BuildKey(copy, ShaderIdentity::kContents) == BuildKey(original, ShaderIdentity::kContents));
+        memset(g_other_shader, 0, sizeof(g_other_shader));
+    }
+
+    void TestRejected()
+    {
+        struct Duplicated
+        {
+            CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL depth_stencil;
+            CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1 depth_stencil1;
+        } duplicated;
+        D3D12_PIPELINE_STATE_STREAM_DESC desc = { sizeof(duplicated), &duplicated };
+        PipelineStateKey key;
+        CHECK(!BuildPipelineStateKey(desc, key));
+
+        Stream stream = MakeStream();
+        desc = { sizeof(stream) - 4, &stream };
+        CHECK(!BuildPipelineStateKey(desc, key));
+
+        // The key is reused without allocating once warmed up.
+        desc = { sizeof(stream), &stream };
+        CHECK(BuildPipelineStateKey(desc, key));
+        const size_t capacity = key.words.capacity();
+        const uint32_t* data = key.words.data();
+        CHECK(BuildPipelineStateKey(desc, key));
+        CHECK(key.words.capacity() == capacity && key.words.data() == data);
+    }
+}
+
+int main()
+{
+    TestDistinct();
+    TestEquivalent();
+    TestRejected();
+    return test::Result();
+}
@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------
+//  random_generator_benchmark.cpp
+//  Samples per microsecond of RandomGenerator against rand(), single calls
+//  and bulk fill.
+//--------------------------------------------------------------------------------
+#include "random_generator.h"
+#include "test_util.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr int kCount = 1 << 22;
+    constexpr int kRepeat = 10;
+
+    void Report(const char* name, double ms, double checksum)
+    {
+        printf("%-28s %8.1f samples/us   (checksum %.3f)\n", name, kCount / (ms * 1000.0), checksum);
+    }
+}
+
+int main()
+{
+    double checksum = 0.0;
+    double ms = test::MeasureMs(kRepeat, [&checksum]
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < kCount; ++i) sum += static_cast<float>(rand()) / (RAND_MAX + 1.0f);
+        checksum = sum;
+    });
+    Report("rand() float", ms, checksum);
+
+    RandomGenerator generator;
+    ms = test::MeasureMs(kRepeat, [&generator, &checksum]
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < kCount; ++i) sum += generator.NextFloat();
+        checksum = sum;
+    });
+    Report("NextFloat", ms, checksum);
+
+    ms = test::MeasureMs(kRepeat, [&checksum]
+    {
+        RandomGenerator& local = RandomGenerator::ThreadLocal();
+        float sum = 0.0f;
+        for (int i = 0; i < kCount; ++i) sum += local.NextFloat();
+        checksum = sum;
+    });
+    Report("ThreadLocal().NextFloat", ms, checksum);
+
+    vector<float> values(kCount);
+    ms = test::MeasureMs(kRepeat, [&generator, &values, &checksum]
+    {
+        generator.FillFloat(values.data(), values.size());
+        checksum = values[kCount / 2];
+    });
+    Report("FillFloat", ms, checksum);
+
+    ms = test::MeasureMs(kRepeat, [&checksum]
+    {
+        int sum = 0;
+        for (int i = 0; i < kCount; ++i) sum += rand() % 100;
+        checksum = sum;
+    });
+    Report("rand() % 100", ms, checksum);
+
+    ms = test::MeasureMs(kRepeat, [&generator, &checksum]
+    {
+        int sum = 0;
+        for (int i = 0; i < kCount; ++i) sum += generator.NextInt(0, 99);
+        checksum = sum;
+    });
+    Report("NextInt(0, 99)", ms, checksum);
+    return 0;
+}
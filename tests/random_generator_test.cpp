@@ -0,0 +1,191 @@
+//--------------------------------------------------------------------------------
+//  random_generator_test.cpp
+//  Reproducibility and statistical checks of RandomGenerator.  Seeds are
+//  fixed, so the statistics are deterministic; the bounds are the 99.9%
+//  quantiles of the tests.
+//--------------------------------------------------------------------------------
+#include "random_generator.h"
+#include "test_util.h"
+#include <climits>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr int kSampleCount = 1 << 20;
+
+    // Pearson's statistic of observed counts against a uniform expectation.
+    double ChiSquare(const vector<int>& counts, int total)
+    {
+        const double expected = static_cast<double>(total) / counts.size();
+        double chi_square = 0.0;
+        for (int count : counts) chi_square += (count - expected) * (count - expected) / expected;
+        return chi_square;
+    }
+
+    void TestReproducible()
+    {
+        RandomGenerator a(1234), b(1234), c(1235);
+        bool same = true;
+        bool differs = false;
+        for (int i = 0; i < 1000; ++i)
+        {
+            const uint32_t value = a.NextUint();
+            same = same && value == b.NextUint();
+            differs = differs || value != c.NextUint();
+        }
+        CHECK(same);
+        CHECK(differs);
+
+        // Seed resets the sequence.
+        a.Seed(99);
+        const uint32_t first = a.NextUint();
+        a.Seed(99);
+        CHECK(a.NextUint() == first);
+
+        // A zero seed still gives a working generator.
+        RandomGenerator zero(0);
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; ++i) bits |= zero.NextUint();
+        CHECK(bits != 0);
+    }
+
+    void TestFloatDistribution()
+    {
+        RandomGenerator generator(42);
+        vector<int> bins(64, 0);
+        double sum = 0.0, sum_sq = 0.0, lag_product = 0.0;
+        float previous = generator.NextFloat();
+        float min_value = 1.0f, max_value = 0.0f;
+        for (int i = 0; i < kSampleCount; ++i)
+        {
+            const float value = generator.NextFloat();
+            min_value = min(min_value, value);
+            max_value = max(max_value, value);
+            ++bins[static_cast<int>(value * bins.size())];
+            sum += value;
+            sum_sq += value * value;
+            lag_product += (value - 0.5) * (previous - 0.5);
+            previous = value;
+        }
+        CHECK(min_value >= 0.0f && max_value < 1.0f);
+
+        const double mean = sum / kSampleCount;
+        const double variance = sum_sq / kSampleCount - mean * mean;
+        const double serial_correlation = lag_product / kSampleCount / variance;
+        CHECK(fabs(mean - 0.5) < 3.3 * sqrt(1.0 / 12.0 / kSampleCount));
+        CHECK(fabs(variance - 1.0 / 12.0) < 1e-3);
+        CHECK(fabs(serial_correlation) < 3.3 / sqrt(static_cast<double>(kSampleCount)));
+        CHECK(ChiSquare(bins, kSampleCount) < 103.4);       // 63 degrees of freedom
+
+        // Pairs of consecutive samples fill the unit square evenly.
+        vector<int> cells(16 * 16, 0);
+        for (int i = 0; i < kSampleCount; ++i)
+        {
+            const int x = static_cast<int>(generator.NextFloat() * 16);
+            const int y = static_cast<int>(generator.NextFloat() * 16);
+            ++cells[y * 16 + x];
+        }
+        CHECK(ChiSquare(cells, kSampleCount) < 330.5);      // 255 degrees of freedom
+
+        RandomGenerator ranged(7);
+        bool in_range = true;
+        for (int i = 0; i < 10000; ++i)
+        {
+            const float value = ranged.NextFloat(-2.0f, 3.0f);
+            in_range = in_range && value >= -2.0f && value < 3.0f;
+        }
+        CHECK(in_range);
+    }
+
+    void TestUintBits()
+    {
+        RandomGenerator generator(5);
+        int bit_counts[32] = {};
+        for (int i = 0; i < kSampleCount; ++i)
+        {
+            const uint32_t value = generator.NextUint();
+            for (int bit = 0; bit < 32; ++bit) bit_counts[bit] += (value >> bit) & 1;
+        }
+        // Every bit is set half of the time (binomial, 3.3 sigma).
+        const double tolerance = 3.3 * sqrt(kSampleCount * 0.25);
+        bool balanced = true;
+        for (int count : bit_counts) balanced = balanced && fabs(count - kSampleCount * 0.5) < tolerance;
+        CHECK(balanced);
+    }
+
+    void TestInt()
+    {
+        RandomGenerator generator(11);
+        vector<int> counts(7, 0);
+        bool in_range = true;
+        for (int i = 0; i < kSampleCount; ++i)
+        {
+            const int value = generator.NextInt(-3, 3);
+            in_range = in_range && value >= -3 && value <= 3;
+            if (value >= -3 && value <= 3) ++counts[value + 3];
+        }
+        CHECK(in_range);
+        CHECK(ChiSquare(counts, kSampleCount) < 22.46);     // 6 degrees of freedom
+
+        // A range that does not divide 2^32: rejection keeps it unbiased.
+        const int range = 3 << 29;
+        int low_half = 0;
+        for (int i = 0; i < kSampleCount; ++i) low_half += generator.NextInt(0, range - 1) < range / 2;
+        CHECK(fabs(low_half - kSampleCount * 0.5) < 3.3 * sqrt(kSampleCount * 0.25));
+
+        CHECK(generator.NextInt(5, 5) == 5);
+        bool full_range_varies = false;
+        const int first = generator.NextInt(INT_MIN, INT_MAX);
+        for (int i = 0; i < 8; ++i) full_range_varies = full_range_varies || generator.NextInt(INT_MIN, INT_MAX) != first;
+        CHECK(full_range_varies);
+    }
+
+    void TestFill()
+    {
+        RandomGenerator bulk(77), single(77);
+        vector<float> values(1001);
+        bulk.FillFloat(values.data(), values.size());
+        bool same = true;
+        for (float value : values) same = same && value == single.NextFloat();
+        CHECK(same);
+        // The state advanced as if by single calls.
+        CHECK(bulk.NextUint() == single.NextUint());
+    }
+
+    void TestThreadLocal()
+    {
+        // Threads draw from different streams, reproducible from the global
+        // seed and the order the threads first use their generator.
+        auto run = [](uint32_t* first, uint32_t* second)
+        {
+            RandomGenerator::SetGlobalSeed(2024);
+            thread([first] { *first = RandomGenerator::ThreadLocal().NextUint(); }).join();
+            thread([second] { *second = RandomGenerator::ThreadLocal().NextUint(); }).join();
+        };
+        uint32_t a0 = 0, a1 = 0, b0 = 0, b1 = 0;
+        run(&a0, &a1);
+        run(&b0, &b1);
+        CHECK(a0 == b0);
+        CHECK(a1 == b1);
+        CHECK(a0 != a1);
+
+        // The same thread keeps its generator.
+        RandomGenerator* first = &RandomGenerator::ThreadLocal();
+        CHECK(first == &RandomGenerator::ThreadLocal());
+    }
+}
+
+int main()
+{
+    TestReproducible();
+    TestFloatDistribution();
+    TestUintBits();
+    TestInt();
+    TestFill();
+    TestThreadLocal();
+    return test::Result();
+}
@@ -0,0 +1,202 @@
+//--------------------------------------------------------------------------------
+//  render_target_pool_test.cpp
+//  RenderTargetAllocator, the slot choice behind RenderTargetPool: smallest
+//  fit, growing a too small free slot, fence gating, 128 pixel rounding and
+//  running out of slots, then a random resize / MSAA toggle trace against a
+//  brute force model.
+//--------------------------------------------------------------------------------
+#include "render_target_allocator.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    RenderTargetKind Kind(uint32_t format, uint32_t samples = 1, bool depth = false)
+    {
+        RenderTargetKind kind;
+        kind.format = format;
+        kind.view_format = format;
+        kind.sample_count = samples;
+        kind.depth_stencil = depth;
+        return kind;
+    }
+
+    void TestRounding()
+    {
+        RenderTargetAllocator allocator;
+        bool create = false;
+        const uint32_t a = allocator.Acquire(Kind(1), 800, 600, 0, &create);
+        CHECK(a == 0 && create);
+        CHECK(allocator.Slot(a).width == 896 && allocator.Slot(a).height == 640);
+        CHECK(allocator.Slot(a).in_use);
+        const uint32_t b = allocator.Acquire(Kind(1), 128, 1, 0, &create);
+        CHECK(b == 1 && create && allocator.Slot(b).width == 128 && allocator.Slot(b).height == 128);
+        CHECK(RenderTargetAllocator::RoundUp(1) == 128 && RenderTargetAllocator::RoundUp(256) == 256 && RenderTargetAllocator::RoundUp(257) == 384);
+    }
+
+    void TestReuse()
+    {
+        RenderTargetAllocator allocator;
+        bool create = false;
+        const uint32_t large = allocator.Acquire(Kind(1), 1920, 1080, 0, &create);
+        const uint32_t small = allocator.Acquire(Kind(1), 1280, 720, 0, &create);
+        const uint32_t other = allocator.Acquire(Kind(2), 640, 480, 0, &create);
+        allocator.Release(large, 1);
+        allocator.Release(small, 1);
+        allocator.Release(other, 1);
+
+        // Smallest that fits, whatever the order; another kind never.
+        CHECK(allocator.Acquire(Kind(1), 600, 400, 1, &create) == small && !create);
+        CHECK(allocator.Acquire(Kind(1), 600, 400, 1, &create) == large && !create);
+        CHECK(allocator.Acquire(Kind(1), 600, 400, 1, &create) == 3 && create);
+        CHECK(allocator.Acquire(Kind(2, 4), 600, 400, 1, &create) == 4 && create);
+        CHECK(allocator.Acquire(Kind(2, 1, true), 600, 400, 1, &create) == 5 && create);
+        RenderTargetKind quality = Kind(2);
+        quality.sample_quality = 1;
+        CHECK(allocator.Acquire(quality, 600, 400, 1, &create) == 6 && create);
+        CHECK(allocator.Acquire(Kind(2), 600, 400, 1, &create) == other && !create);
+        CHECK(allocator.Count() == 7);
+    }
+
+    void TestGrow()
+    {
+        RenderTargetAllocator allocator;
+        bool create = false;
+        const uint32_t a = allocator.Acquire(Kind(1), 1000, 300, 0, &create);
+        allocator.Release(a, 0);
+
+        // Too small in one dimension: grown to cover both, in place.
+        CHECK(allocator.Acquire(Kind(1), 500, 700, 0, &create) == a && create);
+        CHECK(allocator.Slot(a).width == 1024 && allocator.Slot(a).height == 768);
+        allocator.Release(a, 0);
+        CHECK(allocator.Acquire(Kind(1), 1000, 700, 0, &create) == a && !create);
+        allocator.Release(a, 0);
+
+        // Sizes never shrink.
+        CHECK(allocator.Acquire(Kind(1), 16, 16, 0, &create) == a && !create);
+        CHECK(allocator.Slot(a).width == 1024 && allocator.Slot(a).height == 768);
+        CHECK(allocator.Count() == 1);
+
+        // A slot that fits wins over one to grow.
+        const uint32_t b = allocator.Acquire(Kind(1), 128, 128, 0, &create);
+        allocator.Release(a, 0);
+        allocator.Release(b, 0);
+        CHECK(allocator.Acquire(Kind(1), 1024, 768, 0, &create) == a && !create);
+    }
+
+    void TestFence()
+    {
+        RenderTargetAllocator allocator;
+        bool create = false;
+        const uint32_t a = allocator.Acquire(Kind(1), 512, 512, 0, &create);
+        allocator.Release(a, 5);
+
+        // Not before the GPU passed fence 5: a second slot, then the first one again.
+        CHECK(allocator.Acquire(Kind(1), 512, 512, 4, &create) == 1 && create);
+        CHECK(allocator.Acquire(Kind(1), 512, 512, 5, &create) == a && !create);
+        CHECK(allocator.Count() == 2);
+
+        // Nor is it grown before then.
+        allocator.Release(a, 9);
+        CHECK(allocator.Acquire(Kind(1), 2048, 512, 8, &create) == 2 && create);
+        CHECK(allocator.Slot(a).width == 512);
+
+        // A grown slot is free for the next request right away.
+        allocator.Release(2, 10);
+        const uint32_t grown = allocator.Acquire(Kind(1), 4096, 512, 10, &create);
+        CHECK(grown == a && create && allocator.Slot(grown).fence == 0);
+    }
+
+    void TestExhaustion()
+    {
+        RenderTargetAllocator allocator;
+        bool create = false;
+        for (uint32_t i = 0; i < RenderTargetAllocator::kMaxTargets; ++i)
+        {
+            CHECK(allocator.Acquire(Kind(i), 256, 256, 0, &create) == i);
+        }
+        CHECK(allocator.Acquire(Kind(100), 256, 256, 0, &create) == RenderTargetAllocator::kInvalid);
+        CHECK(allocator.Count() == RenderTargetAllocator::kMaxTargets);
+
+        // In flight, or in use: still full.
+        allocator.Release(3, 7);
+        CHECK(allocator.Acquire(Kind(3), 256, 256, 6, &create) == RenderTargetAllocator::kInvalid);
+        CHECK(allocator.Acquire(Kind(3), 256, 256, 7, &create) == 3 && !create);
+
+        allocator.Clear();
+        CHECK(allocator.Count() == 0 && allocator.Acquire(Kind(100), 256, 256, 0, &create) == 0);
+    }
+
+    void TestTrace()
+    {
+        // Frames acquire depth, MSAA color (when on) and scene color (when
+        // scaled) at a size that jumps now and then, and release them with
+        // their own fence while the GPU is two frames behind.  Each choice is
+        // checked against the rules re-derived here.
+        RandomGenerator random(45);
+        RenderTargetAllocator allocator;
+        uint32_t width = 1280, height = 720, creates = 0;
+        bool msaa = false;
+        uint32_t wrong = 0;
+        for (uint64_t frame = 1; frame <= 3000; ++frame)
+        {
+            const uint64_t completed = frame > 2 ? frame - 2 : 0;
+            vector<uint32_t> held;
+
+            if (random.NextFloat() < 0.05f)
+            {
+                width = 200 + random.NextUint() % 1800;
+                height = 200 + random.NextUint() % 1000;
+            }
+            if (random.NextFloat() < 0.01f) msaa = !msaa;
+
+            vector<RenderTargetKind> kinds = { Kind(1, msaa ? 4 : 1, true) };
+            if (msaa) kinds.push_back(Kind(2, 4));
+            if (random.NextFloat() < 0.5f) kinds.push_back(Kind(2));
+            for (const RenderTargetKind& kind : kinds)
+            {
+                // Expected: the smallest free fitting slot, else the first free one to grow, else a new one.
+                uint32_t best = RenderTargetAllocator::kInvalid, grow = RenderTargetAllocator::kInvalid;
+                for (uint32_t i = 0; i < allocator.Count(); ++i)
+                {
+                    const RenderTargetSlot& slot = allocator.Slot(i);
+                    if (slot.in_use || slot.fence > completed || !(slot.kind == kind)) continue;
+                    if (slot.width >= width && slot.height >= height)
+                    {
+                        if (best == RenderTargetAllocator::kInvalid
+                            || uint64_t(slot.width) * slot.height < uint64_t(allocator.Slot(best).width) * allocator.Slot(best).height) best = i;
+                    }
+                    else if (grow == RenderTargetAllocator::kInvalid) grow = i;
+                }
+                const uint32_t expected = best != RenderTargetAllocator::kInvalid ? best
+                    : grow != RenderTargetAllocator::kInvalid ? grow : allocator.Count();
+
+                bool create = false;
+                const uint32_t index = allocator.Acquire(kind, width, height, completed, &create);
+                const RenderTargetSlot& slot = allocator.Slot(index);
+                wrong += index != expected || create != (best == RenderTargetAllocator::kInvalid);
+                wrong += slot.width < width || slot.height < height || slot.width % 128 != 0 || slot.height % 128 != 0;
+                creates += create;
+                held.push_back(index);
+            }
+            for (uint32_t index : held) allocator.Release(index, frame);
+        }
+        CHECK(wrong == 0);
+        CHECK(allocator.Count() <= 3 * 3 + 3);
+        CHECK(creates < 3000 / 10);
+    }
+}
+
+int main()
+{
+    TestRounding();
+    TestReuse();
+    TestGrow();
+    TestFence();
+    TestExhaustion();
+    TestTrace();
+    return test::Result();
+}
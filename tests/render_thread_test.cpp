@@ -0,0 +1,200 @@
+//--------------------------------------------------------------------------------
+//  render_thread_test.cpp
+//  Handoff between the game thread and RenderThread with a fake backend:
+//  commands (mouse input included) execute in posting order, the game
+//  stays at most two frames ahead, a packet is never written while it is
+//  rendered, posts from other threads and wake ups after the render thread
+//  fell asleep are not lost.
+//  Run it in the SANITIZER=thread build as well.
+//--------------------------------------------------------------------------------
+#include "render_thread.h"
+#include "test_util.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct Event
+    {
+        char     type;      // 'F'rame, 'R'esize, mouse 'D'own / 'U'p / 'M'ove
+        uint64_t value;
+    };
+
+    class FakeBackend : public RenderBackend
+    {
+    public:
+        void PrepareRender(const RenderPacket& packet) override
+        {
+            packet_ = &packet;
+            frame_index_ = packet.frame_index;
+            delta_time_ = packet.delta_time;
+        }
+
+        void Render() override
+        {
+            // Render reads the packet again: the game thread must not have
+            // reused it in between.
+            if ((frame_index_ & 15) == 0) this_thread::sleep_for(chrono::microseconds(200));
+            packet_intact_ = packet_intact_ && packet_->frame_index == frame_index_ && packet_->delta_time == delta_time_;
+            events_.push_back({ 'F', frame_index_ });
+        }
+
+        void OnResize(uint32_t width, uint32_t height) override
+        {
+            resize_sizes_match_ = resize_sizes_match_ && height == width + 1;
+            events_.push_back({ 'R', width });
+        }
+
+        void OnMouseDown(uint32_t state, int x, int y) override { OnMouse('D', state, x, y); }
+        void OnMouseUp(uint32_t state, int x, int y) override { OnMouse('U', state, x, y); }
+        void OnMouseMove(uint32_t state, int x, int y) override { OnMouse('M', state, x, y); }
+
+        bool GetMsaaState() const override { return msaa_; }
+        void SetMsaaState(bool value) override { msaa_ = value; ++msaa_toggles_; }
+        bool GetDynamicResolutionState() const override { return dynamic_resolution_; }
+        void SetDynamicResolutionState(bool value) override { dynamic_resolution_ = value; ++dynamic_resolution_toggles_; }
+
+        // Read after RenderThread::Release joined the render thread.
+        vector<Event> events_;
+        bool packet_intact_ = true;
+        bool resize_sizes_match_ = true;
+        bool mouse_arguments_match_ = true;
+        bool msaa_ = false;
+        bool dynamic_resolution_ = false;
+        uint32_t msaa_toggles_ = 0;
+        uint32_t dynamic_resolution_toggles_ = 0;
+
+    private:
+        // x is the value, y and state are derived from it.
+        void OnMouse(char type, uint32_t state, int x, int y)
+        {
+            mouse_arguments_match_ = mouse_arguments_match_ && y == -x && state == static_cast<uint32_t>(x) * 3;
+            events_.push_back({ type, static_cast<uint64_t>(x) });
+        }
+
+        const RenderPacket* packet_ = nullptr;
+        uint64_t frame_index_ = 0;
+        float delta_time_ = 0.0f;
+    };
+
+    void TestFrames()
+    {
+        constexpr uint64_t kFrameCount = 5000;
+        FakeBackend backend;
+        RenderThread* render_thread = RenderThread::Create();
+        render_thread->Initialize(&backend);
+
+        vector<Event> expected;
+        bool within_two_frames = true;
+        for (uint64_t frame = 0; frame < kFrameCount; ++frame)
+        {
+            RenderPacket& packet = render_thread->BeginPacket();
+            within_two_frames = within_two_frames && render_thread->FramesRendered() + 2 >= frame;
+            packet.frame_index = frame;
+            packet.delta_time = static_cast<float>(frame) * 0.5f;
+            render_thread->SubmitPacket();
+            expected.push_back({ 'F', frame });
+
+            if (frame % 97 == 0)
+            {
+                render_thread->PostResize(static_cast<uint32_t>(frame), static_cast<uint32_t>(frame) + 1);
+                expected.push_back({ 'R', frame });
+            }
+            if (frame % 3 == 0)
+            {
+                const char types[3] = { 'D', 'M', 'U' };
+                const char type = types[frame / 3 % 3];
+                const int x = static_cast<int>(frame);
+                if (type == 'D') render_thread->PostMouseDown(x * 3, x, -x);
+                if (type == 'M') render_thread->PostMouseMove(x * 3, x, -x);
+                if (type == 'U') render_thread->PostMouseUp(x * 3, x, -x);
+                expected.push_back({ type, frame });
+            }
+        }
+        render_thread->Release();
+
+        CHECK(within_two_frames);
+        CHECK(backend.packet_intact_);
+        CHECK(backend.resize_sizes_match_);
+        CHECK(backend.mouse_arguments_match_);
+        bool same_order = backend.events_.size() == expected.size();
+        for (size_t i = 0; same_order && i < expected.size(); ++i)
+        {
+            same_order = backend.events_[i].type == expected[i].type && backend.events_[i].value == expected[i].value;
+        }
+        CHECK(same_order);
+    }
+
+    void TestOtherThreads()
+    {
+        constexpr uint32_t kPosterCount = 3;
+        constexpr uint32_t kTogglesPerPoster = 1000;
+        FakeBackend backend;
+        RenderThread* render_thread = RenderThread::Create();
+        render_thread->Initialize(&backend);
+
+        vector<thread> posters;
+        for (uint32_t i = 0; i < kPosterCount; ++i)
+        {
+            posters.emplace_back([render_thread]
+            {
+                for (uint32_t toggle = 0; toggle < kTogglesPerPoster; ++toggle) render_thread->PostToggleMsaa();
+            });
+        }
+        posters.emplace_back([render_thread]
+        {
+            for (uint32_t toggle = 0; toggle < 1001; ++toggle) render_thread->PostToggleDynamicResolution();
+        });
+
+        // The game thread keeps submitting frames meanwhile.
+        for (uint64_t frame = 0; frame < 1000; ++frame)
+        {
+            render_thread->BeginPacket().frame_index = frame;
+            render_thread->SubmitPacket();
+        }
+        for (thread& poster : posters) poster.join();
+        render_thread->Release();
+
+        CHECK(backend.msaa_toggles_ == kPosterCount * kTogglesPerPoster);
+        CHECK(!backend.msaa_);
+        CHECK(backend.dynamic_resolution_toggles_ == 1001);
+        CHECK(backend.dynamic_resolution_);
+        CHECK(backend.events_.size() == 1000);
+    }
+
+    void TestWakeUp()
+    {
+        FakeBackend backend;
+        RenderThread* render_thread = RenderThread::Create();
+        render_thread->Initialize(&backend);
+
+        // Long enough for the render thread to stop spinning and sleep.
+        for (uint64_t frame = 0; frame < 20; ++frame)
+        {
+            this_thread::sleep_for(chrono::milliseconds(2));
+            render_thread->BeginPacket().frame_index = frame;
+            render_thread->SubmitPacket();
+            const auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+            while (render_thread->FramesRendered() <= frame && chrono::steady_clock::now() < deadline) this_thread::yield();
+        }
+        CHECK(render_thread->FramesRendered() == 20);
+
+        // Release executes what is still queued.
+        render_thread->PostResize(1, 2);
+        render_thread->PostResize(2, 3);
+        render_thread->Release();
+        CHECK(backend.events_.size() == 22);
+        CHECK(backend.events_.back().type == 'R' && backend.events_.back().value == 2);
+    }
+}
+
+int main()
+{
+    TestFrames();
+    TestOtherThreads();
+    TestWakeUp();
+    return test::Result();
+}
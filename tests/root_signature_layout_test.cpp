@@ -0,0 +1,203 @@
+//--------------------------------------------------------------------------------
+//  root_signature_layout_test.cpp
+//  Canonical words and hashes of RootSignatureLayout, deduplication by
+//  RootSignatureLayoutTable and validation of the RootSignatureBlobFile
+//  read by RootSignatureCache.
+//--------------------------------------------------------------------------------
+#include "root_signature_layout.h"
+#include "hash_util.h"
+#include "test_util.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // The root signature of the bindless passes: constants, a CBV and a
+    // table of two ranges with appended offsets.
+    RootSignatureLayout MakeLayout(uint32_t offset_second = kDescriptorRangeOffsetAppend)
+    {
+        RootDescriptorRange ranges[2];
+        ranges[0].type = DescriptorRangeType::kShaderResourceView;
+        ranges[0].count = 8;
+        ranges[1].type = DescriptorRangeType::kUnorderedAccessView;
+        ranges[1].count = 4;
+        ranges[1].offset = offset_second;
+
+        RootSignatureLayout layout;
+        layout.AddConstants(4, 0)
+            .AddConstantBufferView(1)
+            .AddDescriptorTable(ranges, 2)
+            .AddStaticSampler(RootStaticSampler())
+            .SetFlags(1);
+        return layout;
+    }
+
+    void TestHashFunctions()
+    {
+        // Known FNV-1a vector, and fixed values: the hashes name files on disk.
+        CHECK(HashBytes("a", 1) == 0xaf63dc4c8601ec8cull);
+        CHECK(HashBytes("", 0) == kFnvOffsetBasis);
+        const uint32_t words[3] = { 1, 2, 3 };
+        CHECK(HashWords(words, 3) == 0xd0aa6218672cf5abull);
+
+        // Word at a time is its own hash, not FNV-1a over the same bytes.
+        CHECK(HashWords(words, 3) != HashBytes(words, sizeof(words)));
+        CHECK(MixHash(1) != MixHash(2) && MixHash(0) == 0);
+    }
+
+    void TestWords()
+    {
+        // Same description, same words and hash; appended offsets equal the
+        // explicit offsets they resolve to.
+        const RootSignatureLayout layout = MakeLayout();
+        CHECK(layout == MakeLayout());
+        CHECK(layout.Hash() == MakeLayout().Hash());
+        CHECK(layout == MakeLayout(8));
+        CHECK(layout.Hash() == MakeLayout(8).Hash());
+        CHECK(layout != MakeLayout(9));
+
+        // Every field changes the words and the hash.
+        vector<RootSignatureLayout> variants;
+        {
+            RootSignatureLayout v = MakeLayout(); v.SetFlags(0); variants.push_back(v);
+        }
+        {
+            RootSignatureLayout v = MakeLayout(); v.AddConstants(1, 2); variants.push_back(v);
+        }
+        {
+            RootSignatureLayout v = MakeLayout(); v.AddShaderResourceView(2); variants.push_back(v);
+        }
+        {
+            RootSignatureLayout v = MakeLayout(); v.AddUnorderedAccessView(2); variants.push_back(v);
+        }
+        {
+            RootSignatureLayout v = MakeLayout(); v.AddConstantBufferView(2); variants.push_back(v);
+        }
+        {
+            RootSignatureLayout v = MakeLayout(); v.AddConstantBufferView(2, 1); variants.push_back(v);
+        }
+        {
+            RootSignatureLayout v = MakeLayout(); v.AddConstantBufferView(2, 0, 1); variants.push_back(v);
+        }
+        {
+            RootSignatureLayout v = MakeLayout(); v.AddConstantBufferView(2, 0, 0, 2); variants.push_back(v);
+        }
+        {
+            RootStaticSampler sampler;
+            sampler.max_lod = 0.0f;
+            RootSignatureLayout v = MakeLayout(); v.AddStaticSampler(sampler); variants.push_back(v);
+        }
+        {
+            RootStaticSampler sampler;
+            sampler.shader_register = 1;
+            RootSignatureLayout v = MakeLayout(); v.AddStaticSampler(sampler); variants.push_back(v);
+        }
+        {
+            // Same parameters in another order.
+            RootDescriptorRange range;
+            RootSignatureLayout a;
+            a.AddConstants(1, 0).AddDescriptorTable(&range, 1);
+            RootSignatureLayout b;
+            b.AddDescriptorTable(&range, 1).AddConstants(1, 0);
+            variants.push_back(a);
+            variants.push_back(b);
+        }
+        {
+            RootDescriptorRange range;
+            range.flags = 2;
+            RootSignatureLayout v = MakeLayout(); v.AddDescriptorTable(&range, 1); variants.push_back(v);
+        }
+        {
+            RootDescriptorRange range;
+            range.space = 1;
+            RootSignatureLayout v = MakeLayout(); v.AddDescriptorTable(&range, 1); variants.push_back(v);
+        }
+        variants.push_back(MakeLayout());
+
+        bool distinct = true;
+        for (size_t i = 0; i < variants.size(); ++i)
+        {
+            for (size_t j = i + 1; j < variants.size(); ++j)
+            {
+                distinct = distinct && variants[i] != variants[j] && variants[i].Hash() != variants[j].Hash();
+            }
+        }
+        CHECK(distinct);
+    }
+
+    void TestTable()
+    {
+        RootSignatureLayoutTable<int> table;
+        const RootSignatureLayout layout = MakeLayout();
+        const vector<uint32_t> words = layout.Words();
+        CHECK(table.Find(layout.Hash(), words) == nullptr);
+        table.Insert(layout.Hash(), words, 1);
+
+        // An equal layout built separately finds the same entry.
+        const RootSignatureLayout same = MakeLayout(8);
+        int* found = table.Find(same.Hash(), same.Words());
+        CHECK(found != nullptr && *found == 1);
+
+        // Colliding hashes are told apart by the words.
+        const vector<uint32_t> other = MakeLayout(9).Words();
+        CHECK(table.Find(layout.Hash(), other) == nullptr);
+        table.Insert(layout.Hash(), other, 2);
+        CHECK(table.Size() == 2);
+        found = table.Find(layout.Hash(), other);
+        CHECK(found != nullptr && *found == 2);
+        found = table.Find(layout.Hash(), words);
+        CHECK(found != nullptr && *found == 1);
+        CHECK(table.Find(layout.Hash() + 1, words) == nullptr);
+    }
+
+    void TestBlobFile()
+    {
+        const vector<uint32_t> words = MakeLayout().Words();
+        const string blob = "serialized root signature";
+        const uint32_t version = 2;     // D3D_ROOT_SIGNATURE_VERSION_1_1
+        const vector<uint8_t> file = RootSignatureBlobFile::Write(version, words, blob.data(), blob.size());
+
+        size_t blob_size = 0;
+        const uint8_t* read = RootSignatureBlobFile::Read(file.data(), file.size(), version, words, &blob_size);
+        CHECK(read != nullptr && blob_size == blob.size());
+        CHECK(read != nullptr && string(reinterpret_cast<const char*>(read), blob_size) == blob);
+
+        // Another root signature version or layout: serialize again.
+        CHECK(RootSignatureBlobFile::Read(file.data(), file.size(), 1, words, &blob_size) == nullptr);
+        vector<uint32_t> other_words = words;
+        other_words.back() ^= 1;
+        CHECK(RootSignatureBlobFile::Read(file.data(), file.size(), version, other_words, &blob_size) == nullptr);
+        other_words = words;
+        other_words.push_back(0);
+        CHECK(RootSignatureBlobFile::Read(file.data(), file.size(), version, other_words, &blob_size) == nullptr);
+
+        // Truncated at any length, or with trailing bytes.
+        bool truncated_rejected = true;
+        for (size_t size = 0; size < file.size(); ++size)
+        {
+            truncated_rejected = truncated_rejected && RootSignatureBlobFile::Read(file.data(), size, version, words, &blob_size) == nullptr;
+        }
+        CHECK(truncated_rejected);
+        vector<uint8_t> longer = file;
+        longer.push_back(0);
+        CHECK(RootSignatureBlobFile::Read(longer.data(), longer.size(), version, words, &blob_size) == nullptr);
+
+        // A corrupted magic, and an empty blob.
+        vector<uint8_t> corrupted = file;
+        corrupted[0] ^= 0xff;
+        CHECK(RootSignatureBlobFile::Read(corrupted.data(), corrupted.size(), version, words, &blob_size) == nullptr);
+        const vector<uint8_t> empty = RootSignatureBlobFile::Write(version, words, nullptr, 0);
+        CHECK(RootSignatureBlobFile::Read(empty.data(), empty.size(), version, words, &blob_size) == nullptr);
+    }
+}
+
+int main()
+{
+    TestHashFunctions();
+    TestWords();
+    TestTable();
+    TestBlobFile();
+    return test::Result();
+}
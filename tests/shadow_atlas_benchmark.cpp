@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------
+//  shadow_atlas_benchmark.cpp
+//  Nanoseconds per ShadowAtlas::Allocate + Free in an 8192 atlas kept about
+//  half full of tiles from 128 to 2048 texels, and for a full refill of
+//  min tiles.
+//--------------------------------------------------------------------------------
+#include "shadow_atlas.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kSize = 8192;
+    constexpr uint32_t kMin = 128;
+    constexpr uint32_t kSteps = 1000000;
+    constexpr int kRepeat = 5;
+
+    void Report(const char* name, double ms, size_t count, double checksum)
+    {
+        printf("%-36s %8.1f ns   (checksum %.0f)\n", name, ms * 1e6 / count, checksum);
+    }
+
+    void MeasureMixed()
+    {
+        ShadowAtlas atlas;
+        atlas.Initialize(kSize, kMin);
+        RandomGenerator random(3);
+        vector<uint32_t> sizes(kSteps), picks(kSteps);
+        for (uint32_t i = 0; i < kSteps; ++i)
+        {
+            sizes[i] = kMin << (random.NextUint() % 5);
+            picks[i] = random.NextUint();
+        }
+
+        vector<uint32_t> nodes;
+        double checksum = 0.0;
+        const double ms = test::MeasureMs(kRepeat, [&]
+        {
+            for (uint32_t i = 0; i < kSteps; ++i)
+            {
+                // Free when more than half of the atlas is used.
+                if (!nodes.empty() && atlas.FreeTexels() < static_cast<uint64_t>(kSize) * kSize / 2)
+                {
+                    const size_t j = picks[i] % nodes.size();
+                    atlas.Free(nodes[j]);
+                    nodes[j] = nodes.back();
+                    nodes.pop_back();
+                }
+                const uint32_t node = atlas.Allocate(sizes[i]);
+                if (node != ShadowAtlas::kInvalidNode) nodes.push_back(node);
+            }
+            checksum += atlas.TileCount();
+        });
+        Report("Allocate + Free, mixed sizes", ms, kSteps, checksum);
+    }
+
+    void MeasureRefill()
+    {
+        ShadowAtlas atlas;
+        atlas.Initialize(kSize, kMin);
+        constexpr uint32_t kCount = (kSize / kMin) * (kSize / kMin);
+        vector<uint32_t> nodes(kCount);
+        double checksum = 0.0;
+        const double ms = test::MeasureMs(kRepeat, [&]
+        {
+            for (uint32_t i = 0; i < kCount; ++i) nodes[i] = atlas.Allocate(kMin);
+            checksum += atlas.Tile(nodes[kCount - 1]).x;
+            for (uint32_t i = 0; i < kCount; ++i) atlas.Free(nodes[i]);
+        });
+        Report("Allocate + Free, min tiles to full", ms, kCount, checksum);
+    }
+}
+
+int main()
+{
+    MeasureMixed();
+    MeasureRefill();
+    return 0;
+}
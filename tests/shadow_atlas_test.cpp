@@ -0,0 +1,147 @@
+//--------------------------------------------------------------------------------
+//  shadow_atlas_test.cpp
+//  ShadowAtlas: size rounding, smallest fitting block, filling and merging
+//  back to one tile, and random allocations and frees checked against a map
+//  of the atlas in min tiles (no overlap, alignment, texel accounting).
+//--------------------------------------------------------------------------------
+#include "shadow_atlas.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    void TestSizes()
+    {
+        ShadowAtlas atlas;
+        atlas.Initialize(1024, 32);
+        CHECK(atlas.Size() == 1024 && atlas.MinTileSize() == 32);
+        CHECK(atlas.LargestFreeTile() == 1024 && atlas.FreeTexels() == 1024u * 1024u);
+
+        // Rounded up to a power of 2, at least the min tile.
+        const uint32_t a = atlas.Allocate(300);
+        const uint32_t b = atlas.Allocate(1);
+        CHECK(atlas.Tile(a).size == 512 && atlas.Tile(b).size == 32);
+        CHECK(atlas.Allocate(1025) == ShadowAtlas::kInvalidNode);
+        CHECK(atlas.TileCount() == 2);
+        CHECK(atlas.FreeTexels() == 1024u * 1024u - 512u * 512u - 32u * 32u);
+
+        // The min tile came out of a 512 block, the other two stay whole.
+        CHECK(atlas.LargestFreeTile() == 512);
+        const uint32_t c = atlas.Allocate(512);
+        const uint32_t d = atlas.Allocate(512);
+        CHECK(c != ShadowAtlas::kInvalidNode && d != ShadowAtlas::kInvalidNode);
+        CHECK(atlas.Allocate(512) == ShadowAtlas::kInvalidNode);
+        CHECK(atlas.LargestFreeTile() == 256);
+
+        atlas.Free(a);
+        atlas.Free(b);
+        atlas.Free(c);
+        atlas.Free(d);
+        atlas.Free(ShadowAtlas::kInvalidNode);
+        CHECK(atlas.TileCount() == 0 && atlas.LargestFreeTile() == 1024);
+        CHECK(atlas.Tile(ShadowAtlas::kInvalidNode).size == 0);
+    }
+
+    void TestFill()
+    {
+        // Every min tile, each at its own place, then everything merges back.
+        ShadowAtlas atlas;
+        atlas.Initialize(512, 32);
+        vector<uint32_t> nodes;
+        vector<bool> covered(16 * 16, false);
+        bool distinct = true;
+        for (uint32_t i = 0; i < 16 * 16; ++i)
+        {
+            nodes.push_back(atlas.Allocate(32));
+            const ShadowTile tile = atlas.Tile(nodes.back());
+            const uint32_t cell = tile.y / 32 * 16 + tile.x / 32;
+            distinct = distinct && tile.size == 32 && !covered[cell];
+            covered[cell] = true;
+        }
+        CHECK(distinct);
+        CHECK(atlas.FreeTexels() == 0 && atlas.LargestFreeTile() == 0);
+        CHECK(atlas.Allocate(32) == ShadowAtlas::kInvalidNode);
+
+        // Free in a scattered order.
+        for (uint32_t i = 0; i < nodes.size(); ++i) atlas.Free(nodes[(i * 97) % nodes.size()]);
+        CHECK(atlas.TileCount() == 0 && atlas.LargestFreeTile() == 512);
+        CHECK(atlas.Tile(atlas.Allocate(512)).size == 512);
+
+        atlas.Clear();
+        CHECK(atlas.TileCount() == 0 && atlas.FreeTexels() == 512u * 512u && atlas.LargestFreeTile() == 512);
+    }
+
+    void TestRandom()
+    {
+        constexpr uint32_t kSize = 4096;
+        constexpr uint32_t kMin = 64;
+        constexpr uint32_t kCells = kSize / kMin;
+        ShadowAtlas atlas;
+        atlas.Initialize(kSize, kMin);
+
+        RandomGenerator random(50);
+        vector<uint32_t> nodes;
+        vector<uint8_t> owner_map(kCells * kCells, 0);
+        uint64_t used_texels = 0;
+        uint32_t overlaps = 0, misaligned = 0, wrong_failures = 0, wrong_counts = 0;
+        for (uint32_t step = 0; step < 200000; ++step)
+        {
+            auto mark = [&](const ShadowTile& tile, uint8_t value)
+            {
+                for (uint32_t y = tile.y / kMin; y < (tile.y + tile.size) / kMin; ++y)
+                {
+                    for (uint32_t x = tile.x / kMin; x < (tile.x + tile.size) / kMin; ++x)
+                    {
+                        if (value != 0 && owner_map[y * kCells + x] != 0) ++overlaps;
+                        owner_map[y * kCells + x] = value;
+                    }
+                }
+            };
+
+            if (!nodes.empty() && (random.NextUint() % 100) < 45)
+            {
+                const size_t i = random.NextUint() % nodes.size();
+                const ShadowTile tile = atlas.Tile(nodes[i]);
+                mark(tile, 0);
+                used_texels -= static_cast<uint64_t>(tile.size) * tile.size;
+                atlas.Free(nodes[i]);
+                nodes[i] = nodes.back();
+                nodes.pop_back();
+            }
+            else
+            {
+                const uint32_t size = kMin << (random.NextUint() % 6);
+                const uint32_t largest = atlas.LargestFreeTile();
+                const uint32_t node = atlas.Allocate(size - random.NextUint() % (size / 2));
+                if ((node == ShadowAtlas::kInvalidNode) != (largest < size)) ++wrong_failures;
+                if (node != ShadowAtlas::kInvalidNode)
+                {
+                    const ShadowTile tile = atlas.Tile(node);
+                    if (tile.size != size || tile.x % size != 0 || tile.y % size != 0 || tile.x + size > kSize || tile.y + size > kSize) ++misaligned;
+                    mark(tile, 1);
+                    used_texels += static_cast<uint64_t>(size) * size;
+                    nodes.push_back(node);
+                }
+            }
+            if (atlas.TileCount() != nodes.size() || atlas.FreeTexels() != static_cast<uint64_t>(kSize) * kSize - used_texels) ++wrong_counts;
+        }
+        CHECK(overlaps == 0);
+        CHECK(misaligned == 0);
+        CHECK(wrong_failures == 0);
+        CHECK(wrong_counts == 0);
+
+        for (uint32_t node : nodes) atlas.Free(node);
+        CHECK(atlas.TileCount() == 0 && atlas.LargestFreeTile() == kSize);
+    }
+}
+
+int main()
+{
+    TestSizes();
+    TestFill();
+    TestRandom();
+    return test::Result();
+}
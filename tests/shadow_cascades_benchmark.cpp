@@ -0,0 +1,53 @@
+//--------------------------------------------------------------------------------
+//  shadow_cascades_benchmark.cpp
+//  Microseconds per ShadowCascades::Update for 1 to 4 cascades over a walking
+//  and turning camera (Windows only: Light comes from d3dUtil.h).
+//--------------------------------------------------------------------------------
+#include "shadow_cascades.h"
+#include "d3dUtil.h"
+#include "test_util.h"
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kFrameCount = 10000;
+    constexpr int kRepeat = 10;
+
+    void Measure(uint32_t cascade_count, const vector<XMFLOAT4X4>& views, const Light& sun)
+    {
+        ShadowCascadeSettings settings;
+        settings.cascade_count = cascade_count;
+        ShadowCascades cascades(settings);
+        double checksum = 0.0;
+        const double ms = test::MeasureMs(kRepeat, [&]
+        {
+            for (const XMFLOAT4X4& view : views)
+            {
+                cascades.Update(XMLoadFloat4x4(&view), XM_PIDIV4, 16.0f / 9.0f, 0.1f, 400.0f, sun);
+                checksum += cascades.ViewProj(cascade_count - 1).m[3][0];
+            }
+        });
+        printf("Update, %u cascade(s) %10.3f us   (checksum %.3f)\n", cascade_count, ms * 1e3 / kFrameCount, checksum);
+    }
+}
+
+int main()
+{
+    vector<XMFLOAT4X4> views(kFrameCount);
+    for (uint32_t i = 0; i < kFrameCount; ++i)
+    {
+        const float t = i * 0.01f;
+        const XMVECTOR eye = XMVectorSet(t * 2.0f, 5.0f + sinf(t), 20.0f * cosf(t * 0.1f), 1.0f);
+        const XMVECTOR direction = XMVectorSet(sinf(t * 0.3f), -0.2f, cosf(t * 0.3f), 0.0f);
+        XMStoreFloat4x4(&views[i], XMMatrixLookToLH(eye, direction, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+    }
+    Light sun;
+    sun.Direction = XMFLOAT3(0.3f, -0.8f, 0.4f);
+
+    for (uint32_t count = 1; count <= ShadowCascades::kMaxCascades; ++count) Measure(count, views, sun);
+    return 0;
+}
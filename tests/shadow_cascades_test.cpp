@@ -0,0 +1,211 @@
+//--------------------------------------------------------------------------------
+//  shadow_cascades_test.cpp
+//  ShadowCascades: split distribution, every frustum slice corner (and the
+//  casters toward the light) inside its cascade over random cameras and
+//  light directions, the smallest bounding sphere on the view axis, constant
+//  cascade size while the camera turns, and texel snapping (Windows only:
+//  Light comes from d3dUtil.h).
+//--------------------------------------------------------------------------------
+#include "shadow_cascades.h"
+#include "d3dUtil.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr float kFovY = XM_PIDIV4;
+    constexpr float kAspect = 16.0f / 9.0f;
+    constexpr float kNearZ = 0.1f;
+    constexpr float kFarZ = 400.0f;
+
+    XMMATRIX CameraView(const XMFLOAT3& eye, float yaw, float pitch)
+    {
+        const XMVECTOR direction = XMVectorSet(sinf(yaw) * cosf(pitch), sinf(pitch), cosf(yaw) * cosf(pitch), 0.0f);
+        return XMMatrixLookToLH(XMLoadFloat3(&eye), direction, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    }
+
+    Light Sun(const XMFLOAT3& direction)
+    {
+        Light light;
+        light.Direction = direction;
+        return light;
+    }
+
+    // Radius of the smallest sphere centered on the view axis around the
+    // slice between the depths n and f, by ternary search on its center.
+    float SmallestAxisRadius(float n, float f)
+    {
+        const double corner_sq = tan(kFovY * 0.5) * tan(kFovY * 0.5) * (1.0 + double(kAspect) * kAspect);
+        auto radius = [=](double z)
+        {
+            return sqrt(max(corner_sq * n * n + (n - z) * (n - z), corner_sq * f * f + (f - z) * (f - z)));
+        };
+        double low = 0.0, high = 2.0 * f;
+        for (int i = 0; i < 200; ++i)
+        {
+            const double a = low + (high - low) / 3.0;
+            const double b = high - (high - low) / 3.0;
+            if (radius(a) < radius(b)) high = b;
+            else low = a;
+        }
+        return static_cast<float>(radius((low + high) * 0.5));
+    }
+
+    void TestSplits()
+    {
+        float splits[ShadowCascades::kMaxCascades + 1];
+        ShadowCascades::ComputeSplits(1.0f, 101.0f, 4, 0.0f, splits);
+        CHECK(splits[0] == 1.0f && splits[4] == 101.0f);
+        CHECK(fabsf(splits[1] - 26.0f) < 1e-4f && fabsf(splits[2] - 51.0f) < 1e-4f && fabsf(splits[3] - 76.0f) < 1e-4f);
+
+        // Logarithmic: the same ratio from one split to the next.
+        ShadowCascades::ComputeSplits(0.5f, 512.0f, 4, 1.0f, splits);
+        bool ratio = true;
+        for (int i = 0; i < 4; ++i) ratio = ratio && fabsf(splits[i + 1] / splits[i] - powf(1024.0f, 0.25f)) < 1e-3f;
+        CHECK(ratio);
+
+        // Blends lie in between and increase.
+        float uniform[5], logarithmic[5];
+        ShadowCascades::ComputeSplits(kNearZ, kFarZ, 4, 0.0f, uniform);
+        ShadowCascades::ComputeSplits(kNearZ, kFarZ, 4, 1.0f, logarithmic);
+        ShadowCascades::ComputeSplits(kNearZ, kFarZ, 4, 0.75f, splits);
+        bool between = true;
+        for (int i = 1; i < 4; ++i)
+        {
+            between = between && splits[i] > splits[i - 1] && splits[i] > logarithmic[i] && splits[i] < uniform[i];
+        }
+        CHECK(between);
+
+        ShadowCascades::ComputeSplits(kNearZ, kFarZ, 1, 0.75f, splits);
+        CHECK(splits[0] == kNearZ && splits[1] == kFarZ);
+    }
+
+    void TestCoverage()
+    {
+        RandomGenerator random(50);
+        const XMFLOAT3 straight_down(0.0f, -1.0f, 0.0f);
+        ShadowCascadeSettings settings;
+        ShadowCascades cascades(settings);
+        uint32_t outside_cascade = 0, outside_bounds = 0, loose_bounds = 0, casters_clipped = 0, bad_splits = 0;
+        for (int trial = 0; trial < 2000; ++trial)
+        {
+            const XMFLOAT3 eye(random.NextFloat(-100.0f, 100.0f), random.NextFloat(0.0f, 20.0f), random.NextFloat(-100.0f, 100.0f));
+            const XMMATRIX view = CameraView(eye, random.NextFloat(-XM_PI, XM_PI), random.NextFloat(-0.7f, 0.7f));
+            XMFLOAT3 direction(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, -0.05f), random.NextFloat(-1.0f, 1.0f));
+            if (trial % 10 == 0) direction = straight_down;
+            const Light sun = Sun(direction);
+            cascades.Update(view, kFovY, kAspect, kNearZ, kFarZ, sun);
+
+            const XMMATRIX inverse_view = XMMatrixInverse(nullptr, view);
+            const XMVECTOR toward_light = XMVectorScale(XMVector3Normalize(XMLoadFloat3(&direction)), -settings.caster_depth * 0.99f);
+            const float tan_y = tanf(kFovY * 0.5f);
+            for (uint32_t c = 0; c < cascades.CascadeCount(); ++c)
+            {
+                if (!(cascades.Split(c) < cascades.Split(c + 1))) ++bad_splits;
+                const XMMATRIX view_proj = XMLoadFloat4x4(&cascades.ViewProj(c));
+                const BoundingSphere& bounds = cascades.Bounds(c);
+                if (bounds.Radius > SmallestAxisRadius(cascades.Split(c), cascades.Split(c + 1)) * 1.0001f) ++loose_bounds;
+                for (int k = 0; k < 8; ++k)
+                {
+                    const float z = cascades.Split(c + (k >> 2));
+                    const XMVECTOR corner = XMVector3Transform(XMVectorSet(
+                        (k & 1 ? 1.0f : -1.0f) * tan_y * kAspect * z, (k & 2 ? 1.0f : -1.0f) * tan_y * z, z, 1.0f), inverse_view);
+
+                    XMFLOAT3 clip;
+                    XMStoreFloat3(&clip, XMVector3TransformCoord(corner, view_proj));
+                    if (fabsf(clip.x) > 1.0001f || fabsf(clip.y) > 1.0001f || clip.z < 0.0f || clip.z > 1.0001f) ++outside_cascade;
+
+                    XMFLOAT3 p;
+                    XMStoreFloat3(&p, corner);
+                    const float dx = p.x - bounds.Center.x, dy = p.y - bounds.Center.y, dz = p.z - bounds.Center.z;
+                    if (sqrtf(dx * dx + dy * dy + dz * dz) > bounds.Radius * 1.0001f + 1e-4f) ++outside_bounds;
+
+                    // A caster up to caster_depth toward the light still lands in the depth range.
+                    XMStoreFloat3(&clip, XMVector3TransformCoord(XMVectorAdd(corner, toward_light), view_proj));
+                    if (clip.z < 0.0f) ++casters_clipped;
+                }
+            }
+        }
+        CHECK(bad_splits == 0);
+        CHECK(outside_cascade == 0);
+        CHECK(outside_bounds == 0);
+        CHECK(loose_bounds == 0);
+        CHECK(casters_clipped == 0);
+    }
+
+    void TestStability()
+    {
+        ShadowCascadeSettings settings;
+        ShadowCascades cascades(settings);
+        const Light sun = Sun(XMFLOAT3(0.3f, -0.8f, 0.4f));
+        const XMFLOAT3 eye(10.0f, 5.0f, -20.0f);
+
+        // Turning in place: the size of each cascade never changes.
+        cascades.Update(CameraView(eye, 0.0f, 0.0f), kFovY, kAspect, kNearZ, kFarZ, sun);
+        float scale[ShadowCascades::kMaxCascades];
+        for (uint32_t c = 0; c < cascades.CascadeCount(); ++c) scale[c] = XMVectorGetX(XMVector3Length(XMLoadFloat4x4(&cascades.ViewProj(c)).r[0]));
+        bool same_size = true;
+        for (int step = 1; step < 64; ++step)
+        {
+            cascades.Update(CameraView(eye, step * 0.1f, sinf(step * 0.3f) * 0.5f), kFovY, kAspect, kNearZ, kFarZ, sun);
+            for (uint32_t c = 0; c < cascades.CascadeCount(); ++c)
+            {
+                const float s = XMVectorGetX(XMVector3Length(XMLoadFloat4x4(&cascades.ViewProj(c)).r[0]));
+                same_size = same_size && fabsf(s - scale[c]) <= scale[c] * 1e-5f;
+            }
+        }
+        CHECK(same_size);
+
+        // Snapped to whole texels: the world origin lands on the texel grid.
+        RandomGenerator random(7);
+        bool snapped = true;
+        uint32_t unchanged = 0, changed = 0, count = 0;
+        for (int trial = 0; trial < 500; ++trial)
+        {
+            const XMFLOAT3 position(random.NextFloat(-100.0f, 100.0f), random.NextFloat(0.0f, 20.0f), random.NextFloat(-100.0f, 100.0f));
+            const float yaw = random.NextFloat(-XM_PI, XM_PI);
+            cascades.Update(CameraView(position, yaw, 0.0f), kFovY, kAspect, kNearZ, kFarZ, sun);
+            XMFLOAT4X4 before[ShadowCascades::kMaxCascades];
+            for (uint32_t c = 0; c < cascades.CascadeCount(); ++c)
+            {
+                before[c] = cascades.ViewProj(c);
+                for (int axis = 0; axis < 2; ++axis)
+                {
+                    const float texels = before[c].m[3][axis] * settings.resolution * 0.5f;
+                    snapped = snapped && fabsf(texels - roundf(texels)) < 0.02f;
+                }
+            }
+
+            // A millimeter keeps (almost always) the same matrices, a meter never.
+            const XMFLOAT3 nudged(position.x + 0.001f, position.y, position.z + 0.001f);
+            cascades.Update(CameraView(nudged, yaw, 0.0f), kFovY, kAspect, kNearZ, kFarZ, sun);
+            for (uint32_t c = 0; c < cascades.CascadeCount(); ++c, ++count)
+            {
+                unchanged += memcmp(&before[c], &cascades.ViewProj(c), sizeof(XMFLOAT4X4)) == 0;
+            }
+            const XMFLOAT3 moved(position.x + 1.0f, position.y, position.z + 1.0f);
+            cascades.Update(CameraView(moved, yaw, 0.0f), kFovY, kAspect, kNearZ, kFarZ, sun);
+            for (uint32_t c = 0; c < cascades.CascadeCount(); ++c)
+            {
+                changed += memcmp(&before[c], &cascades.ViewProj(c), sizeof(XMFLOAT4X4)) != 0;
+            }
+        }
+        CHECK(snapped);
+        CHECK(unchanged * 10 >= count * 9);
+        CHECK(changed == count);
+    }
+}
+
+int main()
+{
+    TestSplits();
+    TestCoverage();
+    TestStability();
+    return test::Result();
+}
@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------
+//  shadow_scheduler_benchmark.cpp
+//  Milliseconds per ShadowScheduler::Schedule for 1000 and 4000 point light
+//  views (1 in 5 with dynamic casters) plus 4 fixed size cascades, with the
+//  camera orbiting through the lights.
+//--------------------------------------------------------------------------------
+#include "shadow_scheduler.h"
+#include "culling_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr int kFrameCount = 600;
+    constexpr float kFovY = XM_PIDIV4;
+
+    void Measure(uint32_t light_count)
+    {
+        ShadowScheduler scheduler;
+        RandomGenerator random(9);
+        for (uint32_t i = 0; i < light_count; ++i)
+        {
+            const XMFLOAT3 center(random.NextFloat(-200.0f, 200.0f), random.NextFloat(0.0f, 20.0f), random.NextFloat(-200.0f, 200.0f));
+            ShadowView view;
+            XMStoreFloat4x4(&view.view_proj, XMMatrixTranslation(center.x, center.y, center.z));
+            view.influence = BoundingSphere(center, random.NextFloat(2.0f, 22.0f));
+            view.dynamic_casters = i % 5 == 0;
+            scheduler.AddView(view);
+        }
+
+        // Cascades follow the camera, so their matrices change every frame.
+        uint32_t cascades[4];
+        for (uint32_t& id : cascades) id = scheduler.AddView(ShadowView());
+
+        const XMMATRIX proj = XMMatrixPerspectiveFovLH(kFovY, 16.0f / 9.0f, 0.1f, 400.0f);
+        const float projection_scale = 1080.0f / (2.0f * tanf(kFovY * 0.5f));
+        vector<ShadowUpdate> updates;
+        double ms = 0.0;
+        size_t checksum = 0;
+        for (int frame = 0; frame < kFrameCount; ++frame)
+        {
+            const float angle = frame * 0.01f;
+            const XMVECTOR eye = XMVectorSet(50.0f * cosf(angle), 10.0f, 50.0f * sinf(angle), 1.0f);
+            const XMMATRIX view = XMMatrixLookToLH(eye, XMVectorSet(-sinf(angle), -0.1f, cosf(angle), 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                ShadowView cascade;
+                XMStoreFloat4x4(&cascade.view_proj, XMMatrixTranslation(static_cast<float>(frame), static_cast<float>(i), 0.0f));
+                XMStoreFloat3(&cascade.influence.Center, XMVectorAdd(eye, XMVectorSet(-sinf(angle) * 10.0f * (i + 1), 0.0f, cosf(angle) * 10.0f * (i + 1), 0.0f)));
+                cascade.influence.Radius = 10.0f * (i + 1);
+                cascade.fixed_size = 2048;
+                cascade.dynamic_casters = true;
+                scheduler.SetView(cascades[i], cascade);
+            }
+            XMFLOAT4 planes[6];
+            CullingSystem::ExtractFrustumPlanes(XMMatrixMultiply(view, proj), planes);
+
+            // Once per frame: a warm up call would schedule the frame twice.
+            const auto begin = chrono::steady_clock::now();
+            scheduler.Schedule(planes, eye, projection_scale, updates);
+            ms += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+            checksum += updates.size();
+        }
+        printf("Schedule, %4u lights + 4 cascades %8.4f ms   (checksum %zu, %u tiles)\n", light_count, ms / kFrameCount, checksum,
+            scheduler.Atlas().TileCount());
+    }
+}
+
+int main()
+{
+    Measure(1000);
+    Measure(4000);
+    return 0;
+}
@@ -0,0 +1,340 @@
+//--------------------------------------------------------------------------------
+//  shadow_scheduler_test.cpp
+//  ShadowScheduler: tile sizes from the screen influence, static caster
+//  caching, the update budget and its order, off screen views giving their
+//  tiles up, and 1000 views over an orbiting camera (no overlapping tiles,
+//  no starved view, ids reused).
+//--------------------------------------------------------------------------------
+#include "shadow_scheduler.h"
+#include "culling_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr float kFovY = XM_PIDIV4;
+    constexpr float kAspect = 16.0f / 9.0f;
+    constexpr float kViewportHeight = 1080.0f;
+
+    struct Camera
+    {
+        XMFLOAT4 planes[6];
+        XMFLOAT3 eye;
+        float projection_scale;
+    };
+
+    Camera MakeCamera(const XMFLOAT3& eye, const XMFLOAT3& direction)
+    {
+        Camera camera;
+        const XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), XMLoadFloat3(&direction), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        CullingSystem::ExtractFrustumPlanes(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(kFovY, kAspect, 0.1f, 1000.0f)), camera.planes);
+        camera.eye = eye;
+        camera.projection_scale = kViewportHeight / (2.0f * tanf(kFovY * 0.5f));
+        return camera;
+    }
+
+    const Camera& DefaultCamera()
+    {
+        static const Camera camera = MakeCamera(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f));
+        return camera;
+    }
+
+    // The matrix only has to change when the view moves.
+    ShadowView MakeView(const XMFLOAT3& center, float radius, bool dynamic_casters = false)
+    {
+        ShadowView view;
+        XMStoreFloat4x4(&view.view_proj, XMMatrixTranslation(center.x, center.y, center.z));
+        view.influence = BoundingSphere(center, radius);
+        view.dynamic_casters = dynamic_casters;
+        return view;
+    }
+
+    vector<ShadowUpdate> Schedule(ShadowScheduler& scheduler, const Camera& camera = DefaultCamera())
+    {
+        vector<ShadowUpdate> updates;
+        scheduler.Schedule(camera.planes, XMLoadFloat3(&camera.eye), camera.projection_scale, updates);
+        return updates;
+    }
+
+    const ShadowUpdate* Find(const vector<ShadowUpdate>& updates, uint32_t view)
+    {
+        for (const ShadowUpdate& update : updates)
+        {
+            if (update.view == view) return &update;
+        }
+        return nullptr;
+    }
+
+    bool Overlap(const ShadowTile& a, const ShadowTile& b)
+    {
+        return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+    }
+
+    void TestSizes()
+    {
+        ShadowScheduler scheduler;
+        const float scale = DefaultCamera().projection_scale;
+        const uint32_t medium = scheduler.AddView(MakeView(XMFLOAT3(0.0f, 0.0f, 100.0f), 10.0f));   // 130 pixels
+        const uint32_t close = scheduler.AddView(MakeView(XMFLOAT3(1.0f, 0.0f, 2.0f), 5.0f));       // eye inside
+        const uint32_t tiny = scheduler.AddView(MakeView(XMFLOAT3(0.0f, 0.0f, 500.0f), 1.0f));
+        const uint32_t behind = scheduler.AddView(MakeView(XMFLOAT3(0.0f, 0.0f, -100.0f), 10.0f));
+        ShadowView cascade = MakeView(XMFLOAT3(0.0f, 5.0f, 50.0f), 40.0f);
+        cascade.fixed_size = 1000;
+        const uint32_t fixed = scheduler.AddView(cascade);
+
+        const vector<ShadowUpdate> updates = Schedule(scheduler);
+        CHECK(updates.size() == 4);
+        CHECK(fabsf(scheduler.Influence(medium) - 10.0f * scale / 100.0f) < 1e-3f);
+        CHECK(scheduler.Influence(close) == scale && scheduler.Influence(behind) == 0.0f);
+        CHECK(scheduler.Tile(medium).size == 512);      // 2 * 130 rounded up
+        CHECK(scheduler.Tile(close).size == 2048);      // max_tile_size
+        CHECK(scheduler.Tile(tiny).size == 128);        // min_tile_size
+        CHECK(scheduler.Tile(behind).size == 0);
+        CHECK(scheduler.Tile(fixed).size == 1024);
+        for (const ShadowUpdate& update : updates)
+        {
+            CHECK(update.view != behind && update.static_casters);
+            const ShadowTile tile = scheduler.Tile(update.view);
+            CHECK(update.tile.x == tile.x && update.tile.y == tile.y && update.tile.size == tile.size);
+        }
+
+        // A view coming closer gets a larger tile, and is drawn again there.
+        scheduler.SetView(medium, MakeView(XMFLOAT3(0.0f, 0.0f, 40.0f), 10.0f));
+        const vector<ShadowUpdate> moved = Schedule(scheduler);
+        CHECK(moved.size() == 1 && moved[0].view == medium && moved[0].static_casters);
+        CHECK(scheduler.Tile(medium).size == 1024);
+
+        // Smaller again: the tile is kept until it is 4 times too large.
+        scheduler.SetView(medium, MakeView(XMFLOAT3(0.0f, 0.0f, 60.0f), 10.0f));
+        Schedule(scheduler);
+        CHECK(scheduler.Tile(medium).size == 1024);
+        scheduler.SetView(medium, MakeView(XMFLOAT3(0.0f, 0.0f, 200.0f), 10.0f));
+        Schedule(scheduler);
+        CHECK(scheduler.Tile(medium).size == 256);
+    }
+
+    void TestStaticCache()
+    {
+        ShadowScheduler scheduler;
+        const ShadowView still = MakeView(XMFLOAT3(-5.0f, 0.0f, 50.0f), 5.0f);
+        const uint32_t id = scheduler.AddView(still);
+        const uint32_t dynamic = scheduler.AddView(MakeView(XMFLOAT3(5.0f, 0.0f, 50.0f), 5.0f, true));
+
+        vector<ShadowUpdate> updates = Schedule(scheduler);
+        CHECK(updates.size() == 2 && updates[0].static_casters && updates[1].static_casters);
+
+        // Nothing changed: only the dynamic casters are drawn, over the cache.
+        for (int frame = 0; frame < 3; ++frame)
+        {
+            updates = Schedule(scheduler);
+            CHECK(updates.size() == 1 && updates[0].view == dynamic && !updates[0].static_casters);
+        }
+        scheduler.SetView(id, still);
+        updates = Schedule(scheduler);
+        CHECK(updates.size() == 1 && updates[0].view == dynamic);
+
+        // A new matrix redraws the static casters; the old one is sampled until then.
+        ShadowView moved = MakeView(XMFLOAT3(-6.0f, 0.0f, 50.0f), 5.0f);
+        scheduler.SetView(id, moved);
+        CHECK(memcmp(&scheduler.RenderedViewProj(id), &still.view_proj, sizeof(XMFLOAT4X4)) == 0);
+        updates = Schedule(scheduler);
+        CHECK(updates.size() == 2 && Find(updates, id) && Find(updates, id)->static_casters);
+        CHECK(memcmp(&scheduler.RenderedViewProj(id), &moved.view_proj, sizeof(XMFLOAT4X4)) == 0);
+
+        // Static casters changing away from the view do not touch it.
+        scheduler.InvalidateStatic(BoundingBox(XMFLOAT3(-6.0f, 0.0f, 80.0f), XMFLOAT3(2.0f, 2.0f, 2.0f)));
+        CHECK(Schedule(scheduler).size() == 1);
+        scheduler.InvalidateStatic(BoundingBox(XMFLOAT3(-6.0f, 0.0f, 56.0f), XMFLOAT3(2.0f, 2.0f, 2.0f)));
+        updates = Schedule(scheduler);
+        CHECK(updates.size() == 2 && Find(updates, id) && Find(updates, id)->static_casters);
+        CHECK(Find(updates, dynamic) && !Find(updates, dynamic)->static_casters);
+    }
+
+    void TestBudget()
+    {
+        // 40 dynamic views, from 10 to 300 pixels of influence.
+        ShadowSchedulerSettings settings;
+        settings.update_budget = 4;
+        ShadowScheduler scheduler(settings);
+        constexpr uint32_t kCount = 40;
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            const float angle = i * XM_2PI / kCount;
+            scheduler.AddView(MakeView(XMFLOAT3(10.0f * cosf(angle), 10.0f * sinf(angle), 40.0f + i * 3.0f), 10.0f - i * 0.1f, true));
+        }
+
+        // First draws go first, most influential first.
+        vector<uint32_t> last_update(kCount, 0);
+        bool first_draws_first = true, budget = true, waited = true;
+        for (uint32_t frame = 1; frame <= 300; ++frame)
+        {
+            const vector<ShadowUpdate> updates = Schedule(scheduler);
+            budget = budget && updates.size() == settings.update_budget;
+            for (const ShadowUpdate& update : updates)
+            {
+                if (frame <= kCount / settings.update_budget)
+                {
+                    first_draws_first = first_draws_first && update.static_casters && update.view / settings.update_budget == frame - 1;
+                }
+                waited = waited && (last_update[update.view] == 0 || frame - last_update[update.view] <= 60);
+                last_update[update.view] = frame;
+            }
+        }
+        CHECK(first_draws_first);
+        CHECK(budget);
+
+        // Small views wait longer (6 times less influence here), but every
+        // view is redrawn.
+        bool all_recent = true;
+        for (uint32_t i = 0; i < kCount; ++i) all_recent = all_recent && last_update[i] + 60 > 300;
+        CHECK(waited && all_recent);
+    }
+
+    void TestEviction()
+    {
+        // Room for 4 tiles of 512.
+        ShadowSchedulerSettings settings;
+        settings.atlas_size = 1024;
+        settings.min_tile_size = 128;
+        settings.max_tile_size = 512;
+        settings.update_budget = 8;
+        ShadowScheduler scheduler(settings);
+        uint32_t ids[4];
+        for (uint32_t i = 0; i < 4; ++i) ids[i] = scheduler.AddView(MakeView(XMFLOAT3(i * 4.0f - 6.0f, 0.0f, 20.0f), 4.0f));
+        CHECK(Schedule(scheduler).size() == 4);
+        CHECK(scheduler.Atlas().FreeTexels() == 0);
+
+        // Turned away: the tiles stay, nothing is drawn.
+        const Camera away = MakeCamera(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f));
+        CHECK(Schedule(scheduler, away).empty());
+        bool kept = true;
+        for (uint32_t id : ids) kept = kept && scheduler.Tile(id).size == 512 && scheduler.Influence(id) == 0.0f;
+        CHECK(kept);
+
+        // A visible view takes the tile of an off screen one.
+        const uint32_t behind = scheduler.AddView(MakeView(XMFLOAT3(0.0f, 0.0f, -20.0f), 4.0f));
+        vector<ShadowUpdate> updates = Schedule(scheduler, away);
+        CHECK(updates.size() == 1 && updates[0].view == behind && scheduler.Tile(behind).size == 512);
+        uint32_t evicted = 0;
+        for (uint32_t id : ids) evicted += scheduler.Tile(id).size == 0;
+        CHECK(evicted == 1);
+
+        // Back on screen, the evicted view takes it back from the one now
+        // off screen, and is drawn from scratch there.
+        updates = Schedule(scheduler);
+        CHECK(updates.size() == 1 && updates[0].view != behind && updates[0].static_casters && updates[0].tile.size == 512);
+        CHECK(scheduler.Tile(behind).size == 0);
+        scheduler.RemoveView(behind);
+
+        // Visible views with less influence give their tiles up too, while
+        // one with more influence only shrinks the newcomer.
+        const uint32_t close = scheduler.AddView(MakeView(XMFLOAT3(0.0f, 0.0f, 10.0f), 4.0f));
+        updates = Schedule(scheduler);
+        CHECK(updates.size() == 1 && updates[0].view == close && scheduler.Tile(close).size == 512);
+        const uint32_t far_view = scheduler.AddView(MakeView(XMFLOAT3(0.0f, 0.0f, 400.0f), 4.0f));
+        Schedule(scheduler);
+        CHECK(scheduler.Tile(far_view).size == 0);
+        uint32_t holders = 0;
+        for (uint32_t id : ids) holders += scheduler.Tile(id).size == 512;
+        CHECK(holders == 3);
+    }
+
+    void TestOrbit()
+    {
+        constexpr uint32_t kCount = 1000;
+        ShadowScheduler scheduler;
+        RandomGenerator random(50);
+        vector<ShadowView> views(kCount);
+        vector<uint32_t> ids(kCount);
+        for (uint32_t i = 0; i < kCount; ++i)
+        {
+            views[i] = MakeView(XMFLOAT3(random.NextFloat(-200.0f, 200.0f), random.NextFloat(0.0f, 20.0f), random.NextFloat(-200.0f, 200.0f)),
+                random.NextFloat(2.0f, 22.0f), i % 5 == 0);
+            ids[i] = scheduler.AddView(views[i]);
+        }
+
+        vector<int> last_update(kCount, -1);
+        vector<uint32_t> view_of_id(kCount);
+        for (uint32_t i = 0; i < kCount; ++i) view_of_id[ids[i]] = i;
+        bool budget = true, tiles_match = true, ids_reused = true;
+        uint32_t overlaps = 0, starved = 0;
+        float min_weighted_wait = FLT_MAX, max_weighted_wait = 0.0f;
+        for (int frame = 0; frame < 800; ++frame)
+        {
+            // Orbit, then hold still from frame 600.
+            const float angle = min(frame, 600) * 0.01f;
+            const Camera camera = MakeCamera(XMFLOAT3(50.0f * cosf(angle), 10.0f, 50.0f * sinf(angle)), XMFLOAT3(-sinf(angle), -0.1f, cosf(angle)));
+
+            // Lights come and go.
+            if (frame % 10 == 5)
+            {
+                const uint32_t i = random.NextUint() % kCount;
+                const uint32_t old_id = ids[i];
+                scheduler.RemoveView(old_id);
+                ids[i] = scheduler.AddView(views[i]);
+                ids_reused = ids_reused && ids[i] == old_id;
+                last_update[i] = -1;
+            }
+
+            const vector<ShadowUpdate> updates = Schedule(scheduler, camera);
+            budget = budget && updates.size() <= scheduler.Settings().update_budget;
+            for (const ShadowUpdate& update : updates)
+            {
+                const ShadowTile tile = scheduler.Tile(update.view);
+                tiles_match = tiles_match && tile.size > 0 && tile.x == update.tile.x && tile.y == update.tile.y && tile.size == update.tile.size;
+                const uint32_t i = view_of_id[update.view];
+                if (frame >= 700 && last_update[i] >= 600 && !update.static_casters)
+                {
+                    const float weighted_wait = (frame - last_update[i]) * scheduler.Influence(update.view);
+                    min_weighted_wait = min(min_weighted_wait, weighted_wait);
+                    max_weighted_wait = max(max_weighted_wait, weighted_wait);
+                }
+                last_update[i] = frame;
+            }
+
+            vector<ShadowTile> tiles;
+            for (uint32_t id : ids)
+            {
+                if (scheduler.Tile(id).size > 0) tiles.push_back(scheduler.Tile(id));
+            }
+            for (size_t a = 0; a < tiles.size(); ++a)
+            {
+                for (size_t b = a + 1; b < tiles.size(); ++b) overlaps += Overlap(tiles[a], tiles[b]);
+            }
+
+            // While views keep coming into sight their first draws go first,
+            // so waits are only bounded once the camera has been still for a
+            // while: then every visible dynamic view is redrawn.
+            for (uint32_t i = 0; frame >= 700 && i < kCount; i += 5)
+            {
+                if (scheduler.Influence(ids[i]) > 0.0f && frame - last_update[i] > 100) ++starved;
+            }
+        }
+        CHECK(budget);
+        CHECK(tiles_match);
+        CHECK(ids_reused);
+        CHECK(overlaps == 0);
+        CHECK(starved == 0);
+
+        // Waits go as 1 / influence: about the same frames * pixels for all.
+        CHECK(max_weighted_wait > 0.0f && max_weighted_wait < 2.0f * min_weighted_wait);
+    }
+}
+
+int main()
+{
+    TestSizes();
+    TestStaticCache();
+    TestBudget();
+    TestEviction();
+    TestOrbit();
+    return test::Result();
+}
@@ -0,0 +1,180 @@
+//--------------------------------------------------------------------------------
+//  software_occlusion_benchmark.cpp
+//  Occluder triangles per millisecond at 320 x 192: the scalar
+//  DepthRasterizer against SoftwareOcclusion serial and on the JobSystem,
+//  for 400 small cubes and one finely tessellated terrain, then boxes tested
+//  per millisecond by FilterVisible.
+//--------------------------------------------------------------------------------
+#include "software_occlusion.h"
+#include "depth_rasterizer.h"
+#include "job_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t kWidth = 320;
+    constexpr uint32_t kHeight = 192;
+    constexpr int kRepeat = 20;
+
+    struct Mesh
+    {
+        vector<XMFLOAT3> positions;
+        vector<uint32_t> indices;
+    };
+
+    Mesh MakeCubes(uint32_t count)
+    {
+        static const uint32_t kCubeIndices[36] =
+        {
+            0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+            2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3,
+        };
+        RandomGenerator random(3);
+        Mesh mesh;
+        for (uint32_t cube = 0; cube < count; ++cube)
+        {
+            const XMFLOAT3 center(random.NextFloat(-30.0f, 30.0f), random.NextFloat(0.0f, 10.0f), random.NextFloat(5.0f, 60.0f));
+            const float size = random.NextFloat(0.5f, 3.0f);
+            const uint32_t first = static_cast<uint32_t>(mesh.positions.size());
+            for (uint32_t corner = 0; corner < 8; ++corner)
+            {
+                mesh.positions.emplace_back(center.x + ((corner & 4) ? size : -size),
+                    center.y + ((corner & 2) ? size : -size), center.z + ((corner & 1) ? size : -size));
+            }
+            for (uint32_t index : kCubeIndices) mesh.indices.push_back(first + index);
+        }
+        return mesh;
+    }
+
+    Mesh MakeTerrain(uint32_t cells)
+    {
+        Mesh mesh;
+        for (uint32_t z = 0; z <= cells; ++z)
+        {
+            for (uint32_t x = 0; x <= cells; ++x)
+            {
+                const float fx = -40.0f + 80.0f * x / cells;
+                const float fz = 2.0f + 80.0f * z / cells;
+                mesh.positions.emplace_back(fx, 3.0f * sinf(fx * 0.3f) * cosf(fz * 0.2f), fz);
+            }
+        }
+        for (uint32_t z = 0; z < cells; ++z)
+        {
+            for (uint32_t x = 0; x < cells; ++x)
+            {
+                const uint32_t a = z * (cells + 1) + x;
+                const uint32_t b = a + cells + 1;
+                mesh.indices.insert(mesh.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+            }
+        }
+        return mesh;
+    }
+
+    OccluderMesh Occluder(const Mesh& mesh)
+    {
+        OccluderMesh occluder;
+        occluder.vertices = mesh.positions.data();
+        occluder.vertex_stride = sizeof(XMFLOAT3);
+        occluder.indices = mesh.indices.data();
+        occluder.indices_32bit = true;
+        occluder.index_count = static_cast<uint32_t>(mesh.indices.size());
+        return occluder;
+    }
+
+    void Report(const char* name, double ms, size_t count, const char* unit, double checksum)
+    {
+        printf("%-44s %9.1f %s/ms   (checksum %.3f)\n", name, count / ms, unit, checksum);
+    }
+
+    double Checksum(const float* depth, size_t count)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) sum += depth[i];
+        return sum;
+    }
+
+    void Measure(const char* name, const Mesh& mesh, const XMFLOAT4X4& view_proj)
+    {
+        const XMFLOAT4X4 identity(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+        const size_t triangle_count = mesh.indices.size() / 3;
+        char label[64];
+
+        if (!JobSystem::IsCreated())
+        {
+            DepthRasterizer rasterizer;
+            rasterizer.Resize(kWidth, kHeight);
+            const double ms = test::MeasureMs(kRepeat, [&]
+            {
+                rasterizer.Clear();
+                rasterizer.DrawIndexed(&mesh.positions[0].x, sizeof(XMFLOAT3), mesh.indices.data(), mesh.indices.size(), &view_proj.m[0][0]);
+            });
+            snprintf(label, sizeof(label), "%s, DepthRasterizer", name);
+            Report(label, ms, triangle_count, "triangles", Checksum(rasterizer.Depth(), kWidth * kHeight));
+        }
+
+        SoftwareOcclusion occlusion;
+        occlusion.Resize(kWidth, kHeight);
+        const double ms = test::MeasureMs(kRepeat, [&]
+        {
+            occlusion.BeginFrame(XMLoadFloat4x4(&view_proj));
+            occlusion.AddOccluder(Occluder(mesh), identity);
+            occlusion.Rasterize();
+        });
+        snprintf(label, sizeof(label), "%s, SoftwareOcclusion%s", name, JobSystem::IsCreated() ? " (jobs)" : "");
+        Report(label, ms, triangle_count, "triangles", Checksum(occlusion.Depth(), occlusion.Pitch() * kHeight));
+    }
+
+    void MeasureBoxes(const Mesh& occluders, const XMFLOAT4X4& view_proj)
+    {
+        constexpr uint32_t kBoxCount = 100000;
+        const XMFLOAT4X4 identity(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+        SoftwareOcclusion occlusion;
+        occlusion.Resize(kWidth, kHeight);
+        occlusion.BeginFrame(XMLoadFloat4x4(&view_proj));
+        occlusion.AddOccluder(Occluder(occluders), identity);
+        occlusion.Rasterize();
+
+        RandomGenerator random(5);
+        vector<XMFLOAT4X4> worlds(kBoxCount);
+        vector<BoundingBox> bounds(kBoxCount);
+        vector<uint32_t> candidates(kBoxCount);
+        for (uint32_t i = 0; i < kBoxCount; ++i)
+        {
+            XMStoreFloat4x4(&worlds[i], XMMatrixTranslation(random.NextFloat(-30.0f, 30.0f), random.NextFloat(-2.0f, 10.0f), random.NextFloat(5.0f, 80.0f)));
+            bounds[i] = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+            candidates[i] = i;
+        }
+        vector<uint32_t> visible;
+        const double ms = test::MeasureMs(kRepeat, [&]
+        {
+            occlusion.FilterVisible(worlds.data(), bounds.data(), candidates.data(), candidates.size(), visible);
+        });
+        Report(JobSystem::IsCreated() ? "FilterVisible (jobs)" : "FilterVisible", ms, kBoxCount, "boxes", static_cast<double>(visible.size()));
+    }
+}
+
+int main()
+{
+    XMFLOAT4X4 view_proj;
+    XMStoreFloat4x4(&view_proj, XMMatrixMultiply(
+        XMMatrixLookAtLH(XMVectorSet(0.0f, 8.0f, -5.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 40.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+        XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(kWidth) / kHeight, 0.1f, 200.0f)));
+    const Mesh cubes = MakeCubes(400);
+    const Mesh terrain = MakeTerrain(128);
+
+    Measure("400 cubes", cubes, view_proj);
+    Measure("terrain 128 x 128", terrain, view_proj);
+    MeasureBoxes(cubes, view_proj);
+
+    JobSystem::Create()->Initialize();
+    Measure("400 cubes", cubes, view_proj);
+    Measure("terrain 128 x 128", terrain, view_proj);
+    MeasureBoxes(cubes, view_proj);
+    JobSystem::Instance().Release();
+    return 0;
+}
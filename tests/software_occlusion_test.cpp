@@ -0,0 +1,383 @@
+//--------------------------------------------------------------------------------
+//  software_occlusion_test.cpp
+//  SoftwareOcclusion against DepthRasterizer, the scalar reference of the
+//  same rules: depth and coverage of random triangles (vertices on the 1/16
+//  pixel grid, where both snap exactly), top-left fill rule edge cases on
+//  tile borders, 16 and 32 bit occluders, and occlusion accuracy of boxes in
+//  a perspective scene, serial and on the JobSystem.
+//--------------------------------------------------------------------------------
+#include "software_occlusion.h"
+#include "depth_rasterizer.h"
+#include "hi_z_pyramid.h"
+#include "job_system.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    struct Mesh
+    {
+        vector<XMFLOAT3> positions;
+        vector<uint32_t> indices;
+    };
+
+    OccluderMesh Occluder(const Mesh& mesh)
+    {
+        OccluderMesh occluder;
+        occluder.vertices = mesh.positions.data();
+        occluder.vertex_stride = sizeof(XMFLOAT3);
+        occluder.indices = mesh.indices.data();
+        occluder.indices_32bit = true;
+        occluder.index_count = static_cast<uint32_t>(mesh.indices.size());
+        return occluder;
+    }
+
+    void AddTriangle(Mesh& mesh, const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+    {
+        const uint32_t first = static_cast<uint32_t>(mesh.positions.size());
+        mesh.positions.push_back(a);
+        mesh.positions.push_back(b);
+        mesh.positions.push_back(c);
+        mesh.indices.insert(mesh.indices.end(), { first, first + 1, first + 2 });
+    }
+
+    // Pixels (y down) to clip space, row vectors.
+    XMFLOAT4X4 PixelToClip(uint32_t width, uint32_t height)
+    {
+        return XMFLOAT4X4(
+            2.0f / width, 0.0f, 0.0f, 0.0f,
+            0.0f, -2.0f / height, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            -1.0f, 1.0f, 0.0f, 1.0f);
+    }
+
+    const XMFLOAT4X4& Identity()
+    {
+        static const XMFLOAT4X4 identity(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+        return identity;
+    }
+
+    void Draw(SoftwareOcclusion& occlusion, const Mesh& mesh, const XMFLOAT4X4& view_proj)
+    {
+        occlusion.BeginFrame(XMLoadFloat4x4(&view_proj));
+        occlusion.AddOccluder(Occluder(mesh), Identity());
+        occlusion.Rasterize();
+    }
+
+    void Draw(DepthRasterizer& rasterizer, const Mesh& mesh, const XMFLOAT4X4& view_proj)
+    {
+        rasterizer.Clear();
+        rasterizer.DrawIndexed(&mesh.positions[0].x, sizeof(XMFLOAT3), mesh.indices.data(), mesh.indices.size(), &view_proj.m[0][0]);
+    }
+
+    // Pixels where one buffer is covered and the other is not, or where
+    // the depths differ.
+    uint32_t Mismatches(const SoftwareOcclusion& occlusion, const DepthRasterizer& rasterizer)
+    {
+        uint32_t mismatches = 0;
+        for (uint32_t y = 0; y < occlusion.Height(); ++y)
+        {
+            for (uint32_t x = 0; x < occlusion.Width(); ++x)
+            {
+                const float depth = occlusion.Depth()[y * occlusion.Pitch() + x];
+                const float expected = rasterizer.Depth()[y * rasterizer.Width() + x];
+                if ((depth == 1.0f) != (expected == 1.0f) || fabsf(depth - expected) > 1e-5f) ++mismatches;
+            }
+        }
+        return mismatches;
+    }
+
+    float OnGrid(float value)
+    {
+        return roundf(value * 16.0f) / 16.0f;
+    }
+
+    void TestMatchesReference(uint32_t width, uint32_t height)
+    {
+        // Inside the guard band of SoftwareOcclusion, so neither clips.
+        RandomGenerator random(width * 7 + height);
+        Mesh mesh;
+        for (uint32_t i = 0; i < 600; ++i)
+        {
+            XMFLOAT3 v[3];
+            const float size = i % 10 == 0 ? 1.2f * width : 24.0f;
+            const float x = random.NextFloat(-0.1f * width, 1.1f * width);
+            const float y = random.NextFloat(-0.1f * height, 1.1f * height);
+            for (XMFLOAT3& p : v)
+            {
+                p.x = OnGrid(max(-0.2f * width, min(1.2f * width, random.NextFloat(x - size, x + size))));
+                p.y = OnGrid(max(-0.2f * height, min(1.2f * height, random.NextFloat(y - size, y + size))));
+                p.z = random.NextFloat(0.05f, 0.95f);
+            }
+            AddTriangle(mesh, v[0], v[1], v[2]);
+        }
+
+        const XMFLOAT4X4 view_proj = PixelToClip(width, height);
+        SoftwareOcclusion occlusion;
+        occlusion.Resize(width, height);
+        Draw(occlusion, mesh, view_proj);
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(width, height);
+        Draw(rasterizer, mesh, view_proj);
+        CHECK(occlusion.TriangleCount() == 600);
+        CHECK(Mismatches(occlusion, rasterizer) == 0);
+
+        // One triangle at a time: coverage, not only the nearest depth.
+        uint32_t mismatches = 0;
+        for (uint32_t i = 0; i < 600; i += 7)
+        {
+            Mesh single;
+            AddTriangle(single, mesh.positions[i * 3], mesh.positions[i * 3 + 1], mesh.positions[i * 3 + 2]);
+            Draw(occlusion, single, view_proj);
+            Draw(rasterizer, single, view_proj);
+            mismatches += Mismatches(occlusion, rasterizer);
+        }
+        CHECK(mismatches == 0);
+    }
+
+    void TestFillRule()
+    {
+        constexpr uint32_t kWidth = 100, kHeight = 70;
+        const XMFLOAT4X4 view_proj = PixelToClip(kWidth, kHeight);
+        SoftwareOcclusion occlusion;
+        occlusion.Resize(kWidth, kHeight);
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(kWidth, kHeight);
+
+        // Fans around a vertex on the tile corner (32, 16): on a pixel
+        // corner, on a pixel center and between them.  Every pixel of the
+        // square is drawn by exactly one triangle, as in DepthRasterizer.
+        const XMFLOAT2 centers[] = { { 32.0f, 16.0f }, { 32.5f, 16.5f }, { 32.0625f, 15.9375f } };
+        for (const XMFLOAT2& center : centers)
+        {
+            const XMFLOAT2 ring[8] = { { 24.5f, 8.5f }, { 32.0f, 8.5f }, { 40.5f, 8.5f }, { 40.5f, 16.0f },
+                { 40.5f, 24.5f }, { 32.0f, 24.5f }, { 24.5f, 24.5f }, { 24.5f, 16.0f } };
+            vector<uint32_t> counts(kWidth * kHeight, 0);
+            uint32_t mismatches = 0;
+            for (int i = 0; i < 8; ++i)
+            {
+                const XMFLOAT2& a = ring[i];
+                const XMFLOAT2& b = ring[(i + 1) % 8];
+                Mesh triangle;
+                // Alternate windings; both faces are drawn.
+                if (i & 1) AddTriangle(triangle, { center.x, center.y, 0.5f }, { a.x, a.y, 0.5f }, { b.x, b.y, 0.5f });
+                else AddTriangle(triangle, { center.x, center.y, 0.5f }, { b.x, b.y, 0.5f }, { a.x, a.y, 0.5f });
+                Draw(occlusion, triangle, view_proj);
+                Draw(rasterizer, triangle, view_proj);
+                mismatches += Mismatches(occlusion, rasterizer);
+                for (uint32_t y = 0; y < kHeight; ++y)
+                {
+                    for (uint32_t x = 0; x < kWidth; ++x)
+                    {
+                        if (occlusion.Depth()[y * occlusion.Pitch() + x] != 1.0f) ++counts[y * kWidth + x];
+                    }
+                }
+            }
+            bool once = true;
+            for (uint32_t y = 0; y < kHeight; ++y)
+            {
+                for (uint32_t x = 0; x < kWidth; ++x)
+                {
+                    const uint32_t expected = x >= 24 && x < 40 && y >= 8 && y < 24 ? 1 : 0;
+                    once = once && counts[y * kWidth + x] == expected;
+                }
+            }
+            CHECK(once);
+            CHECK(mismatches == 0);
+        }
+
+        // Edges along pixel centers on the last column and row of the
+        // screen (the padded lanes of the 4 pixel groups).
+        Mesh edge;
+        AddTriangle(edge, { 90.5f, 60.5f, 0.5f }, { 99.5f, 60.5f, 0.5f }, { 99.5f, 69.5f, 0.5f });
+        AddTriangle(edge, { 90.5f, 60.5f, 0.5f }, { 99.5f, 69.5f, 0.5f }, { 90.5f, 69.5f, 0.5f });
+        AddTriangle(edge, { 98.0f, 0.0f, 0.25f }, { 101.0f, 0.0f, 0.25f }, { 101.0f, 3.0f, 0.25f });
+        Draw(occlusion, edge, view_proj);
+        Draw(rasterizer, edge, view_proj);
+        CHECK(Mismatches(occlusion, rasterizer) == 0);
+        CHECK(occlusion.Depth()[60 * occlusion.Pitch() + 90] == 0.5f && occlusion.Depth()[60 * occlusion.Pitch() + 99] == 1.0f);
+        CHECK(occlusion.Depth()[69 * occlusion.Pitch() + 90] == 1.0f);
+    }
+
+    void TestOccluderMeshes()
+    {
+        // A 16 bit indexed submesh with start index and base vertex, next to
+        // the same triangles as a 32 bit mesh.
+        constexpr uint32_t kWidth = 64, kHeight = 64;
+        const XMFLOAT4X4 view_proj = PixelToClip(kWidth, kHeight);
+        vector<XMFLOAT3> positions(10, XMFLOAT3(0.0f, 0.0f, 0.0f));
+        positions.push_back({ 4.0f, 4.0f, 0.5f });
+        positions.push_back({ 60.0f, 4.0f, 0.5f });
+        positions.push_back({ 60.0f, 60.0f, 0.25f });
+        positions.push_back({ 4.0f, 60.0f, 0.25f });
+        const uint16_t indices16[] = { 9, 9, 9, 0, 1, 2, 0, 2, 3 };
+
+        SoftwareOcclusion occlusion;
+        occlusion.Resize(kWidth, kHeight);
+        occlusion.BeginFrame(XMLoadFloat4x4(&view_proj));
+        OccluderMesh submesh;
+        submesh.vertices = positions.data();
+        submesh.vertex_stride = sizeof(XMFLOAT3);
+        submesh.indices = indices16;
+        submesh.indices_32bit = false;
+        submesh.index_count = 6;
+        submesh.start_index = 3;
+        submesh.base_vertex = 10;
+        occlusion.AddOccluder(submesh, Identity());
+        occlusion.Rasterize();
+
+        Mesh mesh;
+        mesh.positions.assign(positions.begin() + 10, positions.end());
+        mesh.indices = { 0, 1, 2, 0, 2, 3 };
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(kWidth, kHeight);
+        Draw(rasterizer, mesh, view_proj);
+        CHECK(occlusion.TriangleCount() == 2);
+        CHECK(Mismatches(occlusion, rasterizer) == 0);
+
+        // Many occluders whose triangles straddle the setup chunks.
+        Mesh strip;
+        for (uint32_t i = 0; i < 300; ++i)
+        {
+            const float x = static_cast<float>(i % 60);
+            AddTriangle(strip, { x, 0.0f, 0.9f - i * 0.002f }, { x + 4.0f, 64.0f, 0.9f - i * 0.002f }, { x, 64.0f, 0.9f - i * 0.002f });
+        }
+        occlusion.BeginFrame(XMLoadFloat4x4(&view_proj));
+        for (uint32_t i = 0; i < 300; i += 100)
+        {
+            OccluderMesh part = Occluder(strip);
+            part.start_index = i * 3;
+            part.index_count = 300;
+            occlusion.AddOccluder(part, Identity());
+        }
+        occlusion.Rasterize();
+        Draw(rasterizer, strip, view_proj);
+        CHECK(occlusion.TriangleCount() == 300 && occlusion.RasterizedTriangleCount() == 300);
+        CHECK(Mismatches(occlusion, rasterizer) == 0);
+    }
+
+    // Reference visibility: a pixel of the box rectangle is not nearer than
+    // the box.
+    bool ReferenceVisible(const DepthRasterizer& rasterizer, const XMFLOAT4X4& world_view_proj, const BoundingBox& bounds)
+    {
+        HiZRect rect;
+        if (!HiZPyramid::ProjectBox(&world_view_proj.m[0][0], &bounds.Center.x, &bounds.Extents.x,
+            rasterizer.Width(), rasterizer.Height(), &rect))
+        {
+            return true;
+        }
+        for (uint32_t y = rect.min_y; y <= rect.max_y; ++y)
+        {
+            for (uint32_t x = rect.min_x; x <= rect.max_x; ++x)
+            {
+                if (rasterizer.Depth()[y * rasterizer.Width() + x] >= rect.min_depth) return true;
+            }
+        }
+        return false;
+    }
+
+    void TestAccuracy()
+    {
+        constexpr uint32_t kWidth = 320, kHeight = 192;
+        XMFLOAT4X4 view_proj;
+        XMStoreFloat4x4(&view_proj, XMMatrixMultiply(
+            XMMatrixLookAtLH(XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 2.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+            XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(kWidth) / kHeight, 0.1f, 200.0f)));
+
+        // A wall 10 wide and 4 high at z = 5 and a ground plane through the
+        // near plane.
+        Mesh scene;
+        AddTriangle(scene, { -5.0f, 0.0f, 5.0f }, { 5.0f, 4.0f, 5.0f }, { 5.0f, 0.0f, 5.0f });
+        AddTriangle(scene, { -5.0f, 0.0f, 5.0f }, { -5.0f, 4.0f, 5.0f }, { 5.0f, 4.0f, 5.0f });
+        AddTriangle(scene, { -50.0f, 0.0f, -20.0f }, { -50.0f, 0.0f, 80.0f }, { 50.0f, 0.0f, 80.0f });
+        AddTriangle(scene, { -50.0f, 0.0f, -20.0f }, { 50.0f, 0.0f, 80.0f }, { 50.0f, 0.0f, -20.0f });
+
+        SoftwareOcclusion occlusion;
+        occlusion.Resize(kWidth, kHeight);
+        Draw(occlusion, scene, view_proj);
+        DepthRasterizer rasterizer;
+        rasterizer.Resize(kWidth, kHeight);
+        Draw(rasterizer, scene, view_proj);
+
+        // Off grid vertices snap to 1/16 against 1/256 of a pixel: only
+        // pixels along edges may differ.
+        CHECK(Mismatches(occlusion, rasterizer) < kWidth * kHeight / 200);
+
+        auto is_visible = [&occlusion](const XMFLOAT3& center, const XMFLOAT3& extents)
+        {
+            XMFLOAT4X4 world;
+            XMStoreFloat4x4(&world, XMMatrixTranslation(center.x, center.y, center.z));
+            return occlusion.IsVisible(BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), extents), world);
+        };
+        CHECK(!is_visible({ 0.0f, 2.0f, 8.0f }, { 1.0f, 1.0f, 1.0f }));       // behind the wall
+        CHECK(is_visible({ 0.0f, 2.0f, 3.0f }, { 1.0f, 1.0f, 1.0f }));        // in front of it
+        CHECK(is_visible({ 9.0f, 2.0f, 8.0f }, { 1.0f, 1.0f, 1.0f }));        // beside it
+        CHECK(is_visible({ 0.0f, 4.5f, 8.0f }, { 1.0f, 1.0f, 1.0f }));        // over its top edge
+        CHECK(!is_visible({ 0.0f, -3.0f, 8.0f }, { 1.0f, 1.0f, 1.0f }));      // under the ground
+        CHECK(is_visible({ 0.0f, 2.0f, -10.0f }, { 1.0f, 1.0f, 1.0f }));      // around the camera
+
+        // Random boxes: against the reference, no box that shows a pixel is
+        // reported hidden beyond the snapping difference, and nearly all
+        // hidden ones are caught.
+        RandomGenerator random(48);
+        constexpr uint32_t kBoxCount = 4000;
+        vector<XMFLOAT4X4> worlds(kBoxCount);
+        vector<BoundingBox> bounds(kBoxCount);
+        vector<uint32_t> candidates(kBoxCount);
+        uint32_t hidden = 0, caught = 0, false_hidden = 0;
+        for (uint32_t i = 0; i < kBoxCount; ++i)
+        {
+            const XMFLOAT3 center(random.NextFloat(-12.0f, 12.0f), random.NextFloat(-2.0f, 7.0f), random.NextFloat(5.5f, 30.0f));
+            bounds[i] = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(random.NextFloat(0.05f, 1.5f), random.NextFloat(0.05f, 1.5f), random.NextFloat(0.05f, 1.5f)));
+            XMStoreFloat4x4(&worlds[i], XMMatrixTranslation(center.x, center.y, center.z));
+            candidates[i] = i;
+
+            XMFLOAT4X4 world_view_proj;
+            XMStoreFloat4x4(&world_view_proj, XMMatrixMultiply(XMLoadFloat4x4(&worlds[i]), XMLoadFloat4x4(&view_proj)));
+            const bool expected = ReferenceVisible(rasterizer, world_view_proj, bounds[i]);
+            const bool visible = occlusion.IsVisible(bounds[i], worlds[i]);
+            if (!expected) ++hidden;
+            if (!expected && !visible) ++caught;
+            if (expected && !visible) ++false_hidden;
+        }
+        CHECK(hidden > kBoxCount / 4);
+        CHECK(caught >= hidden * 99 / 100);
+        CHECK(false_hidden <= kBoxCount / 500);
+
+        // FilterVisible keeps exactly the visible candidates, in order, also
+        // when split across jobs.
+        vector<uint32_t> expected;
+        for (uint32_t i = 0; i < kBoxCount; ++i)
+        {
+            if (occlusion.IsVisible(bounds[i], worlds[i])) expected.push_back(i);
+        }
+        vector<uint32_t> visible;
+        occlusion.FilterVisible(worlds.data(), bounds.data(), candidates.data(), candidates.size(), visible);
+        CHECK(visible == expected);
+    }
+}
+
+int main()
+{
+    TestMatchesReference(128, 64);
+    TestMatchesReference(100, 70);
+    TestMatchesReference(37, 300);
+    TestFillRule();
+    TestOccluderMeshes();
+    TestAccuracy();
+
+    // The same on the JobSystem: tiles and chunks in parallel.
+    JobSystem::Create()->Initialize(4);
+    TestMatchesReference(128, 64);
+    TestMatchesReference(333, 250);
+    TestFillRule();
+    TestOccluderMeshes();
+    TestAccuracy();
+    JobSystem::Instance().Release();
+    return test::Result();
+}
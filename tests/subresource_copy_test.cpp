@@ -0,0 +1,163 @@
+//--------------------------------------------------------------------------------
+//  subresource_copy_test.cpp
+//  SubresourceCopier against a per row memcpy reference: unaligned and
+//  short rows, pitches, slices, padding left untouched, and the split across
+//  the JobSystem.
+//--------------------------------------------------------------------------------
+#include "subresource_copy.h"
+#include "job_system.h"
+#include "test_util.h"
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    constexpr uint8_t kPadding = 0xcd;
+
+    // Copies copy with the reference loop into a destination of the same
+    // layout, then compares the whole destination including the padding.
+    bool MatchesReference(const SubresourceCopy& copy, const vector<uint8_t>& destination, size_t destination_offset)
+    {
+        vector<uint8_t> expected(destination.size(), kPadding);
+        for (uint32_t slice = 0; slice < copy.slice_count; ++slice)
+        {
+            for (uint32_t row = 0; row < copy.row_count; ++row)
+            {
+                memcpy(expected.data() + destination_offset + slice * copy.destination_slice_pitch + row * copy.destination_row_pitch,
+                    static_cast<const uint8_t*>(copy.source) + slice * copy.source_slice_pitch + row * copy.source_row_pitch,
+                    copy.row_bytes);
+            }
+        }
+        return expected == destination;
+    }
+
+    vector<uint8_t> MakeSource(size_t size)
+    {
+        vector<uint8_t> source(size);
+        for (size_t i = 0; i < size; ++i) source[i] = static_cast<uint8_t>(i * 131 + (i >> 8));
+        return source;
+    }
+
+    void TestStreamCopy()
+    {
+        // Sizes around the streaming threshold and the 16 / 64 byte steps,
+        // at every destination and source misalignment.
+        const vector<uint8_t> source = MakeSource(4096 + 32);
+        const size_t sizes[] = { 0, 1, 15, 16, 17, 63, 64, 255, 256, 257, 1000, 4095, 4096 };
+        bool same = true;
+        for (size_t size : sizes)
+        {
+            for (size_t destination_offset = 0; destination_offset < 16; ++destination_offset)
+            {
+                for (size_t source_offset = 0; source_offset < 16; source_offset += 5)
+                {
+                    vector<uint8_t> destination(size + 48, kPadding);
+                    SubresourceCopier::StreamCopy(destination.data() + destination_offset, source.data() + source_offset, size);
+                    SubresourceCopier::StreamFence();
+                    same = same && memcmp(destination.data() + destination_offset, source.data() + source_offset, size) == 0;
+                    for (size_t i = 0; i < destination_offset; ++i) same = same && destination[i] == kPadding;
+                    for (size_t i = destination_offset + size; i < destination.size(); ++i) same = same && destination[i] == kPadding;
+                }
+            }
+        }
+        CHECK(same);
+    }
+
+    void TestLayouts()
+    {
+        struct Layout
+        {
+            size_t   row_bytes;
+            size_t   destination_row_pitch;
+            size_t   source_row_pitch;
+            uint32_t row_count;
+            uint32_t slice_count;
+        };
+        const Layout layouts[] =
+        {
+            { 4,    256,  4,    1,    1 },  // 1x1 RGBA8, D3D12 row pitch alignment
+            { 1000, 1024, 1000, 37,   1 },  // padded destination rows
+            { 1024, 1024, 1024, 64,   1 },  // packed: one run per slice
+            { 1024, 1024, 1024, 16,   4 },  // packed slices
+            { 300,  512,  304,  9,    3 },  // padded both sides, slices
+        };
+        for (const Layout& layout : layouts)
+        {
+            for (size_t destination_offset = 0; destination_offset < 16; destination_offset += 3)
+            {
+                SubresourceCopy copy;
+                copy.row_bytes = layout.row_bytes;
+                copy.row_count = layout.row_count;
+                copy.slice_count = layout.slice_count;
+                copy.source_row_pitch = layout.source_row_pitch;
+                copy.source_slice_pitch = layout.source_row_pitch * layout.row_count;
+                copy.destination_row_pitch = layout.destination_row_pitch;
+                copy.destination_slice_pitch = layout.destination_row_pitch * layout.row_count;
+
+                const vector<uint8_t> source = MakeSource(copy.source_slice_pitch * copy.slice_count);
+                vector<uint8_t> destination(destination_offset + copy.destination_slice_pitch * copy.slice_count + 64, kPadding);
+                copy.source = source.data();
+                copy.destination = destination.data() + destination_offset;
+                SubresourceCopier::Copy(&copy, 1);
+                CHECK(MatchesReference(copy, destination, destination_offset));
+
+                // Any split of the rows gives the same result.
+                vector<uint8_t> split(destination.size(), kPadding);
+                copy.destination = split.data() + destination_offset;
+                const size_t rows = static_cast<size_t>(copy.row_count) * copy.slice_count;
+                for (size_t begin = 0; begin < rows; begin += 5) SubresourceCopier::CopyRows(copy, begin, min(rows, begin + 5));
+                SubresourceCopier::StreamFence();
+                CHECK(split == destination);
+            }
+        }
+    }
+
+    void TestParallel()
+    {
+        // Above kParallelMinBytes, with a row count that does not divide
+        // into the rows per job, and a small copy alongside it.
+        SubresourceCopy copies[2];
+        copies[0].row_bytes = 4000;
+        copies[0].row_count = 333;
+        copies[0].slice_count = 2;
+        copies[0].source_row_pitch = 4000;
+        copies[0].source_slice_pitch = 4000 * 333;
+        copies[0].destination_row_pitch = 4096;
+        copies[0].destination_slice_pitch = 4096 * 333;
+        copies[1].row_bytes = 64;
+        copies[1].row_count = 4;
+        copies[1].source_row_pitch = 64;
+        copies[1].source_slice_pitch = 256;
+        copies[1].destination_row_pitch = 256;
+        copies[1].destination_slice_pitch = 1024;
+        CHECK(copies[0].row_bytes * copies[0].row_count * copies[0].slice_count > SubresourceCopier::kParallelMinBytes);
+
+        const vector<uint8_t> source0 = MakeSource(copies[0].source_slice_pitch * 2);
+        const vector<uint8_t> source1 = MakeSource(copies[1].source_slice_pitch);
+        vector<uint8_t> destination0(copies[0].destination_slice_pitch * 2 + 64, kPadding);
+        vector<uint8_t> destination1(copies[1].destination_slice_pitch + 64, kPadding);
+        copies[0].source = source0.data();
+        copies[0].destination = destination0.data();
+        copies[1].source = source1.data();
+        copies[1].destination = destination1.data();
+
+        SubresourceCopier::Copy(copies, 2);
+        CHECK(MatchesReference(copies[0], destination0, 0));
+        CHECK(MatchesReference(copies[1], destination1, 0));
+    }
+}
+
+int main()
+{
+    TestStreamCopy();
+    TestLayouts();
+    TestParallel();
+
+    JobSystem::Create()->Initialize(4);
+    TestLayouts();
+    TestParallel();
+    JobSystem::Instance().Release();
+    return test::Result();
+}
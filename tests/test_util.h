@@ -0,0 +1,52 @@
+//--------------------------------------------------------------------------------
+//  test_util.h
+//  Checks and timing shared by the headless tests and benchmarks (no test
+//  framework).  A failed CHECK prints its location and the test goes on;
+//  main returns test::Result() so ctest sees the failure.  Benchmarks print
+//  a checksum of their results so the measured work is not optimized away.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+namespace test
+{
+    inline int& FailureCount()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline void Fail(const char* file, int line, const char* expression)
+    {
+        fprintf(stderr, "%s(%d): CHECK(%s) failed\n", file, line, expression);
+        ++FailureCount();
+    }
+
+    inline int Result()
+    {
+        if (FailureCount() == 0)
+        {
+            printf("passed\n");
+            return 0;
+        }
+        printf("%d check(s) failed\n", FailureCount());
+        return 1;
+    }
+
+    //--------------------------------------------------------------------------------
+    //  Average milliseconds per call of function over repeat calls, after
+    //  one warm up call
+    //--------------------------------------------------------------------------------
+    template<typename Function>
+    double MeasureMs(int repeat, Function&& function)
+    {
+        function();
+        const auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; ++i) function();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - begin).count() / repeat;
+    }
+}
+
+#define CHECK(expression) ((expression) ? (void)0 : test::Fail(__FILE__, __LINE__, #expression))
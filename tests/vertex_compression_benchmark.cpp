@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------------
+//  vertex_compression_benchmark.cpp
+//  Vertices per microsecond of the VertexCompression encoders, and of the
+//  whole CompressMesh import step.
+//--------------------------------------------------------------------------------
+#include "vertex_compression.h"
+#include "mesh_file.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    constexpr size_t kCount = 1 << 20;
+    constexpr int kRepeat = 10;
+
+    void Report(const char* name, double ms, uint32_t checksum)
+    {
+        printf("%-24s %8.1f vertices/us   (checksum %u)\n", name, kCount / (ms * 1000.0), checksum);
+    }
+}
+
+int main()
+{
+    RandomGenerator random(1);
+    vector<XMFLOAT3> positions(kCount), normals(kCount), tangents(kCount);
+    vector<XMFLOAT4> positions4(kCount), colors(kCount);
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        positions[i] = XMFLOAT3(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f));
+        positions4[i] = XMFLOAT4(positions[i].x, positions[i].y, positions[i].z, 1.0f);
+        colors[i] = XMFLOAT4(random.NextFloat(), random.NextFloat(), random.NextFloat(), 1.0f);
+        const float length = sqrtf(positions[i].x * positions[i].x + positions[i].y * positions[i].y + positions[i].z * positions[i].z) + 1e-6f;
+        normals[i] = XMFLOAT3(positions[i].x / length, positions[i].y / length, positions[i].z / length);
+        // Any vector perpendicular to the normal.
+        const float t_length = sqrtf(normals[i].x * normals[i].x + normals[i].z * normals[i].z) + 1e-6f;
+        tangents[i] = XMFLOAT3(normals[i].z / t_length, 0.0f, -normals[i].x / t_length);
+    }
+    const BoundingBox bounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+    vector<QuantizedMeshVertex> mesh_vertices(kCount);
+    double ms = test::MeasureMs(kRepeat, [&]
+    {
+        VertexCompression::QuantizePositions(positions.data(), kCount, bounds, mesh_vertices[0].Position, sizeof(QuantizedMeshVertex));
+    });
+    Report("QuantizePositions", ms, mesh_vertices[kCount / 2].Position[0]);
+
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        for (size_t i = 0; i < kCount; ++i) mesh_vertices[i].TangentFrame = VertexCompression::EncodeTangentFrame(normals[i], &tangents[i], 1.0f);
+    });
+    Report("EncodeTangentFrame", ms, mesh_vertices[kCount / 2].TangentFrame);
+
+    uint32_t checksum = 0;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        XMFLOAT3 n, t;
+        float s = 0.0f;
+        for (size_t i = 0; i < kCount; ++i) VertexCompression::DecodeTangentFrame(mesh_vertices[i].TangentFrame, n, t, s);
+        checksum = static_cast<uint32_t>((n.x + t.y + s) * 1000.0f);
+    });
+    Report("DecodeTangentFrame", ms, checksum);
+
+    vector<QuantizedColorVertex> color_vertices(kCount);
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        VertexCompression::CompressColorVertices(positions4.data(), colors.data(), kCount, bounds, color_vertices.data());
+    });
+    Report("CompressColorVertices", ms, color_vertices[kCount / 2].Color);
+
+    // mesh_converter layout: float3 position, float3 normal, float2 texcoord.
+    MeshFileData source;
+    source.vertex_stride = 32;
+    source.vertices.resize(kCount * 32);
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        const float v[8] = { positions[i].x, positions[i].y, positions[i].z, normals[i].x, normals[i].y, normals[i].z, 0.5f, 0.5f };
+        memcpy(&source.vertices[i * 32], v, sizeof(v));
+    }
+    source.indices.resize(kCount);
+    for (size_t i = 0; i < kCount; ++i) source.indices[i] = static_cast<uint32_t>(i);
+    MeshFileData::Submesh submesh;
+    submesh.index_count = static_cast<uint32_t>(kCount);
+    submesh.extents[0] = submesh.extents[1] = submesh.extents[2] = 1.0f;
+    source.submeshes.push_back(submesh);
+
+    MeshFileData data;
+    ms = test::MeasureMs(kRepeat, [&]
+    {
+        data = source;
+        VertexCompression::CompressMesh(data);
+    });
+    Report("CompressMesh", ms, static_cast<uint32_t>(data.vertices.size()));
+    return 0;
+}
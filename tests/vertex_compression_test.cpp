@@ -0,0 +1,214 @@
+//--------------------------------------------------------------------------------
+//  vertex_compression_test.cpp
+//  Encode / decode round trips and error bounds of VertexCompression.  The
+//  tangent frame is also decoded the way triangle.hlsl does it, from the
+//  R10G10B10A2_UNORM values the input assembler produces.
+//--------------------------------------------------------------------------------
+#include "vertex_compression.h"
+#include "mesh_file.h"
+#include "random_generator.h"
+#include "test_util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Normalize(const XMFLOAT3& v)
+    {
+        const float length = sqrtf(Dot(v, v));
+        return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+    }
+
+    XMFLOAT3 RandomUnit(RandomGenerator& random)
+    {
+        while (true)
+        {
+            const XMFLOAT3 v(random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f));
+            const float length_sq = Dot(v, v);
+            if (length_sq > 1e-4f && length_sq <= 1.0f) return Normalize(v);
+        }
+    }
+
+    float AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return acosf(min(1.0f, max(-1.0f, Dot(a, b)))) * 57.2957795f;
+    }
+
+    // bitangent_sign of triangle.hlsl: packed.w > 0.5f, with packed.w the
+    // 2 bit UNORM as the input assembler converts it.
+    float ShaderBitangentSign(uint32_t packed)
+    {
+        const float w = static_cast<float>(packed >> 30) / 3.0f;
+        return w > 0.5f ? 1.0f : -1.0f;
+    }
+
+    void TestTangentFrame()
+    {
+        RandomGenerator random(21);
+        float max_normal_error = 0.0f, max_tangent_error = 0.0f;
+        bool signs_match = true, shader_signs_match = true, orthonormal = true;
+        for (int i = 0; i < 200000; ++i)
+        {
+            const XMFLOAT3 normal = RandomUnit(random);
+            // A tangent perpendicular to the normal.
+            const XMFLOAT3 r = RandomUnit(random);
+            const float d = Dot(r, normal);
+            if (fabsf(d) > 0.99f) continue;
+            const XMFLOAT3 tangent = Normalize(XMFLOAT3(r.x - d * normal.x, r.y - d * normal.y, r.z - d * normal.z));
+            const float sign = (i & 1) ? 1.0f : -1.0f;
+
+            const uint32_t packed = VertexCompression::EncodeTangentFrame(normal, &tangent, sign);
+            XMFLOAT3 decoded_normal, decoded_tangent;
+            float decoded_sign = 0.0f;
+            VertexCompression::DecodeTangentFrame(packed, decoded_normal, decoded_tangent, decoded_sign);
+
+            max_normal_error = max(max_normal_error, AngleDegrees(normal, decoded_normal));
+            max_tangent_error = max(max_tangent_error, AngleDegrees(tangent, decoded_tangent));
+            signs_match = signs_match && decoded_sign == sign;
+            shader_signs_match = shader_signs_match && ShaderBitangentSign(packed) == sign;
+            orthonormal = orthonormal && fabsf(Dot(decoded_normal, decoded_tangent)) < 1e-4f
+                && fabsf(Dot(decoded_tangent, decoded_tangent) - 1.0f) < 1e-4f;
+        }
+        CHECK(signs_match);
+        CHECK(shader_signs_match);
+        CHECK(orthonormal);
+        // 10 bit octahedral normal and 10 bit angle.
+        CHECK(max_normal_error < 0.3f);
+        CHECK(max_tangent_error < 0.5f);
+        printf("tangent frame: max normal error %.3f deg, max tangent error %.3f deg\n", max_normal_error, max_tangent_error);
+
+        // The sign field is 0 or 3: 0.0 / 1.0 once converted to UNORM.
+        const XMFLOAT3 up(0.0f, 1.0f, 0.0f);
+        CHECK((VertexCompression::EncodeTangentFrame(up, nullptr, 1.0f) >> 30) == 3);
+        CHECK((VertexCompression::EncodeTangentFrame(up, nullptr, -1.0f) >> 30) == 0);
+
+        // Normals on the octahedron edges and poles.
+        const XMFLOAT3 axes[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        for (const XMFLOAT3& axis : axes)
+        {
+            XMFLOAT3 n, t;
+            float s;
+            VertexCompression::DecodeTangentFrame(VertexCompression::EncodeTangentFrame(axis, nullptr, 1.0f), n, t, s);
+            CHECK(AngleDegrees(axis, n) < 0.25f);
+        }
+    }
+
+    void TestPositions()
+    {
+        RandomGenerator random(3);
+        const BoundingBox bounds(XMFLOAT3(10.0f, -5.0f, 2.0f), XMFLOAT3(50.0f, 4.0f, 0.5f));
+        vector<XMFLOAT3> positions(10000);
+        for (XMFLOAT3& p : positions)
+        {
+            p = XMFLOAT3(random.NextFloat(-40.0f, 60.0f), random.NextFloat(-9.0f, -1.0f), random.NextFloat(1.5f, 2.5f));
+        }
+        positions[0] = XMFLOAT3(-40.0f, -9.0f, 1.5f);     // corners of the bounds
+        positions[1] = XMFLOAT3(60.0f, -1.0f, 2.5f);
+
+        vector<QuantizedMeshVertex> vertices(positions.size());
+        VertexCompression::QuantizePositions(positions.data(), positions.size(), bounds, vertices[0].Position, sizeof(QuantizedMeshVertex));
+        const PositionDequantization d = VertexCompression::Dequantization(bounds);
+        const float step[3] = { 100.0f / 65535.0f, 8.0f / 65535.0f, 1.0f / 65535.0f };
+        bool within = true;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            const XMFLOAT3 p = VertexCompression::DequantizePosition(vertices[i].Position, d);
+            // Half a step, plus float rounding of the dequantization.
+            within = within && fabsf(p.x - positions[i].x) <= step[0] * 0.5f + 1e-5f
+                && fabsf(p.y - positions[i].y) <= step[1] * 0.5f + 1e-5f
+                && fabsf(p.z - positions[i].z) <= step[2] * 0.5f + 1e-5f;
+        }
+        CHECK(within);
+        CHECK(vertices[0].Position[0] == 0 && vertices[1].Position[0] == 0xffff && vertices[1].Position[3] == 0);
+    }
+
+    void TestColorAndHalf()
+    {
+        bool exact = true;
+        for (int i = 0; i < 256; ++i)
+        {
+            const float c = i / 255.0f;
+            const XMFLOAT4 decoded = VertexCompression::DecodeColor(VertexCompression::EncodeColor(XMFLOAT4(c, 1.0f - c, c, 0.5f)));
+            exact = exact && decoded.x == c && fabsf(decoded.y - (1.0f - c)) < 1e-6f && fabsf(decoded.w - 128.0f / 255.0f) < 1e-6f;
+        }
+        CHECK(exact);
+        CHECK(VertexCompression::EncodeColor(XMFLOAT4(-1.0f, 2.0f, 0.0f, 1.0f)) == 0xff00ff00);
+
+        // Every finite half survives half -> float -> half.
+        bool round_trip = true;
+        for (uint32_t bits = 0; bits < 0x10000; ++bits)
+        {
+            if ((bits & 0x7c00) == 0x7c00 && (bits & 0x3ff)) continue;   // NaN payloads
+            round_trip = round_trip && VertexCompression::FloatToHalf(VertexCompression::HalfToFloat(static_cast<uint16_t>(bits))) == bits;
+        }
+        CHECK(round_trip);
+        CHECK(VertexCompression::FloatToHalf(1.0f) == 0x3c00);
+        CHECK(VertexCompression::FloatToHalf(65520.0f) == 0x7c00);          // rounds to inf
+        CHECK(VertexCompression::FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3c00); // tie to even
+        CHECK(VertexCompression::FloatToHalf(1e-10f) == 0);
+    }
+
+    void TestCompressMesh()
+    {
+        // Two quads (float3 position, float3 normal, float2 texcoord) in
+        // separate submeshes sharing vertex 0.
+        const float source[5][8] =
+        {
+            { 0, 0, 0,  0, 0, 2,  0.0f, 0.0f },
+            { 1, 0, 0,  0, 0, 1,  1.0f, 0.0f },
+            { 1, 1, 0,  0, 0, 1,  1.0f, 1.0f },
+            { 0, 1, 0,  0, 0, 1,  0.0f, 1.0f },
+            { 0, 0, 9,  0, 1, 0,  0.5f, 0.25f },
+        };
+        MeshFileData data;
+        data.vertex_stride = sizeof(source[0]);
+        data.vertices.resize(sizeof(source));
+        memcpy(data.vertices.data(), source, sizeof(source));
+        data.indices = { 0, 1, 2, 0, 2, 3, 0, 1, 4 };
+        MeshFileData::Submesh a, b;
+        a.index_count = 6;
+        a.center[0] = a.center[1] = 0.5f;
+        a.extents[0] = a.extents[1] = 0.5f;
+        b.start_index = 6;
+        b.index_count = 3;
+        b.center[0] = b.extents[0] = 0.5f;
+        b.center[2] = b.extents[2] = 4.5f;
+        data.submeshes = { a, b };
+
+        CHECK(VertexCompression::CompressMesh(data));
+        CHECK(data.vertex_stride == sizeof(QuantizedMeshVertex));
+        CHECK(data.vertices.size() == 7 * sizeof(QuantizedMeshVertex));    // vertex 0 duplicated
+        CHECK(data.submeshes[1].base_vertex == 4);
+
+        const QuantizedMeshVertex* v = reinterpret_cast<const QuantizedMeshVertex*>(data.vertices.data());
+        const uint32_t last = data.submeshes[1].base_vertex + data.indices[data.submeshes[1].start_index + 2];
+        const XMFLOAT3 p = VertexCompression::DequantizePosition(v[last].Position, VertexCompression::Dequantization(
+            BoundingBox(XMFLOAT3(0.5f, 0.0f, 4.5f), XMFLOAT3(0.5f, 0.0f, 4.5f))));
+        CHECK(fabsf(p.z - 9.0f) < 1e-3f);
+        XMFLOAT3 n, t;
+        float s;
+        VertexCompression::DecodeTangentFrame(v[0].TangentFrame, n, t, s);
+        CHECK(AngleDegrees(n, XMFLOAT3(0.0f, 0.0f, 1.0f)) < 0.25f);     // normalized
+        CHECK(VertexCompression::HalfToFloat(v[last].Texcoord[1]) == 0.25f);
+
+        MeshFileData wrong;
+        wrong.vertex_stride = 16;
+        CHECK(!VertexCompression::CompressMesh(wrong));
+    }
+}
+
+int main()
+{
+    TestTangentFrame();
+    TestPositions();
+    TestColorAndHalf();
+    TestCompressMesh();
+    return test::Result();
+}
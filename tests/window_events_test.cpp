@@ -0,0 +1,192 @@
+//--------------------------------------------------------------------------------
+//  window_events_test.cpp
+//  Event order, mouse move collapsing and the backlog of WindowEventQueue;
+//  ResizeCoalescer across drags, bursts of sizes and minimize / restore.
+//--------------------------------------------------------------------------------
+#include "window_events.h"
+#include "test_util.h"
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    WindowEvent Event(WindowEventType type, uint32_t code = 0, int32_t x = 0, int32_t y = 0)
+    {
+        WindowEvent event;
+        event.type = type;
+        event.code = code;
+        event.x = x;
+        event.y = y;
+        return event;
+    }
+
+    vector<WindowEvent> DrainAll(WindowEventQueue& queue)
+    {
+        vector<WindowEvent> events;
+        queue.Drain([&events](const WindowEvent& event) { events.push_back(event); });
+        return events;
+    }
+
+    void TestOrder()
+    {
+        WindowEventQueue queue;
+        queue.Post(Event(WindowEventType::kMouseMove, 0, 1, 1));
+        queue.Post(Event(WindowEventType::kMouseMove, 0, 2, 2));
+        queue.Post(Event(WindowEventType::kMouseDown, 1, 3, 3));
+        queue.Post(Event(WindowEventType::kMouseMove, 1, 4, 4));
+        queue.Post(Event(WindowEventType::kKeyUp, 27));
+        queue.Post(Event(WindowEventType::kMouseMove, 0, 5, 5));
+        queue.Post(Event(WindowEventType::kMouseMove, 0, 6, 6));
+
+        // Runs of moves collapse into their last one, in place.
+        const vector<WindowEvent> events = DrainAll(queue);
+        CHECK(events.size() == 5);
+        if (events.size() != 5) return;
+        CHECK(events[0].type == WindowEventType::kMouseMove && events[0].x == 2);
+        CHECK(events[1].type == WindowEventType::kMouseDown && events[1].code == 1 && events[1].x == 3);
+        CHECK(events[2].type == WindowEventType::kMouseMove && events[2].x == 4);
+        CHECK(events[3].type == WindowEventType::kKeyUp && events[3].code == 27);
+        CHECK(events[4].type == WindowEventType::kMouseMove && events[4].x == 6);
+        CHECK(DrainAll(queue).empty());
+    }
+
+    void TestBacklog()
+    {
+        // Fill the queue: moves are dropped, everything else waits in order.
+        WindowEventQueue queue;
+        for (uint32_t i = 0; i < WindowEventQueue::kCapacity; ++i) queue.Post(Event(WindowEventType::kKeyUp, i));
+        CHECK(!queue.HasBacklog());
+        queue.Post(Event(WindowEventType::kMouseMove, 0, 9, 9));
+        CHECK(queue.DroppedMoves() == 1);
+        queue.Post(Event(WindowEventType::kSize, 0, 640, 480));
+        queue.Post(Event(WindowEventType::kKeyUp, 5000));
+        CHECK(queue.HasBacklog());
+
+        vector<WindowEvent> events = DrainAll(queue);
+        CHECK(events.size() == WindowEventQueue::kCapacity);
+        bool in_order = true;
+        for (uint32_t i = 0; i < events.size(); ++i) in_order = in_order && events[i].code == i;
+        CHECK(in_order);
+
+        // The backlog moves on with the next Post, still ahead of it.
+        queue.Post(Event(WindowEventType::kKeyUp, 6000));
+        CHECK(!queue.HasBacklog());
+        events = DrainAll(queue);
+        CHECK(events.size() == 3);
+        if (events.size() != 3) return;
+        CHECK(events[0].type == WindowEventType::kSize && events[0].x == 640);
+        CHECK(events[1].code == 5000 && events[2].code == 6000);
+    }
+
+    void TestPumpThread()
+    {
+        // A pump thread posting while the frame thread drains: nothing lost,
+        // nothing reordered.
+        constexpr uint32_t kCount = 200000;
+        WindowEventQueue queue;
+        thread pump([&queue]
+        {
+            for (uint32_t i = 0; i < kCount; ++i) queue.Post(Event(WindowEventType::kKeyUp, i));
+            while (queue.HasBacklog())
+            {
+                queue.FlushBacklog();
+                this_thread::yield();
+            }
+        });
+
+        uint32_t next = 0;
+        bool in_order = true;
+        while (next < kCount)
+        {
+            queue.Drain([&next, &in_order](const WindowEvent& event) { in_order = in_order && event.code == next++; });
+        }
+        pump.join();
+        CHECK(in_order && next == kCount);
+    }
+
+    void TestResizeDrag()
+    {
+        ResizeCoalescer coalescer(800, 600);
+        uint32_t width = 0, height = 0;
+        CHECK(!coalescer.Consume(width, height));
+
+        // Nothing while the borders are dragged, then the last size once.
+        coalescer.OnEnterSizeMove();
+        for (uint32_t i = 1; i <= 50; ++i)
+        {
+            coalescer.OnSize(800 + i, 600 + i, WindowSizeState::kRestored);
+            CHECK(!coalescer.Consume(width, height));
+        }
+        CHECK(coalescer.Dragging());
+        coalescer.OnExitSizeMove();
+        CHECK(coalescer.Consume(width, height) && width == 850 && height == 650);
+        CHECK(!coalescer.Consume(width, height));
+
+        // A drag that ends where it began resizes nothing.
+        coalescer.OnEnterSizeMove();
+        coalescer.OnSize(1000, 700, WindowSizeState::kRestored);
+        coalescer.OnSize(850, 650, WindowSizeState::kRestored);
+        coalescer.OnExitSizeMove();
+        CHECK(!coalescer.Consume(width, height));
+    }
+
+    void TestResizeBurst()
+    {
+        // Several sizes in one frame (maximize, snap): only the last one.
+        ResizeCoalescer coalescer(800, 600);
+        uint32_t width = 0, height = 0;
+        coalescer.OnSize(1024, 768, WindowSizeState::kRestored);
+        coalescer.OnSize(1920, 1080, WindowSizeState::kMaximized);
+        CHECK(coalescer.Width() == 1920 && coalescer.Height() == 1080);
+        CHECK(coalescer.Consume(width, height) && width == 1920 && height == 1080);
+        CHECK(!coalescer.Consume(width, height));
+
+        // A zero sized client area is never applied.
+        coalescer.OnSize(0, 1080, WindowSizeState::kRestored);
+        CHECK(!coalescer.Consume(width, height));
+        coalescer.OnSize(1280, 720, WindowSizeState::kRestored);
+        CHECK(coalescer.Consume(width, height) && width == 1280 && height == 720);
+    }
+
+    void TestMinimize()
+    {
+        ResizeCoalescer coalescer(800, 600);
+        uint32_t width = 0, height = 0;
+
+        // Minimized reports 0 x 0: ignored, the size before it survives.
+        coalescer.OnSize(0, 0, WindowSizeState::kMinimized);
+        CHECK(coalescer.Minimized());
+        CHECK(coalescer.Width() == 800 && coalescer.Height() == 600);
+        CHECK(!coalescer.Consume(width, height));
+
+        // Restored at the same size: nothing to do.
+        coalescer.OnSize(800, 600, WindowSizeState::kRestored);
+        CHECK(!coalescer.Minimized());
+        CHECK(!coalescer.Consume(width, height));
+
+        // A size posted before minimizing is applied on restore, unless the
+        // restore brings its own.
+        coalescer.OnSize(1024, 768, WindowSizeState::kRestored);
+        coalescer.OnSize(0, 0, WindowSizeState::kMinimized);
+        CHECK(!coalescer.Consume(width, height));
+        coalescer.OnSize(1024, 768, WindowSizeState::kRestored);
+        CHECK(coalescer.Consume(width, height) && width == 1024 && height == 768);
+
+        coalescer.OnSize(0, 0, WindowSizeState::kMinimized);
+        coalescer.OnSize(1600, 900, WindowSizeState::kMaximized);
+        CHECK(coalescer.Consume(width, height) && width == 1600 && height == 900);
+    }
+}
+
+int main()
+{
+    TestOrder();
+    TestBacklog();
+    TestPumpThread();
+    TestResizeDrag();
+    TestResizeBurst();
+    TestMinimize();
+    return test::Result();
+}
@@ -0,0 +1,230 @@
+//--------------------------------------------------------------------------------
+//  mesh_converter.cpp
+//  Converts a Wavefront OBJ file into the .kmesh format (mesh_file.h).
+//  Every o/g group becomes a submesh.  Vertex layout:
+//    float3 position, float3 normal, float2 texcoord (32 bytes)
+//
+//  -optimize runs MeshOptimizer (vertex cache, overdraw, vertex fetch) and
+//  prints the simulated ACMR before and after.
+//  -quantize stores QuantizedMeshVertex (vertex_compression.h, 16 bytes).
+//  -lod generates an LOD chain per submesh (mesh_simplifier.h).
+//
+//  Build : cl /std:c++14 /O2 /EHsc tools\mesh_converter.cpp mesh_file.cpp mesh_optimizer.cpp mesh_simplifier.cpp vertex_compression.cpp
+//          g++ -std=c++14 -O2 -I<DirectXMath>/Inc tools/mesh_converter.cpp mesh_file.cpp mesh_optimizer.cpp mesh_simplifier.cpp vertex_compression.cpp
+//  Usage : mesh_converter [-lod] [-optimize] [-quantize] input.obj output.kmesh
+//--------------------------------------------------------------------------------
+#define _CRT_SECURE_NO_WARNINGS
+#include "../mesh_file.h"
+#include "../mesh_optimizer.h"
+#include "../mesh_simplifier.h"
+#include "../vertex_compression.h"
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+    struct Vertex
+    {
+        float position[3];
+        float normal[3];
+        float texcoord[2];
+    };
+
+    // OBJ indices are 1 based and may be negative (relative to the end).
+    int ResolveIndex(int index, size_t count)
+    {
+        if (index > 0) return index - 1;
+        if (index < 0) return static_cast<int>(count) + index;
+        return -1;
+    }
+
+    struct Group
+    {
+        string name;
+        vector<uint32_t> indices;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    bool lod = false;
+    bool optimize = false;
+    bool quantize = false;
+    bool valid = argc >= 3;
+    for (int i = 1; i < argc - 2; ++i)
+    {
+        if (strcmp(argv[i], "-lod") == 0) lod = true;
+        else if (strcmp(argv[i], "-optimize") == 0) optimize = true;
+        else if (strcmp(argv[i], "-quantize") == 0) quantize = true;
+        else valid = false;
+    }
+    if (!valid)
+    {
+        printf("usage : mesh_converter [-lod] [-optimize] [-quantize] input.obj output.kmesh\n");
+        return 1;
+    }
+    const char* input_path = argv[argc - 2];
+    const char* output_path = argv[argc - 1];
+
+    ifstream fin(input_path);
+    if (!fin)
+    {
+        printf("failed to open %s\n", input_path);
+        return 1;
+    }
+
+    vector<float> positions, normals, texcoords;
+    vector<Vertex> vertices;
+    unordered_map<string, uint32_t> vertex_lookup;
+    vector<Group> groups(1);
+    groups[0].name = "default";
+
+    string line;
+    while (getline(fin, line))
+    {
+        istringstream stream(line);
+        string tag;
+        stream >> tag;
+        if (tag == "v")
+        {
+            float x = 0, y = 0, z = 0;
+            stream >> x >> y >> z;
+            positions.insert(positions.end(), { x, y, z });
+        }
+        else if (tag == "vn")
+        {
+            float x = 0, y = 0, z = 0;
+            stream >> x >> y >> z;
+            normals.insert(normals.end(), { x, y, z });
+        }
+        else if (tag == "vt")
+        {
+            float u = 0, v = 0;
+            stream >> u >> v;
+            texcoords.insert(texcoords.end(), { u, 1.0f - v });
+        }
+        else if (tag == "o" || tag == "g")
+        {
+            string name;
+            stream >> name;
+            if (!groups.back().indices.empty()) groups.emplace_back();
+            groups.back().name = name;
+        }
+        else if (tag == "f")
+        {
+            // Fan triangulate polygons.
+            vector<uint32_t> polygon;
+            string corner;
+            while (stream >> corner)
+            {
+                auto found = vertex_lookup.find(corner);
+                if (found != vertex_lookup.end())
+                {
+                    polygon.push_back(found->second);
+                    continue;
+                }
+
+                int p = 0, t = 0, n = 0;
+                if (sscanf(corner.c_str(), "%d/%d/%d", &p, &t, &n) != 3
+                    && sscanf(corner.c_str(), "%d//%d", &p, &n) != 2
+                    && sscanf(corner.c_str(), "%d/%d", &p, &t) != 2)
+                {
+                    sscanf(corner.c_str(), "%d", &p);
+                }
+                p = ResolveIndex(p, positions.size() / 3);
+                t = ResolveIndex(t, texcoords.size() / 2);
+                n = ResolveIndex(n, normals.size() / 3);
+                if (p < 0 || static_cast<size_t>(p) * 3 >= positions.size())
+                {
+                    printf("invalid face in %s\n", input_path);
+                    return 1;
+                }
+
+                Vertex vertex = {};
+                memcpy(vertex.position, &positions[p * 3], sizeof(vertex.position));
+                if (n >= 0 && static_cast<size_t>(n) * 3 < normals.size()) memcpy(vertex.normal, &normals[n * 3], sizeof(vertex.normal));
+                if (t >= 0 && static_cast<size_t>(t) * 2 < texcoords.size()) memcpy(vertex.texcoord, &texcoords[t * 2], sizeof(vertex.texcoord));
+
+                const uint32_t index = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+                vertex_lookup.emplace(corner, index);
+                polygon.push_back(index);
+            }
+            for (size_t i = 2; i < polygon.size(); ++i)
+            {
+                groups.back().indices.insert(groups.back().indices.end(), { polygon[0], polygon[i - 1], polygon[i] });
+            }
+        }
+    }
+
+    MeshFileData data;
+    data.vertex_stride = sizeof(Vertex);
+    data.vertices.resize(vertices.size() * sizeof(Vertex));
+    if (!vertices.empty()) memcpy(data.vertices.data(), vertices.data(), data.vertices.size());
+
+    for (const Group& group : groups)
+    {
+        if (group.indices.empty()) continue;
+
+        MeshFileData::Submesh submesh;
+        submesh.name = group.name;
+        submesh.index_count = static_cast<uint32_t>(group.indices.size());
+        submesh.start_index = static_cast<uint32_t>(data.indices.size());
+        submesh.base_vertex = 0;
+
+        float bounds_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float bounds_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t index : group.indices)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float value = vertices[index].position[axis];
+                bounds_min[axis] = value < bounds_min[axis] ? value : bounds_min[axis];
+                bounds_max[axis] = value > bounds_max[axis] ? value : bounds_max[axis];
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            submesh.center[axis] = (bounds_min[axis] + bounds_max[axis]) * 0.5f;
+            submesh.extents[axis] = (bounds_max[axis] - bounds_min[axis]) * 0.5f;
+        }
+
+        data.indices.insert(data.indices.end(), group.indices.begin(), group.indices.end());
+        data.submeshes.push_back(submesh);
+    }
+
+    if (lod)
+    {
+        printf("%u lods generated\n", MeshSimplifier::GenerateLods(data));
+    }
+
+    if (optimize)
+    {
+        MeshOptimizer::Report report = MeshOptimizer::Optimize(data);
+        printf("ACMR %.3f -> %.3f, %u -> %u vertices, %u bit indices\n",
+            report.acmr_before, report.acmr_after,
+            report.vertex_count_before, report.vertex_count_after, report.index_size * 8);
+    }
+
+    if (quantize && !VertexCompression::CompressMesh(data))
+    {
+        printf("failed to quantize %s\n", input_path);
+        return 1;
+    }
+
+    if (!MeshFileWriter::Write(output_path, data))
+    {
+        printf("failed to write %s\n", output_path);
+        return 1;
+    }
+
+    printf("%s : %zu vertices, %zu indices, %zu submeshes\n",
+        output_path, data.vertices.size() / data.vertex_stride, data.indices.size(), data.submeshes.size());
+    return 0;
+}
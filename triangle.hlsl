@@ -29,3 +29,79 @@ float4 PSMain(PSInput input) : SV_TARGET
 {
     return input.color;
 }
+
+
+//---------------------------------------------------------
+// Quantized vertices (vertex_compression.h)
+//---------------------------------------------------------
+cbuffer cbQuantization : register(b0)
+{
+    float4 gPositionOffset;
+    float4 gPositionScale;
+};
+
+float3 DecodePosition(float4 quantized)
+{
+    return gPositionOffset.xyz + quantized.xyz * gPositionScale.xyz;
+}
+
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f)
+    {
+        n.xy = (1.0f - abs(n.yx)) * (n.xy >= 0.0f ? 1.0f : -1.0f);
+    }
+    return normalize(n);
+}
+
+// R10G10B10A2_UNORM tangent frame: xy = octahedral normal, z = tangent angle, w = bitangent sign
+void DecodeTangentFrame(float4 packed, out float3 normal, out float3 tangent, out float bitangent_sign)
+{
+    normal = OctDecode(packed.xy * 2.0f - 1.0f);
+
+    float sign = normal.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (sign + normal.z);
+    float b = normal.x * normal.y * a;
+    float3 b1 = float3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    float3 b2 = float3(b, sign + normal.y * normal.y * a, -normal.y);
+
+    float s, c;
+    sincos((packed.z - 0.5f) * 6.283185307f, s, c);
+    tangent = b1 * c + b2 * s;
+    bitangent_sign = packed.w > 0.5f ? 1.0f : -1.0f;
+}
+
+PSInput VSMainQuantized(float4 position : POSITION, float4 color : COLOR)
+{
+    PSInput result;
+
+    result.position = float4(DecodePosition(position), 1.0f);
+    result.color = color;
+
+    return result;
+}
+
+
+//---------------------------------------------------------
+// Bindless resources (bindless_descriptor_heap.h)
+//---------------------------------------------------------
+cbuffer cbBindlessDraw : register(b1)
+{
+    uint gTextureIndex;     // BindlessHandle::Index, one root constant per draw
+};
+
+Texture2D gBindlessTextures[] : register(t0, space1);
+SamplerState gLinearWrap : register(s0);
+
+struct PSInputTextured
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD;
+};
+
+float4 PSMainBindless(PSInputTextured input) : SV_TARGET
+{
+    // The index is the same for the whole draw, NonUniformResourceIndex is not needed.
+    return gBindlessTextures[gTextureIndex].Sample(gLinearWrap, input.uv);
+}
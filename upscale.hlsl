@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------
+//  upscale.hlsl
+//  Stretches the dynamic resolution scene target over the back buffer with
+//  one full screen triangle (upscale_pass.h).
+//--------------------------------------------------------------------------------
+
+cbuffer cbBindlessDraw : register(b0)
+{
+    uint gSourceIndex;      // BindlessHandle::Index of the scene target
+};
+
+cbuffer cbUpscale : register(b1)
+{
+    float2 gUvScale;        // render size / allocated size of the pooled target
+    float2 gUvMax;          // last texel center inside the render size
+};
+
+Texture2D gBindlessTextures[] : register(t0, space1);
+SamplerState gLinearClamp : register(s0);
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD;
+};
+
+PSInput VSFullscreen(uint vertex_id : SV_VertexID)
+{
+    // (0,0) (2,0) (0,2) in uv covers the whole screen.
+    PSInput result;
+    float2 uv = float2((vertex_id << 1) & 2, vertex_id & 2);
+    result.position = float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+    result.uv = uv;
+    return result;
+}
+
+float4 PSUpscale(PSInput input) : SV_TARGET
+{
+    // The pooled target is larger than what was rendered; keep the bilinear
+    // footprint inside the rendered area.
+    float2 uv = min(input.uv * gUvScale, gUvMax);
+    return gBindlessTextures[gSourceIndex].SampleLevel(gLinearClamp, uv, 0.0f);
+}
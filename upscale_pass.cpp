@@ -0,0 +1,78 @@
+//--------------------------------------------------------------------------------
+//  upscale_pass.cpp
+//--------------------------------------------------------------------------------
+#include "upscale_pass.h"
+#include "bindless_descriptor_heap.h"
+#include "render_target_pool.h"
+#include "root_signature_cache.h"
+#include "root_signature_layout.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+void UpscalePass::Initialize(ID3D12Device* device, DXGI_FORMAT output_format)
+{
+    RootStaticSampler linear_clamp;
+    linear_clamp.filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+    linear_clamp.address_u = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    linear_clamp.address_v = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    linear_clamp.address_w = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    linear_clamp.max_anisotropy = 1;
+    linear_clamp.visibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+    RootSignatureLayout layout;
+    bindless_parameter_ = AddBindlessParameters(layout, 0);
+    upscale_parameter_ = static_cast<UINT>(layout.Parameters().size());
+    layout.AddConstants(kUpscaleConstantCount, 1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+    layout.AddStaticSampler(linear_clamp);
+    root_signature_ = RootSignatureCache::Instance().Get(layout);
+
+    ComPtr<ID3DBlob> vertex_shader = d3dUtil::CompileShader(L"upscale.hlsl", nullptr, "VSFullscreen", "vs_5_1");
+    ComPtr<ID3DBlob> pixel_shader = d3dUtil::CompileShader(L"upscale.hlsl", nullptr, "PSUpscale", "ps_5_1");
+
+    // No vertex buffer, no depth; every pixel of the output is written.
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+    desc.pRootSignature = root_signature_.Get();
+    desc.VS = { vertex_shader->GetBufferPointer(), vertex_shader->GetBufferSize() };
+    desc.PS = { pixel_shader->GetBufferPointer(), pixel_shader->GetBufferSize() };
+    desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    desc.SampleMask = UINT_MAX;
+    desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+    desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+    desc.DepthStencilState.DepthEnable = false;
+    desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    desc.NumRenderTargets = 1;
+    desc.RTVFormats[0] = output_format;
+    desc.DSVFormat = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    ThrowIfFailed(device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(pso_.GetAddressOf())));
+}
+
+void UpscalePass::Draw(ID3D12GraphicsCommandList* command_list, BindlessHandle source,
+    const RenderTargetDesc& source_desc, UINT width, UINT height)
+{
+    const float inverse_width = 1.0f / source_desc.width;
+    const float inverse_height = 1.0f / source_desc.height;
+    const float constants[kUpscaleConstantCount] =
+    {
+        width * inverse_width,
+        height * inverse_height,
+        (width - 0.5f) * inverse_width,
+        (height - 0.5f) * inverse_height,
+    };
+
+    command_list->SetGraphicsRootSignature(root_signature_.Get());
+    command_list->SetGraphicsRoot32BitConstant(bindless_parameter_, source.Index(), 0);
+    command_list->SetGraphicsRootDescriptorTable(bindless_parameter_ + 1, BindlessDescriptorHeap::Instance().TableStart());
+    command_list->SetGraphicsRoot32BitConstants(upscale_parameter_, kUpscaleConstantCount, constants, 0);
+    command_list->SetPipelineState(pso_.Get());
+    command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    command_list->DrawInstanced(3, 1, 0, 0);
+}
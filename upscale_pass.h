@@ -0,0 +1,41 @@
+//--------------------------------------------------------------------------------
+//  upscale_pass.h
+//  Bilinear stretch of a pooled scene target rendered below the output size
+//  (dynamic resolution) over the bound render target, see upscale.hlsl.
+//  The source is read through the bindless heap.
+//--------------------------------------------------------------------------------
+#pragma once
+#include "d3dUtil.h"
+#include "bindless_handle_table.h"
+
+struct RenderTargetDesc;
+
+class UpscalePass
+{
+public:
+    UpscalePass() = default;
+    ~UpscalePass() = default;
+
+    void Initialize(ID3D12Device* device, DXGI_FORMAT output_format);
+
+    //--------------------------------------------------------------------------------
+    //  Record the full screen draw.  The caller binds the output, its viewport
+    //  and the bindless heap.
+    //  source      : SRV of the scene target, in PIXEL_SHADER_RESOURCE state
+    //  source_desc : its allocated size (PooledRenderTarget::desc)
+    //  width/height: size rendered into it
+    //--------------------------------------------------------------------------------
+    void Draw(ID3D12GraphicsCommandList* command_list, BindlessHandle source,
+        const RenderTargetDesc& source_desc, UINT width, UINT height);
+
+private:
+    UpscalePass(const UpscalePass& rhs) = delete;
+    UpscalePass& operator=(const UpscalePass& rhs) = delete;
+
+    static constexpr UINT kUpscaleConstantCount = 4;
+
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> root_signature_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pso_;
+    UINT bindless_parameter_ = 0;
+    UINT upscale_parameter_ = 0;
+};
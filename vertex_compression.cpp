@@ -0,0 +1,355 @@
+//--------------------------------------------------------------------------------
+//  vertex_compression.cpp
+//--------------------------------------------------------------------------------
+#include "vertex_compression.h"
+#include "mesh_file.h"
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    uint32_t ToUnorm(float value, uint32_t max_value)
+    {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return static_cast<uint32_t>(value * static_cast<float>(max_value) + 0.5f);
+    }
+
+    float FromUnorm(uint32_t value, uint32_t max_value)
+    {
+        return static_cast<float>(value) / static_cast<float>(max_value);
+    }
+
+    float SignNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Octahedral mapping of a unit vector to [-1, 1]^2.
+    void OctEncode(const XMFLOAT3& n, float& u, float& v)
+    {
+        const float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+        float x = n.x / l1;
+        float y = n.y / l1;
+        if (n.z < 0.0f)
+        {
+            const float fx = (1.0f - fabsf(y)) * SignNotZero(x);
+            const float fy = (1.0f - fabsf(x)) * SignNotZero(y);
+            x = fx;
+            y = fy;
+        }
+        u = x;
+        v = y;
+    }
+
+    XMFLOAT3 OctDecode(float u, float v)
+    {
+        XMFLOAT3 n(u, v, 1.0f - fabsf(u) - fabsf(v));
+        if (n.z < 0.0f)
+        {
+            const float x = (1.0f - fabsf(n.y)) * SignNotZero(n.x);
+            const float y = (1.0f - fabsf(n.x)) * SignNotZero(n.y);
+            n.x = x;
+            n.y = y;
+        }
+        const float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+        return XMFLOAT3(n.x / length, n.y / length, n.z / length);
+    }
+
+    // Orthonormal basis around n (Duff et al. 2017).  Must match triangle.hlsl.
+    void Basis(const XMFLOAT3& n, XMFLOAT3& b1, XMFLOAT3& b2)
+    {
+        const float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+        const float a = -1.0f / (sign + n.z);
+        const float b = n.x * n.y * a;
+        b1 = XMFLOAT3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+        b2 = XMFLOAT3(b, sign + n.y * n.y * a, -n.y);
+    }
+
+    const uint32_t kInvalid = 0xffffffff;
+    const uint32_t kSourceStride = 32;  // float3 position, float3 normal, float2 texcoord
+
+    // position -> unorm16 relative to the bounds
+    struct PositionQuantizer
+    {
+        float offset[3];
+        float inverse_scale[3];
+
+        explicit PositionQuantizer(const BoundingBox& bounds)
+        {
+            const PositionDequantization d = VertexCompression::Dequantization(bounds);
+            const float scale[3] = { d.Scale.x, d.Scale.y, d.Scale.z };
+            offset[0] = d.Offset.x;
+            offset[1] = d.Offset.y;
+            offset[2] = d.Offset.z;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                inverse_scale[axis] = scale[axis] > 0.0f ? 1.0f / scale[axis] : 0.0f;
+            }
+        }
+
+        void Quantize(float x, float y, float z, uint16_t* out) const
+        {
+            out[0] = static_cast<uint16_t>(ToUnorm((x - offset[0]) * inverse_scale[0], 0xffff));
+            out[1] = static_cast<uint16_t>(ToUnorm((y - offset[1]) * inverse_scale[1], 0xffff));
+            out[2] = static_cast<uint16_t>(ToUnorm((z - offset[2]) * inverse_scale[2], 0xffff));
+            out[3] = 0;
+        }
+    };
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Public
+//
+//--------------------------------------------------------------------------------
+PositionDequantization VertexCompression::Dequantization(const BoundingBox& bounds)
+{
+    PositionDequantization result;
+    result.Offset = XMFLOAT4(
+        bounds.Center.x - bounds.Extents.x,
+        bounds.Center.y - bounds.Extents.y,
+        bounds.Center.z - bounds.Extents.z,
+        1.0f);
+    result.Scale = XMFLOAT4(bounds.Extents.x * 2.0f, bounds.Extents.y * 2.0f, bounds.Extents.z * 2.0f, 0.0f);
+    return result;
+}
+
+void VertexCompression::QuantizePositions(const XMFLOAT3* positions, size_t count,
+    const BoundingBox& bounds, uint16_t* destination, size_t destination_stride)
+{
+    const PositionQuantizer quantizer(bounds);
+    uint8_t* out = reinterpret_cast<uint8_t*>(destination);
+    for (size_t i = 0; i < count; ++i, out += destination_stride)
+    {
+        quantizer.Quantize(positions[i].x, positions[i].y, positions[i].z, reinterpret_cast<uint16_t*>(out));
+    }
+}
+
+XMFLOAT3 VertexCompression::DequantizePosition(const uint16_t quantized[3], const PositionDequantization& d)
+{
+    return XMFLOAT3(
+        d.Offset.x + FromUnorm(quantized[0], 0xffff) * d.Scale.x,
+        d.Offset.y + FromUnorm(quantized[1], 0xffff) * d.Scale.y,
+        d.Offset.z + FromUnorm(quantized[2], 0xffff) * d.Scale.z);
+}
+
+uint32_t VertexCompression::EncodeTangentFrame(const XMFLOAT3& normal, const XMFLOAT3* tangent, float bitangent_sign)
+{
+    float u, v;
+    OctEncode(normal, u, v);
+    const uint32_t x = ToUnorm(u * 0.5f + 0.5f, 1023);
+    const uint32_t y = ToUnorm(v * 0.5f + 0.5f, 1023);
+
+    // The angle is measured in the basis of the decoded normal, like the shader does.
+    uint32_t z = 0;
+    if (tangent)
+    {
+        XMFLOAT3 decoded = OctDecode(FromUnorm(x, 1023) * 2.0f - 1.0f, FromUnorm(y, 1023) * 2.0f - 1.0f);
+        XMFLOAT3 b1, b2;
+        Basis(decoded, b1, b2);
+        const float angle = atan2f(Dot(*tangent, b2), Dot(*tangent, b1)); // [-pi, pi]
+        z = ToUnorm(angle / XM_2PI + 0.5f, 1023);
+    }
+
+    // 2 bit UNORM: 0 reads as 0.0 (-1), 3 as 1.0 (+1).
+    const uint32_t w = bitangent_sign < 0.0f ? 0 : 3;
+    return x | (y << 10) | (z << 20) | (w << 30);
+}
+
+void VertexCompression::DecodeTangentFrame(uint32_t packed, XMFLOAT3& normal, XMFLOAT3& tangent, float& bitangent_sign)
+{
+    const float u = FromUnorm(packed & 1023, 1023) * 2.0f - 1.0f;
+    const float v = FromUnorm((packed >> 10) & 1023, 1023) * 2.0f - 1.0f;
+    const float angle = (FromUnorm((packed >> 20) & 1023, 1023) - 0.5f) * XM_2PI;
+    normal = OctDecode(u, v);
+
+    XMFLOAT3 b1, b2;
+    Basis(normal, b1, b2);
+    const float c = cosf(angle), s = sinf(angle);
+    tangent = XMFLOAT3(b1.x * c + b2.x * s, b1.y * c + b2.y * s, b1.z * c + b2.z * s);
+    bitangent_sign = FromUnorm(packed >> 30, 3) > 0.5f ? 1.0f : -1.0f;  // as triangle.hlsl
+}
+
+uint32_t VertexCompression::EncodeColor(const XMFLOAT4& color)
+{
+    return ToUnorm(color.x, 255)
+        | (ToUnorm(color.y, 255) << 8)
+        | (ToUnorm(color.z, 255) << 16)
+        | (ToUnorm(color.w, 255) << 24);
+}
+
+XMFLOAT4 VertexCompression::DecodeColor(uint32_t packed)
+{
+    return XMFLOAT4(
+        FromUnorm(packed & 255, 255),
+        FromUnorm((packed >> 8) & 255, 255),
+        FromUnorm((packed >> 16) & 255, 255),
+        FromUnorm(packed >> 24, 255));
+}
+
+void VertexCompression::CompressColorVertices(const XMFLOAT4* positions, const XMFLOAT4* colors,
+    size_t count, const BoundingBox& bounds, QuantizedColorVertex* destination)
+{
+    const PositionQuantizer quantizer(bounds);
+    for (size_t i = 0; i < count; ++i)
+    {
+        quantizer.Quantize(positions[i].x, positions[i].y, positions[i].z, destination[i].Position);
+        destination[i].Color = EncodeColor(colors[i]);
+    }
+}
+
+bool VertexCompression::CompressMesh(MeshFileData& data)
+{
+    if (data.vertex_stride != kSourceStride) return false;
+    const size_t vertex_count = data.vertices.size() / kSourceStride;
+
+    std::vector<uint8_t> new_vertices;
+    std::vector<uint32_t> new_indices;
+    new_vertices.reserve(vertex_count * sizeof(QuantizedMeshVertex));
+    new_indices.reserve(data.indices.size());
+
+    // Absolute vertex -> submesh local id, reset after each submesh.
+    std::vector<uint32_t> local_id(vertex_count, kInvalid);
+    std::vector<uint32_t> used;
+
+    for (auto& submesh : data.submeshes)
+    {
+        const PositionQuantizer quantizer(BoundingBox(
+            XMFLOAT3(submesh.center[0], submesh.center[1], submesh.center[2]),
+            XMFLOAT3(submesh.extents[0], submesh.extents[1], submesh.extents[2])));
+        const uint32_t base = static_cast<uint32_t>(new_vertices.size() / sizeof(QuantizedMeshVertex));
+
+        // Base LOD first, then the LOD ranges, all drawn with this submesh's base vertex.
+        const size_t range_count = 1 + submesh.lods.size();
+        for (size_t r = 0; r < range_count; ++r)
+        {
+            const uint32_t start = r == 0 ? submesh.start_index : submesh.lods[r - 1].start_index;
+            const uint32_t count = r == 0 ? submesh.index_count : submesh.lods[r - 1].index_count;
+            const uint32_t new_start = static_cast<uint32_t>(new_indices.size());
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint32_t vertex = data.indices[start + i] + submesh.base_vertex;
+                if (vertex >= vertex_count) return false;
+                if (local_id[vertex] == kInvalid)
+                {
+                    local_id[vertex] = static_cast<uint32_t>(used.size());
+                    used.push_back(vertex);
+                }
+                new_indices.push_back(local_id[vertex]);
+            }
+
+            if (r == 0) submesh.start_index = new_start;
+            else submesh.lods[r - 1].start_index = new_start;
+        }
+
+        new_vertices.resize(new_vertices.size() + used.size() * sizeof(QuantizedMeshVertex));
+        QuantizedMeshVertex* destination = reinterpret_cast<QuantizedMeshVertex*>(new_vertices.data()) + base;
+        for (size_t i = 0; i < used.size(); ++i)
+        {
+            float source[8];
+            memcpy(source, &data.vertices[static_cast<size_t>(used[i]) * kSourceStride], sizeof(source));
+
+            XMFLOAT3 normal(source[3], source[4], source[5]);
+            const float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+            if (length > 0.0f) normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+            else normal = XMFLOAT3(0.0f, 0.0f, 1.0f);
+
+            quantizer.Quantize(source[0], source[1], source[2], destination[i].Position);
+            destination[i].TangentFrame = EncodeTangentFrame(normal, nullptr, 1.0f);
+            destination[i].Texcoord[0] = FloatToHalf(source[6]);
+            destination[i].Texcoord[1] = FloatToHalf(source[7]);
+        }
+
+        for (uint32_t vertex : used) local_id[vertex] = kInvalid;
+        used.clear();
+        submesh.base_vertex = static_cast<int32_t>(base);
+    }
+
+    data.vertices.swap(new_vertices);
+    data.indices.swap(new_indices);
+    data.vertex_stride = sizeof(QuantizedMeshVertex);
+    return true;
+}
+
+uint16_t VertexCompression::FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+    {
+        // Inf / NaN
+        return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 31)
+    {
+        return static_cast<uint16_t>(sign | 0x7c00);
+    }
+    if (exponent <= 0)
+    {
+        // Denormal or zero, round to nearest even.
+        if (exponent < -10) return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000;
+        const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) ++half;  // may carry into inf
+    return static_cast<uint16_t>(sign | half);
+}
+
+float VertexCompression::HalfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+
+    if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Normalize the denormal.
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
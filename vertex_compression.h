@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------
+//  vertex_compression.h
+//  Vertex attribute quantization.  The matching decode is in triangle.hlsl.
+//  - position : R16G16B16A16_UNORM relative to the submesh bounds
+//  - tangent frame (normal + tangent + bitangent sign) : R10G10B10A2_UNORM
+//      xy = octahedral normal, z = tangent angle around the normal,
+//      w = bitangent sign (0.0 = -1, 1.0 = +1)
+//  - color : R8G8B8A8_UNORM
+//
+//  QuantizedColorVertex input layout (VertexByteStride = 12)
+//    { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, ... }
+//    { "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, 8, ... }
+//  QuantizedMeshVertex input layout (VertexByteStride = 16)
+//    { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0,  ... }
+//    { "NORMAL",   0, DXGI_FORMAT_R10G10B10A2_UNORM,  0, 8,  ... }
+//    { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, 12, ... }
+//--------------------------------------------------------------------------------
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <cstddef>
+
+struct MeshFileData;
+
+struct QuantizedColorVertex
+{
+    uint16_t Position[4];   // w is unused (0)
+    uint32_t Color;
+};
+static_assert(sizeof(QuantizedColorVertex) == 12, "QuantizedColorVertex must match the triangle.hlsl input layout");
+
+struct QuantizedMeshVertex
+{
+    uint16_t Position[4];   // w is unused (0)
+    uint32_t TangentFrame;
+    uint16_t Texcoord[2];   // half
+};
+static_assert(sizeof(QuantizedMeshVertex) == 16, "QuantizedMeshVertex must be 16 bytes");
+
+//--------------------------------------------------------------------------------
+//  position = offset + unorm * scale, per submesh (cbQuantization in triangle.hlsl)
+//--------------------------------------------------------------------------------
+struct PositionDequantization
+{
+    DirectX::XMFLOAT4 Offset;
+    DirectX::XMFLOAT4 Scale;
+};
+
+class VertexCompression
+{
+public:
+    //--------------------------------------------------------------------------------
+    //  Position
+    //--------------------------------------------------------------------------------
+    static PositionDequantization Dequantization(const DirectX::BoundingBox& bounds);
+    static void QuantizePositions(const DirectX::XMFLOAT3* positions, size_t count,
+        const DirectX::BoundingBox& bounds, uint16_t* destination, size_t destination_stride);
+    static DirectX::XMFLOAT3 DequantizePosition(const uint16_t quantized[3], const PositionDequantization& dequantization);
+
+    //--------------------------------------------------------------------------------
+    //  Tangent frame.  tangent may be null (normal only, angle 0).
+    //  bitangent_sign is the sign of dot(cross(normal, tangent), bitangent).
+    //--------------------------------------------------------------------------------
+    static uint32_t EncodeTangentFrame(const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT3* tangent, float bitangent_sign);
+    static void     DecodeTangentFrame(uint32_t packed, DirectX::XMFLOAT3& normal, DirectX::XMFLOAT3& tangent, float& bitangent_sign);
+
+    //--------------------------------------------------------------------------------
+    //  Color (rgba in [0, 1])
+    //--------------------------------------------------------------------------------
+    static uint32_t EncodeColor(const DirectX::XMFLOAT4& color);
+    static DirectX::XMFLOAT4 DecodeColor(uint32_t packed);
+
+    //--------------------------------------------------------------------------------
+    //  float4 position + float4 color (32 bytes) -> QuantizedColorVertex (12 bytes)
+    //--------------------------------------------------------------------------------
+    static void CompressColorVertices(const DirectX::XMFLOAT4* positions, const DirectX::XMFLOAT4* colors,
+        size_t count, const DirectX::BoundingBox& bounds, QuantizedColorVertex* destination);
+
+    //--------------------------------------------------------------------------------
+    //  Converts a mesh_converter mesh (float3 position, float3 normal, float2 texcoord)
+    //  into QuantizedMeshVertex and updates vertex_stride.  Vertices shared between
+    //  submeshes are duplicated so every submesh owns a range quantized to its bounds.
+    //  Returns false when the vertex layout does not match.
+    //--------------------------------------------------------------------------------
+    static bool CompressMesh(MeshFileData& data);
+
+    static uint16_t FloatToHalf(float value);
+    static float    HalfToFloat(uint16_t value);
+};
@@ -0,0 +1,54 @@
+//--------------------------------------------------------------------------------
+//  window_events.cpp
+//--------------------------------------------------------------------------------
+#include "window_events.h"
+
+//--------------------------------------------------------------------------------
+//
+//  WindowEventQueue
+//
+//--------------------------------------------------------------------------------
+void WindowEventQueue::Post(const WindowEvent& event)
+{
+    // Keep the order: nothing overtakes the backlog.
+    FlushBacklog();
+    if (backlog_.empty() && events_.TryPush(event)) return;
+
+    if (event.type == WindowEventType::kMouseMove)
+    {
+        ++dropped_moves_;
+        return;
+    }
+    backlog_.push_back(event);
+}
+
+void WindowEventQueue::FlushBacklog()
+{
+    while (!backlog_.empty() && events_.TryPush(backlog_.front())) backlog_.pop_front();
+}
+
+//--------------------------------------------------------------------------------
+//
+//  ResizeCoalescer
+//
+//--------------------------------------------------------------------------------
+void ResizeCoalescer::OnSize(uint32_t width, uint32_t height, WindowSizeState state)
+{
+    minimized_ = state == WindowSizeState::kMinimized;
+    if (minimized_) return;     // reported as 0 x 0
+    width_ = width;
+    height_ = height;
+}
+
+bool ResizeCoalescer::Consume(uint32_t& width, uint32_t& height)
+{
+    if (minimized_ || dragging_) return false;
+    if (width_ == 0 || height_ == 0) return false;
+    if (width_ == applied_width_ && height_ == applied_height_) return false;
+
+    applied_width_ = width_;
+    applied_height_ = height_;
+    width = width_;
+    height = height_;
+    return true;
+}
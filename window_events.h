@@ -0,0 +1,136 @@
+//--------------------------------------------------------------------------------
+//  window_events.h
+//  Window events passed from the message pump thread to the frame thread
+//  (portable C++17, no platform headers).
+//  - WindowEventQueue : MpscQueue of translated events.  Post never blocks
+//                       the pump; Drain runs once per frame and collapses
+//                       runs of mouse moves into the last one.
+//  - ResizeCoalescer  : folds size / size-move events into at most one
+//                       resize per frame, and one per drag of the borders.
+//--------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <deque>
+#include "mpsc_queue.h"
+
+enum class WindowEventType : uint32_t
+{
+    kNone = 0,
+    kActivate,
+    kDeactivate,
+    kSize,
+    kEnterSizeMove,
+    kExitSizeMove,
+    kMouseDown,
+    kMouseUp,
+    kMouseMove,
+    kKeyUp,
+    kClose,     // the window was asked to close; the frame thread destroys it
+    kQuit,
+};
+
+enum class WindowSizeState : uint32_t
+{
+    kRestored = 0,
+    kMinimized,
+    kMaximized,
+};
+
+struct WindowEvent
+{
+    WindowEventType type = WindowEventType::kNone;
+    uint32_t code = 0;  // kSize: WindowSizeState, mouse: button state, kKeyUp: virtual key, kQuit: exit code
+    int32_t  x = 0;     // kSize: client width
+    int32_t  y = 0;     // kSize: client height
+};
+
+class WindowEventQueue
+{
+public:
+    static constexpr uint32_t kCapacity = 1024;     // power of 2
+
+    WindowEventQueue() : events_(kCapacity) {}
+
+    //--------------------------------------------------------------------------------
+    //  Pump thread (single producer).  When the queue is full, mouse moves
+    //  are dropped (a later one supersedes them) and everything else waits
+    //  in a backlog that is retried on the next Post or FlushBacklog, so
+    //  the pump never waits for the frame thread.
+    //--------------------------------------------------------------------------------
+    void Post(const WindowEvent& event);
+    bool HasBacklog() const { return !backlog_.empty(); }
+    void FlushBacklog();
+
+    uint32_t DroppedMoves() const { return dropped_moves_; }   // pump thread
+
+    //--------------------------------------------------------------------------------
+    //  Frame thread.  handler(const WindowEvent&) for every event posted
+    //  so far, in order, except that consecutive mouse moves are delivered
+    //  as the last of them.
+    //--------------------------------------------------------------------------------
+    template <class Handler>
+    void Drain(Handler&& handler)
+    {
+        WindowEvent event;
+        WindowEvent move;
+        bool has_move = false;
+
+        // Bounded so a flood of events cannot hold up the frame.
+        for (uint32_t i = 0; i < kCapacity && events_.TryPop(event); ++i)
+        {
+            if (event.type == WindowEventType::kMouseMove)
+            {
+                move = event;
+                has_move = true;
+                continue;
+            }
+            if (has_move)
+            {
+                handler(move);
+                has_move = false;
+            }
+            handler(event);
+        }
+        if (has_move) handler(move);
+    }
+
+private:
+    MpscQueue<WindowEvent> events_;
+    std::deque<WindowEvent> backlog_;   // pump thread only
+    uint32_t dropped_moves_ = 0;
+};
+
+//--------------------------------------------------------------------------------
+//  Frame thread.  Feed it the size events while draining, then call
+//  Consume once per frame.
+//--------------------------------------------------------------------------------
+class ResizeCoalescer
+{
+public:
+    ResizeCoalescer(uint32_t width, uint32_t height)
+        : width_(width), height_(height), applied_width_(width), applied_height_(height) {}
+
+    void OnSize(uint32_t width, uint32_t height, WindowSizeState state);
+    void OnEnterSizeMove() { dragging_ = true; }
+    void OnExitSizeMove() { dragging_ = false; }
+
+    //--------------------------------------------------------------------------------
+    //  True when the buffers should be resized to width x height.  Nothing
+    //  while minimized or while the borders are dragged; only when the size
+    //  differs from the last one returned.
+    //--------------------------------------------------------------------------------
+    bool Consume(uint32_t& width, uint32_t& height);
+
+    bool Minimized() const { return minimized_; }
+    bool Dragging() const { return dragging_; }
+    uint32_t Width() const { return width_; }
+    uint32_t Height() const { return height_; }
+
+private:
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t applied_width_;
+    uint32_t applied_height_;
+    bool minimized_ = false;
+    bool dragging_ = false;
+};